@@ -30,6 +30,8 @@
   #include <arpa/inet.h>       // For inet_addr()
   #include <unistd.h>          // For close()
   #include <netinet/in.h>      // For sockaddr_in
+  #include <netinet/tcp.h>     // For TCP_NODELAY
+  #include <sys/time.h>        // For struct timeval
   typedef void raw_type;       // Type used for raw data on this platform
 #endif
 
@@ -238,6 +240,20 @@ unsigned short CommunicatingSocket::getForeignPort()
   return ntohs(addr.sin_port);
 }
 
+void CommunicatingSocket::setRecvTimeout(unsigned int milliseconds) {
+#if defined(WIN32) || defined(WIN64)
+  DWORD timeout = milliseconds;
+#else
+  struct timeval timeout;
+  timeout.tv_sec = milliseconds / 1000;
+  timeout.tv_usec = (milliseconds % 1000) * 1000;
+#endif
+  if (setsockopt(sockDesc, SOL_SOCKET, SO_RCVTIMEO,
+                 (raw_type *) &timeout, sizeof(timeout)) < 0) {
+    throw SocketException("Set of SO_RCVTIMEO failed (setsockopt())", true);
+  }
+}
+
 // TCPSocket Code
 
 TCPSocket::TCPSocket(): CommunicatingSocket(SOCK_STREAM,
@@ -252,6 +268,14 @@ TCPSocket::TCPSocket(const string &foreignAddress, unsigned short foreignPort)
 TCPSocket::TCPSocket(int newConnSD) : CommunicatingSocket(newConnSD) {
 }
 
+void TCPSocket::setNoDelay(bool noDelay) {
+  int flag = noDelay ? 1 : 0;
+  if (setsockopt(sockDesc, IPPROTO_TCP, TCP_NODELAY,
+                 (raw_type *) &flag, sizeof(flag)) < 0) {
+    throw SocketException("Set of TCP_NODELAY failed (setsockopt())", true);
+  }
+}
+
 // TCPServerSocket Code
 
 TCPServerSocket::TCPServerSocket(unsigned short localPort, int queueLen) 
@@ -184,6 +184,15 @@ public:
    */
   unsigned short getForeignPort();
 
+  /**
+   *   Limit the time recv() waits for data.  Once it elapses, recv()
+   *   throws a SocketException, as it does on any other error
+   *   @param milliseconds maximum time to wait; 0 to wait forever (the
+   *   default)
+   *   @exception SocketException thrown if unable to set the option
+   */
+  void setRecvTimeout(unsigned int milliseconds);
+
 protected:
   // Next method may throw SocketException
   CommunicatingSocket(int type, int protocol);
@@ -211,6 +220,16 @@ public:
    */
   TCPSocket(const string &foreignAddress, unsigned short foreignPort);
 
+  /**
+   *   Enable or disable the coalescing of small writes (Nagle's algorithm).
+   *   Protocols with several small messages in flight should disable it,
+   *   so these are not delayed waiting for the acknowledgement of the
+   *   previous ones
+   *   @param noDelay true to send small writes at once (TCP_NODELAY)
+   *   @exception SocketException thrown if unable to set the option
+   */
+  void setNoDelay(bool noDelay);
+
 private:
   // Access for TCPServerSocket::accept() connection creation
   friend class TCPServerSocket;
@@ -0,0 +1,177 @@
+/** \file astrolabe_array_view.cpp
+  \brief Implementation file for astrolabe_array_view.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_array_view.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+astrolabe_double_view::
+astrolabe_double_view
+(void)
+{
+  {
+    bytes_ = NULL;
+    size_  = 0;
+  }
+}
+
+const double*
+astrolabe_double_view::
+aligned_data
+(void)
+const
+{
+  {
+    if (size_ == 0)                              return NULL;
+    if (((size_t)bytes_ % alignof(double)) != 0) return NULL;
+
+    return (const double*)bytes_;
+  }
+}
+
+const char*
+astrolabe_double_view::
+bytes
+(void)
+const
+{
+  {
+    return bytes_;
+  }
+}
+
+void
+astrolabe_double_view::
+copy_to
+(double* destination)
+const
+{
+  {
+    if (size_ > 0) memcpy((void*)destination, (const void*)bytes_, (size_t)size_ * sizeof(double));
+  }
+}
+
+double
+astrolabe_double_view::
+operator[]
+(int i)
+const
+{
+  double value;
+
+  {
+    memcpy((void*)&value, (const void*)(bytes_ + (size_t)i * sizeof(double)), sizeof(double));
+  }
+
+  return value;
+}
+
+void
+astrolabe_double_view::
+set
+(const void* bytes,
+ int         size)
+{
+  {
+    bytes_ = (size > 0) ? (const char*)bytes : NULL;
+    size_  = (size > 0) ? size               : 0;
+  }
+}
+
+int
+astrolabe_double_view::
+size
+(void)
+const
+{
+  {
+    return size_;
+  }
+}
+
+astrolabe_int_view::
+astrolabe_int_view
+(void)
+{
+  {
+    bytes_ = NULL;
+    size_  = 0;
+  }
+}
+
+const int*
+astrolabe_int_view::
+aligned_data
+(void)
+const
+{
+  {
+    if (size_ == 0)                              return NULL;
+    if (((size_t)bytes_ % alignof(int)) != 0)    return NULL;
+
+    return (const int*)bytes_;
+  }
+}
+
+const char*
+astrolabe_int_view::
+bytes
+(void)
+const
+{
+  {
+    return bytes_;
+  }
+}
+
+void
+astrolabe_int_view::
+copy_to
+(int* destination)
+const
+{
+  {
+    if (size_ > 0) memcpy((void*)destination, (const void*)bytes_, (size_t)size_ * sizeof(int));
+  }
+}
+
+int
+astrolabe_int_view::
+operator[]
+(int i)
+const
+{
+  int value;
+
+  {
+    memcpy((void*)&value, (const void*)(bytes_ + (size_t)i * sizeof(int)), sizeof(int));
+  }
+
+  return value;
+}
+
+void
+astrolabe_int_view::
+set
+(const void* bytes,
+ int         size)
+{
+  {
+    bytes_ = (size > 0) ? (const char*)bytes : NULL;
+    size_  = (size > 0) ? size               : 0;
+  }
+}
+
+int
+astrolabe_int_view::
+size
+(void)
+const
+{
+  {
+    return size_;
+  }
+}
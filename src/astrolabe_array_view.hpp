@@ -0,0 +1,171 @@
+/** \file astrolabe_array_view.hpp
+  \brief Read-only views of arrays of values stored in memory owned by
+    someone else, with no alignment requirements.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef ASTROLABE_ARRAY_VIEW_HPP
+#define ASTROLABE_ARRAY_VIEW_HPP
+
+/**
+ * @brief Read-only view of an array of doubles, not necessarily aligned.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * Binary records are packed, so the arrays of doubles they hold are
+ * seldom aligned as doubles in the buffers of the readers. Views keep
+ * a pointer to the first byte of the array and copy every value out
+ * of it when accessed (see operator[]()), which is safe whatever the
+ * alignment.
+ *
+ * Views never own the memory they point to; see the methods handing
+ * them out to know how long they remain valid.
+ */
+
+class astrolabe_double_view
+{
+  public:
+
+    /**
+     * @brief Default constructor. Builds an empty view.
+     */
+
+                  astrolabe_double_view    (void);
+
+    /**
+     * @brief Retrieve the address of the first value, if properly aligned.
+     * @return The address of the first value, if it is aligned as a double
+     *         (so the whole array may be accessed through it), NULL otherwise
+     *         (also when the view is empty).
+     */
+
+    const double* aligned_data             (void) const;
+
+    /**
+     * @brief Retrieve the address of the first byte of the array.
+     * @return The address of the first byte (NULL if the view is empty).
+     */
+
+    const char*   bytes                    (void) const;
+
+    /**
+     * @brief Copy the values in the view to an array.
+     * @param destination The array. It must have room for, at least, size()
+     *        values.
+     */
+
+    void          copy_to                  (double*     destination) const;
+
+    /**
+     * @brief Retrieve a value.
+     * @param i Position of the value, between 0 and size() - 1. Not checked.
+     * @return The value at position i.
+     */
+
+    double        operator[]               (int         i) const;
+
+    /**
+     * @brief Point the view to an array.
+     * @param bytes The address of the first byte of the array.
+     * @param size The number of values in the array.
+     */
+
+    void          set                      (const void* bytes,
+                                            int         size);
+
+    /**
+     * @brief Retrieve the number of values in the view.
+     * @return The number of values.
+     */
+
+    int           size                     (void) const;
+
+  protected:
+
+    /// @brief The first byte of the array.
+
+    const char* bytes_;
+
+    /// @brief The number of values in the array.
+
+    int         size_;
+};
+
+/**
+ * @brief Read-only view of an array of integers, not necessarily aligned.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * See astrolabe_double_view.
+ */
+
+class astrolabe_int_view
+{
+  public:
+
+    /**
+     * @brief Default constructor. Builds an empty view.
+     */
+
+                  astrolabe_int_view       (void);
+
+    /**
+     * @brief Retrieve the address of the first value, if properly aligned.
+     * @return The address of the first value, if it is aligned as an int
+     *         (so the whole array may be accessed through it), NULL otherwise
+     *         (also when the view is empty).
+     */
+
+    const int*    aligned_data             (void) const;
+
+    /**
+     * @brief Retrieve the address of the first byte of the array.
+     * @return The address of the first byte (NULL if the view is empty).
+     */
+
+    const char*   bytes                    (void) const;
+
+    /**
+     * @brief Copy the values in the view to an array.
+     * @param destination The array. It must have room for, at least, size()
+     *        values.
+     */
+
+    void          copy_to                  (int*        destination) const;
+
+    /**
+     * @brief Retrieve a value.
+     * @param i Position of the value, between 0 and size() - 1. Not checked.
+     * @return The value at position i.
+     */
+
+    int           operator[]               (int         i) const;
+
+    /**
+     * @brief Point the view to an array.
+     * @param bytes The address of the first byte of the array.
+     * @param size The number of values in the array.
+     */
+
+    void          set                      (const void* bytes,
+                                            int         size);
+
+    /**
+     * @brief Retrieve the number of values in the view.
+     * @return The number of values.
+     */
+
+    int           size                     (void) const;
+
+  protected:
+
+    /// @brief The first byte of the array.
+
+    const char* bytes_;
+
+    /// @brief The number of values in the array.
+
+    int         size_;
+};
+
+#endif // ASTROLABE_ARRAY_VIEW_HPP
@@ -0,0 +1,438 @@
+/** \file astrolabe_compressed_file.cpp
+  \brief Implementation file for astrolabe_compressed_file.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_compressed_file.hpp"
+#include "astrolabe_file_utilities.hpp"
+
+#include <algorithm>
+
+//
+// zlib is the deflate codec bundled (and linked) with ZipLib, which
+// is already used by the navigation file manager.
+//
+
+#include "extlibs/zlib/zlib.h"
+
+astrolabe_compressed_file::
+astrolabe_compressed_file
+(void)
+{
+  {
+    compressed_ = false;
+    error_      = false;
+    file_       = NULL;
+    frame_      = -1;
+    position_   = 0;
+    size_       = 0;
+  }
+}
+
+astrolabe_compressed_file::
+~astrolabe_compressed_file
+(void)
+{
+  {
+    detach();
+  }
+}
+
+int
+astrolabe_compressed_file::
+attach
+(FILE* file)
+{
+  {
+    int       frame_header[2];
+    long long physical_offset;
+    long long physical_size;
+    char      signature[_ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE];
+
+    detach();
+
+    file_ = file;
+
+    // Get the physical size of the file.
+
+    physical_size = astr_fsize(file_);
+    if (physical_size < 0) { detach(); return 1; }
+
+    if (astr_fseek(file_, 0, SEEK_SET) != 0) { detach(); return 1; }
+
+    //
+    // Look for the signature. Files too small to hold it or holding
+    // something else are plain binary files.
+    //
+
+    if ((physical_size >= _ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE) &&
+        (fread((void*)signature, 1, _ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE, file_) ==
+         _ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE) &&
+        (memcmp(signature, _ASTROLABE_COMPRESSED_FILE_SIGNATURE,
+                _ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE) == 0))
+    {
+      compressed_ = true;
+    }
+
+    if (!compressed_)
+    {
+      if (astr_fseek(file_, 0, SEEK_SET) != 0) { detach(); return 1; }
+
+      size_ = physical_size;
+
+      return 0;
+    }
+
+    //
+    // Compressed file. Walk the frame headers to build the table that
+    // maps logical offsets to frames. The compressed bytes are not read.
+    //
+
+    physical_offset = _ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE;
+
+    frame_offsets_.push_back(0);
+
+    while (physical_offset < physical_size)
+    {
+      if ((physical_size - physical_offset) < (long long)sizeof(frame_header))
+      {
+        detach();
+        return 2;
+      }
+
+      if (fread((void*)frame_header, sizeof(int), 2, file_) != 2)
+      {
+        detach();
+        return 1;
+      }
+
+      physical_offset += sizeof(frame_header);
+
+      if ((frame_header[0] <= 0) || (frame_header[1] <= 0) ||
+          (frame_header[1] > (physical_size - physical_offset)))
+      {
+        detach();
+        return 2;
+      }
+
+      frame_positions_.push_back(physical_offset);
+      frame_compressed_sizes_.push_back(frame_header[1]);
+      frame_offsets_.push_back(frame_offsets_.back() + frame_header[0]);
+
+      physical_offset += frame_header[1];
+
+      if (astr_fseek(file_, physical_offset, SEEK_SET) != 0)
+      {
+        detach();
+        return 1;
+      }
+    }
+
+    size_ = frame_offsets_.back();
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+void
+astrolabe_compressed_file::
+detach
+(void)
+{
+  {
+    compressed_ = false;
+    error_      = false;
+    file_       = NULL;
+    frame_      = -1;
+    position_   = 0;
+    size_       = 0;
+
+    vector<char>().swap(compressed_data_);
+    vector<char>().swap(frame_data_);
+    vector<int>().swap(frame_compressed_sizes_);
+    vector<long long>().swap(frame_offsets_);
+    vector<long long>().swap(frame_positions_);
+  }
+}
+
+bool
+astrolabe_compressed_file::
+error
+(void)
+const
+{
+  {
+    return error_;
+  }
+}
+
+long long
+astrolabe_compressed_file::
+get_size
+(void)
+const
+{
+  {
+    return size_;
+  }
+}
+
+bool
+astrolabe_compressed_file::
+is_compressed
+(void)
+const
+{
+  {
+    return compressed_;
+  }
+}
+
+int
+astrolabe_compressed_file::
+load_frame
+(int frame)
+{
+  {
+    uLongf raw_size;
+
+    if (frame == frame_) return 0;
+
+    // Read the compressed bytes.
+
+    compressed_data_.resize(frame_compressed_sizes_[frame]);
+
+    if (astr_fseek(file_, frame_positions_[frame], SEEK_SET) != 0) return 1;
+
+    if (fread((void*)&compressed_data_[0], 1, compressed_data_.size(), file_) !=
+        compressed_data_.size())
+    {
+      return 1;
+    }
+
+    // Decompress them. The size must be the one stated in the header.
+
+    raw_size = (uLongf)(frame_offsets_[frame + 1] - frame_offsets_[frame]);
+
+    frame_data_.resize(raw_size);
+    frame_     = -1;
+
+    if (uncompress((Bytef*)&frame_data_[0], &raw_size,
+                   (const Bytef*)&compressed_data_[0],
+                   (uLong)compressed_data_.size()) != Z_OK)
+    {
+      return 1;
+    }
+
+    if (raw_size != (uLongf)frame_data_.size()) return 1;
+
+    frame_ = frame;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+void
+astrolabe_compressed_file::
+prefetch
+(long long offset,
+ long long n_bytes)
+{
+  {
+    int       first_frame;
+    int       last_frame;
+    long long physical_begin;
+    long long physical_end;
+
+    if (file_ == NULL) return;
+    if ((offset < 0) || (n_bytes <= 0) || (offset >= size_)) return;
+
+    if ((offset + n_bytes) > size_) n_bytes = size_ - offset;
+
+    // Plain files: logical and physical offsets are the same.
+
+    if (!compressed_)
+    {
+      astr_fprefetch(file_, offset, n_bytes);
+      return;
+    }
+
+    // Compressed files: find the frames holding the first and last bytes.
+
+    first_frame = (int)(upper_bound(frame_offsets_.begin(), frame_offsets_.end(), offset) -
+                        frame_offsets_.begin()) - 1;
+    last_frame  = (int)(upper_bound(frame_offsets_.begin(), frame_offsets_.end(), offset + n_bytes - 1) -
+                        frame_offsets_.begin()) - 1;
+
+    physical_begin = frame_positions_[first_frame] - 2 * (long long)sizeof(int);
+    physical_end   = frame_positions_[last_frame]  + frame_compressed_sizes_[last_frame];
+
+    astr_fprefetch(file_, physical_begin, physical_end - physical_begin);
+  }
+}
+
+size_t
+astrolabe_compressed_file::
+read
+(void*  data,
+ size_t n_bytes)
+{
+  {
+    size_t available;
+    size_t bytes_read;
+    int    frame;
+    size_t in_frame;
+
+    if (file_ == NULL) return 0;
+
+    // Plain files: just read.
+
+    if (!compressed_)
+    {
+      bytes_read = fread(data, 1, n_bytes, file_);
+      if (ferror(file_)) error_ = true;
+
+      position_ += bytes_read;
+
+      return bytes_read;
+    }
+
+    //
+    // Compressed files: copy from as many frames as needed, starting
+    // at the one holding the current position.
+    //
+
+    bytes_read = 0;
+
+    while ((bytes_read < n_bytes) && (position_ < size_))
+    {
+      if ((frame_ >= 0) &&
+          (position_ >= frame_offsets_[frame_]) &&
+          (position_ <  frame_offsets_[frame_ + 1]))
+      {
+        frame = frame_;
+      }
+      else
+      {
+        frame = (int)(upper_bound(frame_offsets_.begin(), frame_offsets_.end(), position_) -
+                      frame_offsets_.begin()) - 1;
+      }
+
+      if (load_frame(frame) != 0)
+      {
+        error_ = true;
+        break;
+      }
+
+      in_frame  = (size_t)(position_ - frame_offsets_[frame]);
+      available = frame_data_.size() - in_frame;
+      if (available > (n_bytes - bytes_read)) available = n_bytes - bytes_read;
+
+      memcpy((char*)data + bytes_read, &frame_data_[in_frame], available);
+
+      bytes_read += available;
+      position_  += available;
+    }
+
+    // That's all.
+
+    return bytes_read;
+  }
+}
+
+int
+astrolabe_compressed_file::
+seek
+(long long offset)
+{
+  {
+    if (file_ == NULL) return 1;
+    if ((offset < 0) || (offset > size_)) return 1;
+
+    //
+    // Plain files are positioned right now; compressed ones will load
+    // the right frame when read.
+    //
+
+    if (!compressed_)
+    {
+      if (astr_fseek(file_, offset, SEEK_SET) != 0) return 1;
+    }
+
+    position_ = offset;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+long long
+astrolabe_compressed_file::
+tell
+(void)
+const
+{
+  {
+    return position_;
+  }
+}
+
+int
+astrolabe_compressed_file::
+write_frame
+(FILE*         file,
+ const char*   data,
+ int           n_bytes,
+ int           level,
+ vector<char>& buffer)
+{
+  {
+    uLongf compressed_size;
+    int    frame_header[2];
+
+    // Compress.
+
+    compressed_size = compressBound((uLong)n_bytes);
+    if (buffer.size() < (size_t)compressed_size) buffer.resize(compressed_size);
+
+    if (compress2((Bytef*)&buffer[0], &compressed_size,
+                  (const Bytef*)data, (uLong)n_bytes, level) != Z_OK)
+    {
+      return 1;
+    }
+
+    // Write the header of the frame and the compressed bytes.
+
+    frame_header[0] = n_bytes;
+    frame_header[1] = (int)compressed_size;
+
+    if (fwrite((void*)frame_header, sizeof(int), 2, file) != 2) return 2;
+    if (fwrite((void*)&buffer[0], 1, compressed_size, file) != compressed_size) return 2;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+astrolabe_compressed_file::
+write_signature
+(FILE* file)
+{
+  {
+    if (fwrite((void*)_ASTROLABE_COMPRESSED_FILE_SIGNATURE, 1,
+               _ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE, file) !=
+        _ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE)
+    {
+      return 1;
+    }
+
+    return 0;
+  }
+}
@@ -0,0 +1,253 @@
+/** \file astrolabe_compressed_file.hpp
+  \brief Transparent access to plain and block-compressed binary files.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef ASTROLABE_COMPRESSED_FILE_HPP
+#define ASTROLABE_COMPRESSED_FILE_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+/// @brief Signature stored at the beginning of every block-compressed
+/// file (8 chars).
+
+#define _ASTROLABE_COMPRESSED_FILE_SIGNATURE "ASTLBDFL"
+
+/// @brief Length in bytes of _ASTROLABE_COMPRESSED_FILE_SIGNATURE.
+
+#define _ASTROLABE_COMPRESSED_FILE_SIGNATURE_SIZE 8
+
+/**
+ * @brief Transparent access to plain and block-compressed binary files.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * Binary obs-e files may be optionally written in block-compressed form
+ * (see obs_e_based_file_writer_bin::set_compression()). The layout of
+ * these files is:
+ *
+ * - The signature (8 chars, _ASTROLABE_COMPRESSED_FILE_SIGNATURE).
+ * - A sequence of frames, each of these made of the number of bytes of
+ *   the frame once decompressed (int), the number of compressed bytes
+ *   (int) and the compressed bytes themselves, a complete deflate
+ *   (zlib) stream.
+ *
+ * Decompressing all the frames, one after the other, yields exactly the
+ * same bytes stored in a plain binary file. Frames are independent, so
+ * any of them may be decompressed without touching the rest. Writers
+ * close frames at epoch boundaries whenever possible, so reading an epoch
+ * usually requires decompressing a single frame.
+ *
+ * This class hides these details to readers: once attached to a FILE
+ * (see attach()), it offers read(), seek() and tell() operations that work
+ * on decompressed (logical) offsets, no matter whether the file is
+ * compressed or not. For plain files, these are just the fread(), fseek()
+ * and ftell() operations on the FILE itself. Offsets in time indexes
+ * (see epoch_time_index) are logical offsets too.
+ *
+ * Only the frame just read is kept, decompressed, in memory.
+ */
+
+class astrolabe_compressed_file
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                  astrolabe_compressed_file  (void);
+
+    /**
+     * @brief Destructor. The FILE attached, if any, is NOT closed.
+     */
+
+                  ~astrolabe_compressed_file (void);
+
+    /**
+     * @brief Attach an open FILE, ascertaining if it is compressed or not.
+     *
+     * @param file The file, open for reading in binary mode. It is not
+     *        owned by this object; callers must close it after detach().
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: I/O error.
+     *         - 2: Corrupted frame found in a compressed file.
+     *
+     * The frame headers of compressed files are scanned to build the
+     * table mapping logical offsets to frames. Once attached, the logical
+     * position is the beginning of the data.
+     */
+
+    int           attach                     (FILE*       file);
+
+    /**
+     * @brief Forget about the FILE attached and release the memory used.
+     */
+
+    void          detach                     (void);
+
+    /**
+     * @brief Check if an error has been detected by read().
+     * @return True if read() found an I/O error or a frame that could not
+     *         be decompressed, false otherwise.
+     */
+
+    bool          error                      (void) const;
+
+    /**
+     * @brief Retrieve the logical size of the file.
+     * @return The size of the data in bytes, once decompressed.
+     */
+
+    long long     get_size                   (void) const;
+
+    /**
+     * @brief Check if the file attached is block-compressed.
+     * @return True if compressed, false otherwise.
+     */
+
+    bool          is_compressed              (void) const;
+
+    /**
+     * @brief Ask the system to load in advance a logical region of the file.
+     *
+     * @param offset Logical offset of the first byte in the region.
+     * @param n_bytes Size of the region, in logical bytes.
+     *
+     * For compressed files, the hint covers the frames holding the region.
+     * This is just a hint (see astr_fprefetch()); errors are ignored.
+     */
+
+    void          prefetch                   (long long   offset,
+                                              long long   n_bytes);
+
+    /**
+     * @brief Read bytes at the current logical position.
+     *
+     * @param data Where to copy the bytes read.
+     * @param n_bytes Number of bytes to read.
+     * @return The number of bytes read. Less than n_bytes at the end of the
+     *         data or on errors (see error()).
+     */
+
+    size_t        read                       (void*       data,
+                                              size_t      n_bytes);
+
+    /**
+     * @brief Move the current logical position.
+     *
+     * @param offset New logical position, from the beginning of the data.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: Offset out of range or I/O error.
+     */
+
+    int           seek                       (long long   offset);
+
+    /**
+     * @brief Retrieve the current logical position.
+     * @return The current logical position.
+     */
+
+    long long     tell                       (void) const;
+
+    /**
+     * @brief Compress a block of data and write it as a frame.
+     *
+     * @param file The file to write to.
+     * @param data The bytes to compress.
+     * @param n_bytes How many bytes to compress (> 0).
+     * @param level Compression level (1, fastest, to 9, smallest).
+     * @param buffer Scratch memory used to compress, reused from call to
+     *        call to avoid allocations.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: Unable to compress the data.
+     *         - 2: I/O error.
+     */
+
+    static int    write_frame                (FILE*         file,
+                                              const char*   data,
+                                              int           n_bytes,
+                                              int           level,
+                                              vector<char>& buffer);
+
+    /**
+     * @brief Write the signature identifying compressed files.
+     *
+     * @param file The file to write to, positioned at its beginning.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: I/O error.
+     */
+
+    static int    write_signature            (FILE*         file);
+
+  protected:
+
+    /**
+     * @brief Decompress a frame, making it the current one.
+     *
+     * @param frame The number of the frame.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: I/O error or corrupted frame.
+     */
+
+    int           load_frame                 (int           frame);
+
+  protected:
+
+    /// @brief Flag. True if the file attached is compressed.
+
+    bool              compressed_;
+
+    /// @brief Scratch buffer where compressed frames are read.
+
+    vector<char>      compressed_data_;
+
+    /// @brief Flag. True when read() has found an error.
+
+    bool              error_;
+
+    /// @brief The FILE attached.
+
+    FILE*             file_;
+
+    /// @brief Number of the frame in frame_data_ (-1 if none).
+
+    int               frame_;
+
+    /// @brief Compressed size of each frame.
+
+    vector<int>       frame_compressed_sizes_;
+
+    /// @brief The current frame, decompressed.
+
+    vector<char>      frame_data_;
+
+    /// @brief Logical offset where each frame starts. Holds one
+    /// extra element, the logical size of the file.
+
+    vector<long long> frame_offsets_;
+
+    /// @brief Physical offset of the compressed bytes of each frame.
+
+    vector<long long> frame_positions_;
+
+    /// @brief Current logical position.
+
+    long long         position_;
+
+    /// @brief Logical size of the file.
+
+    long long         size_;
+};
+
+#endif // ASTROLABE_COMPRESSED_FILE_HPP
@@ -0,0 +1,187 @@
+/** \file astrolabe_file_utilities.cpp
+  \brief Implementation file for astrolabe_file_utilities.hpp
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_file_utilities.hpp"
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+  #include <io.h>
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+#ifdef __linux__
+  #include <linux/falloc.h>
+#endif
+
+int
+astr_fprefetch
+(FILE*     file,
+ long long offset,
+ long long length)
+{
+  if (file == NULL) return -1;
+  {
+    #if defined(_WIN32) || !defined(POSIX_FADV_WILLNEED)
+      return -1;
+    #else
+      if ((offset < 0) || (length <= 0)) return -1;
+
+      if ((long long)(off_t)offset != offset) return -1;
+      if ((long long)(off_t)length != length) return -1;
+
+      return posix_fadvise(fileno(file), (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+    #endif
+  }
+}
+
+int
+astr_fpreallocate
+(FILE*     file,
+ long long length)
+{
+  if (file == NULL) return -1;
+  {
+    if (length <= 0) return -1;
+
+    if (fflush(file) != 0) return -1;
+
+    //
+    // Only where the space may be reserved without changing the size of
+    // the file. Otherwise, a file left behind by a crash would end with
+    // the reserved (zeroed) space, which readers can't tell from data.
+    //
+
+    #if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+      if ((long long)(off_t)length != length) return -1;
+
+      return fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, 0, (off_t)length);
+    #elif defined(_WIN32)
+      HANDLE               handle;
+      FILE_ALLOCATION_INFO info;
+
+      handle = (HANDLE)_get_osfhandle(_fileno(file));
+      if (handle == INVALID_HANDLE_VALUE) return -1;
+
+      info.AllocationSize.QuadPart = length;
+
+      return SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info)) ? 0 : -1;
+    #else
+      return -1;
+    #endif
+  }
+}
+
+int
+astr_fsync
+(FILE* file)
+{
+  if (file == NULL) return -1;
+  {
+    if (fflush(file) != 0) return -1;
+
+    #ifdef _WIN32
+      return _commit(_fileno(file));
+    #else
+      return fsync(fileno(file));
+    #endif
+  }
+}
+
+int
+astr_fseek
+(FILE*     file,
+ long long offset,
+ int       origin)
+{
+  if (file == NULL) return -1;
+  {
+    #ifdef _WIN32
+      return _fseeki64(file, (__int64)offset, origin);
+    #else
+      // Refuse offsets that would be truncated by a narrow off_t.
+
+      if ((long long)(off_t)offset != offset) return -1;
+
+      return fseeko(file, (off_t)offset, origin);
+    #endif
+  }
+}
+
+long long
+astr_ftell
+(FILE* file)
+{
+  if (file == NULL) return -1;
+  {
+    #ifdef _WIN32
+      return (long long)_ftelli64(file);
+    #else
+      return (long long)ftello(file);
+    #endif
+  }
+}
+
+long long
+astr_fsize
+(FILE* file)
+{
+  if (file == NULL) return -1;
+  {
+    if (astr_fseek(file, 0, SEEK_END) != 0) return -1;
+
+    return astr_ftell(file);
+  }
+}
+
+long long
+astr_fmtime
+(const char* file_name)
+{
+  if (file_name == NULL) return -1;
+  {
+    #ifdef _WIN32
+      struct _stat64 file_status;
+
+      if (_stat64(file_name, &file_status) != 0) return -1;
+
+      return (long long)file_status.st_mtime * 1000000000LL;
+    #else
+      struct stat file_status;
+
+      if (stat(file_name, &file_status) != 0) return -1;
+
+      #if defined(__APPLE__)
+        return (long long)file_status.st_mtimespec.tv_sec * 1000000000LL + file_status.st_mtimespec.tv_nsec;
+      #else
+        return (long long)file_status.st_mtim.tv_sec * 1000000000LL + file_status.st_mtim.tv_nsec;
+      #endif
+    #endif
+  }
+}
+
+int
+astr_ftruncate
+(FILE* file)
+{
+  if (file == NULL) return -1;
+  {
+    long long position;
+
+    if (fflush(file) != 0) return -1;
+
+    position = astr_ftell(file);
+    if (position < 0) return -1;
+
+    #ifdef _WIN32
+      return (int)_chsize_s(_fileno(file), (__int64)position);
+    #else
+      return ftruncate(fileno(file), (off_t)position);
+    #endif
+  }
+}
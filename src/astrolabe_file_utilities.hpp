@@ -0,0 +1,147 @@
+/** \file astrolabe_file_utilities.hpp
+  \brief Utilities to work with large files.
+  \ingroup ASTROLABE_data_IO
+
+  This file provides with functions to position C FILE streams and
+  retrieve their position using 64 bit offsets, no matter the platform,
+  so files bigger than 2 (or 4) Gbytes may be handled. The standard
+  fseek() and ftell() functions use long values, which are 32 bits
+  wide on Windows and on 32 bit POSIX systems.
+
+  - On Windows, _fseeki64() and _ftelli64() are used.
+  - On POSIX systems, fseeko() and ftello() are used. Note that on 32 bit
+    POSIX systems off_t is 64 bits wide only when _FILE_OFFSET_BITS is
+    defined to be 64 when compiling (-D_FILE_OFFSET_BITS=64). Otherwise,
+    offsets not fitting in an off_t are reported as errors (see the
+    build notes in README.md).
+
+  Additionally, astr_fprefetch() lets readers tell the system which
+  region of a file they are about to read, so it may be loaded in
+  advance even when the file is not read sequentially, and astr_fsync()
+  lets writers make sure the data written so far survives a power loss.
+  Writers knowing in advance how big a file will get may reserve its
+  space with astr_fpreallocate(), so it is laid out contiguously on the
+  device, and give back what they did not use with astr_ftruncate().
+*/
+
+#ifndef __ASTROLABE_FILE_UTILITIES_HPP__
+#define __ASTROLABE_FILE_UTILITIES_HPP__
+
+#include <stdio.h>
+
+#ifndef _WIN32
+  #include <sys/types.h>
+#endif
+
+/// \brief Ask the system to load in advance a region of a file.
+/**
+  \pre file != NULL
+  \param file The file stream.
+  \param offset Offset, in bytes, of the first byte in the region.
+  \param length Size of the region, in bytes.
+  \return 0 if the hint has been given, non zero otherwise (also on
+    platforms where these hints are not available, such as Windows).
+
+  This is just a hint (posix_fadvise() with POSIX_FADV_WILLNEED); the
+  position of the stream does not change and the function returns
+  immediately, before the data is loaded.
+  */
+
+int       astr_fprefetch         (FILE* file, long long offset, long long length);
+
+/// \brief Reserve space on the storage device for a file.
+/**
+  \pre file != NULL
+  \param file The file stream, open for writing.
+  \param length Size, in bytes, the file is expected to reach.
+  \return 0 if successful, non zero otherwise (for instance, when the
+    file system or the platform does not support preallocation).
+
+  The space is allocated at once, but the size of the file does not change,
+  so a file left behind by a crash holds just the data written so far. This
+  is done on Linux, using fallocate() with FALLOC_FL_KEEP_SIZE, and on
+  Windows, setting the allocation size of the file (FileAllocationInfo).
+  Elsewhere, the only ways to reserve space (posix_fallocate(), ftruncate())
+  extend the file, so nothing is done and an error is returned. The position
+  of the stream does not change. Once the data is written, truncate the file
+  at its end (see astr_ftruncate()) to give back the space not used.
+  */
+
+int       astr_fpreallocate      (FILE* file, long long length);
+
+/// \brief Flush a file stream and commit its data to the storage device.
+/**
+  \pre file != NULL
+  \param file The file stream, open for writing.
+  \return 0 if successful, non zero otherwise.
+
+  The stream is flushed (fflush()) and then the data cached by the system
+  is written to the device: fsync() on POSIX systems, _commit() on Windows.
+  This call blocks until the device reports the data stored, which may take
+  milliseconds, so it should be used sparingly.
+  */
+
+int       astr_fsync             (FILE* file);
+
+/// \brief Move the position of a file stream (64 bit version of fseek).
+/**
+  \pre file != NULL
+  \param file The file stream to position.
+  \param offset Offset, in bytes, relative to the origin.
+  \param origin SEEK_SET, SEEK_CUR or SEEK_END, as in fseek.
+  \return 0 if successful, non zero otherwise (also when the offset
+    can not be represented on this platform).
+  */
+
+int       astr_fseek             (FILE* file, long long offset, int origin);
+
+/// \brief Retrieve the position of a file stream (64 bit version of ftell).
+/**
+  \pre file != NULL
+  \param file The file stream.
+  \return The current position, in bytes, from the beginning of the file,
+    or -1 on errors.
+  */
+
+long long astr_ftell             (FILE* file);
+
+/// \brief Retrieve the size of a file stream.
+/**
+  \pre file != NULL
+  \param file The file stream.
+  \return The size of the file, in bytes, or -1 on errors. The position
+    of the stream is moved to the end of the file.
+  */
+
+long long astr_fsize             (FILE* file);
+
+/// \brief Retrieve the time a file was last modified.
+/**
+  \pre file_name != NULL
+  \param file_name The name of the file.
+  \return The modification time, in nanoseconds since the Epoch, or -1
+    on errors (for instance, when the file does not exist). On Windows the
+    resolution is one second.
+
+  Used to tell whether a file has changed since some other file derived
+  from it (such as an index, see epoch_time_index) was built.
+  */
+
+long long astr_fmtime            (const char* file_name);
+
+/// \brief Truncate a file at the current position of its stream.
+/**
+  \pre file != NULL
+  \param file The file stream, open for writing.
+  \return 0 if successful, non zero otherwise.
+
+  The stream is flushed (fflush()) and everything past its current
+  position is discarded: ftruncate() on POSIX systems, _chsize_s() on
+  Windows. Used to give back the space reserved, but not used, by
+  preallocated files (see astr_fpreallocate()); this works even if the
+  size of the file does not change.
+  */
+
+int       astr_ftruncate         (FILE* file);
+
+#endif // __ASTROLABE_FILE_UTILITIES_HPP__
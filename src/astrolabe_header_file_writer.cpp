@@ -11,6 +11,7 @@ astrolabe_header_file_writer
 {
   {
     file_mode_is_binary_     = false;
+    file_mode_is_columnar_   = false;
     device_type_             = "";
     external_base_file_name_ = "";
     header_file_name_        = "";    
@@ -27,6 +28,16 @@ astrolabe_header_file_writer::
   }
 }
 
+void
+astrolabe_header_file_writer::
+set_columnar
+(bool columnar)
+{
+  {
+    file_mode_is_columnar_ = columnar;
+  }
+}
+
 void
 astrolabe_header_file_writer::
 set_data_channel
@@ -188,8 +199,9 @@ write
     fprintf(header_file, "  <data>\n");
 
 
-    if (file_mode_is_binary_) stmp = "binary_file";
-    else                      stmp = "text_file";
+    if      (file_mode_is_columnar_) stmp = "columnar_file";
+    else if (file_mode_is_binary_)   stmp = "binary_file";
+    else                             stmp = "text_file";
 
     fprintf(header_file, "    <device type=\"%s\" format=\"%s\"> %s </device>\n",
                          device_type_.c_str(), stmp.c_str(), external_base_file_name_.c_str());
@@ -34,6 +34,8 @@
      - Kind of file (type attribute).
      - Binary or text file.
      - A lineage object to include in the header files.
+   - Optionally, declare the external files as columnar ones using
+     set_columnar().
    - Call method write().
 */
 
@@ -68,6 +70,16 @@ class astrolabe_header_file_writer
                                        bool                binary,
                                        const lineage_data* lineage_info);
 
+    /// \brief Declare the external files as columnar files.
+    /**
+      \param columnar When true, the format of the external files will be
+             stated as columnar (see observation_file_writer_col), no matter
+             the value of the binary parameter of set_data_channel(). Only
+             obs-e files may be columnar.
+    */
+
+    void set_columnar                 (bool                columnar);
+
     /// \brief Write the astrolabe header file.
     /**
       \return Error code. Error code values:
@@ -108,6 +120,11 @@ class astrolabe_header_file_writer
 
     bool                              file_mode_is_binary_;
 
+    /// \brief Flag that indicates that a file data channel must be
+    /// written in columnar mode.
+
+    bool                              file_mode_is_columnar_;
+
     /// \brief The lineage information to write in the header of the
     /// observation-events file.
 
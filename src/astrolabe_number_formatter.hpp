@@ -0,0 +1,55 @@
+/** \file astrolabe_number_formatter.hpp
+  \brief Utilities to convert numbers to text.
+  \ingroup ASTROLABE_data_IO
+
+  This file provides with functions to write the text representation of
+  double and integer values, meant to be used by text writers instead of
+  sprintf(). These do not allocate memory, do not depend on the current
+  locale and do not write the ending NULL character.
+
+  Doubles are written using the shortest sequence of digits that converts
+  back to exactly the same double (see astr_parse_double()), computed
+  with the Ryu algorithm (Ulf Adams, "Ryu: fast float-to-string
+  conversion", PLDI 2018). The fixed notation (123.25) or the scientific
+  one (1.2325e-12) is chosen, whichever is shorter.
+*/
+
+#ifndef __ASTROLABE_NUMBER_FORMATTER_HPP__
+#define __ASTROLABE_NUMBER_FORMATTER_HPP__
+
+/// \brief Maximum number of characters written by astr_format_double()
+/// (as in -2.2250738585072014e-308).
+
+#define _ASTR_FORMAT_DOUBLE_MAX_SIZE 24
+
+/// \brief Maximum number of characters written by astr_format_int()
+/// (as in -2147483648).
+
+#define _ASTR_FORMAT_INT_MAX_SIZE    11
+
+/// \brief Write the shortest text representation of a double.
+/**
+  \pre buffer != NULL
+  \param value The value to write.
+  \param buffer Output. The text. It must have room for, at least,
+    _ASTR_FORMAT_DOUBLE_MAX_SIZE characters. No ending NULL is written.
+  \return The number of characters written.
+
+  Infinite values are written as "inf" or "-inf"; NaN as "nan", as
+  printf() does.
+  */
+
+int       astr_format_double     (double value, char* buffer);
+
+/// \brief Write the text representation of an integer.
+/**
+  \pre buffer != NULL
+  \param value The value to write.
+  \param buffer Output. The text. It must have room for, at least,
+    _ASTR_FORMAT_INT_MAX_SIZE characters. No ending NULL is written.
+  \return The number of characters written.
+  */
+
+int       astr_format_int        (int value, char* buffer);
+
+#endif // __ASTROLABE_NUMBER_FORMATTER_HPP__
@@ -0,0 +1,436 @@
+/** \file astrolabe_number_parser.cpp
+  \brief Implementation file for astrolabe_number_parser.hpp
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_number_parser.hpp"
+
+#include <limits>
+#include <stdlib.h>
+
+using namespace std;
+
+/// \brief Maximum number of significant digits accumulated in a 64 bit mantissa.
+
+#define _ASTR_PARSER_MAX_MANTISSA_DIGITS 19
+
+/// \brief Maximum number of significant digits passed to strtod(). Correct
+/// rounding never needs more than 768 of these.
+
+#define _ASTR_PARSER_MAX_FALLBACK_DIGITS 780
+
+/// \brief Exponents beyond this value overflow (or underflow) any double.
+
+#define _ASTR_PARSER_MAX_EXPONENT 100000
+
+/// \brief Biggest integer such that it and all smaller ones are exact doubles (2^53).
+
+static const unsigned long long max_exact_integer = 9007199254740992ULL;
+
+/// \brief Powers of ten that are exact doubles.
+
+static const double exact_powers_of_ten[] =
+{
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10,
+  1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21,
+  1e22
+};
+
+/// \brief Check if the text at a given position matches a lowercase word,
+/// ignoring case.
+
+static bool
+matches_word
+(const char* first,
+ const char* last,
+ const char* word)
+{
+  {
+    while (*word != 0)
+    {
+      if (first >= last) return false;
+      if ((*first | 0x20) != *word) return false;
+
+      first++;
+      word++;
+    }
+
+    return true;
+  }
+}
+
+/// \brief Convert a validated double (digits, optional decimal point and
+/// exponent) using strtod(). Only digits and the exponent are passed to
+/// strtod(), so the result does not depend on the current locale.
+
+static double
+parse_double_slow
+(const char* first,
+ const char* last,
+ int         exponent)
+{
+  {
+    char  buffer[_ASTR_PARSER_MAX_FALLBACK_DIGITS + 16];
+    char  chr;
+    int   dropped_digits;
+    bool  dropped_nonzero;
+    int   i;
+    bool  in_fraction;
+    int   n_digits;
+
+    dropped_digits  = 0;
+    dropped_nonzero = false;
+    in_fraction     = false;
+    n_digits        = 0;
+
+    //
+    // Copy the digits (leading zeros excluded). Every fraction digit
+    // decreases the exponent, since the decimal point is removed.
+    //
+
+    for (; first < last; first++)
+    {
+      chr = *first;
+
+      if (chr == '.')
+      {
+        in_fraction = true;
+        continue;
+      }
+
+      if (in_fraction) exponent--;
+
+      if ((n_digits == 0) && (chr == '0')) continue;
+
+      if (n_digits < _ASTR_PARSER_MAX_FALLBACK_DIGITS)
+      {
+        buffer[n_digits] = chr;
+        n_digits++;
+      }
+      else
+      {
+        dropped_digits++;
+        if (chr != '0') dropped_nonzero = true;
+      }
+    }
+
+    //
+    // Dropped digits still count to compute the magnitude. If any of these
+    // was not zero, a trailing 1 keeps the rounding direction right.
+    //
+
+    exponent += dropped_digits;
+
+    if (dropped_nonzero)
+    {
+      buffer[n_digits] = '1';
+      n_digits++;
+      exponent--;
+    }
+
+    // Append the exponent.
+
+    buffer[n_digits] = 'e';
+    n_digits++;
+
+    if (exponent < 0)
+    {
+      buffer[n_digits] = '-';
+      n_digits++;
+      exponent = -exponent;
+    }
+
+    i = n_digits;
+    do
+    {
+      buffer[n_digits] = (char)('0' + (exponent % 10));
+      n_digits++;
+      exponent /= 10;
+    }
+    while (exponent != 0);
+
+    buffer[n_digits] = 0;
+
+    // The exponent digits have been written in reverse order.
+
+    for (n_digits--; i < n_digits; i++, n_digits--)
+    {
+      chr              = buffer[i];
+      buffer[i]        = buffer[n_digits];
+      buffer[n_digits] = chr;
+    }
+
+    return strtod(buffer, NULL);
+  }
+}
+
+int
+astr_parse_double
+(const char*  first,
+ const char*  last,
+ double&      value,
+ const char** end)
+{
+  if ((first == NULL) || (last < first)) return -1;
+  {
+    const char*        current;
+    int                digit;
+    int                exponent;
+    int                explicit_exponent;
+    bool               explicit_negative;
+    const char*        mantissa_first;
+    const char*        mantissa_last;
+    unsigned long long mantissa;
+    int                mantissa_digits;
+    bool               negative;
+    int                n_digits;
+    bool               truncated;
+
+    current  = first;
+    negative = false;
+
+    // Sign.
+
+    if ((current < last) && ((*current == '-') || (*current == '+')))
+    {
+      negative = (*current == '-');
+      current++;
+    }
+
+    // Infinity and NaN, as written by printf().
+
+    if ((current < last) && ((*current | 0x20) == 'i' || (*current | 0x20) == 'n'))
+    {
+      if (matches_word(current, last, "nan"))
+      {
+        value   = numeric_limits<double>::quiet_NaN();
+        current += 3;
+      }
+      else if (matches_word(current, last, "inf"))
+      {
+        value   = numeric_limits<double>::infinity();
+        current += matches_word(current, last, "infinity") ? 8 : 3;
+      }
+      else return 1;
+
+      if (negative) value = -value;
+      if (end != NULL) *end = current;
+      return 0;
+    }
+
+    //
+    // Digits, with an optional decimal point. Up to 19 significant digits
+    // are accumulated in the mantissa; any other one just changes the
+    // exponent (integer part) or is ignored (fraction).
+    //
+
+    mantissa_first  = current;
+    exponent        = 0;
+    mantissa        = 0;
+    mantissa_digits = 0;
+    n_digits        = 0;
+    truncated       = false;
+
+    while ((current < last) && (*current >= '0') && (*current <= '9'))
+    {
+      digit = *current - '0';
+
+      if (mantissa_digits < _ASTR_PARSER_MAX_MANTISSA_DIGITS)
+      {
+        mantissa = mantissa * 10 + digit;
+        if (mantissa != 0) mantissa_digits++;
+      }
+      else
+      {
+        exponent++;
+        if (digit != 0) truncated = true;
+      }
+
+      n_digits++;
+      current++;
+    }
+
+    if ((current < last) && (*current == '.'))
+    {
+      current++;
+
+      while ((current < last) && (*current >= '0') && (*current <= '9'))
+      {
+        digit = *current - '0';
+
+        if (mantissa_digits < _ASTR_PARSER_MAX_MANTISSA_DIGITS)
+        {
+          mantissa = mantissa * 10 + digit;
+          if (mantissa != 0) mantissa_digits++;
+          exponent--;
+        }
+        else
+        {
+          if (digit != 0) truncated = true;
+        }
+
+        n_digits++;
+        current++;
+      }
+    }
+
+    // At least a digit is needed.
+
+    if (n_digits == 0) return 1;
+
+    mantissa_last = current;
+
+    //
+    // Optional exponent. The 'e' is not part of the number unless
+    // digits follow it.
+    //
+
+    if ((current < last) && ((*current == 'e') || (*current == 'E')))
+    {
+      const char* exponent_first;
+
+      exponent_first    = current;
+      explicit_exponent = 0;
+      explicit_negative = false;
+
+      current++;
+
+      if ((current < last) && ((*current == '-') || (*current == '+')))
+      {
+        explicit_negative = (*current == '-');
+        current++;
+      }
+
+      if ((current < last) && (*current >= '0') && (*current <= '9'))
+      {
+        while ((current < last) && (*current >= '0') && (*current <= '9'))
+        {
+          if (explicit_exponent < _ASTR_PARSER_MAX_EXPONENT)
+          {
+            explicit_exponent = explicit_exponent * 10 + (*current - '0');
+          }
+
+          current++;
+        }
+
+        if (explicit_negative) explicit_exponent = -explicit_exponent;
+      }
+      else
+      {
+        current           = exponent_first;
+        explicit_exponent = 0;
+      }
+    }
+    else explicit_exponent = 0;
+
+    if (end != NULL) *end = current;
+
+    //
+    // Zero (mantissa_digits counts significant digits only, so the
+    // mantissa is zero only if the value is zero).
+    //
+
+    if (mantissa == 0)
+    {
+      value = negative ? -0.0 : 0.0;
+      return 0;
+    }
+
+    exponent += explicit_exponent;
+
+    //
+    // Fast path: when both the mantissa and the power of ten are exact
+    // doubles, a single multiplication or division, correctly rounded by
+    // the FPU, yields the correctly rounded result.
+    //
+
+    if ((!truncated) && (mantissa <= max_exact_integer))
+    {
+      if ((exponent >= -22) && (exponent <= 22))
+      {
+        if (exponent >= 0) value = (double)mantissa * exact_powers_of_ten[exponent];
+        else               value = (double)mantissa / exact_powers_of_ten[-exponent];
+
+        if (negative) value = -value;
+        return 0;
+      }
+
+      //
+      // Big exponents: part of the power of ten may be moved to the
+      // mantissa, as long as it is still exact.
+      //
+
+      if ((exponent > 22) && (exponent <= 22 + 15))
+      {
+        unsigned long long power;
+
+        power = (unsigned long long)exact_powers_of_ten[exponent - 22];
+
+        if (mantissa <= (max_exact_integer / power))
+        {
+          value = (double)(mantissa * power) * exact_powers_of_ten[22];
+
+          if (negative) value = -value;
+          return 0;
+        }
+      }
+    }
+
+    // Slow path.
+
+    value = parse_double_slow(mantissa_first, mantissa_last, explicit_exponent);
+
+    if (negative) value = -value;
+    return 0;
+  }
+}
+
+int
+astr_parse_int
+(const char*  first,
+ const char*  last,
+ int&         value,
+ const char** end)
+{
+  if ((first == NULL) || (last < first)) return -1;
+  {
+    const char* current;
+    long long   limit;
+    bool        negative;
+    long long   result;
+
+    current  = first;
+    negative = false;
+
+    // Sign.
+
+    if ((current < last) && ((*current == '-') || (*current == '+')))
+    {
+      negative = (*current == '-');
+      current++;
+    }
+
+    // At least a digit is needed.
+
+    if ((current >= last) || (*current < '0') || (*current > '9')) return 1;
+
+    // Digits. Stop as soon as the value does not fit in an int.
+
+    limit  = negative ? -(long long)numeric_limits<int>::min() : (long long)numeric_limits<int>::max();
+    result = 0;
+
+    while ((current < last) && (*current >= '0') && (*current <= '9'))
+    {
+      result = result * 10 + (*current - '0');
+      if (result > limit) return 2;
+
+      current++;
+    }
+
+    value = negative ? (int)(-result) : (int)result;
+
+    if (end != NULL) *end = current;
+
+    return 0;
+  }
+}
@@ -0,0 +1,68 @@
+/** \file astrolabe_number_parser.hpp
+  \brief Utilities to convert text to numbers.
+  \ingroup ASTROLABE_data_IO
+
+  This file provides with functions to convert the text representation
+  of double and integer values to binary form. These are meant to be
+  used by text readers, which need to convert every token in a record,
+  so:
+
+  - Text is parsed in place; it does not need to be copied to a separate,
+    NULL terminated buffer.
+  - No memory is allocated.
+  - The current locale is ignored: the decimal point is always '.'.
+  - Doubles are correctly rounded, so the text written for a double with
+    enough significant digits (17, for instance "%.17g") is converted
+    back to the very same double.
+
+  Most doubles in ASTROLABE files have 15 significant digits or less and
+  moderate exponents; these are converted using a single floating point
+  operation. The rest are normalized (digits and exponent only, so no
+  decimal point is involved) and converted using strtod().
+*/
+
+#ifndef __ASTROLABE_NUMBER_PARSER_HPP__
+#define __ASTROLABE_NUMBER_PARSER_HPP__
+
+/// \brief Convert the text at the beginning of a character range to a double.
+/**
+  \pre first != NULL
+  \pre last >= first
+  \param first Pointer to the first character to parse.
+  \param last Pointer to the position following the last character that
+    may be parsed (the text does not need to be NULL terminated).
+  \param value Output. The double value, when successful.
+  \param end Output. When not NULL, it is set to point to the first
+    character following the text converted.
+  \return 0 if successful, non zero if the range does not start with a
+    double value.
+
+  Leading whitespace is NOT skipped. The accepted syntax is an optional
+  sign, a sequence of decimal digits optionally containing a decimal
+  point ('.') and an optional exponent (an 'e' or 'E' followed by an
+  optionally signed sequence of digits), or the words "inf", "infinity"
+  or "nan" (case insensitive), as written by printf().
+  */
+
+int       astr_parse_double      (const char* first, const char* last, double& value, const char** end);
+
+/// \brief Convert the text at the beginning of a character range to an integer.
+/**
+  \pre first != NULL
+  \pre last >= first
+  \param first Pointer to the first character to parse.
+  \param last Pointer to the position following the last character that
+    may be parsed (the text does not need to be NULL terminated).
+  \param value Output. The integer value, when successful.
+  \param end Output. When not NULL, it is set to point to the first
+    character following the text converted.
+  \return 0 if successful, non zero if the range does not start with an
+    integer value or if such value does not fit in an int.
+
+  Leading whitespace is NOT skipped. The accepted syntax is an optional
+  sign followed by a sequence of decimal digits.
+  */
+
+int       astr_parse_int         (const char* first, const char* last, int& value, const char** end);
+
+#endif // __ASTROLABE_NUMBER_PARSER_HPP__
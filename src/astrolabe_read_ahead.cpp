@@ -0,0 +1,593 @@
+/** \file astrolabe_read_ahead.cpp
+  \brief Implementation file for astrolabe_read_ahead.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_read_ahead.hpp"
+
+astrolabe_read_ahead::
+astrolabe_read_ahead
+(void)
+{
+  {
+    backward_          = false;
+    block_             = NULL;
+    block_bytes_       = 0;
+    block_offset_      = 0;
+    block_size_        = 0;
+    bytes_read_        = 0;
+    error_             = false;
+    file_              = NULL;
+    file_size_         = 0;
+    prefetched_offset_ = -1;
+    read_seconds_      = 0;
+    request_bytes_     = 0;
+    request_offset_    = 0;
+    request_pending_   = false;
+    reverse_window_    = 0;
+    stop_              = false;
+    stream_            = NULL;
+    worker_is_running_ = false;
+  }
+}
+
+astrolabe_read_ahead::
+~astrolabe_read_ahead
+(void)
+{
+  {
+    detach();
+  }
+}
+
+void
+astrolabe_read_ahead::
+attach
+(FILE*     file,
+ long long size)
+{
+  {
+    detach();
+
+    bytes_read_   = 0;
+    file_         = file;
+    file_size_    = size;
+    read_seconds_ = 0;
+  }
+}
+
+void
+astrolabe_read_ahead::
+attach
+(astrolabe_compressed_file* stream)
+{
+  {
+    detach();
+
+    bytes_read_   = 0;
+    file_size_    = stream->get_size();
+    read_seconds_ = 0;
+    stream_       = stream;
+  }
+}
+
+long long
+astrolabe_read_ahead::
+copy_chunk
+(long long offset,
+ long long end,
+ char*     data)
+{
+  {
+    long long block_end;
+    size_t    bytes_read;
+    long long current;
+    long long piece_end;
+
+    //
+    // Copy the bytes already in block_ and read from the file those that
+    // are not there.
+    //
+
+    block_end = block_offset_ + (long long)block_bytes_;
+    current   = offset;
+
+    while (current < end)
+    {
+      if ((current >= block_offset_) && (current < block_end))
+      {
+        // Available in block_.
+
+        piece_end = end;
+        if (piece_end > block_end) piece_end = block_end;
+
+        memcpy(data + (current - offset),
+               &block_[(size_t)(current - block_offset_)],
+               (size_t)(piece_end - current));
+
+        current = piece_end;
+      }
+      else
+      {
+        // Not available. Read up to the start of block_, if it follows.
+
+        piece_end = end;
+        if ((block_bytes_ > 0) && (block_offset_ > current) && (block_offset_ < piece_end))
+          piece_end = block_offset_;
+
+        if (!read_file(current, data + (current - offset),
+                       (size_t)(piece_end - current), bytes_read))
+        {
+          error_ = true;
+        }
+
+        current += (long long)bytes_read;
+
+        if (current != piece_end) break;
+      }
+    }
+
+    return current;
+  }
+}
+
+void
+astrolabe_read_ahead::
+detach
+(void)
+{
+  {
+    unique_lock<mutex> lock(mutex_, defer_lock);
+
+    // Stop the helper thread, waiting for any read in progress.
+
+    if (worker_is_running_)
+    {
+      lock.lock();
+      stop_ = true;
+      request_posted_.notify_all();
+      lock.unlock();
+
+      worker_.join();
+    }
+
+    backward_          = false;
+    block_bytes_       = 0;
+    block_offset_      = 0;
+    block_size_        = 0;
+    error_             = false;
+    file_              = NULL;
+    file_size_         = 0;
+    prefetched_offset_ = -1;
+    request_pending_   = false;
+    reverse_window_    = 0;
+    stop_              = false;
+    stream_            = NULL;
+    worker_is_running_ = false;
+
+    if (block_ != NULL) delete [] block_;
+    block_ = NULL;
+  }
+}
+
+bool
+astrolabe_read_ahead::
+error
+(void)
+const
+{
+  {
+    return error_;
+  }
+}
+
+void
+astrolabe_read_ahead::
+get_statistics
+(long long& bytes_read,
+ double&    seconds)
+const
+{
+  {
+    bytes_read = bytes_read_;
+    seconds    = read_seconds_;
+  }
+}
+
+bool
+astrolabe_read_ahead::
+is_started
+(void)
+const
+{
+  {
+    return worker_is_running_;
+  }
+}
+
+void
+astrolabe_read_ahead::
+prefetch_reverse_window
+(long long offset)
+{
+  {
+    long long begin;
+    long long hinted;
+
+    if ((reverse_window_ <= 0) || (offset <= 0)) return;
+
+    //
+    // Nothing to do if the region preceding offset has already been hinted,
+    // as long as at least half the window is still ahead (or the beginning
+    // of the file has been reached).
+    //
+
+    if ((prefetched_offset_ >= 0) && (prefetched_offset_ <= offset))
+    {
+      hinted = offset - prefetched_offset_;
+
+      if ((hinted <= reverse_window_) &&
+          ((hinted >= (reverse_window_ / 2)) || (prefetched_offset_ == 0)))
+      {
+        return;
+      }
+    }
+
+    // Hint the whole window preceding offset.
+
+    begin = offset - reverse_window_;
+    if (begin < 0) begin = 0;
+
+    if (stream_ != NULL) stream_->prefetch(begin, offset - begin);
+    else                 astr_fprefetch(file_, begin, offset - begin);
+
+    prefetched_offset_ = begin;
+  }
+}
+
+size_t
+astrolabe_read_ahead::
+read
+(long long offset,
+ void*     data,
+ size_t    n_bytes)
+{
+  {
+    size_t                           bytes_read;
+    long long                        current;
+    long long                        end;
+    unique_lock<mutex>               lock(mutex_, defer_lock);
+    long long                        next_begin;
+    long long                        next_end;
+    chrono::steady_clock::time_point started;
+
+    if ((file_ == NULL) && (stream_ == NULL)) return 0;
+
+    // Never go beyond the end of the file.
+
+    if ((offset < 0) || (offset >= file_size_)) return 0;
+
+    end = offset + (long long)n_bytes;
+    if (end > file_size_) end = file_size_;
+
+    started = chrono::steady_clock::now();
+
+    // Backward readers: make sure that the system loads what comes next.
+
+    prefetch_reverse_window(offset);
+
+    // No helper thread: just read the file.
+
+    if (!worker_is_running_)
+    {
+      if (!read_file(offset, (char*)data, (size_t)(end - offset), bytes_read)) error_ = true;
+
+      bytes_read_   += (long long)bytes_read;
+      read_seconds_ += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+      return bytes_read;
+    }
+
+    //
+    // Wait for the helper thread to finish the read in progress, if any.
+    // From now on, and until a new request is posted, it won't touch the
+    // file nor block_.
+    //
+
+    lock.lock();
+
+    while (request_pending_) request_served_.wait(lock);
+
+    // Fill the chunk requested.
+
+    current = copy_chunk(offset, end, (char*)data);
+
+    //
+    // Ask the helper thread to read the chunk that will probably be
+    // requested next: the one preceding the bytes just delivered when
+    // reading backwards, the one following them otherwise.
+    //
+
+    if (backward_)
+    {
+      next_end   = offset;
+      next_begin = next_end - (long long)block_size_;
+      if (next_begin < 0) next_begin = 0;
+    }
+    else
+    {
+      next_begin = current;
+      next_end   = next_begin + (long long)block_size_;
+      if (next_end > file_size_) next_end = file_size_;
+    }
+
+    block_bytes_ = 0;
+
+    if ((!error_) && (next_end > next_begin))
+    {
+      request_offset_  = next_begin;
+      request_bytes_   = (size_t)(next_end - next_begin);
+      request_pending_ = true;
+
+      request_posted_.notify_all();
+    }
+
+    lock.unlock();
+
+    bytes_read_   += current - offset;
+    read_seconds_ += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    // That's all.
+
+    return (size_t)(current - offset);
+  }
+}
+
+void
+astrolabe_read_ahead::
+read_ahead
+(void)
+{
+  {
+    char*              block;
+    size_t             bytes_read;
+    unique_lock<mutex> lock(mutex_);
+    bool               status;
+
+    while (true)
+    {
+      // Wait for a request (or for the order to stop).
+
+      while ((!stop_) && (!request_pending_)) request_posted_.wait(lock);
+
+      if (stop_) break;
+
+      //
+      // Read the chunk requested without holding the lock. block_ may be
+      // swapped with the buffer of the reader (see read_block()), but never
+      // while a request is pending.
+      //
+
+      block = block_;
+
+      lock.unlock();
+
+      status = read_file(request_offset_, block, request_bytes_, bytes_read);
+
+      lock.lock();
+
+      //
+      // Publish the result. On errors, the chunk is simply not made
+      // available; read() will find the error by itself.
+      //
+
+      block_offset_    = request_offset_;
+      block_bytes_     = status ? bytes_read : 0;
+      request_pending_ = false;
+
+      request_served_.notify_all();
+    }
+  }
+}
+
+size_t
+astrolabe_read_ahead::
+read_block
+(long long offset,
+ char*&    data,
+ size_t    n_bytes)
+{
+  {
+    size_t                           bytes_read;
+    long long                        current;
+    long long                        end;
+    char*                            full;
+    unique_lock<mutex>               lock(mutex_, defer_lock);
+    chrono::steady_clock::time_point started;
+
+    if ((file_ == NULL) && (stream_ == NULL)) return 0;
+
+    // Never go beyond the end of the file.
+
+    if ((offset < 0) || (offset >= file_size_)) return 0;
+
+    end = offset + (long long)n_bytes;
+    if (end > file_size_) end = file_size_;
+
+    started = chrono::steady_clock::now();
+
+    // Backward readers: make sure that the system loads what comes next.
+
+    prefetch_reverse_window(offset);
+
+    // No helper thread: just read the file.
+
+    if (!worker_is_running_)
+    {
+      if (!read_file(offset, data, (size_t)(end - offset), bytes_read)) error_ = true;
+
+      bytes_read_   += (long long)bytes_read;
+      read_seconds_ += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+      return bytes_read;
+    }
+
+    // Wait for the helper thread to finish the read in progress, if any.
+
+    lock.lock();
+
+    while (request_pending_) request_served_.wait(lock);
+
+    //
+    // When the chunk requested is the one read in advance, swap the
+    // buffers: the caller takes block_, and its own buffer becomes the one
+    // the helper thread reads the next chunk into. Otherwise, fill the
+    // chunk as read() does.
+    //
+
+    if ((block_bytes_ > 0) && (block_offset_ == offset) &&
+        ((block_offset_ + (long long)block_bytes_) >= end))
+    {
+      full    = block_;
+      block_  = data;
+      data    = full;
+      current = end;
+    }
+    else
+    {
+      current = copy_chunk(offset, end, data);
+    }
+
+    // The next chunk is not guessed; see schedule().
+
+    block_bytes_ = 0;
+
+    lock.unlock();
+
+    bytes_read_   += current - offset;
+    read_seconds_ += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    // That's all.
+
+    return (size_t)(current - offset);
+  }
+}
+
+bool
+astrolabe_read_ahead::
+read_file
+(long long offset,
+ char*     data,
+ size_t    n_bytes,
+ size_t&   bytes_read)
+{
+  {
+    bytes_read = 0;
+
+    if (n_bytes == 0) return true;
+
+    // Streams of binary (maybe compressed) files.
+
+    if (stream_ != NULL)
+    {
+      if (stream_->seek(offset) != 0) return false;
+
+      bytes_read = stream_->read((void*)data, n_bytes);
+
+      return !stream_->error();
+    }
+
+    // Plain files.
+
+    if (astr_fseek(file_, offset, SEEK_SET) != 0) return false;
+
+    bytes_read = fread((void*)data, 1, n_bytes, file_);
+
+    return (ferror(file_) == 0);
+  }
+}
+
+void
+astrolabe_read_ahead::
+schedule
+(long long offset,
+ size_t    n_bytes)
+{
+  {
+    long long          end;
+    unique_lock<mutex> lock(mutex_, defer_lock);
+
+    if (!worker_is_running_) return;
+
+    // Never go beyond the limits of the file.
+
+    end = offset + (long long)n_bytes;
+    if (offset < 0)        offset = 0;
+    if (end > file_size_)  end    = file_size_;
+    if (end <= offset)     return;
+
+    lock.lock();
+
+    while (request_pending_) request_served_.wait(lock);
+
+    if (error_) return;
+
+    block_bytes_     = 0;
+    request_offset_  = offset;
+    request_bytes_   = (size_t)(end - offset);
+    request_pending_ = true;
+
+    request_posted_.notify_all();
+  }
+}
+
+void
+astrolabe_read_ahead::
+set_reverse_window
+(long long window_size)
+{
+  {
+    reverse_window_    = window_size;
+    prefetched_offset_ = -1;
+  }
+}
+
+int
+astrolabe_read_ahead::
+start
+(int  block_size,
+ bool backward)
+{
+  {
+    if ((file_ == NULL) && (stream_ == NULL)) return 1;
+    if (worker_is_running_)                   return 1;
+    if (block_size <= 0)                      return 1;
+
+    backward_        = backward;
+    block_bytes_     = 0;
+    block_offset_    = 0;
+    block_size_      = (size_t)block_size;
+    request_pending_ = false;
+    stop_            = false;
+
+    // Allocate the second buffer and start the helper thread.
+
+    try
+    {
+      block_  = new char[block_size_];
+      worker_ = thread(&astrolabe_read_ahead::read_ahead, this);
+    }
+    catch (...)
+    {
+      if (block_ != NULL) delete [] block_;
+      block_ = NULL;
+      return 2;
+    }
+
+    worker_is_running_ = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
@@ -0,0 +1,358 @@
+/** \file astrolabe_read_ahead.hpp
+  \brief Background read-ahead of the chunks of a file.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef ASTROLABE_READ_AHEAD_HPP
+#define ASTROLABE_READ_AHEAD_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#include "astrolabe_compressed_file.hpp"
+#include "astrolabe_file_utilities.hpp"
+
+using namespace std;
+
+/**
+ * @brief Background read-ahead of the chunks of a file.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * File readers fill their data buffer, chunk after chunk, calling read()
+ * with the offset and size of every chunk. Once attached to a file (or to
+ * the stream of a, possibly compressed, binary file), this class serves
+ * these requests.
+ *
+ * By default, read() just reads the file. After start(), a helper thread
+ * reads the chunk that will most probably be requested next (the one
+ * following the last chunk read for forward readers; the one preceding
+ * it for backward ones) into a second buffer while the reader decodes
+ * the records in its data buffer. read() then copies the bytes already
+ * available there and only reads from the file those that were not
+ * guessed right (for instance, the bytes of the incomplete epochs that
+ * backward readers discard at the beginning of every chunk).
+ *
+ * Readers knowing exactly which chunk comes next may avoid that copy:
+ * schedule() asks the helper thread to read it, and read_block() then
+ * hands the second buffer over to the reader, taking the reader's data
+ * buffer in exchange (as astrolabe_write_behind::write() does).
+ *
+ * The file is never accessed by both threads at the same time: read()
+ * waits for the helper thread to complete any pending read before
+ * touching the file.
+ *
+ * Files read backwards defeat the read-ahead policy of the operating
+ * system, which assumes that files are read from their beginning to
+ * their end. When a reverse window is set (see set_reverse_window()),
+ * read() asks the system to load in advance the region of the file
+ * preceding the bytes requested (see astr_fprefetch()), so backward
+ * readers get the same benefits forward ones do.
+ *
+ * The number of bytes delivered by read() and the time spent waiting
+ * for them are recorded (see get_statistics()), so the throughput
+ * achieved by readers may be reported.
+ */
+
+class astrolabe_read_ahead
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                  astrolabe_read_ahead     (void);
+
+    /**
+     * @brief Destructor. Stops the helper thread, if any.
+     */
+
+                  ~astrolabe_read_ahead    (void);
+
+    /**
+     * @brief Attach a plain file.
+     *
+     * @param file The file, open for reading in binary mode. It is not
+     *        owned by this object; callers must detach() it before
+     *        closing it.
+     * @param size The size of the file in bytes.
+     */
+
+    void          attach                   (FILE*                      file,
+                                            long long                  size);
+
+    /**
+     * @brief Attach the stream of a binary file.
+     *
+     * @param stream The stream, already attached to its file. It is not
+     *        owned by this object; callers must detach() it before
+     *        detaching the stream itself.
+     */
+
+    void          attach                   (astrolabe_compressed_file* stream);
+
+    /**
+     * @brief Stop the helper thread and forget about the file attached.
+     */
+
+    void          detach                   (void);
+
+    /**
+     * @brief Check if an error has been detected by read().
+     * @return True if read() found an I/O error, false otherwise.
+     */
+
+    bool          error                    (void) const;
+
+    /**
+     * @brief Retrieve the I/O statistics of the file attached last.
+     *
+     * @param bytes_read Number of bytes delivered by read().
+     * @param seconds Time, in seconds, spent in read() (that is, the time
+     *        readers have been blocked waiting for data).
+     *
+     * Statistics are reset by attach() but not by detach(), so these
+     * may be retrieved once the file has been closed.
+     */
+
+    void          get_statistics           (long long&                 bytes_read,
+                                            double&                    seconds) const;
+
+    /**
+     * @brief Check if the helper thread is running.
+     * @return True if start() has been successfully called.
+     */
+
+    bool          is_started               (void) const;
+
+    /**
+     * @brief Read a chunk of the file.
+     *
+     * @param offset Offset of the first byte to read.
+     * @param data Where to copy the bytes read.
+     * @param n_bytes Number of bytes to read.
+     * @return The number of bytes read. Less than n_bytes at the end of the
+     *         file or on errors (see error()).
+     *
+     * Once the helper thread is started, the read of the next chunk is
+     * scheduled before returning.
+     */
+
+    size_t        read                     (long long                  offset,
+                                            void*                      data,
+                                            size_t                     n_bytes);
+
+    /**
+     * @brief Read a chunk of the file into a buffer that may be swapped
+     *        with the one holding the chunk read in advance.
+     *
+     * @param offset Offset of the first byte to read.
+     * @param data Buffer where the bytes read are stored, starting at its
+     *        first byte. It must have been allocated with new char[], with
+     *        the block size passed to start() as its size. When the chunk
+     *        requested is the one posted by schedule(), data is replaced by
+     *        the buffer holding it, and the old one is kept by this object,
+     *        that will delete it.
+     * @param n_bytes Number of bytes to read (at most, the block size).
+     * @return The number of bytes read. Less than n_bytes at the end of the
+     *         file or on errors (see error()).
+     *
+     * Unlike read(), the read of the next chunk is not scheduled; see
+     * schedule().
+     */
+
+    size_t        read_block               (long long                  offset,
+                                            char*&                     data,
+                                            size_t                     n_bytes);
+
+    /**
+     * @brief Ask the helper thread to read a chunk of the file in advance.
+     *
+     * @param offset Offset of the first byte to read.
+     * @param n_bytes Number of bytes to read (at most, the block size).
+     *
+     * Does nothing if the helper thread is not running. The range is
+     * clipped to the limits of the file.
+     */
+
+    void          schedule                 (long long                  offset,
+                                            size_t                     n_bytes);
+
+    /**
+     * @brief Set the size of the region preceding every read that the
+     *        system is asked to load in advance.
+     *
+     * @param window_size Size of the region, in bytes. 0 disables these
+     *        hints (the default).
+     *
+     * Meant for files read from their end to their beginning. Hints are
+     * not repeated while at least half the window preceding the bytes
+     * requested has already been hinted.
+     */
+
+    void          set_reverse_window       (long long                  window_size);
+
+    /**
+     * @brief Start the helper thread.
+     *
+     * @param block_size Size of the chunks read in advance (usually, the
+     *        size of the data buffer of the reader).
+     * @param backward True if the file is read from its end to its
+     *        beginning, false otherwise.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: No file attached or thread already started.
+     *         - 2: Not enough memory or unable to start the thread.
+     *
+     * Should start() fail, read() keeps on working, reading the file
+     * when called.
+     */
+
+    int           start                    (int                        block_size,
+                                            bool                       backward);
+
+  protected:
+
+    /**
+     * @brief Fill a chunk with the bytes in block_, reading from the file
+     *        those not available there.
+     *
+     * @pre The helper thread has no request pending.
+     * @param offset Offset of the first byte to deliver.
+     * @param end Offset following the last byte to deliver.
+     * @param data Where to copy the bytes.
+     * @return Offset following the last byte delivered (less than end on
+     *         errors; see error()).
+     */
+
+    long long     copy_chunk               (long long                  offset,
+                                            long long                  end,
+                                            char*                      data);
+
+    /**
+     * @brief Ask the system to load the reverse window preceding an offset,
+     *        unless already done.
+     *
+     * @param offset Offset of the first byte being read.
+     */
+
+    void          prefetch_reverse_window  (long long                  offset);
+
+    /**
+     * @brief Body of the helper thread.
+     */
+
+    void          read_ahead               (void);
+
+    /**
+     * @brief Read bytes from the file attached.
+     *
+     * @param offset Offset of the first byte to read.
+     * @param data Where to copy the bytes read.
+     * @param n_bytes Number of bytes to read.
+     * @param bytes_read Number of bytes actually read.
+     * @return True if successful, false if an I/O error arises.
+     */
+
+    bool          read_file                (long long                  offset,
+                                            char*                      data,
+                                            size_t                     n_bytes,
+                                            size_t&                    bytes_read);
+
+  protected:
+
+    /// @brief Flag. True if the file is read from its end to its beginning.
+
+    bool                       backward_;
+
+    /// @brief Buffer holding the chunk read in advance (block_size_ bytes).
+    ///        May be swapped with the data buffer of readers by read_block().
+
+    char*                      block_;
+
+    /// @brief Number of valid bytes in block_.
+
+    size_t                     block_bytes_;
+
+    /// @brief Offset in the file of the first byte in block_.
+
+    long long                  block_offset_;
+
+    /// @brief Size of the chunks read in advance.
+
+    size_t                     block_size_;
+
+    /// @brief Number of bytes delivered by read().
+
+    long long                  bytes_read_;
+
+    /// @brief Flag. True when read() has found an error.
+
+    bool                       error_;
+
+    /// @brief The plain file attached, if any.
+
+    FILE*                      file_;
+
+    /// @brief Size of the file attached.
+
+    long long                  file_size_;
+
+    /// @brief Mutex protecting the members shared with the helper thread.
+
+    mutex                      mutex_;
+
+    /// @brief Lowest offset hinted by prefetch_reverse_window() (-1 if none).
+
+    long long                  prefetched_offset_;
+
+    /// @brief Time, in seconds, spent in read().
+
+    double                     read_seconds_;
+
+    /// @brief Signaled when there's a request or the thread must stop.
+
+    condition_variable         request_posted_;
+
+    /// @brief Signaled when the chunk requested has been read.
+
+    condition_variable         request_served_;
+
+    /// @brief Size of the chunk requested to the helper thread.
+
+    size_t                     request_bytes_;
+
+    /// @brief Offset of the chunk requested to the helper thread.
+
+    long long                  request_offset_;
+
+    /// @brief Flag. True while the helper thread has a request to serve.
+
+    bool                       request_pending_;
+
+    /// @brief Size of the region hinted before every read (0: none).
+
+    long long                  reverse_window_;
+
+    /// @brief Flag. True when the helper thread must finish.
+
+    bool                       stop_;
+
+    /// @brief The stream attached, if any.
+
+    astrolabe_compressed_file* stream_;
+
+    /// @brief The helper thread.
+
+    thread                     worker_;
+
+    /// @brief Flag. True while the helper thread is running.
+
+    bool                       worker_is_running_;
+};
+
+#endif // ASTROLABE_READ_AHEAD_HPP
@@ -0,0 +1,388 @@
+/** \file astrolabe_record_parser.cpp
+  \brief Implementation file for astrolabe_record_parser.hpp
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_record_parser.hpp"
+
+#include "astrolabe_number_parser.hpp"
+
+bool
+astr_is_whitespace
+(char chr)
+{
+  {
+    if (chr == ' ' ) return true;
+    if (chr == '\t') return true;
+    if (chr == '\n') return true;
+    if (chr == '\r') return true;
+
+    return false;
+  }
+}
+
+int
+astr_parse_attributes
+(const char*          buffer,
+ int                  parse_from,
+ int                  parse_to,
+ map<string, string>& attributes)
+{
+  {
+    int chars_to_copy;
+    int copyfrom;
+    int copyto;
+    int i;
+
+    // Check limits and non-null input buffer.
+
+    if (parse_from > parse_to) return 1;
+    if (buffer == NULL)      return 1;
+
+    //
+    // Reset the contents of the attributes map, just in case it's been
+    // used before by the calling module.
+    //
+
+    attributes.clear();
+
+    // Start parsing.
+
+    i = parse_from;
+
+    // Parse all attribute pair.
+
+    while (i <= parse_to)
+    {
+
+      //
+      // Skip all leading whitespace before the attribute name.
+      // Note that if the buffer is exhausted at this point, it
+      // means that no more attribute pairs exist, so reaching
+      // the end of such buffers implies no error, but just the
+      // end of our work...
+      //
+
+      while ((i <= parse_to) && (astr_is_whitespace(buffer[i]))) i++;
+      if (i > parse_to) return 0;
+
+      //
+      // Here, i points, presumably, to the first non-whitespace character,
+      // the beginning of the attribute name and our starting copy
+      // position.
+      //
+
+      copyfrom = i;
+
+      //
+      // Check that we have a non '=' and a non '"' char (our XML delimiters
+      // for attributes).
+      //
+
+      if ((buffer[copyfrom] == '=') ||
+          (buffer[copyfrom] == '"')) return 1;
+
+      //
+      // Nice! We have at copyfrom what seems to be the beginning of the
+      // attribute name.
+      //
+      // Look for its end. We'll start right after the current character,
+      // which has already been tested.
+      //
+
+      i++;
+
+      while ((i <= parse_to) && (!astr_is_whitespace(buffer[i])) && (buffer[i] != '='))
+      {
+        if (buffer[i] == '"') return 1;
+        i++;
+      }
+      if (i > parse_to) return 1;
+
+      // Here, i points to the first whitespace or '=' character. Just
+      // before this position is where our attribute name finishes.
+      //
+
+      copyto = i-1;
+
+      // Compute the length of the attribute value.
+
+      chars_to_copy = copyto - copyfrom + 1;
+
+      // Copy the attribute name to a temporal string.
+
+      string attr_name(&(buffer[copyfrom]), (size_t)(chars_to_copy));
+
+      //
+      // Skip all whitespace until we find the character '='. Note that
+      // we could be already positioned over the '=' char, if the previous
+      // look stopped by this reason.
+      //
+
+      while (i <= parse_to)
+      {
+        if (buffer[i] == '=') break;
+        if (!astr_is_whitespace(buffer[i])) return 1;
+
+        i++;
+      }
+      if (i > parse_to) return 1;
+
+      //
+      // At this point, i points to the '=' character. Make it
+      // point right after that.
+      //
+
+      i++;
+
+      //
+      // Skip all whitespace until we find the character '"', which
+      // delimites the beginning of the attribute value.
+      //
+
+      while (i <= parse_to)
+      {
+        if (buffer[i] == '"') break;
+        if (!astr_is_whitespace(buffer[i])) return 1;
+
+        i++;
+      }
+      if (i > parse_to) return 1;
+
+      //
+      // Here, i points to the '"' character. Skip it, so
+      // we get positioned just after it.
+      //
+
+      i++;
+
+      //
+      // This is the position where the attribute value should begin,
+      // and therefore our starting position for the later copy operation.
+      //
+
+      copyfrom = i;
+
+      //
+      // Keep scanning until we find another '"' char. This will
+      // be the value of the attribute. Note that we start
+      // scanning at position copyfrom, since a couple of consecutive
+      // quotes ("") could show up, which would be an error. If
+      // we skip this fisrt position, we could inadvertedly ignore
+      // this erroneous situation.
+      //
+
+      while ((i <= parse_to) && (buffer[i] != '"')) i++; 
+      if (i > parse_to) return 1;
+
+      //
+      // i points to the second '"' character.
+      // We must copy just before that position.
+      //
+
+      copyto = i-1;
+
+      // Compute the length of the string to copy.
+
+      chars_to_copy = copyto - copyfrom + 1;
+
+      //
+      // Test that this length is not zero (this would happen if
+      // a couple of consecutive quotes ("") is what we've found.
+      //
+
+      if (chars_to_copy < 1) return 1;
+
+      // Convert the attribute value to string.
+
+      string attr_value(&(buffer[copyfrom]), size_t(chars_to_copy));
+
+      // Insert the attribute name + value pair in our output map.
+
+      attributes.insert(pair<string,string>(attr_name, attr_value));
+
+      //
+      // Make i point right after the '"' char, ready to start
+      // the parsing of a new attribute name / value pair.
+      //
+
+      i++;
+
+    }
+
+    return 0;
+  }
+}
+
+int
+astr_parse_closing_tag
+(const char* buffer,
+ int&        cursor,
+ int         record_end,
+ const char* lctag,
+ const char* uctag)
+{
+  {
+    char chr;
+    int  i;
+    int  j;
+    bool lctag_found;
+    bool uctag_found;
+
+    //
+    // The remaining characters in the record, excluding whitespace, must
+    // be those of the closing tag. Note that there could be some whitespace
+    // merged with the tag itself, as for instance "< /l  >" (quotes
+    // excluded). Compare them, one at a time, with both versions of the tag.
+    //
+
+    lctag_found = true;
+    uctag_found = true;
+
+    j = 0;
+    for (i = cursor; i <= record_end; i++)
+    {
+      chr = buffer[i];
+
+      if (astr_is_whitespace(chr)) continue;
+
+      // Too many characters?
+
+      if (lctag[j] == 0) return 1;
+
+      if (chr != lctag[j]) lctag_found = false;
+      if (chr != uctag[j]) uctag_found = false;
+
+      j++;
+    }
+
+    // The record has been processed completely.
+
+    cursor = record_end + 1;
+
+    // Too few characters?
+
+    if (lctag[j] != 0) return 1;
+
+    // Malformed record unless one of the versions of the tag was found.
+
+    if ((!lctag_found) && (!uctag_found)) return 1;
+
+    return 0;
+  }
+}
+
+int
+astr_parse_double_value
+(const char* buffer,
+ int&        cursor,
+ int         record_end,
+ double&     value)
+{
+  {
+    char        chr;
+    const char* text_end;
+    const char* text_start;
+
+    //
+    // Skip any whitespace that might be present before the text representing
+    // the double value.
+    //
+
+    chr = buffer[cursor];
+
+    while (astr_is_whitespace(chr))
+    {
+      cursor++;
+      chr = buffer[cursor];
+    }
+
+    //
+    // Convert the text in place, directly from the buffer. Note that
+    // the conversion may not go beyond the end of the current record.
+    //
+
+    text_start = &(buffer[cursor]);
+    text_end   = &(buffer[record_end + 1]);
+
+    if (astr_parse_double(text_start, text_end, value, &text_end) != 0)
+    {
+      // The text read does not represent a legal double value!!!
+      return 1;
+    }
+
+    cursor += (int)(text_end - text_start);
+
+    //
+    // The value must be followed by whitespace or by an opening <. This
+    // last test is made to deal with the situation in which the last
+    // double in a record is adjacent to the closing tag, thus allowing
+    // no spaces between these two elements.
+    //
+
+    chr = buffer[cursor];
+
+    if ((!astr_is_whitespace(chr)) && (chr != '<'))
+    {
+      // The text read does not represent a legal double value!!!
+      return 1;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+astr_parse_int_value
+(const char* buffer,
+ int&        cursor,
+ int         record_end,
+ int&        value)
+{
+  {
+    char        chr;
+    const char* text_end;
+    const char* text_start;
+
+    //
+    // Skip any whitespace that might be present before the text representing
+    // the integer value.
+    //
+
+    chr = buffer[cursor];
+
+    while (astr_is_whitespace(chr))
+    {
+      cursor++;
+      chr = buffer[cursor];
+    }
+
+    //
+    // Only digits are accepted (no sign). Convert them in place, directly
+    // from the buffer.
+    //
+
+    if ((chr < '0') || (chr > '9'))
+    {
+      //  The text read does not represent a legal integer value!!!
+      return 1;
+    }
+
+    text_start = &(buffer[cursor]);
+    text_end   = &(buffer[record_end + 1]);
+
+    if (astr_parse_int(text_start, text_end, value, &text_end) != 0)
+    {
+      //  The text read does not represent a legal integer value!!!
+      return 1;
+    }
+
+    cursor += (int)(text_end - text_start);
+
+    // That's all.
+
+    return 0;
+  }
+}
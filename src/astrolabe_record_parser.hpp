@@ -0,0 +1,112 @@
+/** \file astrolabe_record_parser.hpp
+  \brief Utilities to parse the contents of the records in ASTROLABE
+    text files.
+  \ingroup ASTROLABE_data_IO
+
+  This file provides with the functions used by text readers to parse
+  the attributes, values and closing tags of l- and o-records. These
+  work on any character buffer, given the position where parsing must
+  start (the cursor, updated as parsing goes on) and the position of the
+  last character in the record; they keep no state of their own, so
+  sequential readers may parse their data buffer with them while the
+  worker threads of parallel readers parse other ranges of the file.
+*/
+
+#ifndef __ASTROLABE_RECORD_PARSER_HPP__
+#define __ASTROLABE_RECORD_PARSER_HPP__
+
+#include <map>
+#include <string>
+
+using namespace std;
+
+/// \brief Check if a character is considered as whitespace in text records.
+/**
+  \param chr The character to check.
+  \return True if chr is a blank, a tab, a carriage return or a line
+    feed, false otherwise.
+  */
+
+bool      astr_is_whitespace        (char chr);
+
+/// \brief Parse the attributes in an XML tag.
+/**
+  \pre buffer != NULL
+  \param buffer Text to parse.
+  \param parse_from Index in buffer where parsing starts (included).
+  \param parse_to Index in buffer where parsing stops (included).
+  \param attributes Output. The attribute names and values found. Cleared
+    before parsing starts.
+  \return 0 if successful, non zero if the text is not a legal list of
+    attributes (name="value" pairs separated by whitespace).
+  */
+
+int       astr_parse_attributes     (const char*          buffer,
+                                     int                  parse_from,
+                                     int                  parse_to,
+                                     map<string, string>& attributes);
+
+/// \brief Check that the rest of a record is just whitespace plus a closing tag.
+/**
+  \pre buffer != NULL
+  \param buffer Text to parse.
+  \param cursor Index in buffer where parsing starts. On output, the index
+    following the last character in the record (record_end + 1).
+  \param record_end Index in buffer of the last character in the record.
+  \param lctag Closing tag, lowercase version (for instance, "</l>").
+  \param uctag Closing tag, uppercase version (for instance, "</L>").
+  \return 0 if the remaining characters, once whitespace is removed, are
+    either lctag or uctag, non zero otherwise.
+
+  Whitespace is allowed inside the tag itself (as in "< /l  >").
+  */
+
+int       astr_parse_closing_tag    (const char*          buffer,
+                                     int&                 cursor,
+                                     int                  record_end,
+                                     const char*          lctag,
+                                     const char*          uctag);
+
+/// \brief Parse the next double value in a record.
+/**
+  \pre buffer != NULL
+  \param buffer Text to parse.
+  \param cursor Index in buffer where parsing starts. Updated to point
+    to the character following the value, when successful.
+  \param record_end Index in buffer of the last character in the record.
+    Parsing never goes beyond it.
+  \param value Output. The double value, when successful.
+  \return 0 if successful, non zero if the first non whitespace characters
+    found are not a legal double value followed by whitespace or by the
+    '<' of the closing tag.
+
+  Leading whitespace is skipped. See astr_parse_double() for the syntax
+  accepted.
+  */
+
+int       astr_parse_double_value   (const char*          buffer,
+                                     int&                 cursor,
+                                     int                  record_end,
+                                     double&              value);
+
+/// \brief Parse the next integer value in a record.
+/**
+  \pre buffer != NULL
+  \param buffer Text to parse.
+  \param cursor Index in buffer where parsing starts. Updated to point
+    to the character following the value, when successful.
+  \param record_end Index in buffer of the last character in the record.
+    Parsing never goes beyond it.
+  \param value Output. The integer value, when successful.
+  \return 0 if successful, non zero if the first non whitespace characters
+    found are not an unsigned integer value.
+
+  Leading whitespace is skipped. Signs are not accepted.
+  */
+
+int       astr_parse_int_value      (const char*          buffer,
+                                     int&                 cursor,
+                                     int                  record_end,
+                                     int&                 value);
+
+#endif // __ASTROLABE_RECORD_PARSER_HPP__
@@ -0,0 +1,60 @@
+/** \file astrolabe_socket_utilities.cpp
+  \brief Implementation file for astrolabe_socket_utilities.hpp
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_socket_utilities.hpp"
+
+int
+astr_socket_get_int
+(const char* buffer)
+{
+  {
+    unsigned int value;
+
+    value = ((unsigned int)(unsigned char)buffer[0] << 24) |
+            ((unsigned int)(unsigned char)buffer[1] << 16) |
+            ((unsigned int)(unsigned char)buffer[2] <<  8) |
+            ((unsigned int)(unsigned char)buffer[3]);
+
+    return (int)value;
+  }
+}
+
+void
+astr_socket_put_int
+(char* buffer,
+ int   value)
+{
+  {
+    buffer[0] = (char)(((unsigned int)value >> 24) & 0xff);
+    buffer[1] = (char)(((unsigned int)value >> 16) & 0xff);
+    buffer[2] = (char)(((unsigned int)value >>  8) & 0xff);
+    buffer[3] = (char)( (unsigned int)value        & 0xff);
+  }
+}
+
+void
+astr_socket_recv_all
+(TCPSocket* socket,
+ char*      buffer,
+ int        n_bytes)
+{
+  {
+    int bytes_received;
+    int total_bytes_received;
+
+    total_bytes_received = 0;
+
+    while (total_bytes_received < n_bytes)
+    {
+      bytes_received = socket->recv(buffer + total_bytes_received, n_bytes - total_bytes_received);
+
+      // Zero means that the other end closed the connection.
+
+      if (bytes_received <= 0) throw SocketException("Connection closed while receiving data");
+
+      total_bytes_received += bytes_received;
+    }
+  }
+}
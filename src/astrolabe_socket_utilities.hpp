@@ -0,0 +1,97 @@
+/** \file astrolabe_socket_utilities.hpp
+  \brief Utilities shared by socket readers and writers.
+  \ingroup ASTROLABE_data_IO
+
+  Socket writers (obs_e_based_socket_writer, r_matrix_socket_writer) and
+  readers (obs_e_based_socket_reader, r_matrix_socket_reader) talk using
+  one of two protocols:
+
+  - Stop-and-wait (the classic one). Every record (and the end-of-file
+    command) is sent with a single send() and acknowledged by the
+    receiver with a single character before the writer may go on. The
+    throughput is therefore limited to one record per round trip.
+  - Windowed. Every message is preceded by its length, as an XDR int,
+    so several of these may travel at the same time. The writer may have
+    up to "window" records not yet acknowledged, and the receiver sends
+    cumulative acknowledgements: an XDR int with the number of messages
+    received since the previous acknowledgement.
+
+  Connections start with the stop-and-wait protocol. Writers asking for
+  a window greater than one send a hello command ("v", the protocol
+  version and the window wanted, XDR coded) before any record. The
+  command is acknowledged as a regular record, and then the receiver
+  answers with two XDR ints: the protocol version it will use and the
+  window it accepts (never greater than the one asked for). Readers
+  always answer, even when rejecting the request (then, the answer is
+  the stop-and-wait protocol and a window of one), and writers keep on
+  using stop-and-wait when the answer is not the windowed protocol.
+  Old readers, not knowing about the hello command, never answer it:
+  writers give up once _ASTROLABE_SOCKET_HELLO_TIMEOUT milliseconds
+  elapse without the answer, and open() fails instead of blocking.
+  Since writers not asking for a window never send the hello command,
+  these work with every reader, new or old.
+*/
+
+#ifndef __ASTROLABE_SOCKET_UTILITIES_HPP__
+#define __ASTROLABE_SOCKET_UTILITIES_HPP__
+
+#include "PracticalSocket.h"
+
+/// \brief Protocol version: one acknowledgement per record.
+
+#define _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT 1
+
+/// \brief Protocol version: length prefixed messages and cumulative
+/// acknowledgements.
+
+#define _ASTROLABE_SOCKET_PROTOCOL_WINDOWED      2
+
+/// \brief Default maximum window accepted by socket readers.
+
+#define _ASTROLABE_SOCKET_DEFAULT_MAX_WINDOW     64
+
+/// \brief Time, in milliseconds, writers wait for the answer to the hello
+/// command (including its acknowledgement) before giving up.
+
+#define _ASTROLABE_SOCKET_HELLO_TIMEOUT          5000
+
+/// \brief Size, in bytes, of an XDR int (message lengths, acknowledgements
+/// and answers to the hello command).
+
+#define _ASTROLABE_SOCKET_XDR_INT_SIZE           4
+
+/// \brief Decode an XDR int.
+/**
+  \pre buffer != NULL
+  \param buffer The 4 bytes holding the int (big endian, two's complement).
+  \return The value decoded.
+  */
+
+int       astr_socket_get_int    (const char* buffer);
+
+/// \brief Encode an XDR int.
+/**
+  \pre buffer != NULL
+  \param buffer Where to store the 4 bytes of the int.
+  \param value The value to encode.
+  */
+
+void      astr_socket_put_int    (char* buffer, int value);
+
+/// \brief Receive an exact number of bytes.
+/**
+  \pre (socket != NULL) && (buffer != NULL)
+  \param socket The connection.
+  \param buffer Where to store the bytes received.
+  \param n_bytes Number of bytes to receive.
+  \throw SocketException The connection has been closed or broken before
+    receiving n_bytes bytes.
+
+  A single recv() may return fewer bytes than those sent with a single
+  send(), or bytes belonging to several send() calls; this function keeps
+  on calling recv() until n_bytes bytes are received.
+  */
+
+void      astr_socket_recv_all   (TCPSocket* socket, char* buffer, int n_bytes);
+
+#endif // __ASTROLABE_SOCKET_UTILITIES_HPP__
@@ -0,0 +1,502 @@
+/** \file astrolabe_text_scanner.cpp
+  \brief Implementation file for astrolabe_text_scanner.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_text_scanner.hpp"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+  #define ASTR_TEXT_SCANNER_X86
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #endif
+#endif
+
+//
+// GCC and clang compile the AVX2 (and, on 32 bit targets, SSE2) functions
+// for these instruction sets without enabling them for the rest of the
+// code. MSVC needs no such thing.
+//
+
+#if defined(ASTR_TEXT_SCANNER_X86) && (defined(__GNUC__) || defined(__clang__))
+  #define ASTR_TARGET_AVX2 __attribute__((target("avx2")))
+  #define ASTR_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+  #define ASTR_TARGET_AVX2
+  #define ASTR_TARGET_SSE2
+#endif
+
+/// \brief Index of the lowest bit set in a (non zero) mask.
+
+static inline int
+lowest_bit
+(unsigned int mask)
+{
+  {
+    #ifdef _MSC_VER
+      unsigned long index;
+
+      _BitScanForward(&index, mask);
+      return (int)index;
+    #else
+      return __builtin_ctz(mask);
+    #endif
+  }
+}
+
+/// \brief Index of the highest bit set in a (non zero) mask.
+
+static inline int
+highest_bit
+(unsigned int mask)
+{
+  {
+    #ifdef _MSC_VER
+      unsigned long index;
+
+      _BitScanReverse(&index, mask);
+      return (int)index;
+    #else
+      return 31 - __builtin_clz(mask);
+    #endif
+  }
+}
+
+/// \brief Make room for, at least, extra more positions in the output vector.
+
+static inline int*
+reserve_positions
+(vector<int>& positions,
+ int          n_positions,
+ int          extra)
+{
+  {
+    if ((n_positions + extra) > (int)positions.size())
+    {
+      positions.resize(2 * positions.size() + extra);
+    }
+
+    return positions.data();
+  }
+}
+
+/// \brief Store the positions of the bits set in a mask.
+
+static inline int
+store_positions
+(unsigned int mask,
+ int          base,
+ int*         positions,
+ int          n_positions)
+{
+  {
+    while (mask != 0)
+    {
+      positions[n_positions] = base + lowest_bit(mask);
+      n_positions++;
+      mask &= mask - 1;
+    }
+
+    return n_positions;
+  }
+}
+
+/// \brief Locate the delimiters in buffer[from] to buffer[size - 1], one byte at a time.
+
+static int
+scan_scalar
+(const char*  buffer,
+ int          from,
+ int          size,
+ vector<int>& positions,
+ int          n_positions)
+{
+  {
+    int  n_reserved;
+    int* out;
+
+    //
+    // Delimiters are sparse, so room is made in small steps instead of for
+    // every byte in the range.
+    //
+
+    out        = reserve_positions(positions, n_positions, 16);
+    n_reserved = (int)positions.size();
+
+    for (; from < size; from++)
+    {
+      if ((buffer[from] == '<') || (buffer[from] == '>'))
+      {
+        if (n_positions == n_reserved)
+        {
+          out        = reserve_positions(positions, n_positions, 16);
+          n_reserved = (int)positions.size();
+        }
+
+        out[n_positions] = from;
+        n_positions++;
+      }
+    }
+
+    return n_positions;
+  }
+}
+
+/// \brief Find the last occurrence of a character in buffer[0] to buffer[size - 1],
+/// one byte at a time.
+
+static int
+find_last_scalar
+(const char* buffer,
+ int         size,
+ char        delimiter)
+{
+  {
+    int i;
+
+    for (i = size - 1; i >= 0; i--)
+    {
+      if (buffer[i] == delimiter) return i;
+    }
+
+    return -1;
+  }
+}
+
+#ifdef ASTR_TEXT_SCANNER_X86
+
+/// \brief Find the last occurrence of a character in a buffer, 16 bytes at a time.
+
+ASTR_TARGET_SSE2 static int
+find_last_sse2
+(const char* buffer,
+ int         size,
+ char        delimiter)
+{
+  {
+    __m128i      block;
+    int          i;
+    unsigned int mask;
+    __m128i      target;
+
+    target = _mm_set1_epi8(delimiter);
+
+    for (i = size; i >= 16; i -= 16)
+    {
+      block = _mm_loadu_si128((const __m128i*)(buffer + i - 16));
+      mask  = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, target));
+
+      if (mask != 0) return i - 16 + highest_bit(mask);
+    }
+
+    // Bytes left (at the beginning of the buffer), if any.
+
+    return find_last_scalar(buffer, i, delimiter);
+  }
+}
+
+/// \brief Find the last occurrence of a character in a buffer, 32 bytes at a time.
+
+ASTR_TARGET_AVX2 static int
+find_last_avx2
+(const char* buffer,
+ int         size,
+ char        delimiter)
+{
+  {
+    __m256i      block;
+    int          i;
+    unsigned int mask;
+    __m256i      target;
+
+    target = _mm256_set1_epi8(delimiter);
+    mask   = 0;
+
+    for (i = size; i >= 32; i -= 32)
+    {
+      block = _mm256_loadu_si256((const __m256i*)(buffer + i - 32));
+      mask  = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, target));
+
+      if (mask != 0) break;
+    }
+
+    // Avoid the penalty of mixing AVX and SSE code afterwards.
+
+    _mm256_zeroupper();
+
+    if (mask != 0) return i - 32 + highest_bit(mask);
+
+    // Bytes left (at the beginning of the buffer), if any.
+
+    return find_last_scalar(buffer, i, delimiter);
+  }
+}
+
+/// \brief Locate the delimiters in a buffer, 16 bytes at a time.
+
+ASTR_TARGET_SSE2 static int
+scan_sse2
+(const char*  buffer,
+ int          size,
+ vector<int>& positions)
+{
+  {
+    __m128i      block;
+    __m128i      closing;
+    int          i;
+    unsigned int mask;
+    int          n_positions;
+    __m128i      opening;
+    int*         out;
+
+    opening     = _mm_set1_epi8('<');
+    closing     = _mm_set1_epi8('>');
+    n_positions = 0;
+
+    for (i = 0; (i + 16) <= size; i += 16)
+    {
+      block = _mm_loadu_si128((const __m128i*)(buffer + i));
+      mask  = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, opening),
+                                                           _mm_cmpeq_epi8(block, closing)));
+
+      if (mask != 0)
+      {
+        out         = reserve_positions(positions, n_positions, 16);
+        n_positions = store_positions(mask, i, out, n_positions);
+      }
+    }
+
+    // Bytes left, if any.
+
+    return scan_scalar(buffer, i, size, positions, n_positions);
+  }
+}
+
+/// \brief Locate the delimiters in a buffer, 32 bytes at a time.
+
+ASTR_TARGET_AVX2 static int
+scan_avx2
+(const char*  buffer,
+ int          size,
+ vector<int>& positions)
+{
+  {
+    __m256i      block;
+    __m256i      closing;
+    int          i;
+    unsigned int mask;
+    int          n_positions;
+    __m256i      opening;
+    int*         out;
+
+    opening     = _mm256_set1_epi8('<');
+    closing     = _mm256_set1_epi8('>');
+    n_positions = 0;
+
+    for (i = 0; (i + 32) <= size; i += 32)
+    {
+      block = _mm256_loadu_si256((const __m256i*)(buffer + i));
+      mask  = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, opening),
+                                                                 _mm256_cmpeq_epi8(block, closing)));
+
+      if (mask != 0)
+      {
+        out         = reserve_positions(positions, n_positions, 32);
+        n_positions = store_positions(mask, i, out, n_positions);
+      }
+    }
+
+    // Avoid the penalty of mixing AVX and SSE code afterwards.
+
+    _mm256_zeroupper();
+
+    // Bytes left, if any.
+
+    return scan_scalar(buffer, i, size, positions, n_positions);
+  }
+}
+
+#endif // ASTR_TEXT_SCANNER_X86
+
+/// \brief Find the best instruction set supported by the processor and
+/// the operating system.
+
+static int
+detect_instruction_set
+(void)
+{
+  {
+    #if !defined(ASTR_TEXT_SCANNER_X86)
+
+      return _ASTROLABE_TEXT_SCANNER_SCALAR;
+
+    #elif defined(_MSC_VER)
+
+      int info[4];
+
+      __cpuid(info, 0);
+      if (info[0] < 7) return _ASTROLABE_TEXT_SCANNER_SSE2;
+
+      //
+      // AVX2 needs the processor to support it (leaf 7, EBX bit 5) and the
+      // operating system to save the AVX registers (OSXSAVE, then XCR0).
+      //
+
+      __cpuid(info, 1);
+      if ((info[2] & (1 << 27)) == 0) return _ASTROLABE_TEXT_SCANNER_SSE2;
+      if ((_xgetbv(0) & 6) != 6)      return _ASTROLABE_TEXT_SCANNER_SSE2;
+
+      __cpuidex(info, 7, 0);
+      if ((info[1] & (1 << 5)) == 0)  return _ASTROLABE_TEXT_SCANNER_SSE2;
+
+      return _ASTROLABE_TEXT_SCANNER_AVX2;
+
+    #else
+
+      __builtin_cpu_init();
+
+      if (__builtin_cpu_supports("avx2")) return _ASTROLABE_TEXT_SCANNER_AVX2;
+      if (__builtin_cpu_supports("sse2")) return _ASTROLABE_TEXT_SCANNER_SSE2;
+
+      return _ASTROLABE_TEXT_SCANNER_SCALAR;
+
+    #endif
+  }
+}
+
+astrolabe_text_scanner::
+astrolabe_text_scanner
+(void)
+{
+  {
+    static const int best_instruction_set = detect_instruction_set();
+
+    cursor_          = 0;
+    instruction_set_ = best_instruction_set;
+    n_delimiters_    = 0;
+  }
+}
+
+astrolabe_text_scanner::
+~astrolabe_text_scanner
+(void)
+{
+  {
+    // INTENTIONALLY LEFT BLANK.
+  }
+}
+
+int
+astrolabe_text_scanner::
+delimiter
+(int index)
+const
+{
+  {
+    return delimiters_[index];
+  }
+}
+
+int
+astrolabe_text_scanner::
+find
+(int position)
+{
+  {
+    //
+    // Readers move forward: most of the time, the delimiter sought is
+    // the one found last or one of the few following it. Otherwise, use
+    // a binary search.
+    //
+
+    if ((cursor_ > n_delimiters_) ||
+        ((cursor_ > 0) && (delimiters_[cursor_ - 1] >= position)))
+    {
+      cursor_ = (int)(lower_bound(delimiters_.begin(), delimiters_.begin() + n_delimiters_, position) -
+                      delimiters_.begin());
+      return cursor_;
+    }
+
+    while ((cursor_ < n_delimiters_) && (delimiters_[cursor_] < position)) cursor_++;
+
+    return cursor_;
+  }
+}
+
+int
+astrolabe_text_scanner::
+find_last
+(const char* buffer,
+ int         size,
+ char        delimiter)
+const
+{
+  {
+    if (size <= 0) return -1;
+
+    #ifdef ASTR_TEXT_SCANNER_X86
+      if (instruction_set_ == _ASTROLABE_TEXT_SCANNER_AVX2) return find_last_avx2(buffer, size, delimiter);
+      if (instruction_set_ == _ASTROLABE_TEXT_SCANNER_SSE2) return find_last_sse2(buffer, size, delimiter);
+    #endif
+
+    return find_last_scalar(buffer, size, delimiter);
+  }
+}
+
+int
+astrolabe_text_scanner::
+instruction_set
+(void)
+const
+{
+  {
+    return instruction_set_;
+  }
+}
+
+int
+astrolabe_text_scanner::
+n_delimiters
+(void)
+const
+{
+  {
+    return n_delimiters_;
+  }
+}
+
+void
+astrolabe_text_scanner::
+scan
+(const char* buffer,
+ int         size)
+{
+  {
+    cursor_ = 0;
+
+    if (size <= 0)
+    {
+      n_delimiters_ = 0;
+      return;
+    }
+
+    #ifdef ASTR_TEXT_SCANNER_X86
+      if (instruction_set_ == _ASTROLABE_TEXT_SCANNER_AVX2)
+      {
+        n_delimiters_ = scan_avx2(buffer, size, delimiters_);
+        return;
+      }
+
+      if (instruction_set_ == _ASTROLABE_TEXT_SCANNER_SSE2)
+      {
+        n_delimiters_ = scan_sse2(buffer, size, delimiters_);
+        return;
+      }
+    #endif
+
+    n_delimiters_ = scan_scalar(buffer, 0, size, delimiters_, 0);
+  }
+}
@@ -0,0 +1,153 @@
+/** \file astrolabe_text_scanner.hpp
+  \brief Bulk location of the tag delimiters in a text buffer.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef ASTROLABE_TEXT_SCANNER_HPP
+#define ASTROLABE_TEXT_SCANNER_HPP
+
+#include <vector>
+
+using namespace std;
+
+/// @brief No vector instructions used by astrolabe_text_scanner.
+
+#define _ASTROLABE_TEXT_SCANNER_SCALAR 0
+
+/// @brief SSE2 instructions (16 bytes at a time) used by astrolabe_text_scanner.
+
+#define _ASTROLABE_TEXT_SCANNER_SSE2   1
+
+/// @brief AVX2 instructions (32 bytes at a time) used by astrolabe_text_scanner.
+
+#define _ASTROLABE_TEXT_SCANNER_AVX2   2
+
+/**
+ * @brief Bulk location of the tag delimiters in a text buffer.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * Records in ASTROLABE text files are delimited by their opening and
+ * closing tags, so finding where records start and end amounts to find
+ * the '<' and '>' characters in the data buffer. Instead of checking the
+ * buffer one byte at a time, text readers call scan() once per chunk.
+ * This method compares 16 (SSE2) or 32 (AVX2) bytes at a time and stores
+ * the positions of all the delimiters found, in increasing order.
+ * Readers then move from one record to the next using these positions
+ * (see find() and delimiter()).
+ *
+ * Backward readers, on the contrary, look for the beginning of the record
+ * preceding a given position. find_last() searches the buffer from its end
+ * to its beginning, with the same instruction sets, for that purpose.
+ *
+ * The instruction set is chosen at run time: AVX2 when the processor
+ * (and operating system) support it, SSE2 otherwise. A portable scalar
+ * loop is used on processors other than x86 ones.
+ */
+
+class astrolabe_text_scanner
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                  astrolabe_text_scanner   (void);
+
+    /**
+     * @brief Destructor.
+     */
+
+                  ~astrolabe_text_scanner  (void);
+
+    /**
+     * @brief Position of a delimiter.
+     *
+     * @param index Index of the delimiter, 0 to n_delimiters() - 1.
+     * @return The position in the buffer scanned of the index-th
+     *         delimiter found.
+     */
+
+    int           delimiter                (int         index) const;
+
+    /**
+     * @brief Find the first delimiter at or after a given position.
+     *
+     * @param position Position in the buffer scanned.
+     * @return The index of the first delimiter whose position is equal
+     *         to or greater than the one requested, or n_delimiters() if
+     *         there is none.
+     *
+     * Readers move forward, so the search starts at the index returned
+     * by the previous call whenever possible.
+     */
+
+    int           find                     (int         position);
+
+    /**
+     * @brief Find the last occurrence of a character in a buffer.
+     *
+     * @param buffer The buffer to search.
+     * @param size Number of bytes to search, starting at buffer[0].
+     * @param delimiter The character sought (usually, '<' or '>').
+     * @return The position in the buffer of the last occurrence of
+     *         delimiter, or -1 if there is none (or size is not positive).
+     *
+     * The buffer is searched from its end to its beginning. Unlike scan(),
+     * no positions are stored and the state of the scanner is not changed.
+     */
+
+    int           find_last                (const char* buffer,
+                                            int         size,
+                                            char        delimiter) const;
+
+    /**
+     * @brief Retrieve the instruction set used by scan().
+     * @return _ASTROLABE_TEXT_SCANNER_SCALAR, _ASTROLABE_TEXT_SCANNER_SSE2
+     *         or _ASTROLABE_TEXT_SCANNER_AVX2.
+     */
+
+    int           instruction_set          (void) const;
+
+    /**
+     * @brief Number of delimiters found by the last call to scan().
+     * @return The number of '<' and '>' characters in the buffer scanned.
+     */
+
+    int           n_delimiters             (void) const;
+
+    /**
+     * @brief Locate all the delimiters in a buffer.
+     *
+     * @param buffer The buffer to scan.
+     * @param size Number of bytes to scan, starting at buffer[0].
+     *
+     * The positions found replace those of any previous call. These are
+     * valid as long as the contents of the buffer do not change.
+     */
+
+    void          scan                     (const char* buffer,
+                                            int         size);
+
+  protected:
+
+    /// @brief Index returned by the last call to find().
+
+    int           cursor_;
+
+    /// @brief Positions of the delimiters found by scan(). Only the first
+    /// n_delimiters_ are meaningful; the rest is room for the next scan.
+
+    vector<int>   delimiters_;
+
+    /// @brief Instruction set used by scan().
+
+    int           instruction_set_;
+
+    /// @brief Number of delimiters found by scan().
+
+    int           n_delimiters_;
+};
+
+#endif // ASTROLABE_TEXT_SCANNER_HPP
@@ -0,0 +1,508 @@
+/** \file astrolabe_write_behind.cpp
+  \brief Implementation file for astrolabe_write_behind.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "astrolabe_write_behind.hpp"
+
+astrolabe_write_behind::
+astrolabe_write_behind
+(void)
+{
+  {
+    block_             = NULL;
+    bytes_written_     = 0;
+    compression_level_ = 0;
+    error_             = false;
+    file_              = NULL;
+    max_sync_seconds_  = 0;
+    n_syncs_           = 0;
+    request_bytes_     = 0;
+    request_pending_   = false;
+    request_sync_      = false;
+    stop_              = false;
+    sync_interval_     = 0;
+    sync_seconds_      = 0;
+    syncing_           = false;
+    unsynced_          = false;
+    worker_is_running_ = false;
+    write_seconds_     = 0;
+  }
+}
+
+astrolabe_write_behind::
+~astrolabe_write_behind
+(void)
+{
+  {
+    detach();
+  }
+}
+
+void
+astrolabe_write_behind::
+attach
+(FILE* file,
+ int   compression_level)
+{
+  {
+    detach();
+
+    bytes_written_     = 0;
+    compression_level_ = compression_level;
+    file_              = file;
+    last_sync_         = chrono::steady_clock::now();
+    max_sync_seconds_  = 0;
+    n_syncs_           = 0;
+    sync_seconds_      = 0;
+    write_seconds_     = 0;
+  }
+}
+
+int
+astrolabe_write_behind::
+detach
+(void)
+{
+  {
+    unique_lock<mutex> lock(mutex_, defer_lock);
+    bool               failed;
+
+    // Wait for the buffer in progress, if any, and stop the helper thread.
+
+    if (worker_is_running_)
+    {
+      lock.lock();
+
+      while (request_pending_ || syncing_) request_served_.wait(lock);
+
+      stop_ = true;
+      request_posted_.notify_all();
+      lock.unlock();
+
+      worker_.join();
+    }
+
+    failed = error_;
+
+    if (block_ != NULL) delete [] block_;
+
+    block_             = NULL;
+    compression_level_ = 0;
+    error_             = false;
+    file_              = NULL;
+    request_bytes_     = 0;
+    request_pending_   = false;
+    request_sync_      = false;
+    stop_              = false;
+    sync_interval_     = 0;
+    syncing_           = false;
+    unsynced_          = false;
+    worker_is_running_ = false;
+
+    vector<char>().swap(compression_buffer_);
+
+    return failed ? 1 : 0;
+  }
+}
+
+bool
+astrolabe_write_behind::
+error
+(void)
+const
+{
+  {
+    return error_;
+  }
+}
+
+void
+astrolabe_write_behind::
+get_statistics
+(long long& bytes_written,
+ double&    seconds)
+const
+{
+  {
+    bytes_written = bytes_written_;
+    seconds       = write_seconds_;
+  }
+}
+
+void
+astrolabe_write_behind::
+get_sync_statistics
+(long long& n_syncs,
+ double&    seconds,
+ double&    max_seconds)
+const
+{
+  {
+    lock_guard<mutex> lock(mutex_);
+
+    n_syncs     = n_syncs_;
+    seconds     = sync_seconds_;
+    max_seconds = max_sync_seconds_;
+  }
+}
+
+bool
+astrolabe_write_behind::
+is_started
+(void)
+const
+{
+  {
+    return worker_is_running_;
+  }
+}
+
+void
+astrolabe_write_behind::
+set_sync_interval
+(int milliseconds)
+{
+  {
+    lock_guard<mutex> lock(mutex_);
+
+    sync_interval_ = (milliseconds > 0) ? milliseconds : 0;
+  }
+}
+
+int
+astrolabe_write_behind::
+start
+(int block_size)
+{
+  {
+    if (file_ == NULL)      return 1;
+    if (worker_is_running_) return 1;
+    if (block_size <= 0)    return 1;
+
+    request_bytes_   = 0;
+    request_pending_ = false;
+    request_sync_    = false;
+    stop_            = false;
+
+    // Allocate the second buffer and start the helper thread.
+
+    try
+    {
+      block_  = new char[block_size];
+      worker_ = thread(&astrolabe_write_behind::write_behind, this);
+    }
+    catch (...)
+    {
+      if (block_ != NULL) delete [] block_;
+      block_ = NULL;
+      return 2;
+    }
+
+    worker_is_running_ = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+astrolabe_write_behind::
+sync
+(void)
+{
+  {
+    unique_lock<mutex> lock(mutex_);
+    double             seconds;
+
+    if (file_ == NULL) return 1;
+
+    // Wait for the buffer (or the timed sync) in progress, if any.
+
+    while (request_pending_ || syncing_) request_served_.wait(lock);
+
+    if (error_) return 1;
+
+    if (!sync_file(seconds)) error_ = true;
+
+    n_syncs_++;
+    sync_seconds_ += seconds;
+    if (seconds > max_sync_seconds_) max_sync_seconds_ = seconds;
+
+    last_sync_ = chrono::steady_clock::now();
+    unsynced_  = false;
+
+    return error_ ? 1 : 0;
+  }
+}
+
+bool
+astrolabe_write_behind::
+sync_file
+(double& seconds)
+{
+  {
+    chrono::steady_clock::time_point started;
+    int                              status;
+
+    started = chrono::steady_clock::now();
+    status  = astr_fsync(file_);
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    return (status == 0);
+  }
+}
+
+int
+astrolabe_write_behind::
+wait
+(void)
+{
+  {
+    unique_lock<mutex> lock(mutex_);
+
+    if (file_ == NULL) return 1;
+
+    while (request_pending_ || syncing_) request_served_.wait(lock);
+
+    return error_ ? 1 : 0;
+  }
+}
+
+int
+astrolabe_write_behind::
+write
+(char*& data,
+ int    n_bytes,
+ bool   sync)
+{
+  {
+    char*                            full;
+    unique_lock<mutex>               lock(mutex_, defer_lock);
+    double                           seconds;
+    chrono::steady_clock::time_point started;
+
+    if (file_ == NULL)             return 1;
+    if ((n_bytes <= 0) && (!sync)) return 0;
+    if (n_bytes < 0)               n_bytes = 0;
+
+    started = chrono::steady_clock::now();
+
+    // No helper thread: just write the buffer (and sync, if asked to).
+
+    if (!worker_is_running_)
+    {
+      if (n_bytes > 0)
+      {
+        if (!write_file(data, n_bytes)) error_ = true;
+      }
+
+      bytes_written_ += n_bytes;
+      write_seconds_ += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+      lock.lock();
+
+      if (n_bytes > 0) unsynced_ = true;
+
+      if (sync && (!error_))
+      {
+        if (!sync_file(seconds)) error_ = true;
+
+        n_syncs_++;
+        sync_seconds_ += seconds;
+        if (seconds > max_sync_seconds_) max_sync_seconds_ = seconds;
+
+        last_sync_ = chrono::steady_clock::now();
+        unsynced_  = false;
+      }
+
+      return error_ ? 1 : 0;
+    }
+
+    //
+    // Wait for the helper thread to finish the buffer in progress, if any.
+    // Then, block_ is free again.
+    //
+
+    lock.lock();
+
+    while (request_pending_) request_served_.wait(lock);
+
+    if (error_) return 1;
+
+    //
+    // Swap the buffers: the helper thread writes the full one. A sync
+    // alone needs no buffer.
+    //
+
+    if (n_bytes > 0)
+    {
+      full   = data;
+      data   = block_;
+      block_ = full;
+    }
+
+    request_bytes_   = n_bytes;
+    request_pending_ = true;
+    request_sync_    = sync;
+
+    request_posted_.notify_all();
+
+    lock.unlock();
+
+    bytes_written_ += n_bytes;
+    write_seconds_ += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+void
+astrolabe_write_behind::
+write_behind
+(void)
+{
+  {
+    unique_lock<mutex> lock(mutex_);
+    double             seconds;
+    bool               status;
+    bool               synced;
+    bool               timed_out;
+    bool               written;
+
+    while (true)
+    {
+      //
+      // Wait for a request (or for the order to stop). With a sync
+      // interval, and data not synced yet, wait no longer than the moment
+      // the data must be synced.
+      //
+
+      timed_out = false;
+
+      while ((!stop_) && (!request_pending_) && (!timed_out))
+      {
+        if ((sync_interval_ > 0) && unsynced_ && (!error_))
+        {
+          timed_out = (request_posted_.wait_until(lock, last_sync_ + chrono::milliseconds(sync_interval_))
+                       == cv_status::timeout);
+        }
+        else
+        {
+          request_posted_.wait(lock);
+        }
+      }
+
+      if (stop_) break;
+
+      //
+      // The timer fired: sync on our own. write() may post a new buffer
+      // meanwhile (block_ is free), but sync(), wait() and detach() wait
+      // for the sync to finish, since they hand the file over to the
+      // calling thread.
+      //
+
+      if (!request_pending_)
+      {
+        syncing_ = true;
+        lock.unlock();
+
+        status = sync_file(seconds);
+
+        lock.lock();
+        syncing_ = false;
+
+        if (!status) error_ = true;
+
+        n_syncs_++;
+        sync_seconds_ += seconds;
+        if (seconds > max_sync_seconds_) max_sync_seconds_ = seconds;
+
+        last_sync_ = chrono::steady_clock::now();
+        unsynced_  = false;
+
+        request_served_.notify_all();
+        continue;
+      }
+
+      // Write the buffer and sync the file without holding the lock.
+
+      lock.unlock();
+
+      seconds = 0;
+      status  = true;
+      synced  = false;
+      written = false;
+
+      if (request_bytes_ > 0)
+      {
+        status  = write_file(block_, request_bytes_);
+        written = true;
+      }
+
+      if (status && request_sync_)
+      {
+        status = sync_file(seconds);
+        synced = true;
+      }
+
+      lock.lock();
+
+      // Publish the result. Errors are reported by the next write().
+
+      if (!status) error_ = true;
+
+      if (written) unsynced_ = true;
+
+      if (synced)
+      {
+        n_syncs_++;
+        sync_seconds_ += seconds;
+        if (seconds > max_sync_seconds_) max_sync_seconds_ = seconds;
+
+        last_sync_ = chrono::steady_clock::now();
+        unsynced_  = false;
+      }
+
+      request_pending_ = false;
+
+      request_served_.notify_all();
+    }
+  }
+}
+
+bool
+astrolabe_write_behind::
+write_file
+(const char* data,
+ int         n_bytes)
+{
+  {
+    size_t bytes_written;
+
+    // Compressed frames.
+
+    if (compression_level_ != 0)
+    {
+      if (astrolabe_compressed_file::write_frame(file_, data, n_bytes,
+                                                 compression_level_, compression_buffer_) != 0)
+      {
+        return false;
+      }
+
+      fflush(file_);
+      return true;
+    }
+
+    // Plain files.
+
+    bytes_written = fwrite((const void*)data, 1, (size_t)n_bytes, file_);
+    if (bytes_written != (size_t)n_bytes) return false;
+
+    fflush(file_);
+    return true;
+  }
+}
@@ -0,0 +1,372 @@
+/** \file astrolabe_write_behind.hpp
+  \brief Background writing of the data buffers of file writers.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef ASTROLABE_WRITE_BEHIND_HPP
+#define ASTROLABE_WRITE_BEHIND_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "astrolabe_compressed_file.hpp"
+#include "astrolabe_file_utilities.hpp"
+
+using namespace std;
+
+/// @brief Durability policies of file writers (see, for instance,
+/// obs_e_based_file_writer::set_durability()). No syncs at all.
+
+#define _ASTROLABE_DURABILITY_NONE         0
+
+/// @brief Durability policy: sync every N epochs.
+
+#define _ASTROLABE_DURABILITY_EPOCHS       1
+
+/// @brief Durability policy: sync at the first epoch boundary once T
+/// milliseconds have elapsed since the last sync. Besides, the data
+/// already written is synced whenever T milliseconds elapse without a
+/// sync (see astrolabe_write_behind::set_sync_interval()).
+
+#define _ASTROLABE_DURABILITY_MILLISECONDS 2
+
+/// @brief Durability policy: sync only when the file is closed.
+
+#define _ASTROLABE_DURABILITY_CLOSE        3
+
+/**
+ * @brief Background writing of the data buffers of file writers.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * File writers store the records they are given in a data buffer, and
+ * write it to disk (see, for instance, obs_e_based_file_writer::flush())
+ * whenever it gets full. Once attached to a file, this class serves these
+ * requests.
+ *
+ * By default, write() just writes the buffer to the file. After start(),
+ * a helper thread owning a second buffer of the same size does it: write()
+ * hands the full buffer over to the helper thread and gives the writer
+ * the second one back, so the writer goes on storing records while the
+ * first buffer is written. write() only blocks when the previous buffer
+ * is still being written, that is, when the disk is slower than the
+ * application producing the data; at most one buffer is waiting to be
+ * written at any time.
+ *
+ * I/O errors found by the helper thread are reported by the next call to
+ * write() or by detach(), which waits for the buffer in progress. Writers
+ * must detach() the file before closing it.
+ *
+ * Buffers may be written as they are or as compressed frames (see
+ * astrolabe_compressed_file::write_frame()).
+ *
+ * A write() may also ask for the file to be committed to the storage
+ * device (see astr_fsync()) once the buffer is written. When the helper
+ * thread is running, it is the one waiting for the device, so writers
+ * are not blocked by the sync either. The number of syncs and the time
+ * these take are available through get_sync_statistics().
+ *
+ * The helper thread may also sync the file on its own, when a given time
+ * has elapsed since the last sync and some data has been written since
+ * (see set_sync_interval()).
+ */
+
+class astrolabe_write_behind
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                  astrolabe_write_behind   (void);
+
+    /**
+     * @brief Destructor. Stops the helper thread, if any.
+     */
+
+                  ~astrolabe_write_behind  (void);
+
+    /**
+     * @brief Attach a file.
+     *
+     * @param file The file, open for writing in binary mode. It is not
+     *        owned by this object; callers must detach() it before
+     *        closing it.
+     * @param compression_level 0 to write the buffers as they are; 1 to 9
+     *        to write them as compressed frames, with that level.
+     */
+
+    void          attach                   (FILE*        file,
+                                            int          compression_level);
+
+    /**
+     * @brief Wait for the buffer being written, if any, stop the helper
+     *        thread and forget about the file attached.
+     *
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: An I/O error has been found by write() or by the
+     *              helper thread.
+     *
+     * The second buffer (see start()) is released.
+     */
+
+    int           detach                   (void);
+
+    /**
+     * @brief Check if an error has been detected.
+     * @return True if an I/O error has been found, false otherwise.
+     */
+
+    bool          error                    (void) const;
+
+    /**
+     * @brief Retrieve the I/O statistics of the file attached last.
+     *
+     * @param bytes_written Number of bytes passed to write().
+     * @param seconds Time, in seconds, spent in write() (that is, the time
+     *        writers have been blocked waiting for the disk).
+     *
+     * Statistics are reset by attach() but not by detach(), so these
+     * may be retrieved once the file has been closed.
+     */
+
+    void          get_statistics           (long long&   bytes_written,
+                                            double&      seconds) const;
+
+    /**
+     * @brief Retrieve the sync statistics of the file attached last.
+     *
+     * @param n_syncs Number of times the file has been committed to the
+     *        storage device (see write() and sync()).
+     * @param seconds Total time, in seconds, spent in these commits.
+     * @param max_seconds Time, in seconds, taken by the slowest one.
+     *
+     * Statistics are reset by attach() but not by detach(). These may be
+     * retrieved while the helper thread is running.
+     */
+
+    void          get_sync_statistics      (long long&   n_syncs,
+                                            double&      seconds,
+                                            double&      max_seconds) const;
+
+    /**
+     * @brief Check if the helper thread is running.
+     * @return True if start() has been successfully called.
+     */
+
+    bool          is_started               (void) const;
+
+    /**
+     * @brief Start the helper thread.
+     *
+     * @param block_size Size of the data buffer of the writer. The second
+     *        buffer has the same size.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: No file attached, thread already started or invalid size.
+     *         - 2: Not enough memory or unable to start the thread.
+     *
+     * Should start() fail, write() keeps on working, writing the buffers
+     * when called.
+     */
+
+    int           start                    (int          block_size);
+
+    /**
+     * @brief Set the maximum time data written may stay not committed to
+     *        the storage device.
+     *
+     * @param milliseconds The time. Zero (the default) disables the timer.
+     *
+     * Once the helper thread is running (see start()), whenever this time
+     * elapses since the last sync, the data written since then, if any,
+     * is committed to the storage device without waiting for a write()
+     * asking for it; write() does not wait for these syncs either. Only the buffers already passed to write() are
+     * covered; the one in the hands of the writer is not. Without the
+     * helper thread, there's no timer.
+     *
+     * attach() and detach() disable the timer.
+     */
+
+    void          set_sync_interval        (int          milliseconds);
+
+    /**
+     * @brief Wait for the buffer being written, if any, and commit the file
+     *        to the storage device in the calling thread.
+     *
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: No file attached, or an I/O error has been found (now or
+     *              by a previous write()).
+     */
+
+    int           sync                     (void);
+
+    /**
+     * @brief Wait for the buffer being written, if any.
+     *
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: No file attached, or an I/O error has been found (now or
+     *              by a previous write()).
+     *
+     * Once it returns, the file holds every buffer passed to write(), so
+     * it may be handled (for instance, truncated) by the calling thread.
+     */
+
+    int           wait                     (void);
+
+    /**
+     * @brief Write a data buffer.
+     *
+     * @param data The data buffer of the writer. Once the helper thread is
+     *        started, it is replaced by the second buffer, that the writer
+     *        must use from now on. Both buffers are allocated with new[]
+     *        and have the size given to start().
+     * @param n_bytes Number of bytes to write. May be 0 when just asking
+     *        for a sync.
+     * @param sync True to commit the file to the storage device once the
+     *        buffer is written.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: I/O error, either writing this buffer or, in the helper
+     *              thread, a previous one.
+     */
+
+    int           write                    (char*&       data,
+                                            int          n_bytes,
+                                            bool         sync);
+
+  protected:
+
+    /**
+     * @brief Commit the file attached to the storage device.
+     *
+     * @param seconds Time, in seconds, taken by the commit.
+     * @return True if successful, false if an I/O error arises.
+     */
+
+    bool          sync_file                (double&      seconds);
+
+    /**
+     * @brief Body of the helper thread.
+     */
+
+    void          write_behind             (void);
+
+    /**
+     * @brief Write bytes to the file attached.
+     *
+     * @param data The bytes to write.
+     * @param n_bytes Number of bytes to write.
+     * @return True if successful, false if an I/O error arises.
+     */
+
+    bool          write_file               (const char*  data,
+                                            int          n_bytes);
+
+  protected:
+
+    /// @brief The buffer not in the hands of the writer: the one being
+    /// written by the helper thread, or the next one to give to the writer.
+
+    char*                      block_;
+
+    /// @brief Number of bytes passed to write().
+
+    long long                  bytes_written_;
+
+    /// @brief Scratch buffer used to compress frames.
+
+    vector<char>               compression_buffer_;
+
+    /// @brief Compression level (0: buffers are written as they are).
+
+    int                        compression_level_;
+
+    /// @brief Flag. True when an I/O error has been found.
+
+    bool                       error_;
+
+    /// @brief The file attached, if any.
+
+    FILE*                      file_;
+
+    /// @brief When the last sync finished (or the file was attached).
+
+    chrono::steady_clock::time_point last_sync_;
+
+    /// @brief Time, in seconds, taken by the slowest sync.
+
+    double                     max_sync_seconds_;
+
+    /// @brief Mutex protecting the members shared with the helper thread.
+
+    mutable mutex              mutex_;
+
+    /// @brief Number of syncs done.
+
+    long long                  n_syncs_;
+
+    /// @brief Signaled when there's a request or the thread must stop.
+
+    condition_variable         request_posted_;
+
+    /// @brief Signaled when the buffer requested has been written.
+
+    condition_variable         request_served_;
+
+    /// @brief Number of bytes of block_ to write.
+
+    int                        request_bytes_;
+
+    /// @brief Flag. True while the helper thread has a buffer to write.
+
+    bool                       request_pending_;
+
+    /// @brief Flag. True when the file must be synced once block_ is written.
+
+    bool                       request_sync_;
+
+    /// @brief Flag. True when the helper thread must finish.
+
+    bool                       stop_;
+
+    /// @brief Maximum time, in milliseconds, data may stay not synced
+    /// (0: no limit). See set_sync_interval().
+
+    int                        sync_interval_;
+
+    /// @brief Time, in seconds, spent in syncs.
+
+    double                     sync_seconds_;
+
+    /// @brief Flag. True while the helper thread syncs the file on its own
+    /// (see set_sync_interval()).
+
+    bool                       syncing_;
+
+    /// @brief The helper thread.
+
+    thread                     worker_;
+
+    /// @brief Flag. True when data has been written since the last sync.
+
+    bool                       unsynced_;
+
+    /// @brief Flag. True while the helper thread is running.
+
+    bool                       worker_is_running_;
+
+    /// @brief Time, in seconds, spent in write().
+
+    double                     write_seconds_;
+};
+
+#endif // ASTROLABE_WRITE_BEHIND_HPP
@@ -0,0 +1,726 @@
+/** \file epoch_time_index.cpp
+  \brief Implementation file for epoch_time_index.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "epoch_time_index.hpp"
+
+#include <algorithm>
+
+/// @brief Size of the blocks read when scanning text data files.
+
+#define _ASTROLABE_TIME_INDEX_SCAN_BLOCK_SIZE 1048576
+
+/// @brief Maximum size of the opening tag of a text record, plus its time tag.
+
+#define _ASTROLABE_TIME_INDEX_SCAN_LOOKAHEAD 4096
+
+int
+epoch_time_index::
+append
+(double    time,
+ long long offset)
+{
+  {
+    // We must be creating an index file.
+
+    if (file_file_ == NULL) return 1;
+
+    // Write the entry.
+
+    if (fwrite((void*)&time,   sizeof(double),    1, file_file_) != 1) return 2;
+    if (fwrite((void*)&offset, sizeof(long long), 1, file_file_) != 1) return 2;
+
+    file_epochs_++;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+epoch_time_index::
+build
+(const char* data_file_name,
+ bool        is_binary)
+{
+  {
+    FILE*                     data_file;
+    astrolabe_compressed_file data_stream;
+    int                       status;
+
+    // Discard the previous contents of the index.
+
+    offsets_.clear();
+    times_.clear();
+    data_mtime_ = 0;
+    data_size_  = 0;
+
+    //
+    // Get the modification time before scanning, so changes made to the
+    // data file while it is scanned make the index stale.
+    //
+
+    data_mtime_ = astr_fmtime(data_file_name);
+
+    // Open the data file.
+
+    data_file = fopen(data_file_name, "rb");
+    if (data_file == NULL) return 1;
+
+    // Scan it.
+
+    if (is_binary)
+    {
+      status = data_stream.attach(data_file);
+      if (status == 0) status = build_binary(data_stream);
+      else             status = 2;
+
+      data_stream.detach();
+    }
+    else
+    {
+      status = build_text(data_file);
+    }
+
+    fclose(data_file);
+
+    // Don't keep partial indexes.
+
+    if (status != 0)
+    {
+      offsets_.clear();
+      times_.clear();
+      data_mtime_ = 0;
+      data_size_  = 0;
+    }
+
+    // That's all.
+
+    return status;
+  }
+}
+
+int
+epoch_time_index::
+build_binary
+(astrolabe_compressed_file& data_stream)
+{
+  {
+    char      active;
+    int       bytes_to_skip;
+    int       i;
+    int       identifier_length;
+    int       n_items;
+    bool      new_epoch;
+    long long offset;
+    long long record_offset;
+    double    time;
+    char      type;
+
+    //
+    // Walk the records in the file. Epochs are delimited by backtracking
+    // (b) records, so the first record after each of these (or the first
+    // one in the file) starts a new epoch.
+    //
+
+    offset    = 0;
+    new_epoch = true;
+
+    while (true)
+    {
+      record_offset = offset;
+
+      // Record type. Running out of data here is the normal end of file.
+
+      if (data_stream.read((void*)&type, sizeof(char)) != sizeof(char))
+      {
+        if (data_stream.error()) return 2;
+        break;
+      }
+
+      offset += sizeof(char);
+
+      // Backtracking records: skip the byte count; a new epoch follows.
+
+      if ((type == 'b') || (type == 'B'))
+      {
+        if (data_stream.seek(offset + sizeof(int)) != 0) return 2;
+
+        offset    += sizeof(int);
+        new_epoch  = true;
+        continue;
+      }
+
+      if ((type != 'l') && (type != 'o')) return 2;
+
+      // Active flag and identifier.
+
+      if (data_stream.read((void*)&active,            sizeof(char)) != sizeof(char)) return 2;
+      if (data_stream.read((void*)&identifier_length, sizeof(int))  != sizeof(int))  return 2;
+      if (identifier_length < 1) return 2;
+
+      //
+      // Skip the identifier and, in l-records, the instance identifier
+      // too, to reach the time tag.
+      //
+
+      bytes_to_skip = identifier_length;
+      if (type == 'l') bytes_to_skip += sizeof(int);
+
+      offset += sizeof(char) + sizeof(int) + bytes_to_skip;
+
+      if (data_stream.seek(offset) != 0) return 2;
+
+      // Time tag.
+
+      if (data_stream.read((void*)&time, sizeof(double)) != sizeof(double)) return 2;
+      offset += sizeof(double);
+
+      if (new_epoch)
+      {
+        times_.push_back(time);
+        offsets_.push_back(record_offset);
+        new_epoch = false;
+      }
+
+      //
+      // Skip the rest of the record: three counters, each followed by
+      // the corresponding array (doubles in l-records, ints in o-records).
+      //
+
+      for (i = 0; i < 3; i++)
+      {
+        if (data_stream.read((void*)&n_items, sizeof(int)) != sizeof(int)) return 2;
+        if (n_items < 0) return 2;
+
+        offset += sizeof(int);
+
+        if (type == 'l') n_items = n_items * (int)sizeof(double);
+        else             n_items = n_items * (int)sizeof(int);
+
+        if (n_items > 0)
+        {
+          offset += n_items;
+          if (data_stream.seek(offset) != 0) return 2;
+        }
+      }
+    }
+
+    data_size_ = offset;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+epoch_time_index::
+build_text
+(FILE* data_file)
+{
+  {
+    bool        active;
+    long long   base_offset;
+    char*       buffer;
+    int         buffer_bytes;
+    size_t      bytes_read;
+    int         cur;
+    bool        end_of_file;
+    bool        first_epoch;
+    int         i;
+    int         j;
+    double      last_time;
+    const char* number_end;
+    int         status;
+    int         tag_end;
+    double      time;
+
+    buffer = new char[_ASTROLABE_TIME_INDEX_SCAN_BLOCK_SIZE];
+
+    base_offset  = 0;    // Offset in the file of buffer[0].
+    buffer_bytes = 0;
+    cur          = 0;
+    end_of_file  = false;
+    first_epoch  = true;
+    last_time    = 0.0;
+    status       = 0;
+
+    while (true)
+    {
+      //
+      // Make sure that a whole opening tag plus its time tag fits in the
+      // buffer before looking at the next character; otherwise, move the
+      // remaining bytes up and load more data.
+      //
+
+      if (((buffer_bytes - cur) < _ASTROLABE_TIME_INDEX_SCAN_LOOKAHEAD) && (!end_of_file))
+      {
+        memmove((void*)buffer, (void*)&(buffer[cur]), (size_t)(buffer_bytes - cur));
+
+        base_offset  += cur;
+        buffer_bytes -= cur;
+        cur           = 0;
+
+        bytes_read = fread((void*)&(buffer[buffer_bytes]), 1,
+                           (size_t)(_ASTROLABE_TIME_INDEX_SCAN_BLOCK_SIZE - buffer_bytes), data_file);
+
+        if (bytes_read == 0)
+        {
+          if (ferror(data_file))
+          {
+            status = 2;
+            break;
+          }
+          end_of_file = true;
+        }
+
+        buffer_bytes += (int)bytes_read;
+      }
+
+      if (cur >= buffer_bytes) break;
+
+      // Look for opening l- or o- tags only.
+
+      if ((buffer[cur] != '<') || ((cur + 1) >= buffer_bytes))
+      {
+        cur++;
+        continue;
+      }
+
+      if ((buffer[cur + 1] != 'l') && (buffer[cur + 1] != 'o'))
+      {
+        cur++;
+        continue;
+      }
+
+      // Find the end of the opening tag.
+
+      tag_end = cur + 2;
+      while ((tag_end < buffer_bytes) && (buffer[tag_end] != '>')) tag_end++;
+
+      if (tag_end >= buffer_bytes)
+      {
+        status = 2;
+        break;
+      }
+
+      //
+      // Records are active unless the s attribute says otherwise (s="r").
+      // Look for an "s" attribute name followed by '=' and its quoted value.
+      //
+
+      active = true;
+
+      for (i = cur + 2; i < tag_end; i++)
+      {
+        if ((buffer[i] != 's') || ((buffer[i - 1] != ' ') && (buffer[i - 1] != '\t') &&
+                                   (buffer[i - 1] != '\n') && (buffer[i - 1] != '\r')))
+          continue;
+
+        j = i + 1;
+        while ((j < tag_end) && ((buffer[j] == ' ') || (buffer[j] == '\t'))) j++;
+        if ((j >= tag_end) || (buffer[j] != '=')) continue;
+        j++;
+        while ((j < tag_end) && ((buffer[j] == ' ') || (buffer[j] == '\t'))) j++;
+        if ((j >= tag_end) || (buffer[j] != '"')) continue;
+        j++;
+
+        if ((j < tag_end) && (buffer[j] == 'r')) active = false;
+        break;
+      }
+
+      // The time tag is the first value after the opening tag.
+
+      i = tag_end + 1;
+      while ((i < buffer_bytes) && ((buffer[i] == ' ')  || (buffer[i] == '\t') ||
+                                    (buffer[i] == '\n') || (buffer[i] == '\r'))) i++;
+
+      if ((astr_parse_double(&(buffer[i]), &(buffer[buffer_bytes]), time, &number_end) != 0) ||
+          ((number_end < &(buffer[buffer_bytes])) && (strchr("0123456789+-.eE", *number_end) != NULL) &&
+           (*number_end != '\0')))
+      {
+        status = 2;
+        break;
+      }
+
+      //
+      // As readers do, only active records may change the epoch.
+      //
+
+      if (active && (first_epoch || (time != last_time)))
+      {
+        times_.push_back(time);
+        offsets_.push_back(base_offset + cur);
+
+        last_time   = time;
+        first_epoch = false;
+      }
+
+      cur = tag_end + 1;
+    }
+
+    data_size_ = base_offset + buffer_bytes;
+
+    delete [] buffer;
+
+    // That's all.
+
+    return status;
+  }
+}
+
+int
+epoch_time_index::
+create
+(const char* index_file_name)
+{
+  {
+    // Only one index file at a time.
+
+    if (file_file_ != NULL) return 1;
+
+    file_file_ = fopen(index_file_name, "wb");
+    if (file_file_ == NULL) return 2;
+
+    // Provisional header, stating that the index is empty.
+
+    file_epochs_ = 0;
+
+    if (write_header(file_file_, 0, 0, 0) != 0)
+    {
+      fclose(file_file_);
+      file_file_ = NULL;
+      return 2;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+epoch_time_index::
+epoch_time_index
+(void)
+{
+  {
+    data_mtime_  = 0;
+    data_size_   = 0;
+    file_epochs_ = 0;
+    file_file_   = NULL;
+  }
+}
+
+epoch_time_index::
+~epoch_time_index
+(void)
+{
+  {
+    if (file_file_ != NULL) fclose(file_file_);
+    file_file_ = NULL;
+  }
+}
+
+int
+epoch_time_index::
+find_epoch_after
+(double time,
+ int&   position)
+const
+{
+  {
+    vector<double>::const_iterator found;
+
+    found = lower_bound(times_.begin(), times_.end(), time);
+
+    if (found == times_.end()) return 1;
+
+    position = (int)(found - times_.begin());
+
+    return 0;
+  }
+}
+
+int
+epoch_time_index::
+find_epoch_before
+(double time,
+ int&   position)
+const
+{
+  {
+    vector<double>::const_iterator found;
+
+    found = upper_bound(times_.begin(), times_.end(), time);
+
+    if (found == times_.begin()) return 1;
+
+    position = (int)(found - times_.begin()) - 1;
+
+    return 0;
+  }
+}
+
+int
+epoch_time_index::
+finish
+(long long data_size,
+ long long data_mtime)
+{
+  {
+    int status;
+
+    // We must be creating an index file.
+
+    if (file_file_ == NULL) return 1;
+
+    // Complete the header with the final figures.
+
+    status = 0;
+
+    if (fseek(file_file_, 0, SEEK_SET) != 0)                   status = 2;
+    if (status == 0) status = write_header(file_file_, data_size, data_mtime, file_epochs_);
+
+    if (fclose(file_file_) != 0)                               status = 2;
+
+    file_file_ = NULL;
+
+    // That's all.
+
+    return status;
+  }
+}
+
+long long
+epoch_time_index::
+get_data_size
+(void)
+const
+{
+  {
+    return data_size_;
+  }
+}
+
+long long
+epoch_time_index::
+get_end_offset
+(int position)
+const
+{
+  {
+    if ((position + 1) < (int)offsets_.size()) return offsets_[position + 1];
+    return data_size_;
+  }
+}
+
+string
+epoch_time_index::
+get_index_file_name
+(const string& data_file_name)
+const
+{
+  {
+    return data_file_name + _ASTROLABE_TIME_INDEX_EXTENSION;
+  }
+}
+
+int
+epoch_time_index::
+get_number_of_epochs
+(void)
+const
+{
+  {
+    return (int)times_.size();
+  }
+}
+
+long long
+epoch_time_index::
+get_offset
+(int position)
+const
+{
+  {
+    return offsets_[position];
+  }
+}
+
+double
+epoch_time_index::
+get_time
+(int position)
+const
+{
+  {
+    return times_[position];
+  }
+}
+
+int
+epoch_time_index::
+load
+(const char* index_file_name,
+ long long   data_size,
+ long long   data_mtime)
+{
+  {
+    long long file_data_mtime;
+    long long file_data_size;
+    long long i;
+    FILE*     index_file;
+    long long n_epochs;
+    long long offset;
+    int       reserved;
+    char      signature[8];
+    int       status;
+    double    time;
+    int       version;
+
+    // Discard the previous contents of the index.
+
+    offsets_.clear();
+    times_.clear();
+    data_mtime_ = 0;
+    data_size_  = 0;
+
+    // Open the index file.
+
+    index_file = fopen(index_file_name, "rb");
+    if (index_file == NULL) return 1;
+
+    // Read and check the header.
+
+    status = 0;
+
+    if ((fread((void*)signature,        sizeof(char),      8, index_file) != 8) ||
+        (fread((void*)&version,         sizeof(int),       1, index_file) != 1) ||
+        (fread((void*)&reserved,        sizeof(int),       1, index_file) != 1) ||
+        (fread((void*)&file_data_size,  sizeof(long long), 1, index_file) != 1) ||
+        (fread((void*)&file_data_mtime, sizeof(long long), 1, index_file) != 1) ||
+        (fread((void*)&n_epochs,        sizeof(long long), 1, index_file) != 1))
+    {
+      status = 2;
+    }
+    else if (strncmp(signature, _ASTROLABE_TIME_INDEX_SIGNATURE, 8) != 0)
+    {
+      status = 2;
+    }
+    else if ((version != _ASTROLABE_TIME_INDEX_VERSION) || (n_epochs < 0))
+    {
+      status = 2;
+    }
+    else if ((data_size >= 0) && (file_data_size != data_size))
+    {
+      status = 3;
+    }
+    else if ((data_mtime >= 0) && (file_data_mtime != data_mtime))
+    {
+      status = 3;
+    }
+
+    // Read the entries.
+
+    if (status == 0)
+    {
+      times_.reserve((size_t)n_epochs);
+      offsets_.reserve((size_t)n_epochs);
+
+      for (i = 0; i < n_epochs; i++)
+      {
+        if ((fread((void*)&time,   sizeof(double),    1, index_file) != 1) ||
+            (fread((void*)&offset, sizeof(long long), 1, index_file) != 1))
+        {
+          status = 2;
+          break;
+        }
+
+        times_.push_back(time);
+        offsets_.push_back(offset);
+      }
+    }
+
+    fclose(index_file);
+
+    // Don't keep partial indexes.
+
+    if (status != 0)
+    {
+      offsets_.clear();
+      times_.clear();
+      return status;
+    }
+
+    data_mtime_ = file_data_mtime;
+    data_size_  = file_data_size;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+epoch_time_index::
+save
+(const char* index_file_name)
+{
+  {
+    FILE*  index_file;
+    size_t i;
+    int    status;
+
+    index_file = fopen(index_file_name, "wb");
+    if (index_file == NULL) return 1;
+
+    status = write_header(index_file, data_size_, data_mtime_, (long long)times_.size());
+
+    for (i = 0; (status == 0) && (i < times_.size()); i++)
+    {
+      if ((fwrite((void*)&(times_[i]),   sizeof(double),    1, index_file) != 1) ||
+          (fwrite((void*)&(offsets_[i]), sizeof(long long), 1, index_file) != 1))
+        status = 2;
+    }
+
+    if (fclose(index_file) != 0) status = 2;
+
+    // Don't leave broken index files behind.
+
+    if (status != 0) remove(index_file_name);
+
+    // That's all.
+
+    return status;
+  }
+}
+
+int
+epoch_time_index::
+write_header
+(FILE*     index_file,
+ long long data_size,
+ long long data_mtime,
+ long long n_epochs)
+{
+  {
+    int reserved;
+    int version;
+
+    reserved = 0;
+    version  = _ASTROLABE_TIME_INDEX_VERSION;
+
+    if ((fwrite((void*)_ASTROLABE_TIME_INDEX_SIGNATURE, sizeof(char),   8, index_file) != 8) ||
+        (fwrite((void*)&version,                    sizeof(int),       1, index_file) != 1) ||
+        (fwrite((void*)&reserved,                   sizeof(int),       1, index_file) != 1) ||
+        (fwrite((void*)&data_size,                  sizeof(long long), 1, index_file) != 1) ||
+        (fwrite((void*)&data_mtime,                 sizeof(long long), 1, index_file) != 1) ||
+        (fwrite((void*)&n_epochs,                   sizeof(long long), 1, index_file) != 1))
+      return 2;
+
+    return 0;
+  }
+}
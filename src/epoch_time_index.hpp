@@ -0,0 +1,333 @@
+/** \file epoch_time_index.hpp
+  \brief Epoch time to byte offset index for obs-e based files.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef EPOCH_TIME_INDEX_HPP
+#define EPOCH_TIME_INDEX_HPP
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "astrolabe_compressed_file.hpp"
+#include "astrolabe_file_utilities.hpp"
+#include "astrolabe_number_parser.hpp"
+
+using namespace std;
+
+/// @brief Extension appended to the name of a data file to build the name
+/// of its index (sidecar) file.
+
+#define _ASTROLABE_TIME_INDEX_EXTENSION ".idx"
+
+/// @brief Signature stored at the beginning of every index file (8 chars).
+
+#define _ASTROLABE_TIME_INDEX_SIGNATURE "ASTLBIDX"
+
+/// @brief Version of the index file layout.
+
+#define _ASTROLABE_TIME_INDEX_VERSION 2
+
+/**
+ * @brief Epoch time to byte offset index for obs-e based files.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * An epoch time index stores, for every epoch in an obs-e based data file
+ * (binary or text), its time tag and the byte offset where its first
+ * record starts. Since time tags grow monotonically in ASTROLABE files, the
+ * index makes it possible to locate any epoch with a binary search, instead
+ * of reading the data file from its beginning.
+ *
+ * Indexes are kept in small sidecar files, whose names are those of the
+ * data files plus the _ASTROLABE_TIME_INDEX_EXTENSION extension (see
+ * get_index_file_name()). The layout of these files is:
+ *
+ * - A header, made of the signature (8 chars, _ASTROLABE_TIME_INDEX_SIGNATURE),
+ *   the version (int), a reserved field (int), the size in bytes of the
+ *   data file indexed (long long), its modification time (long long, see
+ *   astr_fmtime()) and the number of epochs (long long).
+ * - One entry per epoch, made of its time tag (double) and offset (long long).
+ *
+ * Values are stored using the native representation, as in binary
+ * ASTROLABE files.
+ *
+ * For block-compressed binary files (see astrolabe_compressed_file), both
+ * offsets and the size of the data file refer to the uncompressed data.
+ *
+ * This class may be used in two different ways:
+ *
+ * - Writers create index files incrementally, as epochs are written,
+ *   using create(), append() and finish(). Entries are written straight
+ *   to disk, so no memory is used to keep them.
+ * - Readers get the index in memory, either calling load() (when the
+ *   sidecar file exists) or building it from the data file itself using
+ *   build(). Index files built this way may be stored calling save().
+ *   Once the index is available, find_epoch_after() and find_epoch_before()
+ *   locate epochs in O(log n).
+ *
+ * The size and the modification time of the data file are stored in the
+ * header; load() uses them to detect stale indexes (those not matching the
+ * current data file). Checking the size alone is not enough: a data file
+ * rewritten with different contents may well keep its size.
+ */
+
+class epoch_time_index
+{
+  public:
+
+    /**
+     * @brief Append a new epoch to an index file being created.
+     *
+     * @param time The time tag of the epoch.
+     * @param offset Offset in bytes, from the beginning of the data file,
+     *        of the first record in the epoch.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: No index file is being created (see create()).
+     *         - 2: I/O error.
+     */
+
+    int       append              (double time, long long offset);
+
+    /**
+     * @brief Build the index scanning a data file.
+     *
+     * @param data_file_name The name of the data file to index.
+     * @param is_binary True if the data file is a binary one, false
+     *        if it is a text one.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: Unable to open the data file.
+     *         - 2: I/O error or malformed data file.
+     *
+     * Any previous contents of the index are discarded.
+     *
+     * In text files, as readers do, epochs change only when an active
+     * record shows a new time tag.
+     */
+
+    int       build               (const char* data_file_name, bool is_binary);
+
+    /**
+     * @brief Start the creation of an index file.
+     *
+     * @param index_file_name The name of the index file to create.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: An index file is already being created.
+     *         - 2: Unable to create the index file.
+     *
+     * A provisional header is written; it will be completed by finish().
+     */
+
+    int       create              (const char* index_file_name);
+
+    /**
+     * @brief Constructor.
+     */
+
+              epoch_time_index    (void);
+
+    /**
+     * @brief Destructor.
+     *
+     * If an index file is being created and finish() has not been called,
+     * the file is closed as is; its header will state that it is empty.
+     */
+
+              ~epoch_time_index   (void);
+
+    /**
+     * @brief Find the first epoch whose time tag is greater or equal than
+     *        a given time.
+     *
+     * @param time The time to look for.
+     * @param position On output, the position of the epoch in the index.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: All the epochs in the index are older than time.
+     */
+
+    int       find_epoch_after    (double time, int& position) const;
+
+    /**
+     * @brief Find the last epoch whose time tag is lesser or equal than
+     *        a given time.
+     *
+     * @param time The time to look for.
+     * @param position On output, the position of the epoch in the index.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: All the epochs in the index are newer than time.
+     */
+
+    int       find_epoch_before   (double time, int& position) const;
+
+    /**
+     * @brief Complete the creation of an index file.
+     *
+     * @param data_size Final size in bytes of the indexed data file.
+     * @param data_mtime Modification time of the indexed data file, once
+     *        closed (see astr_fmtime()).
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: No index file is being created (see create()).
+     *         - 2: I/O error.
+     */
+
+    int       finish              (long long data_size, long long data_mtime);
+
+    /**
+     * @brief Retrieve the size in bytes of the indexed data file.
+     *
+     * @return The size in bytes of the data file.
+     */
+
+    long long get_data_size       (void) const;
+
+    /**
+     * @brief Retrieve the offset of the byte immediately following
+     *        the last one of an epoch.
+     *
+     * @param position The position of the epoch in the index.
+     * @return The offset of the first record of the next epoch or, for
+     *         the last epoch, the size of the data file.
+     *
+     * Backward readers need this value, since they read epochs from
+     * their end.
+     */
+
+    long long get_end_offset      (int position) const;
+
+    /**
+     * @brief Build the name of the index file for a given data file.
+     *
+     * @param data_file_name The name of the data file.
+     * @return The name of its index file.
+     */
+
+    string    get_index_file_name (const string& data_file_name) const;
+
+    /**
+     * @brief Retrieve the number of epochs in the index.
+     *
+     * @return The number of epochs in the index.
+     */
+
+    int       get_number_of_epochs(void) const;
+
+    /**
+     * @brief Retrieve the offset of the first record in an epoch.
+     *
+     * @param position The position of the epoch in the index.
+     * @return The offset in bytes of the first record of the epoch.
+     */
+
+    long long get_offset          (int position) const;
+
+    /**
+     * @brief Retrieve the time tag of an epoch.
+     *
+     * @param position The position of the epoch in the index.
+     * @return The time tag of the epoch.
+     */
+
+    double    get_time            (int position) const;
+
+    /**
+     * @brief Load an index file.
+     *
+     * @param index_file_name The name of the index file to load.
+     * @param data_size Current size in bytes of the data file the index
+     *        refers to. Use a negative value to skip this check.
+     * @param data_mtime Current modification time of the data file the
+     *        index refers to (see astr_fmtime()). Use a negative value to
+     *        skip this check.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: Unable to open the index file.
+     *         - 2: Invalid index file (bad signature, version, size...).
+     *         - 3: Stale index file; it does not match the data file.
+     *
+     * Any previous contents of the index are discarded.
+     */
+
+    int       load                (const char* index_file_name, long long data_size, long long data_mtime);
+
+    /**
+     * @brief Save the index to an index file.
+     *
+     * @param index_file_name The name of the index file to write.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: Unable to create the index file.
+     *         - 2: I/O error.
+     */
+
+    int       save                (const char* index_file_name);
+
+  protected:
+
+    /**
+     * @brief Build the index for a binary data file.
+     *
+     * @param data_stream The data file, already open (and attached to
+     *        the stream), plain or block-compressed.
+     * @return Error code (see build()).
+     */
+
+    int       build_binary        (astrolabe_compressed_file& data_stream);
+
+    /**
+     * @brief Build the index for a text data file.
+     *
+     * @param data_file The data file, already open.
+     * @return Error code (see build()).
+     */
+
+    int       build_text          (FILE* data_file);
+
+    /**
+     * @brief Write the header of an index file.
+     *
+     * @param index_file The index file, positioned at its beginning.
+     * @param data_size The size in bytes of the indexed data file.
+     * @param data_mtime The modification time of the indexed data file.
+     * @param n_epochs The number of epochs in the index.
+     * @return Error code. 0 if successful, 2 if an I/O error arises.
+     */
+
+    int       write_header        (FILE* index_file, long long data_size, long long data_mtime, long long n_epochs);
+
+  protected:
+
+    /// @brief Modification time of the data file indexed.
+
+    long long         data_mtime_;
+
+    /// @brief Size in bytes of the data file indexed.
+
+    long long         data_size_;
+
+    /// @brief Number of entries written to the index file being created.
+
+    long long         file_epochs_;
+
+    /// @brief The index file being created, if any.
+
+    FILE*             file_file_;
+
+    /// @brief Offsets of the epochs in the index.
+
+    vector<long long> offsets_;
+
+    /// @brief Time tags of the epochs in the index.
+
+    vector<double>    times_;
+};
+
+#endif // EPOCH_TIME_INDEX_HPP
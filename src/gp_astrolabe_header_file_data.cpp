@@ -9,10 +9,11 @@
 // Statit constants
 //
 
-const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_NOT_SET     = 0;
-const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE   = 1;
-const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE = 2;
-const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_SOCKET      = 3;
+const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_NOT_SET       = 0;
+const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE     = 1;
+const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE   = 2;
+const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_SOCKET        = 3;
+const int gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE = 4;
 
 string
 gp_astrolabe_header_file_data::
@@ -20,7 +21,8 @@ get_device_file_name
 (void)
 const
 {
-  set_precondition ((get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE) |
+  set_precondition ((get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE)   |
+                    (get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE) |
                     (get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE));
 
   set_precondition (is_set_device_file_name());
@@ -178,7 +180,8 @@ gp_astrolabe_header_file_data::
 set_device_file_name
 (string& device_file_name)
 {
-  set_precondition ((get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE) |
+  set_precondition ((get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE)   |
+                    (get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE) |
                     (get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE));
   {
     file_name_is_set_ = true;
@@ -191,8 +194,9 @@ gp_astrolabe_header_file_data::
 set_device_format
 (int device_format)
 {
-  set_precondition ((device_format == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE) |
-                    (device_format == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE) |
+  set_precondition ((device_format == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE)   |
+                    (device_format == GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE) |
+                    (device_format == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE)     |
                     (device_format == GP_ASTROLABE_HEADER_FORMAT_IS_SOCKET));
 
   set_precondition (!is_set_device_format());
@@ -21,6 +21,11 @@ class gp_astrolabe_header_file_data
 
     const static int GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE;
 
+    /// \brief Public constant: the device used to keep data is
+    /// a columnar binary file.
+
+    const static int GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE;
+
     /// \brief Public constant: the device used to keep data is
     /// not set.
 
@@ -40,7 +45,8 @@ class gp_astrolabe_header_file_data
 
     /// \brief Get the device file name used to store data.
     /**
-      \pre ((get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE) |
+      \pre ((get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE)   |
+            (get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE) |
             (get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE))
       \pre (is_set_device_file_name())
       \return The name of the file used to store data when the device
@@ -51,7 +57,8 @@ class gp_astrolabe_header_file_data
       Note that a device file name is only meaningful when
 
       - a file is used as the storage device (that is,
-        get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE or
+        get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE,
+        get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE or
         get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE and
       - the file name has been previously set.
 
@@ -68,6 +75,8 @@ class gp_astrolabe_header_file_data
 
       - GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE - Data is stored in a
         binary file.
+      - GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE - Data is stored in a
+        columnar binary file (see observation_file_writer_col).
       - GP_ASTROLABE_HEADER_FORMAT_IS_SOCKET - Data must be handled using
         a TCP/IP socket.
       - GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE - Data is stored in a
@@ -205,7 +214,8 @@ class gp_astrolabe_header_file_data
     /// \brief Set the device file name used to store data when
     /// files are used to do it.
     /**
-      \pre ((get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE) |
+      \pre ((get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE)   |
+            (get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE) |
             (get_device_format()  == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE))
       \param device_file_name The name of the file used to store data when
              the device used to do so is a file.
@@ -215,7 +225,8 @@ class gp_astrolabe_header_file_data
       Note that a device file name may be set only when
 
       - a file is used as the external storage device (that is,
-        - get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE or
+        - get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE,
+        - get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE or
         - get_device_format() == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE) and
       - the file name has not been previously set.
 
@@ -227,6 +238,7 @@ class gp_astrolabe_header_file_data
     /// \brief Set the device format used to store data.
     /**
       \pre ((device_type == GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE)   |
+            (device_type == GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE) |
             (device_type == GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE)     |
             (device_type == GP_ASTROLABE_HEADER_FORMAT_IS_SOCKET))
       \pre (!is_set_device_format())
@@ -239,6 +251,8 @@ class gp_astrolabe_header_file_data
 
       - GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE - Data is stored in a
         binary file.
+      - GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE - Data is stored in a
+        columnar binary file.
       - GP_ASTROLABE_HEADER_FORMAT_IS_SOCKET_CLIENT - Data is handled using
         a TCP/IP socket.
       - GP_ASTROLABE_HEADER_FORMAT_IS_TEXT_FILE - Data is stored in a
@@ -265,6 +265,19 @@ parse
 
         header_data_->set_device_file_name(sdata2);
       }
+      else if (sattr == "COLUMNAR_FILE")
+      {
+        // Set the device type to columnar binary file.
+
+        header_data_->set_device_format(gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE);
+
+        // Get the attached file name.
+
+        sdata = dp->_label_value_string();
+        sdata2 = gpu.string_whitespace_simplify(sdata);
+
+        header_data_->set_device_file_name(sdata2);
+      }
       else if (sattr == "SOCKET")
       {
         // Set the device type to socket.
@@ -646,6 +659,27 @@ validate_semantics
       }
     }
 
+    //
+    // Columnar files are only available for observation (obs-e) files.
+    //
+
+    if (header_data_->get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE)
+    {
+      if (header_data_->get_device_type() != "OBS-E_FILE")
+      {
+        // Columnar r-matrix files do not exist.
+
+        error_tag = "<astrolabe-header_file><data><device>";
+
+        error_description.clear();
+        error_description.push_back("The columnar_file format may only be used with obs-e_file devices.");
+
+        error_message = gpu.build_message(2, file_name_header_, error_tag, error_description);
+
+        list_of_errors_.push_back(error_message);
+      }
+    }
+
 
     //
     //  -------------------------------------------------------------------
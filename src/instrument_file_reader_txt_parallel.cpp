@@ -0,0 +1,25 @@
+/** \file instrument_file_reader_txt_parallel.cpp
+  \brief Implementation file for instrument_file_reader_txt_parallel.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+#include "instrument_file_reader_txt_parallel.hpp"
+
+instrument_file_reader_txt_parallel::
+instrument_file_reader_txt_parallel
+(void)
+{
+  {
+    // Instrument files hold l-records only.
+
+    o_records_allowed_ = false;
+  }
+}
+
+instrument_file_reader_txt_parallel::
+~instrument_file_reader_txt_parallel
+(void)
+{
+  {
+    // INTENTIONALLY LEFT BLANK.
+  }
+}
@@ -0,0 +1,42 @@
+/** \file instrument_file_reader_txt_parallel.hpp
+  \brief Class defining the interface of multithreaded text instrument file readers.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef INSTRUMENT_FILE_READER_TXT_PARALLEL_HPP
+#define INSTRUMENT_FILE_READER_TXT_PARALLEL_HPP
+
+#include "obs_e_based_file_reader_txt_parallel.hpp"
+
+/**
+ * @brief Class defining the interface of multithreaded text instrument file readers.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * This class implements the interface defined in parent class
+ * obs_e_based_file_reader_txt_parallel, reading instrument files stored in
+ * text format in forward direction, as instrument_file_reader_txt_forward
+ * does, but parsing the file with a pool of worker threads.
+ *
+ * Instrument files hold l-records only; o-records are reported as
+ * malformed records.
+ */
+
+class instrument_file_reader_txt_parallel : public obs_e_based_file_reader_txt_parallel
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                 instrument_file_reader_txt_parallel  (void);
+
+    /**
+     * @brief Destructor.
+     */
+
+                 ~instrument_file_reader_txt_parallel (void);
+};
+
+#endif // INSTRUMENT_FILE_READER_TXT_PARALLEL_HPP
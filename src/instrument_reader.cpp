@@ -82,6 +82,7 @@ instrument_reader
 
     socket_reader_               = NULL;
     socket_works_in_server_mode_ = true;
+    text_threads_                = 1;
   }
 }
 
@@ -258,6 +259,33 @@ const
   }
 }
 
+obs_e_based_file_reader*
+instrument_reader::
+new_file_reader
+(void)
+{
+  obs_e_based_file_reader* reader;
+
+  {
+    instrument_file_reader_txt_parallel* txt_parallel_reader;
+
+    if (text_threads_ != 1)
+    {
+      // Forward, multithreaded text file reader.
+      txt_parallel_reader = new instrument_file_reader_txt_parallel();
+      txt_parallel_reader->set_number_of_threads(text_threads_);
+      reader = txt_parallel_reader;
+    }
+    else
+    {
+      // Forward, text file reader.
+      reader = new instrument_file_reader_txt_forward();
+    }
+  }
+
+  return reader;
+}
+
 int
 instrument_reader::
 open
@@ -360,7 +388,7 @@ open
       // Instantiate the file reader.
       //
 
-      file_reader_ = new instrument_file_reader_txt_forward();
+      file_reader_ = new_file_reader();
 
       //
       // We may now try to open the actual underlying file using
@@ -461,6 +489,36 @@ read_l_data
   }
 }
 
+int
+instrument_reader::
+read_l_data_view
+(int                    n_tag_values,
+ astrolabe_double_view& the_tags,
+ int                    n_expectation_values,
+ astrolabe_double_view& the_expectations,
+ int&                   n_covariance_values_found,
+ astrolabe_double_view& the_covariance_values)
+{
+  {
+    if (data_channel_is_socket_)
+    {
+      // Sockets.
+
+      return socket_reader_->read_l_data_view(n_tag_values,              the_tags,
+                                              n_expectation_values,      the_expectations,
+                                              n_covariance_values_found, the_covariance_values);
+    }
+    else
+    {
+      // Files.
+
+      return file_reader_->read_l_data_view(n_tag_values,              the_tags,
+                                            n_expectation_values,      the_expectations,
+                                            n_covariance_values_found, the_covariance_values);
+    }
+  }
+}
+
 int
 instrument_reader::
 read_instance_id
@@ -593,7 +651,7 @@ read_type
         // Instantiate the file reader.
         //
 
-        file_reader_ = new instrument_file_reader_txt_forward();
+        file_reader_ = new_file_reader();
 
         //
         // Open the new chunk. If this fails, we'll return an
@@ -696,6 +754,26 @@ set_header_file
   }
 }
 
+int
+instrument_reader::
+set_number_of_threads
+(int n_threads)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (n_threads < 0) return 2;
+
+    text_threads_ = n_threads;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 instrument_reader::
 set_schema_file
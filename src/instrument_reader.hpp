@@ -8,6 +8,7 @@
 
 #include "instrument_socket_reader.hpp"
 #include "instrument_file_reader_txt_forward.hpp"
+#include "instrument_file_reader_txt_parallel.hpp"
 
 #include "gp_utils.hpp"
 #include "gp_astrolabe_header_file_parser.hpp"
@@ -411,6 +412,44 @@ class instrument_reader
                                                     int&     n_covariance_values_found,
                                                     double*& the_covariance_values);
 
+    /**
+     * @brief Read the tags, expectations and covariance matrix values
+     *        in an l-record as read-only views, with no copies into
+     *        caller-provided arrays.
+     *
+     * @param n_tag_values Number of tag values that must be read from
+     *        the l-record. May be zero, since tags are optional.
+     * @param the_tags On output, view of the n_tag_values tags.
+     * @param n_expectation_values Number of expectation values that must be
+     *        read from the l-record. Must be greater than 0.
+     * @param the_expectations On output, view of the n_expectation_values
+     *        expectations.
+     * @param n_covariance_values_found Actual number of covariance matrix
+     *        values found in the l-record (0, n or (n * (n + 1))/2).
+     * @param the_covariance_values On output, view of the
+     *        n_covariance_values_found covariance matrix values.
+     * @return Error code. The same ones returned by read_l_data().
+     *
+     * This method may replace read_l_data() at exactly the same point
+     * of the reading sequence. The views point to memory owned by the
+     * reader and remain valid ONLY until the next call to read_type();
+     * values needed for longer must be copied by the calling module.
+     *
+     * When reading forward binary files, the views point directly into the
+     * reader's data buffer, so the record is not copied when read. Records
+     * are packed, so the values are not necessarily aligned there; views
+     * fetch them one at a time when accessed (see astrolabe_double_view).
+     * Other channels stage the values in an internal scratch area reused
+     * from record to record.
+     */
+
+    int                  read_l_data_view          (int                    n_tag_values,
+                                                    astrolabe_double_view& the_tags,
+                                                    int                    n_expectation_values,
+                                                    astrolabe_double_view& the_expectations,
+                                                    int&                   n_covariance_values_found,
+                                                    astrolabe_double_view& the_covariance_values);
+
     /**
      * @brief Read the time tag.
      *
@@ -596,6 +635,29 @@ class instrument_reader
 
     int                  set_header_file           (const char* header_file_name);
 
+    /**
+     * @brief Set the number of threads parsing text chunk files.
+     *
+     * @param n_threads Number of worker threads. One (the default) reads
+     *        text files sequentially; zero means as many as cores are
+     *        available.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: Invalid number of threads (negative).
+     *
+     * With more than one thread (or zero), text chunk files are read by
+     * instrument_file_reader_txt_parallel (see
+     * obs_e_based_file_reader_txt_parallel), which splits every chunk into
+     * byte ranges parsed by a pool of worker threads. Records are still
+     * delivered in file order, with the same error codes.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open().
+     */
+
+    int                  set_number_of_threads     (int n_threads);
+
     /**
      * @brief Set the name of the XML schema defining the grammar of
      *        ASTROLABE header files.
@@ -648,6 +710,14 @@ class instrument_reader
 
   protected:
 
+    /**
+     * @brief Instantiate a file reader suitable for the number of threads
+     *        selected (see set_number_of_threads()).
+     * @return The new file reader, not yet open.
+     */
+
+    obs_e_based_file_reader* new_file_reader       (void);
+
     /**
      * @brief Read the metadata included in the ASTROLABE header file.
      * @param total_metadata_warnings Number of warnings detected while retrieving
@@ -766,6 +836,11 @@ class instrument_reader
 
     bool                            socket_works_in_server_mode_;
 
+    /// \brief Number of threads parsing text chunk files (see
+    /// set_number_of_threads()).
+
+    int                             text_threads_;
+
 };
 
 #endif // INSTRUMENT_READER_HPP
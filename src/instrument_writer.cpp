@@ -69,6 +69,7 @@ instrument_writer
     lineage_info_           = NULL;
     port_                   = 0;
     socket_server_mode_     = false;
+    socket_window_          = 1;
     socket_writer_          = NULL;
   }
 }
@@ -122,6 +123,7 @@ open
       // Sockets.
 
       socket_writer_ = new instrument_socket_writer();
+      socket_writer_->set_window(socket_window_);
       status = socket_writer_->open(host_.c_str(), port_, socket_server_mode_);
       if (status != 0) return status;
     }
@@ -270,6 +272,26 @@ set_data_channel
   }
 }
 
+int
+instrument_writer::
+set_socket_window
+(int n_records)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (n_records < 1) return 2;
+
+    socket_window_ = n_records;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 instrument_writer::
 write_l
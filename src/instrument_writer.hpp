@@ -226,6 +226,29 @@ class instrument_writer
                                         int          port,
                                         bool         server_mode);
 
+    /**
+     * \brief Let several records travel through socket data channels
+     *        without waiting for their acknowledgement.
+     *
+     * \param n_records Maximum number of records not acknowledged yet.
+     *        One (the default) keeps the stop-and-wait protocol, where
+     *        every record waits for its acknowledgement.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: The window must be greater than zero.
+     *
+     * See obs_e_based_socket_writer::set_window(). A window greater than one
+     * is asked for when the connection is opened, so the reader must
+     * understand the windowed protocol; otherwise, open() fails.
+     *
+     * This setting has no effect on file data channels. It must be
+     * decided before calling open().
+     */
+
+    int  set_socket_window             (int          n_records);
+
     /**
      * \brief Write an l-record.
      *
@@ -327,6 +350,11 @@ class instrument_writer
 
     bool                            socket_server_mode_;
 
+    /// \brief Window asked for when opening socket data channels (see
+    /// set_socket_window()).
+
+    int                             socket_window_;
+
     /// \brief Socket writer in charge to write instrument data
     /// using a socket conection.
 
@@ -26,6 +26,8 @@ obs_e_based_file_reader
 
     is_eof_                                = false;
 
+    prefetch_is_enabled_                   = false;
+
     read_active_flag_                      = false;
     read_identifier_                       = false;
     read_completed_                        = true;
@@ -38,6 +40,13 @@ obs_e_based_file_reader
     reading_first_epoch_                   = true;
     reading_l_                             = false;
     reading_o_                             = false;
+
+    reverse_window_size_                   = _ASTROLABE_OBS_E_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE;
+
+    view_doubles_                          = NULL;
+    view_doubles_size_                     = 0;
+    view_ints_                             = NULL;
+    view_ints_size_                        = 0;
   }
 }
 
@@ -46,6 +55,10 @@ obs_e_based_file_reader::
 (void)
 {
   {
+    // Stop reading in advance before closing the file.
+
+    read_ahead_.detach();
+
     if (data_buffer_ != NULL) delete [] data_buffer_;
 
     data_buffer_        = NULL;
@@ -64,6 +77,12 @@ obs_e_based_file_reader::
       delete file_name_;
       file_name_ = NULL;
     }
+
+    if (view_doubles_ != NULL) delete [] view_doubles_;
+    if (view_ints_    != NULL) delete [] view_ints_;
+
+    view_doubles_       = NULL;
+    view_ints_          = NULL;
   }
 }
 
@@ -105,6 +124,10 @@ close
     // Do not complain if the file is already closed.
     if (!file_is_open_) return 0;
 
+    // Stop reading in advance, if needed, before closing the file.
+
+    read_ahead_.detach();
+
     // Close the file.
 
     status = fclose(file_file_);
@@ -160,6 +183,18 @@ epoch_change_acknowledged
   }
 }
 
+void
+obs_e_based_file_reader::
+get_read_statistics
+(long long& bytes_read,
+ double&    seconds)
+const
+{
+  {
+    read_ahead_.get_statistics(bytes_read, seconds);
+  }
+}
+
 bool
 obs_e_based_file_reader::
 is_eof
@@ -182,6 +217,176 @@ const
   }
 }
 
+int
+obs_e_based_file_reader::
+read_l_data_view
+(int                    n_tag_values,
+ astrolabe_double_view& the_tags,
+ int                    n_expectation_values,
+ astrolabe_double_view& the_expectations,
+ int&                   n_covariance_values_found,
+ astrolabe_double_view& the_covariance_values)
+{
+  {
+    double* covariances;
+    double* expectations;
+    int     n_doubles;
+    int     status;
+    double* tags;
+
+    // Check dimensions; these are needed to size the scratch area.
+
+    if (n_tag_values < 0)          return 6;
+    if (n_expectation_values <= 0) return 6;
+
+    //
+    // Worst case: tags, expectations and a full covariance matrix
+    // (standard deviations plus correlation coefficients).
+    //
+
+    n_doubles = n_tag_values + n_expectation_values +
+                (n_expectation_values * (n_expectation_values + 1)) / 2;
+
+    reserve_view_storage(n_doubles, 0);
+
+    tags         = view_doubles_;
+    expectations = tags + n_tag_values;
+    covariances  = expectations + n_expectation_values;
+
+    // Stage the values using the regular, copying, method.
+
+    status = read_l_data(n_tag_values,              tags,
+                         n_expectation_values,      expectations,
+                         n_covariance_values_found, covariances);
+
+    if (status != 0) return status;
+
+    // Publish the views.
+
+    the_tags.set             (tags,         n_tag_values);
+    the_expectations.set     (expectations, n_expectation_values);
+    the_covariance_values.set(covariances,  n_covariance_values_found);
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader::
+read_o_data_view
+(int                 n_parameter_iids,
+ astrolabe_int_view& the_parameter_iids,
+ int                 n_observation_iids,
+ astrolabe_int_view& the_observation_iids,
+ int                 n_instrument_iids,
+ astrolabe_int_view& the_instrument_iids)
+{
+  {
+    int* instruments;
+    int* observations;
+    int* parameters;
+    int  status;
+
+    // Check dimensions; these are needed to size the scratch area.
+
+    if (n_parameter_iids   <= 0) return 6;
+    if (n_observation_iids <= 0) return 6;
+    if (n_instrument_iids  <  0) return 6;
+
+    reserve_view_storage(0, n_parameter_iids + n_observation_iids + n_instrument_iids);
+
+    parameters   = view_ints_;
+    observations = parameters + n_parameter_iids;
+    instruments  = observations + n_observation_iids;
+
+    // Stage the values using the regular, copying, method.
+
+    status = read_o_data(n_parameter_iids,   parameters,
+                         n_observation_iids, observations,
+                         n_instrument_iids,  instruments);
+
+    if (status != 0) return status;
+
+    // Publish the views.
+
+    the_parameter_iids.set  (parameters,   n_parameter_iids);
+    the_observation_iids.set(observations, n_observation_iids);
+    the_instrument_iids.set (instruments,  n_instrument_iids);
+
+    return 0;
+  }
+}
+
+void
+obs_e_based_file_reader::
+reserve_view_storage
+(int n_doubles,
+ int n_ints)
+{
+  {
+    // Grow (never shrink) the scratch areas when needed.
+
+    if (n_doubles > view_doubles_size_)
+    {
+      if (view_doubles_ != NULL) delete [] view_doubles_;
+
+      view_doubles_      = new double[n_doubles];
+      view_doubles_size_ = n_doubles;
+    }
+
+    if (n_ints > view_ints_size_)
+    {
+      if (view_ints_ != NULL) delete [] view_ints_;
+
+      view_ints_      = new int[n_ints];
+      view_ints_size_ = n_ints;
+    }
+  }
+}
+
+void
+obs_e_based_file_reader::
+reset_read_state
+(void)
+{
+  {
+    last_epoch_changed_                    = false;
+    last_epoch_time_available_             = false;
+    last_epoch_time_                       = 0;
+
+    first_l_read_                          = false;
+
+    last_record_is_active_                 = false;
+
+    is_eof_                                = false;
+
+    read_active_flag_                      = false;
+    read_identifier_                       = false;
+    read_completed_                        = true;
+    read_iid_                              = false;
+    read_l_data_                           = false;
+    read_o_data_                           = false;
+    read_time_                             = false;
+    read_type_                             = false;
+
+    reading_first_epoch_                   = true;
+    reading_l_                             = false;
+    reading_o_                             = false;
+  }
+}
+
+int
+obs_e_based_file_reader::
+seek_epoch_boundary
+(long long offset)
+{
+  {
+    // Not supported by default.
+
+    return 3;
+  }
+}
+
 int
 obs_e_based_file_reader::
 set_buffer_size
@@ -203,3 +408,40 @@ set_buffer_size
     return 0;
   }
 }
+
+int
+obs_e_based_file_reader::
+set_prefetch
+(bool prefetch)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    prefetch_is_enabled_ = prefetch;
+
+    // Bye.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader::
+set_reverse_window
+(long long window_size)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    // Check the size.
+    if (window_size < 0) return 2;
+
+    reverse_window_size_ = window_size;
+
+    // Bye.
+
+    return 0;
+  }
+}
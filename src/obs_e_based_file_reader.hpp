@@ -10,12 +10,26 @@
 #include <cstring>
 #include <cstdio>
 
+#include "astrolabe_array_view.hpp"
+#include "astrolabe_file_utilities.hpp"
+#include "astrolabe_read_ahead.hpp"
+
 using namespace std;
 
 /// @brief Default buffer size: 5 Mbyte (5 * 1024 * 1024 bytes)
 
 #define _ASTROLABE_OBS_E_FILE_READER_DEFAULT_BUFFER_SIZE 5242880
 
+/// @brief Default size of the window used by readers in memory mapped mode:
+/// 64 Mbyte (64 * 1024 * 1024 bytes)
+
+#define _ASTROLABE_OBS_E_FILE_READER_DEFAULT_MAP_WINDOW_SIZE 67108864
+
+/// @brief Default size of the region that backward readers ask the system
+/// to load in advance: 32 Mbyte (32 * 1024 * 1024 bytes)
+
+#define _ASTROLABE_OBS_E_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE 33554432
+
 /**
  * @brief Abstract class to define the interface of several ASTROLABE
  *        obs_e based file readers.
@@ -37,7 +51,11 @@ using namespace std;
  * - Optionally, the size of the internal buffer used to reduce disk I/O
  *   may be set using method set_buffer_size(). Note that all descendant
  *   classes must provide with a default buffer size that would be used
- *   if a calling module makes no decisions on this subject.
+ *   if a calling module makes no decisions on this subject. Reading the
+ *   file in advance, in a helper thread, may be requested as well (see
+ *   set_prefetch()). Backward readers ask the system to load in advance
+ *   the region of the file preceding the data being read; its size may be
+ *   changed with set_reverse_window().
  * - The reader must be associated to a physical output file using
  *   method open(). This action enables actual I/O operations.
  * - The actual read process may start now. Since two different types of
@@ -217,6 +235,25 @@ class obs_e_based_file_reader
 
     virtual char* _file_name                (void) const;
 
+    /**
+     * @brief Retrieve the amount of data read from the file and the time
+     *        spent doing so.
+     *
+     * @param bytes_read Number of bytes read from the file to fill the
+     *        internal buffer.
+     * @param seconds Time, in seconds, the calling module has been blocked
+     *        waiting for these bytes.
+     *
+     * The quotient of both values is the throughput achieved, which lets
+     * calling modules compare, for instance, forward and backward passes
+     * over the same file. Statistics refer to the file opened last and are
+     * kept after closing it. Readers not using chunks (memory mapped or
+     * parallel ones) report zero bytes.
+     */
+
+    virtual void  get_read_statistics       (long long& bytes_read,
+                                             double&    seconds) const;
+
     /**
      * @brief Check if the data in the file has been completely read.
      *
@@ -453,6 +490,45 @@ class obs_e_based_file_reader
                                              int&     n_covariance_values_found,
                                              double*& the_covariance_values) = 0;
 
+    /**
+     * @brief Read the tags, expectations and covariance matrix values in an
+     *        l-record without copying them into caller-provided arrays.
+     *
+     * @param n_tag_values Number of tag values that must be read from
+     *        the l-record. May be zero, since tags are optional.
+     * @param the_tags On output, read-only view of the n_tag_values tags.
+     * @param n_expectation_values Number of expectation values that must be
+     *        read from the l-record. Must be greater than 0.
+     * @param the_expectations On output, read-only view of the
+     *        n_expectation_values expectations.
+     * @param n_covariance_values_found Actual number of covariance matrix
+     *        values found in the l-record (0, n or (n * (n + 1)) / 2).
+     * @param the_covariance_values On output, read-only view of the
+     *        n_covariance_values_found covariance matrix values.
+     * @return Error code. The same ones returned by read_l_data().
+     *
+     * This method is an alternative to read_l_data() and must be called
+     * exactly at the same point of the reading sequence. Instead of filling
+     * arrays owned by the calling module, the three output views are set
+     * to point to memory owned by the reader. Values need not be aligned
+     * there; see astrolabe_double_view for the ways to access them.
+     *
+     * The views remain valid until the next call to read_type().
+     *
+     * This default implementation stages the values in an internal scratch
+     * area, reused from record to record, by means of read_l_data(), so it
+     * works for any kind of reader. Readers able to expose their own
+     * internal buffers (as the forward binary ones) override it to avoid
+     * copying data at all.
+     */
+
+    virtual int   read_l_data_view          (int                    n_tag_values,
+                                             astrolabe_double_view& the_tags,
+                                             int                    n_expectation_values,
+                                             astrolabe_double_view& the_expectations,
+                                             int&                   n_covariance_values_found,
+                                             astrolabe_double_view& the_covariance_values);
+
     /**
      * @brief Read the lists of parameter, observation and instrument instance
      *        identifiers from an o-record.
@@ -520,6 +596,37 @@ class obs_e_based_file_reader
                                              int   n_instrument_iids,
                                              int*& the_instrument_iids) = 0;
 
+    /**
+     * @brief Read the lists of parameter, observation and instrument instance
+     *        identifiers from an o-record without copying them into
+     *        caller-provided arrays.
+     *
+     * @param n_parameter_iids Total number of parameter instance identifiers
+     *        to read. Must be greater than 0.
+     * @param the_parameter_iids On output, read-only view of the parameter
+     *        instance identifiers.
+     * @param n_observation_iids Total number of observation instance identifiers
+     *        to read. Must be greater than 0.
+     * @param the_observation_iids On output, read-only view of the observation
+     *        instance identifiers.
+     * @param n_instrument_iids Total number of instrument instance identifiers
+     *        to read. May be zero.
+     * @param the_instrument_iids On output, read-only view of the instrument
+     *        instance identifiers.
+     * @return Error code. The same ones returned by read_o_data().
+     *
+     * This method is an alternative to read_o_data(); see read_l_data_view()
+     * for a description of the lifetime of the views returned and of the
+     * behaviour of this default implementation.
+     */
+
+    virtual int   read_o_data_view          (int                 n_parameter_iids,
+                                             astrolabe_int_view& the_parameter_iids,
+                                             int                 n_observation_iids,
+                                             astrolabe_int_view& the_observation_iids,
+                                             int                 n_instrument_iids,
+                                             astrolabe_int_view& the_instrument_iids);
+
     /**
      * @brief Read the time tag, either for l- or o-records.
      *
@@ -623,6 +730,32 @@ class obs_e_based_file_reader
 
     virtual int   read_type                 (char& record_type) = 0;
 
+    /**
+     * @brief Position the reader at the beginning of an epoch.
+     *
+     * @param offset Offset in bytes, from the beginning of the file, of the
+     *        epoch boundary to move to. Forward readers expect the offset
+     *        of the first record of an epoch, while backward readers expect
+     *        that of the byte following the last record of the epoch
+     *        (see epoch_time_index).
+     * @return Error code. Error code values are:
+     *        - 0: Successful completion.
+     *        - 1: The offset is beyond the end of the data.
+     *        - 2: I/O error.
+     *        - 3: Operation not supported by this reader or file not open.
+     *
+     * After a successful seek, the reader is in the same state it would be
+     * after having opened the file, except that the next record retrieved
+     * will be the first (forward) or last (backward) one of the selected
+     * epoch. The offset must be a true epoch boundary, such as those
+     * stored in time indexes; otherwise, results are unpredictable.
+     *
+     * This implementation always returns 3. Readers able to reposition
+     * themselves must override it.
+     */
+
+    virtual int   seek_epoch_boundary       (long long offset);
+
     /**
      * @brief Set the size of the internal buffer used to reduce I/O.
      *
@@ -673,8 +806,89 @@ class obs_e_based_file_reader
 
     virtual int   set_buffer_size           (int buffer_size);
 
+    /**
+     * @brief Enable or disable reading the file in advance.
+     *
+     * @param prefetch True to read the next chunk of the file in a helper
+     *        thread, false otherwise.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file is already open and therefore it is not
+     *             possible to change this setting.
+     *
+     * Readers fill their internal buffer (see set_buffer_size()) with
+     * chunks of the file, and the calling module is blocked while these
+     * are read. When prefetching is enabled, a helper thread reads the
+     * next chunk (the previous one for backward readers) while the
+     * records in the current one are being retrieved, so I/O and decoding
+     * overlap. This is specially convenient when files are stored on
+     * slow or network devices. It costs a second buffer as big as the
+     * internal one.
+     *
+     * Records, error codes and epoch semantics are exactly the same no
+     * matter this setting. Readers not using chunks (memory mapped or
+     * parallel ones) ignore it.
+     *
+     * This method may be called only after the reader object has been
+     * instantiated and before open() has been invoked. By default,
+     * prefetching is disabled.
+     */
+
+    virtual int   set_prefetch              (bool prefetch);
+
+    /**
+     * @brief Set the size of the region of the file that backward readers
+     *        ask the system to load in advance.
+     *
+     * @param window_size Size of the region, in bytes. 0 disables this
+     *        feature.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file is already open and therefore it is not
+     *             possible to change this setting.
+     *        - 2: Invalid (negative) size.
+     *
+     * Operating systems read files in advance assuming that these are
+     * read from their beginning to their end, which is useless when read
+     * backwards. Backward readers therefore tell the system (where
+     * possible, see astr_fprefetch()) which region of the file precedes
+     * the chunk being read, so it is loaded while the records in the
+     * current chunk are retrieved. Bigger windows keep the device busy
+     * longer, which pays on network storage; they do not use memory in the
+     * reader itself. Forward readers ignore this setting.
+     *
+     * This method may be called only after the reader object has been
+     * instantiated and before open() has been invoked. The default size is
+     * _ASTROLABE_OBS_E_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE.
+     */
+
+    virtual int   set_reverse_window        (long long window_size);
+
   protected:
 
+    /**
+     * @brief Make sure that the scratch areas used by the default
+     *        implementations of read_l_data_view() and read_o_data_view()
+     *        are big enough.
+     *
+     * @param n_doubles Minimum number of doubles in view_doubles_.
+     * @param n_ints Minimum number of integers in view_ints_.
+     *
+     * The scratch areas only grow; they are reused by later records and
+     * released when the reader is destroyed.
+     */
+
+    void          reserve_view_storage      (int n_doubles, int n_ints);
+
+    /**
+     * @brief Reset the flags controlling the reading process and the
+     *        tracking of epochs, as if the file had just been opened.
+     *
+     * Used by seek_epoch_boundary() implementations.
+     */
+
+    void          reset_read_state          (void);
+
     /// @brief The internal buffer used to store the data read.
 
     char*         data_buffer_;
@@ -697,7 +911,7 @@ class obs_e_based_file_reader
 
     /// @brief Actual size of the file read (in bytes).
 
-    long          file_size_;
+    long long     file_size_;
 
     /// @brief Flag. When true, the first read record in an epoch was an l-one.
 
@@ -726,6 +940,21 @@ class obs_e_based_file_reader
 
     bool          last_epoch_time_available_;
 
+    /// @brief Flag. When true, the file is read in advance (see set_prefetch()).
+
+    bool          prefetch_is_enabled_;
+
+    /// @brief Reads the chunks of the file, in advance if prefetching is
+    /// enabled. Descendant classes reading chunks attach it to the file
+    /// when opening it and use it to fill data_buffer_.
+
+    astrolabe_read_ahead read_ahead_;
+
+    /// @brief Size of the region hinted in advance by backward readers (see
+    /// set_reverse_window()).
+
+    long long     reverse_window_size_;
+
     /// @brief Control flag. When true, it indicates that a call to read_active_flag()
     /// has already been made for the current record.
 
@@ -782,6 +1011,22 @@ class obs_e_based_file_reader
 
     bool          reading_o_;
 
+    /// @brief Scratch area used to stage doubles returned as views.
+
+    double*       view_doubles_;
+
+    /// @brief Size (number of doubles) of view_doubles_.
+
+    int           view_doubles_size_;
+
+    /// @brief Scratch area used to stage integers returned as views.
+
+    int*          view_ints_;
+
+    /// @brief Size (number of integers) of view_ints_.
+
+    int           view_ints_size_;
+
 };
 
 #endif // OBS_E_BASE_FILE_READER_HPP
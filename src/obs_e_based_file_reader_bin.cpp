@@ -4,6 +4,29 @@
 */ 
 #include "obs_e_based_file_reader_bin.hpp"
 
+int
+obs_e_based_file_reader_bin::
+close
+(void)
+{
+  {
+    //
+    // Stop reading in advance, since it may be using the stream, and forget
+    // about the file (releasing the decompression buffers).
+    //
+
+    if (file_is_open_)
+    {
+      read_ahead_.detach();
+      data_stream_.detach();
+    }
+
+    // Close the file.
+
+    return obs_e_based_file_reader::close();
+  }
+}
+
 obs_e_based_file_reader_bin::
 obs_e_based_file_reader_bin
 (void)
@@ -18,7 +41,9 @@ obs_e_based_file_reader_bin::
 (void)
 {
   {
-    // INTENTIONALLY LEFT BLANK.
+    // The helper thread reading in advance may be using data_stream_.
+
+    read_ahead_.detach();
   }
 }
 
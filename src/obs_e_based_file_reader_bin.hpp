@@ -7,6 +7,7 @@
 #define OBS_E_BASED_FILE_READER_BIN_HPP
 
 #include "obs_e_based_file_reader.hpp"
+#include "astrolabe_compressed_file.hpp"
 
 /**
  * @brief Abstract class to define the interface of binary obs_e_based file readers.
@@ -17,11 +18,28 @@
  * This class implements the interface defined in parent class
  * obs_e_based_file_reader, reading obs_e_based files stored in binary format.
  *
+ * Binary files may be either plain or block-compressed (see
+ * obs_e_based_file_writer_bin::set_compression()). Descendant classes
+ * access the data through data_stream_, which decompresses the latter
+ * transparently, so both kinds of files are read the same way.
+ *
  */
 class obs_e_based_file_reader_bin : public obs_e_based_file_reader
 {
   public:
 
+    /**
+     * @brief Closes the file reader, disabling any other
+     *        further action on it.
+     * @return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: Error closing the file.
+     *
+     * The memory used to decompress block-compressed files is released.
+     */
+
+    virtual int  close                        (void);
+
     /**
      * @brief Default constructor.
      */
@@ -395,6 +413,14 @@ class obs_e_based_file_reader_bin : public obs_e_based_file_reader
 
     virtual int  read_type                    (char& record_type) = 0;
 
+  protected:
+
+    /// @brief Access to the (possibly compressed) data in file_file_. All
+    /// sizes and offsets (file_size_, time index offsets...) are those of
+    /// the uncompressed data.
+
+    astrolabe_compressed_file data_stream_;
+
 };
 
 #endif // OBS_E_BASED_FILE_READER_BIN_HPP
@@ -4,6 +4,16 @@
 */ 
 #include "obs_e_based_file_reader_bin_forward.hpp"
 
+//
+// Memory mapped files are available only on POSIX systems.
+//
+
+#ifndef _WIN32
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif // _WIN32
+
 obs_e_based_file_reader_bin_forward::
 obs_e_based_file_reader_bin_forward
 (void)
@@ -11,6 +21,15 @@ obs_e_based_file_reader_bin_forward
   {
     data_buffer_bytes_   = 0;
     data_buffer_current_ = 0;
+    file_bytes_read_     = 0;
+    file_is_mapped_      = false;
+
+    map_base_            = NULL;
+    map_data_offset_     = 0;
+    map_file_size_       = 0;
+    map_length_          = 0;
+    map_window_size_     = 0;
+    memory_mapped_       = false;
   }
 }
 
@@ -19,7 +38,128 @@ obs_e_based_file_reader_bin_forward::
 (void)
 {
   {
-    // INTENTIONALLY LEFT BLANK.
+    //
+    // When memory mapped, the data buffer points to the mapped window and
+    // must not be deleted by the parent's destructor. Closing the file
+    // unmaps the window and resets the data buffer.
+    //
+
+    if (file_is_mapped_) close();
+  }
+}
+
+int
+obs_e_based_file_reader_bin_forward::
+close
+(void)
+{
+  {
+    // Do not complain if the file is already closed.
+
+    if (!file_is_open_) return 0;
+
+    //
+    // If memory mapped, unmap the current window. The data buffer
+    // is set to NULL so the parent class does not try to delete it.
+    //
+
+    #ifndef _WIN32
+    if (file_is_mapped_)
+    {
+      if (map_base_ != NULL) munmap((void*)map_base_, map_length_);
+
+      map_base_       = NULL;
+      map_length_     = 0;
+      data_buffer_    = NULL;
+      file_is_mapped_ = false;
+    }
+    #endif // _WIN32
+
+    // Close the file.
+
+    return obs_e_based_file_reader_bin::close();
+  }
+}
+
+bool
+obs_e_based_file_reader_bin_forward::
+is_memory_mapped
+(void)
+const
+{
+  {
+    return file_is_open_ ? file_is_mapped_ : memory_mapped_;
+  }
+}
+
+int
+obs_e_based_file_reader_bin_forward::
+map_window
+(long long offset)
+{
+  {
+    #ifndef _WIN32
+
+    long long aligned_offset;
+    size_t    length;
+    void*     new_base;
+    long long page_size;
+
+    // Nothing to map beyond the end of the file.
+
+    if (offset >= map_file_size_) return 1;
+
+    //
+    // Mapping offsets must be multiples of the page size. Therefore, we'll
+    // map the window starting at the page containing offset, and make the
+    // data buffer point to the right position inside this window.
+    //
+
+    page_size      = (long long)sysconf(_SC_PAGESIZE);
+    aligned_offset = offset - (offset % page_size);
+
+    length = map_window_size_;
+    if ((aligned_offset + (long long)length) > map_file_size_)
+      length = (size_t)(map_file_size_ - aligned_offset);
+
+    new_base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileno(file_file_), (off_t)aligned_offset);
+
+    if (new_base == MAP_FAILED) return 2;
+
+    //
+    // Tell the kernel that the window will be read sequentially and
+    // that we will need it soon, so read-ahead starts right now.
+    // These are just hints; errors are harmless and thus ignored.
+    //
+
+    madvise(new_base, length, MADV_SEQUENTIAL);
+    madvise(new_base, length, MADV_WILLNEED);
+
+    // Release the previous window, if any.
+
+    if (map_base_ != NULL) munmap((void*)map_base_, map_length_);
+
+    // Make the data buffer point to the requested offset.
+
+    map_base_            = (char*)new_base;
+    map_length_          = length;
+    map_data_offset_     = offset;
+
+    data_buffer_         = map_base_ + (offset - aligned_offset);
+    data_buffer_bytes_   = (int)(aligned_offset + (long long)length - offset);
+    data_buffer_current_ = 0;
+
+    // That's all.
+
+    return 0;
+
+    #else
+
+    // Memory mapped files not available on this platform.
+
+    return 2;
+
+    #endif // _WIN32
   }
 }
 
@@ -33,6 +173,14 @@ move_remaining_up
     void*  destination;
     void*  source;
 
+    //
+    // When memory mapped, the data buffer is the mapped window itself,
+    // so nothing has to be moved. Moving the window forward is the
+    // job of read_next_chunk().
+    //
+
+    if (file_is_mapped_) return 0;
+
     //
     // Compute the number of bytes to move. This is computing
     // substracting the first non-read position in the buffer
@@ -97,21 +245,71 @@ open
 
     if (file_file_ == NULL) return 2;
 
-    // Ascertain how big is the file.
+    //
+    // Find out whether the file is compressed or not, and how big is the
+    // (uncompressed) data. The stream is left at the start of the data.
+    //
 
-    if (fseek(file_file_, 0 , SEEK_END) != 0)
-    {
-      return 5; // I/O error.
-    }
+    read_status = data_stream_.attach(file_file_);
 
-    file_size_ = ftell(file_file_);
+    if (read_status == 1) return 5; // I/O error.
+    if (read_status == 2) return 6; // Corrupted compressed file.
+
+    file_size_ = data_stream_.get_size();
+
+    //
+    // Compressed files can't be mapped, since what is stored on disk
+    // are not the records themselves. Use buffered reads.
+    //
+
+    file_is_mapped_ = memory_mapped_ && !data_stream_.is_compressed();
 
     //
-    // Reset the fseek position, to be able to read from the start of the
-    // file.
+    // Memory mapped mode. Map the first window of the file. Should
+    // the file be impossible to map, we'll revert to buffered reads.
     //
 
-    fseek(file_file_, 0 , SEEK_SET);
+    #ifndef _WIN32
+    if (file_is_mapped_)
+    {
+      map_file_size_   = file_size_;
+      map_window_size_ = _ASTROLABE_OBS_E_FILE_READER_DEFAULT_MAP_WINDOW_SIZE;
+      if ((size_t)data_buffer_size_ > map_window_size_) map_window_size_ = (size_t)data_buffer_size_;
+
+      file_is_open_ = true;
+
+      // Empty files can't be mapped, and must be reported as such.
+
+      if (map_file_size_ == 0) return 4;
+
+      read_status = map_window(0);
+
+      if (read_status == 0)
+      {
+        //
+        // The whole file will be read sequentially. Tell the kernel
+        // (this is just a hint, so errors are ignored).
+        //
+
+        #ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fileno(file_file_), 0, 0, POSIX_FADV_SEQUENTIAL);
+        #endif
+
+        // Set the name of the file just open.
+
+        file_name_ = strdup(file_name);
+
+        // Successful completion.
+
+        return 0;
+      }
+
+      // Unable to map the file. Revert to buffered reads.
+
+      file_is_open_   = false;
+      file_is_mapped_ = false;
+    }
+    #endif // _WIN32
 
     // Try to create the buffer used for block reads.
 
@@ -126,7 +324,7 @@ open
       // If everything works, the file is reported as open.
       //
 
-      if (file_size_ < data_buffer_size_) data_buffer_size_ = file_size_;
+      if (file_size_ < data_buffer_size_) data_buffer_size_ = (int)file_size_;
 
       data_buffer_ = new char[data_buffer_size_];
       file_is_open_ = true;
@@ -143,6 +341,17 @@ open
       return 3;
     }
 
+    //
+    // Chunks are read through read_ahead_, in a helper thread if so
+    // requested. Should the thread be impossible to start, chunks will
+    // be read when needed, so the error code is ignored.
+    //
+
+    file_bytes_read_ = 0;
+
+    read_ahead_.attach(&data_stream_);
+    if (prefetch_is_enabled_) read_ahead_.start(data_buffer_size_, false);
+
     //
     // Read as much bytes as possible (maximum: data_buffer_size_)
     // from the underlying binary file.
@@ -685,6 +894,174 @@ read_l_data
   }
 }
 
+int
+obs_e_based_file_reader_bin_forward::
+read_l_data_view
+(int                    n_tag_values,
+ astrolabe_double_view& the_tags,
+ int                    n_expectation_values,
+ astrolabe_double_view& the_expectations,
+ int&                   n_covariance_values_found,
+ astrolabe_double_view& the_covariance_values)
+{
+  {
+    int   bytes_moved;
+    int   bytes_to_eat;
+    int   covariances;
+    int   expectations;
+    int   offset;
+    int   read_status;
+    int   tags;
+
+    int   n;
+    int   n_covariances_found;
+    int   n_tags_found;
+    int   n_expectations_found;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only when the time
+    // tag has been read and we are reading an l-type record.
+    //
+
+    if (!read_time_)               return 3;
+    if ( read_completed_)          return 3;
+    if (!reading_l_)               return 3;
+
+    // Check dimensions.
+
+    if (n_tag_values < 0)          return 6;
+    if (n_expectation_values <= 0) return 6;
+
+    //
+    // Make sure that the three counters, the tags and the expectations
+    // are in the buffer. See read_l_data() for details.
+    //
+
+    bytes_to_eat = 3 * sizeof(int) + (n_tag_values + n_expectation_values) * sizeof(double);
+
+    if ((data_buffer_current_ + bytes_to_eat - 1) >= data_buffer_bytes_)
+    {
+      bytes_moved = move_remaining_up();
+      read_status = read_next_chunk(bytes_moved);
+
+      if (read_status == 1)
+      {
+        // End-of-file condition detected.
+
+        is_eof_ = true;
+        return 1;
+      }
+      else if (read_status == 2)
+      {
+        // I/O error detected.
+        return 2;
+      }
+    }
+
+    //
+    // Peek (do not consume yet) the three counters, checking them as
+    // we go.
+    //
+
+    offset = data_buffer_current_;
+
+    memcpy((void*)&n_tags_found, (void*)&(data_buffer_[offset]), sizeof(int));
+    if (n_tags_found != n_tag_values) return 7;
+
+    offset = offset + sizeof(int) + n_tag_values * sizeof(double);
+
+    memcpy((void*)&n_expectations_found, (void*)&(data_buffer_[offset]), sizeof(int));
+    if (n_expectations_found != n_expectation_values) return 7;
+
+    offset = offset + sizeof(int) + n_expectation_values * sizeof(double);
+
+    memcpy((void*)&n_covariances_found, (void*)&(data_buffer_[offset]), sizeof(int));
+
+    n = n_expectations_found;
+
+    if ((n_covariances_found != 0) &
+        (n_covariances_found != n) &
+        (n_covariances_found != ((n * (n + 1)) / 2))) return 7;
+
+    //
+    // Now the full size of the l-data is known. Make sure that all of it
+    // is in the buffer BEFORE setting any view, since moving the remaining
+    // bytes up would invalidate these.
+    //
+
+    offset       = offset + sizeof(int);
+    bytes_to_eat = (offset - data_buffer_current_) + n_covariances_found * sizeof(double);
+
+    if ((data_buffer_current_ + bytes_to_eat - 1) >= data_buffer_bytes_)
+    {
+      bytes_moved = move_remaining_up();
+      read_status = read_next_chunk(bytes_moved);
+
+      if (read_status == 1)
+      {
+        // End-of-file condition detected.
+
+        is_eof_ = true;
+        return 1;
+      }
+      else if (read_status == 2)
+      {
+        // I/O error detected.
+        return 2;
+      }
+    }
+
+    //
+    // Locate the arrays. Note that data_buffer_current_ may have changed
+    // if more data had to be loaded.
+    //
+
+    tags         = data_buffer_current_ + sizeof(int);
+    expectations = tags         + n_tag_values         * sizeof(double) + sizeof(int);
+    covariances  = expectations + n_expectation_values * sizeof(double) + sizeof(int);
+
+    //
+    // Set the views. Records are packed, so the arrays need not be aligned;
+    // views copy every value out when accessed, so that's not a problem.
+    //
+
+    the_tags.set             (&(data_buffer_[tags]),         n_tag_values);
+    the_expectations.set     (&(data_buffer_[expectations]), n_expectation_values);
+    the_covariance_values.set(&(data_buffer_[covariances]),  n_covariances_found);
+
+    n_covariance_values_found = n_covariances_found;
+
+    // Consume the l-data.
+
+    data_buffer_current_ = data_buffer_current_ + bytes_to_eat;
+
+    //
+    // Update flags.
+    //
+
+    read_type_             = false;
+    read_active_flag_      = false;
+    read_identifier_       = false;
+    read_iid_              = false;
+    read_time_             = false;
+    read_l_data_           = false;
+    read_o_data_           = false;
+
+    reading_l_             = false;
+    reading_o_             = false;
+
+    read_completed_        = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 obs_e_based_file_reader_bin_forward::
 read_next_chunk
@@ -699,6 +1076,22 @@ read_next_chunk
 
     if (!file_is_open_) return 2;
 
+    //
+    // Memory mapped mode. Everything up to the end of the data buffer is
+    // already available; if the current window reaches the end of the file
+    // there's no more data. Otherwise, move the window forward so it starts
+    // at the first non processed byte.
+    //
+
+    if (file_is_mapped_)
+    {
+      if ((map_data_offset_ + data_buffer_bytes_) >= map_file_size_) return 1;
+
+      if (map_window(map_data_offset_ + data_buffer_current_) != 0) return 2;
+
+      return 0;
+    }
+
     //
     // Read as much bytes as possible (maximum: data_buffer_size_)
     // from the underlying binary file.
@@ -730,9 +1123,11 @@ read_next_chunk
 
     buffer_start_address = (void*) &(data_buffer_[start_at]);
 
-    // Read the underlying file.
+    // Read the underlying file (decompressing it if needed).
 
-    bytes_read = fread(buffer_start_address, 1, bytes_to_read, file_file_);
+    bytes_read = read_ahead_.read(file_bytes_read_, buffer_start_address, bytes_to_read);
+
+    file_bytes_read_ += bytes_read;
 
     //
     // Check the number of bytes read. If it does not match the number of
@@ -748,7 +1143,7 @@ read_next_chunk
     {
       // Check first the error status.
 
-      if (ferror(file_file_)) return 2;
+      if (read_ahead_.error()) return 2;
 
       //
       // Then, if the number of bytes read is exactly zero, we'll raise
@@ -769,3 +1164,86 @@ read_next_chunk
     return 0;
   }
 }
+
+int
+obs_e_based_file_reader_bin_forward::
+seek_epoch_boundary
+(long long offset)
+{
+  {
+    int read_status;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 3;
+
+    // The offset must lie inside the file.
+
+    if ((offset < 0) || (offset > file_size_)) return 1;
+
+    // The reader behaves now as if the file had just been open.
+
+    reset_read_state();
+
+    //
+    // Memory mapped mode. Move the window so it starts at offset. If the
+    // offset is the end of the file, leave an empty data buffer; read_next_chunk()
+    // will detect the end-of-file condition.
+    //
+
+    if (file_is_mapped_)
+    {
+      if (offset >= map_file_size_)
+      {
+        map_data_offset_     = map_file_size_;
+        data_buffer_bytes_   = 0;
+        data_buffer_current_ = 0;
+        return 0;
+      }
+
+      if (map_window(offset) != 0) return 2;
+
+      return 0;
+    }
+
+    // Buffered mode. Discard the contents of the buffer and refill it.
+
+    data_buffer_bytes_   = 0;
+    data_buffer_current_ = 0;
+    file_bytes_read_     = offset;
+
+    read_status = read_next_chunk(0);
+
+    if (read_status == 2) return 2;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader_bin_forward::
+set_memory_mapped
+(bool memory_mapped)
+{
+  {
+    // If the file is already open, it's not legal to change the I/O model.
+
+    if (file_is_open_) return 1;
+
+    // Memory mapped files are available only on POSIX systems.
+
+    #ifdef _WIN32
+    if (memory_mapped) return 2;
+    #endif // _WIN32
+
+    // Set the new I/O model.
+
+    memory_mapped_ = memory_mapped;
+
+    // Bye.
+
+    return 0;
+  }
+}
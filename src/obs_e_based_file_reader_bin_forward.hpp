@@ -17,6 +17,20 @@
  * obs_e_based_file_reader_bin, reading obs_e_based files stored in binary format in
  * forward direction.
  *
+ * Two different I/O models are available. By default, the file is read
+ * in blocks that are copied (fread) to the internal data buffer. Optionally
+ * (see set_memory_mapped()) the file may be memory mapped instead; in this
+ * case, the data buffer is not allocated at all but points directly to
+ * the mapped pages, so records are decoded with no intermediate copies.
+ * The file is mapped using a sliding window that moves forward as the
+ * data is consumed; this makes it possible to read files much bigger than
+ * the address space available, and tells the operating system that the file
+ * will be read sequentially, so read-ahead may be applied.
+ *
+ * The error codes and epoch semantics are the same no matter the
+ * I/O model in use.
+ *
+ * Memory mapped mode is only available on POSIX systems.
  */
 
 class obs_e_based_file_reader_bin_forward : public obs_e_based_file_reader_bin
@@ -35,6 +49,32 @@ class obs_e_based_file_reader_bin_forward : public obs_e_based_file_reader_bin
 
                  ~obs_e_based_file_reader_bin_forward (void);
 
+    /**
+     * @brief Closes the file reader, disabling any other
+     *        further action on it.
+     * @return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: Error closing the file.
+     *
+     * When working in memory mapped mode, the current window is
+     * unmapped before closing the file.
+     */
+
+    virtual int  close                                (void);
+
+    /**
+     * @brief Check if the reader is using the memory mapped I/O model.
+     *
+     * @return True if the file is (or will be, once opened) read
+     *         through a memory map, false otherwise.
+     *
+     * Note that open() will revert to the regular, buffered I/O model
+     * when the file can not be mapped; this method reports the I/O
+     * model actually in use after open() has been called.
+     */
+
+    virtual bool is_memory_mapped                     (void) const;
+
     /**
      * @brief Opens the reader, enabling I/O operations.
      *
@@ -46,6 +86,7 @@ class obs_e_based_file_reader_bin_forward : public obs_e_based_file_reader_bin
      *        - 3: Not enough memory to allocate the internal buffer.
      *        - 4: End of file condition detected - the file is empty.
      *        - 5: I/O error detected while reading the file.
+     *        - 6: Corrupted block-compressed file.
      *
      * Once a reader has been instantiated (and, optionally, the
      * size of the internal buffer set using set_buffer_size()), it is
@@ -54,6 +95,9 @@ class obs_e_based_file_reader_bin_forward : public obs_e_based_file_reader_bin
      * This method opens the file and instantiates the internal memory
      * buffer used to speed up I/O operations, enabling the different
      * read operations available in this class.
+     *
+     * Both plain and block-compressed files (see
+     * obs_e_based_file_writer_bin::set_compression()) are accepted.
      */
 
     virtual int  open                                 (const char* file_name);
@@ -209,6 +253,39 @@ class obs_e_based_file_reader_bin_forward : public obs_e_based_file_reader_bin
                                                        int&     n_covariance_values_found,
                                                        double*& the_covariance_values);
 
+    /**
+     * @brief Read the tags, expectations and covariance matrix values in an
+     *        l-record without copying them.
+     *
+     * @param n_tag_values Number of tag values that must be read from
+     *        the l-record. May be zero, since tags are optional.
+     * @param the_tags On output, read-only view of the n_tag_values tags.
+     * @param n_expectation_values Number of expectation values that must be
+     *        read from the l-record. Must be greater than 0.
+     * @param the_expectations On output, read-only view of the
+     *        n_expectation_values expectations.
+     * @param n_covariance_values_found Actual number of covariance matrix
+     *        values found in the l-record.
+     * @param the_covariance_values On output, read-only view of the
+     *        n_covariance_values_found covariance matrix values.
+     * @return Error code. The same ones returned by read_l_data().
+     *
+     * The views point directly into the data buffer (or into the mapped
+     * pages, in memory mapped mode), so no data is copied at all. The whole
+     * l-record is made available in the buffer before the views are set,
+     * so these remain valid until the next call to read_type().
+     *
+     * Records are packed, so the arrays in the buffer need not be aligned
+     * as doubles; the views do not require it (see astrolabe_double_view).
+     */
+
+    virtual int  read_l_data_view                     (int                    n_tag_values,
+                                                       astrolabe_double_view& the_tags,
+                                                       int                    n_expectation_values,
+                                                       astrolabe_double_view& the_expectations,
+                                                       int&                   n_covariance_values_found,
+                                                       astrolabe_double_view& the_covariance_values);
+
     /**
      * @brief Read the lists of parameter, observation and instrument instance
      *        identifiers from an o-record.
@@ -373,12 +450,77 @@ class obs_e_based_file_reader_bin_forward : public obs_e_based_file_reader_bin
 
     virtual int  read_type                            (char& record_type) = 0;
 
+    /**
+     * @brief Select the I/O model used to read the file.
+     *
+     * @param memory_mapped When true, the file will be memory mapped instead
+     *        of being read into the internal data buffer.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file is already open and therefore it is not
+     *             possible to change the I/O model.
+     *        - 2: Memory mapped files are not available on this platform.
+     *
+     * By default, forward binary readers copy blocks of the input file
+     * into an internal data buffer. This method makes it possible to
+     * map the file in memory instead, decoding the records straight from
+     * the mapped pages. This avoids copying every record twice (once from
+     * the kernel to the data buffer and once more when the leftover
+     * bytes of the buffer are moved up) and is specially convenient
+     * when dealing with very big files.
+     *
+     * The file is mapped using a sliding window whose size is the
+     * biggest of the buffer size (see set_buffer_size()) and
+     * _ASTROLABE_OBS_E_FILE_READER_DEFAULT_MAP_WINDOW_SIZE.
+     *
+     * If, once open() is called, the file can not be mapped, the reader
+     * reverts silently to the buffered I/O model. This is always the case
+     * for block-compressed files.
+     *
+     * This method may be called only after the reader object has been
+     * instantiated and before open() has been invoked.
+     */
+
+    /**
+     * @brief Position the reader at the beginning of an epoch.
+     *
+     * @param offset Offset in bytes of the first record of the epoch.
+     * @return Error code. See obs_e_based_file_reader::seek_epoch_boundary().
+     *
+     * Both the buffered and memory mapped I/O models are supported. Seeking
+     * to the end of the file is legal; the next read will report an
+     * end-of-file condition.
+     */
+
+    virtual int  seek_epoch_boundary                  (long long offset);
+
+    virtual int  set_memory_mapped                    (bool memory_mapped);
+
   protected:
 
+    /**
+     * @brief Map the window of the input file starting at a given offset.
+     * @param offset Offset, in bytes from the beginning of the file, of the
+     *        first byte that must be available in the data buffer.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: End of file (offset beyond the end of the file).
+     *        - 2: Unable to map the file.
+     *
+     * Maps the window of the file starting at the page containing offset,
+     * unmapping the previous one (if any). Once mapped, the data buffer
+     * points to the byte at position offset in the file.
+     */
+
+    int          map_window                           (long long offset);
+
     /**
      * @brief Moves the bytes still not processed in the data buffer to
      *        the beginning of this buffer.
      * @return The total number of bytes actually moved. May be zero.
+     *
+     * When working in memory mapped mode nothing is moved (and zero is
+     * returned), since the data buffer is the mapped window itself.
      */
 
     int          move_remaining_up                    (void);
@@ -401,6 +543,10 @@ class obs_e_based_file_reader_bin_forward : public obs_e_based_file_reader_bin
      *
      * The data already stored in positions 0..start_at of the buffer are
      * left undisturbed.
+     *
+     * When working in memory mapped mode, parameter start_at is ignored;
+     * the window is moved forward so it starts at the first non processed
+     * position in the data buffer.
      */
 
     int          read_next_chunk                      (int start_at);
@@ -415,6 +561,46 @@ class obs_e_based_file_reader_bin_forward : public obs_e_based_file_reader_bin
     /// "read") in the data buffer.
 
     int          data_buffer_current_;
+
+    /// @brief Offset in the file of the next byte to read into the data
+    /// buffer (buffered mode only).
+
+    long long    file_bytes_read_;
+
+    /// @brief Flag. True when the file open is actually read through a
+    /// memory map, that is, when requested, the file is not compressed and
+    /// open() managed to map it.
+
+    bool         file_is_mapped_;
+
+    /// @brief Start address of the window currently mapped (memory
+    /// mapped mode only).
+
+    char*        map_base_;
+
+    /// @brief Offset in the file of the first byte in the data buffer
+    /// (memory mapped mode only).
+
+    long long    map_data_offset_;
+
+    /// @brief Size of the file in bytes (memory mapped mode only).
+
+    long long    map_file_size_;
+
+    /// @brief Size in bytes of the window currently mapped (memory
+    /// mapped mode only).
+
+    size_t       map_length_;
+
+    /// @brief Maximum size in bytes of the mapped windows (memory
+    /// mapped mode only).
+
+    size_t       map_window_size_;
+
+    /// @brief Flag. When true, the file is read through a memory map
+    /// instead of using the data buffer, if possible (see set_memory_mapped()).
+
+    bool         memory_mapped_;
 };
 
 #endif // OBS_E_BASED_FILE_READER_BIN_FORWARD_HPP
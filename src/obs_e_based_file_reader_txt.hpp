@@ -9,6 +9,8 @@
 #include <string>
 #include <map>
 
+#include "astrolabe_number_parser.hpp"
+#include "astrolabe_record_parser.hpp"
 #include "obs_e_based_file_reader.hpp"
 
 /**
@@ -510,6 +512,8 @@ class obs_e_based_file_reader_txt : public obs_e_based_file_reader
      *
      * For instance, to check a closing l-tag, this method must be called
      * setting lctag to "</l>" and uctag to "</L>".
+     *
+     * The data buffer is parsed by astr_parse_closing_tag().
      */
 
     int          parse_closing_tag            (char* lctag, char *uctag);
@@ -543,6 +547,7 @@ class obs_e_based_file_reader_txt : public obs_e_based_file_reader
      * processed does not contain a valid text representation of a
      * double value.
      *
+     * The data buffer is parsed by astr_parse_double_value().
      */
 
     int          parse_double_value           (double& dvalue);
@@ -576,6 +581,7 @@ class obs_e_based_file_reader_txt : public obs_e_based_file_reader
      * processed does not contain a valid text representation of an
      * integer value.
      *
+     * The data buffer is parsed by astr_parse_int_value().
      */
 
     int          parse_int_value              (int& ivalue);
@@ -11,6 +11,7 @@ obs_e_based_file_reader_txt_forward
   {
     data_buffer_bytes_   = 0;
     data_buffer_current_ = 0;
+    file_bytes_read_     = 0;
   }
 }
 
@@ -30,6 +31,8 @@ find_next_record_limits
 {
   {
     int  i;
+    int  k;
+    int  n;
     bool opening_found;
     int  status;
     int  total_found;
@@ -50,7 +53,7 @@ find_next_record_limits
     // If such situation arises, more data (if any available) must be
     // loaded.
     //
-    // Looking for the second closing '<' now implies that once found
+    // Looking for the second closing '>' now implies that once found
     // (either because we had enough data in the buffer or because
     // some more had to be loaded) a whole record will be available
     // in the data buffer. This simplifies the algorithm.
@@ -60,22 +63,31 @@ find_next_record_limits
     // file in those cases that produce an end-of-file when trying to
     // load more data.
     //
+    // The positions of all the '<' and '>' in the data buffer were located
+    // when it was loaded (see read_next_chunk()), so we just need to walk
+    // through these.
+    //
 
     opening_found = false;
     total_found   = 0;
-    i             = data_buffer_current_;
+    i             = data_buffer_bytes_;
+    n             = delimiters_.n_delimiters();
 
-    while (i < data_buffer_bytes_)
+    for (k = delimiters_.find(data_buffer_current_); k < n; k++)
     {
-      if (data_buffer_[i] == '<') opening_found = true;
+      i = delimiters_.delimiter(k);
+      if (i >= data_buffer_bytes_)
+      {
+        i = data_buffer_bytes_;
+        break;
+      }
 
-      if (data_buffer_[i] == '>')
+      if (data_buffer_[i] == '<') opening_found = true;
+      else
       {
         total_found ++;
         if (total_found == 2) break;
       }
-
-      i++;
     }
 
     //
@@ -141,26 +153,28 @@ find_next_record_limits
       //
       // However, since the original information in the buffer has been
       // moved to its beginning, we must, again, look for the second
-      // closing '>'.
+      // closing '>' (read_next_chunk() has located the delimiters in the
+      // whole buffer again).
       //
       // We are assuming now that the whole record fits into our buffer, since
       // at this point we've read a full chunk of data from disk.
       //
 
-      i = data_buffer_current_; // Beginning of the buffer, since
-                                // move_remaining_up() resets
-                                // data_buffer_current_ to 0.
       total_found = 0;
+      i           = data_buffer_bytes_;
+      n           = delimiters_.n_delimiters();
 
-      while (i < data_buffer_bytes_)
+      for (k = delimiters_.find(data_buffer_current_); k < n; k++)
       {
-        if (data_buffer_[i] == '>')
+        if (data_buffer_[delimiters_.delimiter(k)] == '>')
         {
           total_found ++;
-          if (total_found == 2) break;
+          if (total_found == 2)
+          {
+            i = delimiters_.delimiter(k);
+            break;
+          }
         }
-
-        i++;
       }
 
       // We've got the position of the last (second, in fact) closing '>'.
@@ -171,12 +185,15 @@ find_next_record_limits
 
     // Now, find the first opening '<'.
 
-    i = data_buffer_current_;
+    i = data_buffer_bytes_;
 
-    while (i < data_buffer_bytes_)
+    for (k = delimiters_.find(data_buffer_current_); k < n; k++)
     {
-      if (data_buffer_[i] == '<') break;
-      i++;
+      if (data_buffer_[delimiters_.delimiter(k)] == '<')
+      {
+        i = delimiters_.delimiter(k);
+        break;
+      }
     }
 
     cur_record_start_ = i;
@@ -268,19 +285,19 @@ open
 
     // Ascertain how big is the file.
 
-    if (fseek(file_file_, 0 , SEEK_END) != 0)
+    if (astr_fseek(file_file_, 0 , SEEK_END) != 0)
     {
       return 5; // I/O error.
     }
 
-    file_size_ = ftell(file_file_);
+    file_size_ = astr_ftell(file_file_);
 
     //
     // Reset the fseek position, to be able to read from the start of the
     // file.
     //
 
-    fseek(file_file_, 0 , SEEK_SET);
+    astr_fseek(file_file_, 0 , SEEK_SET);
 
     // Try to create the buffer used for block reads.
 
@@ -295,7 +312,7 @@ open
       // If everything works, the file is reported as open.
       //
 
-      if (file_size_ < data_buffer_size_) data_buffer_size_ = file_size_;
+      if (file_size_ < data_buffer_size_) data_buffer_size_ = (int)file_size_;
 
       data_buffer_ = new char[data_buffer_size_];
       file_is_open_ = true;
@@ -312,6 +329,17 @@ open
       return 3;
     }
 
+    //
+    // Chunks are read through read_ahead_, in a helper thread if so
+    // requested. Should the thread be impossible to start, chunks will
+    // be read when needed, so the error code is ignored.
+    //
+
+    file_bytes_read_ = 0;
+
+    read_ahead_.attach(file_file_, file_size_);
+    if (prefetch_is_enabled_) read_ahead_.start(data_buffer_size_, false);
+
     //
     // Read as much bytes as possible (maximum: data_buffer_size_)
     // from the underlying binary file.
@@ -383,7 +411,9 @@ read_next_chunk
 
     // Read the underlying file.
 
-    bytes_read = fread(buffer_start_address, 1, bytes_to_read, file_file_);
+    bytes_read = read_ahead_.read(file_bytes_read_, buffer_start_address, bytes_to_read);
+
+    file_bytes_read_ += bytes_read;
 
     //
     // Check the number of bytes read. If it does not match the number of
@@ -399,7 +429,7 @@ read_next_chunk
     {
       // Check first the error status.
 
-      if (ferror(file_file_)) return 2;
+      if (read_ahead_.error()) return 2;
 
       //
       // Then, if the number of bytes read is exactly zero, we'll raise
@@ -415,9 +445,48 @@ read_next_chunk
 
     data_buffer_bytes_ = start_at + (int)bytes_read;
 
+    // Locate the tag delimiters in the whole buffer (see find_next_record_limits()).
+
+    delimiters_.scan(data_buffer_, data_buffer_bytes_);
+
     // That's all.
 
     return 0;
   }
 }
 
+int
+obs_e_based_file_reader_txt_forward::
+seek_epoch_boundary
+(long long offset)
+{
+  {
+    int read_status;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 3;
+
+    // The offset must lie inside the file.
+
+    if ((offset < 0) || (offset > file_size_)) return 1;
+
+    // The reader behaves now as if the file had just been open.
+
+    reset_read_state();
+
+    // Discard the contents of the buffer and refill it.
+
+    data_buffer_bytes_   = 0;
+    data_buffer_current_ = 0;
+    file_bytes_read_     = offset;
+
+    read_status = read_next_chunk(0);
+
+    if (read_status == 2) return 2;
+
+    // That's all.
+
+    return 0;
+  }
+}
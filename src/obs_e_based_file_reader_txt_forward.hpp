@@ -6,6 +6,7 @@
 #ifndef OBS_E_BASED_FILE_READER_TXT_FORWARD_HPP
 #define OBS_E_BASED_FILE_READER_TXT_FORWARD_HPP
 
+#include "astrolabe_text_scanner.hpp"
 #include "obs_e_based_file_reader_txt.hpp"
 
 /**
@@ -232,6 +233,18 @@ class obs_e_based_file_reader_txt_forward : public obs_e_based_file_reader_txt
      */
     virtual int  read_type                            (char& record_type) = 0;
 
+    /**
+     * @brief Position the reader at the beginning of an epoch.
+     *
+     * @param offset Offset in bytes of the first record of the epoch.
+     * @return Error code. See obs_e_based_file_reader::seek_epoch_boundary().
+     *
+     * Seeking to the end of the file is legal; the next read will report
+     * an end-of-file condition.
+     */
+
+    virtual int  seek_epoch_boundary                  (long long offset);
+
   protected:
 
     /**
@@ -297,6 +310,16 @@ class obs_e_based_file_reader_txt_forward : public obs_e_based_file_reader_txt
     /// "read") in the data buffer.
 
     int          data_buffer_current_;
+
+    /// @brief Offset in the file of the next byte to read into the data
+    /// buffer.
+
+    long long    file_bytes_read_;
+
+    /// @brief Positions of the '<' and '>' characters in the data buffer,
+    /// located every time it is loaded.
+
+    astrolabe_text_scanner delimiters_;
 };
 
 #endif // OBS_E_BASED_FILE_READER_TXT_FORWARD_HPP
@@ -0,0 +1,1258 @@
+/** \file obs_e_based_file_reader_txt_parallel.cpp
+  \brief Implementation file for obs_e_based_file_reader_txt_parallel.hpp
+  \ingroup ASTROLABE_data_IO
+*/
+#include "obs_e_based_file_reader_txt_parallel.hpp"
+
+int
+obs_e_based_file_reader_txt_parallel::
+close
+(void)
+{
+  {
+    // Do not complain if the file is already closed.
+
+    if (!file_is_open_) return 0;
+
+    // Stop the workers before closing the file; they may still be reading.
+
+    stop_workers();
+
+    // Close the file itself.
+
+    return obs_e_based_file_reader_txt::close();
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+decode_range
+(FILE*         file,
+ range_parser& parser,
+ text_range*   range)
+{
+  {
+    int size;
+
+    //
+    // Read the whole range at once. Note that ranges start at the opening
+    // tag of a record, so there's no need to look for record boundaries.
+    // An extra NULL character guarantees that parsing never goes beyond
+    // the data read.
+    //
+
+    size = (int)(range->end - range->begin);
+
+    range->raw.resize((size_t)size + 1);
+
+    if (astr_fseek(file, range->begin, SEEK_SET) != 0)                    return 2;
+    if (fread((void*)&range->raw[0], 1, (size_t)size, file) != (size_t)size) return 2;
+
+    range->raw[size] = 0;
+
+    // Parse its records.
+
+    return parser.decode(range, o_records_allowed_);
+  }
+}
+
+void
+obs_e_based_file_reader_txt_parallel::
+decode_ranges
+(void)
+{
+  {
+    FILE*              file;
+    int                index;
+    unique_lock<mutex> lock(ranges_mutex_, defer_lock);
+    int                max_index;
+    range_parser       parser;
+    text_range*        range;
+    text_range*        spare;
+    int                status;
+
+    // Every worker uses its own file handle, so reads never interfere.
+
+    file = fopen(file_name_, "rb");
+
+    lock.lock();
+
+    while (true)
+    {
+      //
+      // Wait until there's a range to parse and room to keep it. The
+      // number of parsed ranges waiting to be read is bounded.
+      //
+
+      while (true)
+      {
+        max_index = current_range_ + n_threads_in_use_ * _ASTROLABE_OBS_E_FILE_READER_RANGES_PER_THREAD;
+
+        if (stop_workers_)                                       break;
+        if (next_range_to_decode_ >= (int)ranges_.size())        break;
+        if (next_range_to_decode_ <  max_index)                  break;
+
+        range_released_.wait(lock);
+      }
+
+      if (stop_workers_)                                break;
+      if (next_range_to_decode_ >= (int)ranges_.size()) break;
+
+      // Claim the next range and parse it without holding the lock.
+
+      index = next_range_to_decode_;
+      next_range_to_decode_++;
+
+      range = ranges_[index];
+
+      //
+      // Reuse the memory of a range already read, if any. This saves a
+      // lot of allocations (and page faults) when reading big files.
+      //
+
+      if (spare_ranges_.size() > 0)
+      {
+        spare = spare_ranges_.back();
+        spare_ranges_.pop_back();
+
+        range->raw.swap(spare->raw);
+        range->records.swap(spare->records);
+        range->identifiers.swap(spare->identifiers);
+        range->doubles.swap(spare->doubles);
+        range->ints.swap(spare->ints);
+
+        delete spare;
+      }
+
+      lock.unlock();
+
+      if (file == NULL)
+      {
+        status = 2;
+      }
+      else
+      {
+        try
+        {
+          status = decode_range(file, parser, range);
+        }
+        catch (...)
+        {
+          status = 2; // Not enough memory.
+        }
+      }
+
+      // Publish the result.
+
+      lock.lock();
+
+      range->status  = status;
+      range->decoded = true;
+
+      range_decoded_.notify_all();
+    }
+
+    lock.unlock();
+
+    if (file != NULL) fclose(file);
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+find_record_start
+(long long  position,
+ long long& start)
+{
+  {
+    vector<char> block;
+    int          block_bytes;
+    long long    candidate;
+    char         chr;
+    int          i;
+
+    //
+    // Records start with a '<' followed (maybe after some whitespace) by
+    // anything but a '/', which would make it a closing tag. Read the file
+    // in small blocks until such a '<' is found. Note that the whitespace
+    // after a '<' may span two blocks.
+    //
+
+    block.resize(_ASTROLABE_OBS_E_FILE_READER_RESYNC_BLOCK_SIZE);
+
+    candidate = -1;
+
+    if (astr_fseek(file_file_, position, SEEK_SET) != 0) return 5;
+
+    while (position < file_size_)
+    {
+      block_bytes = _ASTROLABE_OBS_E_FILE_READER_RESYNC_BLOCK_SIZE;
+      if (file_size_ - position < block_bytes) block_bytes = (int)(file_size_ - position);
+
+      if (fread((void*)&block[0], 1, (size_t)block_bytes, file_file_) != (size_t)block_bytes) return 5;
+
+      for (i = 0; i < block_bytes; i++)
+      {
+        chr = block[i];
+
+        if (candidate >= 0)
+        {
+          if (is_whitespace(chr)) continue;
+
+          if (chr != '/')
+          {
+            // Found!
+
+            start = candidate;
+            return 0;
+          }
+
+          // Just a closing tag. Keep looking.
+
+          candidate = -1;
+        }
+        else if (chr == '<')
+        {
+          candidate = position + i;
+        }
+      }
+
+      position += block_bytes;
+    }
+
+    // No more records.
+
+    start = file_size_;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+get_number_of_threads
+(void)
+const
+{
+  {
+    if (file_is_open_) return n_threads_in_use_;
+
+    return n_threads_;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+next_record
+(void)
+{
+  {
+    unique_lock<mutex> lock(ranges_mutex_, defer_lock);
+    text_range*        range;
+
+    while (true)
+    {
+      if (current_range_ >= (int)ranges_.size()) return 1;
+
+      range = ranges_[current_range_];
+
+      // Wait for the range to be parsed, if not done yet.
+
+      if (!current_range_ready_)
+      {
+        lock.lock();
+        while (!range->decoded) range_decoded_.wait(lock);
+        lock.unlock();
+
+        current_range_ready_ = true;
+      }
+
+      // Still more records in this range?
+
+      if (current_record_ < (int)range->records.size()) return 0;
+
+      //
+      // No more records. If the parsing stopped because of an error,
+      // now it's the moment to report it.
+      //
+
+      if (range->status != 0) return range->status;
+
+      //
+      // Release the range, leaving room for the workers to parse another
+      // one. Its memory will be reused.
+      //
+
+      range->raw.clear();
+      range->records.clear();
+      range->identifiers.clear();
+      range->doubles.clear();
+      range->ints.clear();
+
+      lock.lock();
+
+      ranges_[current_range_] = NULL;
+      current_range_++;
+
+      try
+      {
+        spare_ranges_.push_back(range);
+      }
+      catch (...)
+      {
+        delete range;
+      }
+
+      range_released_.notify_all();
+
+      lock.unlock();
+
+      current_record_      = 0;
+      current_range_ready_ = false;
+    }
+  }
+}
+
+obs_e_based_file_reader_txt_parallel::
+obs_e_based_file_reader_txt_parallel
+(void)
+{
+  {
+    current_range_        = 0;
+    current_range_ready_  = false;
+    current_record_       = 0;
+    next_range_to_decode_ = 0;
+    n_threads_            = 0;
+    n_threads_in_use_     = 0;
+    o_records_allowed_    = true;
+    stop_workers_         = false;
+  }
+}
+
+obs_e_based_file_reader_txt_parallel::
+~obs_e_based_file_reader_txt_parallel
+(void)
+{
+  {
+    // The workers must be stopped before our members are destroyed.
+
+    stop_workers();
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+open
+(const char*  file_name)
+{
+  {
+    vector<long long> boundaries;
+    int               i;
+    long long         position;
+    text_range*       range;
+    long long         start;
+    int               status;
+
+    // Won't accept open requests if the file is already open.
+
+    if (file_is_open_) return 1;
+
+    // Try to open the file.
+
+    file_file_ = fopen(file_name, "rb");
+
+    if (file_file_ == NULL) return 2;
+
+    // Ascertain how big is the file.
+
+    file_size_ = astr_fsize(file_file_);
+
+    if (file_size_ < 0)
+    {
+      fclose(file_file_);
+      return 5; // I/O error.
+    }
+
+    if (file_size_ == 0)
+    {
+      fclose(file_file_);
+      return 4; // Empty file.
+    }
+
+    // From now on, close() takes care of the clean up.
+
+    file_is_open_ = true;
+    file_name_    = strdup(file_name);
+
+    reset_read_state();
+
+    current_range_        = 0;
+    current_range_ready_  = false;
+    current_record_       = 0;
+    next_range_to_decode_ = 0;
+    stop_workers_         = false;
+
+    // Split the file into ranges of whole records.
+
+    try
+    {
+      //
+      // Every range ends where the first record starting at least
+      // data_buffer_size_ bytes after its beginning does.
+      //
+
+      boundaries.push_back(0);
+
+      position = data_buffer_size_;
+
+      while (position < file_size_)
+      {
+        status = find_record_start(position, start);
+
+        if (status != 0)
+        {
+          close();
+          return status;
+        }
+
+        if (start >= file_size_) break;
+
+        boundaries.push_back(start);
+
+        position = start + data_buffer_size_;
+      }
+
+      boundaries.push_back(file_size_);
+
+      for (i = 1; i < (int)boundaries.size(); i++)
+      {
+        range            = new text_range();
+        range->begin     = boundaries[i - 1];
+        range->end       = boundaries[i];
+        range->decoded   = false;
+        range->status    = 0;
+
+        ranges_.push_back(range);
+      }
+    }
+    catch (...)
+    {
+      close();
+      return 3;
+    }
+
+    // Start the workers. There's no point in having more workers than ranges.
+
+    n_threads_in_use_ = n_threads_;
+
+    if (n_threads_in_use_ == 0) n_threads_in_use_ = (int)thread::hardware_concurrency();
+    if (n_threads_in_use_ <= 0) n_threads_in_use_ = 1;
+
+    if (n_threads_in_use_ > (int)ranges_.size()) n_threads_in_use_ = (int)ranges_.size();
+
+    try
+    {
+      for (i = 0; i < n_threads_in_use_; i++)
+      {
+        workers_.push_back(thread(&obs_e_based_file_reader_txt_parallel::decode_ranges, this));
+      }
+    }
+    catch (...)
+    {
+      close();
+      return 7;
+    }
+
+    // Successful completion.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+read_l_data
+(int      n_tag_values,
+ double*& the_tags,
+ int      n_expectation_values,
+ double*& the_expectations,
+ int&     n_covariance_values_found,
+ double*& the_covariance_values)
+{
+  {
+    astrolabe_double_view covariances;
+    astrolabe_double_view expectations;
+    int                   status;
+    astrolabe_double_view tags;
+
+    // Locate the values, checking everything, and copy them.
+
+    status = read_l_data_view(n_tag_values,              tags,
+                              n_expectation_values,      expectations,
+                              n_covariance_values_found, covariances);
+
+    if (status != 0) return status;
+
+    tags.copy_to        (the_tags);
+    expectations.copy_to(the_expectations);
+    covariances.copy_to (the_covariance_values);
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+read_l_data_view
+(int                    n_tag_values,
+ astrolabe_double_view& the_tags,
+ int                    n_expectation_values,
+ astrolabe_double_view& the_expectations,
+ int&                   n_covariance_values_found,
+ astrolabe_double_view& the_covariance_values)
+{
+  {
+    int          n;
+    text_range*  range;
+    text_record* record;
+    double*      values;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only when the time
+    // tag has been read and we are reading an l-type record.
+    //
+
+    if (!read_time_)               return 3;
+    if ( read_completed_)          return 3;
+    if (!reading_l_)               return 3;
+
+    if (n_tag_values < 0)          return 6;
+    if (n_expectation_values <= 0) return 6;
+
+    range  = ranges_[current_range_];
+    record = &range->records[current_record_];
+
+    //
+    // All the values in the record have already been parsed. Those that
+    // are not tags nor expectations are the covariance values. Report
+    // problems exactly as obs_e_based_file_reader_txt::read_l_data() does:
+    // first, missing (or invalid) tags and expectations...
+    //
+
+    if (record->n_values < n_tag_values + n_expectation_values) return 4;
+
+    // ... then an illegal number of covariance values...
+
+    n_covariance_values_found = record->n_values - n_tag_values - n_expectation_values;
+
+    n = n_expectation_values;
+
+    if ((n_covariance_values_found != 0) &
+        (n_covariance_values_found != n) &
+        (n_covariance_values_found != ((n * (n + 1)) / 2))) return 7;
+
+    // ... and finally, garbage after the last value.
+
+    if (!record->closing_is_valid) return 5;
+
+    // Publish the views.
+
+    values = &range->doubles[record->values_offset];
+
+    the_tags.set             (values,                                       n_tag_values);
+    the_expectations.set     (values + n_tag_values,                        n_expectation_values);
+    the_covariance_values.set(values + n_tag_values + n_expectation_values, n_covariance_values_found);
+
+    // We're done with this record.
+
+    record_completed();
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+read_o_data
+(int   n_parameter_iids,
+ int*& the_parameter_iids,
+ int   n_observation_iids,
+ int*& the_observation_iids,
+ int   n_instrument_iids,
+ int*& the_instrument_iids)
+{
+  {
+    astrolabe_int_view instruments;
+    astrolabe_int_view observations;
+    astrolabe_int_view parameters;
+    int                status;
+
+    // Locate the values, checking everything, and copy them.
+
+    status = read_o_data_view(n_parameter_iids,   parameters,
+                              n_observation_iids, observations,
+                              n_instrument_iids,  instruments);
+
+    if (status != 0) return status;
+
+    parameters.copy_to  (the_parameter_iids);
+    observations.copy_to(the_observation_iids);
+    instruments.copy_to (the_instrument_iids);
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+read_o_data_view
+(int                 n_parameter_iids,
+ astrolabe_int_view& the_parameter_iids,
+ int                 n_observation_iids,
+ astrolabe_int_view& the_observation_iids,
+ int                 n_instrument_iids,
+ astrolabe_int_view& the_instrument_iids)
+{
+  {
+    int          n_iids;
+    text_range*  range;
+    text_record* record;
+    int*         values;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only when the time
+    // tag has been read and we are reading an o-type record.
+    //
+
+    if (!read_time_)      return 3;
+    if ( read_completed_) return 3;
+    if (!reading_o_)      return 3;
+
+    // More preconditions: sizes of the output instance identifier arrays.
+
+    if (n_parameter_iids   <= 0) return 6;
+    if (n_observation_iids <= 0) return 6;
+    if (n_instrument_iids  <  0) return 6;
+
+    range  = ranges_[current_range_];
+    record = &range->records[current_record_];
+
+    //
+    // All the identifiers in the record have already been parsed. Fewer
+    // than requested means that some were not valid integers; more, that
+    // there's something else than the closing o-tag after the last one.
+    //
+
+    n_iids = n_parameter_iids + n_observation_iids + n_instrument_iids;
+
+    if (record->n_values < n_iids)   return 4;
+    if (record->n_values > n_iids)   return 5;
+    if (!record->closing_is_valid)   return 5;
+
+    // Publish the views.
+
+    values = &range->ints[record->values_offset];
+
+    the_parameter_iids.set  (values,                                         n_parameter_iids);
+    the_observation_iids.set(values + n_parameter_iids,                      n_observation_iids);
+    the_instrument_iids.set (values + n_parameter_iids + n_observation_iids, n_instrument_iids);
+
+    // We're done with this record.
+
+    record_completed();
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+read_time
+(double& time)
+{
+  {
+    text_record* record;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only in the following
+    // situations:
+    //
+    //   - if reading an l-type record, the instance identifier and no other further
+    //     component of the record must have been read.
+    //   - if reading an o-type record, the identifier and no other further component
+    //     of the record must have been read.
+    //
+
+    if (reading_l_)
+    {
+      if (!read_iid_)        return 3;
+      if ( read_l_data_)     return 3;
+    }
+    else // reading_o_
+    {
+      if (!read_identifier_) return 3;
+      if ( read_o_data_)     return 3;
+    }
+
+    // Get the time, already parsed.
+
+    record = &ranges_[current_range_]->records[current_record_];
+
+    if (!record->time_is_valid)
+    {
+      // The characters found do not represent a legal double value.
+      return 4;
+    }
+
+    time = record->time;
+
+    read_time_ = true;
+
+    //
+    // Update last time / epoch related flags and values, exactly as
+    // sequential readers do. Inactive records do not change the status
+    // of the reader concerning epochs.
+    //
+
+    if (last_record_is_active_)
+    {
+      if (last_epoch_time_available_)
+      {
+        if (last_epoch_time_ != time)
+        {
+          last_epoch_changed_      = true;
+          last_epoch_time_         = time;
+        }
+        else
+        {
+          last_epoch_changed_      = false;
+        }
+      }
+      else
+      {
+        last_epoch_changed_        = false;
+        last_epoch_time_           = time;
+        last_epoch_time_available_ = true;
+      }
+
+      // Whenever the epoch changes, we "loose" our first l-record.
+
+      if (last_epoch_changed_) first_l_read_ = false;
+
+      //
+      // Check that when reading an o-record a previous l-record has
+      // been obtained.
+      //
+
+      if ((last_epoch_changed_) || (reading_first_epoch_))
+      {
+        if (reading_o_)
+        {
+          if (!first_l_read_) return 5; // o-records may not start an epoch.
+        }
+        else // reading an l-record.
+        {
+          if (!first_l_read_) first_l_read_ = true;
+        }
+      }
+
+      // If the epoch changes, we will no more be reading the first one.
+
+      if (last_epoch_changed_) reading_first_epoch_ = false;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+read_type
+(char& record_type)
+{
+  {
+    text_range*  range;
+    text_record* record;
+    int          status;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only if no other
+    // read operation is on its way.
+    //
+
+    if (!read_completed_) return 3;
+
+    // Move to the next record, waiting for the workers if needed.
+
+    status = next_record();
+
+    if (status == 1)
+    {
+      // Legal end of file.
+
+      is_eof_ = true;
+      return 1;
+    }
+    else if (status == 5)
+    {
+      // Illegal end of file (file corrupted / malformed).
+
+      is_eof_ = true;
+      return 5;
+    }
+    else if (status != 0)
+    {
+      return status;
+    }
+
+    range  = ranges_[current_range_];
+    record = &range->records[current_record_];
+
+    //
+    // The contents of the opening tag are retrieved by the methods in
+    // obs_e_based_file_reader_txt (read_active_flag(), read_identifier()
+    // and read_instance_id()), so store them where these expect them.
+    //
+
+    last_record_is_active_   = record->active;
+    last_record_instance_id_ = record->iid;
+
+    set_last_record_identifier(&range->identifiers[record->id_offset]);
+
+    // Get the type and set flags accordingly.
+
+    record_type = record->type;
+
+    if (record_type == 'o')
+    {
+      reading_o_ = true;
+      reading_l_ = false;
+    }
+    else
+    {
+      reading_o_ = false;
+      reading_l_ = true;
+    }
+
+    read_completed_        = false;
+    read_type_             = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+void
+obs_e_based_file_reader_txt_parallel::
+record_completed
+(void)
+{
+  {
+    // Reset the flags controlling the reading process and move to the next record.
+
+    read_type_             = false;
+    read_active_flag_      = false;
+    read_identifier_       = false;
+    read_iid_              = false;
+    read_time_             = false;
+    read_l_data_           = false;
+    read_o_data_           = false;
+    reading_l_             = false;
+    reading_o_             = false;
+    read_completed_        = true;
+
+    current_record_++;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::
+set_number_of_threads
+(int n_threads)
+{
+  {
+    // If the file is already open, it's not legal to change the number of threads.
+
+    if (file_is_open_) return 1;
+
+    // Zero means "as many as cores".
+
+    if (n_threads < 0) return 2;
+
+    n_threads_ = n_threads;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+void
+obs_e_based_file_reader_txt_parallel::
+stop_workers
+(void)
+{
+  {
+    int                i;
+    unique_lock<mutex> lock(ranges_mutex_, defer_lock);
+
+    // Tell the workers to finish and wake them up.
+
+    lock.lock();
+
+    stop_workers_ = true;
+
+    range_released_.notify_all();
+    range_decoded_.notify_all();
+
+    lock.unlock();
+
+    // Wait for them.
+
+    for (i = 0; i < (int)workers_.size(); i++)
+    {
+      if (workers_[i].joinable()) workers_[i].join();
+    }
+
+    workers_.clear();
+
+    // Discard all the ranges still alive.
+
+    for (i = 0; i < (int)ranges_.size(); i++)
+    {
+      if (ranges_[i] != NULL) delete ranges_[i];
+    }
+
+    ranges_.clear();
+
+    for (i = 0; i < (int)spare_ranges_.size(); i++) delete spare_ranges_[i];
+
+    spare_ranges_.clear();
+
+    current_range_        = 0;
+    current_range_ready_  = false;
+    current_record_       = 0;
+    next_range_to_decode_ = 0;
+  }
+}
+
+//
+// Parser of the records in a range, used by the worker threads.
+//
+
+obs_e_based_file_reader_txt_parallel::range_parser::
+range_parser
+(void)
+{
+  {
+    buffer_         = NULL;
+    cur_record_cur_ = -1;
+    cur_record_end_ = -1;
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::range_parser::
+decode
+(text_range* range,
+ bool        o_records_allowed)
+{
+  {
+    int  end;
+    int  i;
+    int  k;
+    int  n;
+    bool opening_found;
+    int  size;
+    int  start;
+    int  status;
+    int  total_found;
+
+    range->records.clear();
+    range->identifiers.clear();
+    range->doubles.clear();
+    range->ints.clear();
+
+    //
+    // Parse directly from the bytes of the range (the last one is the
+    // extra NULL character, not part of the data).
+    //
+
+    size    = (int)range->raw.size() - 1;
+    buffer_ = &range->raw[0];
+
+    delimiters_.scan(buffer_, size);
+
+    n = delimiters_.n_delimiters();
+    k = 0;
+
+    while (true)
+    {
+      //
+      // Find the limits of the next record as sequential readers do: it
+      // starts at the first '<' and ends at the second '>'.
+      //
+
+      opening_found = false;
+      start         = -1;
+      end           = -1;
+      total_found   = 0;
+
+      for (; k < n; k++)
+      {
+        i = delimiters_.delimiter(k);
+
+        if (buffer_[i] == '<')
+        {
+          if (!opening_found) start = i;
+          opening_found = true;
+        }
+        else
+        {
+          // A '>' before any '<' can't belong to a legal record.
+
+          if (!opening_found) return 4;
+
+          total_found ++;
+          if (total_found == 2)
+          {
+            end = i;
+            k++;
+            break;
+          }
+        }
+      }
+
+      //
+      // No complete record left. If part of one was found, the range (and
+      // therefore the file, since ranges end where a record starts) ends
+      // abruptly.
+      //
+
+      if (total_found < 2)
+      {
+        if (opening_found) return 5; // Unexpected end of file.
+
+        return 0; // Legal end of the range.
+      }
+
+      cur_record_end_ = end;
+      cur_record_cur_ = start;
+
+      status = parse_record(range, o_records_allowed);
+      if (status != 0) return status;
+    }
+  }
+}
+
+int
+obs_e_based_file_reader_txt_parallel::range_parser::
+parse_record
+(text_range* range,
+ bool        o_records_allowed)
+{
+  {
+    string      att_name;
+    int         att_search_end;
+    int         att_search_start;
+    string      att_value;
+    const char* cchr;
+    const char* cchr_end;
+    double      dval;
+    int         instance_id;
+    int         ival;
+    int         len;
+    text_record record;
+    int         status;
+    int         total_att;
+    char        typ;
+
+    //
+    // buffer_[cur_record_cur_] is the opening '<'. Get the record
+    // type, skipping any whitespace written inside the record tag.
+    //
+
+    cur_record_cur_ ++;
+
+    typ = buffer_[cur_record_cur_];
+
+    while (astr_is_whitespace(typ))
+    {
+      cur_record_cur_++;
+      typ = buffer_[cur_record_cur_];
+    }
+
+    cur_record_cur_++;
+    att_search_start = cur_record_cur_;
+
+    // Check that a correct type tag has been read.
+
+    if (typ == 'o')
+    {
+      if (!o_records_allowed) return 4;
+    }
+    else if (typ != 'l')
+    {
+      return 4;
+    }
+
+    record.type = typ;
+
+    //
+    // Move beyond the closing '>' in the opening record tag. The attributes
+    // lie before it.
+    //
+
+    while (buffer_[cur_record_cur_] != '>') cur_record_cur_++;
+
+    att_search_end = cur_record_cur_ - 1;
+
+    cur_record_cur_ ++;
+
+    //
+    // Parse the attributes: id (mandatory) and s (optional) in both kinds
+    // of records, plus n (mandatory) in l-records.
+    //
+
+    status = astr_parse_attributes(buffer_, att_search_start, att_search_end, cur_record_attributes_);
+    if (status != 0) return 4;
+
+    total_att = (int)cur_record_attributes_.size();
+
+    // The s attribute. If not present, the record is active.
+
+    record.active = true;
+
+    att_name  = "s";
+    att_value = cur_record_attributes_[att_name];
+
+    if (att_value != "")
+    {
+      total_att --;
+
+      if      (att_value == "r") record.active = false;
+      else if (att_value == "a") record.active = true;
+      else                       return 4;
+    }
+
+    // The id attribute, stored with its ending NULL character.
+
+    att_name  = "id";
+    att_value = cur_record_attributes_[att_name];
+
+    if (att_value == "") return 4;
+
+    total_att --;
+
+    record.id_offset = (int)range->identifiers.size();
+    range->identifiers.insert(range->identifiers.end(), att_value.c_str(), att_value.c_str() + att_value.size() + 1);
+
+    // The n attribute (an integer), in l-records only.
+
+    record.iid = 0;
+
+    if (typ == 'l')
+    {
+      att_name  = "n";
+      att_value = cur_record_attributes_[att_name];
+
+      if (att_value == "") return 4;
+
+      total_att --;
+
+      len  = (int)att_value.size();
+      cchr = att_value.c_str();
+
+      if (astr_parse_int(cchr, cchr + len, instance_id, &cchr_end) != 0) return 4;
+      if (cchr_end != (cchr + len)) return 4;
+
+      record.iid = instance_id;
+    }
+
+    // No other attributes are allowed.
+
+    if (total_att != 0) return 4;
+
+    //
+    // The time tag. Should it be invalid, read_time() will report it, so
+    // the rest of the record is of no interest.
+    //
+
+    record.time_is_valid    = (astr_parse_double_value(buffer_, cur_record_cur_, cur_record_end_, record.time) == 0);
+    record.n_values         = 0;
+    record.closing_is_valid = false;
+
+    //
+    // All the values after the time tag, until something else is found
+    // (hopefully, the closing tag).
+    //
+
+    if (typ == 'l')
+    {
+      record.values_offset = (int)range->doubles.size();
+
+      if (record.time_is_valid)
+      {
+        while (astr_parse_double_value(buffer_, cur_record_cur_, cur_record_end_, dval) == 0)
+        {
+          range->doubles.push_back(dval);
+          record.n_values++;
+        }
+
+        record.closing_is_valid = (astr_parse_closing_tag(buffer_, cur_record_cur_, cur_record_end_, "</l>", "</L>") == 0);
+      }
+    }
+    else
+    {
+      record.values_offset = (int)range->ints.size();
+
+      if (record.time_is_valid)
+      {
+        while (astr_parse_int_value(buffer_, cur_record_cur_, cur_record_end_, ival) == 0)
+        {
+          range->ints.push_back(ival);
+          record.n_values++;
+        }
+
+        record.closing_is_valid = (astr_parse_closing_tag(buffer_, cur_record_cur_, cur_record_end_, "</o>", "</O>") == 0);
+      }
+    }
+
+    // The record is complete.
+
+    range->records.push_back(record);
+
+    // That's all.
+
+    return 0;
+  }
+}
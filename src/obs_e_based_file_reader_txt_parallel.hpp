@@ -0,0 +1,530 @@
+/** \file obs_e_based_file_reader_txt_parallel.hpp
+  \brief Class defining the interface of multithreaded obs_e_based text file readers.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef OBS_E_BASED_FILE_READER_TXT_PARALLEL_HPP
+#define OBS_E_BASED_FILE_READER_TXT_PARALLEL_HPP
+
+#include "astrolabe_text_scanner.hpp"
+#include "obs_e_based_file_reader_txt.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/// @brief Size of the blocks read when looking for the start of a record
+/// at the boundaries of the ranges: 64 Kbyte (64 * 1024 bytes)
+
+#define _ASTROLABE_OBS_E_FILE_READER_RESYNC_BLOCK_SIZE 65536
+
+#ifndef _ASTROLABE_OBS_E_FILE_READER_RANGES_PER_THREAD
+
+/// @brief Number of ranges that every worker thread may keep decoded
+/// ahead of the consumer.
+
+#define _ASTROLABE_OBS_E_FILE_READER_RANGES_PER_THREAD 2
+
+#endif
+
+/**
+ * @brief Class defining the interface of multithreaded obs_e_based text file readers.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * This class implements the interface defined in parent class
+ * obs_e_based_file_reader_txt, reading obs_e_based files stored in text
+ * format in forward direction, as obs_e_based_file_reader_txt_forward
+ * descendants do. The difference is that the file is parsed by a pool of
+ * worker threads.
+ *
+ * When the file is opened, it is split into byte ranges of the size set
+ * with set_buffer_size(). The boundary between two ranges is then moved
+ * forward to the start of the next record, that is, to the next '<' not
+ * followed by a '/' (the start of an opening l- or o-tag), so every range
+ * holds whole records. Only a small block is read at each boundary to
+ * find it.
+ *
+ * Worker threads read ranges, using their own file handles, and parse
+ * them completely with the routines in obs_e_based_file_reader_txt. Since
+ * the number of tags and expectations in an l-record (or of instance
+ * identifiers in an o-record) is not known until read_l_data() or
+ * read_o_data() are called, all the values in a record are converted in
+ * a row; these methods just split them as requested. Records and epochs
+ * are delivered in the same order, with the same epoch semantics and
+ * error codes, than those of the sequential readers. At most
+ * _ASTROLABE_OBS_E_FILE_READER_RANGES_PER_THREAD ranges per thread are
+ * kept parsed ahead of the reader, so memory usage is bounded no matter
+ * the size of the file. Worker threads already read the file ahead of the
+ * consumer, so set_prefetch() has no effect on this reader.
+ *
+ * Descendant classes state which kinds of records are legal in their
+ * files (see o_records_allowed_).
+ *
+ * The reader object itself must be used from a single thread; the
+ * synchronization with the worker threads is internal.
+ */
+
+class obs_e_based_file_reader_txt_parallel : public obs_e_based_file_reader_txt
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                 obs_e_based_file_reader_txt_parallel  (void);
+
+    /**
+     * @brief Destructor
+     */
+
+    virtual      ~obs_e_based_file_reader_txt_parallel (void);
+
+    /**
+     * @brief Closes the file reader, disabling any other
+     *        further action on it.
+     * @return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: Error closing the file.
+     *
+     * Worker threads are stopped and all the parsed data is discarded.
+     */
+
+    virtual int  close                                (void);
+
+    /**
+     * @brief Retrieve the number of worker threads in use or requested.
+     * @return Once the file is open, the number of worker threads actually
+     *         in use. Otherwise, the number of threads requested using
+     *         set_number_of_threads() (0 meaning "as many as cores").
+     */
+
+    virtual int  get_number_of_threads                (void) const;
+
+    /**
+     * @brief Opens the reader, enabling I/O operations.
+     *
+     * @param file_name Name of the file to read.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file was already open.
+     *        - 2: Unable to open the selected file.
+     *        - 3: Not enough memory to allocate the internal structures.
+     *        - 4: End of file condition detected - the file is empty.
+     *        - 5: I/O error detected while reading the file.
+     *        - 6: NOT USED.
+     *        - 7: Unable to start the worker threads.
+     *
+     * The file is split into ranges of whole records (see the class
+     * description) and the worker threads are started, so parsing begins
+     * right away.
+     */
+
+    virtual int  open                                 (const char* file_name);
+
+    /**
+     * @brief Read the tags, expectations and covariance
+     *        matrix values in an l-record.
+     *
+     * @return Error code. The same ones returned by
+     *         obs_e_based_file_reader_txt::read_l_data(), plus 2 when
+     *         the file has not been opened.
+     *
+     * See obs_e_based_file_reader_txt::read_l_data() for a description
+     * of the parameters.
+     */
+
+    virtual int  read_l_data                          (int      n_tag_values,
+                                                       double*& the_tags,
+                                                       int      n_expectation_values,
+                                                       double*& the_expectations,
+                                                       int&     n_covariance_values_found,
+                                                       double*& the_covariance_values);
+
+    /**
+     * @brief Read the tags, expectations and covariance
+     *        matrix values in an l-record without copying them.
+     *
+     * @return Error code. The same ones returned by read_l_data().
+     *
+     * The views point to the values parsed by the worker threads, which
+     * are kept until the next call to read_type().
+     */
+
+    virtual int  read_l_data_view                     (int                    n_tag_values,
+                                                       astrolabe_double_view& the_tags,
+                                                       int                    n_expectation_values,
+                                                       astrolabe_double_view& the_expectations,
+                                                       int&                   n_covariance_values_found,
+                                                       astrolabe_double_view& the_covariance_values);
+
+    /**
+     * @brief Read the lists of parameter, observation and instrument instance
+     *        identifiers from an o-record.
+     *
+     * @return Error code. The same ones returned by
+     *         observation_file_reader_txt_forward::read_o_data(), plus 2
+     *         when the file has not been opened. Files not accepting
+     *         o-records always return 3.
+     *
+     * See obs_e_based_file_reader_txt::read_o_data() for a description
+     * of the parameters.
+     */
+
+    virtual int  read_o_data                          (int   n_parameter_iids,
+                                                       int*& the_parameter_iids,
+                                                       int   n_observation_iids,
+                                                       int*& the_observation_iids,
+                                                       int   n_instrument_iids,
+                                                       int*& the_instrument_iids);
+
+    /**
+     * @brief Read the lists of parameter, observation and instrument instance
+     *        identifiers from an o-record without copying them.
+     *
+     * @return Error code. The same ones returned by read_o_data().
+     *
+     * The views point to the values parsed by the worker threads, which
+     * are kept until the next call to read_type().
+     */
+
+    virtual int  read_o_data_view                     (int                 n_parameter_iids,
+                                                       astrolabe_int_view& the_parameter_iids,
+                                                       int                 n_observation_iids,
+                                                       astrolabe_int_view& the_observation_iids,
+                                                       int                 n_instrument_iids,
+                                                       astrolabe_int_view& the_instrument_iids);
+
+    /**
+     * @brief Read the time tag, either for l- or o-records.
+     *
+     * @param time The time tag.
+     * @return Error code. The same ones returned by
+     *         obs_e_based_file_reader_txt::read_time(), plus 2 when
+     *         the file has not been opened.
+     */
+
+    virtual int  read_time                            (double& time);
+
+    /**
+     * @brief Read the event record type.
+     *
+     * @param record_type The type of the record being read, either an 'l' or
+     *        an 'o' (both lowercase).
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: End-of-file (no more data).
+     *         - 2: I/O error while reading (might happen if the file
+     *              has not been opened).
+     *         - 3: Invalid call sequence.
+     *         - 4: Malformed record found.
+     *         - 5: Unexpected end of file. Invalid file.
+     *
+     * If the range holding the next record is still being parsed, this
+     * method waits for it. Errors found by the worker threads when
+     * parsing a range are reported once all the records preceding the
+     * wrong one have been delivered.
+     *
+     * See obs_e_based_file_reader_txt::read_type().
+     */
+
+    virtual int  read_type                            (char& record_type);
+
+    /**
+     * @brief Set the number of worker threads.
+     *
+     * @param n_threads Number of worker threads. Zero means as many as
+     *        cores are available.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The file is already open.
+     *         - 2: Invalid number of threads (negative).
+     *
+     * This method may be called only before open(). If not called, the
+     * number of threads is set after the number of cores.
+     */
+
+    virtual int  set_number_of_threads                (int n_threads);
+
+  protected:
+
+    /// @brief A parsed record.
+
+    struct text_record
+    {
+      /// @brief Type of the record ('l' or 'o').
+
+      char           type;
+
+      /// @brief Active flag.
+
+      bool           active;
+
+      /// @brief Offset of the identifier (NULL terminated) in the
+      /// identifiers of the range.
+
+      int            id_offset;
+
+      /// @brief Instance identifier (l-records only).
+
+      int            iid;
+
+      /// @brief Time tag.
+
+      double         time;
+
+      /// @brief Flag. When false, the time tag is not a valid double.
+
+      bool           time_is_valid;
+
+      /// @brief Offset of the first value in the doubles (l-records)
+      /// or ints (o-records) of the range.
+
+      int            values_offset;
+
+      /// @brief Number of values found after the time tag.
+
+      int            n_values;
+
+      /// @brief Flag. When false, the values are followed by something
+      /// else than whitespace and a legal closing tag.
+
+      bool           closing_is_valid;
+    };
+
+    /// @brief A range of consecutive records and, once parsed, its contents.
+
+    struct text_range
+    {
+      /// @brief Offset in the file of the first byte in the range.
+
+      long long            begin;
+
+      /// @brief Offset in the file of the byte following the range.
+
+      long long            end;
+
+      /// @brief True once a worker thread has processed the range.
+
+      bool                 decoded;
+
+      /// @brief Status of the parsing (0, or an error code for read_type()).
+
+      int                  status;
+
+      /// @brief The bytes in the range, as read from the file.
+
+      vector<char>         raw;
+
+      /// @brief The records found, up to the first error, if any.
+
+      vector<text_record>  records;
+
+      /// @brief The identifiers of the records, one after the other.
+
+      vector<char>         identifiers;
+
+      /// @brief The values in the l-records, one record after the other.
+
+      vector<double>       doubles;
+
+      /// @brief The values in the o-records, one record after the other.
+
+      vector<int>          ints;
+    };
+
+    /**
+     * @brief Parser of the records in a range.
+     *
+     * Worker threads may not share the parsing state of the reader, so
+     * each one uses its own parser, which runs the same parsing routines
+     * sequential readers do (see astrolabe_record_parser.hpp) on the bytes
+     * of a range instead of on the data buffer of a file.
+     */
+
+    class range_parser
+    {
+      public:
+
+        /**
+         * @brief Default constructor.
+         */
+
+                     range_parser  (void);
+
+        /**
+         * @brief Parse all the records in a range.
+         *
+         * @param range The range to parse. Its raw bytes must have been
+         *        read, followed by an extra NULL character.
+         * @param o_records_allowed When false, o-records are malformed.
+         * @return The status of the range: 0 if it was parsed successfully,
+         *         or 4 (malformed record) or 5 (unexpected end of file),
+         *         as read_type() would report them.
+         */
+
+        int          decode        (text_range* range,
+                                    bool        o_records_allowed);
+
+      protected:
+
+        /**
+         * @brief Parse the record in the current record limits.
+         *
+         * @param range The range being parsed.
+         * @param o_records_allowed When false, o-records are malformed.
+         * @return 0 if the record is legal, 4 otherwise.
+         */
+
+        int          parse_record  (text_range* range,
+                                    bool        o_records_allowed);
+
+      protected:
+
+        /// @brief The bytes of the range being parsed.
+
+        const char*            buffer_;
+
+        /// @brief Attributes in the opening tag of the current record.
+
+        map<string, string>    cur_record_attributes_;
+
+        /// @brief Current position in buffer_ when parsing a record.
+
+        int                    cur_record_cur_;
+
+        /// @brief Last position in buffer_ of the current record.
+
+        int                    cur_record_end_;
+
+        /// @brief Positions of the tag delimiters in the range.
+
+        astrolabe_text_scanner delimiters_;
+    };
+
+    /**
+     * @brief Parse a range of records.
+     *
+     * @param file The file to read from (owned by the calling worker).
+     * @param parser The parser of the calling worker.
+     * @param range The range to parse.
+     * @return The status of the range: 0 if it was parsed successfully,
+     *         or 2 (I/O error), 4 (malformed record) or 5 (unexpected end
+     *         of file), as read_type() would report them.
+     */
+
+    int          decode_range                         (FILE*         file,
+                                                       range_parser& parser,
+                                                       text_range*   range);
+
+    /**
+     * @brief Body of the worker threads.
+     *
+     * Claims and parses ranges, in order, as long as the number of
+     * parsed ranges waiting to be read stays within limits.
+     */
+
+    void         decode_ranges                        (void);
+
+    /**
+     * @brief Find the first record starting at or after a given position.
+     *
+     * @param position Offset in the file where the search starts.
+     * @param start On output, the offset of the '<' opening the record,
+     *        or the size of the file if there are no more records.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 5: I/O error.
+     */
+
+    int          find_record_start                    (long long  position,
+                                                       long long& start);
+
+    /**
+     * @brief Move to the next record, releasing ranges already read
+     *        and waiting for the next one when needed.
+     *
+     * @return 0 if a record is available, 1 at the end of the file or
+     *         the error code found while parsing the range.
+     */
+
+    int          next_record                          (void);
+
+    /**
+     * @brief Reset the flags controlling the reading process once a record
+     *        has been completely read, and move to the next one.
+     */
+
+    void         record_completed                     (void);
+
+    /**
+     * @brief Stop the worker threads and discard all ranges.
+     */
+
+    void         stop_workers                         (void);
+
+  protected:
+
+    /// @brief Index of the range being read.
+
+    int                   current_range_;
+
+    /// @brief Flag. When true, the range being read has already been parsed.
+
+    bool                  current_range_ready_;
+
+    /// @brief Index, in the current range, of the record being read.
+
+    int                   current_record_;
+
+    /// @brief Index of the next range to be claimed by a worker thread.
+
+    int                   next_range_to_decode_;
+
+    /// @brief Number of worker threads requested (0: one per core).
+
+    int                   n_threads_;
+
+    /// @brief Number of worker threads in use.
+
+    int                   n_threads_in_use_;
+
+    /// @brief Flag. When true, o-records are legal. Set by descendant classes.
+
+    bool                  o_records_allowed_;
+
+    /// @brief Signaled when a worker finishes parsing a range.
+
+    condition_variable    range_decoded_;
+
+    /// @brief Signaled when the reader is done with a range.
+
+    condition_variable    range_released_;
+
+    /// @brief The ranges the file is split into.
+
+    vector<text_range*>   ranges_;
+
+    /// @brief Protects the ranges and counters shared with the workers.
+
+    mutex                 ranges_mutex_;
+
+    /// @brief Ranges already read, kept to reuse their memory.
+
+    vector<text_range*>   spare_ranges_;
+
+    /// @brief Flag. When true, the worker threads must finish.
+
+    bool                  stop_workers_;
+
+    /// @brief The worker threads.
+
+    vector<thread>        workers_;
+
+};
+
+#endif // OBS_E_BASED_FILE_READER_TXT_PARALLEL_HPP
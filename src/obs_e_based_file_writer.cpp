@@ -42,20 +42,97 @@ const
   return result;
 }
 
+int
+obs_e_based_file_writer::
+commit_epochs
+(void)
+{
+  {
+    bool due;
+
+    //
+    // Epochs are counted when these start; the sync, if due, covers all
+    // of them but the one starting now.
+    //
+
+    due = false;
+
+    if (epochs_since_sync_ > 0)
+    {
+      if (durability_policy_ == _ASTROLABE_DURABILITY_EPOCHS)
+      {
+        due = (epochs_since_sync_ >= durability_interval_);
+      }
+      else if (durability_policy_ == _ASTROLABE_DURABILITY_MILLISECONDS)
+      {
+        due = (chrono::steady_clock::now() - last_sync_) >= chrono::milliseconds(durability_interval_);
+      }
+    }
+
+    if (due)
+    {
+      //
+      // Hand the buffer, even if empty, over, asking for a sync once it is
+      // written. Offsets (see index_epoch()) do not change.
+      //
+
+      if (write_behind_.write(data_buffer_, data_buffer_cur_, true) != 0) return 1;
+
+      file_bytes_flushed_ += data_buffer_cur_;
+      data_buffer_cur_     = 0;
+      epochs_since_sync_   = 0;
+      last_sync_           = chrono::steady_clock::now();
+    }
+
+    epochs_since_sync_++;
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_writer::
+close_time_index
+(void)
+{
+  {
+    if (!time_index_is_enabled_) return 0;
+
+    //
+    // Store the final size and modification time of the data file in the
+    // index. The data file is closed by now, so its modification time
+    // won't change unless somebody else writes to it.
+    //
+
+    if (time_index_.finish(file_bytes_flushed_, astr_fmtime(file_name_)) != 0) return 1;
+
+    return 0;
+  }
+}
+
 obs_e_based_file_writer::
 obs_e_based_file_writer
 (void)
 {
   {
+    async_flush_         = false;
     data_buffer_         = NULL;
     data_buffer_cur_     = 0;
     data_buffer_size_    = _ASTROLABE_FILE_WRITER_DEFAULT_BUFFER_SIZE;
+    durability_interval_ = 0;
+    durability_policy_   = _ASTROLABE_DURABILITY_NONE;
+    epochs_since_sync_   = 0;
+    file_bytes_flushed_  = 0;
     file_file_           = NULL;
     file_name_           = NULL;
     file_is_open_        = false;
     first_l_written_     = false;
     first_time_writing_  = true;
     last_time_tag_        = 0.0;
+    preallocation_bytes_  = 0;
+    preallocated_         = false;
+
+    time_index_is_enabled_ = false;
   }
 }
 
@@ -79,22 +156,65 @@ obs_e_based_file_writer::
 
 int
 obs_e_based_file_writer::
-flush
+finish_flushing
 (void)
 {
   {
-    size_t bytes_written;
+    int status;
+
+    status = 0;
+
+    //
+    // Give back the space reserved but not used. The data must be in the
+    // file, so wait for the buffer being written in the background, if any.
+    //
 
+    if (preallocated_)
+    {
+      if (write_behind_.wait()      != 0) status = 1;
+      if (astr_ftruncate(file_file_) != 0) status = 1;
+
+      preallocated_ = false;
+    }
+
+    // All the policies but "none" make sure the data is on the device.
+
+    if (durability_policy_ != _ASTROLABE_DURABILITY_NONE)
+    {
+      if (write_behind_.sync() != 0) status = 1;
+    }
+
+    // Wait for the helper thread, if any, and release the second buffer.
+
+    if (write_behind_.detach() != 0) status = 1;
+
+    return status;
+  }
+}
+
+int
+obs_e_based_file_writer::
+flush
+(void)
+{
+  {
     // If there's no data to dump, simply return (no errors).
 
     if (data_buffer_cur_ == 0) return 0;
 
-    // Write the current contents of the data buffer to disk.
+    //
+    // Write the current contents of the data buffer to disk. When writing
+    // in the background, the buffer is swapped for an empty one instead.
+    //
 
-    bytes_written = fwrite((void*)data_buffer_, 1, (size_t)data_buffer_cur_, file_file_);
-    if (bytes_written != (size_t)data_buffer_cur_) return 1;
+    if (write_behind_.write(data_buffer_, data_buffer_cur_, false) != 0) return 1;
 
-    fflush(file_file_);
+    //
+    // Offsets (see index_epoch()) refer to the data as stored in the buffer,
+    // that is, before compressing it (see frame_compression_level()).
+    //
+
+    file_bytes_flushed_ += data_buffer_cur_;
 
     // Reset pointers and flags.
 
@@ -106,6 +226,76 @@ flush
   }
 }
 
+int
+obs_e_based_file_writer::
+frame_compression_level
+(void)
+const
+{
+  {
+    return 0;
+  }
+}
+
+long long
+obs_e_based_file_writer::
+get_bytes_stored
+(void)
+const
+{
+  {
+    return file_bytes_flushed_ + data_buffer_cur_;
+  }
+}
+
+void
+obs_e_based_file_writer::
+get_sync_statistics
+(long long& n_syncs,
+ double&    seconds,
+ double&    max_seconds)
+const
+{
+  {
+    write_behind_.get_sync_statistics(n_syncs, seconds, max_seconds);
+  }
+}
+
+void
+obs_e_based_file_writer::
+get_write_statistics
+(long long& bytes_written,
+ double&    seconds)
+const
+{
+  {
+    write_behind_.get_statistics(bytes_written, seconds);
+  }
+}
+
+int
+obs_e_based_file_writer::
+index_epoch
+(double time)
+{
+  {
+    // The epochs stored so far are complete. Sync them, if due.
+
+    if (commit_epochs() != 0) return 1;
+
+    if (!time_index_is_enabled_) return 0;
+
+    //
+    // The epoch starts at the first free position of the data buffer,
+    // that will be written after all the bytes already flushed.
+    //
+
+    if (time_index_.append(time, file_bytes_flushed_ + data_buffer_cur_) != 0) return 1;
+
+    return 0;
+  }
+}
+
 bool
 obs_e_based_file_writer::
 is_open
@@ -158,16 +348,103 @@ open
       return 3;
     }
 
+    //
+    // Create the time index, if requested. Failing to do so is an error,
+    // since the calling module explicitly asked for it.
+    //
+
+    file_bytes_flushed_ = 0;
+
+    if (time_index_is_enabled_)
+    {
+      if (time_index_.create(time_index_.get_index_file_name(file_name).c_str()) != 0)
+      {
+        fclose(file_file_);
+        delete [] data_buffer_;
+        data_buffer_  = NULL;
+        file_is_open_ = false;
+        return 4;
+      }
+    }
+    else
+    {
+      //
+      // Remove the index of a previous file with the same name, if any. It
+      // would be stale, and readers should not have to find it out.
+      //
+
+      remove(time_index_.get_index_file_name(file_name).c_str());
+    }
+
     // Set the name of the file just open.
 
     file_name_ = strdup(file_name);
 
+    //
+    // Reserve the space of the file, if asked to. This is just an
+    // optimization, so the file simply grows as usual should it fail.
+    //
+
+    preallocated_ = false;
+
+    if (preallocation_bytes_ > 0)
+    {
+      preallocated_ = (astr_fpreallocate(file_file_, preallocation_bytes_) == 0);
+    }
+
+    //
+    // All the buffers are written through write_behind_. The helper thread
+    // is only started when asked to (see set_async_flush()) or to keep the
+    // periodic syncs off the calling thread (see set_durability()); should
+    // it not start, the buffers are written synchronously.
+    //
+
+    write_behind_.attach(file_file_, frame_compression_level());
+
+    //
+    // With the milliseconds policy, the helper thread also syncs on its
+    // own the buffers already written, so these are not kept waiting for
+    // the next epoch boundary.
+    //
+
+    if (durability_policy_ == _ASTROLABE_DURABILITY_MILLISECONDS)
+    {
+      write_behind_.set_sync_interval(durability_interval_);
+    }
+
+    if (async_flush_                                           ||
+        (durability_policy_ == _ASTROLABE_DURABILITY_EPOCHS)   ||
+        (durability_policy_ == _ASTROLABE_DURABILITY_MILLISECONDS))
+    {
+      write_behind_.start(data_buffer_size_);
+    }
+
+    epochs_since_sync_ = 0;
+    last_sync_         = chrono::steady_clock::now();
+
     // Successful completion.
 
     return 0;
   }
 }
 
+int
+obs_e_based_file_writer::
+set_async_flush
+(bool enabled)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    async_flush_ = enabled;
+
+    // Bye.
+
+    return 0;
+  }
+}
+
 int
 obs_e_based_file_writer::
 set_buffer_size
@@ -190,3 +467,118 @@ set_buffer_size
   }
 }
 
+int
+obs_e_based_file_writer::
+set_durability
+(int policy,
+ int interval)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    if ((policy < _ASTROLABE_DURABILITY_NONE) ||
+        (policy > _ASTROLABE_DURABILITY_CLOSE)) return 2;
+
+    // Periodic policies need a period.
+
+    if ((policy == _ASTROLABE_DURABILITY_EPOCHS) ||
+        (policy == _ASTROLABE_DURABILITY_MILLISECONDS))
+    {
+      if (interval <= 0) return 3;
+    }
+
+    durability_interval_ = interval;
+    durability_policy_   = policy;
+
+    // Bye.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_writer::
+set_preallocation
+(long long n_bytes)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    // The size must not be negative.
+    if (n_bytes < 0)   return 2;
+
+    preallocation_bytes_ = n_bytes;
+
+    // Bye.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_writer::
+set_time_index
+(bool enabled)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    time_index_is_enabled_ = enabled;
+
+    // Bye.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_writer::
+write_epoch
+(const observation_epoch& epoch)
+{
+  {
+    int n_records;
+    int record;
+    int status;
+
+    n_records = epoch.get_n_records();
+
+    for (record = 0; record < n_records; record++)
+    {
+      if (epoch.get_type(record) == 'l')
+      {
+        status = write_l(epoch.get_active(record),
+                         (char*)epoch.get_identifier(record),
+                         epoch.get_instance_id(record),
+                         epoch.get_record_time(record),
+                         epoch.get_n_tags(record),
+                         (double*)epoch.get_tags(record),
+                         epoch.get_n_expectations(record),
+                         (double*)epoch.get_expectations(record),
+                         epoch.get_n_covariance_values(record),
+                         (double*)epoch.get_covariance_values(record));
+      }
+      else
+      {
+        status = write_o(epoch.get_active(record),
+                         (char*)epoch.get_identifier(record),
+                         epoch.get_record_time(record),
+                         epoch.get_n_parameter_iids(record),
+                         (int*)epoch.get_parameter_iids(record),
+                         epoch.get_n_observation_iids(record),
+                         (int*)epoch.get_observation_iids(record),
+                         epoch.get_n_instrument_iids(record),
+                         (int*)epoch.get_instrument_iids(record));
+      }
+
+      if (status != 0) return status;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
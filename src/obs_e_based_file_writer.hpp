@@ -10,6 +10,10 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include "astrolabe_write_behind.hpp"
+#include "epoch_time_index.hpp"
+#include "observation_epoch.hpp"
+
 using namespace std;
 
 /// @brief Default buffer size: 5 Mbyte (5 * 1024 * 1024 bytes)
@@ -37,10 +41,17 @@ using namespace std;
  *   may be set using method set_buffer_size(). Note that all descendant
  *   classes must provide with a default buffer size that would be used
  *   if a calling module makes no decisions on this subject.
+ * - Optionally, the buffer may be written to disk in the background
+ *   (see set_async_flush()), so write_l() and write_o() do not wait for
+ *   the disk every time the buffer gets full.
+ * - Optionally, the data may be committed to the storage device from time
+ *   to time (see set_durability()), so a power loss does not lose more
+ *   than a bounded number of epochs.
  * - The writer must be associated to a physical output file using
  *   method open(). This action enables actual I/O operations.
  * - A series of either l- or o-records may be written using, respectively,
- *   methods write_l() or write_o(). More on this below (*)
+ *   methods write_l() or write_o(). More on this below (*). Whole epochs
+ *   may also be written at once using write_epoch().
  * - The writer must close() the associated output file, thus guaranteeing
  *   that no pending write operations are left behind. Note that close()
  *   must flush the contents of the internal buffer to disk, when non empty.
@@ -141,6 +152,53 @@ class obs_e_based_file_writer
 
     virtual     ~obs_e_based_file_writer   (void);
 
+    /**
+     * @brief Retrieve the number of bytes stored so far in the file.
+     *
+     * @return Bytes flushed from the internal buffer plus those still
+     *         waiting in it, that is, the offset of the next byte to write.
+     *
+     * Sizes refer to the data as stored in the buffer, that is, before
+     * compressing it (see frame_compression_level()). Segmented writers
+     * use this figure to decide when to start a new chunk (see
+     * observation_writer::set_max_chunk_size()). Writers keeping the
+     * records in memory until closed (such as observation_file_writer_col)
+     * report no bytes until then.
+     */
+
+    virtual long long get_bytes_stored     (void) const;
+
+    /**
+     * @brief Retrieve the sync statistics of the writer.
+     *
+     * @param n_syncs Number of times the file has been committed to the
+     *        storage device (see set_durability()).
+     * @param seconds Total time, in seconds, spent in these commits.
+     * @param max_seconds Time, in seconds, taken by the slowest one.
+     *
+     * Statistics refer to the file opened last and are kept after
+     * closing it.
+     */
+
+    virtual void get_sync_statistics       (long long&   n_syncs,
+                                            double&      seconds,
+                                            double&      max_seconds) const;
+
+    /**
+     * @brief Retrieve the I/O statistics of the writer.
+     *
+     * @param bytes_written Number of bytes flushed from the internal buffer.
+     * @param seconds Time, in seconds, the calling module has been blocked
+     *        while the buffer was written to disk.
+     *
+     * Statistics refer to the file opened last and are kept after
+     * closing it. Comparing them with and without set_async_flush() shows
+     * how much writing in the background saves.
+     */
+
+    virtual void get_write_statistics      (long long&   bytes_written,
+                                            double&      seconds) const;
+
     /**
      * @brief Check if the underlying data file has already been opened.
      *
@@ -158,6 +216,7 @@ class obs_e_based_file_writer
      *        - 1: The file was already open.
      *        - 2: Unable to open the selected file.
      *        - 3: Not enough memory to allocate the internal buffer.
+     *        - 4: Unable to create the time index file (see set_time_index()).
      *
      * Once a writer has been instantiated (and, optionally, the
      * size of the internal buffer set using set_buffer_size()), it is
@@ -171,6 +230,36 @@ class obs_e_based_file_writer
 
     virtual int  open                      (const char*  file_name);
 
+    /**
+     * @brief Enable or disable writing the internal buffer in the background.
+     *
+     * @param enabled True to write the buffer in a helper thread, false
+     *        to write it in the thread calling write_l() and write_o().
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *
+     * When enabled, open() allocates a second buffer of the same size and
+     * starts a helper thread (see astrolabe_write_behind). Whenever the
+     * buffer gets full, it is handed over to the helper thread, and the
+     * writer goes on with the second one. write_l() and write_o() only
+     * wait for the disk when the previous buffer has not been written yet,
+     * so their latency is bounded by the time needed to fill a buffer
+     * instead of the time needed to write it.
+     *
+     * I/O errors found in the background are reported by the next write
+     * needing to flush the buffer, or by close(), which waits for all
+     * the data to be written. Should the helper thread not start, the
+     * buffer is written as usual.
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked. By default, buffers
+     * are written in the thread calling the writer.
+     */
+
+    virtual int  set_async_flush           (bool         enabled);
+
     /**
      * @brief Set the size of the internal buffer used by the writer.
      *
@@ -195,6 +284,106 @@ class obs_e_based_file_writer
 
     virtual int  set_buffer_size           (int          buffer_size);
 
+    /**
+     * @brief Select when the data written is committed to the storage
+     *        device.
+     *
+     * @param policy One of _ASTROLABE_DURABILITY_NONE,
+     *        _ASTROLABE_DURABILITY_EPOCHS, _ASTROLABE_DURABILITY_MILLISECONDS
+     *        or _ASTROLABE_DURABILITY_CLOSE.
+     * @param interval Number of epochs (_ASTROLABE_DURABILITY_EPOCHS) or
+     *        milliseconds (_ASTROLABE_DURABILITY_MILLISECONDS) between
+     *        syncs. Ignored by the other policies.
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *         - 2: Unknown policy.
+     *         - 3: The interval must be greater than zero.
+     *
+     * Syncs (see astr_fsync()) always take place at epoch boundaries:
+     * when a new epoch starts and the policy says so, the internal buffer
+     * is flushed, even if not full, and the file is synced, so the data on
+     * the device ends with a complete epoch. With the epochs and
+     * milliseconds policies, open() starts the helper thread of
+     * set_async_flush() even if not asked to, so the syncs are done in the
+     * background and write_l() and write_o() do not wait for the device.
+     * Besides, with the milliseconds policy, the helper thread syncs the
+     * buffers already written whenever the interval elapses without a sync
+     * (see astrolabe_write_behind::set_sync_interval()), so a long gap
+     * between epochs does not leave these unsynced; data still in the
+     * internal buffer waits for the next epoch boundary, as usual.
+     * All the policies but _ASTROLABE_DURABILITY_NONE also sync the file
+     * in close().
+     *
+     * Frequent syncs mean smaller writes (and, for compressed files,
+     * smaller frames); get_sync_statistics() tells how long these take.
+     * Writers storing the data only when closed (such as
+     * observation_file_writer_col) just sync in close().
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked. By default, files are
+     * never synced (_ASTROLABE_DURABILITY_NONE).
+     */
+
+    virtual int  set_durability            (int          policy,
+                                            int          interval);
+
+    /**
+     * @brief Set the space to reserve on the storage device when opening
+     *        the file.
+     *
+     * @param n_bytes Size, in bytes, the file is expected to reach. Zero
+     *        disables preallocation.
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *         - 2: The size must not be negative.
+     *
+     * When set, open() reserves n_bytes for the file (see
+     * astr_fpreallocate()), so it is laid out contiguously on the device
+     * instead of growing a buffer at a time. The size of the file is not
+     * changed, so files left behind by a crash hold just the data written.
+     * close() then gives back the space not used (see astr_ftruncate()).
+     * Failing to preallocate is not an error; the file just grows as usual.
+     * Space is reserved only on platforms able to keep the size of the
+     * file (currently, Linux and Windows).
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked. By default, no space
+     * is reserved.
+     */
+
+    virtual int  set_preallocation         (long long    n_bytes);
+
+    /**
+     * @brief Enable or disable the creation of a time index for the file.
+     *
+     * @param enabled True to create the time index, false otherwise.
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *
+     * When enabled, the writer creates, besides the data file, a small
+     * sidecar file (see class epoch_time_index) that stores the time tag
+     * of every epoch written and the byte offset where it starts. Readers
+     * use it to position themselves at any time in O(log n) instead of
+     * reading the data file from its beginning.
+     *
+     * The name of the index file is that of the data file plus the
+     * _ASTROLABE_TIME_INDEX_EXTENSION extension. The index is completed
+     * when the writer is closed. When disabled, open() removes the index
+     * file left by a previous data file with the same name, if any.
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked. By default, no time
+     * index is created.
+     */
+
+    virtual int  set_time_index            (bool         enabled);
+
     /**
      * @brief Write an l-record.
      *
@@ -296,6 +485,23 @@ class obs_e_based_file_writer
                                             int          n_instrument_iids,
                                             int*         the_instrument_iids) = 0;
 
+    /**
+     * @brief Write all the l- and o-records of an epoch.
+     *
+     * @param epoch The records to write, in the order these must appear
+     *        in the file.
+     * @return Error code. Same values as write_l() and write_o(); the
+     *         first error found is reported.
+     *
+     * This default implementation just calls write_l() or write_o() for
+     * every record, so the records before the one failing, if any, are
+     * written. Descendant classes override this method to validate the
+     * whole epoch once and store it in the data buffer in a single pass;
+     * see their documentation for details.
+     */
+
+    virtual int  write_epoch               (const observation_epoch& epoch);
+
   protected:
 
     /**
@@ -308,12 +514,91 @@ class obs_e_based_file_writer
      * This protected method writes the contents of the internal buffer to
      * disk, thus reducing the total amount of I/O operations needed and
      * (hopefully) improving the performance.
+     *
+     * When writing in the background (see set_async_flush()), the buffer
+     * is handed over to the helper thread and data_buffer_ points to the
+     * second buffer on return. Errors may then refer to a previous flush.
      */
 
     virtual int  flush                     (void);
 
+    /**
+     * @brief Wait until all the data flushed has been written to disk.
+     *
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 1: Error detected while writing a buffer to disk.
+     *
+     * Descendant classes must call this method from close(), after the
+     * last call to flush() and before closing the file, so the helper
+     * thread (see set_async_flush()) is not writing to it any longer.
+     * Preallocated files (see set_preallocation()) are truncated here.
+     */
+
+    int          finish_flushing           (void);
+
+    /**
+     * @brief Compression level used to write the internal buffer.
+     *
+     * @return 0 if the buffer is written as it is; otherwise, the level
+     *         used to write it as a compressed frame (see
+     *         astrolabe_compressed_file::write_frame()).
+     *
+     * Descendant classes writing compressed files override this method.
+     */
+
+    virtual int  frame_compression_level   (void) const;
+
+    /**
+     * @brief Sync the epochs stored so far, if the durability policy says
+     *        so (see set_durability()).
+     *
+     * @return Error code. Error code values:
+     *        - 0: successful completion (or no sync due).
+     *        - 1: Error detected while writing the buffer or syncing.
+     *
+     * Called by index_epoch(), that is, whenever a new epoch starts, so
+     * the epochs stored so far are complete.
+     */
+
+    int          commit_epochs             (void);
+
+    /**
+     * @brief Register the start of a new epoch in the time index.
+     *
+     * @param time The time tag of the new epoch.
+     * @return Error code. Error code values:
+     *        - 0: successful completion (or time index disabled).
+     *        - 1: Error detected while writing the time index.
+     *
+     * Descendant classes must call this method whenever a new epoch
+     * starts, right before the first record of the epoch is stored in
+     * the data buffer, so its offset may be computed. This is also where
+     * the epochs already stored are synced (see commit_epochs()), so the
+     * method is called even when the time index is disabled.
+     */
+
+    int          index_epoch               (double time);
+
+    /**
+     * @brief Complete the time index, if enabled.
+     *
+     * @return Error code. Error code values:
+     *        - 0: successful completion (or time index disabled).
+     *        - 1: Error detected while writing the time index.
+     *
+     * Descendant classes must call this method from close(), once all
+     * the data has been flushed to disk.
+     */
+
+    int          close_time_index          (void);
+
   protected:
 
+    /// @brief Flag. When true, the buffer is written in a helper thread.
+
+    bool   async_flush_;
+
     /// @brief The data_buffer_ used to store the data to write.
 
     char*  data_buffer_;
@@ -328,10 +613,27 @@ class obs_e_based_file_writer
 
     int    data_buffer_size_;
 
+    /// @brief Number of epochs or milliseconds between syncs.
+
+    int    durability_interval_;
+
+    /// @brief When to sync the file (see set_durability()).
+
+    int    durability_policy_;
+
+    /// @brief Number of epochs started since the last sync.
+
+    int    epochs_since_sync_;
+
     /// @brief The file handled by the writer.
 
     FILE*  file_file_;
 
+    /// @brief Total of bytes already flushed to the file. Added to
+    /// data_buffer_cur_, it provides the offset of the next byte to write.
+
+    long long file_bytes_flushed_;
+
     /// @brief The name of the underlying file being dealt with.
 
     char*  file_name_;
@@ -356,6 +658,32 @@ class obs_e_based_file_writer
     /// (set of l- and o-records with the same time tag).
 
     double last_time_tag_;
+
+    /// @brief When the file was last synced (or opened).
+
+    chrono::steady_clock::time_point last_sync_;
+
+    /// @brief Bytes to reserve for the file when opening it (0: none).
+
+    long long preallocation_bytes_;
+
+    /// @brief Flag. True when the space of the file has been reserved, so
+    /// it must be truncated when closed.
+
+    bool   preallocated_;
+
+    /// @brief The time index being created, if enabled.
+
+    epoch_time_index time_index_;
+
+    /// @brief Flag. When true, a time index is created along with the file.
+
+    bool   time_index_is_enabled_;
+
+    /// @brief Writes the contents of data_buffer_ to the file, maybe in
+    /// the background.
+
+    astrolabe_write_behind write_behind_;
 };
 
 #endif // OBS_E_BASED_FILE_WRITER_HPP
@@ -17,14 +17,23 @@ close
     // Do not complain if the file is already closed.
     if (!file_is_open_) return 0;
 
-    // If there's still data in the buffer, dump it to disk.
-
-    status = flush();
+    //
+    // If there's no room left in the buffer for the last backtracking
+    // record, dump it to disk. Otherwise, keep the pending data, so the
+    // last frame of compressed files is not a tiny one holding just the
+    // backtracking record.
+    //
 
-    if (status != 0)
+    if ((data_buffer_cur_ + (int)(sizeof(char) + sizeof(int))) > data_buffer_size_)
     {
-      fclose(file_file_);
-      return 2;
+      status = flush();
+
+      if (status != 0)
+      {
+        finish_flushing();
+        fclose(file_file_);
+        return 2;
+      }
     }
 
     // We must write the last sub-block tag
@@ -44,6 +53,10 @@ close
 
     status = flush();
 
+    // Wait for the data flushed in the background, if any.
+
+    if (finish_flushing() != 0) status = 1;
+
     if (status != 0)
     {
       fclose(file_file_);
@@ -55,6 +68,17 @@ close
     status = fclose(file_file_);
     if (status != 0) return 1;
 
+    // Complete the time index, if any.
+
+    if (close_time_index() != 0)
+    {
+      delete [] data_buffer_;
+      data_buffer_ = NULL;
+
+      file_is_open_ = false;
+      return 2;
+    }
+
     //
     // The file is closed now. Update the corresponding status members and
     // destroy buffers.
@@ -77,6 +101,7 @@ obs_e_based_file_writer_bin
 {
   {
     bytes_in_current_block_ = 0;
+    compression_level_      = 0;
   }
 }
 
@@ -97,278 +122,338 @@ obs_e_based_file_writer_bin::
 
 int
 obs_e_based_file_writer_bin::
-write_l
-(bool         active,
- char*        identifier,
- int          instance_identifier,
- double       time,
- int          n_tags,
- double*      buffer_tags,
- int          n_expectations,
- double*      buffer_expectations,
- int          n_covariance_values,
- double*      buffer_covariance)
+flush_at_epoch_boundary
+(void)
 {
   {
-    char  cactive;
-    int   i;
-    char* pchar;
-    int   size_b_record;
-    int   size_identifier;
-    int   size_l_record;
-    int   size_total;
-    int   status;
-    bool  write_backtrack_info;
+    if (compression_level_ == 0) return 0;
 
-    // Won't work if the file is closed.
+    if (data_buffer_cur_ < (data_buffer_size_ / 2)) return 0;
 
-    if (!file_is_open_)      return 1;
+    return flush();
+  }
+}
 
-    // code must be at least 1 chars long excluding the terminating NULL char.
+int
+obs_e_based_file_writer_bin::
+frame_compression_level
+(void)
+const
+{
+  {
+    return compression_level_;
+  }
+}
 
-    if (identifier == NULL)  return 4;
+int
+obs_e_based_file_writer_bin::
+l_record_size
+(int size_identifier,
+ int n_tags,
+ int n_expectations,
+ int n_covariance_values)
+const
+{
+  {
+    return   sizeof(char)                          // type
+           + sizeof(char)                          // active flag
+           + sizeof(int)                           // length in chars of the identifier
+           + sizeof(char) * size_identifier        // identifier
+           + sizeof(int)                           // instance identifier
+           + sizeof(double)                        // time stamp
+           + sizeof(int)                           // number of tags
+           + sizeof(double) * n_tags               // the tags
+           + sizeof(int)                           // number of expectations
+           + sizeof(double) * n_expectations       // the expectations
+           + sizeof(int)                           // number of covariance values
+           + sizeof(double) * n_covariance_values; // the covariance values.
+  }
+}
 
-    size_identifier = (int)strlen(identifier);
+int
+obs_e_based_file_writer_bin::
+open
+(const char*  file_name)
+{
+  {
+    int status;
 
-    if (size_identifier < 1) return 4;
+    status = obs_e_based_file_writer::open(file_name);
+    if (status != 0) return status;
 
-    // The dimensions of the several double arrays must be correct.
+    // Compressed files start with their signature.
 
-    if (n_tags < 0)          return 5;
-    if (n_expectations <= 0) return 5;
-    if ((n_covariance_values != 0)              &
-        (n_covariance_values != n_expectations) &
-        (n_covariance_values != (n_expectations*(n_expectations+1))/2))
-                             return 5;
-
-    //
-    // Check if this is the first time we write to the file. If so, we
-    // must give an initial value to the last time tag in use.
-    //
-
-    if (first_time_writing_)
+    if (compression_level_ != 0)
     {
-      first_time_writing_ = false;
-      last_time_tag_      = time;
+      if (astrolabe_compressed_file::write_signature(file_file_) != 0)
+      {
+        finish_flushing();
+        fclose(file_file_);
+        delete [] data_buffer_;
+        data_buffer_  = NULL;
+        free(file_name_);
+        file_name_    = NULL;
+        file_is_open_ = false;
+        return 2;
+      }
     }
 
-    //
-    // Compute the size needed to store the current l record in the buffer.
-    // We'll take into account the backtracking tags only when a sub-block
-    // (set of records with the same time tag) has just finished.
-    //
+    // That's all.
 
-    size_b_record = 0; // No backtracking info until detected as needed.
+    return 0;
+  }
+}
 
-    size_l_record =   sizeof(char)                          // type
-                    + sizeof(char)                          // active flag
-                    + sizeof(int)                           // length in chars of the identifier
-                    + sizeof(char) * size_identifier        // identifier
-                    + sizeof(int)                           // instance identifier
-                    + sizeof(double)                        // time stamp
-                    + sizeof(int)                           // number of tags
-                    + sizeof(double) * n_tags               // the tags
-                    + sizeof(int)                           // number of expectations
-                    + sizeof(double) * n_expectations       // the expectations
-                    + sizeof(int)                           // number of covariance values
-                    + sizeof(double) * n_covariance_values; // the covariance values.
+int
+obs_e_based_file_writer_bin::
+set_compression
+(int level)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
 
-    size_total = size_l_record;
+    // Check the level.
+    if ((level < 0) || (level > 9)) return 2;
 
-    write_backtrack_info = false;
+    compression_level_ = level;
 
-    if (time != last_time_tag_)
-    {
-      //
-      // We need to write the backtracking information for the previous
-      // sub-block.
-      //
+    // Bye.
 
-      size_b_record =   sizeof(char) // type ('b')
-                      + sizeof(int); // total of bytes in block.
+    return 0;
+  }
+}
 
-      size_total += size_b_record;
+int
+obs_e_based_file_writer_bin::
+store_backtrack_record
+(void)
+{
+  {
+    // backtracking tag.
+    data_buffer_[data_buffer_cur_] = 'b';
+    data_buffer_cur_++;
 
-      // We must write the backtrack info.
+    // bytes in sub-block.
+    memcpy(&(data_buffer_[data_buffer_cur_]), &bytes_in_current_block_, sizeof(int));
+    data_buffer_cur_ += (int)sizeof(int);
 
-      write_backtrack_info = true;
+    // Reset the number of bytes in the current sub-block.
 
-      // We've got a new last_time_tag_ to compare to.
+    bytes_in_current_block_ = 0;
 
-      last_time_tag_ = time;
-    }
+    // We'll expect an l-record the next time a write operation is called.
+
+    first_l_written_ = false;
+
+    // Start a new compressed frame, if needed.
+
+    if (flush_at_epoch_boundary() != 0) return 2;
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_writer_bin::
+store_l_record
+(bool          active,
+ const char*   identifier,
+ int           size_identifier,
+ int           instance_identifier,
+ double        time,
+ int           n_tags,
+ const double* buffer_tags,
+ int           n_expectations,
+ const double* buffer_expectations,
+ int           n_covariance_values,
+ const double* buffer_covariance)
+{
+  {
+    bool  new_epoch;
+    char* pchar;
 
     //
-    // Check if enough room is still left in the data buffer. If not, flush
-    // the buffer to disk and start storing data again from its beginning.
+    // Check if this is the first time we write to the file. If so, we
+    // must give an initial value to the last time tag in use.
+    // Note that the first record written starts an epoch as well.
     //
 
-    if ((data_buffer_cur_ + size_total ) > data_buffer_size_)
-    {
-      status = flush();
-
-      // I/O error if status is not 0.
+    new_epoch = first_time_writing_;
 
-      if (status != 0) return 2;
+    if (first_time_writing_)
+    {
+      first_time_writing_ = false;
+      last_time_tag_      = time;
     }
 
-    // Copy to the data buffer the required info.
-
-    if (write_backtrack_info)
+    if (time != last_time_tag_)
     {
       // We must dump last sub-block backtracking data.
 
-      // backtracking tag.
-      data_buffer_[data_buffer_cur_] = 'b';
-      data_buffer_cur_++;
+      if (store_backtrack_record() != 0) return 2;
 
-      // bytes in sub-block.
-      pchar = (char*)&bytes_in_current_block_;
+      new_epoch = true;
 
-      for(i = 0; i < (int)sizeof(int); i++)
-      {
-        data_buffer_[data_buffer_cur_] = pchar[i];
-        data_buffer_cur_++;
-      }
-
-      // Reset the number of bytes in the current sub-block.
+      // We've got a new last_time_tag_ to compare to.
 
-      bytes_in_current_block_ = 0;
+      last_time_tag_ = time;
+    }
 
-      // We'll expect an l-record the next time a write operation is called.
+    // A new epoch starts here. Register it in the time index, if enabled.
 
-      first_l_written_ = false;
+    if (new_epoch)
+    {
+      if (index_epoch(time) != 0) return 2;
     }
 
-    // l-tag
+    //
+    // Copy to the data buffer the required info. Note that the buffer may
+    // have been replaced while registering the epoch (see flush()).
+    //
 
-    data_buffer_[data_buffer_cur_] = 'l';
-    data_buffer_cur_++;
+    pchar = &(data_buffer_[data_buffer_cur_]);
 
-    // Active flag.
+    // l-tag and active flag.
 
-    if (active) cactive = 1;
-    else        cactive = 0;
+    *pchar++ = 'l';
+    *pchar++ = active ? 1 : 0;
 
-    data_buffer_[data_buffer_cur_] = cactive;
-    data_buffer_cur_++;
+    //
+    // Length of the identifier and the identifier itself (variable length,
+    // that's why we wrote its length before).
+    //
 
-    // Length of the identifier.
+    memcpy(pchar, &size_identifier, sizeof(int));
+    pchar += sizeof(int);
 
-    pchar = (char*)&size_identifier;
+    memcpy(pchar, identifier, (size_t)size_identifier);
+    pchar += size_identifier;
 
-    for (i = 0; i < (int)sizeof(int); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    // Instance identifier and time stamp.
 
-    //
-    // The identifier itself (variable length, that's why we wrote its
-    // length before).
-    //
+    memcpy(pchar, &instance_identifier, sizeof(int));
+    pchar += sizeof(int);
 
-    for (i = 0; i < size_identifier; i++)
-    {
-      data_buffer_[data_buffer_cur_] = identifier[i];
-      data_buffer_cur_++;
-    }
+    memcpy(pchar, &time, sizeof(double));
+    pchar += sizeof(double);
 
-    // Instance identifier.
+    // Number of tags and the tags themselves.
 
-    pchar = (char*)&instance_identifier;
+    memcpy(pchar, &n_tags, sizeof(int));
+    pchar += sizeof(int);
 
-    for (i = 0; i < (int)sizeof(int); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    if (n_tags > 0) memcpy(pchar, buffer_tags, n_tags * sizeof(double));
+    pchar += n_tags * sizeof(double);
 
-    // Time stamp.
+    // Number of expectations and the expectations themselves.
 
-    pchar = (char*)&time;
+    memcpy(pchar, &n_expectations, sizeof(int));
+    pchar += sizeof(int);
 
-    for(i = 0; i < (int)sizeof(double); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    memcpy(pchar, buffer_expectations, n_expectations * sizeof(double));
+    pchar += n_expectations * sizeof(double);
 
-    // Number of tags.
+    // Number of covariance matrix elements and their values.
 
-    pchar = (char*)&n_tags;
+    memcpy(pchar, &n_covariance_values, sizeof(int));
+    pchar += sizeof(int);
 
-    for (i = 0; i < (int)sizeof(int); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    if (n_covariance_values > 0) memcpy(pchar, buffer_covariance, n_covariance_values * sizeof(double));
+    pchar += n_covariance_values * sizeof(double);
 
-    // The tags themselves.
+    // Update pointers and the total number of bytes in this block.
 
-    pchar = (char*)buffer_tags;
+    bytes_in_current_block_ += (int)(pchar - &(data_buffer_[data_buffer_cur_]));
+    data_buffer_cur_         = (int)(pchar - data_buffer_);
 
-    for(i = 0; i < (int)(n_tags *sizeof(double)); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    //
+    // We don't need an l-record the next time data is written.
+    // Note that inactive records DO NOT CHANGE the situation,
+    // since, although written, these records do not count as
+    // "real" ones.
+    //
 
-    // Number of expectations.
+    if (active) first_l_written_ = true;
 
-    pchar = (char*)&n_expectations;
+    // That's all.
 
-    for (i = 0; i < (int)sizeof(int); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_writer_bin::
+write_l
+(bool         active,
+ char*        identifier,
+ int          instance_identifier,
+ double       time,
+ int          n_tags,
+ double*      buffer_tags,
+ int          n_expectations,
+ double*      buffer_expectations,
+ int          n_covariance_values,
+ double*      buffer_covariance)
+{
+  {
+    int   size_identifier;
+    int   size_total;
+    int   status;
 
-    // The expectations themselves.
+    // Won't work if the file is closed.
 
-    pchar = (char*)buffer_expectations;
+    if (!file_is_open_)      return 1;
 
-    for(i = 0; i < (int)(n_expectations *sizeof(double)); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    // code must be at least 1 chars long excluding the terminating NULL char.
 
-    // Number of covariance matrix elements.
+    if (identifier == NULL)  return 4;
 
-    pchar = (char*)&n_covariance_values;
+    size_identifier = (int)strlen(identifier);
 
-    for (i = 0; i < (int)sizeof(int); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    if (size_identifier < 1) return 4;
 
-    // The covariance matrix values themselves.
+    // The dimensions of the several double arrays must be correct.
 
-    pchar = (char*)buffer_covariance;
+    if (n_tags < 0)          return 5;
+    if (n_expectations <= 0) return 5;
+    if ((n_covariance_values != 0)              &
+        (n_covariance_values != n_expectations) &
+        (n_covariance_values != (n_expectations*(n_expectations+1))/2))
+                             return 5;
 
-    for(i = 0; i < (int)(n_covariance_values *sizeof(double)); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    //
+    // Compute the size needed to store the current l record in the buffer.
+    // We'll take into account the backtracking tags only when a sub-block
+    // (set of records with the same time tag) has just finished. Note that
+    // the first record written starts an epoch, but closes none.
+    //
 
-    // Update the total number of bytes in this block.
+    size_total = l_record_size(size_identifier, n_tags, n_expectations, n_covariance_values);
 
-    bytes_in_current_block_ += size_l_record;
+    if ((!first_time_writing_) && (time != last_time_tag_))
+    {
+      size_total +=   sizeof(char) // type ('b')
+                    + sizeof(int); // total of bytes in block.
+    }
 
     //
-    // We don't need an l-record the next time data is written.
-    // Note that inactive records DO NOT CHANGE the situation,
-    // since, although written, these records do not count as
-    // "real" ones.
+    // Check if enough room is still left in the data buffer. If not, flush
+    // the buffer to disk and start storing data again from its beginning.
     //
 
-    if (active) first_l_written_ = true;
+    if ((data_buffer_cur_ + size_total ) > data_buffer_size_)
+    {
+      status = flush();
 
-    // That's all.
+      // I/O error if status is not 0.
 
-    return 0;
+      if (status != 0) return 2;
+    }
+
+    // Copy to the data buffer the required info.
+
+    return store_l_record(active, identifier, size_identifier, instance_identifier, time,
+                          n_tags, buffer_tags, n_expectations, buffer_expectations, n_covariance_values, buffer_covariance);
   }
 }
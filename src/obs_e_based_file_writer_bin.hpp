@@ -7,6 +7,7 @@
 #define OBS_E_BASED_FILE_WRITER_BIN_HPP
 
 #include "obs_e_based_file_writer.hpp"
+#include "astrolabe_compressed_file.hpp"
 
 /**
  * @brief Class defining the interface of binary obs_e_based file writers.
@@ -16,6 +17,9 @@
  * This class implements the interface defined in parent class
  * obs_e_based_file_writer, creating binary files as result.
  *
+ * Optionally, files may be written in block-compressed form (see
+ * set_compression()). All binary readers handle both plain and
+ * compressed files transparently.
  *
  */
 class obs_e_based_file_writer_bin : public obs_e_based_file_writer
@@ -52,6 +56,53 @@ class obs_e_based_file_writer_bin : public obs_e_based_file_writer
      */
     virtual     ~obs_e_based_file_writer_bin (void);
 
+    /**
+     * @brief Opens the writer, enabling I/O operations.
+     *
+     * @param file_name Name of the file to write.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file was already open.
+     *        - 2: Unable to open the selected file (or to write the
+     *             signature of compressed files).
+     *        - 3: Not enough memory to allocate the internal buffer.
+     *        - 4: Unable to create the time index file (see set_time_index()).
+     *
+     * See obs_e_based_file_writer::open(). When compression is enabled
+     * (see set_compression()), the signature of compressed files is
+     * written right after opening the file.
+     */
+
+    virtual int  open                        (const char*  file_name);
+
+    /**
+     * @brief Enable or disable block compression.
+     *
+     * @param level Compression level. 0 disables compression (the default);
+     *        1 (fastest) to 9 (smallest files) enable it.
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *         - 2: Invalid compression level.
+     *
+     * When enabled, every time the internal buffer is flushed its contents
+     * are deflated and written as an independent frame (see class
+     * astrolabe_compressed_file). The buffer is also flushed at the end
+     * of any epoch once it is half full, so frames usually hold complete
+     * epochs; only epochs that do not fit in half the buffer span several
+     * frames. Larger buffers (see set_buffer_size()) yield better
+     * compression ratios.
+     *
+     * Offsets stored in time indexes (see set_time_index()) are those of
+     * the uncompressed data.
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked.
+     */
+
+    virtual int  set_compression             (int          level);
+
     /**
      * @brief Write an l-record.
      *
@@ -167,6 +218,100 @@ class obs_e_based_file_writer_bin : public obs_e_based_file_writer
                                               int          n_instrument_iids,
                                               int*         the_instrument_iids) = 0;
 
+  protected:
+
+    /**
+     * @brief Close the current compressed frame at an epoch boundary.
+     *
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 1: Error detected while writting the buffer to disk.
+     *
+     * Descendant classes must call this method right after writing the
+     * backtracking record that closes an epoch. If compression is enabled
+     * and the buffer is, at least, half full, it is flushed, so the next
+     * epoch starts a new frame. Otherwise, nothing is done.
+     */
+
+    int          flush_at_epoch_boundary     (void);
+
+    /**
+     * @brief Compression level used to write the internal buffer.
+     *
+     * @return The level set by set_compression(). When not zero, every
+     *         flush writes the buffer as a new compressed frame.
+     */
+
+    virtual int  frame_compression_level     (void) const;
+
+    /**
+     * @brief Size, in bytes, of an l-record once stored in the data buffer.
+     *
+     * @param size_identifier Length of the identifier, in characters.
+     * @param n_tags Number of tag values.
+     * @param n_expectations Number of expectations.
+     * @param n_covariance_values Number of covariance matrix elements.
+     * @return The size of the record, not including any backtracking record.
+     */
+
+    int          l_record_size               (int          size_identifier,
+                                              int          n_tags,
+                                              int          n_expectations,
+                                              int          n_covariance_values) const;
+
+    /**
+     * @brief Store the backtracking record closing the current epoch.
+     *
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 2: I/O error detected while writing to disk.
+     *
+     * The record is stored at the current position of the data buffer,
+     * that must have room enough for it. The counter of bytes in the epoch
+     * is reset and an l-record is expected next. The compressed frame, if
+     * any, is closed (see flush_at_epoch_boundary()).
+     */
+
+    int          store_backtrack_record      (void);
+
+    /**
+     * @brief Store an l-record already validated in the data buffer.
+     *
+     * @param active The l-record is active (true) or removed (false).
+     * @param identifier Identifier of the l-record.
+     * @param size_identifier Length of the identifier, in characters.
+     * @param instance_identifier Instance identifier of the l-record.
+     * @param time Time tag of the l-record.
+     * @param n_tags Number of tag values to store.
+     * @param buffer_tags The tag values.
+     * @param n_expectations Number of expectations to store.
+     * @param buffer_expectations The expectations.
+     * @param n_covariance_values Number of covariance matrix elements to
+     *        store.
+     * @param buffer_covariance The covariance matrix elements.
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 2: I/O error detected while writing to disk.
+     *
+     * When the time tag differs from the one of the current epoch, the
+     * backtracking record of the latter is stored first, and the new epoch
+     * is registered (see index_epoch()). The data buffer must have room
+     * enough for both records; no checks are made. Used by write_l() and
+     * by the write_epoch() methods of descendant classes.
+     */
+
+    int          store_l_record              (bool          active,
+                                              const char*   identifier,
+                                              int           size_identifier,
+                                              int           instance_identifier,
+                                              double        time,
+                                              int           n_tags,
+                                              const double* buffer_tags,
+                                              int           n_expectations,
+                                              const double* buffer_expectations,
+                                              int           n_covariance_values,
+                                              const double* buffer_covariance);
+
   protected:
 
     /// @brief Number of bytes accumulated in the current epoch (set of
@@ -175,6 +320,10 @@ class obs_e_based_file_writer_bin : public obs_e_based_file_writer
 
     int    bytes_in_current_block_;
 
+    /// @brief Compression level (0: no compression).
+
+    int    compression_level_;
+
 };
 
 #endif // OBS_E_BASED_FILE_WRITER_BIN_HPP
@@ -19,6 +19,10 @@ close
 
     status = flush();
 
+    // Wait for the data flushed in the background, if any.
+
+    if (finish_flushing() != 0) status = 1;
+
     if (status != 0)
     {
       fclose(file_file_);
@@ -30,6 +34,17 @@ close
     status = fclose(file_file_);
     if (status != 0) return 1;
 
+    // Complete the time index, if any.
+
+    if (close_time_index() != 0)
+    {
+      delete [] data_buffer_;
+      data_buffer_ = NULL;
+
+      file_is_open_ = false;
+      return 2;
+    }
+
     //
     // The file is closed now. Update the corresponding status members and
     // destroy buffers.
@@ -46,34 +61,14 @@ close
   }
 }
 
+void
 obs_e_based_file_writer_txt::
-obs_e_based_file_writer_txt
+compute_value_sizes
 (void)
 {
   {
-
-    //
-    // Instantiate and assign the fixed parts of the l- and o-records
-    // formats. Doing this here will reduce drastically the amount of
-    // instantiation / destruction operations needed by methods
-    // build_l_format() and build_o_format().
-    //
-    // Note that this is the place to change default formats for
-    // integer (o-records) or double (l-records) if ever needed as well
-    // as any other format involved in the process or "text writing".
-    //
-    // WARNING - WARNING - WARNING - WARNING - WARNING - WARNING
-    //
-    // Do not forget to update the size in bytes that the different
-    // part of the l- or o-records will use later on this same method.
-    //
-    // END OF WARNING - END OF WARNING - END OF WARNING - END OF WARNING
-    //
-
-    format_fixed_l_                    = strdup("<l s=\"%c\" id=\"%s\" n=\"%s\"> %23.15le");
-    format_fixed_o_                    = strdup("<o s=\"%c\" id=\"%s\"> %23.15le");
-    format_default_double_format_      = strdup(" %23.15le");
-    format_default_int_format_         = strdup(" %10ld");
+    int double_size;
+    int int_size;
 
     //
     // Compute the actual size that different types of data will use when
@@ -81,7 +76,10 @@ obs_e_based_file_writer_txt
     //
     // WARNING - WARNING - WARNING - WARNING - WARNING - WARNING
     //
-    // These sizes must be set taking into acount the formats defined above!!!
+    // These sizes must be set taking into acount the formats defined in the
+    // constructor!!! When shortest_doubles_ is set, a double takes up to
+    // _ASTR_FORMAT_DOUBLE_MAX_SIZE characters and an integer up to
+    // _ASTR_FORMAT_INT_MAX_SIZE, instead.
     //
     // END OF WARNING - END OF WARNING - END OF WARNING - END OF WARNING
     //
@@ -95,13 +93,24 @@ obs_e_based_file_writer_txt
     // into account to perform the computation.
     //
 
+    if (shortest_doubles_)
+    {
+      double_size = _ASTR_FORMAT_DOUBLE_MAX_SIZE;
+      int_size    = _ASTR_FORMAT_INT_MAX_SIZE;
+    }
+    else
+    {
+      double_size = 23;
+      int_size    = 10;
+    }
+
     //
     // Fixed par of the l-record.
     //
 
     sizeof_fixed_l_ = (2 + 1 + 3 + 1 + 1 + 4 + 1 + 1 +3 + 2) + 1 + // Literal characters.
                        1                                         + // s attribute value .
-                      23;                                          // Time tag outside the opening tag.
+                      double_size;                                 // Time tag outside the opening tag.
 
     //
     // Fixed part of the o-record.
@@ -109,21 +118,21 @@ obs_e_based_file_writer_txt
 
     sizeof_fixed_o_ = (2 + 1 + 3 + 1 + 1 + 4 + 2) + 1 + // Literal characters.
                        1                              + // s attribute value.
-                      23;                               // Time tag outside the opening tag.
+                      double_size;                      // Time tag outside the opening tag.
 
     //
     // Size taken by a single double value (expectation, standard deviation
     // or auxiliar). Includes the whitespace preceding the double value itself.
     //
 
-    sizeof_double_value_ = 1 + 23;
+    sizeof_double_value_ = 1 + double_size;
 
     //
     // Size taken by a single integer value (identifiers). Includes the
     // whitespace preceding the integer value itself.
     //
 
-    sizeof_int_value_ = 1 + 10;
+    sizeof_int_value_ = 1 + int_size;
 
     //
     // Size taken by any (either l or o) tag. Includes the preceding whitespace,
@@ -137,6 +146,46 @@ obs_e_based_file_writer_txt
   }
 }
 
+obs_e_based_file_writer_txt::
+obs_e_based_file_writer_txt
+(void)
+{
+  {
+
+    //
+    // Instantiate and assign the fixed parts of the l- and o-records
+    // formats. Doing this here will reduce drastically the amount of
+    // instantiation / destruction operations needed by methods
+    // build_l_format() and build_o_format().
+    //
+    // Note that this is the place to change default formats for
+    // integer (o-records) or double (l-records) if ever needed as well
+    // as any other format involved in the process or "text writing".
+    //
+    // WARNING - WARNING - WARNING - WARNING - WARNING - WARNING
+    //
+    // Do not forget to update the size in bytes that the different
+    // part of the l- or o-records will use (see compute_value_sizes()).
+    //
+    // END OF WARNING - END OF WARNING - END OF WARNING - END OF WARNING
+    //
+
+    format_fixed_l_                    = strdup("<l s=\"%c\" id=\"%s\" n=\"%s\"> %23.15le");
+    format_fixed_o_                    = strdup("<o s=\"%c\" id=\"%s\"> %23.15le");
+    format_default_double_format_      = strdup(" %23.15le");
+    format_default_int_format_         = strdup(" %10ld");
+
+    //
+    // Values are written using the formats above until
+    // set_shortest_doubles() is called. Compute the size these take.
+    //
+
+    shortest_doubles_ = false;
+
+    compute_value_sizes();
+  }
+}
+
 obs_e_based_file_writer_txt::
 ~obs_e_based_file_writer_txt
 (void)
@@ -166,50 +215,92 @@ obs_e_based_file_writer_txt::
 
 int
 obs_e_based_file_writer_txt::
-write_l
-(bool         active,
- char*        identifier,
- int          instance_identifier,
- double       time,
- int          n_tags,
- double*      buffer_tags,
- int          n_expectations,
- double*      buffer_expectations,
- int          n_covariance_values,
- double*      buffer_covariance)
+print_double
+(char*  pchar,
+ double value)
 {
   {
-    int   bytes_written;
-    char  cactive;
-    int   i;
-    char* iidc;
-    char  instance_id[20];
-    int   n_double_elements;
-    char* pchar;
-    int   sizeof_identifier;
-    int   size_l_record;
-    int   status;
-    int   total_bytes_written;
+    if (!shortest_doubles_) return sprintf(pchar, format_default_double_format_, value);
 
-    // Won't work if the file is closed.
+    *pchar = ' ';
+    return 1 + astr_format_double(value, pchar + 1);
+  }
+}
 
-    if (!file_is_open_)        return 1;
+int
+obs_e_based_file_writer_txt::
+print_int
+(char* pchar,
+ int   value)
+{
+  {
+    if (!shortest_doubles_) return sprintf(pchar, format_default_int_format_, value);
 
-    // identifier must be at least 1 char long excluding the terminating NULL char.
+    *pchar = ' ';
+    return 1 + astr_format_int(value, pchar + 1);
+  }
+}
 
-    if (identifier == NULL)    return 4;
+int
+obs_e_based_file_writer_txt::
+print_text
+(char*       pchar,
+ const char* text)
+{
+  {
+    int size;
 
-    sizeof_identifier = (int)strlen(identifier);
-    if (sizeof_identifier < 1) return 4;
+    size = (int)strlen(text);
+    memcpy(pchar, text, (size_t)size);
 
-    // The dimensions of the several double arrays must be correct.
+    return size;
+  }
+}
 
-    if (n_tags < 0)            return 5;
-    if (n_expectations <= 0)   return 5;
-    if ((n_covariance_values != 0)              &
-        (n_covariance_values != n_expectations) &
-        (n_covariance_values != (n_expectations*(n_expectations+1))/2))
-                               return 5;
+int
+obs_e_based_file_writer_txt::
+set_shortest_doubles
+(bool enabled)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    shortest_doubles_ = enabled;
+
+    // Records may take a different amount of characters now.
+
+    compute_value_sizes();
+
+    // Bye.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_file_writer_txt::
+store_l_record
+(bool          active,
+ const char*   identifier,
+ int           instance_identifier,
+ double        time,
+ int           n_tags,
+ const double* buffer_tags,
+ int           n_expectations,
+ const double* buffer_expectations,
+ int           n_covariance_values,
+ const double* buffer_covariance)
+{
+  {
+    int   bytes_written;
+    char  cactive;
+    int   i;
+    char* iidc;
+    char  instance_id[20];
+    bool  new_epoch;
+    char* pchar;
+    int   total_bytes_written;
 
     //
     // Check if this is the first time we write to the file. If so, we
@@ -218,36 +309,18 @@ write_l
     // Note that inactive records do not change flags at all. We
     // simply write to the output file, but it is as if we wouldn't
     // written nothing at all from the flags standpoint.
+    // The first active record written, as well as any active one with
+    // a new time tag, starts an epoch.
     //
 
+    new_epoch = active && (first_time_writing_ || (time != last_time_tag_));
+
     if (active && first_time_writing_)
     {
       first_time_writing_ = false;
       last_time_tag_      = time;
     }
 
-    //
-    // Compute the size needed to store the current l record in the buffer.
-    // We'll use the different sizeof_* data members defined and initialized
-    // in the constructor.
-    //
-    // Note that it is only here that we may measure the size of the instance
-    // identifier (we don't want to write it in 10 positions, since it is
-    // surrounded by quotes and whitespace would look pretty horrible!).
-    //
-
-    iidc = &(instance_id[0]);
-    sprintf(iidc, "%d",instance_identifier);
-
-    n_double_elements = n_tags + n_expectations + n_covariance_values;
-
-    size_l_record = sizeof_fixed_l_                          +
-                    sizeof_identifier                        +
-                    (int)strlen(iidc)                        +
-                    sizeof_double_value_ * n_double_elements +
-                    sizeof_closing_tag_;
-
-
     //
     // Check if an epoch change is just arriving... Inactive records do
     // not change flags.
@@ -273,18 +346,11 @@ write_l
       first_l_written_ = false;
     }
 
-    //
-    // Check if enough room is still left in the data buffer. If not, flush
-    // the buffer to disk and start storing data again from its beginning.
-    //
+    // A new epoch starts here. Register it in the time index, if enabled.
 
-    if ((data_buffer_cur_ + size_l_record ) > data_buffer_size_)
+    if (new_epoch)
     {
-      status = flush();
-
-      // I/O error if status is not 0.
-
-      if (status != 0) return 2;
+      if (index_epoch(time) != 0) return 2;
     }
 
     //
@@ -296,6 +362,12 @@ write_l
     // - the tags (if any), expectations and covariance values (again, if any),
     // - the closing l tag plus the newline.
     //
+    // Note that the buffer may have been replaced while registering the
+    // epoch (see flush()).
+    //
+
+    iidc = &(instance_id[0]);
+    iidc[astr_format_int(instance_identifier, iidc)] = 0;
 
     total_bytes_written = 0;
     pchar = &(data_buffer_[data_buffer_cur_]);
@@ -305,7 +377,16 @@ write_l
     if (active) cactive = 'a';
     else        cactive = 'r';
 
-    bytes_written = sprintf(pchar, format_fixed_l_, cactive, identifier, iidc, time);
+    if (shortest_doubles_)
+    {
+      bytes_written  = print_text(pchar,                 active ? "<l s=\"a\" id=\"" : "<l s=\"r\" id=\"");
+      bytes_written += print_text(pchar + bytes_written, identifier);
+      bytes_written += print_text(pchar + bytes_written, "\" n=\"");
+      bytes_written += print_text(pchar + bytes_written, iidc);
+      bytes_written += print_text(pchar + bytes_written, "\">");
+      bytes_written += print_double(pchar + bytes_written, time);
+    }
+    else bytes_written = sprintf(pchar, format_fixed_l_, cactive, identifier, iidc, time);
     total_bytes_written += bytes_written;
     pchar += bytes_written;
 
@@ -313,7 +394,7 @@ write_l
 
     for (i = 0; i < n_tags; i++ )
     {
-      bytes_written = sprintf(pchar, format_default_double_format_, buffer_tags[i]);
+      bytes_written = print_double(pchar, buffer_tags[i]);
       total_bytes_written += bytes_written;
       pchar+= bytes_written;
     }
@@ -322,7 +403,7 @@ write_l
 
     for (i = 0; i < n_expectations; i++ )
     {
-      bytes_written = sprintf(pchar, format_default_double_format_, buffer_expectations[i]);
+      bytes_written = print_double(pchar, buffer_expectations[i]);
       total_bytes_written += bytes_written;
       pchar+= bytes_written;
     }
@@ -331,7 +412,7 @@ write_l
 
     for (i = 0; i < n_covariance_values; i++ )
     {
-      bytes_written = sprintf(pchar, format_default_double_format_, buffer_covariance[i]);
+      bytes_written = print_double(pchar, buffer_covariance[i]);
       total_bytes_written += bytes_written;
       pchar+= bytes_written;
     }
@@ -342,7 +423,7 @@ write_l
     // operating system used when compiling this code.
     //
 
-    bytes_written = sprintf(pchar, " </l>%s", NEWLINE);
+    bytes_written = print_text(pchar, " </l>" NEWLINE);
     total_bytes_written += bytes_written;
 
     // Update pointers.
@@ -362,3 +443,87 @@ write_l
     return 0;
   }
 }
+
+int
+obs_e_based_file_writer_txt::
+write_l
+(bool         active,
+ char*        identifier,
+ int          instance_identifier,
+ double       time,
+ int          n_tags,
+ double*      buffer_tags,
+ int          n_expectations,
+ double*      buffer_expectations,
+ int          n_covariance_values,
+ double*      buffer_covariance)
+{
+  {
+    char* iidc;
+    char  instance_id[20];
+    int   n_double_elements;
+    int   sizeof_identifier;
+    int   size_l_record;
+    int   status;
+
+    // Won't work if the file is closed.
+
+    if (!file_is_open_)        return 1;
+
+    // identifier must be at least 1 char long excluding the terminating NULL char.
+
+    if (identifier == NULL)    return 4;
+
+    sizeof_identifier = (int)strlen(identifier);
+    if (sizeof_identifier < 1) return 4;
+
+    // The dimensions of the several double arrays must be correct.
+
+    if (n_tags < 0)            return 5;
+    if (n_expectations <= 0)   return 5;
+    if ((n_covariance_values != 0)              &
+        (n_covariance_values != n_expectations) &
+        (n_covariance_values != (n_expectations*(n_expectations+1))/2))
+                               return 5;
+
+    //
+    // Compute the size needed to store the current l record in the buffer.
+    // We'll use the different sizeof_* data members defined and initialized
+    // in the constructor.
+    //
+    // Note that it is only here that we may measure the size of the instance
+    // identifier (we don't want to write it in 10 positions, since it is
+    // surrounded by quotes and whitespace would look pretty horrible!).
+    //
+
+    iidc = &(instance_id[0]);
+    iidc[astr_format_int(instance_identifier, iidc)] = 0;
+
+    n_double_elements = n_tags + n_expectations + n_covariance_values;
+
+    size_l_record = sizeof_fixed_l_                          +
+                    sizeof_identifier                        +
+                    (int)strlen(iidc)                        +
+                    sizeof_double_value_ * n_double_elements +
+                    sizeof_closing_tag_;
+
+    //
+    // Check if enough room is still left in the data buffer. If not, flush
+    // the buffer to disk and start storing data again from its beginning.
+    //
+
+    if ((data_buffer_cur_ + size_l_record ) > data_buffer_size_)
+    {
+      status = flush();
+
+      // I/O error if status is not 0.
+
+      if (status != 0) return 2;
+    }
+
+    // "Print" the record and update the flags.
+
+    return store_l_record(active, identifier, instance_identifier, time,
+                          n_tags, buffer_tags, n_expectations, buffer_expectations, n_covariance_values, buffer_covariance);
+  }
+}
@@ -4,6 +4,61 @@
 */ 
 #include "obs_e_based_socket_reader.hpp"
 
+void
+obs_e_based_socket_reader::
+accept_protocol
+(void)
+{
+  {
+    char answer[2 * _ASTROLABE_SOCKET_XDR_INT_SIZE];
+    int  version;
+    int  window;
+
+    // Decode the protocol version and the window wanted by the writer.
+
+    decoder_stream_->simple(version);
+    decoder_stream_->simple(window);
+
+    //
+    // Grant the windowed protocol (or any newer one, that writers must
+    // be ready to give up) if both ends want a window.
+    //
+
+    if ((version >= _ASTROLABE_SOCKET_PROTOCOL_WINDOWED) && (window > 1) && (max_window_ > 1))
+    {
+      protocol_version_ = _ASTROLABE_SOCKET_PROTOCOL_WINDOWED;
+      window_           = (window < max_window_) ? window : max_window_;
+    }
+    else
+    {
+      protocol_version_ = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+      window_           = 1;
+    }
+
+    //
+    // Acknowledge half a window at once, so the writer never runs out of
+    // window while the acknowledgement travels.
+    //
+
+    ack_interval_    = (window_ + 1) / 2;
+    unacked_records_ = 0;
+
+    //
+    // Acknowledgements must not wait for the previous ones to be
+    // acknowledged by TCP, since the writer may be waiting for them.
+    //
+
+    if (protocol_version_ == _ASTROLABE_SOCKET_PROTOCOL_WINDOWED) socket_->setNoDelay(true);
+
+    // Answer.
+
+    astr_socket_put_int(answer, protocol_version_);
+    astr_socket_put_int(answer + _ASTROLABE_SOCKET_XDR_INT_SIZE, window_);
+
+    socket_->send(answer, 2 * _ASTROLABE_SOCKET_XDR_INT_SIZE);
+  }
+}
+
 int
 obs_e_based_socket_reader::
 close
@@ -78,6 +133,8 @@ obs_e_based_socket_reader
 (void)
 {
   {
+    ack_interval_               = 1;
+
     data_buffer_                = NULL;
     data_buffer_size_           = _EVENT_SOCKET_READER_DEFAULT_BUFFER_SIZE;
 
@@ -95,8 +152,13 @@ obs_e_based_socket_reader
 
     is_eof_                     = false;
 
+    max_window_                 = _ASTROLABE_SOCKET_DEFAULT_MAX_WINDOW;
+
     o_records_allowed_          = true;
 
+    protocol_is_settled_        = false;
+    protocol_version_           = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+
     read_active_flag_           = false;
     read_completed_             = true;
     read_identifier_            = false;
@@ -114,6 +176,15 @@ obs_e_based_socket_reader
     server_socket_              = NULL;
     socket_                     = NULL;
     socket_is_open_             = false;
+
+    unacked_records_            = 0;
+
+    view_doubles_               = NULL;
+    view_doubles_size_          = 0;
+    view_ints_                  = NULL;
+    view_ints_size_             = 0;
+
+    window_                     = 1;
   }
 }
 
@@ -123,6 +194,9 @@ obs_e_based_socket_reader::
 {
   {
     if (socket_is_open_) close();
+
+    if (view_doubles_ != NULL) delete [] view_doubles_;
+    if (view_ints_    != NULL) delete [] view_ints_;
   }
 }
 
@@ -133,6 +207,35 @@ get_full_record
 {
   {
     int  bytesReceived; // Total bytes read
+    char lengthBuffer[_ASTROLABE_SOCKET_XDR_INT_SIZE];
+    int  record_length;
+
+    //
+    // Windowed protocol: records are preceded by their length, and may
+    // arrive split or along with others, so read exactly what's needed.
+    //
+
+    if (protocol_version_ == _ASTROLABE_SOCKET_PROTOCOL_WINDOWED)
+    {
+      astr_socket_recv_all(socket_, lengthBuffer, _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+      record_length = astr_socket_get_int(lengthBuffer);
+
+      if ((record_length < 1) || (record_length > data_buffer_size_))
+      {
+        throw SocketException("Invalid record length"); // Protocol error.
+      }
+
+      astr_socket_recv_all(socket_, data_buffer_, record_length);
+
+      // Acknowledge the records received so far once in a while.
+
+      unacked_records_++;
+
+      if (unacked_records_ >= ack_interval_) send_ack();
+
+      return;
+    }
 
     //
     // Get a full data record. These are sent at once.
@@ -167,6 +270,17 @@ get_full_record
   }
 }
 
+int
+obs_e_based_socket_reader::
+get_window
+(void)
+const
+{
+  {
+    return window_;
+  }
+}
+
 bool
 obs_e_based_socket_reader::
 is_eof
@@ -262,6 +376,17 @@ open
       }
     }
 
+    //
+    // Every connection starts with the stop-and-wait protocol. The writer
+    // may ask for another one before sending its first record.
+    //
+
+    ack_interval_        = 1;
+    protocol_is_settled_ = false;
+    protocol_version_    = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+    unacked_records_     = 0;
+    window_              = 1;
+
     // Update flags.
 
     socket_is_open_ = true;
@@ -503,6 +628,57 @@ read_l_data
   }
 }
 
+int
+obs_e_based_socket_reader::
+read_l_data_view
+(int                    n_tag_values,
+ astrolabe_double_view& the_tags,
+ int                    n_expectation_values,
+ astrolabe_double_view& the_expectations,
+ int&                   n_covariance_values_found,
+ astrolabe_double_view& the_covariance_values)
+{
+  {
+    double* covariances;
+    double* expectations;
+    int     n_doubles;
+    int     status;
+    double* tags;
+
+    // Check dimensions; these are needed to size the scratch area.
+
+    if (n_tag_values < 0)          return 6;
+    if (n_expectation_values <= 0) return 6;
+
+    // Worst case: tags, expectations and a full covariance matrix.
+
+    n_doubles = n_tag_values + n_expectation_values +
+                (n_expectation_values * (n_expectation_values + 1)) / 2;
+
+    reserve_view_storage(n_doubles, 0);
+
+    tags         = view_doubles_;
+    expectations = tags + n_tag_values;
+    covariances  = expectations + n_expectation_values;
+
+    // Decode the values into the scratch area.
+
+    status = read_l_data(n_tag_values,              tags,
+                         n_expectation_values,      expectations,
+                         n_covariance_values_found, covariances);
+
+    if (status != 0) return status;
+
+    // Publish the views.
+
+    the_tags.set             (tags,         n_tag_values);
+    the_expectations.set     (expectations, n_expectation_values);
+    the_covariance_values.set(covariances,  n_covariance_values_found);
+
+    return 0;
+  }
+}
+
 int
 obs_e_based_socket_reader::
 read_instance_id
@@ -659,6 +835,52 @@ read_o_data
   }
 }
 
+int
+obs_e_based_socket_reader::
+read_o_data_view
+(int                 n_parameter_iids,
+ astrolabe_int_view& the_parameter_iids,
+ int                 n_observation_iids,
+ astrolabe_int_view& the_observation_iids,
+ int                 n_instrument_iids,
+ astrolabe_int_view& the_instrument_iids)
+{
+  {
+    int* instruments;
+    int* observations;
+    int* parameters;
+    int  status;
+
+    // Check dimensions; these are needed to size the scratch area.
+
+    if (n_parameter_iids   <= 0) return 6;
+    if (n_observation_iids <= 0) return 6;
+    if (n_instrument_iids  <  0) return 6;
+
+    reserve_view_storage(0, n_parameter_iids + n_observation_iids + n_instrument_iids);
+
+    parameters   = view_ints_;
+    observations = parameters + n_parameter_iids;
+    instruments  = observations + n_observation_iids;
+
+    // Decode the values into the scratch area.
+
+    status = read_o_data(n_parameter_iids,   parameters,
+                         n_observation_iids, observations,
+                         n_instrument_iids,  instruments);
+
+    if (status != 0) return status;
+
+    // Publish the views.
+
+    the_parameter_iids.set  (parameters,   n_parameter_iids);
+    the_observation_iids.set(observations, n_observation_iids);
+    the_instrument_iids.set (instruments,  n_instrument_iids);
+
+    return 0;
+  }
+}
+
 int
 obs_e_based_socket_reader::
 read_time
@@ -803,41 +1025,87 @@ read_type
     // since it arrives stored in the same place that the record type.
     //
 
-    try
-    {
-      //
-      // get_full_record() stores the data read in the underlying
-      // buffer used by our decoders (data_buffer_).
-      //
-      // get_full_record(), by the way, reads data from the socket
-      // connection!
-      //
+    //
+    // The first message may be the request to use the windowed protocol
+    // (the hello command). It is answered here, and then the actual
+    // record is read.
+    //
 
-      get_full_record();
-    }
-    catch (...)
+    do
     {
-      // Problems reading the socket. We'll report a read error condition.
-      return 2;
-    }
+      try
+      {
+        //
+        // get_full_record() stores the data read in the underlying
+        // buffer used by our decoders (data_buffer_).
+        //
+        // get_full_record(), by the way, reads data from the socket
+        // connection!
+        //
+
+        get_full_record();
+      }
+      catch (...)
+      {
+        // Problems reading the socket. We'll report a read error condition.
+        return 2;
+      }
 
-    // Let's decode the type. Beware: it may be the end-of-file command!
+      // Let's decode the type. Beware: it may be the end-of-file command!
 
-    try
-    {
-      decoder_membuf_->rewind(); // So we start again from the beginning of the buffer.
-      decoder_stream_->cstring(the_type, 1);
-    }
-    catch (...)
-    {
-      // Error decoding the type. We'll report a read error condition.
-      return 2;
+      try
+      {
+        decoder_membuf_->rewind(); // So we start again from the beginning of the buffer.
+        decoder_stream_->cstring(the_type, 1);
+      }
+      catch (...)
+      {
+        // Error decoding the type. We'll report a read error condition.
+        return 2;
+      }
+
+      if (the_type[0] == 'v')
+      {
+        // Too late to change the protocol.
+
+        if (protocol_is_settled_) return 4;
+
+        try
+        {
+          accept_protocol();
+        }
+        catch (...)
+        {
+          // Error decoding the request or sending the answer.
+          return 2;
+        }
+      }
+
+      protocol_is_settled_ = true;
     }
+    while (the_type[0] == 'v');
 
     // Have we received the "end-of-file" command?
 
     if (the_type[0] == 'e')
     {
+      //
+      // With the windowed protocol, the writer waits for every record
+      // to be acknowledged before closing the connection.
+      //
+
+      if (unacked_records_ > 0)
+      {
+        try
+        {
+          send_ack();
+        }
+        catch (...)
+        {
+          return 2;
+        }
+      }
+
       // End of transmission!!!
 
       is_eof_ = true;
@@ -878,3 +1146,66 @@ read_type
     return 0;
   }
 }
+
+void
+obs_e_based_socket_reader::
+reserve_view_storage
+(int n_doubles,
+ int n_ints)
+{
+  {
+    // Grow (never shrink) the scratch areas when needed.
+
+    if (n_doubles > view_doubles_size_)
+    {
+      if (view_doubles_ != NULL) delete [] view_doubles_;
+
+      view_doubles_      = new double[n_doubles];
+      view_doubles_size_ = n_doubles;
+    }
+
+    if (n_ints > view_ints_size_)
+    {
+      if (view_ints_ != NULL) delete [] view_ints_;
+
+      view_ints_      = new int[n_ints];
+      view_ints_size_ = n_ints;
+    }
+  }
+}
+
+void
+obs_e_based_socket_reader::
+send_ack
+(void)
+{
+  {
+    char ack[_ASTROLABE_SOCKET_XDR_INT_SIZE];
+
+    // A single, cumulative, acknowledgement for all of them.
+
+    astr_socket_put_int(ack, unacked_records_);
+
+    socket_->send(ack, _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+    unacked_records_ = 0;
+  }
+}
+
+int
+obs_e_based_socket_reader::
+set_max_window
+(int n_records)
+{
+  {
+    // The window must be decided before opening the connection.
+
+    if (socket_is_open_) return 1;
+
+    if (n_records < 1)   return 2;
+
+    max_window_ = n_records;
+
+    return 0;
+  }
+}
@@ -7,6 +7,8 @@
 #define OBS_E_BASED_SOCKET_READER_HPP
 
 #include "PracticalSocket.h"
+#include "astrolabe_array_view.hpp"
+#include "astrolabe_socket_utilities.hpp"
 
 #include <xtl/objio.h>
 #include <xtl/xdr.h>
@@ -76,6 +78,12 @@
  *   Closing the reader will disable any further I/O read operations.
  * - The reader object may be destroyed.
  *
+ * Both the classic stop-and-wait protocol and the windowed one (see
+ * astrolabe_socket_utilities.hpp) are understood. Writers asking for the
+ * windowed protocol are granted a window no greater than the one set with
+ * set_max_window(). Records are then acknowledged in groups of half the
+ * window, so the writer keeps on sending while they are being read.
+ *
  */
 
 class obs_e_based_socket_reader
@@ -162,6 +170,20 @@ class obs_e_based_socket_reader
 
          ~obs_e_based_socket_reader (void);
 
+    /**
+     * \brief Retrieve the window agreed with the writer.
+     *
+     * \return The maximum number of records that the writer may send
+     *         without waiting for their acknowledgement. One means that
+     *         the stop-and-wait protocol is in use.
+     *
+     * The writer asks for the windowed protocol, if it wants to, before
+     * sending its first record, so the window is only known after the
+     * first call to read_type().
+     */
+
+    int  get_window                 (void) const;
+
     /**
      * \brief Check if the data in socket channel has been completely read.
      *
@@ -356,6 +378,36 @@ class obs_e_based_socket_reader
                                      int&     n_covariance_values_found,
                                      double*& the_covariance_values);
 
+    /**
+     * \brief Read (receive) the tags, expectations and covariance matrix
+     *        values in an l-record, returning read-only views instead of
+     *        filling caller-provided arrays.
+     *
+     * \param n_tag_values Number of tag values that must be read from
+     *        the l-record. May be zero, since tags are optional.
+     * \param the_tags On output, view of the n_tag_values tags.
+     * \param n_expectation_values Number of expectation values that must be
+     *        read from the l-record. Must be greater than 0.
+     * \param the_expectations On output, view of the expectations.
+     * \param n_covariance_values_found Actual number of covariance matrix
+     *        values found in the l-record.
+     * \param the_covariance_values On output, view of the covariance matrix
+     *        values.
+     * \return Error code. The same ones returned by read_l_data().
+     *
+     * Data received through a socket must be XDR decoded, so values are
+     * staged in a scratch area owned by the reader and reused from record
+     * to record. The calling module needs no buffers of its own, though.
+     * The views remain valid until the next call to read_type().
+     */
+
+    int  read_l_data_view           (int                    n_tag_values,
+                                     astrolabe_double_view& the_tags,
+                                     int                    n_expectation_values,
+                                     astrolabe_double_view& the_expectations,
+                                     int&                   n_covariance_values_found,
+                                     astrolabe_double_view& the_covariance_values);
+
     /**
      * \brief Reads (receives) the instance identifier in an l-record.
      *
@@ -442,6 +494,35 @@ class obs_e_based_socket_reader
                                      int   n_instrument_iids,
                                      int*& the_instrument_iids);
 
+    /**
+     * \brief Read (receive) the lists of parameter, observation and instrument
+     *        instance identifiers from an o-record, returning read-only views
+     *        instead of filling caller-provided arrays.
+     *
+     * \param n_parameter_iids Total number of parameter instance identifiers
+     *        to read. Must be greater than 0.
+     * \param the_parameter_iids On output, view of the parameter instance
+     *        identifiers.
+     * \param n_observation_iids Total number of observation instance identifiers
+     *        to read. Must be greater than 0.
+     * \param the_observation_iids On output, view of the observation instance
+     *        identifiers.
+     * \param n_instrument_iids Total number of instrument instance identifiers
+     *        to read. May be zero.
+     * \param the_instrument_iids On output, view of the instrument instance
+     *        identifiers.
+     * \return Error code. The same ones returned by read_o_data().
+     *
+     * See read_l_data_view() for the lifetime of the views.
+     */
+
+    int  read_o_data_view           (int                 n_parameter_iids,
+                                     astrolabe_int_view& the_parameter_iids,
+                                     int                 n_observation_iids,
+                                     astrolabe_int_view& the_observation_iids,
+                                     int                 n_instrument_iids,
+                                     astrolabe_int_view& the_instrument_iids);
+
     /**
      * \brief Reads (receives) the time tag, either for l- or o-records.
      *
@@ -497,7 +578,9 @@ class obs_e_based_socket_reader
      *         - 6: NOT USED.
      *
      * read_type() is the method that starts the process of reading a
-     * full event record, either l- or o-.
+     * full event record, either l- or o-. The request to use the windowed
+     * protocol, if any, is answered by the first call to this method, and
+     * is never seen by the caller.
      *
      * It may be invoked right after open(), read_l_data() or read_o_data()
      * have been called only. Using this method at any other moment will
@@ -529,8 +612,38 @@ class obs_e_based_socket_reader
 
     int  read_type                  (char& record_type);
 
+    /**
+     * \brief Set the maximum window granted to writers asking for the
+     *        windowed protocol.
+     *
+     * \param n_records The maximum window. One makes the reader answer
+     *        that only the stop-and-wait protocol is available.
+     * \return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The socket is already open.
+     *         - 2: The window must be greater than zero.
+     *
+     * The window bounds the number of records (not acknowledged yet) that
+     * may be waiting in the buffers of the connection. By default, it is
+     * _ASTROLABE_SOCKET_DEFAULT_MAX_WINDOW.
+     */
+
+    int  set_max_window             (int n_records);
+
   protected:
 
+    /**
+     * \brief Answer the request to use the windowed protocol.
+     *
+     * \throw SocketException Unable to send the answer.
+     *
+     * The protocol version and the window wanted by the writer are decoded
+     * from the hello command in the internal buffer. protocol_version_,
+     * window_ and ack_interval_ are set according to the answer sent.
+     */
+
+    void accept_protocol            (void);
+
     /**
      * \brief Reads a full record using the open socket connection.
      *
@@ -549,13 +662,40 @@ class obs_e_based_socket_reader
      * is a single byte (its contents does not matter at all; what is
      * important is to send one single byte back to the writer).
      *
+     * With the windowed protocol, the record is preceded by its length,
+     * and the acknowledgement is only sent once ack_interval_ records
+     * have been received (see send_ack()).
+     *
      */
 
     void get_full_record            (void);
 
+    /**
+     * \brief Make sure that the scratch areas used by read_l_data_view()
+     *        and read_o_data_view() are big enough.
+     *
+     * \param n_doubles Minimum number of doubles in view_doubles_.
+     * \param n_ints Minimum number of integers in view_ints_.
+     */
+
+    void reserve_view_storage       (int n_doubles, int n_ints);
+
+    /**
+     * \brief Acknowledge the records received with the windowed protocol
+     *        that have not been acknowledged yet (unacked_records_).
+     *
+     * \throw SocketException Unable to send the acknowledgement.
+     */
+
+    void send_ack                   (void);
 
   protected:
 
+    /// \brief Number of records acknowledged at once with the windowed
+    /// protocol.
+
+    int                                 ack_interval_;
+
     /// \brief The data_buffer_ where received data will be stored.
 
     char*                               data_buffer_;
@@ -608,6 +748,10 @@ class obs_e_based_socket_reader
 
     bool                                last_record_is_active_;
 
+    /// \brief Maximum window granted to writers (see set_max_window()).
+
+    int                                 max_window_;
+
     ///
     /// \brief Flag that states whether reading o-records is legal. Some descendant
     /// classes (as parameter readers for example) do not accept o-records. Setting
@@ -617,6 +761,16 @@ class obs_e_based_socket_reader
 
     bool                                o_records_allowed_;
 
+    /// \brief Flag. True once the first message has been received, so the
+    /// protocol may not be changed anymore.
+
+    bool                                protocol_is_settled_;
+
+    /// \brief Protocol in use (_ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT or
+    /// _ASTROLABE_SOCKET_PROTOCOL_WINDOWED).
+
+    int                                 protocol_version_;
+
 
     /// \brief Control flag. When true, it indicates that a call to read_active_flag()
     /// has already been made for the current record.
@@ -687,6 +841,31 @@ class obs_e_based_socket_reader
 
     bool                                socket_is_open_;
 
+    /// \brief Number of records received with the windowed protocol and not
+    /// acknowledged yet.
+
+    int                                 unacked_records_;
+
+    /// \brief Scratch area used to stage doubles returned as views.
+
+    double*                             view_doubles_;
+
+    /// \brief Size (number of doubles) of view_doubles_.
+
+    int                                 view_doubles_size_;
+
+    /// \brief Scratch area used to stage integers returned as views.
+
+    int*                                view_ints_;
+
+    /// \brief Size (number of integers) of view_ints_.
+
+    int                                 view_ints_size_;
+
+    /// \brief Window agreed with the writer (see get_window()).
+
+    int                                 window_;
+
 };
 
 #endif // OBS_E_BASED_SOCKET_READER_HPP
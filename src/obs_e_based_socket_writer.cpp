@@ -45,10 +45,15 @@ close
     try
     {
       // Send the EOF command.
-      socket_->send(coder_membuf_->data(), coder_membuf_->size());
+      send_record();
 
-      // Wait for the acknowledgement sent by the receiver.
-      getACK();
+      //
+      // Wait for the acknowledgement sent by the receiver. With the
+      // windowed protocol, the records not acknowledged yet are
+      // acknowledged along with the EOF command.
+      //
+
+      while (outstanding_records_ > 0) getACK();
 
     }
     catch(SocketException &)
@@ -113,10 +118,14 @@ obs_e_based_socket_writer
     host_                = "";
     last_time_tag_       = 0.0;
     o_records_allowed_   = true;
+    outstanding_records_ = 0;
     port_                = 0;
+    protocol_version_    = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+    requested_window_    = 1;
     server_socket_       = NULL;
     socket_              = NULL;
     socket_is_open_      = false;
+    window_              = 1;
 
   }
 }
@@ -138,8 +147,30 @@ getACK
   {
     char echoBuffer[1];      // Buffer for 1 acknowledgement character.
     int  bytesReceived;      // Bytes read on each recv()
+    char countBuffer[_ASTROLABE_SOCKET_XDR_INT_SIZE];
+    int  n_acknowledged;
     int  totalBytesReceived; // Total bytes read
 
+    //
+    // Windowed protocol: the acknowledgement is an XDR int with the number
+    // of messages acknowledged at once.
+    //
+
+    if (protocol_version_ == _ASTROLABE_SOCKET_PROTOCOL_WINDOWED)
+    {
+      astr_socket_recv_all(socket_, countBuffer, _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+      n_acknowledged = astr_socket_get_int(countBuffer);
+
+      if ((n_acknowledged < 1) || (n_acknowledged > outstanding_records_))
+      {
+        throw SocketException("Invalid acknowledgement"); // Protocol error.
+      }
+
+      outstanding_records_ -= n_acknowledged;
+      return;
+    }
+
     bytesReceived = 0;
     totalBytesReceived = 0;  
 
@@ -160,6 +191,17 @@ getACK
   }
 }
 
+int
+obs_e_based_socket_writer::
+get_window
+(void)
+const
+{
+  {
+    return window_;
+  }
+}
+
 bool
 obs_e_based_socket_writer::
 is_open
@@ -171,6 +213,61 @@ const
   }
 }
 
+void
+obs_e_based_socket_writer::
+negotiate_protocol
+(void)
+{
+  {
+    char answer[2 * _ASTROLABE_SOCKET_XDR_INT_SIZE];
+    int  version;
+    int  window;
+
+    // Encode the hello command: protocol version and window wanted.
+
+    version = _ASTROLABE_SOCKET_PROTOCOL_WINDOWED;
+
+    coder_membuf_->rewind();
+    coder_stream_->cstring("v", 1);
+    coder_stream_->simple(version);
+    coder_stream_->simple(requested_window_);
+
+    //
+    // The hello command travels and is acknowledged as any other message
+    // of the stop-and-wait protocol. Then, the receiver answers. Old
+    // receivers never do, so don't wait for them forever: a timeout
+    // throws, as a broken connection does.
+    //
+
+    socket_->setRecvTimeout(_ASTROLABE_SOCKET_HELLO_TIMEOUT);
+
+    send_record();
+
+    astr_socket_recv_all(socket_, answer, 2 * _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+    socket_->setRecvTimeout(0);
+
+    version = astr_socket_get_int(answer);
+    window  = astr_socket_get_int(answer + _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+    // Keep on using stop-and-wait unless the receiver agrees.
+
+    if ((version == _ASTROLABE_SOCKET_PROTOCOL_WINDOWED) && (window > 1))
+    {
+      protocol_version_ = _ASTROLABE_SOCKET_PROTOCOL_WINDOWED;
+      window_           = (window < requested_window_) ? window : requested_window_;
+
+      //
+      // Several records are now in flight. Coalescing small writes would
+      // hold them until the previous ones are acknowledged by TCP, which
+      // the receiver delays, since it answers once every several records.
+      //
+
+      socket_->setNoDelay(true);
+    }
+  }
+}
+
 int
 obs_e_based_socket_writer::
 open
@@ -257,12 +354,15 @@ open
       // Instantiate a data buffer with the proper size.
       //
 
-      data_buffer_     = new char[data_buffer_size_];
+      data_buffer_     = new char[_ASTROLABE_SOCKET_XDR_INT_SIZE + data_buffer_size_];
       socket_is_open_  = true;
 
-      // Set up the stack of XDR objects needed to write XDR coded data.
+      //
+      // Set up the stack of XDR objects needed to write XDR coded data. The
+      // room before the encoded data is used to store its length.
+      //
 
-      coder_membuf_    = new mem_buffer(data_buffer_, data_buffer_size_);
+      coder_membuf_    = new mem_buffer(data_buffer_ + _ASTROLABE_SOCKET_XDR_INT_SIZE, data_buffer_size_);
       coder_formatter_ = new XDR_format<mem_buffer>(*coder_membuf_);
       coder_stream_    = new obj_output<XDR_format<mem_buffer> >(*coder_formatter_);
 
@@ -279,6 +379,50 @@ open
       return 3;
     }
 
+    //
+    // Every connection starts with the stop-and-wait protocol. Ask for
+    // the windowed one if a window has been set.
+    //
+
+    outstanding_records_ = 0;
+    protocol_version_    = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+    window_              = 1;
+
+    if (requested_window_ > 1)
+    {
+      try
+      {
+        negotiate_protocol();
+      }
+      catch (...)
+      {
+        //
+        // The receiver does not understand the hello command, or the
+        // connection is broken. There's no point in sending the
+        // end-of-file command; just drop the connection.
+        //
+
+        if (socket_        != NULL) delete socket_;
+        if (server_socket_ != NULL) delete server_socket_;
+
+        socket_        = NULL;
+        server_socket_ = NULL;
+
+        delete coder_membuf_;
+        delete coder_formatter_;
+        delete coder_stream_;
+        delete [] data_buffer_;
+
+        coder_membuf_    = NULL;
+        coder_formatter_ = NULL;
+        coder_stream_    = NULL;
+        data_buffer_     = NULL;
+
+        socket_is_open_ = false;
+        return 2;
+      }
+    }
+
     // Successful completion.
 
     return 0;
@@ -287,9 +431,10 @@ open
 
 int
 obs_e_based_socket_writer::
-write_l
+send_l_record
 (bool         active,
  char*        identifier,
+ int          sizeof_identifier,
  int          instance_identifier,
  double       time,
  int          n_tags,
@@ -300,28 +445,6 @@ write_l
  double*      buffer_covariance)
 {
   {
-    int sizeof_identifier;
-
-    // We need an open socket connection to work.
-
-    if (!socket_is_open_)      return 1;
-
-    // identifier must be at least 1 char long excluding the terminating NULL char.
-
-    if (identifier == NULL)    return 4;
-
-    sizeof_identifier = (int)strlen(identifier);
-    if (sizeof_identifier < 1) return 4;
-
-    // The dimensions of the several double arrays must be correct.
-
-    if (n_tags < 0)            return 5;
-    if (n_expectations <= 0)   return 5;
-    if ((n_covariance_values != 0)              &
-        (n_covariance_values != n_expectations) &
-        (n_covariance_values != (n_expectations*(n_expectations+1))/2))
-                               return 5;
-
     //
     // Check if this is the first time we write to the socket. If so, we
     // must give an initial value to the last time tag in use.
@@ -460,10 +583,7 @@ write_l
     try
     {
       // Send data.
-      socket_->send(coder_membuf_->data(), coder_membuf_->size());
-
-      // Wait for the acknowledgement sent by the receiver.
-      getACK();
+      send_record();
     }
     catch(SocketException &)
     {
@@ -488,9 +608,10 @@ write_l
 
 int
 obs_e_based_socket_writer::
-write_o
+send_o_record
 (bool         active,
  char*        identifier,
+ int          sizeof_identifier,
  double       time,
  int          n_parameter_iids,
  int*         the_parameter_iids,
@@ -500,59 +621,6 @@ write_o
  int*         the_instrument_iids)
 {
   {
-    int   sizeof_identifier;
-
-    // Won't work if no o-records are allowed.
-
-    if (!o_records_allowed_) return 3;
-
-    // Won't work if the socket is not ready.
-
-    if (!socket_is_open_) return 1;
-
-    //
-    // Won't work neither if no l-records have been written yet for the
-    // current time tag. This test, however, makes sense only when
-    // writing ACTIVE o-records. Inactive ones are always written,
-    // no matter what the situation is.
-    //
-
-    if (active && (!first_l_written_)) return 3;
-
-    // identifier must contain something.
-
-    if (identifier == NULL) return 4;
-
-    sizeof_identifier = (int)strlen(identifier);
-    if (sizeof_identifier < 1) return 4;
-
-    //
-    // We'll still refuse to do anything if the number of identifier does not
-    // match with what we're expecting.
-    //
-
-    if (n_parameter_iids   <= 0) return 7;
-    if (n_observation_iids <= 0) return 7;
-    if (n_instrument_iids  <  0) return 7;
-
-    //
-    // Check if an epoch change is just arriving... Here, the problem
-    // of the no l-records written could arise too.
-    //
-    // Note that this only matters when the record is active. Otherwise,
-    // we simply write data but change NO flags at all.
-    //
-
-    if (active && (time != last_time_tag_))
-    {
-      //
-      // Ooops! This is the first record in an epoch and we are trying to
-      // write an o-record. This is an error!
-      //
-
-      return 3;
-    }
-
     //
     // Write the o-record to the socket.
     //
@@ -650,10 +718,7 @@ write_o
     try
     {
       // Send data
-      socket_->send(coder_membuf_->data(), coder_membuf_->size());
-
-      // Wait for the acknowledgement sent by the receiver.
-      getACK();
+      send_record();
     }
     catch(SocketException &)
     {
@@ -668,3 +733,289 @@ write_o
   }
 }
 
+void
+obs_e_based_socket_writer::
+send_record
+(void)
+{
+  {
+    int size;
+
+    size = coder_membuf_->size();
+
+    // Stop-and-wait: send the message as is and wait for its acknowledgement.
+
+    if (protocol_version_ != _ASTROLABE_SOCKET_PROTOCOL_WINDOWED)
+    {
+      socket_->send(coder_membuf_->data(), size);
+      getACK();
+      return;
+    }
+
+    //
+    // Windowed protocol. Wait only if the window is full; then, send the
+    // length of the message and the message itself at once.
+    //
+
+    while (outstanding_records_ >= window_) getACK();
+
+    astr_socket_put_int(data_buffer_, size);
+
+    socket_->send(data_buffer_, _ASTROLABE_SOCKET_XDR_INT_SIZE + size);
+
+    outstanding_records_++;
+  }
+}
+
+int
+obs_e_based_socket_writer::
+set_window
+(int n_records)
+{
+  {
+    // The window must be decided before opening the connection.
+
+    if (socket_is_open_) return 1;
+
+    if (n_records < 1)   return 2;
+
+    requested_window_ = n_records;
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_socket_writer::
+write_epoch
+(const observation_epoch& epoch)
+{
+  {
+    bool   active;
+    bool   l_written;
+    double last_time;
+    int    n_covariance_values;
+    int    n_expectations;
+    int    n_records;
+    int    record;
+    bool   started;
+    int    status;
+    double time;
+
+    // We need an open socket connection to work.
+
+    if (!socket_is_open_) return 1;
+
+    n_records = epoch.get_n_records();
+
+    //
+    // Validate the whole epoch before sending anything, replaying the
+    // checks write_l() and write_o() would make on the flags. Inactive
+    // records never change flags.
+    //
+
+    l_written = first_l_written_;
+    last_time = last_time_tag_;
+    started   = !first_time_writing_;
+
+    for (record = 0; record < n_records; record++)
+    {
+      active = epoch.get_active(record);
+      time   = epoch.get_record_time(record);
+
+      if (epoch.get_type(record) == 'l')
+      {
+        if (strlen(epoch.get_identifier(record)) < 1) return 4;
+
+        n_expectations      = epoch.get_n_expectations(record);
+        n_covariance_values = epoch.get_n_covariance_values(record);
+
+        if (epoch.get_n_tags(record) < 0) return 5;
+        if (n_expectations <= 0)          return 5;
+        if ((n_covariance_values != 0)              &
+            (n_covariance_values != n_expectations) &
+            (n_covariance_values != (n_expectations*(n_expectations+1))/2))
+                                          return 5;
+
+        if (active)
+        {
+          l_written = true;
+          last_time = time;
+          started   = true;
+        }
+      }
+      else
+      {
+        if (!o_records_allowed_)                           return 3;
+        if (active && (!l_written))                        return 3;
+        if (strlen(epoch.get_identifier(record)) < 1)      return 4;
+        if (epoch.get_n_parameter_iids(record)   <= 0)     return 7;
+        if (epoch.get_n_observation_iids(record) <= 0)     return 7;
+        if (epoch.get_n_instrument_iids(record)  <  0)     return 7;
+        if (active && ((!started) || (time != last_time))) return 3;
+      }
+    }
+
+    //
+    // Send the records. Nothing may fail now but the connection. Each
+    // record is still acknowledged by the receiver.
+    //
+
+    for (record = 0; record < n_records; record++)
+    {
+      if (epoch.get_type(record) == 'l')
+      {
+        status = send_l_record(epoch.get_active(record),
+                               (char*)epoch.get_identifier(record),
+                               (int)strlen(epoch.get_identifier(record)),
+                               epoch.get_instance_id(record),
+                               epoch.get_record_time(record),
+                               epoch.get_n_tags(record),
+                               (double*)epoch.get_tags(record),
+                               epoch.get_n_expectations(record),
+                               (double*)epoch.get_expectations(record),
+                               epoch.get_n_covariance_values(record),
+                               (double*)epoch.get_covariance_values(record));
+      }
+      else
+      {
+        status = send_o_record(epoch.get_active(record),
+                               (char*)epoch.get_identifier(record),
+                               (int)strlen(epoch.get_identifier(record)),
+                               epoch.get_record_time(record),
+                               epoch.get_n_parameter_iids(record),
+                               (int*)epoch.get_parameter_iids(record),
+                               epoch.get_n_observation_iids(record),
+                               (int*)epoch.get_observation_iids(record),
+                               epoch.get_n_instrument_iids(record),
+                               (int*)epoch.get_instrument_iids(record));
+      }
+
+      if (status != 0) return status;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+obs_e_based_socket_writer::
+write_l
+(bool         active,
+ char*        identifier,
+ int          instance_identifier,
+ double       time,
+ int          n_tags,
+ double*      buffer_tags,
+ int          n_expectations,
+ double*      buffer_expectations,
+ int          n_covariance_values,
+ double*      buffer_covariance)
+{
+  {
+    int sizeof_identifier;
+
+    // We need an open socket connection to work.
+
+    if (!socket_is_open_)      return 1;
+
+    // identifier must be at least 1 char long excluding the terminating NULL char.
+
+    if (identifier == NULL)    return 4;
+
+    sizeof_identifier = (int)strlen(identifier);
+    if (sizeof_identifier < 1) return 4;
+
+    // The dimensions of the several double arrays must be correct.
+
+    if (n_tags < 0)            return 5;
+    if (n_expectations <= 0)   return 5;
+    if ((n_covariance_values != 0)              &
+        (n_covariance_values != n_expectations) &
+        (n_covariance_values != (n_expectations*(n_expectations+1))/2))
+                               return 5;
+
+    // Send it.
+
+    return send_l_record(active, identifier, sizeof_identifier, instance_identifier, time,
+                         n_tags, buffer_tags, n_expectations, buffer_expectations, n_covariance_values, buffer_covariance);
+  }
+}
+
+int
+obs_e_based_socket_writer::
+write_o
+(bool         active,
+ char*        identifier,
+ double       time,
+ int          n_parameter_iids,
+ int*         the_parameter_iids,
+ int          n_observation_iids,
+ int*         the_observation_iids,
+ int          n_instrument_iids,
+ int*         the_instrument_iids)
+{
+  {
+    int   sizeof_identifier;
+
+    // Won't work if no o-records are allowed.
+
+    if (!o_records_allowed_) return 3;
+
+    // Won't work if the socket is not ready.
+
+    if (!socket_is_open_) return 1;
+
+    //
+    // Won't work neither if no l-records have been written yet for the
+    // current time tag. This test, however, makes sense only when
+    // writing ACTIVE o-records. Inactive ones are always written,
+    // no matter what the situation is.
+    //
+
+    if (active && (!first_l_written_)) return 3;
+
+    // identifier must contain something.
+
+    if (identifier == NULL) return 4;
+
+    sizeof_identifier = (int)strlen(identifier);
+    if (sizeof_identifier < 1) return 4;
+
+    //
+    // We'll still refuse to do anything if the number of identifier does not
+    // match with what we're expecting.
+    //
+
+    if (n_parameter_iids   <= 0) return 7;
+    if (n_observation_iids <= 0) return 7;
+    if (n_instrument_iids  <  0) return 7;
+
+    //
+    // Check if an epoch change is just arriving... Here, the problem
+    // of the no l-records written could arise too.
+    //
+    // Note that this only matters when the record is active. Otherwise,
+    // we simply write data but change NO flags at all.
+    //
+
+    if (active && (time != last_time_tag_))
+    {
+      //
+      // Ooops! This is the first record in an epoch and we are trying to
+      // write an o-record. This is an error!
+      //
+
+      return 3;
+    }
+
+    // Send it.
+
+    return send_o_record(active, identifier, sizeof_identifier, time,
+                         n_parameter_iids,   the_parameter_iids,
+                         n_observation_iids, the_observation_iids,
+                         n_instrument_iids,  the_instrument_iids);
+  }
+}
@@ -11,6 +11,8 @@
 #include <cstdlib>
 
 #include "PracticalSocket.h"
+#include "astrolabe_socket_utilities.hpp"
+#include "observation_epoch.hpp"
 
 #include <xtl/objio.h>
 #include <xtl/xdr.h>
@@ -60,6 +62,12 @@ using namespace std;
  * neutral, architecture-independent representation guarantees that the
  * receiver will be able to rebuild such information flawlessly.
  *
+ * By default, every record must be acknowledged by the receiver before
+ * the next one is sent, so no more than one record per network round trip
+ * may be sent. Use set_window() before open() to let several records
+ * travel at the same time (see astrolabe_socket_utilities.hpp for a
+ * description of both protocols).
+ *
  */
 
 class obs_e_based_socket_writer
@@ -110,6 +118,17 @@ class obs_e_based_socket_writer
      */
         ~obs_e_based_socket_writer (void);
 
+    /**
+     * \brief Retrieve the window in use.
+     *
+     * \return The maximum number of records that may be waiting for
+     *         their acknowledgement, as agreed with the receiver when
+     *         opening the connection. One means that the stop-and-wait
+     *         protocol is in use (also when the socket is not open).
+     */
+
+    int  get_window                (void) const;
+
     /**
      * \brief Check if the socket is already opened.
      *
@@ -133,7 +152,8 @@ class obs_e_based_socket_writer
      * \return Error code. Error code values:
      *        - 0: Successful completion.
      *        - 1: The socket was already open.
-     *        - 2: Unable to open the selected socket.
+     *        - 2: Unable to open the selected socket, or to agree on
+     *             the windowed protocol with the receiver (see set_window()).
      *        - 3: Not enough memory to allocate the internal buffer.
      *
      * Once a socket writer has been instantiated it is possible
@@ -166,6 +186,34 @@ class obs_e_based_socket_writer
                                     int         port,
                                     bool        server_mode);
 
+    /**
+     * \brief Select the number of records that may be sent without
+     *        waiting for their acknowledgement.
+     *
+     * \param n_records The window wanted. One (the default) selects the
+     *        classic stop-and-wait protocol.
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The socket is already open.
+     *        - 2: The window must be greater than zero.
+     *
+     * When the window is greater than one, open() asks the receiver to use
+     * the windowed protocol (see astrolabe_socket_utilities.hpp), and the
+     * receiver decides the window actually used (see get_window()), that
+     * may be smaller. Readers that do not know about the windowed protocol
+     * never answer the request, so open() fails (after waiting for
+     * _ASTROLABE_SOCKET_HELLO_TIMEOUT milliseconds, at most); use the
+     * default window with these.
+     *
+     * With the windowed protocol, write_l(), write_o() and write_epoch()
+     * return as soon as the records are handed to the connection, and only
+     * wait when the window is full. Errors sending records may therefore be
+     * reported by a later call, or by close(), which waits for every record
+     * to be acknowledged.
+     */
+
+    int  set_window                (int         n_records);
+
     /**
      * \brief Write (send) an l-record.
      *
@@ -357,6 +405,30 @@ class obs_e_based_socket_writer
                                     int          n_instrument_iids,
                                     int*         the_instrument_iids);
 
+    /**
+     * \brief Sends all the l- and o-records of an epoch.
+     * \param epoch The records to send, in the order these must be received.
+     * \return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: The socket is not open.
+     *        - 2: Error sending data.
+     *        - 3: An active o-record would be the first active record in
+     *             the group sharing the same time tag, or o-records are not
+     *             allowed.
+     *        - 4: An identifier is empty.
+     *        - 5: Invalid number of tags, expectations or covariance values
+     *             in an l-record (see write_l()).
+     *        - 7: Invalid number of instance identifiers in an o-record
+     *             (see write_o()).
+     *
+     * The whole epoch is validated before sending anything, so the receiver
+     * gets no records at all if any of them is wrong. Then, the records are
+     * sent one after the other, with no further checks. Every record is
+     * still acknowledged by the receiver, as when using write_l() and
+     * write_o().
+     */
+
+    int  write_epoch               (const observation_epoch& epoch);
 
   protected:
 
@@ -379,10 +451,107 @@ class obs_e_based_socket_writer
      * is. In fact, it does not matter what character is sent; only
      * that it is sent (and received).
      *
+     * When the windowed protocol is in use, acknowledgements are XDR ints
+     * instead, stating how many records are acknowledged at once; these
+     * are discounted from outstanding_records_.
+     *
      */
 
     void getACK                    (void);
 
+    /**
+     * \brief Ask the receiver to use the windowed protocol.
+     *
+     * \throw SocketException Unable to send the request or to receive
+     *        the answer within _ASTROLABE_SOCKET_HELLO_TIMEOUT
+     *        milliseconds.
+     *
+     * Sends the hello command with the window wanted (requested_window_)
+     * and sets protocol_version_ and window_ according to the answer.
+     * Used by open().
+     */
+
+    void negotiate_protocol        (void);
+
+    /**
+     * \brief Encode and send an l-record already validated (see
+     *        send_record()).
+     * \param active The l-record is active (true) or removed (false).
+     * \param identifier Identifier of the l-record.
+     * \param sizeof_identifier Length of the identifier, in characters.
+     * \param instance_identifier Instance identifier of the l-record.
+     * \param time Time tag of the l-record.
+     * \param n_tags Number of tag values to send.
+     * \param buffer_tags The tag values.
+     * \param n_expectations Number of expectations to send.
+     * \param buffer_expectations The expectations.
+     * \param n_covariance_values Number of covariance matrix elements to send.
+     * \param buffer_covariance The covariance matrix elements.
+     * \return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 2: Error encoding or sending data.
+     *
+     * Updates the flags used to check the order of the records (see
+     * write_l()). Used by write_l() and write_epoch().
+     */
+
+    int  send_l_record             (bool         active,
+                                    char*        identifier,
+                                    int          sizeof_identifier,
+                                    int          instance_identifier,
+                                    double       time,
+                                    int          n_tags,
+                                    double*      buffer_tags,
+                                    int          n_expectations,
+                                    double*      buffer_expectations,
+                                    int          n_covariance_values,
+                                    double*      buffer_covariance);
+
+    /**
+     * \brief Encode and send an o-record already validated (see
+     *        send_record()).
+     * \param active The o-record is active (true) or removed (false).
+     * \param identifier Identifier of the o-record.
+     * \param sizeof_identifier Length of the identifier, in characters.
+     * \param time Time tag of the o-record.
+     * \param n_parameter_iids Number of parameter instance identifiers.
+     * \param the_parameter_iids The parameter instance identifiers.
+     * \param n_observation_iids Number of observation instance identifiers.
+     * \param the_observation_iids The observation instance identifiers.
+     * \param n_instrument_iids Number of instrument instance identifiers.
+     * \param the_instrument_iids The instrument instance identifiers.
+     * \return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 2: Error encoding or sending data.
+     *
+     * Used by write_o() and write_epoch().
+     */
+
+    int  send_o_record             (bool         active,
+                                    char*        identifier,
+                                    int          sizeof_identifier,
+                                    double       time,
+                                    int          n_parameter_iids,
+                                    int*         the_parameter_iids,
+                                    int          n_observation_iids,
+                                    int*         the_observation_iids,
+                                    int          n_instrument_iids,
+                                    int*         the_instrument_iids);
+
+    /**
+     * \brief Send the message encoded in coder_membuf_.
+     *
+     * \throw SocketException Unable to send the message or to receive
+     *        an acknowledgement.
+     *
+     * With the stop-and-wait protocol, the message is sent as is and its
+     * acknowledgement is awaited. With the windowed protocol, the message
+     * is preceded by its length, and acknowledgements are only awaited
+     * when the window is full.
+     */
+
+    void send_record               (void);
+
   protected:
 
     /// \brief Underlying mem_buffer object used in XDR coding operatinos.
@@ -398,7 +567,9 @@ class obs_e_based_socket_writer
 
     obj_output<XDR_format<mem_buffer> >* coder_stream_;
 
-    /// \brief The data_buffer_ used to store the data to write.
+    /// \brief The data_buffer_ used to store the data to write. The
+    /// encoded messages start _ASTROLABE_SOCKET_XDR_INT_SIZE bytes after
+    /// its beginning, leaving room for their length.
 
     char*                                data_buffer_;
 
@@ -437,10 +608,24 @@ class obs_e_based_socket_writer
 
     bool                                 o_records_allowed_;
 
+    /// \brief Number of records (or commands) sent and not acknowledged
+    /// yet. Always zero with the stop-and-wait protocol.
+
+    int                                  outstanding_records_;
+
     /// \brief Port to connect through.
 
     unsigned short                       port_;
 
+    /// \brief Protocol in use (_ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT or
+    /// _ASTROLABE_SOCKET_PROTOCOL_WINDOWED).
+
+    int                                  protocol_version_;
+
+    /// \brief Window asked for when opening the connection (see set_window()).
+
+    int                                  requested_window_;
+
     /// \brief The server socket used to set the connection in server mode.
 
     TCPServerSocket*                     server_socket_;
@@ -452,6 +637,10 @@ class obs_e_based_socket_writer
     /// \brief Flag showing wheter the socket connection is open.
 
     bool                                 socket_is_open_;
+
+    /// \brief Window agreed with the receiver (see get_window()).
+
+    int                                  window_;
 };
 
 #endif // OBS_E_BASED_SOCKET_WRITER_HPP
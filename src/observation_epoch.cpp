@@ -0,0 +1,436 @@
+/** \file observation_epoch.cpp
+  \brief Implementation file for observation_epoch.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "observation_epoch.hpp"
+
+#include <cstring>
+
+void
+observation_epoch::
+clear
+(void)
+{
+  {
+    // Note that clear() does not release the memory of the vectors.
+
+    actives_.clear();
+    identifiers_.clear();
+    instance_ids_.clear();
+    times_.clear();
+    types_.clear();
+
+    covariance_values_.clear();
+    expectations_.clear();
+    instrument_iids_.clear();
+    observation_iids_.clear();
+    parameter_iids_.clear();
+    tags_.clear();
+
+    // There is always an extra offsets element: the end of the last record.
+
+    offsets_.resize(1);
+
+    offsets_[0].covariance  = 0;
+    offsets_[0].expectation = 0;
+    offsets_[0].identifier  = 0;
+    offsets_[0].instrument  = 0;
+    offsets_[0].observation = 0;
+    offsets_[0].parameter   = 0;
+    offsets_[0].tag         = 0;
+
+    n_l_records_    = 0;
+    n_o_records_    = 0;
+
+    time_           = 0;
+    time_available_ = false;
+  }
+}
+
+bool
+observation_epoch::
+get_active
+(int record)
+const
+{
+  {
+    return (actives_[record] != 0);
+  }
+}
+
+const double*
+observation_epoch::
+get_covariance_values
+(int record)
+const
+{
+  {
+    return covariance_values_.data() + offsets_[record].covariance;
+  }
+}
+
+const double*
+observation_epoch::
+get_expectations
+(int record)
+const
+{
+  {
+    return expectations_.data() + offsets_[record].expectation;
+  }
+}
+
+const char*
+observation_epoch::
+get_identifier
+(int record)
+const
+{
+  {
+    return identifiers_.data() + offsets_[record].identifier;
+  }
+}
+
+int
+observation_epoch::
+get_instance_id
+(int record)
+const
+{
+  {
+    return instance_ids_[record];
+  }
+}
+
+const int*
+observation_epoch::
+get_instrument_iids
+(int record)
+const
+{
+  {
+    return instrument_iids_.data() + offsets_[record].instrument;
+  }
+}
+
+int
+observation_epoch::
+get_n_covariance_values
+(int record)
+const
+{
+  {
+    return offsets_[record + 1].covariance - offsets_[record].covariance;
+  }
+}
+
+int
+observation_epoch::
+get_n_expectations
+(int record)
+const
+{
+  {
+    return offsets_[record + 1].expectation - offsets_[record].expectation;
+  }
+}
+
+int
+observation_epoch::
+get_n_instrument_iids
+(int record)
+const
+{
+  {
+    return offsets_[record + 1].instrument - offsets_[record].instrument;
+  }
+}
+
+int
+observation_epoch::
+get_n_l_records
+(void)
+const
+{
+  {
+    return n_l_records_;
+  }
+}
+
+int
+observation_epoch::
+get_n_o_records
+(void)
+const
+{
+  {
+    return n_o_records_;
+  }
+}
+
+int
+observation_epoch::
+get_n_observation_iids
+(int record)
+const
+{
+  {
+    return offsets_[record + 1].observation - offsets_[record].observation;
+  }
+}
+
+int
+observation_epoch::
+get_n_parameter_iids
+(int record)
+const
+{
+  {
+    return offsets_[record + 1].parameter - offsets_[record].parameter;
+  }
+}
+
+int
+observation_epoch::
+get_n_records
+(void)
+const
+{
+  {
+    return (int)types_.size();
+  }
+}
+
+int
+observation_epoch::
+get_n_tags
+(int record)
+const
+{
+  {
+    return offsets_[record + 1].tag - offsets_[record].tag;
+  }
+}
+
+const int*
+observation_epoch::
+get_observation_iids
+(int record)
+const
+{
+  {
+    return observation_iids_.data() + offsets_[record].observation;
+  }
+}
+
+const int*
+observation_epoch::
+get_parameter_iids
+(int record)
+const
+{
+  {
+    return parameter_iids_.data() + offsets_[record].parameter;
+  }
+}
+
+double
+observation_epoch::
+get_record_time
+(int record)
+const
+{
+  {
+    return times_[record];
+  }
+}
+
+const double*
+observation_epoch::
+get_tags
+(int record)
+const
+{
+  {
+    return tags_.data() + offsets_[record].tag;
+  }
+}
+
+double
+observation_epoch::
+get_time
+(void)
+const
+{
+  {
+    return time_;
+  }
+}
+
+char
+observation_epoch::
+get_type
+(int record)
+const
+{
+  {
+    return types_[record];
+  }
+}
+
+void
+observation_epoch::
+new_l_record
+(bool        active,
+ const char* identifier,
+ int         instance_id,
+ double      time,
+ int         n_tags,
+ int         n_expectations,
+ double*&    tags,
+ double*&    expectations,
+ double*&    covariance_values)
+{
+  {
+    record_offsets* end;
+    record_offsets* start;
+
+    new_record('l', active, identifier, instance_id, time);
+
+    // Make room for the values. Covariances are sized for the worst case.
+
+    start = &offsets_[offsets_.size() - 2];
+    end   = start + 1;
+
+    end->tag         = start->tag         + n_tags;
+    end->expectation = start->expectation + n_expectations;
+    end->covariance  = start->covariance  + (n_expectations * (n_expectations + 1)) / 2;
+
+    tags_.resize(end->tag);
+    expectations_.resize(end->expectation);
+    covariance_values_.resize(end->covariance);
+
+    tags              = tags_.data()              + start->tag;
+    expectations      = expectations_.data()      + start->expectation;
+    covariance_values = covariance_values_.data() + start->covariance;
+
+    n_l_records_++;
+  }
+}
+
+void
+observation_epoch::
+new_o_record
+(bool        active,
+ const char* identifier,
+ double      time,
+ int         n_parameter_iids,
+ int         n_observation_iids,
+ int         n_instrument_iids,
+ int*&       parameter_iids,
+ int*&       observation_iids,
+ int*&       instrument_iids)
+{
+  {
+    record_offsets* end;
+    record_offsets* start;
+
+    new_record('o', active, identifier, 0, time);
+
+    // Make room for the values.
+
+    start = &offsets_[offsets_.size() - 2];
+    end   = start + 1;
+
+    end->parameter   = start->parameter   + n_parameter_iids;
+    end->observation = start->observation + n_observation_iids;
+    end->instrument  = start->instrument  + n_instrument_iids;
+
+    parameter_iids_.resize(end->parameter);
+    observation_iids_.resize(end->observation);
+    instrument_iids_.resize(end->instrument);
+
+    parameter_iids   = parameter_iids_.data()   + start->parameter;
+    observation_iids = observation_iids_.data() + start->observation;
+    instrument_iids  = instrument_iids_.data()  + start->instrument;
+
+    n_o_records_++;
+  }
+}
+
+void
+observation_epoch::
+new_record
+(char        type,
+ bool        active,
+ const char* identifier,
+ int         instance_id,
+ double      time)
+{
+  {
+    size_t id_length;
+
+    types_.push_back(type);
+    actives_.push_back(active ? 1 : 0);
+    instance_ids_.push_back(instance_id);
+    times_.push_back(time);
+
+    // Identifiers are stored one after the other, NULL terminated.
+
+    id_length = strlen(identifier);
+
+    identifiers_.insert(identifiers_.end(), identifier, identifier + id_length + 1);
+
+    //
+    // The record ends where it starts (no values) but for its identifier.
+    // Callers set the end of the values they own.
+    //
+
+    offsets_.push_back(offsets_.back());
+    offsets_.back().identifier = (int)identifiers_.size();
+
+    // The time of the epoch is the one of its first active record.
+
+    if (active && !time_available_)
+    {
+      time_           = time;
+      time_available_ = true;
+    }
+  }
+}
+
+observation_epoch::
+observation_epoch
+(void)
+{
+  {
+    clear();
+  }
+}
+
+observation_epoch::
+~observation_epoch
+(void)
+{
+  {
+  }
+}
+
+void
+observation_epoch::
+set_n_covariance_values
+(int n_covariance_values)
+{
+  {
+    record_offsets* end;
+
+    // Give back the storage reserved for, but not used by, the last l-record.
+
+    end = &offsets_.back();
+
+    end->covariance = (end - 1)->covariance + n_covariance_values;
+
+    covariance_values_.resize(end->covariance);
+  }
+}
@@ -0,0 +1,432 @@
+/** \file observation_epoch.hpp
+  \brief Container holding all the l- and o-records in an epoch.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef OBSERVATION_EPOCH_HPP
+#define OBSERVATION_EPOCH_HPP
+
+#include <vector>
+
+using namespace std;
+
+/**
+   \brief Container holding all the l- and o-records in an epoch, as
+   retrieved by observation_reader::read_epoch().
+
+   \ingroup ASTROLABE_data_IO
+
+   Records are stored as a structure of arrays: every field (type,
+   active flag, identifier, instance identifier, time, tags, expectations,
+   covariance values and parameter / observation / instrument instance
+   identifiers) is kept in its own contiguous buffer. The values of
+   consecutive records are stored one after the other, so, for instance,
+   get_tags(0) addresses the tags of all the l-records in the epoch, in
+   the order these were read. Records of the "wrong" type simply own
+   no values (get_n_tags() is zero for o-records, get_n_parameter_iids()
+   is zero for l-records).
+
+   Records are numbered from 0 to get_n_records() - 1, in the order these
+   were read from the data channel. None of the get_ methods taking a
+   record number check its validity.
+
+   The buffers are reused (never shrunk) from epoch to epoch, so reading
+   a whole data channel with the same observation_epoch object will not
+   allocate memory once the largest epoch has been seen. Pointers
+   retrieved from an observation_epoch object are therefore valid only
+   until it is cleared or refilled.
+
+   Methods clear(), new_l_record(), new_o_record() and
+   set_n_covariance_values() are used by observation_reader to fill the
+   object; applications will normally use the get_ methods only.
+*/
+
+class observation_epoch
+{
+  public:
+
+    /// \brief Remove all the records in the epoch, keeping the memory allocated.
+
+    void          clear                     (void);
+
+    /// \brief Retrieve the active flag of a record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return True if the record is active, false otherwise.
+    */
+
+    bool          get_active                (int record) const;
+
+    /// \brief Retrieve the covariance matrix values of an l-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The get_n_covariance_values(record) values of the record.
+    */
+
+    const double* get_covariance_values     (int record) const;
+
+    /// \brief Retrieve the expectations of an l-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The get_n_expectations(record) values of the record.
+    */
+
+    const double* get_expectations          (int record) const;
+
+    /// \brief Retrieve the identifier of a record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The NULL terminated identifier of the record.
+    */
+
+    const char*   get_identifier            (int record) const;
+
+    /// \brief Retrieve the instance identifier of an l-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The instance identifier; 0 for o-records.
+    */
+
+    int           get_instance_id           (int record) const;
+
+    /// \brief Retrieve the instrument instance identifiers of an o-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The get_n_instrument_iids(record) identifiers of the record.
+    */
+
+    const int*    get_instrument_iids       (int record) const;
+
+    /// \brief Retrieve the number of covariance matrix values of an l-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The number of covariance values found (0, n or (n * (n + 1)) / 2,
+              n being the number of expectations); 0 for o-records.
+    */
+
+    int           get_n_covariance_values   (int record) const;
+
+    /// \brief Retrieve the number of expectations of an l-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The number of expectations; 0 for o-records.
+    */
+
+    int           get_n_expectations        (int record) const;
+
+    /// \brief Retrieve the number of instrument instance identifiers of an o-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The number of identifiers; 0 for l-records.
+    */
+
+    int           get_n_instrument_iids     (int record) const;
+
+    /// \brief Retrieve the number of l-records in the epoch.
+    /**
+      \return The number of l-records.
+    */
+
+    int           get_n_l_records           (void) const;
+
+    /// \brief Retrieve the number of o-records in the epoch.
+    /**
+      \return The number of o-records.
+    */
+
+    int           get_n_o_records           (void) const;
+
+    /// \brief Retrieve the number of observation instance identifiers of an o-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The number of identifiers; 0 for l-records.
+    */
+
+    int           get_n_observation_iids    (int record) const;
+
+    /// \brief Retrieve the number of parameter instance identifiers of an o-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The number of identifiers; 0 for l-records.
+    */
+
+    int           get_n_parameter_iids      (int record) const;
+
+    /// \brief Retrieve the number of records (l- plus o-) in the epoch.
+    /**
+      \return The number of records.
+    */
+
+    int           get_n_records             (void) const;
+
+    /// \brief Retrieve the number of tags of an l-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The number of tags; 0 for o-records.
+    */
+
+    int           get_n_tags                (int record) const;
+
+    /// \brief Retrieve the observation instance identifiers of an o-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The get_n_observation_iids(record) identifiers of the record.
+    */
+
+    const int*    get_observation_iids      (int record) const;
+
+    /// \brief Retrieve the parameter instance identifiers of an o-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The get_n_parameter_iids(record) identifiers of the record.
+    */
+
+    const int*    get_parameter_iids        (int record) const;
+
+    /// \brief Retrieve the time tag of a record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The time tag of the record. Inactive records may carry
+              a time tag different from the epoch's one.
+    */
+
+    double        get_record_time           (int record) const;
+
+    /// \brief Retrieve the tags of an l-record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return The get_n_tags(record) values of the record.
+    */
+
+    const double* get_tags                  (int record) const;
+
+    /// \brief Retrieve the time of the epoch.
+    /**
+      \return The time tag of the first active record in the epoch,
+              or 0 if there are no active records.
+    */
+
+    double        get_time                  (void) const;
+
+    /// \brief Retrieve the type of a record.
+    /**
+      \pre (0 <= record) && (record < get_n_records())
+      \param record The number of the record.
+      \return 'l' or 'o'.
+    */
+
+    char          get_type                  (int record) const;
+
+    /// \brief Append a new l-record to the epoch.
+    /**
+      \param active Active flag of the record.
+      \param identifier Identifier of the record (NULL terminated).
+      \param instance_id Instance identifier of the record.
+      \param time Time tag of the record.
+      \param n_tags Number of tags in the record (>= 0).
+      \param n_expectations Number of expectations in the record (> 0).
+      \param tags On output, the storage for the n_tags tags.
+      \param expectations On output, the storage for the n_expectations
+             expectations.
+      \param covariance_values On output, the storage for the covariance
+             matrix values; able to hold (n * (n + 1)) / 2 values, n being
+             n_expectations. Call set_n_covariance_values() once the actual
+             number of values is known.
+
+      The storage returned is valid until the next call to any of the
+      methods that modify the object.
+    */
+
+    void          new_l_record              (bool        active,
+                                             const char* identifier,
+                                             int         instance_id,
+                                             double      time,
+                                             int         n_tags,
+                                             int         n_expectations,
+                                             double*&    tags,
+                                             double*&    expectations,
+                                             double*&    covariance_values);
+
+    /// \brief Append a new o-record to the epoch.
+    /**
+      \param active Active flag of the record.
+      \param identifier Identifier of the record (NULL terminated).
+      \param time Time tag of the record.
+      \param n_parameter_iids Number of parameter instance identifiers (> 0).
+      \param n_observation_iids Number of observation instance identifiers (> 0).
+      \param n_instrument_iids Number of instrument instance identifiers (>= 0).
+      \param parameter_iids On output, the storage for the parameter
+             instance identifiers.
+      \param observation_iids On output, the storage for the observation
+             instance identifiers.
+      \param instrument_iids On output, the storage for the instrument
+             instance identifiers.
+
+      The storage returned is valid until the next call to any of the
+      methods that modify the object.
+    */
+
+    void          new_o_record              (bool        active,
+                                             const char* identifier,
+                                             double      time,
+                                             int         n_parameter_iids,
+                                             int         n_observation_iids,
+                                             int         n_instrument_iids,
+                                             int*&       parameter_iids,
+                                             int*&       observation_iids,
+                                             int*&       instrument_iids);
+
+    /// \brief Constructor.
+
+                  observation_epoch         (void);
+
+    /// \brief Destructor.
+
+                  ~observation_epoch        (void);
+
+    /// \brief Set the actual number of covariance matrix values of the
+    /// last record appended, that must be an l-record.
+    /**
+      \pre The last record appended is an l-record.
+      \param n_covariance_values The number of covariance values found, not
+             greater than the number of values reserved by new_l_record().
+    */
+
+    void          set_n_covariance_values   (int n_covariance_values);
+
+  protected:
+
+    /// \brief Append the fields shared by l- and o-records.
+    /**
+      \param type Type of the record.
+      \param active Active flag of the record.
+      \param identifier Identifier of the record.
+      \param instance_id Instance identifier of the record.
+      \param time Time tag of the record.
+    */
+
+    void          new_record                (char        type,
+                                             bool        active,
+                                             const char* identifier,
+                                             int         instance_id,
+                                             double      time);
+
+  protected:
+
+    /// \brief Where the values of a record start in each of the buffers.
+    /// The values of record i end where those of record i + 1 start.
+
+    struct record_offsets
+    {
+      /// \brief Offset in covariance_values_.
+
+      int covariance;
+
+      /// \brief Offset in expectations_.
+
+      int expectation;
+
+      /// \brief Offset in identifiers_.
+
+      int identifier;
+
+      /// \brief Offset in instrument_iids_.
+
+      int instrument;
+
+      /// \brief Offset in observation_iids_.
+
+      int observation;
+
+      /// \brief Offset in parameter_iids_.
+
+      int parameter;
+
+      /// \brief Offset in tags_.
+
+      int tag;
+    };
+
+    /// \brief Active flags of the records (0 or 1).
+
+    vector<char>           actives_;
+
+    /// \brief Covariance values of all the l-records.
+
+    vector<double>         covariance_values_;
+
+    /// \brief Expectations of all the l-records.
+
+    vector<double>         expectations_;
+
+    /// \brief Identifiers of all the records, NULL terminated.
+
+    vector<char>           identifiers_;
+
+    /// \brief Instance identifiers of the records (0 for o-records).
+
+    vector<int>            instance_ids_;
+
+    /// \brief Instrument instance identifiers of all the o-records.
+
+    vector<int>            instrument_iids_;
+
+    /// \brief Number of l-records in the epoch.
+
+    int                    n_l_records_;
+
+    /// \brief Number of o-records in the epoch.
+
+    int                    n_o_records_;
+
+    /// \brief Offsets of the values of the records. Holds get_n_records() + 1
+    /// elements, the last one being the end of the values of the last record.
+
+    vector<record_offsets> offsets_;
+
+    /// \brief Observation instance identifiers of all the o-records.
+
+    vector<int>            observation_iids_;
+
+    /// \brief Parameter instance identifiers of all the o-records.
+
+    vector<int>            parameter_iids_;
+
+    /// \brief Tags of all the l-records.
+
+    vector<double>         tags_;
+
+    /// \brief Time of the epoch (first active record).
+
+    double                 time_;
+
+    /// \brief Flag. True when time_ has been set.
+
+    bool                   time_available_;
+
+    /// \brief Time tags of the records.
+
+    vector<double>         times_;
+
+    /// \brief Types of the records ('l' or 'o').
+
+    vector<char>           types_;
+};
+
+#endif // OBSERVATION_EPOCH_HPP
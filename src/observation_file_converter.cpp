@@ -0,0 +1,487 @@
+/** \file observation_file_converter.cpp
+  \brief Implementation file for observation_file_converter.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#include "observation_file_converter.hpp"
+
+#include <chrono>
+
+observation_file_converter::
+observation_file_converter
+(void)
+{
+  {
+    channel_status_ = 0;
+    converted_      = false;
+    input_is_set_   = false;
+    layout_is_set_  = false;
+    memory_mapped_  = false;
+    n_epochs_       = 0;
+    n_records_      = 0;
+    output_is_set_  = false;
+    prefetch_       = false;
+    queue_size_     = _ASTROLABE_OBS_E_FILE_CONVERTER_DEFAULT_QUEUE_SIZE;
+    read_done_      = false;
+    read_status_    = 0;
+    reverse_mode_   = false;
+    seconds_        = 0.0;
+    stop_           = false;
+  }
+}
+
+observation_file_converter::
+~observation_file_converter
+(void)
+{
+  {
+    // INTENTIONALLY LEFT BLANK. The read stage is always joined by convert().
+  }
+}
+
+int
+observation_file_converter::
+convert
+(void)
+{
+  {
+    chrono::steady_clock::time_point start;
+    int                              slot;
+    int                              status;
+    thread                           reader_thread;
+    int                              write_status;
+
+    if (!input_is_set_ || !output_is_set_ || !layout_is_set_) return 1;
+    if (converted_)                                            return 1;
+
+    converted_      = true;
+    channel_status_ = 0;
+    n_epochs_       = 0;
+    n_records_      = 0;
+    start           = chrono::steady_clock::now();
+
+    // Open both data channels.
+
+    status = reader_.open(reverse_mode_, memory_mapped_, prefetch_);
+    if (status != 0)
+    {
+      channel_status_ = status;
+      return 2;
+    }
+
+    status = writer_.open();
+    if (status != 0)
+    {
+      reader_.close();
+      channel_status_ = status;
+      return 3;
+    }
+
+    // Allocate the epochs. All of them are free at the beginning.
+
+    try
+    {
+      epochs_.resize(queue_size_);
+    }
+    catch (...)
+    {
+      reader_.close();
+      writer_.close();
+      return 6;
+    }
+
+    filled_slots_.clear();
+    free_slots_.clear();
+
+    for (slot = 0; slot < queue_size_; slot++) free_slots_.push_back(slot);
+
+    read_done_   = false;
+    read_status_ = 0;
+    stop_        = false;
+
+    // Start the read stage.
+
+    try
+    {
+      reader_thread = thread(&observation_file_converter::read_epochs, this);
+    }
+    catch (...)
+    {
+      reader_.close();
+      writer_.close();
+      return 6;
+    }
+
+    //
+    // The write stage. Write the epochs in the order these are read,
+    // giving them back to the read stage once written.
+    //
+
+    write_status = 0;
+
+    while (true)
+    {
+      {
+        unique_lock<mutex> lock(queue_mutex_);
+
+        while (filled_slots_.empty() && !read_done_) slot_filled_.wait(lock);
+
+        if (filled_slots_.empty()) break;
+
+        slot = filled_slots_.front();
+        filled_slots_.pop_front();
+      }
+
+      write_status = write_epoch(slot);
+
+      {
+        lock_guard<mutex> lock(queue_mutex_);
+
+        free_slots_.push_back(slot);
+
+        // Stop the read stage should the epoch not be written.
+
+        if (write_status != 0) stop_ = true;
+      }
+
+      slot_freed_.notify_one();
+
+      if (write_status != 0) break;
+    }
+
+    reader_thread.join();
+
+    // Close both channels. Report the first error found, if any.
+
+    reader_.close();
+
+    status = writer_.close();
+
+    seconds_ = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (write_status != 0)
+    {
+      channel_status_ = write_status;
+      return 5;
+    }
+
+    if (read_status_ != 0)
+    {
+      channel_status_ = read_status_;
+      return 4;
+    }
+
+    if (status != 0)
+    {
+      channel_status_ = status;
+      return 5;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+get_channel_status
+(void)
+const
+{
+  {
+    return channel_status_;
+  }
+}
+
+int
+observation_file_converter::
+get_input_errors
+(list<string>& list_of_errors)
+{
+  {
+    return reader_.get_metadata_errors(list_of_errors);
+  }
+}
+
+int
+observation_file_converter::
+get_input_warnings
+(list<string>& list_of_warnings)
+{
+  {
+    return reader_.get_metadata_warnings(list_of_warnings);
+  }
+}
+
+void
+observation_file_converter::
+get_statistics
+(long long& n_epochs,
+ long long& n_records,
+ double&    seconds)
+const
+{
+  {
+    n_epochs  = n_epochs_;
+    n_records = n_records_;
+    seconds   = seconds_;
+  }
+}
+
+void
+observation_file_converter::
+read_epochs
+(void)
+{
+  {
+    int slot;
+    int status;
+
+    while (true)
+    {
+      // Wait for an epoch to fill.
+
+      {
+        unique_lock<mutex> lock(queue_mutex_);
+
+        while (free_slots_.empty() && !stop_) slot_freed_.wait(lock);
+
+        if (stop_) break;
+
+        slot = free_slots_.front();
+        free_slots_.pop_front();
+      }
+
+      status = reader_.read_epoch(epochs_[slot]);
+
+      {
+        lock_guard<mutex> lock(queue_mutex_);
+
+        if (status != 0)
+        {
+          //
+          // End of data (1) or error. Either way, the read stage is over.
+          // Errors are reported once the epochs already read are written.
+          //
+
+          free_slots_.push_back(slot);
+
+          if (status != 1) read_status_ = status;
+
+          read_done_ = true;
+        }
+        else
+        {
+          filled_slots_.push_back(slot);
+        }
+      }
+
+      slot_filled_.notify_one();
+
+      if (status != 0) break;
+    }
+  }
+}
+
+int
+observation_file_converter::
+set_chunk_manifest
+(bool enabled)
+{
+  {
+    if (converted_) return 1;
+
+    writer_.set_chunk_manifest(enabled);
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+set_columnar
+(int block_size)
+{
+  {
+    if (converted_)     return 1;
+    if (block_size < 0) return 2;
+
+    writer_.set_columnar(block_size);
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+set_input
+(const char* header_file_name,
+ const char* schema_file_name,
+ bool        reverse_mode,
+ bool        memory_mapped,
+ bool        prefetch)
+{
+  {
+    list<string> problems;
+    int          status;
+
+    if (input_is_set_)            return 1;
+    if (header_file_name == NULL) return 2;
+
+    if (schema_file_name != NULL) reader_.set_schema_file(schema_file_name);
+
+    //
+    // Error code 3 is returned for both warnings and errors. Only errors
+    // make it impossible to read the data.
+    //
+
+    status = reader_.set_header_file(header_file_name);
+    if (status == 3)
+    {
+      if (reader_.get_metadata_errors(problems) > 0) return 3;
+    }
+    else if (status != 0)
+    {
+      channel_status_ = status;
+      return 5;
+    }
+
+    if (!reader_.data_channel_is_file()) return 4;
+
+    input_is_set_  = true;
+    memory_mapped_ = memory_mapped;
+    prefetch_      = prefetch;
+    reverse_mode_  = reverse_mode;
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+set_max_chunk_size
+(long long max_bytes,
+ bool      preallocate)
+{
+  {
+    if (converted_)    return 1;
+    if (max_bytes < 0) return 2;
+
+    writer_.set_max_chunk_size(max_bytes, preallocate);
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+set_metadata
+(gp_metadata& metadata)
+{
+  {
+    if (converted_) return 1;
+
+    //
+    // Partial objects are fine (the metadata may be split into several
+    // ones); only those describing no records at all are rejected.
+    //
+
+    if ((metadata.get_dim_lspec() == 0) && (metadata.get_dim_mspec() == 0)) return 2;
+
+    // The reader takes the dimensions of the records from the metadata.
+
+    if (reader_.set_metadata(metadata) != 0) return 1;
+
+    layout_is_set_ = true;
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+set_output
+(const char*         header_file_name,
+ const char*         external_base_file_name,
+ bool                binary,
+ int                 max_epochs_to_split,
+ int                 file_suffix_width,
+ const lineage_data* lineage_info)
+{
+  {
+    int status;
+
+    if (output_is_set_) return 1;
+
+    // Use the lineage of the input when none is given.
+
+    if (lineage_info == NULL)
+    {
+      if (!input_is_set_) return 6;
+
+      lineage_info = reader_.get_lineage();
+    }
+
+    status = writer_.set_data_channel(header_file_name,
+                                      external_base_file_name,
+                                      binary,
+                                      max_epochs_to_split,
+                                      file_suffix_width,
+                                      lineage_info);
+    if (status != 0) return status;
+
+    output_is_set_ = true;
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+set_queue_size
+(int n_epochs)
+{
+  {
+    if (converted_)   return 1;
+    if (n_epochs < 2) return 2;
+
+    queue_size_ = n_epochs;
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+set_time_index
+(bool enabled)
+{
+  {
+    if (converted_) return 1;
+
+    writer_.set_time_index(enabled);
+
+    return 0;
+  }
+}
+
+int
+observation_file_converter::
+write_epoch
+(int slot)
+{
+  {
+    int status;
+
+    // The writer validates and encodes the whole epoch at once.
+
+    status = writer_.write_epoch(epochs_[slot]);
+    if (status != 0) return status;
+
+    n_records_ += epochs_[slot].get_n_records();
+    n_epochs_++;
+
+    return 0;
+  }
+}
@@ -0,0 +1,461 @@
+/** \file observation_file_converter.hpp
+  \brief Multithreaded conversion of observation-event files between formats.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef OBSERVATION_FILE_CONVERTER_HPP
+#define OBSERVATION_FILE_CONVERTER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gp_metadata.hpp"
+#include "observation_epoch.hpp"
+#include "observation_reader.hpp"
+#include "observation_writer.hpp"
+
+using namespace std;
+
+/// @brief Default number of epochs that may be on their way from the
+/// reader to the writer at the same time (see set_queue_size()).
+
+#ifndef _ASTROLABE_OBS_E_FILE_CONVERTER_DEFAULT_QUEUE_SIZE
+  #define _ASTROLABE_OBS_E_FILE_CONVERTER_DEFAULT_QUEUE_SIZE 64
+#endif
+
+/**
+ * @brief Multithreaded conversion of observation-event files between formats.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * This class copies the observation-event data described by an input
+ * ASTROLABE header file to a new one, changing its format (text, binary
+ * or columnar), its direction (forward or reversed) or the way it is split
+ * into chunk files. Both the input and the output may be made of any number of
+ * chunks (see segmented_file_utils); the observation_reader and
+ * observation_writer classes take care of them.
+ *
+ * Records are copied a whole epoch at a time (see
+ * observation_reader::read_epoch()), so the dimensions of every kind of
+ * record must be known in advance. These are taken from the metadata
+ * describing the data (see set_metadata()): the number of tags and
+ * expectations of the l-records come from the l_specs, and the number of
+ * parameter, observation and instrument instance identifiers of the
+ * o-records from the m_specs.
+ *
+ * The conversion is a two stage pipeline:
+ *
+ * - The read stage, running in its own thread, decodes the epochs of the
+ *   input files.
+ * - The write stage, which is the thread calling convert(), encodes the
+ *   epochs to the output files.
+ *
+ * Epochs flow from one stage to the other through a bounded queue (see
+ * set_queue_size()), so decoding and encoding overlap. When prefetching
+ * is enabled (see set_input()), a third thread reads the input files
+ * ahead of the read stage. The epoch objects are recycled, so no memory
+ * is allocated once the largest epoch has been seen.
+ *
+ * When reversing the data, epochs are written from the last one to the
+ * first one; the records of each epoch keep their original order, as
+ * backwards readers return them (see, for instance,
+ * observation_file_reader_txt_backward).
+ *
+ * The way to use this class is:
+ *
+ * - Set the input header file with set_input().
+ * - Set the record layout with set_metadata().
+ * - Set the output header file and data files with set_output().
+ * - Optionally, write columnar files (set_columnar()), change the length
+ *   of the queues (set_queue_size()), limit the size of the chunk files
+ *   (set_max_chunk_size()) or ask for time indexes (set_time_index()) or
+ *   a chunk manifest (set_chunk_manifest()).
+ * - Call convert() once.
+ *
+ * Only file data channels may be converted.
+ */
+
+class observation_file_converter
+{
+  public:
+
+    /**
+     * @brief Convert the input data channel.
+     *
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: Invalid call sequence. The input, output or metadata
+     *              have not been set, or convert() has already been called.
+     *         - 2: Unable to open the input data channel. The error code
+     *              returned by observation_reader::open() is available
+     *              through get_channel_status().
+     *         - 3: Unable to open the output data channel. The error code
+     *              returned by observation_writer::open() is available
+     *              through get_channel_status().
+     *         - 4: Error reading the input data channel. The error code
+     *              returned by observation_reader::read_epoch() is available
+     *              through get_channel_status().
+     *         - 5: Error writing the output data channel. The error code
+     *              returned by observation_writer::write_epoch() or close()
+     *              is available through get_channel_status().
+     *         - 6: Unable to allocate the epochs or to start the read stage.
+     *
+     * Both data channels are closed on return. Should an error happen, the
+     * output files contain the epochs written so far.
+     */
+
+    int          convert                (void);
+
+    /**
+     * @brief Retrieve the error code that made convert() or set_input()
+     *        fail.
+     *
+     * @return The error code returned by the observation_reader or
+     *         observation_writer method that failed (see convert() and
+     *         set_input()), or 0 if none did.
+     */
+
+    int          get_channel_status     (void) const;
+
+    /**
+     * @brief Get the list of errors detected when parsing the input
+     *        ASTROLABE header file.
+     *
+     * @param list_of_errors The textual description of the errors found.
+     * @return The number of errors in the list.
+     *
+     * See observation_reader::get_metadata_errors().
+     */
+
+    int          get_input_errors       (list<string>& list_of_errors);
+
+    /**
+     * @brief Get the list of warnings detected when parsing the input
+     *        ASTROLABE header file.
+     *
+     * @param list_of_warnings The textual description of the warnings found.
+     * @return The number of warnings in the list.
+     *
+     * See observation_reader::get_metadata_warnings().
+     */
+
+    int          get_input_warnings     (list<string>& list_of_warnings);
+
+    /**
+     * @brief Retrieve the figures of the last conversion.
+     *
+     * @param n_epochs Number of epochs written.
+     * @param n_records Number of records (either l- or o-) written.
+     * @param seconds Wall clock time spent by convert(), in seconds.
+     */
+
+    void         get_statistics         (long long& n_epochs,
+                                         long long& n_records,
+                                         double&    seconds) const;
+
+    /**
+     * @brief Default constructor.
+     */
+
+                 observation_file_converter  (void);
+
+    /**
+     * @brief Destructor.
+     */
+
+                 ~observation_file_converter (void);
+
+    /**
+     * @brief Enable or disable the chunk manifest of the output.
+     *
+     * @param enabled True to write a chunk manifest once the output is
+     *        complete.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: convert() has already been called.
+     *
+     * See observation_writer::set_chunk_manifest().
+     */
+
+    int          set_chunk_manifest     (bool enabled);
+
+    /**
+     * @brief Write the output chunk files in columnar format.
+     *
+     * @param block_size Maximum number of records in a column block. Zero
+     *        goes back to the format selected with set_output().
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: convert() has already been called.
+     *         - 2: The block size must not be negative.
+     *
+     * See observation_writer::set_columnar(). The layout of the columns
+     * comes from the dimensions of the records, so these are taken from
+     * the metadata (see set_metadata()) as in any other conversion.
+     */
+
+    int          set_columnar           (int block_size);
+
+    /**
+     * @brief Set the input ASTROLABE header file.
+     *
+     * @param header_file_name Name of the ASTROLABE header file describing
+     *        the data to convert.
+     * @param schema_file_name Name of the XML schema used to validate the
+     *        header file. May be NULL, in which case no validation is done.
+     * @param reverse_mode When true, the output contains the epochs of the
+     *        input in reverse order.
+     * @param memory_mapped Read the input files through memory maps, when
+     *        possible (see observation_reader::open()).
+     * @param prefetch Read the input files in advance, in a helper thread
+     *        (see observation_reader::open()).
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The input has already been set.
+     *         - 2: The name of the header file is NULL.
+     *         - 3: Errors found in the header file. Use get_input_errors()
+     *              to retrieve them.
+     *         - 4: The header file does not describe a file data channel.
+     *         - 5: The input channel rejected the header file for any other
+     *              reason. The error code returned by
+     *              observation_reader::set_header_file() is available
+     *              through get_channel_status().
+     *
+     * Warnings found in the header file do not prevent the conversion; use
+     * get_input_warnings() to retrieve them.
+     */
+
+    int          set_input              (const char* header_file_name,
+                                         const char* schema_file_name,
+                                         bool        reverse_mode,
+                                         bool        memory_mapped,
+                                         bool        prefetch);
+
+    /**
+     * @brief Split the output chunk files by size.
+     *
+     * @param max_bytes Target size, in bytes, of every chunk file. Zero
+     *        disables the limit.
+     * @param preallocate Reserve the space of every chunk file when it is
+     *        created.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: convert() has already been called.
+     *         - 2: The size must not be negative.
+     *
+     * See observation_writer::set_max_chunk_size(). The maximum number of
+     * epochs per chunk (see set_output()) is still honored.
+     */
+
+    int          set_max_chunk_size     (long long max_bytes,
+                                         bool      preallocate);
+
+    /**
+     * @brief Set the layout of the records from the metadata describing them.
+     *
+     * @param metadata The metadata, as loaded by gp_metadata_parser. It
+     *        must remain available until convert() is called.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: convert() has already been called.
+     *         - 2: The metadata contains neither l_specs nor m_specs.
+     *
+     * The metadata is handed to the input channel (see
+     * observation_reader::set_metadata()): the dimensions of the l-records
+     * whose identifier is the type of an l_spec are the dimension of its
+     * t_spec (tags) and its own dimension (expectations). The dimensions
+     * of the o-records whose identifier is the type of an m_spec are the
+     * dimensions of its p_list, l_list and i_list (parameter, observation
+     * and instrument instance identifiers). Specifications with invalid
+     * dimensions are ignored, and their records make convert() fail.
+     *
+     * This method may be called several times, for instance, when the
+     * metadata is split into several objects.
+     */
+
+    int          set_metadata           (gp_metadata& metadata);
+
+    /**
+     * @brief Set the output ASTROLABE header file and data files.
+     *
+     * @param header_file_name Name of the ASTROLABE header file to write.
+     * @param external_base_file_name Base name of the chunk files where data
+     *        will be written (see observation_writer::set_data_channel()).
+     * @param binary Write binary files (true) or text files (false).
+     * @param max_epochs_to_split Maximum number of epochs in a chunk file.
+     * @param file_suffix_width Number of digits of the numeric suffix of the
+     *        chunk files. Range: [1..9].
+     * @param lineage_info Lineage to write to the header file. When NULL,
+     *        the lineage of the input header file is used; set_input()
+     *        must then be called first.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The output has already been set.
+     *         - 2: The name of the header file is NULL.
+     *         - 3: The base file name for the chunk files is NULL.
+     *         - 4: max_epochs_to_split is not greater than zero.
+     *         - 5: file_suffix_width out of range.
+     *         - 6: No lineage given and no input set.
+     */
+
+    int          set_output             (const char*         header_file_name,
+                                         const char*         external_base_file_name,
+                                         bool                binary,
+                                         int                 max_epochs_to_split,
+                                         int                 file_suffix_width,
+                                         const lineage_data* lineage_info);
+
+    /**
+     * @brief Set the number of epochs that may be on their way from the
+     *        reader to the writer.
+     *
+     * @param n_epochs Number of epochs, at least 2 (one per stage).
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: convert() has already been called.
+     *         - 2: Invalid number of epochs.
+     *
+     * Longer queues absorb bigger differences in the time the stages
+     * spend on the same epoch, at the cost of memory. By default,
+     * _ASTROLABE_OBS_E_FILE_CONVERTER_DEFAULT_QUEUE_SIZE epochs are used.
+     */
+
+    int          set_queue_size         (int n_epochs);
+
+    /**
+     * @brief Enable or disable the creation of time indexes for the
+     *        output chunk files.
+     *
+     * @param enabled True to create a time index for every chunk file.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: convert() has already been called.
+     *
+     * See observation_writer::set_time_index().
+     */
+
+    int          set_time_index         (bool enabled);
+
+  protected:
+
+    /**
+     * @brief Body of the read stage.
+     */
+
+    void         read_epochs            (void);
+
+    /**
+     * @brief Write the records of an epoch to the output channel.
+     *
+     * @param slot The epoch (index in epochs_) to write.
+     * @return The error code returned by observation_writer::write_epoch().
+     */
+
+    int          write_epoch            (int slot);
+
+  protected:
+
+    /// @brief Error code returned by observation_reader or observation_writer
+    /// when convert() or set_input() fails.
+
+    int                        channel_status_;
+
+    /// @brief Flag. True once convert() has been called.
+
+    bool                       converted_;
+
+    /// @brief The epochs moving through the pipeline.
+
+    vector<observation_epoch>  epochs_;
+
+    /// @brief Epochs (indexes in epochs_) read, waiting to be written.
+
+    deque<int>                 filled_slots_;
+
+    /// @brief Epochs (indexes in epochs_) that may be filled by the read stage.
+
+    deque<int>                 free_slots_;
+
+    /// @brief Flag. True once set_input() has succeeded.
+
+    bool                       input_is_set_;
+
+    /// @brief Flag. True once set_metadata() has succeeded.
+
+    bool                       layout_is_set_;
+
+    /// @brief Read the input files through memory maps.
+
+    bool                       memory_mapped_;
+
+    /// @brief Number of epochs written by the last conversion.
+
+    long long                  n_epochs_;
+
+    /// @brief Number of records written by the last conversion.
+
+    long long                  n_records_;
+
+    /// @brief Flag. True once set_output() has succeeded.
+
+    bool                       output_is_set_;
+
+    /// @brief Read the input files in advance, in a helper thread.
+
+    bool                       prefetch_;
+
+    /// @brief Protects the queues and the flags shared by the stages.
+
+    mutex                      queue_mutex_;
+
+    /// @brief Number of epochs in the pipeline.
+
+    int                        queue_size_;
+
+    /// @brief Flag. True once the read stage has found the end of the input
+    /// (or an error).
+
+    bool                       read_done_;
+
+    /// @brief Error code returned by observation_reader::read_epoch(), if
+    /// other than 0 (success) or 1 (end of data).
+
+    int                        read_status_;
+
+    /// @brief The input data channel.
+
+    observation_reader         reader_;
+
+    /// @brief Flag. True when the epochs must be written in reverse order.
+
+    bool                       reverse_mode_;
+
+    /// @brief Wall clock time spent by the last conversion, in seconds.
+
+    double                     seconds_;
+
+    /// @brief Signaled when an epoch is added to filled_slots_ or the read
+    /// stage is over.
+
+    condition_variable         slot_filled_;
+
+    /// @brief Signaled when an epoch is returned to free_slots_.
+
+    condition_variable         slot_freed_;
+
+    /// @brief Flag. True when the read stage must stop as soon as possible
+    /// (the write stage failed).
+
+    bool                       stop_;
+
+    /// @brief The output data channel.
+
+    observation_writer         writer_;
+};
+
+#endif // OBSERVATION_FILE_CONVERTER_HPP
@@ -46,14 +46,16 @@ open
 
     if (file_file_ == NULL) return 2;
 
-    // Ascertain how big is the file.
+    //
+    // Find out whether the file is compressed or not, and how big is the
+    // (uncompressed) data.
+    //
 
-    if (fseek(file_file_, 0 , SEEK_END) != 0)
-    {
-      return 5; // I/O error.
-    }
+    read_status = data_stream_.attach(file_file_);
+
+    if (read_status != 0) return 5; // I/O error or corrupted compressed file.
 
-    file_size_         = ftell(file_file_);
+    file_size_         = data_stream_.get_size();
     file_bytes_unread_ = file_size_;
 
     // Try to create the buffer used for buffered reads.
@@ -69,7 +71,7 @@ open
       // If everything works, the file is reported as open.
       //
 
-      if (file_size_ < data_buffer_size_) data_buffer_size_ = file_size_;
+      if (file_size_ < data_buffer_size_) data_buffer_size_ = (int)file_size_;
 
       data_buffer_ = new char[data_buffer_size_];
       file_is_open_ = true;
@@ -87,13 +89,21 @@ open
     }
 
     //
-    // Read as much bytes as possible (maximum: data_buffer_size_)
-    // from the underlying binary file.
-    // Since this is the first read operation, we must guarantee that
-    // the fseek pointer indicates the end of the file.
+    // Chunks are read through read_ahead_, in a helper thread if so
+    // requested. Should the thread be impossible to start, chunks will
+    // be read when needed, so the error code is ignored. The system is
+    // asked to load in advance the region preceding every chunk, since
+    // its own read-ahead policy is of no use when reading backwards.
     //
 
-    fseek(file_file_, 0, SEEK_END);
+    read_ahead_.attach(&data_stream_);
+    read_ahead_.set_reverse_window(reverse_window_size_);
+    if (prefetch_is_enabled_) read_ahead_.start(data_buffer_size_, true);
+
+    //
+    // Read as much bytes as possible (maximum: data_buffer_size_)
+    // from the underlying binary file, starting at its end.
+    //
 
     read_status = read_prev_chunk();
 
@@ -603,8 +613,8 @@ read_prev_chunk
   {
     int    backtrack_index;
     int    bytes_in_epoch;
-    long   bytes_read;
-    long   bytes_to_read;
+    int    bytes_read;
+    int    bytes_to_read;
     int    offset;
     int    new_offset;
     int    previous_backtrack_index;
@@ -624,7 +634,7 @@ read_prev_chunk
     // Ascertain how many bytes may be read at once.
 
     bytes_to_read = data_buffer_size_;
-    if (bytes_to_read > file_bytes_unread_) bytes_to_read = file_bytes_unread_;
+    if (bytes_to_read > file_bytes_unread_) bytes_to_read = (int)file_bytes_unread_;
 
     if (bytes_to_read == 0)
     {
@@ -640,18 +650,20 @@ read_prev_chunk
     offset = data_buffer_size_ - (int)bytes_to_read;
 
     //
-    // Move the current position in the file bytes_to_read bytes backwards to
-    // be able to read forward later on. Note that we ASSUME that the file
-    // is positioned ("fseek-ed") at the beginning of the data block that
-    // has already been processed, starting with an 'l' tag (or just at
-    // the end of the file when no data has been read yet).
+    // Read the bytes_to_read bytes preceding the data block that has
+    // already been processed, starting with an 'l' tag (or the last
+    // bytes_to_read bytes in the file when no data has been read yet).
+    // These are decompressed if needed.
     //
 
-    fseek(file_file_, -bytes_to_read, SEEK_CUR);
-
-    // Read bytes_to_read bytes.
+    // A full chunk is taken without copying it when read in advance.
 
-    bytes_read = (int)fread((void*)&(data_buffer_[offset]), 1, bytes_to_read, file_file_);
+    if (offset == 0)
+      bytes_read = (int)read_ahead_.read_block(file_bytes_unread_ - bytes_to_read,
+                                               data_buffer_, bytes_to_read);
+    else
+      bytes_read = (int)read_ahead_.read(file_bytes_unread_ - bytes_to_read,
+                                         (void*)&(data_buffer_[offset]), bytes_to_read);
     if (bytes_read != bytes_to_read)
     {
       //
@@ -752,13 +764,12 @@ read_prev_chunk
     file_bytes_unread_ -= bytes_read;
 
     //
-    // We must update the fseek position, so the next time this method
-    // is invoked the fseek pointer points to the beginning of the
-    // buffer we've just read. Now, it is pointing to its END, so we
-    // must fseek -bytes_read backward.
+    // Ask the helper thread, if any, to read the chunk that the next call
+    // will request: the data_buffer_size_ bytes preceding those already
+    // processed (or all of them, if fewer). read_block() takes it then.
     //
 
-    fseek(file_file_, -bytes_read, SEEK_CUR);
+    read_ahead_.schedule(file_bytes_unread_ - data_buffer_size_, (size_t)data_buffer_size_);
 
     //
     // Now we know that we have an integral set of epochs starting at
@@ -979,6 +990,51 @@ read_type
   }
 }
 
+int
+observation_file_reader_bin_backward::
+seek_epoch_boundary
+(long long offset)
+{
+  {
+    int read_status;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 3;
+
+    // The offset must lie inside the file.
+
+    if ((offset < 0) || (offset > file_size_)) return 1;
+
+    // The reader behaves now as if the file had just been open.
+
+    reset_read_state();
+
+    //
+    // Leave the data buffer empty, so if nothing is left to read (offset 0)
+    // the next read operation detects the beginning-of-file condition.
+    //
+
+    chunk_start_index_     = data_buffer_size_;
+    epoch_remaining_bytes_ = 0;
+
+    //
+    // Everything before offset is still to be read (see read_prev_chunk()).
+    // Load the data buffer.
+    //
+
+    file_bytes_unread_ = offset;
+
+    read_status = read_prev_chunk();
+
+    if (read_status == 2) return 2;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 observation_file_reader_bin_backward::
 update_epoch_pointers
@@ -995,6 +1051,13 @@ update_epoch_pointers
 
     if (epoch_remaining_bytes_> 0) return 0;
 
+    //
+    // An empty data buffer (see seek_epoch_boundary()) holds no epoch to
+    // navigate from. Just try to read more data.
+    //
+
+    if (chunk_start_index_ >= data_buffer_size_) return read_prev_chunk();
+
     //
     // We've EXHAUSTED the current epoch. It is necessary to navigate
     // backwards to fetch the previous one.
@@ -63,7 +63,8 @@ class observation_file_reader_bin_backward : public obs_e_based_file_reader_bin
      *        - 2: Unable to open the selected file.
      *        - 3: Not enough memory to allocate the internal buffer.
      *        - 4: End of file condition detected - the file is empty.
-     *        - 5: I/O error detected while reading the file.
+     *        - 5: I/O error detected while reading the file (or
+     *             corrupted block-compressed file).
      *        - 6: NOT USED.
      *        - 7: NOT USED.
      *
@@ -74,6 +75,9 @@ class observation_file_reader_bin_backward : public obs_e_based_file_reader_bin
      * This method opens the file and instantiates the internal memory
      * buffer used to speed up I/O operations, enabling the different
      * read operations available in this class.
+     *
+     * Both plain and block-compressed files (see
+     * obs_e_based_file_writer_bin::set_compression()) are accepted.
      */
 
     virtual int  open                                  (const char*  file_name);
@@ -371,6 +375,20 @@ class observation_file_reader_bin_backward : public obs_e_based_file_reader_bin
     virtual int  read_type                             (char& record_type);
 
 
+    /**
+     * @brief Position the reader at the end of an epoch.
+     *
+     * @param offset Offset in bytes of the byte following the last one
+     *        of the epoch (that is, following its backtracking information).
+     * @return Error code. See obs_e_based_file_reader::seek_epoch_boundary().
+     *
+     * The next record read will be the last one of the epoch. Seeking to
+     * the beginning of the file is legal; the next read will report a
+     * beginning-of-file condition.
+     */
+
+    virtual int  seek_epoch_boundary                   (long long offset);
+
   protected:
 
     /**
@@ -477,7 +495,7 @@ class observation_file_reader_bin_backward : public obs_e_based_file_reader_bin
 
     /// @brief Number of bytes in the input file that have not been read yet.
 
-    int          file_bytes_unread_;
+    long long    file_bytes_unread_;
 };
 
 #endif // OBSERVATION_FILE_READER_BIN_BACKWARD_HPP
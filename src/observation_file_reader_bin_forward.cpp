@@ -225,6 +225,124 @@ read_o_data
   }
 }
 
+int
+observation_file_reader_bin_forward::
+read_o_data_view
+(int                 n_parameter_iids,
+ astrolabe_int_view& the_parameter_iids,
+ int                 n_observation_iids,
+ astrolabe_int_view& the_observation_iids,
+ int                 n_instrument_iids,
+ astrolabe_int_view& the_instrument_iids)
+{
+  {
+    int   bytes_moved;
+    int   bytes_to_eat;
+    int   offset;
+    int   read_status;
+
+    int   n_pars_found;
+    int   n_obs_found;
+    int   n_inst_found;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only when the time
+    // tag has been read and we are reading an o-type record.
+    //
+
+    if (!read_time_)      return 3;
+    if ( read_completed_) return 3;
+    if (!reading_o_)      return 3;
+
+    // More preconditions: sizes of the output instance identifier arrays.
+
+    if (n_parameter_iids   <= 0) return 6;
+    if (n_observation_iids <= 0) return 6;
+    if (n_instrument_iids  <  0) return 6;
+
+    //
+    // Make sure that the whole o-data is in the buffer BEFORE setting
+    // any view. See read_o_data() for details on the computation.
+    //
+
+    bytes_to_eat = (3 + n_parameter_iids + n_observation_iids + n_instrument_iids)  * sizeof(int);
+
+    if ((data_buffer_current_ + bytes_to_eat - 1) >= data_buffer_bytes_)
+    {
+      bytes_moved = move_remaining_up();
+      read_status = read_next_chunk(bytes_moved);
+
+      if (read_status == 1)
+      {
+        // End-of-file condition detected.
+
+        is_eof_ = true;
+        return 1;
+      }
+      else if (read_status == 2)
+      {
+        // I/O error detected.
+        return 2;
+      }
+    }
+
+    // Parameters: check the counter and set the view.
+
+    offset = data_buffer_current_;
+
+    memcpy((void*)&n_pars_found, (void*)&(data_buffer_[offset]), sizeof(int));
+    if (n_pars_found != n_parameter_iids) return 7;
+
+    offset = offset + sizeof(int);
+    the_parameter_iids.set(&(data_buffer_[offset]), n_pars_found);
+    offset = offset + n_pars_found * sizeof(int);
+
+    // Observations.
+
+    memcpy((void*)&n_obs_found, (void*)&(data_buffer_[offset]), sizeof(int));
+    if (n_obs_found != n_observation_iids) return 7;
+
+    offset = offset + sizeof(int);
+    the_observation_iids.set(&(data_buffer_[offset]), n_obs_found);
+    offset = offset + n_obs_found * sizeof(int);
+
+    // Instruments (if any).
+
+    memcpy((void*)&n_inst_found, (void*)&(data_buffer_[offset]), sizeof(int));
+    if (n_inst_found != n_instrument_iids) return 7;
+
+    offset = offset + sizeof(int);
+    the_instrument_iids.set(&(data_buffer_[offset]), n_inst_found);
+
+    // Consume the o-data.
+
+    data_buffer_current_ = data_buffer_current_ + bytes_to_eat;
+
+    // Update flags.
+
+    read_type_             = false;
+    read_active_flag_      = false;
+    read_identifier_       = false;
+    read_iid_              = false;
+    read_time_             = false;
+    read_l_data_           = false;
+    read_o_data_           = false;
+
+    reading_l_             = false;
+    reading_o_             = false;
+
+    read_completed_        = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 observation_file_reader_bin_forward::
 read_time
@@ -96,6 +96,36 @@ class observation_file_reader_bin_forward : public obs_e_based_file_reader_bin_f
                                                        int   n_instrument_iids,
                                                        int*& the_instrument_iids);
 
+    /**
+     * @brief Read the lists of parameter, observation and instrument instance
+     *        identifiers from an o-record without copying them.
+     *
+     * @param n_parameter_iids Total number of parameter instance identifiers
+     *        to read. Must be greater than 0.
+     * @param the_parameter_iids On output, read-only view of the parameter
+     *        instance identifiers.
+     * @param n_observation_iids Total number of observation instance identifiers
+     *        to read. Must be greater than 0.
+     * @param the_observation_iids On output, read-only view of the observation
+     *        instance identifiers.
+     * @param n_instrument_iids Total number of instrument instance identifiers
+     *        to read. May be zero.
+     * @param the_instrument_iids On output, read-only view of the instrument
+     *        instance identifiers.
+     * @return Error code. The same ones returned by read_o_data().
+     *
+     * The views point directly into the data buffer, so no data is copied,
+     * whatever the alignment of the o-record. They remain valid until the
+     * next call to read_type().
+     */
+
+    virtual int  read_o_data_view                     (int                 n_parameter_iids,
+                                                       astrolabe_int_view& the_parameter_iids,
+                                                       int                 n_observation_iids,
+                                                       astrolabe_int_view& the_observation_iids,
+                                                       int                 n_instrument_iids,
+                                                       astrolabe_int_view& the_instrument_iids);
+
     /**
      * @brief Read the time tag, either for l- or o-records.
      *
@@ -0,0 +1,1265 @@
+/** \file observation_file_reader_bin_parallel.cpp
+  \brief Implementation file for observation_file_reader_bin_parallel.hpp
+  \ingroup ASTROLABE_data_IO
+*/
+#include "observation_file_reader_bin_parallel.hpp"
+
+int
+observation_file_reader_bin_parallel::
+close
+(void)
+{
+  {
+    // Do not complain if the file is already closed.
+
+    if (!file_is_open_) return 0;
+
+    // Stop the workers before closing the file; they may still be reading.
+
+    stop_workers();
+
+    // Close the file itself.
+
+    return obs_e_based_file_reader_bin::close();
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+decode_range
+(astrolabe_compressed_file& stream,
+ epoch_range*               range)
+{
+  {
+    int          cur;
+    int          element_size;
+    int          i;
+    int          n_bytes;
+    epoch_record record;
+    int          size;
+    char         type;
+
+    //
+    // Read the whole range at once. Note that ranges start at the first
+    // record of an epoch, so there's no need to look for record boundaries.
+    //
+
+    size = (int)(range->end - range->begin);
+
+    range->raw.resize((size_t)size);
+
+    if (stream.seek(range->begin) != 0)                                return 2;
+    if (stream.read((void*)&range->raw[0], (size_t)size) != (size_t)size) return 2;
+
+    //
+    // Decode the records, that is, locate all their fields. Only complete
+    // records are kept, so when an error is found, the records preceding
+    // it may still be delivered.
+    //
+
+    cur = 0;
+
+    while (cur < size)
+    {
+      type = range->raw[cur];
+
+      // Backtracking information is of no interest here. Skip it.
+
+      if ((type == 'b') || (type == 'B'))
+      {
+        if (cur + (int)(sizeof(char) + sizeof(int)) > size) return 5;
+        cur += sizeof(char) + sizeof(int);
+        continue;
+      }
+
+      if ((type != 'l') && (type != 'o')) return 4;
+
+      record.type = type;
+      cur        += sizeof(char);
+
+      // Active flag and identifier.
+
+      if (cur + (int)(sizeof(char) + sizeof(int)) > size) return 5;
+
+      record.active = (range->raw[cur] == 1);
+      cur          += sizeof(char);
+
+      memcpy((void*)&record.id_length, (void*)&range->raw[cur], sizeof(int));
+      cur += sizeof(int);
+
+      if (record.id_length < 0)          return 4;
+      if (record.id_length > size - cur) return 5;
+
+      record.id_offset = cur;
+      cur             += record.id_length;
+
+      // Instance identifier (l-records only).
+
+      record.iid = 0;
+
+      if (type == 'l')
+      {
+        if (cur + (int)sizeof(int) > size) return 5;
+        memcpy((void*)&record.iid, (void*)&range->raw[cur], sizeof(int));
+        cur += sizeof(int);
+      }
+
+      // Time tag.
+
+      if (cur + (int)sizeof(double) > size) return 5;
+      memcpy((void*)&record.time, (void*)&range->raw[cur], sizeof(double));
+      cur += sizeof(double);
+
+      //
+      // The three counters, each followed by its array (doubles in
+      // l-records, ints in o-records).
+      //
+
+      record.data_offset = cur;
+
+      if (type == 'l') element_size = sizeof(double);
+      else             element_size = sizeof(int);
+
+      for (i = 0; i < 3; i++)
+      {
+        if (cur + (int)sizeof(int) > size) return 5;
+        memcpy((void*)&record.counts[i], (void*)&range->raw[cur], sizeof(int));
+        cur += sizeof(int);
+
+        if (record.counts[i] < 0) return 4;
+
+        if ((long long)record.counts[i] * element_size > (long long)(size - cur)) return 5;
+
+        n_bytes = record.counts[i] * element_size;
+        cur    += n_bytes;
+      }
+
+      // The record is complete.
+
+      range->records.push_back(record);
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+void
+observation_file_reader_bin_parallel::
+decode_ranges
+(void)
+{
+  {
+    FILE*                     file;
+    int                       index;
+    unique_lock<mutex>        lock(ranges_mutex_, defer_lock);
+    int                       max_index;
+    epoch_range*              range;
+    epoch_range*              spare;
+    int                       status;
+    astrolabe_compressed_file stream;
+
+    //
+    // Every worker uses its own file handle (and decompression buffers),
+    // so reads never interfere.
+    //
+
+    file = fopen(file_name_, "rb");
+
+    if (file != NULL)
+    {
+      if (stream.attach(file) != 0)
+      {
+        fclose(file);
+        file = NULL;
+      }
+    }
+
+    lock.lock();
+
+    while (true)
+    {
+      //
+      // Wait until there's a range to decode and room to keep it. The
+      // number of decoded ranges waiting to be read is bounded.
+      //
+
+      while (true)
+      {
+        max_index = current_range_ + n_threads_in_use_ * _ASTROLABE_OBS_E_FILE_READER_RANGES_PER_THREAD;
+
+        if (stop_workers_)                                       break;
+        if (next_range_to_decode_ >= (int)ranges_.size())        break;
+        if (next_range_to_decode_ <  max_index)                  break;
+
+        range_released_.wait(lock);
+      }
+
+      if (stop_workers_)                                break;
+      if (next_range_to_decode_ >= (int)ranges_.size()) break;
+
+      // Claim the next range and decode it without holding the lock.
+
+      index = next_range_to_decode_;
+      next_range_to_decode_++;
+
+      range = ranges_[index];
+
+      //
+      // Reuse the memory of a range already read, if any. This saves a
+      // lot of allocations (and page faults) when reading big files.
+      //
+
+      if (spare_ranges_.size() > 0)
+      {
+        spare = spare_ranges_.back();
+        spare_ranges_.pop_back();
+
+        range->raw.swap(spare->raw);
+        range->records.swap(spare->records);
+
+        delete spare;
+      }
+
+      lock.unlock();
+
+      if (file == NULL)
+      {
+        status = 2;
+      }
+      else
+      {
+        try
+        {
+          status = decode_range(stream, range);
+        }
+        catch (...)
+        {
+          status = 2; // Not enough memory.
+        }
+      }
+
+      // Publish the result.
+
+      lock.lock();
+
+      range->status  = status;
+      range->decoded = true;
+
+      range_decoded_.notify_all();
+    }
+
+    lock.unlock();
+
+    stream.detach();
+
+    if (file != NULL) fclose(file);
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+find_epoch_boundaries
+(vector<long long>& boundaries)
+{
+  {
+    long long         block_begin;
+    int               block_bytes;
+    int               cursor;
+    int               epoch_bytes;
+    int               i;
+    epoch_time_index  index;
+    string            index_name;
+    long long         position;
+    vector<long long> starts;
+    vector<char>      block;
+    int               size_b_record;
+
+    boundaries.clear();
+
+    //
+    // Use the time index, if any. It must be up to date (load() checks it
+    // against the size and modification time of the file) and must start
+    // at the beginning of the file.
+    //
+
+    index_name = index.get_index_file_name(file_name_);
+
+    if (index.load(index_name.c_str(), file_size_, astr_fmtime(file_name_)) == 0)
+    {
+      if ((index.get_number_of_epochs() > 0) && (index.get_offset(0) == 0))
+      {
+        for (i = 0; i < index.get_number_of_epochs(); i++) boundaries.push_back(index.get_offset(i));
+        boundaries.push_back(file_size_);
+
+        return 0;
+      }
+    }
+
+    //
+    // No index available. Follow the chain of backtracking records from
+    // the end of the file. Each epoch is followed by a 'b' tag and the
+    // number of bytes in the epoch (not including the 'b' record itself),
+    // so the start of every epoch may be computed from its end. The file
+    // is read backwards in blocks, to avoid a read per epoch.
+    //
+
+    size_b_record = sizeof(char) + sizeof(int);
+
+    block.resize(_ASTROLABE_OBS_E_FILE_READER_BACKTRACK_BLOCK_SIZE);
+
+    block_begin = file_size_; // Offset in the file of block[0].
+    position    = file_size_; // End of the epoch being located.
+
+    while (position > 0)
+    {
+      if (position < size_b_record) return 6;
+
+      // Load a new block (ending at position) if the 'b' record is not in the current one.
+
+      if (position - size_b_record < block_begin)
+      {
+        block_begin = position - _ASTROLABE_OBS_E_FILE_READER_BACKTRACK_BLOCK_SIZE;
+        if (block_begin < 0) block_begin = 0;
+
+        block_bytes = (int)(position - block_begin);
+
+        if (data_stream_.seek(block_begin) != 0) return 5;
+        if (data_stream_.read((void*)&block[0], (size_t)block_bytes) != (size_t)block_bytes) return 5;
+      }
+
+      cursor = (int)(position - size_b_record - block_begin);
+
+      if ((block[cursor] != 'b') && (block[cursor] != 'B')) return 6;
+
+      memcpy((void*)&epoch_bytes, (void*)&block[cursor + 1], sizeof(int));
+
+      if ((epoch_bytes < 0) || (epoch_bytes > position - size_b_record)) return 6;
+
+      position = position - size_b_record - epoch_bytes;
+
+      // Empty epochs (the file may end with an empty one) are ignored.
+
+      if (epoch_bytes > 0) starts.push_back(position);
+    }
+
+    // We've got the epochs in reverse order.
+
+    for (i = (int)starts.size() - 1; i >= 0; i--) boundaries.push_back(starts[i]);
+
+    // Files made only of empty epochs have no data at all.
+
+    if (boundaries.size() == 0) return 6;
+
+    boundaries.push_back(file_size_);
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+get_number_of_threads
+(void)
+const
+{
+  {
+    if (file_is_open_) return n_threads_in_use_;
+
+    return n_threads_;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+next_record
+(void)
+{
+  {
+    unique_lock<mutex> lock(ranges_mutex_, defer_lock);
+    epoch_range*       range;
+
+    while (true)
+    {
+      if (current_range_ >= (int)ranges_.size()) return 1;
+
+      range = ranges_[current_range_];
+
+      // Wait for the range to be decoded, if not done yet.
+
+      if (!current_range_ready_)
+      {
+        lock.lock();
+        while (!range->decoded) range_decoded_.wait(lock);
+        lock.unlock();
+
+        current_range_ready_ = true;
+      }
+
+      // Still more records in this range?
+
+      if (current_record_ < (int)range->records.size()) return 0;
+
+      //
+      // No more records. If the decoding stopped because of an error,
+      // now it's the moment to report it.
+      //
+
+      if (range->status != 0) return range->status;
+
+      //
+      // Release the range, leaving room for the workers to decode another
+      // one. Its memory will be reused.
+      //
+
+      range->raw.clear();
+      range->records.clear();
+
+      lock.lock();
+
+      ranges_[current_range_] = NULL;
+      current_range_++;
+
+      try
+      {
+        spare_ranges_.push_back(range);
+      }
+      catch (...)
+      {
+        delete range;
+      }
+
+      range_released_.notify_all();
+
+      lock.unlock();
+
+      current_record_      = 0;
+      current_range_ready_ = false;
+    }
+  }
+}
+
+observation_file_reader_bin_parallel::
+observation_file_reader_bin_parallel
+(void)
+{
+  {
+    current_range_        = 0;
+    current_range_ready_  = false;
+    current_record_       = 0;
+    next_range_to_decode_ = 0;
+    n_threads_            = 0;
+    n_threads_in_use_     = 0;
+    stop_workers_         = false;
+  }
+}
+
+observation_file_reader_bin_parallel::
+~observation_file_reader_bin_parallel
+(void)
+{
+  {
+    // The workers must be stopped before our members are destroyed.
+
+    stop_workers();
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+open
+(const char*  file_name)
+{
+  {
+    vector<long long> boundaries;
+    int               i;
+    int               n_epochs;
+    epoch_range*      range;
+    long long         range_begin;
+    int               status;
+
+    // Won't accept open requests if the file is already open.
+
+    if (file_is_open_) return 1;
+
+    // Try to open the file.
+
+    file_file_ = fopen(file_name, "rb");
+
+    if (file_file_ == NULL) return 2;
+
+    //
+    // Find out whether the file is compressed or not, and how big is the
+    // (uncompressed) data.
+    //
+
+    status = data_stream_.attach(file_file_);
+
+    if (status != 0)
+    {
+      fclose(file_file_);
+      if (status == 2) return 6; // Corrupted compressed file.
+      return 5;                  // I/O error.
+    }
+
+    file_size_ = data_stream_.get_size();
+
+    if (file_size_ == 0)
+    {
+      data_stream_.detach();
+      fclose(file_file_);
+      return 4; // Empty file.
+    }
+
+    // From now on, close() takes care of the clean up.
+
+    file_is_open_ = true;
+    file_name_    = strdup(file_name);
+
+    reset_read_state();
+
+    current_range_        = 0;
+    current_range_ready_  = false;
+    current_record_       = 0;
+    next_range_to_decode_ = 0;
+    stop_workers_         = false;
+
+    // Split the file into ranges of whole epochs.
+
+    try
+    {
+      status = find_epoch_boundaries(boundaries);
+
+      if (status != 0)
+      {
+        close();
+        return status;
+      }
+
+      //
+      // Put consecutive epochs together until the next one would make the
+      // range bigger than the size of the buffer.
+      //
+
+      n_epochs    = (int)boundaries.size() - 1;
+      range_begin = boundaries[0];
+
+      for (i = 1; i <= n_epochs; i++)
+      {
+        if ((i < n_epochs) && (boundaries[i + 1] - range_begin <= data_buffer_size_)) continue;
+
+        range            = new epoch_range();
+        range->begin     = range_begin;
+        range->end       = boundaries[i];
+        range->decoded   = false;
+        range->status    = 0;
+
+        ranges_.push_back(range);
+
+        range_begin = boundaries[i];
+      }
+    }
+    catch (...)
+    {
+      close();
+      return 3;
+    }
+
+    // Start the workers. There's no point in having more workers than ranges.
+
+    n_threads_in_use_ = n_threads_;
+
+    if (n_threads_in_use_ == 0) n_threads_in_use_ = (int)thread::hardware_concurrency();
+    if (n_threads_in_use_ <= 0) n_threads_in_use_ = 1;
+
+    if (n_threads_in_use_ > (int)ranges_.size()) n_threads_in_use_ = (int)ranges_.size();
+
+    try
+    {
+      for (i = 0; i < n_threads_in_use_; i++)
+      {
+        workers_.push_back(thread(&observation_file_reader_bin_parallel::decode_ranges, this));
+      }
+    }
+    catch (...)
+    {
+      close();
+      return 7;
+    }
+
+    // Successful completion.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_active_flag
+(bool& active)
+{
+  {
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only after read_type()
+    // has been called and no other read has been made.
+    //
+
+    if (!read_type_)        return 3;
+    if ( read_active_flag_) return 3;
+
+    // Get the flag.
+
+    active = ranges_[current_range_]->records[current_record_].active;
+
+    last_record_is_active_ = active;
+    read_active_flag_      = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_identifier
+(char*& identifier,
+ int    id_len)
+{
+  {
+    int           length;
+    epoch_range*  range;
+    epoch_record* record;
+
+    // Check that the file is open!
+
+    if (!file_is_open_)     return 2;
+
+    // Check preconditions. The active flag must have been read.
+
+    if (!read_active_flag_) return 3;
+    if ( read_identifier_)  return 3;
+
+    if (identifier == NULL) return 4;
+
+    // Is there enough room for the identifier and its ending NULL character?
+
+    range  = ranges_[current_range_];
+    record = &range->records[current_record_];
+    length = record->id_length;
+
+    if (id_len <= length)   return 4;
+
+    // Get the identifier.
+
+    if (length > 0) memcpy((void*)identifier, (void*)&range->raw[record->id_offset], (size_t)length);
+    identifier[length] = 0;
+
+    read_identifier_ = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_instance_id
+(int& instance_id)
+{
+  {
+    // Check that the file is open!
+
+    if (!file_is_open_)    return 2;
+
+    // Check preconditions. The identifier of an l-record must have been read.
+
+    if (!read_identifier_) return 3;
+    if ( read_iid_)        return 3;
+    if (!reading_l_)       return 3;
+
+    // Get the instance identifier.
+
+    instance_id = ranges_[current_range_]->records[current_record_].iid;
+
+    read_iid_ = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_l_data
+(int      n_tag_values,
+ double*& the_tags,
+ int      n_expectation_values,
+ double*& the_expectations,
+ int&     n_covariance_values_found,
+ double*& the_covariance_values)
+{
+  {
+    int           covariances;
+    int           expectations;
+    int           n;
+    epoch_range*  range;
+    epoch_record* record;
+    int           tags;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only when the time
+    // tag has been read and we are reading an l-type record.
+    //
+
+    if (!read_time_)               return 3;
+    if ( read_completed_)          return 3;
+    if (!reading_l_)               return 3;
+
+    // More preconditions: sizes of the output buffers.
+
+    if (n_tag_values < 0)          return 6;
+    if (n_expectation_values <= 0) return 6;
+
+    // The sizes must match those found in the record.
+
+    range  = ranges_[current_range_];
+    record = &range->records[current_record_];
+
+    if (record->counts[0] != n_tag_values)         return 7;
+    if (record->counts[1] != n_expectation_values) return 7;
+
+    n = n_expectation_values;
+
+    if ((record->counts[2] != 0) &
+        (record->counts[2] != n) &
+        (record->counts[2] != ((n * (n + 1)) / 2))) return 7;
+
+    //
+    // Locate the arrays. Each one is preceded by its counter (already
+    // checked).
+    //
+
+    tags         = record->data_offset + sizeof(int);
+    expectations = tags         + n_tag_values         * sizeof(double) + sizeof(int);
+    covariances  = expectations + n_expectation_values * sizeof(double) + sizeof(int);
+
+    n_covariance_values_found = record->counts[2];
+
+    // Copy the values.
+
+    if (n_tag_values > 0)
+    {
+      memcpy((void*)the_tags, (void*)&range->raw[tags], (size_t)n_tag_values * sizeof(double));
+    }
+
+    memcpy((void*)the_expectations, (void*)&range->raw[expectations], (size_t)n_expectation_values * sizeof(double));
+
+    if (n_covariance_values_found > 0)
+    {
+      memcpy((void*)the_covariance_values, (void*)&range->raw[covariances],
+             (size_t)n_covariance_values_found * sizeof(double));
+    }
+
+    // We're done with this record.
+
+    record_completed();
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_l_data_view
+(int                    n_tag_values,
+ astrolabe_double_view& the_tags,
+ int                    n_expectation_values,
+ astrolabe_double_view& the_expectations,
+ int&                   n_covariance_values_found,
+ astrolabe_double_view& the_covariance_values)
+{
+  {
+    int           covariances;
+    int           expectations;
+    int           n;
+    epoch_range*  range;
+    epoch_record* record;
+    int           tags;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only when the time
+    // tag has been read and we are reading an l-type record.
+    //
+
+    if (!read_time_)               return 3;
+    if ( read_completed_)          return 3;
+    if (!reading_l_)               return 3;
+
+    // More preconditions: sizes of the output buffers.
+
+    if (n_tag_values < 0)          return 6;
+    if (n_expectation_values <= 0) return 6;
+
+    // The sizes must match those found in the record.
+
+    range  = ranges_[current_range_];
+    record = &range->records[current_record_];
+
+    if (record->counts[0] != n_tag_values)         return 7;
+    if (record->counts[1] != n_expectation_values) return 7;
+
+    n = n_expectation_values;
+
+    if ((record->counts[2] != 0) &
+        (record->counts[2] != n) &
+        (record->counts[2] != ((n * (n + 1)) / 2))) return 7;
+
+    //
+    // Locate the arrays. Each one is preceded by its counter (already
+    // checked).
+    //
+
+    tags         = record->data_offset + sizeof(int);
+    expectations = tags         + n_tag_values         * sizeof(double) + sizeof(int);
+    covariances  = expectations + n_expectation_values * sizeof(double) + sizeof(int);
+
+    n_covariance_values_found = record->counts[2];
+
+    //
+    // Publish the views. Records are packed, so the arrays need not be
+    // aligned; the views do not require it.
+    //
+
+    the_tags.set             (&range->raw[tags],         n_tag_values);
+    the_expectations.set     (&range->raw[expectations], n_expectation_values);
+    the_covariance_values.set(&range->raw[covariances],  n_covariance_values_found);
+
+    // We're done with this record.
+
+    record_completed();
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_o_data
+(int   n_parameter_iids,
+ int*& the_parameter_iids,
+ int   n_observation_iids,
+ int*& the_observation_iids,
+ int   n_instrument_iids,
+ int*& the_instrument_iids)
+{
+  {
+    int           instruments;
+    int           observations;
+    int           parameters;
+    epoch_range*  range;
+    epoch_record* record;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only when the time
+    // tag has been read and we are reading an o-type record.
+    //
+
+    if (!read_time_)      return 3;
+    if ( read_completed_) return 3;
+    if (!reading_o_)      return 3;
+
+    // More preconditions: sizes of the output instance identifier arrays.
+
+    if (n_parameter_iids   <= 0) return 6;
+    if (n_observation_iids <= 0) return 6;
+    if (n_instrument_iids  <  0) return 6;
+
+    // The sizes must match those found in the record.
+
+    range  = ranges_[current_range_];
+    record = &range->records[current_record_];
+
+    if (record->counts[0] != n_parameter_iids)   return 7;
+    if (record->counts[1] != n_observation_iids) return 7;
+    if (record->counts[2] != n_instrument_iids)  return 7;
+
+    //
+    // Locate the arrays. Each one is preceded by its counter (already
+    // checked).
+    //
+
+    parameters   = record->data_offset + sizeof(int);
+    observations = parameters   + n_parameter_iids   * sizeof(int) + sizeof(int);
+    instruments  = observations + n_observation_iids * sizeof(int) + sizeof(int);
+
+    // Copy the values.
+
+    memcpy((void*)the_parameter_iids,   (void*)&range->raw[parameters],   (size_t)n_parameter_iids   * sizeof(int));
+    memcpy((void*)the_observation_iids, (void*)&range->raw[observations], (size_t)n_observation_iids * sizeof(int));
+
+    if (n_instrument_iids > 0)
+    {
+      memcpy((void*)the_instrument_iids, (void*)&range->raw[instruments], (size_t)n_instrument_iids * sizeof(int));
+    }
+
+    // We're done with this record.
+
+    record_completed();
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_o_data_view
+(int                 n_parameter_iids,
+ astrolabe_int_view& the_parameter_iids,
+ int                 n_observation_iids,
+ astrolabe_int_view& the_observation_iids,
+ int                 n_instrument_iids,
+ astrolabe_int_view& the_instrument_iids)
+{
+  {
+    int           instruments;
+    int           observations;
+    int           parameters;
+    epoch_range*  range;
+    epoch_record* record;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only when the time
+    // tag has been read and we are reading an o-type record.
+    //
+
+    if (!read_time_)      return 3;
+    if ( read_completed_) return 3;
+    if (!reading_o_)      return 3;
+
+    // More preconditions: sizes of the output instance identifier arrays.
+
+    if (n_parameter_iids   <= 0) return 6;
+    if (n_observation_iids <= 0) return 6;
+    if (n_instrument_iids  <  0) return 6;
+
+    // The sizes must match those found in the record.
+
+    range  = ranges_[current_range_];
+    record = &range->records[current_record_];
+
+    if (record->counts[0] != n_parameter_iids)   return 7;
+    if (record->counts[1] != n_observation_iids) return 7;
+    if (record->counts[2] != n_instrument_iids)  return 7;
+
+    //
+    // Locate the arrays. Each one is preceded by its counter (already
+    // checked).
+    //
+
+    parameters   = record->data_offset + sizeof(int);
+    observations = parameters   + n_parameter_iids   * sizeof(int) + sizeof(int);
+    instruments  = observations + n_observation_iids * sizeof(int) + sizeof(int);
+
+    // Publish the views.
+
+    the_parameter_iids.set  (&range->raw[parameters],   n_parameter_iids);
+    the_observation_iids.set(&range->raw[observations], n_observation_iids);
+    the_instrument_iids.set (&range->raw[instruments],  n_instrument_iids);
+
+    // We're done with this record.
+
+    record_completed();
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_time
+(double& time)
+{
+  {
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only in the following
+    // situations:
+    //
+    //   - if reading an l-type record, the instance identifier and no other further
+    //     component of the record must have been read.
+    //   - if reading an o-type record, the identifier and no other further component
+    //     of the record must have been read.
+    //
+
+    if (reading_l_)
+    {
+      if (!read_iid_)        return 3;
+      if ( read_l_data_)     return 3;
+    }
+    else // reading_o_
+    {
+      if (!read_identifier_) return 3;
+      if ( read_o_data_)     return 3;
+    }
+
+    // Get the time.
+
+    time = ranges_[current_range_]->records[current_record_].time;
+
+    read_time_ = true;
+
+    //
+    // Update last time / epoch related flags and values, exactly as
+    // sequential readers do. Inactive records do not change the status
+    // of the reader concerning epochs.
+    //
+
+    if (last_record_is_active_)
+    {
+      if (last_epoch_time_available_)
+      {
+        if (last_epoch_time_ != time)
+        {
+          last_epoch_changed_      = true;
+          last_epoch_time_         = time;
+        }
+        else
+        {
+          last_epoch_changed_      = false;
+        }
+      }
+      else
+      {
+        last_epoch_changed_        = false;
+        last_epoch_time_           = time;
+        last_epoch_time_available_ = true;
+      }
+
+      // Whenever the epoch changes, we "loose" our first l-record.
+
+      if (last_epoch_changed_) first_l_read_ = false;
+
+      //
+      // Check that when reading an o-record a previous l-record has
+      // been obtained.
+      //
+
+      if ((last_epoch_changed_) || (reading_first_epoch_))
+      {
+        if (reading_o_)
+        {
+          if (!first_l_read_) return 5; // o-records may not start an epoch.
+        }
+        else // reading an l-record.
+        {
+          if (!first_l_read_) first_l_read_ = true;
+        }
+      }
+
+      // If the epoch changes, we will no more be reading the first one.
+
+      if (last_epoch_changed_) reading_first_epoch_ = false;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+read_type
+(char& record_type)
+{
+  {
+    int status;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 2;
+
+    //
+    // Check preconditions. This function works only if no other
+    // read operation is on its way.
+    //
+
+    if (!read_completed_) return 3;
+
+    // Move to the next record, waiting for the workers if needed.
+
+    status = next_record();
+
+    if (status == 1)
+    {
+      // End-of-file condition detected.
+
+      is_eof_ = true;
+      return 1;
+    }
+    else if (status == 5)
+    {
+      // Truncated record: the file is corrupted.
+
+      is_eof_ = true;
+      return 5;
+    }
+    else if (status != 0)
+    {
+      return status;
+    }
+
+    // Get the type and set flags accordingly.
+
+    record_type = ranges_[current_range_]->records[current_record_].type;
+
+    if (record_type == 'o')
+    {
+      reading_o_ = true;
+      reading_l_ = false;
+    }
+    else
+    {
+      reading_o_ = false;
+      reading_l_ = true;
+    }
+
+    read_completed_        = false;
+    read_type_             = true;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+void
+observation_file_reader_bin_parallel::
+record_completed
+(void)
+{
+  {
+    // Reset the flags controlling the reading process and move to the next record.
+
+    read_type_             = false;
+    read_active_flag_      = false;
+    read_identifier_       = false;
+    read_iid_              = false;
+    read_time_             = false;
+    read_l_data_           = false;
+    read_o_data_           = false;
+    reading_l_             = false;
+    reading_o_             = false;
+    read_completed_        = true;
+
+    current_record_++;
+  }
+}
+
+int
+observation_file_reader_bin_parallel::
+set_number_of_threads
+(int n_threads)
+{
+  {
+    // If the file is already open, it's not legal to change the number of threads.
+
+    if (file_is_open_) return 1;
+
+    // Zero means "as many as cores".
+
+    if (n_threads < 0) return 2;
+
+    n_threads_ = n_threads;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+void
+observation_file_reader_bin_parallel::
+stop_workers
+(void)
+{
+  {
+    int                i;
+    unique_lock<mutex> lock(ranges_mutex_, defer_lock);
+
+    // Tell the workers to finish and wake them up.
+
+    lock.lock();
+
+    stop_workers_ = true;
+
+    range_released_.notify_all();
+    range_decoded_.notify_all();
+
+    lock.unlock();
+
+    // Wait for them.
+
+    for (i = 0; i < (int)workers_.size(); i++)
+    {
+      if (workers_[i].joinable()) workers_[i].join();
+    }
+
+    workers_.clear();
+
+    // Discard all the ranges still alive.
+
+    for (i = 0; i < (int)ranges_.size(); i++)
+    {
+      if (ranges_[i] != NULL) delete ranges_[i];
+    }
+
+    ranges_.clear();
+
+    for (i = 0; i < (int)spare_ranges_.size(); i++) delete spare_ranges_[i];
+
+    spare_ranges_.clear();
+
+    current_range_        = 0;
+    current_range_ready_  = false;
+    current_record_       = 0;
+    next_range_to_decode_ = 0;
+  }
+}
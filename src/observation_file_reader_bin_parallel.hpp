@@ -0,0 +1,505 @@
+/** \file observation_file_reader_bin_parallel.hpp
+  \brief Class defining the interface of multithreaded observation binary file readers.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef OBSERVATION_FILE_READER_BIN_PARALLEL_HPP
+#define OBSERVATION_FILE_READER_BIN_PARALLEL_HPP
+
+#include "obs_e_based_file_reader_bin.hpp"
+#include "epoch_time_index.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/// @brief Size of the blocks read when walking the backtracking records
+/// from the end of the file: 64 Kbyte (64 * 1024 bytes)
+
+#define _ASTROLABE_OBS_E_FILE_READER_BACKTRACK_BLOCK_SIZE 65536
+
+/// @brief Number of ranges that every worker thread may keep decoded
+/// ahead of the consumer.
+
+#define _ASTROLABE_OBS_E_FILE_READER_RANGES_PER_THREAD 2
+
+/**
+ * @brief Class defining the interface of multithreaded observation binary file readers.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * This class implements the interface defined in parent class
+ * obs_e_based_file_reader_bin, reading observation files stored in binary
+ * format in forward direction, as observation_file_reader_bin_forward does.
+ * The difference is that the file is decoded by a pool of worker threads.
+ *
+ * When the file is opened, it is split into ranges made of whole epochs.
+ * The boundaries of the epochs are taken from the time index of the file,
+ * when available and up to date (see epoch_time_index); otherwise, the
+ * backtracking (b) records written after every epoch are followed from the
+ * end of the file to its beginning. Each range holds as many consecutive
+ * epochs as fit in the size set with set_buffer_size() (a single epoch
+ * bigger than this size makes a range by itself).
+ *
+ * Worker threads read ranges, using their own file handles, and decode
+ * them completely. The read_* methods just hand out the values already
+ * decoded, range after range, so records and epochs are delivered in the
+ * same order, with the same epoch semantics and error codes, than
+ * those of the sequential readers. At most
+ * _ASTROLABE_OBS_E_FILE_READER_RANGES_PER_THREAD ranges per thread are
+ * kept decoded ahead of the reader, so memory usage is bounded no matter
+ * the size of the file. Worker threads already read the file ahead
+ * of the consumer, so set_prefetch() has no effect on this reader.
+ *
+ * Decoding a range means locating all the fields of its records, so
+ * values are copied just once, when handed out. As in forward readers,
+ * views (see read_l_data_view() and read_o_data_view()) point directly
+ * to the data read.
+ *
+ * The reader object itself must be used from a single thread; the
+ * synchronization with the worker threads is internal.
+ */
+
+class observation_file_reader_bin_parallel : public obs_e_based_file_reader_bin
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                 observation_file_reader_bin_parallel  (void);
+
+    /**
+     * @brief Destructor
+     */
+
+                 ~observation_file_reader_bin_parallel (void);
+
+    /**
+     * @brief Closes the file reader, disabling any other
+     *        further action on it.
+     * @return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: Error closing the file.
+     *
+     * Worker threads are stopped and all the decoded data is discarded.
+     */
+
+    virtual int  close                                (void);
+
+    /**
+     * @brief Retrieve the number of worker threads in use or requested.
+     * @return Once the file is open, the number of worker threads actually
+     *         in use. Otherwise, the number of threads requested using
+     *         set_number_of_threads() (0 meaning "as many as cores").
+     */
+
+    virtual int  get_number_of_threads                (void) const;
+
+    /**
+     * @brief Opens the reader, enabling I/O operations.
+     *
+     * @param file_name Name of the file to read.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file was already open.
+     *        - 2: Unable to open the selected file.
+     *        - 3: Not enough memory to allocate the internal structures.
+     *        - 4: End of file condition detected - the file is empty.
+     *        - 5: I/O error detected while reading the file.
+     *        - 6: Invalid file. The backtracking information needed
+     *             to split the file into epochs is missing or corrupted,
+     *             or the file is a corrupted block-compressed one.
+     *        - 7: Unable to start the worker threads.
+     *
+     * The file is split into ranges of epochs (see the class description)
+     * and the worker threads are started, so decoding begins right away.
+     *
+     * Both plain and block-compressed files (see
+     * obs_e_based_file_writer_bin::set_compression()) are accepted.
+     */
+
+    virtual int  open                                 (const char* file_name);
+
+    /**
+     * @brief Reads the active flag for either l- or o-records.
+     *
+     * @param active Value of the l- or o-record's active flag.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: NOT USED.
+     *         - 2: The file has not been opened.
+     *         - 3: Invalid call sequence.
+     *
+     * See obs_e_based_file_reader::read_active_flag().
+     */
+
+    virtual int  read_active_flag                     (bool& active);
+
+    /**
+     * @brief Reads the identifier field for either l- or o-records.
+     *
+     * @param identifier Value of the l- or o-record's identifier. Must be
+     *        preallocated, with room for id_len characters.
+     * @param id_len Maximum number of characters in identifier,
+     *        including the ending NULL character.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: NOT USED.
+     *         - 2: The file has not been opened.
+     *         - 3: Invalid call sequence.
+     *         - 4: The identifier buffer is NULL or too short.
+     *
+     * See obs_e_based_file_reader::read_identifier().
+     */
+
+    virtual int  read_identifier                      (char*& identifier,
+                                                       int    id_len);
+
+    /**
+     * @brief Reads the instance identifier field for l-records.
+     *
+     * @param instance_id The instance identifier of the l-record.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: NOT USED.
+     *         - 2: The file has not been opened.
+     *         - 3: Invalid call sequence.
+     *
+     * See obs_e_based_file_reader::read_instance_id().
+     */
+
+    virtual int  read_instance_id                     (int& instance_id);
+
+    /**
+     * @brief Reads the data block in an l-record.
+     *
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: NOT USED.
+     *         - 2: The file has not been opened.
+     *         - 3: Invalid call sequence.
+     *         - 6: Invalid dimensions requested.
+     *         - 7: The dimensions requested do not match those
+     *              found in the l-record.
+     *
+     * See obs_e_based_file_reader::read_l_data() for a description
+     * of the parameters.
+     */
+
+    virtual int  read_l_data                          (int      n_tag_values,
+                                                       double*& the_tags,
+                                                       int      n_expectation_values,
+                                                       double*& the_expectations,
+                                                       int&     n_covariance_values_found,
+                                                       double*& the_covariance_values);
+
+    /**
+     * @brief Reads the data block in an l-record without copying it.
+     *
+     * @return Error code. The same ones returned by read_l_data().
+     *
+     * The views point to the data of the range being read, which is kept
+     * until the next call to read_type().
+     */
+
+    virtual int  read_l_data_view                     (int                    n_tag_values,
+                                                       astrolabe_double_view& the_tags,
+                                                       int                    n_expectation_values,
+                                                       astrolabe_double_view& the_expectations,
+                                                       int&                   n_covariance_values_found,
+                                                       astrolabe_double_view& the_covariance_values);
+
+    /**
+     * @brief Read the lists of parameter, observation and instrument instance
+     *        identifiers from an o-record.
+     *
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: NOT USED.
+     *         - 2: The file has not been opened.
+     *         - 3: Invalid call sequence.
+     *         - 6: Invalid dimensions requested.
+     *         - 7: The dimensions requested do not match those
+     *              found in the o-record.
+     *
+     * See obs_e_based_file_reader::read_o_data() for a description
+     * of the parameters.
+     */
+
+    virtual int  read_o_data                          (int   n_parameter_iids,
+                                                       int*& the_parameter_iids,
+                                                       int   n_observation_iids,
+                                                       int*& the_observation_iids,
+                                                       int   n_instrument_iids,
+                                                       int*& the_instrument_iids);
+
+    /**
+     * @brief Read the lists of parameter, observation and instrument instance
+     *        identifiers from an o-record without copying them.
+     *
+     * @return Error code. The same ones returned by read_o_data().
+     *
+     * The views point to the data of the range being read, which is kept
+     * until the next call to read_type().
+     */
+
+    virtual int  read_o_data_view                     (int                 n_parameter_iids,
+                                                       astrolabe_int_view& the_parameter_iids,
+                                                       int                 n_observation_iids,
+                                                       astrolabe_int_view& the_observation_iids,
+                                                       int                 n_instrument_iids,
+                                                       astrolabe_int_view& the_instrument_iids);
+
+    /**
+     * @brief Read the time tag, either for l- or o-records.
+     *
+     * @param time The time tag.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: NOT USED.
+     *         - 2: The file has not been opened.
+     *         - 3: Invalid call sequence.
+     *         - 4: NOT USED.
+     *         - 5: An epoch change has been detected when reading
+     *              the time. The record being read, which is the
+     *              first of the new epoch, is an o-record, which
+     *              is illegal.
+     *
+     * See obs_e_based_file_reader::read_time().
+     */
+
+    virtual int  read_time                            (double& time);
+
+    /**
+     * @brief Read the event record type.
+     *
+     * @param record_type The type of the record being read, either an 'l' or
+     *        an 'o' (both lowercase).
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: End-of-file (no more data).
+     *         - 2: I/O error while reading (might happen if the file
+     *              has not been opened).
+     *         - 3: Invalid call sequence.
+     *         - 4: Malformed record found.
+     *         - 5: Unexpected end of data. Invalid file.
+     *
+     * If the range holding the next record is still being decoded, this
+     * method waits for it. Errors found by the worker threads when
+     * decoding a range are reported once all the records preceding the
+     * wrong one have been delivered.
+     *
+     * See obs_e_based_file_reader::read_type().
+     */
+
+    virtual int  read_type                            (char& record_type);
+
+    /**
+     * @brief Set the number of worker threads.
+     *
+     * @param n_threads Number of worker threads. Zero means as many as
+     *        cores are available.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The file is already open.
+     *         - 2: Invalid number of threads (negative).
+     *
+     * This method may be called only before open(). If not called, the
+     * number of threads is set after the number of cores.
+     */
+
+    virtual int  set_number_of_threads                (int n_threads);
+
+  protected:
+
+    /// @brief Location of the fields of a decoded record.
+
+    struct epoch_record
+    {
+      /// @brief Type of the record ('l' or 'o').
+
+      char           type;
+
+      /// @brief Active flag.
+
+      bool           active;
+
+      /// @brief Length of the identifier.
+
+      int            id_length;
+
+      /// @brief Offset of the identifier in the raw data of the range.
+
+      int            id_offset;
+
+      /// @brief Instance identifier (l-records only).
+
+      int            iid;
+
+      /// @brief Time tag.
+
+      double         time;
+
+      /// @brief The three counters (number of tags, expectations and
+      /// covariance values in l-records; number of parameter, observation
+      /// and instrument instance identifiers in o-records).
+
+      int            counts[3];
+
+      /// @brief Offset of the first counter in the raw data of the range.
+
+      int            data_offset;
+    };
+
+    /// @brief A range of consecutive epochs and, once decoded, its records.
+
+    struct epoch_range
+    {
+      /// @brief Offset in the file of the first byte in the range.
+
+      long long            begin;
+
+      /// @brief Offset in the file of the byte following the range.
+
+      long long            end;
+
+      /// @brief True once a worker thread has processed the range.
+
+      bool                 decoded;
+
+      /// @brief Status of the decoding (0, or an error code for read_type()).
+
+      int                  status;
+
+      /// @brief The bytes in the range, as read from the file.
+
+      vector<char>         raw;
+
+      /// @brief The records found, up to the first error, if any.
+
+      vector<epoch_record> records;
+    };
+
+    /**
+     * @brief Decode a range of epochs.
+     *
+     * @param stream The file to read from (owned by the calling worker).
+     * @param range The range to decode.
+     * @return The status of the range: 0 if it was decoded successfully,
+     *         or 2 (I/O error), 4 (malformed record) or 5 (unexpected end
+     *         of data), as read_type() would report them.
+     */
+
+    int          decode_range                         (astrolabe_compressed_file& stream,
+                                                       epoch_range*               range);
+
+    /**
+     * @brief Body of the worker threads.
+     *
+     * Claims and decodes ranges, in order, as long as the number of
+     * decoded ranges waiting to be read stays within limits.
+     */
+
+    void         decode_ranges                        (void);
+
+    /**
+     * @brief Compute the boundaries of the epochs in the file.
+     *
+     * @param boundaries On output, the offsets of the first byte in every
+     *        epoch, in file order, followed by the size of the file.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 5: I/O error.
+     *         - 6: Invalid backtracking information.
+     *
+     * The time index of the file is used when up to date; otherwise the
+     * backtracking records are followed from the end of the file.
+     */
+
+    int          find_epoch_boundaries                (vector<long long>& boundaries);
+
+    /**
+     * @brief Move to the next record, releasing ranges already read
+     *        and waiting for the next one when needed.
+     *
+     * @return 0 if a record is available, 1 at the end of the file or
+     *         the error code found while decoding the range.
+     */
+
+    int          next_record                          (void);
+
+    /**
+     * @brief Reset the flags controlling the reading process once a record
+     *        has been completely read, and move to the next one.
+     */
+
+    void         record_completed                     (void);
+
+    /**
+     * @brief Stop the worker threads and discard all ranges.
+     */
+
+    void         stop_workers                         (void);
+
+  protected:
+
+    /// @brief Index of the range being read.
+
+    int                   current_range_;
+
+    /// @brief Flag. When true, the range being read has already been decoded.
+
+    bool                  current_range_ready_;
+
+    /// @brief Index, in the current range, of the record being read.
+
+    int                   current_record_;
+
+    /// @brief Index of the next range to be claimed by a worker thread.
+
+    int                   next_range_to_decode_;
+
+    /// @brief Number of worker threads requested (0: one per core).
+
+    int                   n_threads_;
+
+    /// @brief Number of worker threads in use.
+
+    int                   n_threads_in_use_;
+
+    /// @brief Signaled when a worker finishes decoding a range.
+
+    condition_variable    range_decoded_;
+
+    /// @brief Signaled when the reader is done with a range.
+
+    condition_variable    range_released_;
+
+    /// @brief The ranges the file is split into.
+
+    vector<epoch_range*>  ranges_;
+
+    /// @brief Protects the ranges and counters shared with the workers.
+
+    mutex                 ranges_mutex_;
+
+    /// @brief Ranges already read, kept to reuse their memory.
+
+    vector<epoch_range*>  spare_ranges_;
+
+    /// @brief Flag. When true, the worker threads must finish.
+
+    bool                  stop_workers_;
+
+    /// @brief The worker threads.
+
+    vector<thread>        workers_;
+
+};
+
+#endif // OBSERVATION_FILE_READER_BIN_PARALLEL_HPP
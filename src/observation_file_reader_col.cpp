@@ -0,0 +1,703 @@
+/** \file observation_file_reader_col.cpp
+  \brief Implementation file for observation_file_reader_col.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+#include "observation_file_reader_col.hpp"
+
+#include "astrolabe_file_utilities.hpp"
+
+//
+// Take n_bytes out of the directory being parsed (see parse_directory()),
+// checking that these do not go beyond its end.
+//
+
+static bool
+take
+(const char*& cur,
+ const char*  end,
+ void*        dest,
+ long long    n_bytes)
+{
+  {
+    if (n_bytes > (long long)(end - cur)) return false;
+
+    memcpy(dest, cur, (size_t)n_bytes);
+    cur += n_bytes;
+
+    return true;
+  }
+}
+
+int
+observation_file_reader_col::
+close
+(void)
+{
+  {
+    int status;
+
+    // Do not complain if the file is already closed.
+    if (!file_is_open_) return 0;
+
+    directory_.clear();
+    file_is_open_ = false;
+
+    // Close the file.
+
+    status = fclose(file_file_);
+    file_file_ = NULL;
+
+    if (status != 0) return 1;
+
+    // Successful completion.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_col::
+find_blocks
+(const char*  identifier,
+ double       time_from,
+ double       time_to,
+ vector<int>& blocks)
+{
+  {
+    int i;
+
+    blocks.clear();
+
+    if (!file_is_open_) return 1;
+
+    for (i = 0; i < (int)directory_.size(); i++)
+    {
+      // Discard blocks of other kinds of records...
+
+      if (identifier != NULL)
+      {
+        if (directory_[i].identifier != identifier) continue;
+      }
+
+      // ... or out of the time range requested.
+
+      if (directory_[i].time_max < time_from) continue;
+      if (directory_[i].time_min > time_to)   continue;
+
+      blocks.push_back(i);
+    }
+
+    return 0;
+  }
+}
+
+const char*
+observation_file_reader_col::
+get_block_identifier
+(int block)
+const
+{
+  {
+    return directory_[block].identifier.c_str();
+  }
+}
+
+long long
+observation_file_reader_col::
+get_block_n_covariance_values
+(int block)
+const
+{
+  {
+    if (directory_[block].type != 'l') return 0;
+
+    // The covariance values are always the last column of l-blocks.
+
+    return directory_[block].column_sizes.back() / sizeof(double);
+  }
+}
+
+int
+observation_file_reader_col::
+get_block_n_expectations
+(int block)
+const
+{
+  {
+    if (directory_[block].type != 'l') return 0;
+
+    return directory_[block].dimensions[1];
+  }
+}
+
+int
+observation_file_reader_col::
+get_block_n_instrument_iids
+(int block)
+const
+{
+  {
+    if (directory_[block].type != 'o') return 0;
+
+    return directory_[block].dimensions[2];
+  }
+}
+
+int
+observation_file_reader_col::
+get_block_n_observation_iids
+(int block)
+const
+{
+  {
+    if (directory_[block].type != 'o') return 0;
+
+    return directory_[block].dimensions[1];
+  }
+}
+
+int
+observation_file_reader_col::
+get_block_n_parameter_iids
+(int block)
+const
+{
+  {
+    if (directory_[block].type != 'o') return 0;
+
+    return directory_[block].dimensions[0];
+  }
+}
+
+int
+observation_file_reader_col::
+get_block_n_records
+(int block)
+const
+{
+  {
+    return directory_[block].n_records;
+  }
+}
+
+int
+observation_file_reader_col::
+get_block_n_tags
+(int block)
+const
+{
+  {
+    if (directory_[block].type != 'l') return 0;
+
+    return directory_[block].dimensions[0];
+  }
+}
+
+double
+observation_file_reader_col::
+get_block_time_max
+(int block)
+const
+{
+  {
+    return directory_[block].time_max;
+  }
+}
+
+double
+observation_file_reader_col::
+get_block_time_min
+(int block)
+const
+{
+  {
+    return directory_[block].time_min;
+  }
+}
+
+char
+observation_file_reader_col::
+get_block_type
+(int block)
+const
+{
+  {
+    return directory_[block].type;
+  }
+}
+
+int
+observation_file_reader_col::
+get_n_blocks
+(void)
+const
+{
+  {
+    return (int)directory_.size();
+  }
+}
+
+bool
+observation_file_reader_col::
+is_open
+(void)
+const
+{
+  {
+    return file_is_open_;
+  }
+}
+
+observation_file_reader_col::
+observation_file_reader_col
+(void)
+{
+  {
+    file_file_    = NULL;
+    file_is_open_ = false;
+  }
+}
+
+observation_file_reader_col::
+~observation_file_reader_col
+(void)
+{
+  {
+    close();
+  }
+}
+
+int
+observation_file_reader_col::
+open
+(const char* file_name)
+{
+  {
+    char*     directory;
+    long long directory_offset;
+    long long directory_size;
+    long long file_size;
+    char      magic[_ASTROLABE_COL_FILE_MAGIC_SIZE];
+    int       n_blocks;
+    int       status;
+    long long trailer_size;
+
+    // Won't accept open requests if the file is already open.
+
+    if (file_is_open_) return 1;
+
+    file_file_ = fopen(file_name, "rb");
+    if (file_file_ == NULL) return 2;
+
+    //
+    // Check the magic string at the beginning of the file, then read the
+    // trailer at its end, telling where the directory is.
+    //
+
+    trailer_size = sizeof(long long) + sizeof(int) + _ASTROLABE_COL_FILE_MAGIC_SIZE;
+
+    file_size = astr_fsize(file_file_);
+
+    status = 0;
+
+    if (file_size < _ASTROLABE_COL_FILE_MAGIC_SIZE + trailer_size)
+    {
+      status = 4;
+    }
+    else if ((astr_fseek(file_file_, 0, SEEK_SET) != 0) ||
+             (fread(magic, 1, _ASTROLABE_COL_FILE_MAGIC_SIZE, file_file_) != _ASTROLABE_COL_FILE_MAGIC_SIZE))
+    {
+      status = 5;
+    }
+    else if (memcmp(magic, _ASTROLABE_COL_FILE_MAGIC, _ASTROLABE_COL_FILE_MAGIC_SIZE) != 0)
+    {
+      status = 4;
+    }
+    else if ((astr_fseek(file_file_, file_size - trailer_size, SEEK_SET) != 0)        ||
+             (fread(&directory_offset, sizeof(long long), 1, file_file_) != 1)       ||
+             (fread(&n_blocks, sizeof(int), 1, file_file_) != 1)                     ||
+             (fread(magic, 1, _ASTROLABE_COL_FILE_MAGIC_SIZE, file_file_) != _ASTROLABE_COL_FILE_MAGIC_SIZE))
+    {
+      status = 5;
+    }
+    else if (memcmp(magic, _ASTROLABE_COL_FILE_MAGIC, _ASTROLABE_COL_FILE_MAGIC_SIZE) != 0)
+    {
+      status = 4; // Not a columnar file, or one that was not closed.
+    }
+    else if ((directory_offset < _ASTROLABE_COL_FILE_MAGIC_SIZE) ||
+             (directory_offset > file_size - trailer_size)       ||
+             (n_blocks < 0))
+    {
+      status = 4;
+    }
+
+    if (status != 0)
+    {
+      fclose(file_file_);
+      file_file_ = NULL;
+      return status;
+    }
+
+    // Load the whole directory and parse it.
+
+    directory_size = file_size - trailer_size - directory_offset;
+
+    try
+    {
+      directory = new char[(size_t)directory_size + 1];
+    }
+    catch (...)
+    {
+      fclose(file_file_);
+      file_file_ = NULL;
+      return 3;
+    }
+
+    if ((astr_fseek(file_file_, directory_offset, SEEK_SET) != 0) ||
+        (fread(directory, 1, (size_t)directory_size, file_file_) != (size_t)directory_size))
+    {
+      status = 5;
+    }
+    else if (parse_directory(directory, directory_size, n_blocks, directory_offset) != 0)
+    {
+      status = 4;
+    }
+
+    delete [] directory;
+
+    if (status != 0)
+    {
+      directory_.clear();
+      fclose(file_file_);
+      file_file_ = NULL;
+      return status;
+    }
+
+    file_is_open_ = true;
+
+    // Successful completion.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_col::
+parse_directory
+(const char* directory,
+ long long   directory_size,
+ int         n_blocks,
+ long long   directory_offset)
+{
+  {
+    long long    block_offset;
+    const char*  cur;
+    const char*  end;
+    long long    element_size;
+    block_entry* entry;
+    int          expected_columns;
+    int          i;
+    int          id_length;
+    int          j;
+    long long    min_entry_size;
+    int          n_columns;
+    long long    offset;
+
+    cur = directory;
+    end = directory + directory_size;
+
+    //
+    // Every entry takes, at least, a type, an identifier one char long
+    // and all the fixed size fields. Do not trust n_blocks beyond that.
+    //
+
+    min_entry_size = sizeof(char) + sizeof(int) + 1 + sizeof(int) + 2 * sizeof(double) +
+                     3 * sizeof(int) + sizeof(long long) + sizeof(int);
+
+    if ((long long)n_blocks > directory_size / min_entry_size) return 1;
+
+    directory_.clear();
+    directory_.resize(n_blocks);
+
+    for (i = 0; i < n_blocks; i++)
+    {
+      entry = &directory_[i];
+
+      if (!take(cur, end, &entry->type, sizeof(char)))  return 1;
+      if (!take(cur, end, &id_length,   sizeof(int)))   return 1;
+
+      if ((id_length < 1) || (id_length > end - cur)) return 1;
+
+      entry->identifier.assign(cur, id_length);
+      cur += id_length;
+
+      if (!take(cur, end, &entry->n_records, sizeof(int)))       return 1;
+      if (!take(cur, end, &entry->time_min,  sizeof(double)))    return 1;
+      if (!take(cur, end, &entry->time_max,  sizeof(double)))    return 1;
+      if (!take(cur, end, entry->dimensions, 3 * sizeof(int)))   return 1;
+      if (!take(cur, end, &block_offset,     sizeof(long long))) return 1;
+      if (!take(cur, end, &n_columns,        sizeof(int)))       return 1;
+
+      // The number of columns depends on the type and dimensions of the block.
+
+      if (entry->n_records <= 0) return 1;
+
+      if (entry->type == 'l')
+      {
+        if ((entry->dimensions[0] < 0) || (entry->dimensions[1] <= 0)) return 1;
+
+        expected_columns = 3 + entry->dimensions[0] + entry->dimensions[1] + 2;
+      }
+      else if (entry->type == 'o')
+      {
+        if ((entry->dimensions[0] <= 0) || (entry->dimensions[1] <= 0) || (entry->dimensions[2] < 0)) return 1;
+
+        expected_columns = 2 + entry->dimensions[0] + entry->dimensions[1] + entry->dimensions[2];
+      }
+      else
+      {
+        return 1;
+      }
+
+      if (n_columns != expected_columns) return 1;
+
+      entry->column_sizes.resize(n_columns);
+      entry->column_offsets.resize(n_columns);
+
+      if (!take(cur, end, entry->column_sizes.data(), n_columns * sizeof(long long))) return 1;
+
+      //
+      // Columns are stored one after the other. None may reach the directory.
+      // All of them but the covariance values of l-blocks hold one value
+      // per record.
+      //
+
+      offset = block_offset;
+
+      for (j = 0; j < n_columns; j++)
+      {
+        if      (j == 0)                 element_size = sizeof(double); // Time tags.
+        else if (j == 1)                 element_size = sizeof(char);   // Active flags.
+        else if (entry->type == 'o')     element_size = sizeof(int);    // Instance identifiers.
+        else if (j == 2)                 element_size = sizeof(int);    // Instance identifiers.
+        else if (j <  n_columns - 2)     element_size = sizeof(double); // Tags and expectations.
+        else if (j == n_columns - 2)     element_size = sizeof(int);    // Covariance counts.
+        else                             element_size = 0;              // Covariance values.
+
+        if (element_size != 0)
+        {
+          if (entry->column_sizes[j] != (long long)entry->n_records * element_size) return 1;
+        }
+        else
+        {
+          if (entry->column_sizes[j] < 0)                                     return 1;
+          if ((entry->column_sizes[j] % (long long)sizeof(double)) != 0)      return 1;
+        }
+
+        entry->column_offsets[j] = offset;
+        offset                  += entry->column_sizes[j];
+      }
+
+      if ((block_offset < _ASTROLABE_COL_FILE_MAGIC_SIZE) || (offset > directory_offset)) return 1;
+    }
+
+    // Nothing should be left.
+
+    if (cur != end) return 1;
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_col::
+read_active_flags
+(int   block,
+ char* active_flags)
+{
+  {
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+
+    return read_column(block, 1, active_flags);
+  }
+}
+
+int
+observation_file_reader_col::
+read_column
+(int   block,
+ int   column,
+ void* values)
+{
+  {
+    size_t size;
+
+    size = (size_t)directory_[block].column_sizes[column];
+
+    if (size == 0) return 0;
+
+    if (astr_fseek(file_file_, directory_[block].column_offsets[column], SEEK_SET) != 0) return 4;
+
+    if (fread(values, 1, size, file_file_) != size) return 4;
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_col::
+read_covariance_values
+(int     block,
+ int*    n_covariance_values,
+ double* covariance_values)
+{
+  {
+    int n_columns;
+    int status;
+
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+    if (directory_[block].type != 'l')                    return 3;
+
+    // Counts and values are the last two columns of l-blocks.
+
+    n_columns = (int)directory_[block].column_sizes.size();
+
+    status = read_column(block, n_columns - 2, n_covariance_values);
+    if (status != 0) return status;
+
+    if (covariance_values == NULL) return 0;
+
+    return read_column(block, n_columns - 1, covariance_values);
+  }
+}
+
+int
+observation_file_reader_col::
+read_expectations
+(int     block,
+ int     expectation,
+ double* expectations)
+{
+  {
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+    if (directory_[block].type != 'l')                    return 3;
+
+    if ((expectation < 0) || (expectation >= directory_[block].dimensions[1])) return 3;
+
+    // Time, active flag and instance id, then the tags, then the expectations.
+
+    return read_column(block, 3 + directory_[block].dimensions[0] + expectation, expectations);
+  }
+}
+
+int
+observation_file_reader_col::
+read_instance_ids
+(int  block,
+ int* instance_ids)
+{
+  {
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+    if (directory_[block].type != 'l')                    return 3;
+
+    return read_column(block, 2, instance_ids);
+  }
+}
+
+int
+observation_file_reader_col::
+read_instrument_iids
+(int  block,
+ int  iid,
+ int* instrument_iids)
+{
+  {
+    block_entry* entry;
+
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+
+    entry = &directory_[block];
+
+    if (entry->type != 'o')                               return 3;
+    if ((iid < 0) || (iid >= entry->dimensions[2]))       return 3;
+
+    return read_column(block, 2 + entry->dimensions[0] + entry->dimensions[1] + iid, instrument_iids);
+  }
+}
+
+int
+observation_file_reader_col::
+read_observation_iids
+(int  block,
+ int  iid,
+ int* observation_iids)
+{
+  {
+    block_entry* entry;
+
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+
+    entry = &directory_[block];
+
+    if (entry->type != 'o')                               return 3;
+    if ((iid < 0) || (iid >= entry->dimensions[1]))       return 3;
+
+    return read_column(block, 2 + entry->dimensions[0] + iid, observation_iids);
+  }
+}
+
+int
+observation_file_reader_col::
+read_parameter_iids
+(int  block,
+ int  iid,
+ int* parameter_iids)
+{
+  {
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+    if (directory_[block].type != 'o')                    return 3;
+
+    if ((iid < 0) || (iid >= directory_[block].dimensions[0])) return 3;
+
+    return read_column(block, 2 + iid, parameter_iids);
+  }
+}
+
+int
+observation_file_reader_col::
+read_tags
+(int     block,
+ int     tag,
+ double* tags)
+{
+  {
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+    if (directory_[block].type != 'l')                    return 3;
+
+    if ((tag < 0) || (tag >= directory_[block].dimensions[0])) return 3;
+
+    return read_column(block, 3 + tag, tags);
+  }
+}
+
+int
+observation_file_reader_col::
+read_times
+(int     block,
+ double* times)
+{
+  {
+    if (!file_is_open_) return 1;
+    if ((block < 0) || (block >= (int)directory_.size())) return 2;
+
+    return read_column(block, 0, times);
+  }
+}
@@ -0,0 +1,469 @@
+/** \file observation_file_reader_col.hpp
+  \brief Class defining the interface of observation columnar file readers.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef OBSERVATION_FILE_READER_COL_HPP
+#define OBSERVATION_FILE_READER_COL_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "observation_file_writer_col.hpp"
+
+using namespace std;
+
+/**
+ * @brief Class defining the interface of observation columnar file readers.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * Columnar files (see observation_file_writer_col for a description of
+ * their layout) keep records grouped in blocks sharing type, identifier
+ * and dimensions, every field of the records in a block being stored as
+ * a contiguous column. This reader does not deliver records one by one,
+ * as the sequential readers do, but whole columns: applications select
+ * the blocks they are interested in (see find_blocks() or the get_block_
+ * methods) and then read (project) just the columns they need. Columns
+ * not requested are never read from disk.
+ *
+ * Blocks are numbered from 0 to get_n_blocks() - 1, in the order these
+ * were written. Within a block, records keep the order in which these
+ * were written, but blocks of different kinds of records are interleaved
+ * as these got full, so the original order of the records in the file
+ * may not be rebuilt exactly (the time tags, however, are kept).
+ *
+ * None of the get_block_ methods check the validity of the block
+ * number received; the read_ methods do.
+ */
+
+class observation_file_reader_col
+{
+  public:
+
+    /**
+     * @brief Closes the reader, disabling any other further action on it.
+     * @return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: Error closing the file.
+     */
+
+    int          close                          (void);
+
+    /**
+     * @brief Select the blocks holding records of a given kind in
+     *        a given time range.
+     *
+     * @param identifier Identifier of the records to look for. NULL
+     *        selects the blocks no matter their identifier.
+     * @param time_from Beginning of the time range.
+     * @param time_to End of the time range.
+     * @param blocks On output, the numbers of the blocks whose identifier
+     *        matches the one requested and whose time range overlaps
+     *        [time_from, time_to], in ascending order.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *
+     * Only the directory of the file, already in memory, is searched.
+     */
+
+    int          find_blocks                    (const char*  identifier,
+                                                 double       time_from,
+                                                 double       time_to,
+                                                 vector<int>& blocks);
+
+    /**
+     * @brief Retrieve the identifier of the records in a block.
+     * @param block The number of the block.
+     * @return The NULL terminated identifier of the records in the block.
+     */
+
+    const char*  get_block_identifier           (int block) const;
+
+    /**
+     * @brief Retrieve the total number of covariance values in an l-block.
+     * @param block The number of the block.
+     * @return The number of covariance values stored for all the records
+     *         in the block (0 for o-blocks). See read_covariance_values().
+     */
+
+    long long    get_block_n_covariance_values  (int block) const;
+
+    /**
+     * @brief Retrieve the number of expectations of the records in an l-block.
+     * @param block The number of the block.
+     * @return The number of expectations (0 for o-blocks).
+     */
+
+    int          get_block_n_expectations       (int block) const;
+
+    /**
+     * @brief Retrieve the number of instrument instance identifiers of the
+     *        records in an o-block.
+     * @param block The number of the block.
+     * @return The number of instrument instance identifiers (0 for l-blocks).
+     */
+
+    int          get_block_n_instrument_iids    (int block) const;
+
+    /**
+     * @brief Retrieve the number of observation instance identifiers of the
+     *        records in an o-block.
+     * @param block The number of the block.
+     * @return The number of observation instance identifiers (0 for l-blocks).
+     */
+
+    int          get_block_n_observation_iids   (int block) const;
+
+    /**
+     * @brief Retrieve the number of parameter instance identifiers of the
+     *        records in an o-block.
+     * @param block The number of the block.
+     * @return The number of parameter instance identifiers (0 for l-blocks).
+     */
+
+    int          get_block_n_parameter_iids     (int block) const;
+
+    /**
+     * @brief Retrieve the number of records in a block.
+     * @param block The number of the block.
+     * @return The number of records in the block, that is, the number of
+     *         elements of each of its columns.
+     */
+
+    int          get_block_n_records            (int block) const;
+
+    /**
+     * @brief Retrieve the number of tags of the records in an l-block.
+     * @param block The number of the block.
+     * @return The number of tags (0 for o-blocks).
+     */
+
+    int          get_block_n_tags               (int block) const;
+
+    /**
+     * @brief Retrieve the greatest time tag in a block.
+     * @param block The number of the block.
+     * @return The greatest time tag of the records in the block.
+     */
+
+    double       get_block_time_max             (int block) const;
+
+    /**
+     * @brief Retrieve the smallest time tag in a block.
+     * @param block The number of the block.
+     * @return The smallest time tag of the records in the block.
+     */
+
+    double       get_block_time_min             (int block) const;
+
+    /**
+     * @brief Retrieve the type of the records in a block.
+     * @param block The number of the block.
+     * @return 'l' or 'o'.
+     */
+
+    char         get_block_type                 (int block) const;
+
+    /**
+     * @brief Retrieve the number of blocks in the file.
+     * @return The number of blocks; 0 if the file is not open.
+     */
+
+    int          get_n_blocks                   (void) const;
+
+    /**
+     * @brief Check if the underlying data file has already been opened.
+     *
+     * @return True if the file has already been opened, false otherwise.
+     */
+
+    bool         is_open                        (void) const;
+
+    /**
+     * @brief Default constructor.
+     */
+
+                 observation_file_reader_col    (void);
+
+    /**
+     * @brief Destructor. Closes the file if still open.
+     */
+
+                 ~observation_file_reader_col   (void);
+
+    /**
+     * @brief Opens the reader, enabling I/O operations.
+     *
+     * @param file_name Name of the file to read.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file was already open.
+     *        - 2: Unable to open the selected file.
+     *        - 3: Not enough memory to allocate the internal structures.
+     *        - 4: Invalid file. Not a columnar file, or its directory
+     *             is corrupted.
+     *        - 5: I/O error detected while reading the file.
+     *
+     * Only the trailer and the directory of the file are read.
+     */
+
+    int          open                           (const char*  file_name);
+
+    /**
+     * @brief Read the active flags of the records in a block.
+     *
+     * @param block The number of the block.
+     * @param active_flags On output, get_block_n_records(block) flags
+     *        (1 active, 0 removed).
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: NOT USED.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_active_flags              (int          block,
+                                                 char*        active_flags);
+
+    /**
+     * @brief Read the covariance values of the records in an l-block.
+     *
+     * @param block The number of the block.
+     * @param n_covariance_values On output, get_block_n_records(block)
+     *        values, the number of covariance values of each record
+     *        (0, n or (n * (n + 1)) / 2, n being the number of expectations).
+     * @param covariance_values On output, the
+     *        get_block_n_covariance_values(block) covariance values of
+     *        all the records, one record after the other. May be NULL
+     *        if only the counts are needed.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: The block is not an l-block.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_covariance_values         (int          block,
+                                                 int*         n_covariance_values,
+                                                 double*      covariance_values);
+
+    /**
+     * @brief Read one of the expectation columns of an l-block.
+     *
+     * @param block The number of the block.
+     * @param expectation Which expectation to read (0 to
+     *        get_block_n_expectations(block) - 1).
+     * @param expectations On output, get_block_n_records(block) values.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: The block is not an l-block or the expectation is out of range.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_expectations              (int          block,
+                                                 int          expectation,
+                                                 double*      expectations);
+
+    /**
+     * @brief Read the instance identifiers of the records in an l-block.
+     *
+     * @param block The number of the block.
+     * @param instance_ids On output, get_block_n_records(block) values.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: The block is not an l-block.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_instance_ids              (int          block,
+                                                 int*         instance_ids);
+
+    /**
+     * @brief Read one of the instrument instance identifier columns of an o-block.
+     *
+     * @param block The number of the block.
+     * @param iid Which instrument instance identifier to read (0 to
+     *        get_block_n_instrument_iids(block) - 1).
+     * @param instrument_iids On output, get_block_n_records(block) values.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: The block is not an o-block or iid is out of range.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_instrument_iids           (int          block,
+                                                 int          iid,
+                                                 int*         instrument_iids);
+
+    /**
+     * @brief Read one of the observation instance identifier columns of an o-block.
+     *
+     * @param block The number of the block.
+     * @param iid Which observation instance identifier to read (0 to
+     *        get_block_n_observation_iids(block) - 1).
+     * @param observation_iids On output, get_block_n_records(block) values.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: The block is not an o-block or iid is out of range.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_observation_iids          (int          block,
+                                                 int          iid,
+                                                 int*         observation_iids);
+
+    /**
+     * @brief Read one of the parameter instance identifier columns of an o-block.
+     *
+     * @param block The number of the block.
+     * @param iid Which parameter instance identifier to read (0 to
+     *        get_block_n_parameter_iids(block) - 1).
+     * @param parameter_iids On output, get_block_n_records(block) values.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: The block is not an o-block or iid is out of range.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_parameter_iids            (int          block,
+                                                 int          iid,
+                                                 int*         parameter_iids);
+
+    /**
+     * @brief Read one of the tag columns of an l-block.
+     *
+     * @param block The number of the block.
+     * @param tag Which tag to read (0 to get_block_n_tags(block) - 1).
+     * @param tags On output, get_block_n_records(block) values.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: The block is not an l-block or the tag is out of range.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_tags                      (int          block,
+                                                 int          tag,
+                                                 double*      tags);
+
+    /**
+     * @brief Read the time tags of the records in a block.
+     *
+     * @param block The number of the block.
+     * @param times On output, get_block_n_records(block) values.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file has not been opened.
+     *        - 2: Invalid block number.
+     *        - 3: NOT USED.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_times                     (int          block,
+                                                 double*      times);
+
+  protected:
+
+    /**
+     * @brief Parse the directory of the file.
+     *
+     * @param directory The bytes making the directory.
+     * @param directory_size Number of bytes in the directory.
+     * @param n_blocks Number of blocks described in the directory.
+     * @param directory_offset Offset of the directory in the file; no
+     *        column may go beyond this point.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The directory is corrupted.
+     */
+
+    int          parse_directory                (const char*  directory,
+                                                 long long    directory_size,
+                                                 int          n_blocks,
+                                                 long long    directory_offset);
+
+    /**
+     * @brief Read a whole column of a block.
+     *
+     * @param block The number of the block (already checked).
+     * @param column The number of the column in the block (already checked).
+     * @param values On output, the contents of the column.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 4: I/O error detected while reading the file.
+     */
+
+    int          read_column                    (int          block,
+                                                 int          column,
+                                                 void*        values);
+
+  protected:
+
+    /// @brief Directory entry describing a block.
+
+    struct block_entry
+    {
+      /// @brief Offset in the file of each of the columns in the block.
+
+      vector<long long>      column_offsets;
+
+      /// @brief Size in bytes of each of the columns in the block.
+
+      vector<long long>      column_sizes;
+
+      /// @brief Dimensions of the records in the block (tags and
+      /// expectations or parameter, observation and instrument iids).
+
+      int                    dimensions[3];
+
+      /// @brief Identifier of the records in the block.
+
+      string                 identifier;
+
+      /// @brief Number of records in the block.
+
+      int                    n_records;
+
+      /// @brief Maximum time tag in the block.
+
+      double                 time_max;
+
+      /// @brief Minimum time tag in the block.
+
+      double                 time_min;
+
+      /// @brief Type of the records in the block ('l' or 'o').
+
+      char                   type;
+    };
+
+    /// @brief The blocks in the file.
+
+    vector<block_entry>  directory_;
+
+    /// @brief The file handled by the reader.
+
+    FILE*                file_file_;
+
+    /// @brief Flag. True when the file is open.
+
+    bool                 file_is_open_;
+};
+
+#endif // OBSERVATION_FILE_READER_COL_HPP
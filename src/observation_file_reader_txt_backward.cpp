@@ -4,6 +4,15 @@
 */ 
 #include "observation_file_reader_txt_backward.hpp"
 
+//
+// Memory mapped files are available only on POSIX systems.
+//
+
+#ifndef _WIN32
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif // _WIN32
+
 observation_file_reader_txt_backward::
 observation_file_reader_txt_backward
 (void)
@@ -15,6 +24,13 @@ observation_file_reader_txt_backward
     epoch_remaining_records_   =  0;
     epoch_end_                 = -1;
     file_bytes_unread_         =  0;
+
+    map_base_                  = NULL;
+    map_buffer_size_           =  0;
+    map_length_                =  0;
+    map_window_size_           =  0;
+    file_is_mapped_            = false;
+    memory_mapped_             = false;
   }
 }
 
@@ -23,7 +39,48 @@ observation_file_reader_txt_backward::
 (void)
 {
   {
-    // INTENTIONALLY LEFT BLANK.
+    //
+    // When memory mapped, the data buffer points to the mapped file and
+    // must not be deleted by the parent's destructor. Closing the file
+    // unmaps it and resets the data buffer.
+    //
+
+    if (file_is_mapped_) close();
+  }
+}
+
+int
+observation_file_reader_txt_backward::
+close
+(void)
+{
+  {
+    // Do not complain if the file is already closed.
+
+    if (!file_is_open_) return 0;
+
+    //
+    // If memory mapped, unmap the file. The data buffer is set to NULL so
+    // the parent class does not try to delete it, and its size is restored
+    // to the one requested before opening the file.
+    //
+
+    #ifndef _WIN32
+    if (file_is_mapped_)
+    {
+      if (map_base_ != NULL) munmap((void*)map_base_, map_length_);
+
+      map_base_         = NULL;
+      map_length_       = 0;
+      data_buffer_      = NULL;
+      data_buffer_size_ = map_buffer_size_;
+      file_is_mapped_   = false;
+    }
+    #endif // _WIN32
+
+    // Close the file.
+
+    return obs_e_based_file_reader_txt::close();
   }
 }
 
@@ -650,19 +707,12 @@ find_record_bwd
 
     //
     // Look for the first opening '<' backwards, since we are trying to find a
-    // closing record tag, either l- or o-.
+    // closing record tag, either l- or o-. The search is made several bytes
+    // at a time; index becomes chunk_start_index_ - 1 if there is no '<'.
     //
 
-    index--;
-
-    while (index >= chunk_start_index_)
-    {
-      chr = data_buffer_[index];
-
-      if (chr == '<') break;
-
-      index--;
-    }
+    index = chunk_start_index_ +
+            delimiters_.find_last(&(data_buffer_[chunk_start_index_]), index - chunk_start_index_, '<');
 
     if (index < chunk_start_index_) return 1;
 
@@ -731,19 +781,12 @@ find_record_bwd
 
     //
     // Look for the next opening '<' backwards. Presumably, it will belong to
-    // the opening tag and will mark the beginning of the record.
+    // the opening tag and will mark the beginning of the record. Again,
+    // several bytes are searched at a time.
     //
 
-    index--;
-
-    while (index >= chunk_start_index_)
-    {
-      chr = data_buffer_[index];
-
-      if (chr == '<') break;
-
-      index--;
-    }
+    index = chunk_start_index_ +
+            delimiters_.find_last(&(data_buffer_[chunk_start_index_]), index - chunk_start_index_, '<');
 
     if (index < chunk_start_index_) return 2; // Malformed record found.
 
@@ -825,15 +868,16 @@ find_record_fwd
 (int from,  int& start, int& end, char& type)
 {
   {
-    char chr;
-    int  i;
-    int  index;
-    int  j;
-    int  k;
-    int  opening_tag_end;
-    int  text_size;
-    char type_closing;
-    char type_opening;
+    char        chr;
+    const char* found;
+    int         i;
+    int         index;
+    int         j;
+    int         k;
+    int         opening_tag_end;
+    int         text_size;
+    char        type_closing;
+    char        type_opening;
 
     if (from >= data_buffer_size_) return 1; // Reached the end of the buffer.
 
@@ -924,36 +968,23 @@ find_record_fwd
 
     index++;
 
-    while (index < data_buffer_size_)
-    {
-      chr = data_buffer_[index];
-
-      if (chr == '>') break;
+    found = (const char*)memchr(&(data_buffer_[index]), '>', data_buffer_size_ - index);
 
-      index++;
-    }
-
-    if (index >= data_buffer_size_) return 1;
+    if (found == NULL) return 1;
 
     // index points now to the end of the record.
 
-    end = index;
+    index = (int)(found - data_buffer_);
+    end   = index;
 
     //
     // Now, we'll try to find the first opening '<' backwards, which, presumably,
-    // will be part of the closing tag.
+    // will be part of the closing tag. k becomes opening_tag_end if there
+    // is none.
     //
 
-    k = end - 1;
-
-    while (k > opening_tag_end)
-    {
-      chr = data_buffer_[k];
-
-      if (chr == '<') break;
-
-      k--;
-    }
+    k = opening_tag_end + 1 +
+        delimiters_.find_last(&(data_buffer_[opening_tag_end + 1]), end - opening_tag_end - 1, '<');
 
     if (k <= opening_tag_end) return 2; // Malformed record found.
 
@@ -1039,14 +1070,11 @@ find_timetag
  double& timetag)
 {
   {
-    char   chr;
-    void*  destination;
-    int    index;
-    void*  source;
-    int    timetag_first;
-    int    timetag_last;
-    int    timetag_size;
-    double timetag_value;
+    char        chr;
+    int         index;
+    const char* timetag_first;
+    const char* timetag_last;
+    double      timetag_value;
 
     index = record_start;
 
@@ -1087,61 +1115,124 @@ find_timetag
 
     chr = data_buffer_[index];
 
+    //
     // At this moment, index points to the first character in the time tag.
+    // Convert it in place, directly from the data buffer. The time tag must
+    // be followed by whitespace.
+    //
 
-    timetag_first = index;
+    timetag_first = &(data_buffer_[index]);
+    timetag_last  = &(data_buffer_[record_end + 1]);
 
-    // Look now for the last position.
+    if (astr_parse_double(timetag_first, timetag_last, timetag_value, &timetag_last) != 0)
+    {
+      // The text read does not represent a legal double value!!!
+      return 1;
+    }
 
-    index++;
+    index += (int)(timetag_last - timetag_first);
     if (index > record_end) return 1;
 
-    chr = data_buffer_[index];
+    if (!is_whitespace(data_buffer_[index])) return 1;
 
-    while (!is_whitespace(chr))
-    {
-      index++;
-      if (index > record_end) return 1;
+    // We've got it!
 
-      chr = data_buffer_[index];
-    }
+    timetag = timetag_value;
 
-    timetag_last = index;
-    timetag_size = timetag_last - timetag_first + 1;
+    // That's all!
 
-    //
-    // The string representing the time tag is in positions time_tag_first to
-    // time_tag_last in the internal data buffer. Now it is time to convert
-    // this string to binary form. We'll use the text buffer provided by
-    // our parent class to perform this conversion.
-    //
+    return 0;
 
-    guarantee_text_buffer_size(timetag_size + 1); // Includes final NULL.
+  }
+}
 
-    // Copy the text in the data buffer (source) to our local copy (destination).
+bool
+observation_file_reader_txt_backward::
+is_memory_mapped
+(void)
+const
+{
+  {
+    return file_is_open_ ? file_is_mapped_ : memory_mapped_;
+  }
+}
 
-    source      = (void*)&(data_buffer_[timetag_first]);
-    destination = (void*)text_buffer_;
+int
+observation_file_reader_txt_backward::
+map_file
+(void)
+{
+  {
+    #ifndef _WIN32
 
-    memcpy(destination, source, (size_t)timetag_size);
-    text_buffer_[timetag_size] = 0; // Ending NULL character.
+    void* new_base;
 
-    // Try to convert the text just obtained to a binary double value.
+    // The whole file must fit in the address space.
 
-    if (sscanf(text_buffer_, "%lf", &timetag_value) == EOF)
-    {
-      // The text read does not represent a legal double value!!!
-      return 1;
-    }
+    if ((long long)(size_t)file_size_ != file_size_) return 1;
 
-    // We've got it!
+    new_base = mmap(NULL, (size_t)file_size_, PROT_READ, MAP_PRIVATE, fileno(file_file_), 0);
 
-    timetag = timetag_value;
+    if (new_base == MAP_FAILED) return 1;
 
-    // That's all!
+    map_base_   = (char*)new_base;
+    map_length_ = (size_t)file_size_;
+
+    // That's all.
 
     return 0;
 
+    #else
+
+    // Memory mapped files not available on this platform.
+
+    return 1;
+
+    #endif // _WIN32
+  }
+}
+
+int
+observation_file_reader_txt_backward::
+map_prev_chunk
+(void)
+{
+  {
+    int       bytes_to_map;
+
+    #ifndef _WIN32
+    long long hint_start;
+    #endif // _WIN32
+
+    //
+    // The window ends where the data already processed starts, and is as
+    // big as possible (but no more than map_window_size_ bytes).
+    //
+
+    bytes_to_map = map_window_size_;
+    if (bytes_to_map > file_bytes_unread_) bytes_to_map = (int)file_bytes_unread_;
+
+    data_buffer_      = map_base_ + (file_bytes_unread_ - bytes_to_map);
+    data_buffer_size_ = bytes_to_map;
+
+    //
+    // Ask the system to load this window and the reverse window preceding
+    // it, since its own read-ahead policy is of no use when reading
+    // backwards. This is just a hint, so errors are ignored. Addresses
+    // must be page aligned.
+    //
+
+    #ifndef _WIN32
+    hint_start = file_bytes_unread_ - bytes_to_map - reverse_window_size_;
+    if (hint_start < 0) hint_start = 0;
+    hint_start -= hint_start % (long long)sysconf(_SC_PAGESIZE);
+
+    madvise((void*)(map_base_ + hint_start), (size_t)(file_bytes_unread_ - hint_start), MADV_WILLNEED);
+    #endif // _WIN32
+
+    // That's all.
+
+    return bytes_to_map;
   }
 }
 
@@ -1167,58 +1258,98 @@ open
 
     // Ascertain how big is the file.
 
-    if (fseek(file_file_, 0 , SEEK_END) != 0)
+    if (astr_fseek(file_file_, 0 , SEEK_END) != 0)
     {
       return 5; // I/O error.
     }
 
-    file_size_         = ftell(file_file_);
+    file_size_         = astr_ftell(file_file_);
     file_bytes_unread_ = file_size_;
 
-    // Try to create the buffer used for buffered reads.
+    //
+    // Memory mapped mode. Map the whole file; read_prev_chunk() will walk
+    // its windows from the last one to the first one. Should the file be
+    // impossible to map (or too big for the address space), we'll revert
+    // to buffered reads.
+    //
 
-    try
-    {
-      //
-      // Instantiate a data buffer with the proper size. If the size of the
-      // file is smaller than the maximum authorized size, then data_buffer_size_
-      // will be readjusted to use less memory. Otherwise, the requested
-      // data buffer size will be preserved.
-      //
-      // If everything works, the file is reported as open.
-      //
+    file_is_mapped_ = memory_mapped_;
 
-      if (file_size_ < data_buffer_size_) data_buffer_size_ = file_size_;
+    if (file_is_mapped_)
+    {
+      map_buffer_size_ = data_buffer_size_;
+      map_window_size_ = _ASTROLABE_OBS_E_FILE_READER_DEFAULT_MAP_WINDOW_SIZE;
+      if (data_buffer_size_ > map_window_size_) map_window_size_ = data_buffer_size_;
 
-      data_buffer_ = new char[data_buffer_size_];
       file_is_open_ = true;
+
+      // Empty files can't be mapped, and must be reported as such.
+
+      if (file_size_ == 0) return 4;
+
+      if (map_file() != 0)
+      {
+        // Unable to map the file. Revert to buffered reads.
+
+        file_is_open_   = false;
+        file_is_mapped_ = false;
+      }
     }
-    catch (...)
+
+    if (!file_is_mapped_)
     {
+      // Try to create the buffer used for buffered reads.
+
+      try
+      {
+        //
+        // Instantiate a data buffer with the proper size. If the size of the
+        // file is smaller than the maximum authorized size, then data_buffer_size_
+        // will be readjusted to use less memory. Otherwise, the requested
+        // data buffer size will be preserved.
+        //
+        // If everything works, the file is reported as open.
+        //
+
+        if (file_size_ < data_buffer_size_) data_buffer_size_ = (int)file_size_;
+
+        data_buffer_ = new char[data_buffer_size_];
+        file_is_open_ = true;
+      }
+      catch (...)
+      {
+        //
+        // If there's not enough memory, close again the file, flag it
+        // as not open and return the error code.
+        //
+
+        close();
+        file_is_open_ = false;
+        return 3;
+      }
+
       //
-      // If there's not enough memory, close again the file, flag it
-      // as not open and return the error code.
+      // Chunks are read through read_ahead_, in a helper thread if so
+      // requested. Should the thread be impossible to start, chunks will
+      // be read when needed, so the error code is ignored. The system is
+      // asked to load in advance the region preceding every chunk, since
+      // its own read-ahead policy is of no use when reading backwards.
       //
 
-      close();
-      file_is_open_ = false;
-      return 3;
+      read_ahead_.attach(file_file_, file_size_);
+      read_ahead_.set_reverse_window(reverse_window_size_);
+      if (prefetch_is_enabled_) read_ahead_.start(data_buffer_size_, true);
     }
 
     //
     // Read as much bytes as possible (maximum: data_buffer_size_)
-    // from the underlying binary file.
-    //
-    // Since this is the first read operation, we must guarantee that
-    // the fseek pointer indicates the end of the file.
+    // from the underlying binary file, starting at its end.
     //
     // Note that read_prev_chunk() tries to find the first complete epoch
     // in the information read. This may lead to errors 3 and 4 in the
     // list below.
     //
 
-    fseek(file_file_, 0, SEEK_END);
-
     read_status = read_prev_chunk();
 
     // Check errors.
@@ -1364,17 +1495,17 @@ read_prev_chunk
 (void)
 {
   {
-    long   bytes_read;
-    long   bytes_to_read;
-    char   chr;
-    bool   done;
-    int    i;
-    int    offset;
-    int    new_offset;
-    int    record_end;
-    int    record_start;
-    int    status;
-    char   type;
+    int       bytes_read;
+    int       bytes_to_read;
+    char      chr;
+    bool      done;
+    int       i;
+    int       offset;
+    int       new_offset;
+    int       record_end;
+    int       record_start;
+    int       status;
+    char      type;
 
     // Check that the file is open!
 
@@ -1393,48 +1524,65 @@ read_prev_chunk
         return 1;
       }
 
-      // Ascertain how many bytes may be read at once.
-
-      bytes_to_read = data_buffer_size_;
-      if (bytes_to_read > file_bytes_unread_) bytes_to_read = file_bytes_unread_;
-
-      if (bytes_to_read == 0)
+      if (file_is_mapped_)
       {
-        is_eof_ = true;
-        return 1;
-      }
+        //
+        // Memory mapped mode. Nothing is read: the data buffer becomes the
+        // window of the mapped file preceding the data block that has
+        // already been processed. Thus, there are no unused bytes at its
+        // beginning.
+        //
 
-      //
-      // Compute the number of bytes that won't be used in the data buffer. This
-      // amount will be used as an offset to put data in this buffer.
-      //
+        bytes_to_read = map_prev_chunk();
+        bytes_read    = bytes_to_read;
+        offset        = 0;
+      }
+      else
+      {
+        // Ascertain how many bytes may be read at once.
 
-      offset = data_buffer_size_ - (int)bytes_to_read;
+        bytes_to_read = data_buffer_size_;
+        if (bytes_to_read > file_bytes_unread_) bytes_to_read = (int)file_bytes_unread_;
 
-      //
-      // Move the current position in the file bytes_to_read bytes backwards to
-      // be able to read forward later on. Note that we ASSUME that the file
-      // is positioned ("fseek-ed") at the beginning of the data block that
-      // has already been processed, starting with an 'l' tag (or just at
-      // the end of the file when no data has been read yet).
-      //
+        if (bytes_to_read == 0)
+        {
+          is_eof_ = true;
+          return 1;
+        }
 
-      fseek(file_file_, -bytes_to_read, SEEK_CUR);
+        //
+        // Compute the number of bytes that won't be used in the data buffer. This
+        // amount will be used as an offset to put data in this buffer.
+        //
 
-      // Read bytes_to_read bytes.
+        offset = data_buffer_size_ - (int)bytes_to_read;
 
-      bytes_read = (int)fread((void*)&(data_buffer_[offset]), 1, bytes_to_read, file_file_);
-      if (bytes_read != bytes_to_read)
-      {
         //
-        // This should never happen; we never ask for more data that is stored
-        // in the file, since we always know how much information is left there.
-        //
-        // Therefore, ff the number of bytes read do not match with the total
-        // of bytes to read, this means that some kind of I/O error has arised.
+        // Read the bytes_to_read bytes preceding the data block that has
+        // already been processed, starting with an 'l' tag (or the last
+        // bytes_to_read bytes in the file when no data has been read yet).
         //
 
-        return 2;
+        // A full chunk is taken without copying it when read in advance.
+
+        if (offset == 0)
+          bytes_read = (int)read_ahead_.read_block(file_bytes_unread_ - bytes_to_read,
+                                                   data_buffer_, bytes_to_read);
+        else
+          bytes_read = (int)read_ahead_.read(file_bytes_unread_ - bytes_to_read,
+                                             (void*)&(data_buffer_[offset]), bytes_to_read);
+        if (bytes_read != bytes_to_read)
+        {
+          //
+          // This should never happen; we never ask for more data that is stored
+          // in the file, since we always know how much information is left there.
+          //
+          // Therefore, ff the number of bytes read do not match with the total
+          // of bytes to read, this means that some kind of I/O error has arised.
+          //
+
+          return 2;
+        }
       }
 
       //
@@ -1578,13 +1726,12 @@ read_prev_chunk
       file_bytes_unread_ -= bytes_read;
 
       //
-      // We must update the fseek position, so the next time this method
-      // is invoked the fseek pointer points to the beginning of the
-      // buffer we've just read. Now, it is pointing to its END, so we
-      // must fseek -bytes_read backward.
+      // Ask the helper thread, if any, to read the chunk that the next call
+      // will request: the data_buffer_size_ bytes preceding those already
+      // processed (or all of them, if fewer). read_block() takes it then.
       //
 
-      fseek(file_file_, -bytes_read, SEEK_CUR);
+      if (!file_is_mapped_) read_ahead_.schedule(file_bytes_unread_ - data_buffer_size_, (size_t)data_buffer_size_);
 
       //
       // Now we know that we have an integral set of epochs starting at
@@ -1760,7 +1907,7 @@ read_type
     int         att_search_start;
     string      att_value;
     const char* cchr;
-    int         i;
+    const char* cchr_end;
     int         instance_id;
     int         len;
     int         status;
@@ -2041,9 +2188,8 @@ read_type
       len  = (int)att_value.size();
       cchr = att_value.c_str();
   
-      if ((cchr[0] != '-') & (cchr[0]!= '+') & ((cchr[0] < '0') || (cchr[0] > '9'))) return 4;
-      for (i = 1; i < len; i++) if (cchr[i] < '0' || cchr[i] > '9') return 4;
-      if(sscanf(cchr, "%d", &instance_id)  == EOF ) return 4;
+      if (astr_parse_int(cchr, cchr + len, instance_id, &cchr_end) != 0) return 4;
+      if (cchr_end != (cchr + len)) return 4;
 
       // Update last record read information.
 
@@ -2067,3 +2213,75 @@ read_type
     return 0;
   }
 }
+
+int
+observation_file_reader_txt_backward::
+seek_epoch_boundary
+(long long offset)
+{
+  {
+    int read_status;
+
+    // Check that the file is open!
+
+    if (!file_is_open_) return 3;
+
+    // The offset must lie inside the file.
+
+    if ((offset < 0) || (offset > file_size_)) return 1;
+
+    // The reader behaves now as if the file had just been open.
+
+    reset_read_state();
+
+    //
+    // Leave the data buffer empty, so if nothing is left to read (offset 0)
+    // the next read operation detects the beginning-of-file condition.
+    //
+
+    chunk_start_index_       =  0;
+    data_buffer_current_     = -1;
+    epoch_remaining_records_ =  0;
+
+    //
+    // Everything before offset is still to be read (see read_prev_chunk()).
+    // Load the data buffer.
+    //
+
+    file_bytes_unread_ = offset;
+
+    read_status = read_prev_chunk();
+
+    if ((read_status != 0) && (read_status != 1)) return 2;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_reader_txt_backward::
+set_memory_mapped
+(bool memory_mapped)
+{
+  {
+    // If the file is already open, it's not legal to change the I/O model.
+
+    if (file_is_open_) return 1;
+
+    // Memory mapped files are available only on POSIX systems.
+
+    #ifdef _WIN32
+    if (memory_mapped) return 2;
+    #endif // _WIN32
+
+    // Set the new I/O model.
+
+    memory_mapped_ = memory_mapped;
+
+    // Bye.
+
+    return 0;
+  }
+}
@@ -7,6 +7,7 @@
 #define OBSERVATION_FILE_READER_TXT_BACKWARD_HPP
 
 #include "obs_e_based_file_reader_txt.hpp"
+#include "astrolabe_text_scanner.hpp"
 
 /**
  * @brief Class defining the interface of backwards observation text file readers.
@@ -35,6 +36,20 @@
  * Note that an epoch is a set of records (either l- or o-) that have
  * exactly the same time tag.
  *
+ * Two different I/O models are available. By default, chunks of the file
+ * are copied (read) to the internal data buffer, from the end of the file
+ * to its beginning. Optionally (see set_memory_mapped()) the whole file may
+ * be memory mapped instead; in this case, the data buffer is not allocated
+ * at all but points to the mapped pages, one window at a time, so records
+ * are located and parsed in place, with no intermediate copies. In both
+ * cases, the beginning of the records preceding a given position is found
+ * searching the buffer backwards several bytes at a time (see
+ * astrolabe_text_scanner::find_last()).
+ *
+ * The error codes and epoch semantics are the same no matter the
+ * I/O model in use.
+ *
+ * Memory mapped mode is only available on POSIX systems.
  */
 
 class observation_file_reader_txt_backward : public obs_e_based_file_reader_txt
@@ -52,6 +67,32 @@ class observation_file_reader_txt_backward : public obs_e_based_file_reader_txt
      */
                  ~observation_file_reader_txt_backward (void);
 
+    /**
+     * @brief Closes the file reader, disabling any other
+     *        further action on it.
+     * @return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: Error closing the file.
+     *
+     * When working in memory mapped mode, the file is unmapped before
+     * closing it.
+     */
+
+    virtual int  close                                 (void);
+
+    /**
+     * @brief Check if the reader is using the memory mapped I/O model.
+     *
+     * @return True if the file is (or will be, once opened) read
+     *         through a memory map, false otherwise.
+     *
+     * Note that open() will revert to the regular, buffered I/O model
+     * when the file can not be mapped; this method reports the I/O
+     * model actually in use after open() has been called.
+     */
+
+    virtual bool is_memory_mapped                      (void) const;
+
     /**
      * @brief Opens the reader, enabling I/O operations.
      *
@@ -241,6 +282,55 @@ class observation_file_reader_txt_backward : public obs_e_based_file_reader_txt
 
     virtual int  read_type                             (char& record_type);
 
+    /**
+     * @brief Position the reader at the end of an epoch.
+     *
+     * @param offset Offset in bytes of the byte following the last record
+     *        of the epoch (that is, the offset of the first record of the
+     *        next epoch or the size of the file).
+     * @return Error code. See obs_e_based_file_reader::seek_epoch_boundary().
+     *
+     * The next record read will be the last one of the epoch. Seeking to
+     * the beginning of the file is legal; the next read will report a
+     * beginning-of-file condition.
+     */
+
+    virtual int  seek_epoch_boundary                   (long long offset);
+
+    /**
+     * @brief Select the I/O model used to read the file.
+     *
+     * @param memory_mapped True to map the file in memory, false to use
+     *        buffered reads (the default).
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file is already open and therefore it is not
+     *             possible to change the I/O model.
+     *        - 2: Memory mapped files are not available on this platform.
+     *
+     * By default, chunks of the file are read, starting at its end, into
+     * an internal data buffer. This method makes it possible to map the
+     * whole file in memory instead, locating and parsing the records
+     * straight from the mapped pages. This avoids the seek and copy of
+     * every chunk and is specially convenient when dealing with very big
+     * files.
+     *
+     * The mapped file is processed in windows whose size is the biggest
+     * of the buffer size (see set_buffer_size()) and
+     * _ASTROLABE_OBS_E_FILE_READER_DEFAULT_MAP_WINDOW_SIZE. Epochs must
+     * fit in a window, as these must fit in the data buffer in buffered
+     * mode. The system is asked to load the reverse window (see
+     * set_reverse_window()) preceding the window being processed.
+     *
+     * If, once open() is called, the file can not be mapped, the reader
+     * reverts silently to the buffered I/O model.
+     *
+     * This method may be called only after the reader object has been
+     * instantiated and before open() has been invoked.
+     */
+
+    virtual int  set_memory_mapped                     (bool memory_mapped);
+
   protected:
 
    /**
@@ -401,6 +491,28 @@ class observation_file_reader_txt_backward : public obs_e_based_file_reader_txt
                                                         int     record_start, int record_end,
                                                         double& timetag);
 
+    /**
+     * @brief Map the whole input file in memory (memory mapped mode only).
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: Unable to map the file.
+     */
+
+    int          map_file                              (void);
+
+    /**
+     * @brief Make the data buffer point to the window of the mapped file
+     *        preceding the data already processed (memory mapped mode only).
+     * @return The size of the window, that is, the new value of
+     *         data_buffer_size_. It is never bigger than map_window_size_.
+     *
+     * The window ends at the first byte already processed (see
+     * file_bytes_unread_), which must not be zero. The system is asked to
+     * load this window and the reverse window preceding it.
+     */
+
+    int          map_prev_chunk                        (void);
+
     /**
      * @brief Read as many bytes as possible from the input file to fill the
      *        data buffer. The read process is performed in backwards direction.
@@ -438,6 +550,11 @@ class observation_file_reader_txt_backward : public obs_e_based_file_reader_txt
      *
      * Remember: the data already stored in positions 0..start_at of the buffer
      * is left undisturbed.
+     *
+     * When working in memory mapped mode, nothing is read: the data buffer
+     * is made to point to the window of the mapped file preceding the bytes
+     * already processed (and data_buffer_size_ is set to the size of
+     * such window).
      */
 
     int          read_prev_chunk                       (void);
@@ -456,6 +573,11 @@ class observation_file_reader_txt_backward : public obs_e_based_file_reader_txt
 
     int          data_buffer_current_;
 
+    /// @brief Searches the data buffer backwards, looking for the beginning
+    /// of records.
+
+    astrolabe_text_scanner delimiters_;
+
     /// @brief Position in the data buffer where the epoch being processed
     /// ends.
 
@@ -473,7 +595,35 @@ class observation_file_reader_txt_backward : public obs_e_based_file_reader_txt
 
     /// @brief Number of bytes in the input file that have not been read yet.
 
-    int          file_bytes_unread_;
+    long long    file_bytes_unread_;
+
+    /// @brief Flag. True when the file open is actually read through a
+    /// memory map, that is, when requested and open() managed to map it.
+
+    bool         file_is_mapped_;
+
+    /// @brief Start address of the mapped file (memory mapped mode only).
+
+    char*        map_base_;
+
+    /// @brief Size of the data buffer requested before opening the file,
+    /// restored when it is closed (memory mapped mode only).
+
+    int          map_buffer_size_;
+
+    /// @brief Size in bytes of the mapped file (memory mapped mode only).
+
+    size_t       map_length_;
+
+    /// @brief Maximum size in bytes of the windows of the mapped file
+    /// processed at a time (memory mapped mode only).
+
+    int          map_window_size_;
+
+    /// @brief Flag. When true, the file is read through a memory map
+    /// instead of using the data buffer, if possible (see set_memory_mapped()).
+
+    bool         memory_mapped_;
 };
 
 #endif // OBSERVATION_FILE_READER_TXT_BACKWARD_HPP
@@ -263,7 +263,7 @@ read_type
     int         att_search_start;
     string      att_value;
     const char* cchr;
-    int         i;
+    const char* cchr_end;
     int         instance_id;
     int         len;
     int         status;
@@ -543,9 +543,8 @@ read_type
       len  = (int)att_value.size();
       cchr = att_value.c_str();
   
-      if ((cchr[0] != '-') & (cchr[0]!= '+') & ((cchr[0] < '0') || (cchr[0] > '9'))) return 4;
-      for (i = 1; i < len; i++) if (cchr[i] < '0' || cchr[i] > '9') return 4;
-      if(sscanf(cchr, "%d", &instance_id)  == EOF ) return 4;
+      if (astr_parse_int(cchr, cchr + len, instance_id, &cchr_end) != 0) return 4;
+      if (cchr_end != (cchr + len)) return 4;
 
       // Update last record read information.
 
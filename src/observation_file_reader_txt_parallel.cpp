@@ -0,0 +1,25 @@
+/** \file observation_file_reader_txt_parallel.cpp
+  \brief Implementation file for observation_file_reader_txt_parallel.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+#include "observation_file_reader_txt_parallel.hpp"
+
+observation_file_reader_txt_parallel::
+observation_file_reader_txt_parallel
+(void)
+{
+  {
+    // Observation files hold both l- and o-records.
+
+    o_records_allowed_ = true;
+  }
+}
+
+observation_file_reader_txt_parallel::
+~observation_file_reader_txt_parallel
+(void)
+{
+  {
+    // INTENTIONALLY LEFT BLANK.
+  }
+}
@@ -0,0 +1,39 @@
+/** \file observation_file_reader_txt_parallel.hpp
+  \brief Class defining the interface of multithreaded text observation file readers.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef OBSERVATION_FILE_READER_TXT_PARALLEL_HPP
+#define OBSERVATION_FILE_READER_TXT_PARALLEL_HPP
+
+#include "obs_e_based_file_reader_txt_parallel.hpp"
+
+/**
+ * @brief Class defining the interface of multithreaded text observation file readers.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * This class implements the interface defined in parent class
+ * obs_e_based_file_reader_txt_parallel, reading observation files stored in
+ * text format in forward direction, as observation_file_reader_txt_forward
+ * does, but parsing the file with a pool of worker threads.
+ */
+
+class observation_file_reader_txt_parallel : public obs_e_based_file_reader_txt_parallel
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                 observation_file_reader_txt_parallel  (void);
+
+    /**
+     * @brief Destructor.
+     */
+
+                 ~observation_file_reader_txt_parallel (void);
+};
+
+#endif // OBSERVATION_FILE_READER_TXT_PARALLEL_HPP
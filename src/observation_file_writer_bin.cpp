@@ -25,265 +25,359 @@ observation_file_writer_bin::
 
 int
 observation_file_writer_bin::
-write_o
-(bool         active,
- char*        identifier,
- double       time,
- int          n_parameter_iids,
- int*         the_parameter_iids,
- int          n_observation_iids,
- int*         the_observation_iids,
- int          n_instrument_iids,
- int*         the_instrument_iids)
+o_record_size
+(int size_identifier,
+ int n_iidentifiers)
+const
+{
+  {
+    return   sizeof(char)                        // type
+           + sizeof(char)                        // active flag
+           + sizeof(int)                         // length in chars of the identifier
+           + sizeof(char) * size_identifier      // identifier
+           + sizeof(double)                      // time tag
+           + sizeof(int) * 3                     // The number of parameter, observation
+                                                 // and instrument instance identifiers
+           + sizeof(int) * n_iidentifiers;       // The whole set of instance identifiers
+  }
+}
+
+int
+observation_file_writer_bin::
+store_o_record
+(bool          active,
+ const char*   identifier,
+ int           size_identifier,
+ double        time,
+ int           n_parameter_iids,
+ const int*    the_parameter_iids,
+ int           n_observation_iids,
+ const int*    the_observation_iids,
+ int           n_instrument_iids,
+ const int*    the_instrument_iids)
 {
   {
-    char  cactive;
-    int   i;
-    int   n_iidentifiers;
     char* pchar;
-    int   size_b_record;
-    int   size_identifier;
-    int   size_o_record;
-    int   size_total;
-    int   status;
-    bool  write_backtrack_info;
 
-    // Won't work if the file is closed.
+    if (time != last_time_tag_)
+    {
+      // We must dump last sub-block backtracking data.
 
-    if (!file_is_open_) return 1;
+      if (store_backtrack_record() != 0) return 2;
 
-    // identifier must be at least 1 chars long excluding the terminating NULL char.
+      // We've got a new last_time_tag_ to compare to.
 
-    if (identifier == NULL) return 4;
+      last_time_tag_ = time;
 
-    size_identifier = (int)strlen(identifier);
+      //
+      // A new epoch starts here (an illegal one, since it starts with an
+      // o-record, but readers will detect and report it). Register it in
+      // the time index, if enabled.
+      //
 
-    if (size_identifier < 1) return 4;
+      if (index_epoch(time) != 0) return 2;
+    }
 
     //
-    // Won't work neither if no l-records have been written yet for the
-    // current time tag.
+    // Copy to the data buffer the required info. Note that the buffer may
+    // have been replaced while registering the epoch (see flush()).
     //
 
-    if (!first_l_written_) return 3;
+    pchar = &(data_buffer_[data_buffer_cur_]);
 
-    //
-    // We'll still refuse to do anything if the number of identifier does not
-    // match with what we're expecting.
-    //
+    // o-tag and active flag.
 
-    if (n_parameter_iids   <= 0) return 7;
-    if (n_observation_iids <= 0) return 7;
-    if (n_instrument_iids  <  0) return 7;
+    *pchar++ = 'o';
+    *pchar++ = active ? 1 : 0;
 
     //
-    // Compute the size needed to store the current o record in the buffer.
-    // We'll take into account the backtracking tags only when a sub-block
-    // (set of records with the same time tag) has just finished.
+    // Length of the identifier and the identifier itself (variable length,
+    // that's why we wrote its length before).
     //
 
-    size_b_record = 0; // No backtracking info until detected as needed.
+    memcpy(pchar, &size_identifier, sizeof(int));
+    pchar += sizeof(int);
 
-    n_iidentifiers = n_parameter_iids + n_observation_iids + n_instrument_iids;
+    memcpy(pchar, identifier, (size_t)size_identifier);
+    pchar += size_identifier;
 
-    size_o_record =   sizeof(char)                        // type
-                    + sizeof(char)                        // active flag
-                    + sizeof(int)                         // length in chars of the identifier
-                    + sizeof(char) * size_identifier      // identifier
-                    + sizeof(double)                      // time tag
-                    + sizeof(int) * 3                     // The number of parameter, observation
-                                                          // and instrument instance identifiers
-                    + sizeof(int) * n_iidentifiers;       // The whole set of instance identifiers
+    // Time tag.
 
-    size_total = size_o_record;
+    memcpy(pchar, &time, sizeof(double));
+    pchar += sizeof(double);
 
-    write_backtrack_info = false;
+    //
+    // Instance identifiers. First, parameters, then observations and,
+    // finally, instruments (if any, these are optional).
+    //
+    // For each type of instance identifiers we'll write first the
+    // counter (stating how may instance identifiers will follow) and
+    // the instance identifiers themselves.
+    //
 
-    if (time != last_time_tag_)
-    {
-      //
-      // We need to write the backtracking information for the previous
-      // sub-block.
-      //
+    memcpy(pchar, &n_parameter_iids, sizeof(int));
+    pchar += sizeof(int);
 
-      size_b_record =   sizeof(char) // type ('b')
-                      + sizeof(int); // total of bytes in block.
+    memcpy(pchar, the_parameter_iids, n_parameter_iids * sizeof(int));
+    pchar += n_parameter_iids * sizeof(int);
 
-      size_total += size_b_record;
+    memcpy(pchar, &n_observation_iids, sizeof(int));
+    pchar += sizeof(int);
 
-      // We must write the backtracking info.
+    memcpy(pchar, the_observation_iids, n_observation_iids * sizeof(int));
+    pchar += n_observation_iids * sizeof(int);
 
-      write_backtrack_info = true;
+    memcpy(pchar, &n_instrument_iids, sizeof(int));
+    pchar += sizeof(int);
 
-      // We've got a new last_time_tag_ to compare to.
+    if (n_instrument_iids > 0) memcpy(pchar, the_instrument_iids, n_instrument_iids * sizeof(int));
+    pchar += n_instrument_iids * sizeof(int);
 
-      last_time_tag_ = time;
-    }
+    // Update pointers and the total number of bytes in this block.
 
-    //
-    // Check if enough room is still left in the data buffer. If not, flush
-    // the buffer to disk and start storing data again from its beginning.
-    //
+    bytes_in_current_block_ += (int)(pchar - &(data_buffer_[data_buffer_cur_]));
+    data_buffer_cur_         = (int)(pchar - data_buffer_);
 
-    if ((data_buffer_cur_ + size_total) > data_buffer_size_)
-    {
-      status = flush();
+    // That's all.
 
-      // I/O error if status is not 0.
+    return 0;
+  }
+}
 
-      if (status != 0) return 2;
-    }
+int
+observation_file_writer_bin::
+write_epoch
+(const observation_epoch& epoch)
+{
+  {
+    bool   l_written;
+    bool   new_block;
+    int    n_covariance_values;
+    int    n_expectations;
+    int    n_instrument_iids;
+    int    n_observation_iids;
+    int    n_parameter_iids;
+    int    n_records;
+    int    n_tags;
+    int    record;
+    int    size_identifier;
+    int    size_total;
+    int    status;
+    double time;
 
-    // Copy to the data buffer the required info.
+    // Won't work if the file is closed.
 
-    if (write_backtrack_info)
-    {
-      // We must dump last sub-block backtracking data.
+    if (!file_is_open_) return 1;
 
-      // backtracking tag.
-      data_buffer_[data_buffer_cur_] = 'b';
-      data_buffer_cur_++;
+    n_records = epoch.get_n_records();
 
-      // bytes in sub-block.
-      pchar = (char*)&bytes_in_current_block_;
+    if (n_records == 0) return 0;
 
-      for(i = 0; i < (int)sizeof(int); i++)
-      {
-        data_buffer_[data_buffer_cur_] = pchar[i];
-        data_buffer_cur_++;
-      }
+    //
+    // Validate the whole epoch, computing the room it needs, before storing
+    // anything. The records are stored in a single pass afterwards.
+    //
+    // Records following the l-record at the beginning of the epoch need
+    // no backtracking information; the first one closes the epoch in
+    // progress, if any.
+    //
 
-      // Reset the number of bytes in the current sub-block.
+    time       = epoch.get_record_time(0);
+    new_block  = (!first_time_writing_) && (time != last_time_tag_);
+    l_written  = (!new_block) && first_l_written_;
+    size_total = 0;
 
-      bytes_in_current_block_ = 0;
+    if (new_block)
+    {
+      size_total +=   sizeof(char) // type ('b')
+                    + sizeof(int); // total of bytes in block.
+    }
 
-      // We'll expect an l-record the next time a write operation is called.
+    for (record = 0; record < n_records; record++)
+    {
+      //
+      // Records with different time tags make up several sub-blocks. Leave
+      // these to write_l() and write_o().
+      //
 
-      first_l_written_ = false;
-    }
+      if (epoch.get_record_time(record) != time) return obs_e_based_file_writer::write_epoch(epoch);
 
-    // o-tag
+      size_identifier = (int)strlen(epoch.get_identifier(record));
 
-    data_buffer_[data_buffer_cur_] = 'o';
-    data_buffer_cur_++;
+      if (size_identifier < 1) return 4;
 
-    // Active flag.
+      if (epoch.get_type(record) == 'l')
+      {
+        n_tags              = epoch.get_n_tags(record);
+        n_expectations      = epoch.get_n_expectations(record);
+        n_covariance_values = epoch.get_n_covariance_values(record);
 
-    if (active) cactive = 1;
-    else        cactive = 0;
+        if (n_tags < 0)          return 5;
+        if (n_expectations <= 0) return 5;
+        if ((n_covariance_values != 0)              &
+            (n_covariance_values != n_expectations) &
+            (n_covariance_values != (n_expectations*(n_expectations+1))/2))
+                                 return 5;
 
-    data_buffer_[data_buffer_cur_] = cactive;
-    data_buffer_cur_++;
+        size_total += l_record_size(size_identifier, n_tags, n_expectations, n_covariance_values);
 
-    // Length of the identifier.
+        if (epoch.get_active(record)) l_written = true;
+      }
+      else
+      {
+        if (!l_written) return 3;
 
-    pchar = (char*)&size_identifier;
+        n_parameter_iids   = epoch.get_n_parameter_iids(record);
+        n_observation_iids = epoch.get_n_observation_iids(record);
+        n_instrument_iids  = epoch.get_n_instrument_iids(record);
 
-    for (i = 0; i < (int)sizeof(int); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
+        if (n_parameter_iids   <= 0) return 7;
+        if (n_observation_iids <= 0) return 7;
+        if (n_instrument_iids  <  0) return 7;
+
+        size_total += o_record_size(size_identifier, n_parameter_iids + n_observation_iids + n_instrument_iids);
+      }
     }
 
+    // Epochs larger than the data buffer are split among several flushes.
+
+    if (size_total > data_buffer_size_) return obs_e_based_file_writer::write_epoch(epoch);
+
     //
-    // The identifier itself (variable length, that's why we wrote its
-    // length before).
+    // Check if enough room is still left in the data buffer for the whole
+    // epoch. If not, flush the buffer to disk and start storing data again
+    // from its beginning.
     //
 
-    for (i = 0; i < size_identifier; i++)
+    if ((data_buffer_cur_ + size_total) > data_buffer_size_)
     {
-      data_buffer_[data_buffer_cur_] = identifier[i];
-      data_buffer_cur_++;
-    }
+      status = flush();
 
-    // Time tag.
+      // I/O error if status is not 0.
 
-    pchar = (char*)&time;
+      if (status != 0) return 2;
+    }
+
+    // Store the records. Nothing may fail now but I/O operations.
 
-    for(i = 0; i < (int)sizeof(double); i++)
+    for (record = 0; record < n_records; record++)
     {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
+      if (epoch.get_type(record) == 'l')
+      {
+        status = store_l_record(epoch.get_active(record),
+                                epoch.get_identifier(record),
+                                (int)strlen(epoch.get_identifier(record)),
+                                epoch.get_instance_id(record),
+                                time,
+                                epoch.get_n_tags(record),
+                                epoch.get_tags(record),
+                                epoch.get_n_expectations(record),
+                                epoch.get_expectations(record),
+                                epoch.get_n_covariance_values(record),
+                                epoch.get_covariance_values(record));
+      }
+      else
+      {
+        status = store_o_record(epoch.get_active(record),
+                                epoch.get_identifier(record),
+                                (int)strlen(epoch.get_identifier(record)),
+                                time,
+                                epoch.get_n_parameter_iids(record),
+                                epoch.get_parameter_iids(record),
+                                epoch.get_n_observation_iids(record),
+                                epoch.get_observation_iids(record),
+                                epoch.get_n_instrument_iids(record),
+                                epoch.get_instrument_iids(record));
+      }
+
+      if (status != 0) return status;
     }
 
-    //
-    // Instance identifiers. First, parameters, then observations and,
-    // finally, instruments (if any, these are optional).
-    //
-    // For each type of instance identifiers we'll write first the
-    // counter (stating how may instance identifiers will follow) and
-    // the instance identifiers themselves.
-    //
+    // That's all.
 
-    // The counter (parameters)
+    return 0;
+  }
+}
 
-    pchar = (char*)&n_parameter_iids;
+int
+observation_file_writer_bin::
+write_o
+(bool         active,
+ char*        identifier,
+ double       time,
+ int          n_parameter_iids,
+ int*         the_parameter_iids,
+ int          n_observation_iids,
+ int*         the_observation_iids,
+ int          n_instrument_iids,
+ int*         the_instrument_iids)
+{
+  {
+    int   size_identifier;
+    int   size_total;
+    int   status;
 
-    for (i = 0; i < (int)sizeof(int); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    // Won't work if the file is closed.
 
-    // The instance identifiers (parameters)
+    if (!file_is_open_) return 1;
 
-    pchar = (char*)the_parameter_iids;
+    // identifier must be at least 1 chars long excluding the terminating NULL char.
 
-    for(i = 0; i < (int)(n_parameter_iids *sizeof(int)); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    if (identifier == NULL) return 4;
 
-    // The counter (observations)
+    size_identifier = (int)strlen(identifier);
 
-    pchar = (char*)&n_observation_iids;
+    if (size_identifier < 1) return 4;
 
-    for (i = 0; i < (int)sizeof(int); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    //
+    // Won't work neither if no l-records have been written yet for the
+    // current time tag.
+    //
 
-    // The instance identifiers (observations)
+    if (!first_l_written_) return 3;
 
-    pchar = (char*)the_observation_iids;
+    //
+    // We'll still refuse to do anything if the number of identifier does not
+    // match with what we're expecting.
+    //
 
-    for(i = 0; i < (int)(n_observation_iids *sizeof(int)); i++)
-    {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
-    }
+    if (n_parameter_iids   <= 0) return 7;
+    if (n_observation_iids <= 0) return 7;
+    if (n_instrument_iids  <  0) return 7;
 
-    // The counter (instruments)
+    //
+    // Compute the size needed to store the current o record in the buffer.
+    // We'll take into account the backtracking tags only when a sub-block
+    // (set of records with the same time tag) has just finished.
+    //
 
-    pchar = (char*)&n_instrument_iids;
+    size_total = o_record_size(size_identifier, n_parameter_iids + n_observation_iids + n_instrument_iids);
 
-    for (i = 0; i < (int)sizeof(int); i++)
+    if (time != last_time_tag_)
     {
-      data_buffer_[data_buffer_cur_] = pchar[i];
-      data_buffer_cur_++;
+      size_total +=   sizeof(char) // type ('b')
+                    + sizeof(int); // total of bytes in block.
     }
 
-    // The instance identifiers (instruments). IF ANY.
+    //
+    // Check if enough room is still left in the data buffer. If not, flush
+    // the buffer to disk and start storing data again from its beginning.
+    //
 
-    if (n_instrument_iids > 0)
+    if ((data_buffer_cur_ + size_total) > data_buffer_size_)
     {
-      pchar = (char*)the_instrument_iids;
-
-      for(i = 0; i < (int)(n_instrument_iids *sizeof(int)); i++)
-      {
-        data_buffer_[data_buffer_cur_] = pchar[i];
-        data_buffer_cur_++;
-      }
-    }
+      status = flush();
 
-    // Update the total number of bytes in this block.
+      // I/O error if status is not 0.
 
-    bytes_in_current_block_ += size_o_record;
+      if (status != 0) return 2;
+    }
 
-    // That's all.
+    // Copy to the data buffer the required info.
 
-    return 0;
+    return store_o_record(active, identifier, size_identifier, time,
+                          n_parameter_iids,   the_parameter_iids,
+                          n_observation_iids, the_observation_iids,
+                          n_instrument_iids,  the_instrument_iids);
   }
 }
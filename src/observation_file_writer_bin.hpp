@@ -99,6 +99,80 @@ class observation_file_writer_bin : public obs_e_based_file_writer_bin
                                               int          n_instrument_iids,
                                               int*         the_instrument_iids);
 
+    /**
+     * @brief Write all the l- and o-records of an epoch.
+     *
+     * @param epoch The records to write, in the order these must appear
+     *        in the file.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: File is not open so it is not possible to write.
+     *        - 2: I/O error detected while writing to disk.
+     *        - 3: An o-record would be the first record in the group
+     *             sharing the same time tag.
+     *        - 4: An identifier is empty.
+     *        - 5: Invalid number of tags, expectations or covariance values
+     *             in an l-record (see write_l()).
+     *        - 7: Invalid number of instance identifiers in an o-record
+     *             (see write_o()).
+     *
+     * When all the records share the same time tag, the epoch is validated
+     * as a whole before storing anything, so nothing is written if any
+     * record is wrong. Then, the room needed by the epoch is reserved once
+     * and the records are stored one after the other, with no further
+     * checks. The file is the same that write_l() and write_o() would
+     * create.
+     *
+     * Epochs mixing time tags, or too big for the data buffer, are written
+     * record by record (see obs_e_based_file_writer::write_epoch()).
+     */
+
+    virtual int  write_epoch                 (const observation_epoch& epoch);
+
+  protected:
+
+    /**
+     * @brief Size, in bytes, of an o-record once stored in the data buffer.
+     *
+     * @param size_identifier Length of the identifier, in characters.
+     * @param n_iidentifiers Total number of parameter, observation and
+     *        instrument instance identifiers.
+     * @return The size of the record, not including any backtracking record.
+     */
+
+    int          o_record_size               (int          size_identifier,
+                                              int          n_iidentifiers) const;
+
+    /**
+     * @brief Store an o-record already validated in the data buffer.
+     *
+     * @param active The o-record is active (true) or removed (false).
+     * @param identifier Identifier of the o-record.
+     * @param size_identifier Length of the identifier, in characters.
+     * @param time Time tag of the o-record.
+     * @param n_parameter_iids Number of parameter instance identifiers.
+     * @param the_parameter_iids The parameter instance identifiers.
+     * @param n_observation_iids Number of observation instance identifiers.
+     * @param the_observation_iids The observation instance identifiers.
+     * @param n_instrument_iids Number of instrument instance identifiers.
+     * @param the_instrument_iids The instrument instance identifiers.
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 2: I/O error detected while writing to disk.
+     *
+     * See store_l_record(); the same rules apply.
+     */
+
+    int          store_o_record              (bool          active,
+                                              const char*   identifier,
+                                              int           size_identifier,
+                                              double        time,
+                                              int           n_parameter_iids,
+                                              const int*    the_parameter_iids,
+                                              int           n_observation_iids,
+                                              const int*    the_observation_iids,
+                                              int           n_instrument_iids,
+                                              const int*    the_instrument_iids);
 };
 
 #endif // OBSERVATION_FILE_WRITER_BIN_HPP
@@ -0,0 +1,595 @@
+/** \file observation_file_writer_col.cpp
+  \brief Implementation file for observation_file_writer_col.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+#include "observation_file_writer_col.hpp"
+
+int
+observation_file_writer_col::
+close
+(void)
+{
+  {
+    int  i;
+    int  status;
+    bool write_failed;
+
+    // Do not complain if the file is already closed.
+    if (!file_is_open_) return 0;
+
+    //
+    // Write the blocks still in memory, then the directory (that must
+    // describe all of them) and the trailer.
+    //
+
+    write_failed = false;
+
+    for (i = 0; i < (int)blocks_.size(); i++)
+    {
+      if (blocks_[i]->times.size() == 0) continue;
+
+      if (write_block(blocks_[i]) != 0)
+      {
+        write_failed = true;
+        break;
+      }
+    }
+
+    if (!write_failed)
+    {
+      if (write_directory() != 0) write_failed = true;
+    }
+
+    if (!write_failed)
+    {
+      if (flush() != 0) write_failed = true;
+    }
+
+    // Wait for the data flushed in the background, if any.
+
+    if (finish_flushing() != 0) write_failed = true;
+
+    // Get rid of the blocks. These are no longer needed.
+
+    for (i = 0; i < (int)blocks_.size(); i++) delete blocks_[i];
+
+    blocks_.clear();
+    blocks_index_.clear();
+    directory_.clear();
+
+    if (write_failed)
+    {
+      fclose(file_file_);
+
+      delete [] data_buffer_;
+      data_buffer_ = NULL;
+
+      file_is_open_ = false;
+      return 2;
+    }
+
+    // Close the file.
+
+    status = fclose(file_file_);
+    if (status != 0) return 1;
+
+    //
+    // The file is closed now. Update the corresponding status members and
+    // destroy buffers.
+    //
+
+    delete [] data_buffer_;
+    data_buffer_ = NULL;
+
+    file_is_open_ = false;
+
+    // Successful completion.
+
+    return 0;
+  }
+}
+
+observation_file_writer_col::column_block*
+observation_file_writer_col::
+get_block
+(char        type,
+ const char* identifier,
+ const int*  dimensions)
+{
+  column_block* block;
+
+  {
+    unordered_map<string, int>::iterator it;
+    string                               key;
+
+    //
+    // Records are grouped by type, identifier and dimensions. Build a key
+    // holding all of them (the identifier is NULL terminated, so no two
+    // different combinations may produce the same key).
+    //
+
+    key.reserve(strlen(identifier) + 2 + 3 * sizeof(int));
+
+    key.push_back(type);
+    key.append(identifier);
+    key.push_back('\0');
+    key.append((const char*)dimensions, 3 * sizeof(int));
+
+    it = blocks_index_.find(key);
+
+    if (it != blocks_index_.end())
+    {
+      block = blocks_[it->second];
+    }
+    else
+    {
+      // First record of its kind. Create its block.
+
+      block = new column_block();
+
+      block->type          = type;
+      block->identifier    = identifier;
+      block->dimensions[0] = dimensions[0];
+      block->dimensions[1] = dimensions[1];
+      block->dimensions[2] = dimensions[2];
+
+      if (type == 'l') block->value_columns.resize(dimensions[0] + dimensions[1]);
+      else             block->iid_columns.resize(dimensions[0] + dimensions[1] + dimensions[2]);
+
+      blocks_index_[key] = (int)blocks_.size();
+      blocks_.push_back(block);
+    }
+  }
+
+  return block;
+}
+
+observation_file_writer_col::
+observation_file_writer_col
+(void)
+{
+  {
+    block_size_ = _ASTROLABE_COL_FILE_WRITER_DEFAULT_BLOCK_SIZE;
+  }
+}
+
+observation_file_writer_col::
+~observation_file_writer_col
+(void)
+{
+  {
+    int i;
+
+    // Make sure that the file is closed, flushing any data not yet written.
+    if (file_is_open_) close();
+
+    // Destroy blocks and buffers (if needed).
+
+    for (i = 0; i < (int)blocks_.size(); i++) delete blocks_[i];
+
+    if (data_buffer_ != NULL) delete [] data_buffer_;
+    data_buffer_ = NULL;
+  }
+}
+
+int
+observation_file_writer_col::
+open
+(const char* file_name)
+{
+  {
+    int status;
+
+    // Open the file and allocate the data buffer.
+
+    status = obs_e_based_file_writer::open(file_name);
+    if (status != 0) return status;
+
+    // Start from scratch.
+
+    blocks_.clear();
+    blocks_index_.clear();
+    directory_.clear();
+
+    first_l_written_    = false;
+    first_time_writing_ = true;
+
+    // Columnar files start with their magic string.
+
+    if (store(_ASTROLABE_COL_FILE_MAGIC, _ASTROLABE_COL_FILE_MAGIC_SIZE) != 0)
+    {
+      fclose(file_file_);
+
+      delete [] data_buffer_;
+      data_buffer_ = NULL;
+
+      file_is_open_ = false;
+      return 2;
+    }
+
+    // Successful completion.
+
+    return 0;
+  }
+}
+
+int
+observation_file_writer_col::
+set_block_size
+(int block_size)
+{
+  {
+    // If the file is already open, it's not legal to change the block size.
+    if (file_is_open_)   return 1;
+
+    // The block size must be a positive value.
+    if (block_size <= 0) return 2;
+
+    block_size_ = block_size;
+
+    // Bye.
+
+    return 0;
+  }
+}
+
+int
+observation_file_writer_col::
+set_time_index
+(bool enabled)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    // The directory of the file already plays the role of the time index.
+    if (enabled)       return 2;
+
+    return obs_e_based_file_writer::set_time_index(false);
+  }
+}
+
+int
+observation_file_writer_col::
+store
+(const void* data,
+ long long   n_bytes)
+{
+  {
+    long long   n_copy;
+    const char* pchar;
+
+    pchar = (const char*)data;
+
+    //
+    // Columns may be larger than the data buffer. Copy as much as
+    // possible each time, flushing the buffer when full.
+    //
+
+    while (n_bytes > 0)
+    {
+      if (data_buffer_cur_ == data_buffer_size_)
+      {
+        if (flush() != 0) return 1;
+      }
+
+      n_copy = data_buffer_size_ - data_buffer_cur_;
+      if (n_copy > n_bytes) n_copy = n_bytes;
+
+      memcpy(data_buffer_ + data_buffer_cur_, pchar, (size_t)n_copy);
+
+      data_buffer_cur_ += (int)n_copy;
+      pchar            += n_copy;
+      n_bytes          -= n_copy;
+    }
+
+    return 0;
+  }
+}
+
+int
+observation_file_writer_col::
+write_block
+(column_block* block)
+{
+  {
+    block_entry entry;
+    int         i;
+    long long   n_bytes;
+    int         n_records;
+
+    n_records = (int)block->times.size();
+
+    // Describe the block in the directory.
+
+    entry.type          = block->type;
+    entry.identifier    = block->identifier;
+    entry.n_records     = n_records;
+    entry.dimensions[0] = block->dimensions[0];
+    entry.dimensions[1] = block->dimensions[1];
+    entry.dimensions[2] = block->dimensions[2];
+    entry.offset        = file_bytes_flushed_ + data_buffer_cur_;
+
+    entry.time_min = block->times[0];
+    entry.time_max = block->times[0];
+
+    for (i = 1; i < n_records; i++)
+    {
+      if (block->times[i] < entry.time_min) entry.time_min = block->times[i];
+      if (block->times[i] > entry.time_max) entry.time_max = block->times[i];
+    }
+
+    // Columns shared by l- and o-records: time tags and active flags.
+
+    n_bytes = (long long)n_records * sizeof(double);
+    if (store(block->times.data(), n_bytes) != 0) return 1;
+    entry.column_sizes.push_back(n_bytes);
+
+    n_bytes = (long long)n_records * sizeof(char);
+    if (store(block->actives.data(), n_bytes) != 0) return 1;
+    entry.column_sizes.push_back(n_bytes);
+
+    if (block->type == 'l')
+    {
+      // Instance identifiers.
+
+      n_bytes = (long long)n_records * sizeof(int);
+      if (store(block->instance_ids.data(), n_bytes) != 0) return 1;
+      entry.column_sizes.push_back(n_bytes);
+
+      // One column per tag and expectation.
+
+      for (i = 0; i < (int)block->value_columns.size(); i++)
+      {
+        n_bytes = (long long)n_records * sizeof(double);
+        if (store(block->value_columns[i].data(), n_bytes) != 0) return 1;
+        entry.column_sizes.push_back(n_bytes);
+      }
+
+      // Covariances: how many values per record, then the values themselves.
+
+      n_bytes = (long long)n_records * sizeof(int);
+      if (store(block->covariance_counts.data(), n_bytes) != 0) return 1;
+      entry.column_sizes.push_back(n_bytes);
+
+      n_bytes = (long long)block->covariance_values.size() * sizeof(double);
+      if (store(block->covariance_values.data(), n_bytes) != 0) return 1;
+      entry.column_sizes.push_back(n_bytes);
+    }
+    else
+    {
+      // One column per parameter, observation and instrument instance identifier.
+
+      for (i = 0; i < (int)block->iid_columns.size(); i++)
+      {
+        n_bytes = (long long)n_records * sizeof(int);
+        if (store(block->iid_columns[i].data(), n_bytes) != 0) return 1;
+        entry.column_sizes.push_back(n_bytes);
+      }
+    }
+
+    directory_.push_back(entry);
+
+    // Empty the block, keeping its memory for the next records.
+
+    block->actives.clear();
+    block->covariance_counts.clear();
+    block->covariance_values.clear();
+    block->instance_ids.clear();
+    block->times.clear();
+
+    for (i = 0; i < (int)block->value_columns.size(); i++) block->value_columns[i].clear();
+    for (i = 0; i < (int)block->iid_columns.size();   i++) block->iid_columns[i].clear();
+
+    return 0;
+  }
+}
+
+int
+observation_file_writer_col::
+write_directory
+(void)
+{
+  {
+    long long    directory_offset;
+    block_entry* entry;
+    int          i;
+    int          id_length;
+    int          n_blocks;
+    int          n_columns;
+
+    directory_offset = file_bytes_flushed_ + data_buffer_cur_;
+
+    for (i = 0; i < (int)directory_.size(); i++)
+    {
+      entry = &directory_[i];
+
+      id_length = (int)entry->identifier.length();
+      n_columns = (int)entry->column_sizes.size();
+
+      if (store(&entry->type,               sizeof(char))              != 0) return 1;
+      if (store(&id_length,                 sizeof(int))               != 0) return 1;
+      if (store(entry->identifier.data(),   id_length)                 != 0) return 1;
+      if (store(&entry->n_records,          sizeof(int))               != 0) return 1;
+      if (store(&entry->time_min,           sizeof(double))            != 0) return 1;
+      if (store(&entry->time_max,           sizeof(double))            != 0) return 1;
+      if (store(entry->dimensions,          3 * sizeof(int))           != 0) return 1;
+      if (store(&entry->offset,             sizeof(long long))         != 0) return 1;
+      if (store(&n_columns,                 sizeof(int))               != 0) return 1;
+      if (store(entry->column_sizes.data(), n_columns * sizeof(long long)) != 0) return 1;
+    }
+
+    // The trailer tells readers where the directory is.
+
+    n_blocks = (int)directory_.size();
+
+    if (store(&directory_offset,          sizeof(long long))             != 0) return 1;
+    if (store(&n_blocks,                  sizeof(int))                   != 0) return 1;
+    if (store(_ASTROLABE_COL_FILE_MAGIC,  _ASTROLABE_COL_FILE_MAGIC_SIZE) != 0) return 1;
+
+    return 0;
+  }
+}
+
+int
+observation_file_writer_col::
+write_l
+(bool         active,
+ char*        identifier,
+ int          instance_identifier,
+ double       time,
+ int          n_tags,
+ double*      buffer_tags,
+ int          n_expectations,
+ double*      buffer_expectations,
+ int          n_covariance_values,
+ double*      buffer_covariance)
+{
+  {
+    column_block* block;
+    int           dimensions[3];
+    int           i;
+
+    // Won't work if the file is closed.
+
+    if (!file_is_open_)      return 1;
+
+    // code must be at least 1 chars long excluding the terminating NULL char.
+
+    if (identifier == NULL)  return 4;
+    if (identifier[0] == 0)  return 4;
+
+    // The dimensions of the several double arrays must be correct.
+
+    if (n_tags < 0)          return 5;
+    if (n_expectations <= 0) return 5;
+    if ((n_covariance_values != 0)              &
+        (n_covariance_values != n_expectations) &
+        (n_covariance_values != (n_expectations*(n_expectations+1))/2))
+                             return 5;
+
+    //
+    // Keep track of the current epoch, so misplaced o-records may be
+    // detected (see write_o()).
+    //
+
+    first_time_writing_ = false;
+    first_l_written_    = true;
+    last_time_tag_      = time;
+
+    // Append the record to its block.
+
+    dimensions[0] = n_tags;
+    dimensions[1] = n_expectations;
+    dimensions[2] = 0;
+
+    block = get_block('l', identifier, dimensions);
+
+    block->times.push_back(time);
+    block->actives.push_back(active ? 1 : 0);
+    block->instance_ids.push_back(instance_identifier);
+
+    for (i = 0; i < n_tags; i++)
+      block->value_columns[i].push_back(buffer_tags[i]);
+
+    for (i = 0; i < n_expectations; i++)
+      block->value_columns[n_tags + i].push_back(buffer_expectations[i]);
+
+    block->covariance_counts.push_back(n_covariance_values);
+    block->covariance_values.insert(block->covariance_values.end(),
+                                    buffer_covariance, buffer_covariance + n_covariance_values);
+
+    // Dump the block when full.
+
+    if ((int)block->times.size() >= block_size_)
+    {
+      if (write_block(block) != 0) return 2;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_file_writer_col::
+write_o
+(bool         active,
+ char*        identifier,
+ double       time,
+ int          n_parameter_iids,
+ int*         the_parameter_iids,
+ int          n_observation_iids,
+ int*         the_observation_iids,
+ int          n_instrument_iids,
+ int*         the_instrument_iids)
+{
+  {
+    column_block* block;
+    int           dimensions[3];
+    int           i;
+    int           offset;
+
+    // Won't work if the file is closed.
+
+    if (!file_is_open_) return 1;
+
+    // identifier must be at least 1 chars long excluding the terminating NULL char.
+
+    if (identifier == NULL) return 4;
+    if (identifier[0] == 0) return 4;
+
+    //
+    // Won't work neither if no l-records have been written yet for the
+    // current time tag.
+    //
+
+    if (!first_l_written_)     return 3;
+    if (time != last_time_tag_) return 3;
+
+    //
+    // We'll still refuse to do anything if the number of identifier does not
+    // match with what we're expecting.
+    //
+
+    if (n_parameter_iids   <= 0) return 7;
+    if (n_observation_iids <= 0) return 7;
+    if (n_instrument_iids  <  0) return 7;
+
+    // Append the record to its block.
+
+    dimensions[0] = n_parameter_iids;
+    dimensions[1] = n_observation_iids;
+    dimensions[2] = n_instrument_iids;
+
+    block = get_block('o', identifier, dimensions);
+
+    block->times.push_back(time);
+    block->actives.push_back(active ? 1 : 0);
+
+    for (i = 0; i < n_parameter_iids; i++)
+      block->iid_columns[i].push_back(the_parameter_iids[i]);
+
+    offset = n_parameter_iids;
+
+    for (i = 0; i < n_observation_iids; i++)
+      block->iid_columns[offset + i].push_back(the_observation_iids[i]);
+
+    offset += n_observation_iids;
+
+    for (i = 0; i < n_instrument_iids; i++)
+      block->iid_columns[offset + i].push_back(the_instrument_iids[i]);
+
+    // Dump the block when full.
+
+    if ((int)block->times.size() >= block_size_)
+    {
+      if (write_block(block) != 0) return 2;
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
@@ -0,0 +1,411 @@
+/** \file observation_file_writer_col.hpp
+  \brief Class defining the interface of observation columnar file writers.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef OBSERVATION_FILE_WRITER_COL_HPP
+#define OBSERVATION_FILE_WRITER_COL_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "obs_e_based_file_writer.hpp"
+
+using namespace std;
+
+/// @brief Default number of records stored in a column block.
+
+#define _ASTROLABE_COL_FILE_WRITER_DEFAULT_BLOCK_SIZE 65536
+
+/// @brief Magic string found at the beginning and the end of columnar files.
+
+#define _ASTROLABE_COL_FILE_MAGIC "ASTRCOL1"
+
+/// @brief Length, in bytes, of _ASTROLABE_COL_FILE_MAGIC.
+
+#define _ASTROLABE_COL_FILE_MAGIC_SIZE 8
+
+/**
+ * @brief Class defining the interface of observation columnar file writers.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * Columnar files store the same information as binary (or text) files,
+ * but records are not written in the order these are received. Instead,
+ * records are grouped in column blocks. All the records in a block share
+ * their type, identifier and dimensions (number of tags and expectations
+ * for l-records, number of parameter, observation and instrument instance
+ * identifiers for o-records) and every field of these records is stored
+ * as a contiguous column: the time tags of all the records in the block,
+ * then their active flags, and so on. This way, applications interested
+ * in a few fields of a few kinds of records only (for instance, the
+ * expectations of a given observation) may read just these (see
+ * observation_file_reader_col) instead of the whole file.
+ *
+ * A block is written to disk when it reaches the number of records set
+ * with set_block_size() or when the writer is closed. The time range
+ * covered by every block is kept in a directory written at the end of
+ * the file, so readers may skip the blocks out of the range of interest.
+ *
+ * File layout (native byte order, the same used by binary files):
+ *
+ * - _ASTROLABE_COL_FILE_MAGIC.
+ * - The column blocks, one after the other. l-blocks hold the following
+ *   columns: time tags (double), active flags (char), instance identifiers
+ *   (int), one column per tag (double), one column per expectation (double),
+ *   number of covariance values of each record (int) and, finally, the
+ *   covariance values of all the records, one after the other (double).
+ *   o-blocks hold the following columns: time tags (double), active flags
+ *   (char) and one column per parameter, observation and instrument instance
+ *   identifier (int).
+ * - The directory. For every block: type (char), length of the identifier
+ *   (int), identifier (chars), number of records (int), minimum and maximum
+ *   time tags (double), dimensions (3 int), offset of the block in the file
+ *   (long long), number of columns (int) and size in bytes of each column
+ *   (long long).
+ * - The trailer: offset of the directory (long long), number of blocks
+ *   (int) and _ASTROLABE_COL_FILE_MAGIC again.
+ *
+ * Note that time indexes (see set_time_index()) are not available for
+ * columnar files; the directory plays this role.
+ */
+class observation_file_writer_col : public obs_e_based_file_writer
+{
+  public:
+
+    /**
+     * @brief Closes the columnar file writer, disabling any other
+     *        further action on it.
+     *
+     * Writes the blocks still in memory, the directory and the trailer
+     * to the underlying file. Once close is executed, it is not possible
+     * to perform any other actions on the writer besides destroying it.
+     *
+     * @return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: Error closing the file.
+     *        - 2: I/O error while writing data to disk.
+     */
+
+    virtual int  close                       (void);
+
+    /**
+     * @brief Default constructor.
+     *
+     */
+
+                 observation_file_writer_col (void);
+
+    /**
+     * @brief Destructor.
+     *
+     * Destroys the columnar writer. It also closes the underlying file
+     * if no close() has been issued by the calling module, in order
+     * to guarantee that all data is flushed to disk.
+     */
+
+    virtual     ~observation_file_writer_col (void);
+
+    /**
+     * @brief Opens the writer, enabling I/O operations.
+     *
+     * @param file_name Name of the file to write.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file was already open.
+     *        - 2: Unable to open the selected file.
+     *        - 3: Not enough memory to allocate the internal buffer.
+     *
+     * See obs_e_based_file_writer::open(). Besides, this method writes
+     * the magic string identifying columnar files.
+     */
+
+    virtual int  open                        (const char*  file_name);
+
+    /**
+     * @brief Set the maximum number of records in a column block.
+     *
+     * @param block_size The maximum number of records in a block.
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              the block size at this moment.
+     *         - 2: Invalid block size. It must be greater than zero.
+     *
+     * Larger blocks mean longer, more efficient, column reads but
+     * coarser time ranges and more memory used by the writer, since
+     * every kind of record being written keeps a block in memory. By
+     * default, _ASTROLABE_COL_FILE_WRITER_DEFAULT_BLOCK_SIZE records.
+     */
+
+    int          set_block_size              (int          block_size);
+
+    /**
+     * @brief Enable or disable the creation of a time index for the file.
+     *
+     * @param enabled True to create the time index, false otherwise.
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion (only when enabled is false).
+     *         - 1: Writer already open.
+     *         - 2: Time indexes are not available for columnar files.
+     *
+     * Columnar files keep the time range of every block in their
+     * directory, so no time index is needed.
+     */
+
+    virtual int  set_time_index              (bool         enabled);
+
+    /**
+     * @brief Write an l-record.
+     *
+     * @param active The l-record is active (true) or removed (false).
+     * @param identifier Identifier of the l-record.
+     * @param instance_identifier Instance identifier of the l-record.
+     * @param time Time tag of the l-record.
+     * @param n_tags Number of tag values to write. May be zero if the
+     *        l-record being written has no related tags.
+     * @param buffer_tags Array holding the n_tags tag values to write.
+     * @param n_expectations Dimension of the expectations array, that is,
+     *        the number of expectation values to write.
+     * @param buffer_expectations Array holding the n_expectations values
+     *        to write.
+     * @param n_covariance_values Number of covariance matrix elements to
+     *        write. May be either 0 (no covariance matrix is written),
+     *        n_expectations (that is, only the standard deviations are written)
+     *        or (n_expectations * (n_expectations + 1))/2, (the full covariance
+     *        matrix, not duplicating simmetric values).
+     * @param buffer_covariance The covariance matrix elements to write.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: File is not open so it is not possible to write.
+     *        - 2: I/O error detected while writing to disk.
+     *        - 3: NOT USED.
+     *        - 4: Parameter identifier must be at least 1 character long (excluding
+     *             the terminating NULL string).
+     *        - 5: Invalid number of values specified in n_tags (must be >= 0),
+     *             n_expectations (must be > 0) or n_covariance_values (0,
+     *             n_expectations or (n_expectations*(n_expectations+1))/2.
+     *
+     * The record is appended to the block in memory holding the records
+     * with the same identifier and dimensions. The block is written to
+     * disk when full.
+     */
+
+    virtual int  write_l                     (bool         active,
+                                              char*        identifier,
+                                              int          instance_identifier,
+                                              double       time,
+                                              int          n_tags,
+                                              double*      buffer_tags,
+                                              int          n_expectations,
+                                              double*      buffer_expectations,
+                                              int          n_covariance_values,
+                                              double*      buffer_covariance);
+
+    /**
+     * @brief Writes an o-record.
+     *
+     * @param active The o-record is active (true) or removed (false).
+     * @param identifier Identifier of the o-record.
+     * @param time Time tag of the o-record.
+     * @param n_parameter_iids Total number of parameter instance identifiers
+     *        to write. Must be greater than 0.
+     * @param the_parameter_iids Buffer storing the parameter instance
+     *        identifiers to write.
+     * @param n_observation_iids Total number of observation instance identifiers
+     *        to write. Must be greater than 0.
+     * @param the_observation_iids Buffer storing the observation instance
+     *        identifiers to write.
+     * @param n_instrument_iids Total number of instrument instance identifiers
+     *        to write. May be zero.
+     * @param the_instrument_iids Buffer storing the instrument instance
+     *        identifiers to write.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: File is not open so it is not possible to write.
+     *        - 2: I/O error detected while writing to disk.
+     *        - 3: An attempt to write an o-record as the first record in the
+     *             group sharing the same time tag has been detected.
+     *        - 4: Parameter code must at least 1 character long (excluding
+     *             the terminating NULL string).
+     *        - 5: NOT USED.
+     *        - 6: NOT USED.
+     *        - 7: Either the number of parameter or observation instance
+     *              identifiers are equal to or less than zero. These values
+     *              must be strictly positive. Also, this error code may
+     *              be issued if the number of instrument instance identifiers
+     *              requested is negative (but it may be zero).
+     *
+     * The record is appended to the block in memory holding the records
+     * with the same identifier and dimensions. The block is written to
+     * disk when full.
+     */
+
+    virtual int  write_o                     (bool         active,
+                                              char*        identifier,
+                                              double       time,
+                                              int          n_parameter_iids,
+                                              int*         the_parameter_iids,
+                                              int          n_observation_iids,
+                                              int*         the_observation_iids,
+                                              int          n_instrument_iids,
+                                              int*         the_instrument_iids);
+
+  protected:
+
+    /// @brief A block of records (still in memory) sharing type,
+    /// identifier and dimensions.
+
+    struct column_block
+    {
+      /// @brief Active flags of the records.
+
+      vector<char>           actives;
+
+      /// @brief Number of covariance values of each l-record.
+
+      vector<int>            covariance_counts;
+
+      /// @brief Covariance values of all the l-records, one after the other.
+
+      vector<double>         covariance_values;
+
+      /// @brief Number of tags and expectations (l-records) or parameter,
+      /// observation and instrument instance identifiers (o-records).
+
+      int                    dimensions[3];
+
+      /// @brief Identifier of the records in the block.
+
+      string                 identifier;
+
+      /// @brief Instance identifier columns (o-records; parameters,
+      /// observations and instruments, in this order).
+
+      vector< vector<int> >  iid_columns;
+
+      /// @brief Instance identifiers of the records (l-records).
+
+      vector<int>            instance_ids;
+
+      /// @brief Time tags of the records.
+
+      vector<double>         times;
+
+      /// @brief Type of the records in the block ('l' or 'o').
+
+      char                   type;
+
+      /// @brief Tag and expectation columns (l-records; tags first).
+
+      vector< vector<double> > value_columns;
+    };
+
+    /// @brief Directory entry describing a block already written.
+
+    struct block_entry
+    {
+      /// @brief Size in bytes of each of the columns in the block.
+
+      vector<long long>      column_sizes;
+
+      /// @brief Dimensions of the records in the block.
+
+      int                    dimensions[3];
+
+      /// @brief Identifier of the records in the block.
+
+      string                 identifier;
+
+      /// @brief Number of records in the block.
+
+      int                    n_records;
+
+      /// @brief Offset of the first column of the block in the file.
+
+      long long              offset;
+
+      /// @brief Maximum time tag in the block.
+
+      double                 time_max;
+
+      /// @brief Minimum time tag in the block.
+
+      double                 time_min;
+
+      /// @brief Type of the records in the block ('l' or 'o').
+
+      char                   type;
+    };
+
+  protected:
+
+    /**
+     * @brief Retrieve the block in memory where to append a new record,
+     *        creating it if needed.
+     *
+     * @param type Type of the record ('l' or 'o').
+     * @param identifier Identifier of the record.
+     * @param dimensions The dimensions of the record.
+     * @return The block where to append the record.
+     */
+
+    column_block* get_block                  (char         type,
+                                              const char*  identifier,
+                                              const int*   dimensions);
+
+    /**
+     * @brief Copy some bytes to the data buffer, flushing it as needed.
+     *
+     * @param data The bytes to store.
+     * @param n_bytes How many bytes to store.
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 1: Error detected while writting the buffer to disk.
+     */
+
+    int          store                       (const void*  data,
+                                              long long    n_bytes);
+
+    /**
+     * @brief Write a block to disk and add it to the directory.
+     *
+     * @param block The block to write. It's emptied (but kept) afterwards.
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 1: Error detected while writting the block to disk.
+     */
+
+    int          write_block                 (column_block* block);
+
+    /**
+     * @brief Write the directory and the trailer.
+     *
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 1: Error detected while writting to disk.
+     */
+
+    int          write_directory             (void);
+
+  protected:
+
+    /// @brief The blocks being filled, one per type, identifier and dimensions.
+
+    vector<column_block*>         blocks_;
+
+    /// @brief Position in blocks_ of each block, by type, identifier and dimensions.
+
+    unordered_map<string, int>    blocks_index_;
+
+    /// @brief Maximum number of records in a block.
+
+    int                           block_size_;
+
+    /// @brief Directory of the blocks already written.
+
+    vector<block_entry>           directory_;
+};
+
+#endif // OBSERVATION_FILE_WRITER_COL_HPP
@@ -22,6 +22,265 @@ observation_file_writer_txt::
   }
 }
 
+void
+observation_file_writer_txt::
+store_o_record
+(bool          active,
+ const char*   identifier,
+ double        time,
+ int           n_parameter_iids,
+ const int*    the_parameter_iids,
+ int           n_observation_iids,
+ const int*    the_observation_iids,
+ int           n_instrument_iids,
+ const int*    the_instrument_iids)
+{
+  {
+    int   bytes_written;
+    char  cactive;
+    int   i;
+    char* pchar;
+    int   total_bytes_written;
+
+    //
+    // "Print" to the data buffer the required info.
+    //
+    // This is done in several steps:
+    //
+    // - The o tag (including the active / removed attribute),
+    //   identifier and time tag first,
+    // - the different lists of instance identifiers, using several loops then, and
+    // - the closing o tag plus the newline, to finish.
+    //
+
+    total_bytes_written = 0;
+    pchar = &(data_buffer_[data_buffer_cur_]);
+
+    // o tag, identifier and time tag.
+
+    if (active) cactive = 'a';
+    else        cactive = 'r';
+
+    if (shortest_doubles_)
+    {
+      bytes_written  = print_text(pchar,                 active ? "<o s=\"a\" id=\"" : "<o s=\"r\" id=\"");
+      bytes_written += print_text(pchar + bytes_written, identifier);
+      bytes_written += print_text(pchar + bytes_written, "\">");
+      bytes_written += print_double(pchar + bytes_written, time);
+    }
+    else bytes_written = sprintf(pchar, format_fixed_o_, cactive, identifier, time);
+    total_bytes_written += bytes_written;
+    pchar += bytes_written;
+
+    // The list of parameter instance identifiers
+
+    for (i = 0; i < n_parameter_iids; i++ )
+    {
+      bytes_written = print_int(pchar, the_parameter_iids[i]);
+      total_bytes_written += bytes_written;
+      pchar+= bytes_written;
+    }
+
+    // The list of observation instance identifiers
+
+    for (i = 0; i < n_observation_iids; i++ )
+    {
+      bytes_written = print_int(pchar, the_observation_iids[i]);
+      total_bytes_written += bytes_written;
+      pchar+= bytes_written;
+    }
+
+    // The list of instrument instance identifiers, if any.
+
+    if (n_instrument_iids > 0)
+    {
+      for (i = 0; i < n_instrument_iids; i++ )
+      {
+        bytes_written = print_int(pchar, the_instrument_iids[i]);
+        total_bytes_written += bytes_written;
+        pchar+= bytes_written;
+      }
+    }
+
+    //
+    // Closing o tag plus newline. Note that the actual contents of NEWLINE,
+    // a macro defined at the header of this class, will depend on the
+    // operating system used when compiling this code.
+    //
+
+    bytes_written = print_text(pchar, " </o>" NEWLINE);
+    total_bytes_written += bytes_written;
+
+    // Update pointers.
+
+    data_buffer_cur_ += total_bytes_written;
+  }
+}
+
+int
+observation_file_writer_txt::
+write_epoch
+(const observation_epoch& epoch)
+{
+  {
+    bool   active;
+    bool   l_written;
+    int    n_covariance_values;
+    int    n_double_elements;
+    int    n_expectations;
+    int    n_iidentifiers;
+    int    n_instrument_iids;
+    int    n_observation_iids;
+    int    n_parameter_iids;
+    int    n_records;
+    int    n_tags;
+    int    record;
+    int    sizeof_identifier;
+    int    size_total;
+    int    status;
+    double time;
+
+    // Won't work if the file is closed.
+
+    if (!file_is_open_) return 1;
+
+    n_records = epoch.get_n_records();
+
+    if (n_records == 0) return 0;
+
+    //
+    // Validate the whole epoch, computing the room it needs, before printing
+    // anything. The records are printed in a single pass afterwards.
+    //
+    // Active o-records are legal once an active l-record with the same
+    // time tag has been written, either in this epoch or before it.
+    // Inactive records never change flags. The size of the instance
+    // identifier of l-records is bounded by the size of an integer value.
+    //
+
+    time       = epoch.get_record_time(0);
+    l_written  = (!first_time_writing_) && (time == last_time_tag_) && first_l_written_;
+    size_total = 0;
+
+    for (record = 0; record < n_records; record++)
+    {
+      //
+      // Records with different time tags make up several sub-blocks. Leave
+      // these to write_l() and write_o().
+      //
+
+      if (epoch.get_record_time(record) != time) return obs_e_based_file_writer::write_epoch(epoch);
+
+      active = epoch.get_active(record);
+
+      if (epoch.get_type(record) == 'l')
+      {
+        sizeof_identifier = (int)strlen(epoch.get_identifier(record));
+        if (sizeof_identifier < 1) return 4;
+
+        n_tags              = epoch.get_n_tags(record);
+        n_expectations      = epoch.get_n_expectations(record);
+        n_covariance_values = epoch.get_n_covariance_values(record);
+
+        if (n_tags < 0)          return 5;
+        if (n_expectations <= 0) return 5;
+        if ((n_covariance_values != 0)              &
+            (n_covariance_values != n_expectations) &
+            (n_covariance_values != (n_expectations*(n_expectations+1))/2))
+                                 return 5;
+
+        n_double_elements = n_tags + n_expectations + n_covariance_values;
+
+        size_total += sizeof_fixed_l_                          +
+                      sizeof_identifier                        +
+                      sizeof_int_value_                        +
+                      sizeof_double_value_ * n_double_elements +
+                      sizeof_closing_tag_;
+
+        if (active) l_written = true;
+      }
+      else
+      {
+        if (active && (!l_written)) return 3;
+
+        sizeof_identifier = (int)strlen(epoch.get_identifier(record));
+        if (sizeof_identifier < 1) return 4;
+
+        n_parameter_iids   = epoch.get_n_parameter_iids(record);
+        n_observation_iids = epoch.get_n_observation_iids(record);
+        n_instrument_iids  = epoch.get_n_instrument_iids(record);
+
+        if (n_parameter_iids   <= 0) return 7;
+        if (n_observation_iids <= 0) return 7;
+        if (n_instrument_iids  <  0) return 7;
+
+        n_iidentifiers = n_parameter_iids + n_observation_iids + n_instrument_iids;
+
+        size_total += sizeof_fixed_o_                    +
+                      sizeof_identifier                  +
+                      sizeof_int_value_ * n_iidentifiers +
+                      sizeof_closing_tag_;
+      }
+    }
+
+    // Epochs larger than the data buffer are split among several flushes.
+
+    if (size_total > data_buffer_size_) return obs_e_based_file_writer::write_epoch(epoch);
+
+    //
+    // Check if enough room is still left in the data buffer for the whole
+    // epoch. If not, flush the buffer to disk and start storing data again
+    // from its beginning.
+    //
+
+    if ((data_buffer_cur_ + size_total) > data_buffer_size_)
+    {
+      status = flush();
+
+      // I/O error if status is not 0.
+
+      if (status != 0) return 2;
+    }
+
+    // Print the records. Nothing may fail now but I/O operations.
+
+    for (record = 0; record < n_records; record++)
+    {
+      if (epoch.get_type(record) == 'l')
+      {
+        status = store_l_record(epoch.get_active(record),
+                                epoch.get_identifier(record),
+                                epoch.get_instance_id(record),
+                                time,
+                                epoch.get_n_tags(record),
+                                epoch.get_tags(record),
+                                epoch.get_n_expectations(record),
+                                epoch.get_expectations(record),
+                                epoch.get_n_covariance_values(record),
+                                epoch.get_covariance_values(record));
+
+        if (status != 0) return status;
+      }
+      else
+      {
+        store_o_record(epoch.get_active(record),
+                       epoch.get_identifier(record),
+                       time,
+                       epoch.get_n_parameter_iids(record),
+                       epoch.get_parameter_iids(record),
+                       epoch.get_n_observation_iids(record),
+                       epoch.get_observation_iids(record),
+                       epoch.get_n_instrument_iids(record),
+                       epoch.get_instrument_iids(record));
+      }
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 observation_file_writer_txt::
 write_o
@@ -36,15 +295,10 @@ write_o
  int*         the_instrument_iids)
 {
   {
-    int   bytes_written;
-    char  cactive;
-    int   i;
     int   n_iidentifiers;
-    char* pchar;
     int   size_o_record;
     int   sizeof_identifier;
     int   status;
-    int   total_bytes_written;
 
     // Won't work if the file is closed.
 
@@ -121,71 +375,12 @@ write_o
       if (status != 0) return 2;
     }
 
-    //
-    // "Print" to the data buffer the required info.
-    //
-    // This is done in several steps:
-    //
-    // - The o tag (including the active / removed attribute),
-    //   identifier and time tag first,
-    // - the different lists of instance identifiers, using several loops then, and
-    // - the closing o tag plus the newline, to finish.
-    //
-
-    total_bytes_written = 0;
-    pchar = &(data_buffer_[data_buffer_cur_]);
-
-    // o tag, identifier and time tag.
-
-    if (active) cactive = 'a';
-    else        cactive = 'r';
-
-    bytes_written = sprintf(pchar, format_fixed_o_, cactive, identifier, time);
-    total_bytes_written += bytes_written;
-    pchar += bytes_written;
-
-    // The list of parameter instance identifiers
-
-    for (i = 0; i < n_parameter_iids; i++ )
-    {
-      bytes_written = sprintf(pchar, format_default_int_format_, the_parameter_iids[i]);
-      total_bytes_written += bytes_written;
-      pchar+= bytes_written;
-    }
-
-    // The list of observation instance identifiers
-
-    for (i = 0; i < n_observation_iids; i++ )
-    {
-      bytes_written = sprintf(pchar, format_default_int_format_, the_observation_iids[i]);
-      total_bytes_written += bytes_written;
-      pchar+= bytes_written;
-    }
+    // "Print" the record.
 
-    // The list of instrument instance identifiers, if any.
-
-    if (n_instrument_iids > 0)
-    {
-      for (i = 0; i < n_instrument_iids; i++ )
-      {
-        bytes_written = sprintf(pchar, format_default_int_format_, the_instrument_iids[i]);
-        total_bytes_written += bytes_written;
-        pchar+= bytes_written;
-      }
-    }
-
-    //
-    // Closing o tag plus newline. Note that the actual contents of NEWLINE,
-    // a macro defined at the header of this class, will depend on the
-    // operating system used when compiling this code.
-    //
-
-    bytes_written = sprintf(pchar, " </o>%s", NEWLINE);
-    total_bytes_written += bytes_written;
-
-    // Update pointers.
-
-    data_buffer_cur_ += total_bytes_written;
+    store_o_record(active, identifier, time,
+                   n_parameter_iids,   the_parameter_iids,
+                   n_observation_iids, the_observation_iids,
+                   n_instrument_iids,  the_instrument_iids);
 
     // That's all.
 
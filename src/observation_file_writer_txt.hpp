@@ -99,6 +99,65 @@ class observation_file_writer_txt : public obs_e_based_file_writer_txt
                                               int*         the_observation_iids,
                                               int          n_instrument_iids,
                                               int*         the_instrument_iids);
+
+    /**
+     * @brief Write all the l- and o-records of an epoch.
+     *
+     * @param epoch The records to write, in the order these must appear
+     *        in the file.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: File is not open so it is not possible to write.
+     *        - 2: I/O error detected while writing to disk.
+     *        - 3: An active o-record would be the first active record in
+     *             the group sharing the same time tag.
+     *        - 4: An identifier is empty.
+     *        - 5: Invalid number of tags, expectations or covariance values
+     *             in an l-record (see write_l()).
+     *        - 7: Invalid number of instance identifiers in an o-record
+     *             (see write_o()).
+     *
+     * When all the records share the same time tag, the epoch is validated
+     * as a whole before printing anything, so nothing is written if any
+     * record is wrong. Then, the room needed by the epoch is reserved once
+     * and the records are printed one after the other, with no further
+     * checks. The file is the same that write_l() and write_o() would
+     * create.
+     *
+     * Epochs mixing time tags, or too big for the data buffer, are written
+     * record by record (see obs_e_based_file_writer::write_epoch()).
+     */
+
+    virtual int  write_epoch                 (const observation_epoch& epoch);
+
+  protected:
+
+    /**
+     * @brief Store an o-record already validated in the data buffer.
+     *
+     * @param active The o-record is active (true) or removed (false).
+     * @param identifier Identifier of the o-record.
+     * @param time Time tag of the o-record.
+     * @param n_parameter_iids Number of parameter instance identifiers.
+     * @param the_parameter_iids The parameter instance identifiers.
+     * @param n_observation_iids Number of observation instance identifiers.
+     * @param the_observation_iids The observation instance identifiers.
+     * @param n_instrument_iids Number of instrument instance identifiers.
+     * @param the_instrument_iids The instrument instance identifiers.
+     *
+     * The data buffer must have room enough for the record; no checks are
+     * made. o-records never change the flags of the writer.
+     */
+
+    void         store_o_record              (bool          active,
+                                              const char*   identifier,
+                                              double        time,
+                                              int           n_parameter_iids,
+                                              const int*    the_parameter_iids,
+                                              int           n_observation_iids,
+                                              const int*    the_observation_iids,
+                                              int           n_instrument_iids,
+                                              const int*    the_instrument_iids);
 };
 
 #endif // OBSERVATION_FILE_WRITER_TXT_HPP
@@ -5,12 +5,121 @@
 
 #include "observation_reader.hpp"
 
+/// @brief Initial number of slots of the hash table locating the dimensions
+/// of the records (a power of two).
+
+#define _ASTROLABE_OBSERVATION_READER_DIMENSION_SLOTS 16
+
+void
+observation_reader::
+add_read_statistics
+(void)
+{
+  {
+    long long bytes_read;
+    double    seconds;
+
+    file_reader_->get_read_statistics(bytes_read, seconds);
+
+    read_bytes_   += bytes_read;
+    read_seconds_ += seconds;
+  }
+}
+
+void
+observation_reader::
+add_record_dimensions
+(char        type,
+ const char* identifier,
+ const int*  counts,
+ bool        replace)
+{
+  {
+    record_dimensions dimensions;
+    int               first;
+    int               i;
+    int               id_length;
+    unsigned int      mask;
+    int               n_slots;
+    int               position;
+    unsigned int      slot;
+
+    // Already known? Then, replace its dimensions, if asked to.
+
+    position = find_record_dimensions(type, identifier);
+
+    if (position >= 0)
+    {
+      if (replace)
+      {
+        for (i = 0; i < 3; i++) record_dimensions_[position].counts[i] = counts[i];
+      }
+
+      return;
+    }
+
+    // A new kind of record. Its position identifies it from now on.
+
+    for (i = 0; i < 3; i++) dimensions.counts[i] = counts[i];
+
+    dimensions.identifier = identifier;
+    dimensions.type       = type;
+
+    record_dimensions_.push_back(dimensions);
+
+    //
+    // Keep the hash table at most half full, so lookups stay short. When
+    // it grows, every entry is hashed again; otherwise only the new one.
+    //
+
+    first = (int)record_dimensions_.size() - 1;
+
+    if ((2 * record_dimensions_.size()) > record_dimensions_slots_.size())
+    {
+      n_slots = _ASTROLABE_OBSERVATION_READER_DIMENSION_SLOTS;
+      while (n_slots < (int)(4 * record_dimensions_.size())) n_slots *= 2;
+
+      record_dimensions_slots_.assign(n_slots, -1);
+      first = 0;
+    }
+
+    mask = (unsigned int)record_dimensions_slots_.size() - 1;
+
+    for (position = first; position < (int)record_dimensions_.size(); position++)
+    {
+      slot = hash_record_identifier(record_dimensions_[position].type,
+                                    record_dimensions_[position].identifier.c_str()) & mask;
+
+      while (record_dimensions_slots_[slot] != -1) slot = (slot + 1) & mask;
+
+      record_dimensions_slots_[slot] = position;
+    }
+
+    //
+    // Make sure that read_epoch() will be able to read the identifier
+    // (plus its ending NULL character).
+    //
+
+    id_length = (int)strlen(identifier);
+
+    if (id_length >= epoch_identifier_size_)
+    {
+      if (epoch_identifier_ != NULL) delete [] epoch_identifier_;
+
+      epoch_identifier_size_ = id_length + 1;
+      epoch_identifier_      = new char[epoch_identifier_size_];
+      epoch_identifier_[0]   = '\0';
+    }
+  }
+}
+
 int
 observation_reader::
 close
 (void)
 {
   {
+    int i;
     int status;
 
     status = 0;
@@ -33,11 +142,24 @@ close
       if (file_reader_ != NULL)
       {
         status = file_reader_->close();
+        add_read_statistics();
         delete file_reader_;
         file_reader_ = NULL;
       }
+
+      discard_lookahead();
+      discard_next_file_reader();
+    }
+
+    // Release the time indexes, if any.
+
+    for (i = 0; i < (int)time_indexes_.size(); i++)
+    {
+      if (time_indexes_[i] != NULL) delete time_indexes_[i];
     }
 
+    time_indexes_.clear();
+
     data_channel_is_open_ = false;
     return status;
   }
@@ -63,6 +185,44 @@ data_channel_is_socket
   }
 }
 
+void
+observation_reader::
+discard_lookahead
+(void)
+{
+  {
+    // Stop the worker threads of every chunk decoded in advance.
+
+    while (!lookahead_readers_.empty())
+    {
+      lookahead_readers_.front()->close();
+      delete lookahead_readers_.front();
+
+      lookahead_readers_.pop_front();
+    }
+
+    lookahead_status_.clear();
+  }
+}
+
+void
+observation_reader::
+discard_next_file_reader
+(void)
+{
+  {
+    if (next_file_reader_ == NULL) return;
+
+    // Wait for the helper thread, since it's using the reader.
+
+    if (next_file_reader_opener_.joinable()) next_file_reader_opener_.join();
+
+    next_file_reader_->close();
+    delete next_file_reader_;
+    next_file_reader_ = NULL;
+  }
+}
+
 bool
 observation_reader::
 epoch_changed
@@ -83,33 +243,220 @@ epoch_change_acknowledged
   }
 }
 
+void
+observation_reader::
+fill_lookahead
+(void)
+{
+  {
+    string                   chunk_filename;
+    obs_e_based_file_reader* reader;
+
+    if (!lookahead_is_active_) return;
+
+    //
+    // Opening a multithreaded reader starts decoding the chunk right away.
+    // Errors are kept until the chunk is reached, as if it were opened
+    // then.
+    //
+
+    while ((int)lookahead_readers_.size() < chunk_lookahead_)
+    {
+      if (chunk_names_generator_.get_next_filename(chunk_filename) != 0) break;
+
+      reader = new_parallel_file_reader();
+
+      lookahead_status_.push_back(reader->open(chunk_filename.c_str()));
+      lookahead_readers_.push_back(reader);
+    }
+  }
+}
+
+int
+observation_reader::
+find_record_dimensions
+(char        type,
+ const char* identifier)
+const
+{
+  {
+    unsigned int mask;
+    int          position;
+    unsigned int slot;
+
+    if (record_dimensions_slots_.empty()) return -1;
+
+    mask = (unsigned int)record_dimensions_slots_.size() - 1;
+    slot = hash_record_identifier(type, identifier) & mask;
+
+    // Linear probing, up to the first empty slot.
+
+    while ((position = record_dimensions_slots_[slot]) != -1)
+    {
+      if ((record_dimensions_[position].type == type) &&
+          (strcmp(record_dimensions_[position].identifier.c_str(), identifier) == 0)) return position;
+
+      slot = (slot + 1) & mask;
+    }
+
+    return -1;
+  }
+}
+
+obs_e_based_file_reader*
+observation_reader::
+new_file_reader
+(void)
+{
+  obs_e_based_file_reader* reader;
+
+  {
+    observation_file_reader_bin_forward*  bin_forward_reader;
+    bool                                  is_binary_file;
+    observation_file_reader_txt_backward* txt_backward_reader;
+    observation_file_reader_txt_parallel* txt_parallel_reader;
+
+    is_binary_file
+      = (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE);
+
+    if (is_binary_file)
+    {
+      // Binary files.
+      if (is_backwards_mode_set_)
+      {
+        // Reversed, binary file reader.
+        reader = new observation_file_reader_bin_backward();
+      }
+      else
+      {
+        //
+        // Forward, binary file reader. Select its I/O model; if memory maps
+        // are not available, the reader keeps on using buffered reads, so
+        // the error code is ignored.
+        //
+
+        bin_forward_reader = new observation_file_reader_bin_forward();
+        bin_forward_reader->set_memory_mapped(is_memory_mapped_mode_set_);
+        reader = bin_forward_reader;
+      }
+    }
+    else
+    {
+      // Text files.
+      if (is_backwards_mode_set_)
+      {
+        //
+        // Reversed, text file reader. Select its I/O model as done for
+        // forward binary files (errors ignored for the same reasons).
+        //
+
+        txt_backward_reader = new observation_file_reader_txt_backward();
+        txt_backward_reader->set_memory_mapped(is_memory_mapped_mode_set_);
+        reader = txt_backward_reader;
+      }
+      else if (text_threads_ != 1)
+      {
+        // Forward, multithreaded text file reader.
+        txt_parallel_reader = new observation_file_reader_txt_parallel();
+        txt_parallel_reader->set_number_of_threads(text_threads_);
+        reader = txt_parallel_reader;
+      }
+      else
+      {
+        // Forward, text file reader.
+        reader = new observation_file_reader_txt_forward();
+      }
+    }
+
+    // Read ahead, if requested (memory mapped readers ignore this setting).
+
+    reader->set_prefetch(is_prefetch_mode_set_);
+
+    // Region loaded in advance when reading backwards (forward readers ignore it).
+
+    reader->set_reverse_window(reverse_window_size_);
+  }
+
+  return reader;
+}
+
+obs_e_based_file_reader*
+observation_reader::
+new_parallel_file_reader
+(void)
+{
+  obs_e_based_file_reader* reader;
+
+  {
+    observation_file_reader_bin_parallel* bin_parallel_reader;
+    observation_file_reader_txt_parallel* txt_parallel_reader;
+
+    //
+    // Forward readers only. These read ahead by themselves, so neither
+    // memory maps nor prefetching apply.
+    //
+
+    if (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE)
+    {
+      bin_parallel_reader = new observation_file_reader_bin_parallel();
+      bin_parallel_reader->set_number_of_threads(lookahead_threads_);
+      reader = bin_parallel_reader;
+    }
+    else
+    {
+      txt_parallel_reader = new observation_file_reader_txt_parallel();
+      txt_parallel_reader->set_number_of_threads(lookahead_threads_);
+      reader = txt_parallel_reader;
+    }
+  }
+
+  return reader;
+}
+
 observation_reader::
 observation_reader
 (void)
 {
   {
+    chunk_lookahead_             = 0;
     data_channel_is_open_        = false;
     data_channel_is_set_         = false;
     data_channel_is_socket_      = false;
+    epoch_identifier_            = NULL;
+    epoch_identifier_size_       = 0;
+    epoch_record_pending_        = false;
     file_reader_                 = NULL;
     is_backwards_mode_set_       = false;
     is_eof_                      = false;
     is_header_filename_set_      = false;
+    is_memory_mapped_mode_set_   = false;
     is_metadata_read_            = false;
+    is_open_ahead_mode_set_      = false;
+    is_prefetch_mode_set_        = false;
     is_schema_filename_set_      = false;
 
     last_epoch_changed_          = false;
     last_epoch_time_available_   = false;
     last_epoch_time_             = 0;
     last_record_is_active_       = false;
+    lookahead_is_active_         = false;
+    lookahead_threads_           = 0;
+    metadata_.clear();
+    next_file_reader_            = NULL;
+    next_file_reader_status_     = 0;
 
     header_file_                 = "";
     schema_file_                 = "";
 
     socket_reader_               = NULL;
     socket_works_in_server_mode_ = true;
+    text_threads_                = 1;
 
     reading_first_epoch_         = true;
+
+    read_bytes_                  = 0;
+    read_seconds_                = 0;
+    reverse_window_size_         = _ASTROLABE_OBS_E_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE;
   }
 }
 
@@ -122,6 +469,8 @@ observation_reader::
     // Close the reader if still open.
 
     if (data_channel_is_open_) close();
+
+    if (epoch_identifier_ != NULL) delete [] epoch_identifier_;
   }
 }
 
@@ -217,6 +566,16 @@ get_metadata
   }
 }
 
+const lineage_data*
+observation_reader::
+get_lineage
+(void)
+{
+  {
+    return header_data_.get_lineage_ptr();
+  }
+}
+
 int
 observation_reader::
 get_metadata_errors
@@ -264,104 +623,283 @@ get_metadata_warnings
   }
 }
 
-bool
+void
 observation_reader::
-is_eof
-(void)
+get_read_statistics
+(long long& bytes_read,
+ double&    seconds)
 const
 {
   {
-    return is_eof_;
-  }
-}
+    long long chunk_bytes_read;
+    double    chunk_seconds;
 
-bool
-observation_reader::
-is_open
-(void)
-const
-{
-  {
-    return data_channel_is_open_;
+    bytes_read = read_bytes_;
+    seconds    = read_seconds_;
+
+    // Add the statistics of the chunk being read, if any.
+
+    if (file_reader_ != NULL)
+    {
+      file_reader_->get_read_statistics(chunk_bytes_read, chunk_seconds);
+
+      bytes_read += chunk_bytes_read;
+      seconds    += chunk_seconds;
+    }
   }
 }
 
 int
 observation_reader::
-open
-(bool reverse_mode)
+get_time_index
+(int                chunk,
+ epoch_time_index*& index)
 {
   {
+    string                    chunk_filename;
+    long long                 chunk_mtime;
+    long long                 chunk_size;
+    FILE*                     chunk_file;
+    astrolabe_compressed_file chunk_stream;
+    bool                      is_binary_file;
+    string                    index_filename;
+    int                       status;
 
-    string       data_channel_filename;
-    string       chunk_filename;
-    const char*  host;
-    bool         is_binary_file;
-    int          port;
-    int          status;
+    // Make room for the indexes of all the chunks.
 
-    // If the data channel is already open, report an error.
+    if ((int)time_indexes_.size() < chunk_names_generator_.get_number_of_chunks())
+      time_indexes_.resize(chunk_names_generator_.get_number_of_chunks(), NULL);
 
-    if (data_channel_is_open_) return 1;
+    // Already available? Then, we're done.
 
-    // Set internal flags.
+    index = time_indexes_[chunk-1];
+    if (index != NULL) return 0;
 
-    is_backwards_mode_set_ = reverse_mode;
+    // Get the name of the chunk and its index.
 
-    //
-    // Now, check what kind of underlying data channel we are
-    // going to deal with.
-    //
+    status = chunk_names_generator_.get_chunk_filename(chunk, chunk_filename);
+    if (status != 0) return 1;
 
-    if (data_channel_is_socket_)
+    try
     {
-      // Working with sockets.
+      index = new epoch_time_index();
+    }
+    catch (...)
+    {
+      return 1;
+    }
 
-      // We don't accept reverse mode when working with sockets.
+    index_filename = index->get_index_file_name(chunk_filename);
 
-      if (is_backwards_mode_set_) return 8;
+    //
+    // Ascertain the size and modification time of the chunk, so stale
+    // indexes (not matching the data they refer to) are detected. Binary
+    // chunks may be block-compressed; indexes refer then to the
+    // uncompressed data.
+    //
 
-      // Get the host, if any.
+    chunk_mtime = astr_fmtime(chunk_filename.c_str());
 
-      host = NULL;
+    chunk_file = fopen(chunk_filename.c_str(), "rb");
+    if (chunk_file == NULL)
+    {
+      delete index;
+      index = NULL;
+      return 1;
+    }
 
-      if (header_data_.is_set_device_server()) host = (header_data_.get_device_server()).c_str();
+    status = chunk_stream.attach(chunk_file);
 
-      // We must retrieve the port used to connect.
+    chunk_size = chunk_stream.get_size();
 
-      port = header_data_.get_device_port();
+    chunk_stream.detach();
+    fclose(chunk_file);
 
-      // Check that server or client mode plus host and port make the right combination.
+    if (status != 0)
+    {
+      delete index;
+      index = NULL;
+      return 1;
+    }
 
-      if (!socket_works_in_server_mode_)
-      {
-        // We want the socket reader work as a client, that is, starting
-        // itself the connection. Therefore, we need not only a port number
-        // but also a host name or IP addresss...
+    //
+    // Try to load the sidecar index file. If not available (or stale), build
+    // the index scanning the chunk and try to save it for later use. Failing
+    // to save it is not an error; the index will be simply rebuilt next time.
+    //
 
-        if (host == NULL) return 2;
-      }
+    status = index->load(index_filename.c_str(), chunk_size, chunk_mtime);
 
-      // Create the socket reader.
+    if (status != 0)
+    {
+      is_binary_file
+        = (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE);
 
-      try
-      {
-        socket_reader_ = new observation_socket_reader();
-      }
-      catch (...)
+      status = index->build(chunk_filename.c_str(), is_binary_file);
+      if (status != 0)
       {
-        // Unable to open.
-
-        return 2;
+        delete index;
+        index = NULL;
+        return 1;
       }
 
-      // Open the socket connection.
+      index->save(index_filename.c_str());
+    }
 
-      status = socket_reader_->open(host, port, socket_works_in_server_mode_);
+    // Keep the index for later use.
 
-      if (status != 0) return status;
+    time_indexes_[chunk-1] = index;
 
-      // We've opened the underlying data channel!!!
+    // That's all.
+
+    return 0;
+  }
+}
+
+unsigned int
+observation_reader::
+hash_record_identifier
+(char        type,
+ const char* identifier)
+const
+{
+  {
+    unsigned int hash;
+
+    // FNV-1a, over the type and the characters of the identifier.
+
+    hash = 2166136261u;
+
+    hash ^= (unsigned char)type;
+    hash *= 16777619u;
+
+    while (*identifier != '\0')
+    {
+      hash ^= (unsigned char)(*identifier);
+      hash *= 16777619u;
+      identifier++;
+    }
+
+    return hash;
+  }
+}
+
+bool
+observation_reader::
+is_eof
+(void)
+const
+{
+  {
+    return is_eof_;
+  }
+}
+
+bool
+observation_reader::
+is_open
+(void)
+const
+{
+  {
+    return data_channel_is_open_;
+  }
+}
+
+int
+observation_reader::
+open
+(bool reverse_mode,
+ bool memory_mapped,
+ bool prefetch)
+{
+  {
+
+    string      data_channel_filename;
+    int         n_cores;
+    const char* host;
+    int         open_status;
+    int         port;
+    int         status;
+
+    // If the data channel is already open, report an error.
+
+    if (data_channel_is_open_) return 1;
+
+    //
+    // Columnar files do not keep records in epoch order, so these can't be
+    // read sequentially. Use observation_file_reader_col instead.
+    //
+
+    if (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_COLUMNAR_FILE) return 9;
+
+    // Take the dimensions of the records from the metadata, if available.
+
+    set_metadata_dimensions();
+
+    // Set internal flags.
+
+    epoch_record_pending_      = false;
+    is_backwards_mode_set_     = reverse_mode;
+    read_bytes_                = 0;
+    read_seconds_              = 0;
+    is_memory_mapped_mode_set_ = memory_mapped;
+    is_prefetch_mode_set_      = prefetch;
+
+    //
+    // Now, check what kind of underlying data channel we are
+    // going to deal with.
+    //
+
+    if (data_channel_is_socket_)
+    {
+      // Working with sockets.
+
+      // We don't accept reverse mode when working with sockets.
+
+      if (is_backwards_mode_set_) return 8;
+
+      // Get the host, if any.
+
+      host = NULL;
+
+      if (header_data_.is_set_device_server()) host = (header_data_.get_device_server()).c_str();
+
+      // We must retrieve the port used to connect.
+
+      port = header_data_.get_device_port();
+
+      // Check that server or client mode plus host and port make the right combination.
+
+      if (!socket_works_in_server_mode_)
+      {
+        // We want the socket reader work as a client, that is, starting
+        // itself the connection. Therefore, we need not only a port number
+        // but also a host name or IP addresss...
+
+        if (host == NULL) return 2;
+      }
+
+      // Create the socket reader.
+
+      try
+      {
+        socket_reader_ = new observation_socket_reader();
+      }
+      catch (...)
+      {
+        // Unable to open.
+
+        return 2;
+      }
+
+      // Open the socket connection.
+
+      status = socket_reader_->open(host, port, socket_works_in_server_mode_);
+
+      if (status != 0) return status;
+
+      // We've opened the underlying data channel!!!
 
       data_channel_is_open_ = true;
       
@@ -369,16 +907,8 @@ open
     else
     {
       //
-      // We're dealing with files. Now we need to know if we want to read
-      // a text or a binary file.
-      //
-
-      is_binary_file = 
-        (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE);
-
-      //
-      // Retrieve too the name of the "general" external file that will keep (in fact,
-      // possibly split into chunks) the actual data.
+      // We're dealing with files. Retrieve the name of the "general" external
+      // file that will keep (in fact, possibly split into chunks) the actual data.
       //
 
       data_channel_filename = header_data_.get_device_file_name();
@@ -391,59 +921,35 @@ open
       chunk_names_generator_.set_mode_read(data_channel_filename, is_backwards_mode_set_);
 
       //
-      // Get the name of the first chunk (or last, if working in backwards
-      // mode) making the general file. Note that if the next call fails,
-      // it will mean that the actual chunk files are not located in
-      // the same folder than the astrolabe header file or that
-      // these chunks do not exist or that are named incorrectly.
+      // Decode chunks in advance, if asked to (forward readers only). The
+      // cores are shared out among the current chunk and the next ones.
       //
 
-      status = chunk_names_generator_.get_next_filename(chunk_filename);
-      if (status != 0) return 2; // Unable to open data channel.
+      lookahead_is_active_ = ((chunk_lookahead_ > 0) && (!is_backwards_mode_set_));
+      lookahead_threads_   = 0;
 
-      //
-      // Instantiate the appropriate kind of reader depending on the
-      // file type (text or binary) and the read mode (forward or reverse).
-      //
-
-      if (is_binary_file)
+      if (lookahead_is_active_)
       {
-        // Binary files.
-        if (is_backwards_mode_set_)
-        {
-          // Reversed, binary file reader.
-          file_reader_ = new observation_file_reader_bin_backward();
-        }
-        else
-        {
-          // Forward, binary file reader.
-          file_reader_ = new observation_file_reader_bin_forward();
-        }
-      }
-      else
-      {
-        // Text files.
-        if (is_backwards_mode_set_)
-        {
-          // Reversed, text file reader.
-          file_reader_ = new observation_file_reader_txt_backward();
-        }
-        else
-        {
-          // Forward, text file reader.
-          file_reader_ = new observation_file_reader_txt_forward();
-        }
+        n_cores            = (int)thread::hardware_concurrency();
+        lookahead_threads_ = n_cores / (chunk_lookahead_ + 1);
+        if (lookahead_threads_ < 1) lookahead_threads_ = 1;
       }
 
       //
-      // We may now try to open the actual underlying file using
-      // the reader (whatever it is) just created. This should never
-      // fail, since our chunk filenames generator already has checked
-      // that these chunks do exist. However, we'll check...
+      // Open the first chunk (or last, if working in backwards mode) making
+      // the general file. Note that if no chunk is available, it will mean
+      // that the actual chunk files are not located in the same folder than
+      // the astrolabe header file or that these chunks do not exist or that
+      // are named incorrectly.
+      //
+      // Opening the chunk should never fail, since our chunk filenames
+      // generator already has checked that these chunks do exist. However,
+      // we'll check...
       //
 
-      status = file_reader_->open(chunk_filename.c_str());
-      if (status != 0) return status;
+      status = open_next_chunk(open_status);
+      if (status == 1) return 2; // Unable to open data channel.
+      if (status != 0) return open_status;
 
       // We've opened the underlying data channel!!!
 
@@ -457,6 +963,98 @@ open
   }
 }
 
+int
+observation_reader::
+open_next_chunk
+(int& open_status)
+{
+  {
+    string chunk_filename;
+
+    open_status = 0;
+
+    //
+    // With a chunk lookahead, the reader of the next chunk is already
+    // decoding it. Refill the lookahead once taken, so the decoding of the
+    // chunk following the last one in it starts now.
+    //
+
+    if (lookahead_is_active_)
+    {
+      fill_lookahead();
+
+      if (lookahead_readers_.empty()) return 1;
+
+      file_reader_ = lookahead_readers_.front();
+      open_status  = lookahead_status_.front();
+
+      lookahead_readers_.pop_front();
+      lookahead_status_.pop_front();
+
+      fill_lookahead();
+
+      return (open_status == 0) ? 0 : 2;
+    }
+
+    //
+    // The next chunk may be already open, or being opened, in the
+    // background. Wait for it, if needed, and start opening the one
+    // following it.
+    //
+
+    if (next_file_reader_ != NULL)
+    {
+      if (next_file_reader_opener_.joinable()) next_file_reader_opener_.join();
+
+      file_reader_      = next_file_reader_;
+      open_status       = next_file_reader_status_;
+      next_file_reader_ = NULL;
+
+      if (open_status != 0) return 2;
+
+      start_next_file_reader();
+
+      return 0;
+    }
+
+    //
+    // Generate the name for the next chunk. If we've got an error here, it
+    // means that there are no more files to read.
+    //
+
+    if (chunk_names_generator_.get_next_filename(chunk_filename) != 0) return 1;
+
+    //
+    // Instantiate the appropriate kind of reader depending on the
+    // file type (text or binary) and the read mode (forward or reverse),
+    // and open the chunk.
+    //
+
+    file_reader_ = new_file_reader();
+
+    open_status = file_reader_->open(chunk_filename.c_str());
+    if (open_status != 0) return 2;
+
+    // Open the following chunk while this one is read, if so requested.
+
+    start_next_file_reader();
+
+    return 0;
+  }
+}
+
+void
+observation_reader::
+open_next_file_reader
+(void)
+{
+  {
+    // Runs in the helper thread. Nobody else touches the reader meanwhile.
+
+    next_file_reader_status_ = next_file_reader_->open(next_chunk_filename_.c_str());
+  }
+}
+
 int
 observation_reader::
 read_active_flag
@@ -484,6 +1082,178 @@ read_active_flag
   }
 }
 
+int
+observation_reader::
+read_epoch
+(observation_epoch& epoch)
+{
+  {
+    bool   active;
+    int    dimensions;
+    int    instance_id;
+    int    status;
+    double time;
+    char   type;
+
+    epoch.clear();
+
+    if (!data_channel_is_open_) return 2;
+
+    // Once the end of data is reached, there are no underlying readers left.
+
+    if (is_eof_) return 1;
+
+    //
+    // The first record of this epoch may have been left half read (all but
+    // its data) by the previous call, since epoch changes may be detected
+    // only after reading the time of the first record of the new epoch.
+    // Complete it.
+    //
+
+    if (epoch_record_pending_)
+    {
+      epoch_record_pending_ = false;
+
+      status = read_epoch_record_data(epoch,
+                                      epoch_record_pending_type_,
+                                      epoch_record_pending_active_,
+                                      epoch_record_pending_iid_,
+                                      epoch_record_pending_time_,
+                                      epoch_record_pending_dimensions_);
+      if (status != 0) return status;
+    }
+
+    // Read records until the epoch changes or no more data is available.
+
+    while (true)
+    {
+      status = read_type(type);
+      if (status != 0)
+      {
+        // The end of data also ends the last epoch.
+
+        if (is_eof_) return (epoch.get_n_records() == 0) ? 1 : 0;
+
+        return 4;
+      }
+
+      if (read_active_flag(active) != 0) return 4;
+
+      //
+      // Identifiers longer than the buffer can't have their dimensions set,
+      // so these are reported as unknown.
+      //
+
+      status = read_identifier(epoch_identifier_, epoch_identifier_size_);
+
+      if (status == 4) return 3;
+      if (status != 0) return 4;
+
+      // Find the dimensions of the record.
+
+      dimensions = find_record_dimensions(type, epoch_identifier_);
+      if (dimensions < 0) return 3;
+
+      // Instance identifiers exist only in l-records.
+
+      instance_id = 0;
+
+      if (type == 'l')
+      {
+        if (read_instance_id(instance_id) != 0) return 4;
+      }
+
+      if (read_time(time) != 0) return 4;
+
+      //
+      // A new epoch? Then this record belongs to the next one. Keep it,
+      // half read, until we're called again.
+      //
+
+      if (active && last_epoch_changed_ && (epoch.get_n_records() > 0))
+      {
+        epoch_record_pending_            = true;
+        epoch_record_pending_active_     = active;
+        epoch_record_pending_dimensions_ = dimensions;
+        epoch_record_pending_iid_        = instance_id;
+        epoch_record_pending_time_       = time;
+        epoch_record_pending_type_       = type;
+
+        return 0;
+      }
+
+      // Same epoch. Read the data.
+
+      status = read_epoch_record_data(epoch, type, active, instance_id, time,
+                                      dimensions);
+      if (status != 0) return status;
+    }
+  }
+}
+
+int
+observation_reader::
+read_epoch_record_data
+(observation_epoch& epoch,
+ char               type,
+ bool               active,
+ int                instance_id,
+ double             time,
+ int                dimensions)
+{
+  {
+    const int*  counts;
+    double*     covariance_values;
+    double*     expectations;
+    const char* identifier;
+    int*        instrument_iids;
+    int         n_covariance_values;
+    int*        observation_iids;
+    int*        parameter_iids;
+    double*     tags;
+
+    //
+    // The identifier is the one kept with the dimensions, so the record
+    // does not depend on the contents of epoch_identifier_ (the first
+    // record of the next epoch may have been left half read).
+    //
+
+    counts     = record_dimensions_[dimensions].counts;
+    identifier = record_dimensions_[dimensions].identifier.c_str();
+
+    if (type == 'l')
+    {
+      //
+      // Read the values directly into the epoch's storage. Covariances
+      // are given room for the worst case; the unused part is given back
+      // once their actual number is known.
+      //
+
+      epoch.new_l_record(active, identifier, instance_id, time,
+                         counts[0], counts[1],
+                         tags, expectations, covariance_values);
+
+      if (read_l_data(counts[0],           tags,
+                      counts[1],           expectations,
+                      n_covariance_values, covariance_values) != 0) return 4;
+
+      epoch.set_n_covariance_values(n_covariance_values);
+    }
+    else
+    {
+      epoch.new_o_record(active, identifier, time,
+                         counts[0], counts[1], counts[2],
+                         parameter_iids, observation_iids, instrument_iids);
+
+      if (read_o_data(counts[0], parameter_iids,
+                      counts[1], observation_iids,
+                      counts[2], instrument_iids) != 0) return 4;
+    }
+
+    return 0;
+  }
+}
+
 int
 observation_reader::
 read_identifier
@@ -536,6 +1306,36 @@ read_l_data
   }
 }
 
+int
+observation_reader::
+read_l_data_view
+(int                    n_tag_values,
+ astrolabe_double_view& the_tags,
+ int                    n_expectation_values,
+ astrolabe_double_view& the_expectations,
+ int&                   n_covariance_values_found,
+ astrolabe_double_view& the_covariance_values)
+{
+  {
+    if (data_channel_is_socket_)
+    {
+      // Sockets.
+
+      return socket_reader_->read_l_data_view(n_tag_values,              the_tags,
+                                              n_expectation_values,      the_expectations,
+                                              n_covariance_values_found, the_covariance_values);
+    }
+    else
+    {
+      // Files.
+
+      return file_reader_->read_l_data_view(n_tag_values,              the_tags,
+                                            n_expectation_values,      the_expectations,
+                                            n_covariance_values_found, the_covariance_values);
+    }
+  }
+}
+
 int
 observation_reader::
 read_instance_id
@@ -587,6 +1387,36 @@ read_o_data
   }
 }
 
+int
+observation_reader::
+read_o_data_view
+(int                 n_parameter_iids,
+ astrolabe_int_view& the_parameter_iids,
+ int                 n_observation_iids,
+ astrolabe_int_view& the_observation_iids,
+ int                 n_instrument_iids,
+ astrolabe_int_view& the_instrument_iids)
+{
+  {
+    if (data_channel_is_socket_)
+    {
+      // Sockets.
+
+      return socket_reader_->read_o_data_view (n_parameter_iids,   the_parameter_iids,
+                                               n_observation_iids, the_observation_iids,
+                                               n_instrument_iids,  the_instrument_iids);
+    }
+    else
+    {
+      // Files.
+
+      return file_reader_->read_o_data_view (n_parameter_iids,   the_parameter_iids,
+                                             n_observation_iids, the_observation_iids,
+                                             n_instrument_iids,  the_instrument_iids);
+    }
+  }
+}
+
 int
 observation_reader::
 read_time
@@ -676,9 +1506,8 @@ read_type
 (char& record_type)
 {
   {
-    string chunk_filename;
-    bool   is_binary_file;
-    int    status;
+    int open_status;
+    int status;
 
     if (data_channel_is_socket_)
     {
@@ -726,69 +1555,28 @@ read_type
         //
 
         status = file_reader_->close();
-        
+        add_read_statistics();
+
         delete file_reader_;
         file_reader_ = NULL;
 
         if (status != 0) return 7;
 
         //
-        // Generate the name for the next chunk.
+        // Open the next chunk.
         //
-        // If we've got an error here, it means that there are no more files
-        // to read, so we'll return the end-of-file condition.
+        // If there are no more files to read, we'll return the end-of-file
+        // condition. If opening it fails, we'll return an "error closing /
+        // opening current / next chunk".
         //
 
-        status = chunk_names_generator_.get_next_filename(chunk_filename);
-        if (status != 0)
+        status = open_next_chunk(open_status);
+        if (status == 1)
         {
           is_eof_ = true;
           return 1; // End of file (no more chunks are available).
         }
 
-        //
-        // Instantiate the appropriate kind of reader depending on the
-        // file type (text or binary) and the read mode (forward or reverse).
-        //
-
-        is_binary_file
-          = (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE);
-
-        if (is_binary_file)
-        {
-          // Binary files.
-          if (is_backwards_mode_set_)
-          {
-            // Reversed, binary file reader.
-            file_reader_ = new observation_file_reader_bin_backward();
-          }
-          else
-          {
-            // Forward, binary file reader.
-            file_reader_ = new observation_file_reader_bin_forward();
-          }
-        }
-        else
-        {
-          // Text files.
-          if (is_backwards_mode_set_)
-          {
-            // Reversed, text file reader.
-            file_reader_ = new observation_file_reader_txt_backward();
-          }
-          else
-          {
-            // Forward, text file reader.
-            file_reader_ = new observation_file_reader_txt_forward();
-          }
-        }
-
-        //
-        // Open the new chunk. If this fails, we'll return an
-        // "error closing / opening current / next chunk".
-        //
-
-        status = file_reader_->open(chunk_filename.c_str());
         if (status != 0) return 7;
 
         //
@@ -813,6 +1601,240 @@ read_type
   }
 }
 
+int
+observation_reader::
+seek_to_time
+(double time)
+{
+  {
+    int               chunk;
+    string            chunk_filename;
+    double            first_time;
+    bool              found;
+    int               i;
+    epoch_time_index* index;
+    double            last_time;
+    int               n_chunks;
+    long long         n_records;
+    long long         offset;
+    int               position;
+    int               status;
+
+    // The data channel must be open.
+
+    if (!data_channel_is_open_) return 2;
+
+    // Sockets can't be repositioned.
+
+    if (data_channel_is_socket_) return 3;
+
+    //
+    // Look for the chunk containing the requested epoch. Chunks are visited
+    // in reading order; since time tags grow monotonically along the whole
+    // data set, the first chunk having a suitable epoch is the right one.
+    //
+    // Forward readers need the offset where the epoch starts, while
+    // backwards readers need the one where it ends (see
+    // obs_e_based_file_reader::seek_epoch_boundary()).
+    //
+    // When the chunk manifest records the time range of every chunk (see
+    // observation_writer::set_chunk_manifest()), chunks that can't hold
+    // the epoch are skipped without loading their indexes, so only the
+    // index of the right chunk is read.
+    //
+
+    n_chunks = chunk_names_generator_.get_number_of_chunks();
+    found    = false;
+    index    = NULL;
+    offset   = 0;
+    chunk    = 0;
+
+    for (i = 1; i <= n_chunks; i++)
+    {
+      if (is_backwards_mode_set_) chunk = n_chunks - i + 1;
+      else                        chunk = i;
+
+      if (chunk_names_generator_.get_chunk_time_range(chunk, first_time, last_time, n_records) == 0)
+      {
+        if (n_records == 0) continue;
+
+        if (is_backwards_mode_set_)
+        {
+          if ((first_time > time) && (last_time > time)) continue;
+        }
+        else
+        {
+          if ((first_time < time) && (last_time < time)) continue;
+        }
+      }
+
+      status = get_time_index(chunk, index);
+      if (status != 0) return 4;
+
+      if (is_backwards_mode_set_)
+      {
+        if (index->find_epoch_before(time, position) == 0)
+        {
+          found  = true;
+          offset = index->get_end_offset(position);
+          break;
+        }
+      }
+      else
+      {
+        if (index->find_epoch_after(time, position) == 0)
+        {
+          found  = true;
+          offset = index->get_offset(position);
+          break;
+        }
+      }
+    }
+
+    //
+    // If no epoch is found, position the reader at the end of the data, that
+    // is, at the end of the last chunk (forward) or at the beginning of the
+    // first one (backwards). The next read will raise an end-of-file.
+    // The index of the last chunk may not be loaded yet if it was skipped.
+    //
+
+    if (!found)
+    {
+      if (is_backwards_mode_set_)
+      {
+        offset = 0;
+      }
+      else
+      {
+        if (get_time_index(chunk, index) != 0) return 4;
+
+        offset = index->get_data_size();
+      }
+    }
+
+    //
+    // Replace the current reader by a new one reading the selected chunk.
+    // The chunks decoded in advance, if any, are not the next ones any
+    // longer.
+    //
+
+    discard_lookahead();
+    discard_next_file_reader();
+
+    if (file_reader_ != NULL)
+    {
+      status = file_reader_->close();
+      add_read_statistics();
+
+      delete file_reader_;
+      file_reader_ = NULL;
+
+      if (status != 0) return 5;
+    }
+
+    status = chunk_names_generator_.get_chunk_filename(chunk, chunk_filename);
+    if (status != 0) return 5;
+
+    file_reader_ = new_file_reader();
+
+    //
+    // Empty chunks (open() code 4) are legal; these can only be selected when
+    // no epoch is found and are already positioned at their end.
+    //
+
+    status = file_reader_->open(chunk_filename.c_str());
+    if ((status != 0) && (status != 4)) return 5;
+
+    //
+    // The next chunks to read are those following (preceding) the selected
+    // one. Start decoding these in advance, if asked to.
+    //
+
+    chunk_names_generator_.set_current_chunk(chunk);
+
+    fill_lookahead();
+    start_next_file_reader();
+
+    // Move to the epoch found.
+
+    if (status == 0)
+    {
+      status = file_reader_->seek_epoch_boundary(offset);
+      if (status != 0) return 5;
+    }
+
+    // We're starting to read again. Reset our own flags.
+
+    epoch_record_pending_      = false;
+    is_eof_                    = false;
+    last_epoch_changed_        = false;
+    last_epoch_time_available_ = false;
+    last_record_is_active_     = false;
+    reading_first_epoch_       = true;
+
+    // That's all.
+
+    if (!found) return 1;
+
+    return 0;
+  }
+}
+
+int
+observation_reader::
+set_chunk_lookahead
+(int n_chunks)
+{
+  {
+    // The lookahead is set up when opening the data channel.
+
+    if (data_channel_is_open_) return 1;
+    if (n_chunks < 0)          return 2;
+
+    chunk_lookahead_ = n_chunks;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_reader::
+set_chunk_manifest
+(bool enabled)
+{
+  {
+    // The chunks are looked for when opening the data channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (chunk_names_generator_.set_manifest_cache(enabled) != 0) return 1;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_reader::
+set_chunk_open_ahead
+(bool enabled)
+{
+  {
+    // Chunks are opened once the data channel is.
+
+    if (data_channel_is_open_) return 1;
+
+    is_open_ahead_mode_set_ = enabled;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 observation_reader::
 set_data_channel
@@ -884,6 +1906,174 @@ set_header_file
   }
 }
 
+int
+observation_reader::
+set_l_record_dimensions
+(const char* identifier,
+ int         n_tag_values,
+ int         n_expectation_values)
+{
+  {
+    int counts[3];
+
+    if (identifier == NULL)        return 1;
+    if (identifier[0] == '\0')     return 1;
+
+    if (n_tag_values < 0)          return 2;
+    if (n_expectation_values <= 0) return 2;
+
+    // Keep the dimensions.
+
+    counts[0] = n_tag_values;
+    counts[1] = n_expectation_values;
+    counts[2] = 0;
+
+    add_record_dimensions('l', identifier, counts, true);
+
+    return 0;
+  }
+}
+
+int
+observation_reader::
+set_metadata
+(gp_metadata& metadata)
+{
+  {
+    if (data_channel_is_open_) return 1;
+
+    metadata_.push_back(&metadata);
+
+    return 0;
+  }
+}
+
+void
+observation_reader::
+set_metadata_dimensions
+(void)
+{
+  {
+    int      counts[3];
+    int      i;
+    size_t   j;
+    gp_lspec lspec;
+    gp_mspec mspec;
+    int      n_lspecs;
+    int      n_mspecs;
+    string   type;
+
+    //
+    // Dimensions set explicitly are kept. Specifications with invalid
+    // dimensions are skipped; read_epoch() will report their records as
+    // unknown.
+    //
+
+    for (j = 0; j < metadata_.size(); j++)
+    {
+      n_lspecs = metadata_[j]->get_dim_lspec();
+
+      for (i = 0; i < n_lspecs; i++)
+      {
+        lspec = metadata_[j]->get_lspec(i);
+        type  = lspec.get_type();
+
+        counts[0] = lspec.get_tspec_ptr()->get_dimension();
+        counts[1] = lspec.get_dimension();
+        counts[2] = 0;
+
+        if (type.empty() || (counts[0] < 0) || (counts[1] <= 0)) continue;
+
+        add_record_dimensions('l', type.c_str(), counts, false);
+      }
+
+      n_mspecs = metadata_[j]->get_dim_mspec();
+
+      for (i = 0; i < n_mspecs; i++)
+      {
+        mspec = metadata_[j]->get_mspec(i);
+        type  = mspec.get_type();
+
+        counts[0] = mspec.get_plist_ptr()->get_dim();
+        counts[1] = mspec.get_llist_ptr()->get_dim();
+        counts[2] = mspec.get_ilist_ptr()->get_dim();
+
+        if (type.empty() || (counts[0] <= 0) || (counts[1] <= 0) || (counts[2] < 0)) continue;
+
+        add_record_dimensions('o', type.c_str(), counts, false);
+      }
+    }
+  }
+}
+
+int
+observation_reader::
+set_number_of_threads
+(int n_threads)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+    if (n_threads < 0)         return 2;
+
+    text_threads_ = n_threads;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_reader::
+set_o_record_dimensions
+(const char* identifier,
+ int         n_parameter_iids,
+ int         n_observation_iids,
+ int         n_instrument_iids)
+{
+  {
+    int counts[3];
+
+    if (identifier == NULL)      return 1;
+    if (identifier[0] == '\0')   return 1;
+
+    if (n_parameter_iids   <= 0) return 2;
+    if (n_observation_iids <= 0) return 2;
+    if (n_instrument_iids  <  0) return 2;
+
+    // Keep the dimensions.
+
+    counts[0] = n_parameter_iids;
+    counts[1] = n_observation_iids;
+    counts[2] = n_instrument_iids;
+
+    add_record_dimensions('o', identifier, counts, true);
+
+    return 0;
+  }
+}
+
+int
+observation_reader::
+set_reverse_window
+(long long window_size)
+{
+  {
+    // The file readers are set up when opening the data channel.
+
+    if (data_channel_is_open_) return 1;
+    if (window_size < 0)       return 2;
+
+    reverse_window_size_ = window_size;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 observation_reader::
 set_schema_file
@@ -914,3 +2104,38 @@ set_schema_file
 
   }
 }
+
+void
+observation_reader::
+start_next_file_reader
+(void)
+{
+  {
+    // Only when requested. Chunk lookaheads open their own readers.
+
+    if (!is_open_ahead_mode_set_ || lookahead_is_active_) return;
+
+    if (next_file_reader_ != NULL) return;
+
+    // No more chunks, no more readers.
+
+    if (chunk_names_generator_.get_next_filename(next_chunk_filename_) != 0) return;
+
+    next_file_reader_        = new_file_reader();
+    next_file_reader_status_ = 0;
+
+    //
+    // Open it in a helper thread. Should the thread be impossible to start,
+    // open it right now; it will be ready anyway when needed.
+    //
+
+    try
+    {
+      next_file_reader_opener_ = thread(&observation_reader::open_next_file_reader, this);
+    }
+    catch (...)
+    {
+      open_next_file_reader();
+    }
+  }
+}
@@ -9,17 +9,25 @@
 #include "observation_socket_reader.hpp"
 #include "observation_file_reader_bin_backward.hpp"
 #include "observation_file_reader_bin_forward.hpp"
+#include "observation_file_reader_bin_parallel.hpp"
 #include "observation_file_reader_txt_backward.hpp"
 #include "observation_file_reader_txt_forward.hpp"
+#include "observation_file_reader_txt_parallel.hpp"
 
 #include "gp_utils.hpp"
 #include "gp_astrolabe_header_file_parser.hpp"
+#include "gp_metadata.hpp"
 
 #include "segmented_file_utils.hpp"
+#include "epoch_time_index.hpp"
+#include "observation_epoch.hpp"
 
 
+#include <deque>
 #include <list>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
@@ -89,6 +97,12 @@ using namespace std;
        read_o_data() correspondingly to obtain the specific data for
        each kind of record.
        to call 
+   - Alternatively, the loop may read a whole epoch per iteration using
+     read_epoch(), that returns all its records at once in an
+     observation_epoch object. The dimensions of every kind of record
+     are taken from the metadata (see set_metadata()) or set one by one
+     (see set_l_record_dimensions() and set_o_record_dimensions()).
+     Both ways of reading may not be mixed.
    - Once out of the read loop, call close() to close the reader.
    - Destroy the reader (this is not necessary, of course, if it was
      instantiated automatically).
@@ -201,6 +215,19 @@ class observation_reader
 
     void                 epoch_change_acknowledged (void);
 
+    /**
+     * @brief Get the lineage found in the ASTROLABE header file.
+     *
+     * @return The lineage of the header file set by set_header_file(). It
+     *         is owned by the reader and must not be deleted.
+     *
+     * Applications copying data from one channel to another (see, for
+     * instance, observation_file_converter) use it to describe the output
+     * channel the same way the input one was.
+     */
+
+    const lineage_data*  get_lineage               (void);
+
     /**
      * @brief Get the list of errors that have been detected when retrieving
      *        the ASTROLABE header file metadata.
@@ -253,6 +280,27 @@ class observation_reader
 
     int                  get_metadata_warnings     (list<string>& list_of_warnings);
 
+    /**
+     * @brief Retrieve the amount of data read from the chunk files and the
+     *        time spent doing so.
+     *
+     * @param bytes_read Number of bytes read from the chunk files to fill
+     *        the internal buffers of the file readers.
+     * @param seconds Time, in seconds, the calling module has been blocked
+     *        waiting for these bytes.
+     *
+     * The quotient of both values is the throughput achieved, which lets
+     * calling modules compare, for instance, forward and backward passes
+     * over the same data (see set_reverse_window()). Statistics add up
+     * those of the file readers of every chunk read since open() (see
+     * obs_e_based_file_reader::get_read_statistics()) and are kept after
+     * close(). Memory mapped and multithreaded readers, and socket data
+     * channels, report zero bytes.
+     */
+
+    void                 get_read_statistics       (long long& bytes_read,
+                                                    double&    seconds) const;
+
 
     /**
      * @brief Check if the data in the observation channel has been completely read.
@@ -300,6 +348,12 @@ class observation_reader
      * @brief Opens the underlying data channel, enabling I/O operations.
      *
      * @param reverse_mode Open the data channel to read it in reverse mode.
+     * @param memory_mapped Read files through memory maps instead
+     *        of copying them to internal buffers. Only applies to forward,
+     *        binary and reverse, text file channels; ignored otherwise.
+     * @param prefetch Read the chunks of data files in advance, in a helper
+     *        thread. Only applies to buffered file channels; ignored
+     *        otherwise.
      * @return Error code. Error code values:
      *        - 0: Successful completion.
      *        - 1: The data channel was already open.
@@ -317,6 +371,8 @@ class observation_reader
      *        - 6: Malformed records found.
      *        - 7: Internal buffer too small to read data.
      *         -8: Reverse mode not allowed in socket data channels.
+     *        - 9: The data channel is a columnar file (see the
+     *             observation_file_reader_col class to read it).
      *
      * Once a reader has been instantiated, and the metadata included in
      * the input ASTROLABE header file loaded, it is possible to open
@@ -333,9 +389,28 @@ class observation_reader
      * data_channel_is_file() or data_channel_is_socket() should be
      * called prior to invoking open().
      *
+     * When reading binary files in forward mode, or text files in reverse
+     * mode, it is also possible to ask the reader to map these in memory (see
+     * parameter memory_mapped). Records are then decoded straight from the
+     * mapped pages, avoiding the copies needed to fill the internal buffers.
+     * This is specially convenient when reading very big files. Error codes and epoch semantics
+     * are exactly the same no matter the value of this parameter. Should
+     * memory maps not be available (either because of the platform or
+     * because a particular file can not be mapped) the reader reverts
+     * to the regular, buffered I/O model.
+     *
+     * File readers fill their internal buffers chunk after chunk, waiting
+     * for each chunk to be read from disk. It is possible to ask them to
+     * read the next chunk (the previous one in reverse mode) in a helper
+     * thread while the application processes the current one (see parameter
+     * prefetch). This overlaps I/O and decoding, at the cost of one more
+     * buffer per file. Error codes and epoch semantics do not change.
+     *
      */
 
-    int                  open                      (bool reverse_mode=false);
+    int                  open                      (bool reverse_mode=false,
+                                                    bool memory_mapped=false,
+                                                    bool prefetch=false);
 
     /**
      * @brief Reads the active flag for either l- or o-records.
@@ -360,6 +435,51 @@ class observation_reader
 
     int                  read_active_flag          (bool&       active);
 
+    /**
+     * @brief Read all the l- and o-records in the next epoch at once.
+     *
+     * @param epoch On output, the records in the epoch. Its buffers are
+     *        reused, so passing the same object again and again avoids
+     *        allocating memory for each epoch.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: End of file (no more data). The epoch is empty.
+     *         - 2: The observation channel has not been opened.
+     *         - 3: A record whose identifier has no dimensions set
+     *              (see set_metadata(), set_l_record_dimensions() and
+     *              set_o_record_dimensions()) has been found.
+     *         - 4: Error reading a record. Any of the errors reported
+     *              by the read_* methods reading single fields; for
+     *              instance, I/O errors, malformed records, or records
+     *              whose number of values does not match the dimensions
+     *              set for their identifier.
+     *
+     * This method replaces the whole read_type(), read_active_flag(),
+     * read_identifier(), read_instance_id(), read_time() and read_l_data()
+     * or read_o_data() sequence for all the records in an epoch, returning
+     * these in the struct-of-arrays layout of observation_epoch. See
+     * the description of such class.
+     *
+     * Since the number of tags, expectations and instance identifiers in
+     * the records is not stored in text files, the reader must be told the
+     * dimensions of each kind of record before calling this method. The
+     * simplest way is to hand the metadata describing the records over
+     * using set_metadata(); set_l_record_dimensions() and
+     * set_o_record_dimensions() set (or override) them one by one.
+     *
+     * An epoch change may be detected only after reading the time of the
+     * first record of the new epoch. Such record is kept, half read, until
+     * the next call to read_epoch(). Therefore, once this method has been
+     * used, records must NOT be read using the single field methods any
+     * longer (except after calling seek_to_time(), that discards any
+     * half read record).
+     *
+     * Inactive records are returned with the epoch they are found in; as
+     * with the single field methods, they never raise epoch changes.
+     */
+
+    int                  read_epoch                (observation_epoch& epoch);
+
     /**
      * @brief Reads the identifier field for either l- or o-records.
      *
@@ -499,6 +619,44 @@ class observation_reader
                                                     int&     n_covariance_values_found,
                                                     double*& the_covariance_values);
 
+    /**
+     * @brief Read the tags, expectations and covariance matrix values
+     *        in an l-record as read-only views, with no copies into
+     *        caller-provided arrays.
+     *
+     * @param n_tag_values Number of tag values that must be read from
+     *        the l-record. May be zero, since tags are optional.
+     * @param the_tags On output, view of the n_tag_values tags.
+     * @param n_expectation_values Number of expectation values that must be
+     *        read from the l-record. Must be greater than 0.
+     * @param the_expectations On output, view of the n_expectation_values
+     *        expectations.
+     * @param n_covariance_values_found Actual number of covariance matrix
+     *        values found in the l-record (0, n or (n * (n + 1))/2).
+     * @param the_covariance_values On output, view of the
+     *        n_covariance_values_found covariance matrix values.
+     * @return Error code. The same ones returned by read_l_data().
+     *
+     * This method may replace read_l_data() at exactly the same point
+     * of the reading sequence. The views point to memory owned by the
+     * reader and remain valid ONLY until the next call to read_type();
+     * values needed for longer must be copied by the calling module.
+     *
+     * When reading forward binary files, the views point directly into the
+     * reader's data buffer, so the record is not copied when read. Records
+     * are packed, so the values are not necessarily aligned there; views
+     * fetch them one at a time when accessed (see astrolabe_double_view).
+     * Other channels stage the values in an internal scratch area reused
+     * from record to record.
+     */
+
+    int                  read_l_data_view          (int                    n_tag_values,
+                                                    astrolabe_double_view& the_tags,
+                                                    int                    n_expectation_values,
+                                                    astrolabe_double_view& the_expectations,
+                                                    int&                   n_covariance_values_found,
+                                                    astrolabe_double_view& the_covariance_values);
+
     /**
      * @brief Read the lists of parameter, observation and instrument instance
      *        identifiers from an o-record.
@@ -562,6 +720,36 @@ class observation_reader
                                                     int   n_instrument_iids,
                                                     int*& the_instrument_iids);
 
+    /**
+     * @brief Read the lists of parameter, observation and instrument instance
+     *        identifiers from an o-record as read-only views, with no copies
+     *        into caller-provided arrays.
+     *
+     * @param n_parameter_iids Total number of parameter instance identifiers
+     *        to read. Must be greater than 0.
+     * @param the_parameter_iids On output, view of the parameter instance
+     *        identifiers.
+     * @param n_observation_iids Total number of observation instance identifiers
+     *        to read. Must be greater than 0.
+     * @param the_observation_iids On output, view of the observation instance
+     *        identifiers.
+     * @param n_instrument_iids Total number of instrument instance identifiers
+     *        to read. May be zero.
+     * @param the_instrument_iids On output, view of the instrument instance
+     *        identifiers.
+     * @return Error code. The same ones returned by read_o_data().
+     *
+     * This method may replace read_o_data(). As in read_l_data_view(), the
+     * views remain valid only until the next call to read_type().
+     */
+
+    int                  read_o_data_view          (int                 n_parameter_iids,
+                                                    astrolabe_int_view& the_parameter_iids,
+                                                    int                 n_observation_iids,
+                                                    astrolabe_int_view& the_observation_iids,
+                                                    int                 n_instrument_iids,
+                                                    astrolabe_int_view& the_instrument_iids);
+
     /**
      * @brief Read the time tag, either for l- or o-records.
      *
@@ -660,6 +848,136 @@ class observation_reader
 
     int                  read_type                 (char& record_type);
 
+    /**
+     * @brief Position the reader at the epoch closest to a given time.
+     *
+     * @param time The time to look for.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: No epoch found. When reading forward, all the epochs are
+     *             older than time; when reading backwards, all of them are
+     *             newer. The reader is left at the end of the data, so the
+     *             next call to read_type() will report an end-of-file
+     *             condition.
+     *        - 2: The data channel is not open.
+     *        - 3: Operation not available on socket data channels.
+     *        - 4: Unable to load or build the time index of a chunk.
+     *        - 5: Error while closing / opening / positioning a chunk file.
+     *
+     * When reading forward, the reader is positioned at the first epoch
+     * whose time tag is greater or equal than time. When reading backwards,
+     * it is positioned at the last epoch whose time tag is lesser or equal
+     * than time, so the next record read is the last one of that epoch.
+     * In both cases, the reading process continues normally from there,
+     * including the rest of chunks, if any.
+     *
+     * The epoch is located in O(log n) using the time index of the chunk
+     * files (see epoch_time_index). Indexes are read from their sidecar
+     * files when these exist and match the data (see
+     * observation_writer::set_time_index()). Otherwise, these are built
+     * on demand, scanning the chunk once, and saved for later use if
+     * possible. Indexes are kept in memory until the reader is closed.
+     * When the data set has a chunk manifest recording the time range of
+     * every chunk (see observation_writer::set_chunk_manifest()), the
+     * chunk holding the epoch is found from it, so the indexes of the rest
+     * of chunks are neither read nor built.
+     *
+     * This method may be called at any moment after open(), as long as no
+     * record is being read (that is, whenever read_type() could be called).
+     */
+
+    int                  seek_to_time              (double time);
+
+    /**
+     * @brief Decode the chunks following the current one in advance.
+     *
+     * @param n_chunks Number of chunks, following the one being read,
+     *        to decode in advance. 0 disables the lookahead.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel has already been opened.
+     *        - 2: Invalid number of chunks (negative).
+     *
+     * Chunk files are self-contained, so these may be decoded at the same
+     * time. When reading files forward with a lookahead of n chunks, the
+     * reader keeps the next n chunks open in multithreaded file readers
+     * (see observation_file_reader_bin_parallel and
+     * observation_file_reader_txt_parallel), whose worker threads decode
+     * them while the application processes the current one. The cores
+     * available are shared out among these n + 1 readers.
+     *
+     * Records are still delivered chunk after chunk, that is, in global
+     * time order, with the same error codes and epoch semantics. Memory
+     * usage is bounded by the lookahead: each of the n + 1 readers keeps
+     * at most _ASTROLABE_OBS_E_FILE_READER_RANGES_PER_THREAD ranges of
+     * epochs per worker thread decoded ahead of the application.
+     *
+     * These readers read ahead by themselves, so the memory_mapped and
+     * prefetch parameters of open() do not apply to them. Backwards
+     * readers ignore this setting. After seek_to_time(), the lookahead
+     * restarts at the chunk following the one selected.
+     *
+     * This method must be called before open(). By default, there's no
+     * lookahead.
+     */
+
+    int                  set_chunk_lookahead       (int n_chunks);
+
+    /**
+     * @brief Open the next chunk in the background.
+     *
+     * @param enabled True to open every chunk in a helper thread while the
+     *        previous one is being read.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel has already been opened.
+     *
+     * Moving from a chunk to the next one (the previous one in reverse
+     * mode) means opening a file, allocating its buffers and reading its
+     * first block, which is felt as a latency spike by applications
+     * processing data as it comes. When enabled, the reader of the next
+     * chunk is created and opened, first block included, in a helper
+     * thread as soon as the current chunk is reached, so the transition
+     * just waits for it to be ready (if not yet).
+     *
+     * Records, error codes and epoch semantics do not change; opening
+     * errors are reported when the chunk is reached, as usual. Just one
+     * more reader, with its buffers, is kept at any time. This setting
+     * applies to both forward and backwards readers, and to the chunks
+     * following the one selected by seek_to_time(). It is ignored when a
+     * chunk lookahead is set (see set_chunk_lookahead()), whose readers
+     * are already opened in advance.
+     *
+     * This method must be called before open(). By default, chunks are
+     * opened when reached.
+     */
+
+    int                  set_chunk_open_ahead      (bool enabled);
+
+    /**
+     * @brief Save a chunk manifest when the chunk files have to be
+     *        looked for.
+     *
+     * @param enabled True to save the manifest.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel has already been opened.
+     *
+     * To open a file data channel, the reader must find out how many
+     * chunk files it is made of. A chunk manifest written along with the
+     * data (see observation_writer::set_chunk_manifest()) tells it at once;
+     * otherwise, the folder holding the chunks is listed. When enabled,
+     * the result of this listing is saved as a manifest (see
+     * segmented_file_utils::set_manifest_cache()), so readers opening the
+     * same data later on do not list the folder again. Failing to save
+     * the manifest is not an error.
+     *
+     * This method must be called before open(). By default, no manifest
+     * is saved.
+     */
+
+    int                  set_chunk_manifest        (bool enabled);
+
     /**
      * @brief Set the parameters controlling the behaviour of socket
      *        readers,when these are used.
@@ -757,6 +1075,130 @@ class observation_reader
 
     int                  set_header_file           (const char* header_file_name);
 
+    /**
+     * @brief Set the dimensions of the l-records with a given identifier,
+     *        as needed by read_epoch().
+     *
+     * @param identifier The identifier of the l-records.
+     * @param n_tag_values Number of tags in the l-records. May be zero.
+     * @param n_expectation_values Number of expectations in the l-records.
+     *        Must be greater than zero.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The identifier is NULL or empty.
+     *         - 2: Invalid dimensions.
+     *
+     * Setting again the dimensions of an identifier replaces the
+     * previous ones, even those taken from the metadata (see
+     * set_metadata()).
+     */
+
+    int                  set_l_record_dimensions   (const char* identifier,
+                                                    int         n_tag_values,
+                                                    int         n_expectation_values);
+
+    /**
+     * @brief Set the metadata describing the records, so read_epoch()
+     *        knows their dimensions.
+     *
+     * @param metadata The metadata, as loaded by gp_metadata_parser. It
+     *        must remain available until open() is called.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The data channel is already open.
+     *
+     * When the data channel is opened (see open()), the dimensions of the
+     * l-records (number of tags and expectations) are taken from the
+     * l-record specifications in the metadata, and those of the o-records
+     * (number of parameter, observation and instrument instance
+     * identifiers) from the measurement specifications. Dimensions
+     * already set with set_l_record_dimensions() or
+     * set_o_record_dimensions() take precedence over these.
+     *
+     * This method may be called several times, for instance, when the
+     * metadata is split into several objects. Should two objects describe
+     * the same identifier, the first one wins.
+     */
+
+    int                  set_metadata              (gp_metadata& metadata);
+
+    /**
+     * @brief Set the number of threads parsing text chunk files.
+     *
+     * @param n_threads Number of worker threads. One (the default) reads
+     *        text files sequentially; zero means as many as cores are
+     *        available.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: Invalid number of threads (negative).
+     *
+     * With more than one thread (or zero), text chunk files read forward
+     * are read by observation_file_reader_txt_parallel (see
+     * obs_e_based_file_reader_txt_parallel), which splits every chunk into
+     * byte ranges parsed by a pool of worker threads. Records are still
+     * delivered in file order, with the same error codes and epoch
+     * semantics.
+     *
+     * Binary files, and text files read backwards, are always read
+     * sequentially. Chunks decoded in advance because of a lookahead (see
+     * set_chunk_lookahead()) are always read by multithreaded readers.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open().
+     */
+
+    int                  set_number_of_threads     (int n_threads);
+
+    /**
+     * @brief Set the dimensions of the o-records with a given identifier,
+     *        as needed by read_epoch().
+     *
+     * @param identifier The identifier of the o-records.
+     * @param n_parameter_iids Number of parameter instance identifiers in
+     *        the o-records. Must be greater than zero.
+     * @param n_observation_iids Number of observation instance identifiers in
+     *        the o-records. Must be greater than zero.
+     * @param n_instrument_iids Number of instrument instance identifiers in
+     *        the o-records. May be zero.
+     * @return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The identifier is NULL or empty.
+     *         - 2: Invalid dimensions.
+     *
+     * Setting again the dimensions of an identifier replaces the
+     * previous ones, even those taken from the metadata (see
+     * set_metadata()).
+     */
+
+    int                  set_o_record_dimensions   (const char* identifier,
+                                                    int         n_parameter_iids,
+                                                    int         n_observation_iids,
+                                                    int         n_instrument_iids);
+
+    /**
+     * @brief Set the size of the region of the chunk files that backward
+     *        file readers ask the system to load in advance.
+     *
+     * @param window_size Size of the region, in bytes. 0 disables this
+     *        feature.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: Invalid (negative) size.
+     *
+     * The size is handed to the file reader of every chunk (see
+     * obs_e_based_file_reader::set_reverse_window()). Bigger windows keep
+     * the device busy longer, which pays on network storage; check the
+     * throughput achieved with get_read_statistics(). Forward readers and
+     * socket data channels ignore this setting.
+     *
+     * This method must be called before open(). The default size is
+     * _ASTROLABE_OBS_E_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE.
+     */
+
+    int                  set_reverse_window        (long long window_size);
+
     /**
      * @brief Set the name of the XML schema defining the grammar of
      *        ASTROLABE header files.
@@ -850,8 +1292,189 @@ class observation_reader
     int                  get_metadata              (int& total_metadata_warnings,
                                                     int& total_metadata_errors);
 
+    /**
+     * @brief Add (or replace) the dimensions of a kind of record.
+     * @param type The type of the records ('l' or 'o').
+     * @param identifier The identifier of the records (not empty).
+     * @param counts The dimensions (see record_dimensions).
+     * @param replace True to replace the dimensions already set for the
+     *        identifier, if any; false to keep these.
+     *
+     * Also makes sure that epoch_identifier_ is able to hold the identifier.
+     */
+
+    void                 add_record_dimensions     (char        type,
+                                                    const char* identifier,
+                                                    const int*  counts,
+                                                    bool        replace);
+
+    /**
+     * @brief Locate the dimensions of a kind of record.
+     * @param type The type of the records ('l' or 'o').
+     * @param identifier The identifier of the records.
+     * @return The position of the dimensions in record_dimensions_, or -1
+     *         if none have been set.
+     *
+     * No memory is allocated; the lookup hashes the identifier in place.
+     */
+
+    int                  find_record_dimensions    (char type, const char* identifier) const;
+
+    /**
+     * @brief Compute the hash of a record type and identifier, used to
+     *        locate its dimensions in record_dimensions_slots_.
+     * @param type The type of the records ('l' or 'o').
+     * @param identifier The identifier of the records.
+     * @return The hash value (FNV-1a).
+     */
+
+    unsigned int         hash_record_identifier    (char type, const char* identifier) const;
+
+    /**
+     * @brief Set the dimensions of the records described in the metadata
+     *        (see set_metadata()) that have no dimensions set yet.
+     */
+
+    void                 set_metadata_dimensions   (void);
+
+    /**
+     * @brief Retrieve the time index of a chunk file, loading or building
+     *        it if not available yet.
+     * @param chunk The number of the chunk, starting at 1.
+     * @param index On output, the time index of the chunk.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: Unable to load or build the time index.
+     */
+
+    int                  get_time_index            (int chunk, epoch_time_index*& index);
+
+    /**
+     * @brief Instantiate a file reader suitable for the format of the
+     *        data files, the read mode (forward or reverse) and the
+     *        number of threads (see set_number_of_threads()) selected.
+     * @return The new file reader, not yet open.
+     */
+
+    obs_e_based_file_reader* new_file_reader      (void);
+
+    /**
+     * @brief Instantiate a multithreaded file reader suitable for the
+     *        format of the data files (see set_chunk_lookahead()).
+     * @return The new file reader, not yet open.
+     */
+
+    obs_e_based_file_reader* new_parallel_file_reader (void);
+
+    /**
+     * @brief Add the read statistics of file_reader_ to those of the
+     *        chunks already read (see get_read_statistics()).
+     */
+
+    void                 add_read_statistics       (void);
+
+    /**
+     * @brief Close and destroy the readers of the chunks decoded in
+     *        advance, if any.
+     */
+
+    void                 discard_lookahead         (void);
+
+    /**
+     * @brief Wait for the reader of the next chunk opened in the
+     *        background, if any, and destroy it.
+     */
+
+    void                 discard_next_file_reader  (void);
+
+    /**
+     * @brief Open the readers of the chunks following the current one,
+     *        until the lookahead is full or no chunks are left.
+     */
+
+    void                 fill_lookahead            (void);
+
+    /**
+     * @brief Make file_reader_ read the next chunk.
+     * @param open_status On output, the error code returned by the
+     *        open() method of the new file reader.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: No more chunks are available.
+     *        - 2: Unable to open the next chunk (see open_status).
+     *
+     * With a chunk lookahead (see set_chunk_lookahead()) the reader is
+     * taken from the chunks already being decoded, and the lookahead is
+     * filled again.
+     */
+
+    int                  open_next_chunk           (int& open_status);
+
+    /**
+     * @brief Body of the helper thread opening the next chunk (see
+     *        set_chunk_open_ahead()).
+     */
+
+    void                 open_next_file_reader     (void);
+
+    /**
+     * @brief Start opening the next chunk in the background, if so
+     *        requested and some chunk is left.
+     */
+
+    void                 start_next_file_reader    (void);
+
+    /**
+     * @brief Read the data of a record whose type, active flag, identifier,
+     *        instance identifier and time have already been read, and
+     *        append it to an epoch.
+     * @param epoch The epoch to append the record to.
+     * @param type The type of the record.
+     * @param active The active flag of the record.
+     * @param instance_id The instance identifier of the record (l-records).
+     * @param time The time tag of the record.
+     * @param dimensions The position, in record_dimensions_, of the
+     *        dimensions (and identifier) of the record.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 4: Error reading the record.
+     *
+     * The values are decoded straight into the storage of the epoch.
+     */
+
+    int                  read_epoch_record_data    (observation_epoch& epoch,
+                                                    char               type,
+                                                    bool               active,
+                                                    int                instance_id,
+                                                    double             time,
+                                                    int                dimensions);
+
   protected:
 
+    /// \brief Dimensions of a kind of record, as set by set_metadata(),
+    /// set_l_record_dimensions() or set_o_record_dimensions().
+
+    struct record_dimensions
+    {
+      /// \brief Number of tags and expectations (l-records) or parameter,
+      /// observation and instrument instance identifiers (o-records).
+
+      int    counts[3];
+
+      /// \brief The identifier of the records.
+
+      string identifier;
+
+      /// \brief The type of the records ('l' or 'o').
+
+      char   type;
+    };
+
+    /// \brief Number of chunks to decode in advance (see
+    /// set_chunk_lookahead()).
+
+    int                             chunk_lookahead_;
+
     /// \brief The chunk files name generator.
 
     segmented_file_utils            chunk_names_generator_;
@@ -871,6 +1494,41 @@ class observation_reader
 
     bool                            data_channel_is_socket_;
 
+    /// \brief Buffer used by read_epoch() to read identifiers. It is able
+    /// to hold the longest identifier whose dimensions have been set.
+
+    char*                           epoch_identifier_;
+
+    /// \brief Size of epoch_identifier_.
+
+    int                             epoch_identifier_size_;
+
+    /// \brief Flag. True when the last call to read_epoch() left the
+    /// first record of the next epoch half read (all but its data).
+
+    bool                            epoch_record_pending_;
+
+    /// \brief Active flag of the half read record, if any.
+
+    bool                            epoch_record_pending_active_;
+
+    /// \brief Dimensions of the half read record, if any (position in
+    /// record_dimensions_).
+
+    int                             epoch_record_pending_dimensions_;
+
+    /// \brief Instance identifier of the half read record, if any.
+
+    int                             epoch_record_pending_iid_;
+
+    /// \brief Time of the half read record, if any.
+
+    double                          epoch_record_pending_time_;
+
+    /// \brief Type of the half read record, if any.
+
+    char                            epoch_record_pending_type_;
+
     /// \brief The data parsed from the input astrolabe header file.
 
     gp_astrolabe_header_file_data   header_data_;
@@ -902,10 +1560,25 @@ class observation_reader
 
     bool                            is_header_filename_set_;
 
+    /// \brief Flag that indicates that forward binary files must be read
+    /// through memory maps.
+
+    bool                            is_memory_mapped_mode_set_;
+
     /// \brief Flag that shows whether the metadata has been read.
 
     bool                            is_metadata_read_;
 
+    /// \brief Flag that indicates that the next chunk must be opened in
+    /// advance, in a helper thread (see set_chunk_open_ahead()).
+
+    bool                            is_open_ahead_mode_set_;
+
+    /// \brief Flag that indicates that file readers must read their chunks
+    /// in advance, in a helper thread.
+
+    bool                            is_prefetch_mode_set_;
+
     /// \brief Flag that shows whether the schema file name
     /// has been set.
 
@@ -929,11 +1602,77 @@ class observation_reader
 
     bool                            last_epoch_time_available_;
 
+    /// \brief Flag. True when the chunks are read through the lookahead,
+    /// that is, when set and reading forward.
+
+    bool                            lookahead_is_active_;
+
+    /// \brief Readers of the chunks decoded in advance, in reading order.
+
+    deque<obs_e_based_file_reader*> lookahead_readers_;
+
+    /// \brief Error codes returned when opening the readers in
+    /// lookahead_readers_.
+
+    deque<int>                      lookahead_status_;
+
+    /// \brief Number of worker threads of every lookahead reader.
+
+    int                             lookahead_threads_;
+
+    /// \brief Name of the chunk being opened by next_file_reader_.
+
+    string                          next_chunk_filename_;
+
+    /// \brief Reader of the next chunk, opened in the background (see
+    /// set_chunk_open_ahead()). NULL when none.
+
+    obs_e_based_file_reader*        next_file_reader_;
+
+    /// \brief The helper thread opening next_file_reader_.
+
+    thread                          next_file_reader_opener_;
+
+    /// \brief Error code returned when opening next_file_reader_.
+
+    int                             next_file_reader_status_;
+
+    /// \brief The metadata objects describing the records, if any (see
+    /// set_metadata()).
+
+    vector<gp_metadata*>            metadata_;
+
+    /// \brief Dimensions of the l- and o-records. Records are identified
+    /// by the position of their dimensions in this vector.
+
+    vector<record_dimensions>       record_dimensions_;
+
+    /// \brief Open addressing hash table (its size is a power of two) with
+    /// the positions in record_dimensions_, indexed by type and identifier
+    /// (see hash_record_identifier()). Empty slots hold -1.
+
+    vector<int>                     record_dimensions_slots_;
+
+    /// \brief Bytes read by the file readers of the chunks already closed
+    /// (see get_read_statistics()).
+
+    long long                       read_bytes_;
+
+    /// \brief Time spent by the file readers of the chunks already closed
+    /// waiting for read_bytes_ (see get_read_statistics()).
+
+    double                          read_seconds_;
+
     /// \brief Control flag. True when the first epoch in the file is being
     /// read, false otherwise.
 
     bool                            reading_first_epoch_;
 
+    /// \brief Size of the region of the chunk files that backward file
+    /// readers ask the system to load in advance (see set_reverse_window()).
+
+    long long                       reverse_window_size_;
+
     /// \brief Name of the XML schema file used to validate the syntax
     /// of the ASTROLABE header file to read. When empty, no schema
     /// is available.
@@ -950,6 +1689,16 @@ class observation_reader
 
     bool                            socket_works_in_server_mode_;
 
+    /// \brief Number of threads parsing text chunk files (see
+    /// set_number_of_threads()).
+
+    int                             text_threads_;
+
+    /// \brief Time indexes of the chunk files, used by seek_to_time().
+    /// Position i holds the index of chunk i+1, or NULL if not loaded yet.
+
+    vector<epoch_time_index*>       time_indexes_;
+
 };
 
 #endif // OBSERVATION_READER_HPP
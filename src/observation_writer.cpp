@@ -1,5 +1,107 @@
 #include "observation_writer.hpp"
 
+void
+observation_writer::
+add_sync_statistics
+(void)
+{
+  {
+    double    max_seconds;
+    long long n_syncs;
+    double    seconds;
+
+    // Chunk file writers are destroyed once closed; keep their figures.
+
+    file_writer_->get_sync_statistics(n_syncs, seconds, max_seconds);
+
+    n_syncs_      += n_syncs;
+    sync_seconds_ += seconds;
+    if (max_seconds > max_sync_seconds_) max_sync_seconds_ = max_seconds;
+  }
+}
+
+int
+observation_writer::
+begin_epoch
+(void)
+{
+  {
+    string chunk_filename;
+    int    status;
+
+    //
+    // A chunk is full when it holds the maximum number of epochs or, if
+    // a target size has been set, when it has already reached it. Every
+    // chunk holds at least one epoch.
+    //
+
+    if ((already_written_epochs_ == max_epochs_per_chunk_) ||
+        ((max_chunk_bytes_ > 0) && (already_written_epochs_ > 0) &&
+         (file_writer_->get_bytes_stored() >= max_chunk_bytes_)))
+    {
+
+      // We've reached the maximum size of the chunk.
+
+      // Describe it for the manifest, then close it.
+
+      chunk_names_generator_.set_chunk_time_range(chunk_first_time_,
+                                                  chunk_last_time_,
+                                                  chunk_n_records_);
+
+      status = file_writer_->close();
+      if (status != 0) return 2; // Error writing to disk.
+
+      // Destroy the file writer.
+
+      add_sync_statistics();
+      delete file_writer_;
+      file_writer_ = NULL;
+
+      //
+      // Get the next chunk file name. Note that this operation may fail
+      // if the width of the numeric suffix used to christianize new
+      // files is too short, and the number of available digits is not
+      // enough to assign a number to the new chunk. For instance, if
+      // such width is just 1, no more than nine files (with suffixes
+      // going from _1 to _9) may be generated.
+      //
+
+      status = chunk_names_generator_.get_next_filename(chunk_filename);
+      if (status != 0) return 6;
+
+      //
+      // Create a new file writer, depending on the kind of file we're
+      // dealing with.
+      //
+
+      file_writer_ = new_file_writer();
+
+      // Open the writer.
+
+      status = file_writer_->open(chunk_filename.c_str());
+      if (status != 0) return 7;
+
+
+      // Reset our counters of written epochs and records.
+
+      already_written_epochs_ = 0;
+      chunk_n_records_        = 0;
+    }
+
+    //
+    // One more epoch written! (Although we are just at its beginning).
+    // Its time tag has already been saved by the caller.
+    //
+
+    if (already_written_epochs_ == 0) chunk_first_time_ = last_time_tag_;
+    chunk_last_time_ = last_time_tag_;
+
+    already_written_epochs_ ++;
+
+    return 0;
+  }
+}
+
 int
 observation_writer::
 close
@@ -36,12 +138,31 @@ close
 
       if (file_writer_->is_open())
       {
+        chunk_names_generator_.set_chunk_time_range(chunk_first_time_,
+                                                    chunk_last_time_,
+                                                    chunk_n_records_);
+
         status = file_writer_->close();
+        add_sync_statistics();
         delete file_writer_;
         file_writer_ = NULL;
 
         if (status != 0) return status;
       }
+
+      //
+      // Describe the chunks written, if asked to, so readers find them
+      // without scanning the folder.
+      //
+
+      if (chunk_manifest_is_enabled_)
+      {
+        if (chunk_names_generator_.write_manifest() != 0)
+        {
+          data_channel_is_open_ = false;
+          return 1;
+        }
+      }
     }
 
     // Update flags.
@@ -60,9 +181,13 @@ observation_writer
 {
   {
     already_written_epochs_ = 0;
+    async_flush_            = false;
+    columnar_block_size_    = 0;
     data_channel_is_open_   = false;
     data_channel_is_set_    = false;
     data_channel_is_socket_ = false;
+    durability_interval_    = 0;
+    durability_policy_      = _ASTROLABE_DURABILITY_NONE;
     external_base_file_     = "";
     file_mode_is_binary_    = false;
     file_writer_            = NULL;
@@ -71,11 +196,23 @@ observation_writer
     host_                   = "";
     last_time_tag_          = 0.0;
     lineage_info_           = NULL;
+    max_chunk_bytes_        = 0;
     max_epochs_per_chunk_   = 0;
+    max_sync_seconds_       = 0;
+    n_syncs_                = 0;
     numeric_suffix_width_   = 0;
     port_                   = 0;
+    preallocate_chunks_     = false;
     socket_server_mode_     = false;
+    socket_window_          = 1;
     socket_writer_          = NULL;
+    sync_seconds_           = 0;
+    time_index_is_enabled_  = false;
+
+    chunk_first_time_          = 0.0;
+    chunk_last_time_           = 0.0;
+    chunk_manifest_is_enabled_ = false;
+    chunk_n_records_           = 0;
   }
 }
 
@@ -90,6 +227,36 @@ observation_writer::
   }
 }
 
+void
+observation_writer::
+get_sync_statistics
+(long long& n_syncs,
+ double&    seconds,
+ double&    max_seconds)
+const
+{
+  {
+    double    chunk_max_seconds;
+    long long chunk_n_syncs;
+    double    chunk_seconds;
+
+    n_syncs     = n_syncs_;
+    seconds     = sync_seconds_;
+    max_seconds = max_sync_seconds_;
+
+    // Add the figures of the chunk file being written, if any.
+
+    if (file_writer_ != NULL)
+    {
+      file_writer_->get_sync_statistics(chunk_n_syncs, chunk_seconds, chunk_max_seconds);
+
+      n_syncs += chunk_n_syncs;
+      seconds += chunk_seconds;
+      if (chunk_max_seconds > max_seconds) max_seconds = chunk_max_seconds;
+    }
+  }
+}
+
 bool
 observation_writer::  
 is_open
@@ -101,6 +268,48 @@ const
   }
 }
 
+obs_e_based_file_writer*
+observation_writer::
+new_file_writer
+(void)
+{
+  obs_e_based_file_writer* writer;
+
+  {
+    observation_file_writer_col* columnar_writer;
+
+    // Instantiate the writer for the kind of file we're dealing with.
+
+    if (columnar_block_size_ > 0)
+    {
+      columnar_writer = new observation_file_writer_col();
+      columnar_writer->set_block_size(columnar_block_size_);
+
+      writer = columnar_writer;
+    }
+    else if (file_mode_is_binary_)
+    {
+      writer = new observation_file_writer_bin();
+    }
+    else
+    {
+      writer = new observation_file_writer_txt();
+    }
+
+    //
+    // Apply the settings of the channel. Columnar files have no time
+    // indexes, so these are never asked for.
+    //
+
+    writer->set_async_flush(async_flush_);
+    writer->set_durability(durability_policy_, durability_interval_);
+    writer->set_time_index(time_index_is_enabled_ && (columnar_block_size_ == 0));
+    writer->set_preallocation(preallocate_chunks_ ? max_chunk_bytes_ : 0);
+  }
+
+  return writer;
+}
+
 int
 observation_writer::  
 open
@@ -129,6 +338,7 @@ open
       // Sockets.
 
       socket_writer_ = new observation_socket_writer();
+      socket_writer_->set_window(socket_window_);
       status = socket_writer_->open(host_.c_str(), port_, socket_server_mode_);
       if (status != 0) return status;
     }
@@ -151,60 +361,96 @@ open
                                       file_mode_is_binary_,
                                       lineage_info_);
 
+      header_writer.set_columnar(columnar_block_size_ > 0);
+
       status = header_writer.write();
       if (status != 0) return 2; // Unable to open the data channel.
+
+      //
+      // A manifest left by a previous run would describe the chunks we
+      // are about to replace.
+      //
+
+      if (chunk_names_generator_.remove_manifest() == 2) return 2;
       
-      // Now, we need to know whether the file is text or binary.
+      //
+      // Get the first chunk name. We ignore the return error code since
+      // this is the first time we call the name generator and it will
+      // always work (there's no risk of running out of file names).
+      //
 
-      if (file_mode_is_binary_)
-      {
-        // Binary files.
+      status = chunk_names_generator_.get_next_filename(chunk_filename);
 
-        //
-        // Get the first chunk name. We ignore the return error code since
-        // this is the first time we call the name generator and it will
-        // always work (there's no risk of running out of file names).
-        //
+      // Instantiate the proper writer, depending on the kind of file.
 
-        status = chunk_names_generator_.get_next_filename(chunk_filename);
+      file_writer_ = new_file_writer();
 
-        // Instantiate the proper writer.
+      // Open the writer. Beware of errors!
 
-        file_writer_ = new observation_file_writer_bin();
+      status = file_writer_->open(chunk_filename.c_str());
 
-        // Open the writer. Beware of errors!
+      if (status != 0) return status;
+    }
 
-        status = file_writer_->open(chunk_filename.c_str());
+    // Set flags.
 
-        if (status != 0) return status;
-      }
-      else
-      {
-        // Text files
+    data_channel_is_open_ = true;
 
-        //
-        // Get the first chunk name. We ignore the return error code since
-        // this is the first time we call the name generator and it will
-        // always work (there's no risk of running out of file names).
-        //
+    // That's all.
 
-        status = chunk_names_generator_.get_next_filename(chunk_filename);
+    return 0;
+  }
+}
 
-        // Instantiate the proper writer.
+int
+observation_writer::
+set_async_flush
+(bool enabled)
+{
+  {
+    // The setting must be decided before opening the channel.
 
-        file_writer_ = new observation_file_writer_txt();
+    if (data_channel_is_open_) return 1;
 
-        // Open the writer. Beware of errors!
+    async_flush_ = enabled;
 
-        status = file_writer_->open(chunk_filename.c_str());
+    // That's all.
 
-        if (status != 0) return status;
-      }
-    }
+    return 0;
+  }
+}
 
-    // Set flags.
+int
+observation_writer::
+set_chunk_manifest
+(bool enabled)
+{
+  {
+    // The setting must be decided before opening the channel.
 
-    data_channel_is_open_ = true;
+    if (data_channel_is_open_) return 1;
+
+    chunk_manifest_is_enabled_ = enabled;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_writer::
+set_columnar
+(int block_size)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (block_size < 0) return 2;
+
+    columnar_block_size_ = block_size;
 
     // That's all.
 
@@ -317,6 +563,207 @@ set_data_channel
   }
 }
 
+int
+observation_writer::
+set_durability
+(int policy,
+ int interval)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if ((policy < _ASTROLABE_DURABILITY_NONE) ||
+        (policy > _ASTROLABE_DURABILITY_CLOSE)) return 2;
+
+    // Periodic policies need a period.
+
+    if ((policy == _ASTROLABE_DURABILITY_EPOCHS) ||
+        (policy == _ASTROLABE_DURABILITY_MILLISECONDS))
+    {
+      if (interval <= 0) return 3;
+    }
+
+    durability_interval_ = interval;
+    durability_policy_   = policy;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_writer::
+set_max_chunk_size
+(long long max_bytes,
+ bool      preallocate)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (max_bytes < 0) return 2;
+
+    max_chunk_bytes_    = max_bytes;
+    preallocate_chunks_ = preallocate && (max_bytes > 0);
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_writer::
+set_socket_window
+(int n_records)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (n_records < 1) return 2;
+
+    socket_window_ = n_records;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_writer::
+set_time_index
+(bool enabled)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    time_index_is_enabled_ = enabled;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+observation_writer::
+write_epoch
+(const observation_epoch& epoch)
+{
+  {
+    int    n_records;
+    int    record;
+    int    status;
+    double time;
+
+    // Check our preconditions.
+
+    if (!data_channel_is_open_) return 1;
+
+    n_records = epoch.get_n_records();
+
+    if (n_records == 0) return 0;
+
+    //
+    // See what's the type of data channel we're using and work
+    // correspondingly.
+    //
+
+    if (data_channel_is_socket_)
+    {
+      // Sockets. The socket writer validates the whole epoch.
+
+      status = socket_writer_->write_epoch(epoch);
+      return status;
+    }
+    else
+    {
+      //
+      // Files, either binary or text.
+      //
+      // Records with different time tags may start several epochs, and
+      // each one of these may need a new chunk. Leave them to write_l()
+      // and write_o().
+      //
+
+      time = epoch.get_record_time(0);
+
+      for (record = 1; record < n_records; record++)
+      {
+        if (epoch.get_record_time(record) != time) break;
+      }
+
+      if (record < n_records)
+      {
+        for (record = 0; record < n_records; record++)
+        {
+          if (epoch.get_type(record) == 'l')
+          {
+            status = write_l(epoch.get_active(record),
+                             (char*)epoch.get_identifier(record),
+                             epoch.get_instance_id(record),
+                             epoch.get_record_time(record),
+                             epoch.get_n_tags(record),
+                             (double*)epoch.get_tags(record),
+                             epoch.get_n_expectations(record),
+                             (double*)epoch.get_expectations(record),
+                             epoch.get_n_covariance_values(record),
+                             (double*)epoch.get_covariance_values(record));
+          }
+          else
+          {
+            status = write_o(epoch.get_active(record),
+                             (char*)epoch.get_identifier(record),
+                             epoch.get_record_time(record),
+                             epoch.get_n_parameter_iids(record),
+                             (int*)epoch.get_parameter_iids(record),
+                             epoch.get_n_observation_iids(record),
+                             (int*)epoch.get_observation_iids(record),
+                             epoch.get_n_instrument_iids(record),
+                             (int*)epoch.get_instrument_iids(record));
+          }
+
+          if (status != 0) return status;
+        }
+
+        return 0;
+      }
+
+      //
+      // A single time tag. Check once if this is a new epoch; if so, it
+      // must start with an l-record, and it may need a new chunk.
+      //
+
+      if (first_time_writing_ || (time != last_time_tag_))
+      {
+        if (epoch.get_type(0) != 'l') return 3;
+
+        last_time_tag_      = time;
+        first_time_writing_ = false;
+
+        status = begin_epoch();
+        if (status != 0) return status;
+      }
+
+      // Finally, write the whole epoch! Use the polymorphic writer to do it.
+
+      status = file_writer_->write_epoch(epoch);
+      if (status == 0) chunk_n_records_ += n_records;
+
+      return status;
+    }
+  }
+}
+
 int
 observation_writer::
 write_l
@@ -332,7 +779,6 @@ write_l
  double* buffer_covariance)
 {
   {
-    string chunk_filename;
     bool   epoch_changed;
     int    status;
 
@@ -397,67 +843,16 @@ write_l
         // and create a new one.
         //
 
-        if (already_written_epochs_ == max_epochs_per_chunk_)
-        {
-
-          // We've reached the maximum number of epochs per chunk.
-
-          // Close the current chunk.
-
-          status = file_writer_->close();
-          if (status != 0) return 2; // Error writing to disk.
-
-          // Destroy the file writer.
-
-          delete file_writer_;
-          file_writer_ = NULL;
-
-          //
-          // Get the next chunk file name. Note that this operation may fail
-          // if the width of the numeric suffix used to christianize new
-          // files is too short, and the number of available digits is not
-          // enough to assign a number to the new chunk. For instance, if
-          // such width is just 1, no more than nine files (with suffixes
-          // going from _1 to _9) may be generated.
-          //
-
-          status = chunk_names_generator_.get_next_filename(chunk_filename);
-          if (status != 0) return 6;
-
-          //
-          // Create a new file writer, depending on the kind of file we're
-          // dealing with.
-          //
-
-          if (file_mode_is_binary_)
-          {
-            file_writer_ = new observation_file_writer_bin();
-          }
-          else
-          {
-            file_writer_ = new observation_file_writer_txt();
-          }
-
-          // Open the writer.
-
-          status = file_writer_->open(chunk_filename.c_str());
-          if (status != 0) return 7;
-
-
-          // Reset our counter of written epochs.
-
-          already_written_epochs_ = 0;
-        }
-
-        // One more epoch written! (Although we are just at its beginning)
-
-        already_written_epochs_ ++;
+        status = begin_epoch();
+        if (status != 0) return status;
       }
 
       // Finally, write the l-record! Use the polymorphic writer to do it.
 
       status = file_writer_->write_l(active, identifier, instance_identifier, time,
                                      n_tags, buffer_tags, n_expectations, buffer_expectations, n_covariance_values, buffer_covariance);
+      if (status == 0) chunk_n_records_++;
+
       return status;
     }
   }
@@ -556,6 +951,8 @@ write_o
                                               n_parameter_iids,   the_parameter_iids,
                                               n_observation_iids, the_observation_iids,
                                               n_instrument_iids,  the_instrument_iids);
+      if (status == 0) chunk_n_records_++;
+
       return status;
     }
   }
@@ -9,12 +9,14 @@
 
 #include "observation_socket_writer.hpp"
 #include "observation_file_writer_bin.hpp"
+#include "observation_file_writer_col.hpp"
 #include "observation_file_writer_txt.hpp"
 
 #include "astrolabe_header_file_writer.hpp"
 
 #include "segmented_file_utils.hpp"
 #include "lineage_data.hpp"
+#include "observation_epoch.hpp"
 
 
 /**
@@ -26,8 +28,8 @@
    This class is able to write to all the different types of data channels
    defined by the ASTROLABE I/O interface.
 
-   This includes both sockets and files; files may be either binary or
-   text.
+   This includes both sockets and files; files may be either binary,
+   text or columnar (see set_columnar()).
 
    THEREFORE, THIS IS THE CLASS TO USE WHEN WRITING ASTROLABE DATA. All other
    classes in this library implement the different writers needed to
@@ -40,8 +42,8 @@
      the different set_data_channel() methods available to do so.
    - Open the channel using method open().
    - Write all the needed information to the channel using methods write_l()
-     and write_o() repeatedly until data is exhausted and then,
-     close the channel using method close().
+     and write_o() repeatedly (or write_epoch(), a whole epoch at a time)
+     until data is exhausted and then, close the channel using method close().
 
    Note that all methods but set_data_channel() are completely independent
    of the kind of output channel being used.
@@ -79,6 +81,22 @@ class observation_writer
 
     int  close                         (void);
 
+    /**
+     * \brief Retrieve the sync statistics of the file data channel.
+     *
+     * \param n_syncs Number of times the chunk files have been committed
+     *        to the storage device (see set_durability()).
+     * \param seconds Total time, in seconds, spent in these commits.
+     * \param max_seconds Time, in seconds, taken by the slowest one.
+     *
+     * Figures add up all the chunk files written so far, including the
+     * one being written, and are kept after closing the channel.
+     */
+
+    void get_sync_statistics           (long long&   n_syncs,
+                                        double&      seconds,
+                                        double&      max_seconds) const;
+
     /**
      * \brief Check if the underlying data channel has already been opened.
      *
@@ -123,6 +141,83 @@ class observation_writer
 
     int  open                          (void);
 
+    /**
+     * \brief Enable or disable writing the chunk files in the background.
+     *
+     * \param enabled True to write the buffers of the file writers in a
+     *        helper thread.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *
+     * When enabled, file writers use two buffers: one is filled by write_l()
+     * and write_o() while the other is written to disk by a helper thread
+     * (see obs_e_based_file_writer::set_async_flush()). Real time
+     * applications are then only blocked when the disk falls behind by a
+     * whole buffer, instead of every time a buffer gets full. close() waits
+     * until all the data has been written.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open(); by default, buffers are written by
+     * the thread calling the writer.
+     */
+
+    int  set_async_flush               (bool         enabled);
+
+    /**
+     * \brief Enable or disable the chunk manifest.
+     *
+     * \param enabled True to write a chunk manifest when closing the
+     *        data channel.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *
+     * The manifest (see segmented_file_utils::write_manifest()) records
+     * how many chunk files have been written and how these are named, so
+     * readers find them without scanning the folder where these are stored.
+     * It also records the time tags of the first and last epochs and the
+     * number of records of every chunk, so readers seeking a given time
+     * (see observation_reader::seek_to_time()) go straight to the chunk
+     * holding it. Failing to write it makes close() return error code 1.
+     *
+     * Any manifest left by a previous run is removed by open(), whatever
+     * this setting, since the chunks it describes are being replaced.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open(); by default, no manifest is written.
+     */
+
+    int  set_chunk_manifest            (bool         enabled);
+
+    /**
+     * \brief Write the chunk files in columnar format.
+     *
+     * \param block_size Maximum number of records in a column block (see
+     *        observation_file_writer_col::set_block_size()). Zero goes back
+     *        to the format selected with set_data_channel().
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: The block size must not be negative.
+     *
+     * Every chunk file becomes a columnar file (see
+     * observation_file_writer_col), and the header file states so. Chunks
+     * are still split by number of epochs or size, but time indexes are
+     * not written (see set_time_index()), since the directory of columnar
+     * files already records the time range of each block. Columnar files
+     * are read with observation_file_reader_col, one chunk at a time.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open(); by default, the format selected with
+     * set_data_channel() is used.
+     */
+
+    int  set_columnar                  (int          block_size);
+
     /**
      * \brief Set the observation channel to work with files
      *
@@ -136,6 +231,7 @@ class observation_writer
      *        will be a binary one. When false, this file will be a text file.
      * \param max_epochs_to_split Maximum number of epochs to write in any of
      *        the external files containing actual data. Must be greater than zero.
+     *        Chunk files may also be limited by size (see set_max_chunk_size()).
      * \param file_suffix_width Number of digits to use in the suffix part
      *        of the names of the different external files into which data is
      *        written. Range: [1..9].
@@ -271,6 +367,119 @@ class observation_writer
                                         int          port,
                                         bool         server_mode);
 
+    /**
+     * \brief Select when the chunk files are committed to the storage
+     *        device.
+     *
+     * \param policy One of _ASTROLABE_DURABILITY_NONE,
+     *        _ASTROLABE_DURABILITY_EPOCHS, _ASTROLABE_DURABILITY_MILLISECONDS
+     *        or _ASTROLABE_DURABILITY_CLOSE.
+     * \param interval Number of epochs (_ASTROLABE_DURABILITY_EPOCHS) or
+     *        milliseconds (_ASTROLABE_DURABILITY_MILLISECONDS) between
+     *        syncs. Ignored by the other policies.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: Unknown policy.
+     *        - 3: The interval must be greater than zero.
+     *
+     * See obs_e_based_file_writer::set_durability(). Unless the policy is
+     * _ASTROLABE_DURABILITY_NONE, every chunk file is synced when closed.
+     * Periodic syncs are done by a helper thread, so writing does not wait
+     * for the device. Use get_sync_statistics() to tune the interval.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open(); by default, files are never synced.
+     */
+
+    int  set_durability                (int          policy,
+                                        int          interval);
+
+    /**
+     * \brief Split the chunk files by size, and optionally reserve their
+     *        space in advance.
+     *
+     * \param max_bytes Target size, in bytes, of every chunk file. Zero
+     *        disables the limit.
+     * \param preallocate When true, the space of every chunk file
+     *        (max_bytes) is reserved when it is created (see
+     *        obs_e_based_file_writer::set_preallocation()).
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: The size must not be negative.
+     *
+     * The number of epochs in a chunk (see set_data_channel()) says
+     * little about its size, since epochs may differ in size by orders
+     * of magnitude. When a limit is set, a new chunk file is started as
+     * soon as an epoch begins and the current chunk already holds
+     * max_bytes or more (see obs_e_based_file_writer::get_bytes_stored()),
+     * whatever the number of epochs written, which is still honored.
+     * Epochs are never split, so chunks overshoot the target by less than
+     * an epoch; every chunk holds at least one epoch.
+     *
+     * Sizes are measured before compression. Preallocated chunk files are
+     * laid out contiguously on the device, and the space not used is given
+     * back when closed. Their size is that of the data actually written at
+     * all times, so they may be recovered after a crash. Space is reserved
+     * on Linux and Windows only; elsewhere, preallocate is silently ignored
+     * and chunk files just grow as usual.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open(); by default, chunks are split by
+     * number of epochs only.
+     */
+
+    int  set_max_chunk_size            (long long    max_bytes,
+                                        bool         preallocate);
+
+    /**
+     * \brief Let several records travel through socket data channels
+     *        without waiting for their acknowledgement.
+     *
+     * \param n_records Maximum number of records not acknowledged yet.
+     *        One (the default) keeps the stop-and-wait protocol, where
+     *        every record waits for its acknowledgement.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: The window must be greater than zero.
+     *
+     * See obs_e_based_socket_writer::set_window(). A window greater than one
+     * is asked for when the connection is opened, so the reader must
+     * understand the windowed protocol; otherwise, open() fails.
+     *
+     * This setting has no effect on file data channels. It must be
+     * decided before calling open().
+     */
+
+    int  set_socket_window             (int          n_records);
+
+    /**
+     * \brief Enable or disable the creation of time indexes.
+     *
+     * \param enabled True to create a time index for every chunk file.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *
+     * When enabled, every chunk file written gets a sidecar time index
+     * (see epoch_time_index) that allows observation_reader::seek_to_time()
+     * to locate epochs without scanning the data. Indexes are not needed
+     * to seek, since readers build them when missing, but creating them
+     * while writing avoids this extra pass.
+     *
+     * This setting has no effect on socket data channels nor on columnar
+     * chunk files (see set_columnar()). It must be decided before calling
+     * open(); by default, no indexes are created.
+     */
+
+    int  set_time_index                (bool         enabled);
+
     /**
      * \brief Write an l-record.
      *
@@ -384,8 +593,100 @@ class observation_writer
                                         int          n_instrument_iids,
                                         int*         the_instrument_iids);
 
+    /**
+     * \brief Write all the l- and o-records of an epoch.
+     *
+     * \param epoch The records to write, in the order these must appear in
+     *        the data channel, as retrieved, for instance, by
+     *        observation_reader::read_epoch().
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is not open so it is not possible to write.
+     *        - 2: I/O error detected while writing (either to disk or to
+     *             a socket connection).
+     *        - 3: An o-record would be the first record in the epoch.
+     *        - 4: An identifier is empty.
+     *        - 5: Invalid number of tags, expectations or covariance values
+     *             in an l-record (see write_l()).
+     *        - 6: Error writing: a new chunk file had to be created to
+     *             store the epoch, but the width of the numeric suffix is
+     *             not big enough to allow for more chunk file names.
+     *        - 7: I/O error: unable to create a new file chunk, or invalid
+     *             number of instance identifiers in an o-record (see
+     *             write_o()).
+     *
+     * This method is equivalent to calling write_l() or write_o() for every
+     * record in the epoch, but much cheaper: when all the records share the
+     * same time tag, the order of the records and the need for a new chunk
+     * file are checked once for the whole epoch, and the writers validate
+     * and store the epoch in a single pass (see, for instance,
+     * observation_file_writer_bin::write_epoch()). Then, nothing is written
+     * if any record is wrong.
+     *
+     * Epochs mixing several time tags are written record by record.
+     */
+
+    int  write_epoch                   (const observation_epoch& epoch);
+
   protected:
 
+    /**
+     * \brief Add the sync statistics of the chunk file writer to those
+     *        of the channel, before destroying it.
+     */
+
+    void add_sync_statistics           (void);
+
+    /**
+     * \brief Account for a new epoch in the current chunk file, closing it
+     *        and opening the next one when it is already full (either by
+     *        number of epochs or by size, see set_max_chunk_size()).
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 2: I/O error closing the current chunk file.
+     *        - 6: The width of the numeric suffix is not big enough to
+     *             allow for more chunk file names.
+     *        - 7: I/O error: unable to create a new file chunk.
+     */
+
+    int  begin_epoch                   (void);
+
+    /**
+     * \brief Create the writer of a new chunk file, according to the
+     *        format and settings of the data channel.
+     *
+     * \return The new (not open yet) file writer.
+     */
+
+    obs_e_based_file_writer*
+         new_file_writer               (void);
+
+  protected:
+
+    /// \brief Flag. When true, a chunk manifest is written when closing
+    /// the data channel (see set_chunk_manifest()).
+
+    bool                            chunk_manifest_is_enabled_;
+
+    /// \brief Maximum number of records in a column block, when writing
+    /// columnar chunk files (0: the chunk files are not columnar).
+
+    int                             columnar_block_size_;
+
+    /// \brief Time tag of the first epoch of the current chunk.
+
+    double                          chunk_first_time_;
+
+    /// \brief Time tag of the last epoch of the current chunk.
+
+    double                          chunk_last_time_;
+
+    /// \brief Number of records written to the current chunk.
+
+    long long                       chunk_n_records_;
+
     /// \brief The chunk files name generator.
 
     segmented_file_utils            chunk_names_generator_;
@@ -395,6 +696,11 @@ class observation_writer
 
     int                             already_written_epochs_;
 
+    /// \brief Flag stating if the file writers must write their buffers in
+    /// the background.
+
+    bool                            async_flush_;
+
     /// \brief Flag. When true, indicates that the underlying data
     /// channel is open.
 
@@ -410,6 +716,14 @@ class observation_writer
 
     bool                            data_channel_is_socket_;
 
+    /// \brief Number of epochs or milliseconds between syncs.
+
+    int                             durability_interval_;
+
+    /// \brief When to sync the chunk files (see set_durability()).
+
+    int                             durability_policy_;
+
     /// \brief Base name of the external files written when working in
     /// external mode.
 
@@ -449,10 +763,23 @@ class observation_writer
 
     lineage_data*                   lineage_info_;
 
+    /// \brief Target size, in bytes, of a chunk file (0: no limit).
+
+    long long                       max_chunk_bytes_;
+
     /// \brief Maximum number of epochs to write in a single chunk file.
 
     int                             max_epochs_per_chunk_;
 
+    /// \brief Time, in seconds, taken by the slowest sync of the chunk
+    /// files already closed.
+
+    double                          max_sync_seconds_;
+
+    /// \brief Number of syncs of the chunk files already closed.
+
+    long long                       n_syncs_;
+
     /// \brief Width in characters of the numeric suffix used to identify
     /// the different chunk file names.
 
@@ -462,16 +789,35 @@ class observation_writer
 
     int                             port_;
 
+    /// \brief Flag. True when the space of the chunk files must be reserved
+    /// when these are created (see set_max_chunk_size()).
+
+    bool                            preallocate_chunks_;
+
     /// \brief Flag stating if the socket has to work as a server (listener)
     /// or not (client).
 
 
     bool                            socket_server_mode_;
 
+    /// \brief Window asked for when opening socket data channels (see
+    /// set_socket_window()).
+
+    int                             socket_window_;
+
     /// \brief Socket writer in charge to write observation data
     /// using a socket conection.
 
     observation_socket_writer*      socket_writer_;
+
+    /// \brief Time, in seconds, spent syncing the chunk files already
+    /// closed.
+
+    double                          sync_seconds_;
+
+    /// \brief Flag stating if time indexes must be created for the chunk files.
+
+    bool                            time_index_is_enabled_;
 };
 
 #endif // OBSERVATION_WRITER_HPP
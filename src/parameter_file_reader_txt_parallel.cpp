@@ -0,0 +1,25 @@
+/** \file parameter_file_reader_txt_parallel.cpp
+  \brief Implementation file for parameter_file_reader_txt_parallel.hpp.
+  \ingroup ASTROLABE_data_IO
+*/
+#include "parameter_file_reader_txt_parallel.hpp"
+
+parameter_file_reader_txt_parallel::
+parameter_file_reader_txt_parallel
+(void)
+{
+  {
+    // Parameter files hold l-records only.
+
+    o_records_allowed_ = false;
+  }
+}
+
+parameter_file_reader_txt_parallel::
+~parameter_file_reader_txt_parallel
+(void)
+{
+  {
+    // INTENTIONALLY LEFT BLANK.
+  }
+}
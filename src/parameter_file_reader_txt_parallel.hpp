@@ -0,0 +1,42 @@
+/** \file parameter_file_reader_txt_parallel.hpp
+  \brief Class defining the interface of multithreaded text parameter file readers.
+  \ingroup ASTROLABE_data_IO
+*/
+
+#ifndef PARAMETER_FILE_READER_TXT_PARALLEL_HPP
+#define PARAMETER_FILE_READER_TXT_PARALLEL_HPP
+
+#include "obs_e_based_file_reader_txt_parallel.hpp"
+
+/**
+ * @brief Class defining the interface of multithreaded text parameter file readers.
+ *
+ * \ingroup ASTROLABE_data_IO
+ *
+ * This class implements the interface defined in parent class
+ * obs_e_based_file_reader_txt_parallel, reading parameter files stored in
+ * text format in forward direction, as parameter_file_reader_txt_forward
+ * does, but parsing the file with a pool of worker threads.
+ *
+ * Parameter files hold l-records only; o-records are reported as
+ * malformed records.
+ */
+
+class parameter_file_reader_txt_parallel : public obs_e_based_file_reader_txt_parallel
+{
+  public:
+
+    /**
+     * @brief Default constructor.
+     */
+
+                 parameter_file_reader_txt_parallel  (void);
+
+    /**
+     * @brief Destructor.
+     */
+
+                 ~parameter_file_reader_txt_parallel (void);
+};
+
+#endif // PARAMETER_FILE_READER_TXT_PARALLEL_HPP
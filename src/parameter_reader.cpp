@@ -107,6 +107,7 @@ parameter_reader
 
     socket_reader_               = NULL;
     socket_works_in_server_mode_ = true;
+    text_threads_                = 1;
 
     reading_first_epoch_         = true;
   }
@@ -285,6 +286,38 @@ const
   }
 }
 
+obs_e_based_file_reader*
+parameter_reader::
+new_file_reader
+(bool is_binary_file)
+{
+  obs_e_based_file_reader* reader;
+
+  {
+    parameter_file_reader_txt_parallel* txt_parallel_reader;
+
+    if (is_binary_file)
+    {
+      // Forward, binary file reader.
+      reader = new parameter_file_reader_bin_forward();
+    }
+    else if (text_threads_ != 1)
+    {
+      // Forward, multithreaded text file reader.
+      txt_parallel_reader = new parameter_file_reader_txt_parallel();
+      txt_parallel_reader->set_number_of_threads(text_threads_);
+      reader = txt_parallel_reader;
+    }
+    else
+    {
+      // Forward, text file reader.
+      reader = new parameter_file_reader_txt_forward();
+    }
+  }
+
+  return reader;
+}
+
 int
 parameter_reader::
 open
@@ -397,16 +430,7 @@ open
       // file type (text or binary).
       //
 
-      if (is_binary_file)
-      {
-        // Forward, binary file reader.
-        file_reader_ = new parameter_file_reader_bin_forward();
-      }
-      else
-      {
-        // Forward, text file reader.
-        file_reader_ = new parameter_file_reader_txt_forward();
-      }
+      file_reader_ = new_file_reader(is_binary_file);
 
       //
       // We may now try to open the actual underlying file using
@@ -509,6 +533,36 @@ read_l_data
   }
 }
 
+int
+parameter_reader::
+read_l_data_view
+(int                    n_tag_values,
+ astrolabe_double_view& the_tags,
+ int                    n_expectation_values,
+ astrolabe_double_view& the_expectations,
+ int&                   n_covariance_values_found,
+ astrolabe_double_view& the_covariance_values)
+{
+  {
+    if (data_channel_is_socket_)
+    {
+      // Sockets.
+
+      return socket_reader_->read_l_data_view(n_tag_values,              the_tags,
+                                              n_expectation_values,      the_expectations,
+                                              n_covariance_values_found, the_covariance_values);
+    }
+    else
+    {
+      // Files.
+
+      return file_reader_->read_l_data_view(n_tag_values,              the_tags,
+                                            n_expectation_values,      the_expectations,
+                                            n_covariance_values_found, the_covariance_values);
+    }
+  }
+}
+
 int
 parameter_reader::
 read_instance_id
@@ -697,16 +751,7 @@ read_type
         is_binary_file
           = (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE);
 
-        if (is_binary_file)
-        {
-          // Forward, binary file reader.
-          file_reader_ = new parameter_file_reader_bin_forward();
-        }
-        else
-        {
-          // Forward, text file reader.
-          file_reader_ = new parameter_file_reader_txt_forward();
-        }
+        file_reader_ = new_file_reader(is_binary_file);
 
         //
         // Open the new chunk. If this fails, we'll return an
@@ -809,6 +854,26 @@ set_header_file
   }
 }
 
+int
+parameter_reader::
+set_number_of_threads
+(int n_threads)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (n_threads < 0) return 2;
+
+    text_threads_ = n_threads;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 parameter_reader::
 set_schema_file
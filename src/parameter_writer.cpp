@@ -1,5 +1,25 @@
 #include "parameter_writer.hpp"
 
+void
+parameter_writer::
+add_sync_statistics
+(void)
+{
+  {
+    double    max_seconds;
+    long long n_syncs;
+    double    seconds;
+
+    // Chunk file writers are destroyed once closed; keep their figures.
+
+    file_writer_->get_sync_statistics(n_syncs, seconds, max_seconds);
+
+    n_syncs_      += n_syncs;
+    sync_seconds_ += seconds;
+    if (max_seconds > max_sync_seconds_) max_sync_seconds_ = max_seconds;
+  }
+}
+
 int
 parameter_writer::
 close
@@ -37,6 +57,7 @@ close
       if (file_writer_->is_open())
       {
         status = file_writer_->close();
+        add_sync_statistics();
         delete file_writer_;
         file_writer_ = NULL;
 
@@ -63,6 +84,8 @@ parameter_writer
     data_channel_is_open_   = false;
     data_channel_is_set_    = false;
     data_channel_is_socket_ = false;
+    durability_interval_    = 0;
+    durability_policy_      = _ASTROLABE_DURABILITY_NONE;
     external_base_file_     = "";
     file_mode_is_binary_    = false;
     file_writer_            = NULL;
@@ -72,10 +95,14 @@ parameter_writer
     last_time_tag_          = 0.0;
     lineage_info_           = NULL;
     max_epochs_per_chunk_   = 0;
+    max_sync_seconds_       = 0;
+    n_syncs_                = 0;
     numeric_suffix_width_   = 0;
     port_                   = 0;
     socket_server_mode_     = false;
+    socket_window_          = 1;
     socket_writer_          = NULL;
+    sync_seconds_           = 0;
   }
 }
 
@@ -90,6 +117,36 @@ parameter_writer::
   }
 }
 
+void
+parameter_writer::
+get_sync_statistics
+(long long& n_syncs,
+ double&    seconds,
+ double&    max_seconds)
+const
+{
+  {
+    double    chunk_max_seconds;
+    long long chunk_n_syncs;
+    double    chunk_seconds;
+
+    n_syncs     = n_syncs_;
+    seconds     = sync_seconds_;
+    max_seconds = max_sync_seconds_;
+
+    // Add the figures of the chunk file being written, if any.
+
+    if (file_writer_ != NULL)
+    {
+      file_writer_->get_sync_statistics(chunk_n_syncs, chunk_seconds, chunk_max_seconds);
+
+      n_syncs += chunk_n_syncs;
+      seconds += chunk_seconds;
+      if (chunk_max_seconds > max_seconds) max_seconds = chunk_max_seconds;
+    }
+  }
+}
+
 bool
 parameter_writer::  
 is_open
@@ -129,6 +186,7 @@ open
       // Sockets.
 
       socket_writer_ = new parameter_socket_writer();
+      socket_writer_->set_window(socket_window_);
       status = socket_writer_->open(host_.c_str(), port_, socket_server_mode_);
       if (status != 0) return status;
     }
@@ -172,6 +230,8 @@ open
 
         file_writer_ = new parameter_file_writer_bin();
 
+        file_writer_->set_durability(durability_policy_, durability_interval_);
+
         // Open the writer. Beware of errors!
 
         status = file_writer_->open(chunk_filename.c_str());
@@ -194,6 +254,8 @@ open
 
         file_writer_ = new parameter_file_writer_txt();
 
+        file_writer_->set_durability(durability_policy_, durability_interval_);
+
         // Open the writer. Beware of errors!
 
         status = file_writer_->open(chunk_filename.c_str());
@@ -318,6 +380,57 @@ set_data_channel
   }
 }
 
+int
+parameter_writer::
+set_durability
+(int policy,
+ int interval)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if ((policy < _ASTROLABE_DURABILITY_NONE) ||
+        (policy > _ASTROLABE_DURABILITY_CLOSE)) return 2;
+
+    // Periodic policies need a period.
+
+    if ((policy == _ASTROLABE_DURABILITY_EPOCHS) ||
+        (policy == _ASTROLABE_DURABILITY_MILLISECONDS))
+    {
+      if (interval <= 0) return 3;
+    }
+
+    durability_interval_ = interval;
+    durability_policy_   = policy;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+parameter_writer::
+set_socket_window
+(int n_records)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (n_records < 1) return 2;
+
+    socket_window_ = n_records;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 parameter_writer::
 write_l
@@ -410,6 +523,7 @@ write_l
 
           // Destroy the file writer.
 
+          add_sync_statistics();
           delete file_writer_;
           file_writer_ = NULL;
 
@@ -439,6 +553,8 @@ write_l
             file_writer_ = new parameter_file_writer_txt();
           }
 
+          file_writer_->set_durability(durability_policy_, durability_interval_);
+
           // Open the writer.
 
           status = file_writer_->open(chunk_filename.c_str());
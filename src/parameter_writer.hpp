@@ -89,6 +89,22 @@ class parameter_writer
      */
         ~parameter_writer                  (void);
 
+    /**
+     * \brief Retrieve the sync statistics of the file data channel.
+     *
+     * \param n_syncs Number of times the chunk files have been committed
+     *        to the storage device (see set_durability()).
+     * \param seconds Total time, in seconds, spent in these commits.
+     * \param max_seconds Time, in seconds, taken by the slowest one.
+     *
+     * Figures add up all the chunk files written so far, including the
+     * one being written, and are kept after closing the channel.
+     */
+
+    void get_sync_statistics           (long long&   n_syncs,
+                                        double&      seconds,
+                                        double&      max_seconds) const;
+
     /**
      * \brief Check if the underlying data channel has already been opened.
      *
@@ -271,6 +287,58 @@ class parameter_writer
                                         int          port,
                                         bool         server_mode);
 
+    /**
+     * \brief Select when the chunk files are committed to the storage
+     *        device.
+     *
+     * \param policy One of _ASTROLABE_DURABILITY_NONE,
+     *        _ASTROLABE_DURABILITY_EPOCHS, _ASTROLABE_DURABILITY_MILLISECONDS
+     *        or _ASTROLABE_DURABILITY_CLOSE.
+     * \param interval Number of epochs (_ASTROLABE_DURABILITY_EPOCHS) or
+     *        milliseconds (_ASTROLABE_DURABILITY_MILLISECONDS) between
+     *        syncs. Ignored by the other policies.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: Unknown policy.
+     *        - 3: The interval must be greater than zero.
+     *
+     * See obs_e_based_file_writer::set_durability(). Unless the policy is
+     * _ASTROLABE_DURABILITY_NONE, every chunk file is synced when closed.
+     * Periodic syncs are done by a helper thread, so writing does not wait
+     * for the device. Use get_sync_statistics() to tune the interval.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open(); by default, files are never synced.
+     */
+
+    int  set_durability                (int          policy,
+                                        int          interval);
+
+    /**
+     * \brief Let several records travel through socket data channels
+     *        without waiting for their acknowledgement.
+     *
+     * \param n_records Maximum number of records not acknowledged yet.
+     *        One (the default) keeps the stop-and-wait protocol, where
+     *        every record waits for its acknowledgement.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: The window must be greater than zero.
+     *
+     * See obs_e_based_socket_writer::set_window(). A window greater than one
+     * is asked for when the connection is opened, so the reader must
+     * understand the windowed protocol; otherwise, open() fails.
+     *
+     * This setting has no effect on file data channels. It must be
+     * decided before calling open().
+     */
+
+    int  set_socket_window             (int          n_records);
+
     /**
      * \brief Write an l-record.
      *
@@ -323,6 +391,15 @@ class parameter_writer
                                         double*      buffer_covariance);
 
 
+  protected:
+
+    /**
+     * \brief Add the sync statistics of the chunk file writer to those
+     *        of the channel, before destroying it.
+     */
+
+    void add_sync_statistics           (void);
+
   protected:
 
     /// \brief The chunk files name generator.
@@ -349,6 +426,14 @@ class parameter_writer
 
     bool                            data_channel_is_socket_;
 
+    /// \brief Number of epochs or milliseconds between syncs.
+
+    int                             durability_interval_;
+
+    /// \brief When to sync the chunk files (see set_durability()).
+
+    int                             durability_policy_;
+
     /// \brief Base name of the external files written when working in
     /// external mode.
 
@@ -392,6 +477,15 @@ class parameter_writer
 
     int                             max_epochs_per_chunk_;
 
+    /// \brief Time, in seconds, taken by the slowest sync of the chunk
+    /// files already closed.
+
+    double                          max_sync_seconds_;
+
+    /// \brief Number of syncs of the chunk files already closed.
+
+    long long                       n_syncs_;
+
     /// \brief Width in characters of the numeric suffix used to identify
     /// the different chunk file names.
 
@@ -407,10 +501,20 @@ class parameter_writer
 
     bool                            socket_server_mode_;
 
+    /// \brief Window asked for when opening socket data channels (see
+    /// set_socket_window()).
+
+    int                             socket_window_;
+
     /// \brief Socket writer in charge to write parameter data
     /// using a socket conection.
 
     parameter_socket_writer*        socket_writer_;
+
+    /// \brief Time, in seconds, spent syncing the chunk files already
+    /// closed.
+
+    double                          sync_seconds_;
 };
 
 #endif // PARAMETER_WRITER_HPP
@@ -10,6 +10,8 @@
 #include <cstring>
 #include <cstdio>
 
+#include "astrolabe_file_utilities.hpp"
+
 using namespace std;
 
 /// @brief Default buffer size: 5 Mbyte (5 * 1024 * 1024 bytes)
@@ -448,7 +450,7 @@ class r_matrix_based_file_reader
 
     /// @brief Actual size of the file read (in bytes).
 
-    long          file_size_;
+    long long     file_size_;
 
     /// @brief Flag. When true, the file has been completely read, so no
     /// more data is available.
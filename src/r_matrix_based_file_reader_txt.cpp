@@ -348,12 +348,9 @@ parse_double_value
 (double& dvalue)
 {
   {
-    char   chr;
-    void*  destination;
-    void*  source;
-    int    text_end;
-    int    text_size;
-    int    text_start;
+    char        chr;
+    const char* text_end;
+    const char* text_start;
 
     //
     // Skip any whitespace that might be present before the text representing
@@ -368,45 +365,32 @@ parse_double_value
       chr = data_buffer_[cur_record_cur_];
     }
 
-    text_start = cur_record_cur_;
-
-    //
-    // Skip all non-whitespace characters. These are the characters that
-    // presumably may be interpreted as a double.
     //
-    // Note that the loop is also aborted if an opening < is found. This
-    // specific test is made to deal with the situation in which the last
-    // double in a record is adjacent to the closing tag, thus allowing
-    // no spaces between these two elements.
+    // Convert the text in place, directly from the data buffer. Note that
+    // the conversion may not go beyond the end of the current record.
     //
 
-    while ((!is_whitespace(chr)) && (chr != '<'))
+    text_start = &(data_buffer_[cur_record_cur_]);
+    text_end   = &(data_buffer_[cur_record_end_ + 1]);
+
+    if (astr_parse_double(text_start, text_end, dvalue, &text_end) != 0)
     {
-      cur_record_cur_++;
-      chr = data_buffer_[cur_record_cur_];
+      // The text read does not represent a legal double value!!!
+      return 1;
     }
 
-    text_end = cur_record_cur_ - 1;
-    text_size = text_end - text_start + 1;
+    cur_record_cur_ += (int)(text_end - text_start);
 
     //
-    // Guarantee that our internal text buffer is big enough to hold the
-    // set of characters just read.
+    // The value must be followed by whitespace or by an opening <. This
+    // last test is made to deal with the situation in which the last
+    // double in a record is adjacent to the closing tag, thus allowing
+    // no spaces between these two elements.
     //
 
-    guarantee_text_buffer_size(text_size + 1); // Includes final NULL character.
-
-    // Copy the text in the data buffer (source) to our local copy (destination).
-
-    source      = (void*)&(data_buffer_[text_start]);
-    destination = (void*)text_buffer_;
-
-    memcpy(destination, source, (size_t)text_size);
-    text_buffer_[text_size] = 0; // Ending NULL character.
-
-    // Try to convert the text just obtained to a binary double value.
+    chr = data_buffer_[cur_record_cur_];
 
-    if (sscanf(text_buffer_, "%lf", &dvalue) == EOF)
+    if ((!is_whitespace(chr)) && (chr != '<'))
     {
       // The text read does not represent a legal double value!!!
       return 1;
@@ -424,12 +408,9 @@ parse_int_value
 (int& ivalue)
 {
   {
-    char  chr;
-    void* destination;
-    void* source;
-    int   text_end;
-    int   text_size;
-    int   text_start;
+    char        chr;
+    const char* text_end;
+    const char* text_start;
 
     //
     // Skip any whitespace that might be present before the text representing
@@ -444,45 +425,28 @@ parse_int_value
       chr = data_buffer_[cur_record_cur_];
     }
 
-    text_start = cur_record_cur_;
-
     //
-    // Skip all digit characters. These are the the ones that
-    // presumably may be interpreted as an integer.
+    // Only digits are accepted (no sign). Convert them in place, directly
+    // from the data buffer.
     //
 
-    while ((chr >= '0')  && (chr <= '9')) 
+    if ((chr < '0') || (chr > '9'))
     {
-      cur_record_cur_++;
-      chr = data_buffer_[cur_record_cur_];
+      //  The text read does not represent a legal integer value!!!
+      return 1;
     }
 
-    text_end = cur_record_cur_ - 1;
-    text_size = text_end - text_start + 1;
-
-    //
-    // Guarantee that our internal text buffer is big enough to hold the
-    // set of characters just read.
-    //
-
-    guarantee_text_buffer_size(text_size + 1); // Includes final NULL character.
-
-    // Copy the text in the data buffer (source( to our local copy (destination).
+    text_start = &(data_buffer_[cur_record_cur_]);
+    text_end   = &(data_buffer_[cur_record_end_ + 1]);
 
-    source      = (void*)&(data_buffer_[text_start]);
-    destination = (void*)text_buffer_;
-
-    memcpy(destination, source, (size_t)text_size);
-    text_buffer_[text_size] = 0; // Ending NULL character.
-
-    // Try to convert the text just obtained to a binary integer value.
-
-    if (sscanf(text_buffer_, "%d", &ivalue) == EOF)
+    if (astr_parse_int(text_start, text_end, ivalue, &text_end) != 0)
     {
       //  The text read does not represent a legal integer value!!!
       return 1;
     }
 
+    cur_record_cur_ += (int)(text_end - text_start);
+
     // That's all.
 
     return 0;
@@ -9,6 +9,7 @@
 #include <string>
 #include <map>
 
+#include "astrolabe_number_parser.hpp"
 #include "r_matrix_based_file_reader.hpp"
 
 /**
@@ -42,17 +42,62 @@ const
   return result;
 }
 
+int
+r_matrix_based_file_writer::
+commit_epochs
+(void)
+{
+  {
+    bool due;
+
+    // Every r-record is an epoch. See obs_e_based_file_writer::commit_epochs().
+
+    due = false;
+
+    if (epochs_since_sync_ > 0)
+    {
+      if (durability_policy_ == _ASTROLABE_DURABILITY_EPOCHS)
+      {
+        due = (epochs_since_sync_ >= durability_interval_);
+      }
+      else if (durability_policy_ == _ASTROLABE_DURABILITY_MILLISECONDS)
+      {
+        due = (chrono::steady_clock::now() - last_sync_) >= chrono::milliseconds(durability_interval_);
+      }
+    }
+
+    if (due)
+    {
+      if (write_behind_.write(data_buffer_, data_buffer_cur_, true) != 0) return 1;
+
+      data_buffer_cur_   = 0;
+      epochs_since_sync_ = 0;
+      last_sync_         = chrono::steady_clock::now();
+    }
+
+    epochs_since_sync_++;
+
+    return 0;
+  }
+}
+
 r_matrix_based_file_writer::
 r_matrix_based_file_writer
 (void)
 {
   {
+    async_flush_         = false;
     data_buffer_         = NULL;
     data_buffer_cur_     = 0;
     data_buffer_size_    = _ASTROLABE_R_MATRIX_FILE_WRITER_DEFAULT_BUFFER_SIZE;
+    durability_interval_ = 0;
+    durability_policy_   = _ASTROLABE_DURABILITY_NONE;
+    epochs_since_sync_   = 0;
     file_file_           = NULL;
     file_name_           = NULL;
     file_is_open_        = false;
+    preallocation_bytes_ = 0;
+    preallocated_        = false;
   }
 }
 
@@ -73,22 +118,58 @@ r_matrix_based_file_writer::
 
 int
 r_matrix_based_file_writer::
-flush
+finish_flushing
 (void)
 {
   {
-    size_t bytes_written;
+    int status;
+
+    status = 0;
+
+    //
+    // Give back the space reserved but not used. The data must be in the
+    // file, so wait for the buffer being written in the background, if any.
+    //
+
+    if (preallocated_)
+    {
+      if (write_behind_.wait()      != 0) status = 1;
+      if (astr_ftruncate(file_file_) != 0) status = 1;
+
+      preallocated_ = false;
+    }
+
+    // All the policies but "none" make sure the data is on the device.
+
+    if (durability_policy_ != _ASTROLABE_DURABILITY_NONE)
+    {
+      if (write_behind_.sync() != 0) status = 1;
+    }
+
+    // Wait for the helper thread, if any, and release the second buffer.
 
+    if (write_behind_.detach() != 0) status = 1;
+
+    return status;
+  }
+}
+
+int
+r_matrix_based_file_writer::
+flush
+(void)
+{
+  {
     // If there's no data to dump, simply return (no errors).
 
     if (data_buffer_cur_ == 0) return 0;
 
-    // Write the current contents of the data buffer to disk.
+    //
+    // Write the current contents of the data buffer to disk. When writing
+    // in the background, the buffer is swapped for an empty one instead.
+    //
 
-    bytes_written = fwrite((void*)data_buffer_, 1, (size_t)data_buffer_cur_, file_file_);
-    if (bytes_written != (size_t)data_buffer_cur_) return 1;
-
-    fflush(file_file_);
+    if (write_behind_.write(data_buffer_, data_buffer_cur_, false) != 0) return 1;
 
     // Reset pointers and flags.
 
@@ -100,6 +181,47 @@ flush
   }
 }
 
+long long
+r_matrix_based_file_writer::
+get_bytes_stored
+(void)
+const
+{
+  {
+    long long bytes_flushed;
+    double    seconds;
+
+    write_behind_.get_statistics(bytes_flushed, seconds);
+
+    return bytes_flushed + data_buffer_cur_;
+  }
+}
+
+void
+r_matrix_based_file_writer::
+get_sync_statistics
+(long long& n_syncs,
+ double&    seconds,
+ double&    max_seconds)
+const
+{
+  {
+    write_behind_.get_sync_statistics(n_syncs, seconds, max_seconds);
+  }
+}
+
+void
+r_matrix_based_file_writer::
+get_write_statistics
+(long long& bytes_written,
+ double&    seconds)
+const
+{
+  {
+    write_behind_.get_statistics(bytes_written, seconds);
+  }
+}
+
 bool
 r_matrix_based_file_writer::
 is_open
@@ -156,12 +278,69 @@ open
 
     file_name_ = strdup(file_name);
 
+    //
+    // Reserve the space of the file, if asked to. This is just an
+    // optimization, so the file simply grows as usual should it fail.
+    //
+
+    preallocated_ = false;
+
+    if (preallocation_bytes_ > 0)
+    {
+      preallocated_ = (astr_fpreallocate(file_file_, preallocation_bytes_) == 0);
+    }
+
+    //
+    // All the buffers are written through write_behind_ (see set_async_flush()).
+    // Periodic syncs are kept off the calling thread (see set_durability()).
+    //
+
+    write_behind_.attach(file_file_, 0);
+
+    //
+    // With the milliseconds policy, the helper thread also syncs on its
+    // own the buffers already written, so these are not kept waiting for
+    // the next epoch boundary.
+    //
+
+    if (durability_policy_ == _ASTROLABE_DURABILITY_MILLISECONDS)
+    {
+      write_behind_.set_sync_interval(durability_interval_);
+    }
+
+    if (async_flush_                                           ||
+        (durability_policy_ == _ASTROLABE_DURABILITY_EPOCHS)   ||
+        (durability_policy_ == _ASTROLABE_DURABILITY_MILLISECONDS))
+    {
+      write_behind_.start(data_buffer_size_);
+    }
+
+    epochs_since_sync_ = 0;
+    last_sync_         = chrono::steady_clock::now();
+
     // Successful completion.
 
     return 0;
   }
 }
 
+int
+r_matrix_based_file_writer::
+set_async_flush
+(bool enabled)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    async_flush_ = enabled;
+
+    // Bye.
+
+    return 0;
+  }
+}
+
 int
 r_matrix_based_file_writer::
 set_buffer_size
@@ -184,3 +363,52 @@ set_buffer_size
   }
 }
 
+int
+r_matrix_based_file_writer::
+set_durability
+(int policy,
+ int interval)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    if ((policy < _ASTROLABE_DURABILITY_NONE) ||
+        (policy > _ASTROLABE_DURABILITY_CLOSE)) return 2;
+
+    // Periodic policies need a period.
+
+    if ((policy == _ASTROLABE_DURABILITY_EPOCHS) ||
+        (policy == _ASTROLABE_DURABILITY_MILLISECONDS))
+    {
+      if (interval <= 0) return 3;
+    }
+
+    durability_interval_ = interval;
+    durability_policy_   = policy;
+
+    // Bye.
+
+    return 0;
+  }
+}
+
+int
+r_matrix_based_file_writer::
+set_preallocation
+(long long n_bytes)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    // The size must not be negative.
+    if (n_bytes < 0)   return 2;
+
+    preallocation_bytes_ = n_bytes;
+
+    // Bye.
+
+    return 0;
+  }
+}
@@ -10,6 +10,8 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include "astrolabe_write_behind.hpp"
+
 using namespace std;
 
 /// @brief Default buffer size: 5 Mbyte (5 * 1024 * 1024 bytes)
@@ -37,6 +39,10 @@ using namespace std;
  *   may be set using method set_buffer_size(). Note that all descendant
  *   classes must provide with a default buffer size that would be used
  *   if a calling module makes no decisions on this subject.
+ * - Optionally, the buffer may be written to disk in the background
+ *   (see set_async_flush()).
+ * - Optionally, the data may be committed to the storage device from time
+ *   to time (see set_durability()).
  * - The writer must be associated to a physical output file using
  *   method open(). This action enables actual I/O operations.
  * - A series of r-records may be written using method write_r().
@@ -119,6 +125,48 @@ class r_matrix_based_file_writer
      * @return True if the file has already been opened, false otherwise.
      */
 
+    /**
+     * @brief Retrieve the number of bytes stored so far in the file.
+     *
+     * @return Bytes flushed from the internal buffer plus those still
+     *         waiting in it.
+     *
+     * Segmented writers use this figure to decide when to start a new
+     * chunk (see r_matrix_writer::set_max_chunk_size()).
+     */
+
+    virtual long long get_bytes_stored      (void) const;
+
+    /**
+     * @brief Retrieve the sync statistics of the writer.
+     *
+     * @param n_syncs Number of times the file has been committed to the
+     *        storage device (see set_durability()).
+     * @param seconds Total time, in seconds, spent in these commits.
+     * @param max_seconds Time, in seconds, taken by the slowest one.
+     *
+     * Statistics refer to the file opened last and are kept after
+     * closing it.
+     */
+
+    virtual void get_sync_statistics        (long long&   n_syncs,
+                                             double&      seconds,
+                                             double&      max_seconds) const;
+
+    /**
+     * @brief Retrieve the I/O statistics of the writer.
+     *
+     * @param bytes_written Number of bytes flushed from the internal buffer.
+     * @param seconds Time, in seconds, the calling module has been blocked
+     *        while the buffer was written to disk.
+     *
+     * Statistics refer to the file opened last and are kept after
+     * closing it.
+     */
+
+    virtual void get_write_statistics       (long long&   bytes_written,
+                                             double&      seconds) const;
+
     virtual bool is_open                    (void) const;
 
     /**
@@ -185,8 +233,78 @@ class r_matrix_based_file_writer
      * details.
      */
 
+    /**
+     * @brief Enable or disable writing the internal buffer in the background.
+     *
+     * @param enabled True to write the buffer in a helper thread, false
+     *        to write it in the thread calling write_r().
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *
+     * See obs_e_based_file_writer::set_async_flush(); r-records are
+     * written the same way l- and o-records are.
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked. By default, buffers
+     * are written in the thread calling the writer.
+     */
+
+    virtual int  set_async_flush            (bool         enabled);
+
     virtual int  set_buffer_size            (int          buffer_size);
 
+    /**
+     * @brief Select when the data written is committed to the storage
+     *        device.
+     *
+     * @param policy One of _ASTROLABE_DURABILITY_NONE,
+     *        _ASTROLABE_DURABILITY_EPOCHS, _ASTROLABE_DURABILITY_MILLISECONDS
+     *        or _ASTROLABE_DURABILITY_CLOSE.
+     * @param interval Number of r-records (_ASTROLABE_DURABILITY_EPOCHS) or
+     *        milliseconds (_ASTROLABE_DURABILITY_MILLISECONDS) between
+     *        syncs. Ignored by the other policies.
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *         - 2: Unknown policy.
+     *         - 3: The interval must be greater than zero.
+     *
+     * See obs_e_based_file_writer::set_durability(); every r-record is a
+     * whole epoch, so syncs take place between r-records.
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked. By default, files are
+     * never synced (_ASTROLABE_DURABILITY_NONE).
+     */
+
+    virtual int  set_durability             (int          policy,
+                                             int          interval);
+
+    /**
+     * @brief Set the space to reserve on the storage device when opening
+     *        the file.
+     *
+     * @param n_bytes Size, in bytes, the file is expected to reach. Zero
+     *        disables preallocation.
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *         - 2: The size must not be negative.
+     *
+     * See obs_e_based_file_writer::set_preallocation(). The space not
+     * used is given back when the file is closed.
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked. By default, no space
+     * is reserved.
+     */
+
+    virtual int  set_preallocation          (long long    n_bytes);
+
     /**
      * @brief Write an r-record.
      *
@@ -227,8 +345,40 @@ class r_matrix_based_file_writer
 
     virtual int  flush                     (void);
 
+    /**
+     * @brief Wait until all the data flushed has been written to disk.
+     *
+     * @return Error code. Error code values:
+     *        - 0: successful completion.
+     *        - 1: Error detected while writing a buffer to disk.
+     *
+     * Descendant classes must call this method from close(), after the
+     * last call to flush() and before closing the file. The space not used
+     * by preallocated files (see set_preallocation()) is given back here.
+     */
+
+    int          finish_flushing           (void);
+
+    /**
+     * @brief Sync the r-records stored so far, if the durability policy
+     *        says so (see set_durability()).
+     *
+     * @return Error code. Error code values:
+     *        - 0: successful completion (or no sync due).
+     *        - 1: Error detected while writing the buffer or syncing.
+     *
+     * Descendant classes must call this method from write_r(), before
+     * storing the new r-record in the data buffer.
+     */
+
+    int          commit_epochs             (void);
+
   protected:
 
+    /// @brief Flag. When true, the buffer is written in a helper thread.
+
+    bool   async_flush_;
+
     /// @brief The data_buffer_ used to store the data to write.
 
     char*  data_buffer_;
@@ -243,6 +393,18 @@ class r_matrix_based_file_writer
 
     int    data_buffer_size_;
 
+    /// @brief Number of r-records or milliseconds between syncs.
+
+    int    durability_interval_;
+
+    /// @brief When to sync the file (see set_durability()).
+
+    int    durability_policy_;
+
+    /// @brief Number of r-records written since the last sync.
+
+    int    epochs_since_sync_;
+
     /// @brief The file handled by the writer.
 
     FILE*  file_file_;
@@ -255,6 +417,23 @@ class r_matrix_based_file_writer
 
     bool   file_is_open_;
 
+    /// @brief When the file was last synced (or opened).
+
+    chrono::steady_clock::time_point last_sync_;
+
+    /// @brief Bytes to reserve for the file when opening it (0: none).
+
+    long long preallocation_bytes_;
+
+    /// @brief Flag. True when the space of the file has been reserved, so
+    /// it must be truncated when closed.
+
+    bool   preallocated_;
+
+    /// @brief Writes the contents of data_buffer_ to the file, maybe in
+    /// the background.
+
+    astrolabe_write_behind write_behind_;
 };
 
 #endif // R_MATRIX_BASED_FILE_WRITER_HPP
@@ -61,6 +61,20 @@ backtrack_to_previous_record
   }
 }
 
+int
+r_matrix_file_reader_bin_backward::
+close
+(void)
+{
+  {
+    // Forget about the file before closing it.
+
+    read_ahead_.detach();
+
+    return r_matrix_based_file_reader::close();
+  }
+}
+
 r_matrix_file_reader_bin_backward::
 r_matrix_file_reader_bin_backward
 (void)
@@ -72,6 +86,7 @@ r_matrix_file_reader_bin_backward
     record_remaining_bytes_     = -1;
     chunk_start_index_          = -1;
     file_bytes_unread_          =  0;
+    reverse_window_size_        = _ASTROLABE_R_MATRIX_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE;
   }
 }
 
@@ -84,6 +99,18 @@ r_matrix_file_reader_bin_backward::
   }
 }
 
+void
+r_matrix_file_reader_bin_backward::
+get_read_statistics
+(long long& bytes_read,
+ double&    seconds)
+const
+{
+  {
+    read_ahead_.get_statistics(bytes_read, seconds);
+  }
+}
+
 int
 r_matrix_file_reader_bin_backward::
 open
@@ -106,12 +133,12 @@ open
 
     // Ascertain how big is the file.
 
-    if (fseek(file_file_, 0 , SEEK_END) != 0)
+    if (astr_fseek(file_file_, 0 , SEEK_END) != 0)
     {
       return 5; // I/O error.
     }
 
-    file_size_         = ftell(file_file_);
+    file_size_         = astr_ftell(file_file_);
     file_bytes_unread_ = file_size_;
 
     // Try to create the buffer used for buffered reads.
@@ -127,7 +154,7 @@ open
       // If everything works, the file is reported as open.
       //
 
-      if (file_size_ < data_buffer_size_) data_buffer_size_ = file_size_;
+      if (file_size_ < data_buffer_size_) data_buffer_size_ = (int)file_size_;
 
       data_buffer_ = new char[data_buffer_size_];
       file_is_open_ = true;
@@ -145,14 +172,18 @@ open
     }
 
     //
-    // Read as much bytes as possible (maximum: data_buffer_size_)
-    // from the underlying binary file.
-    //
-    // Since this is the first read operation, we must guarantee that
-    // the fseek pointer indicates the end of the file.
+    // Chunks are read through read_ahead_, which asks the system to load
+    // in advance the region preceding every chunk, since its own read-ahead
+    // policy is of no use when reading backwards.
     //
 
-    fseek(file_file_, 0, SEEK_END);
+    read_ahead_.attach(file_file_, file_size_);
+    read_ahead_.set_reverse_window(reverse_window_size_);
+
+    //
+    // Read as much bytes as possible (maximum: data_buffer_size_)
+    // from the underlying binary file, starting at its end.
+    //
 
     read_status = read_prev_chunk();
 
@@ -308,8 +339,8 @@ read_prev_chunk
   {
     int    backtrack_index;
     int    bytes_in_record;
-    long   bytes_read;
-    long   bytes_to_read;
+    int    bytes_read;
+    int    bytes_to_read;
     int    offset;
     int    new_offset;
     int    previous_backtrack_index;
@@ -329,7 +360,7 @@ read_prev_chunk
     // Ascertain how many bytes may be read at once.
 
     bytes_to_read = data_buffer_size_;
-    if (bytes_to_read > file_bytes_unread_) bytes_to_read = file_bytes_unread_;
+    if (bytes_to_read > file_bytes_unread_) bytes_to_read = (int)file_bytes_unread_;
 
     if (bytes_to_read == 0)
     {
@@ -345,18 +376,13 @@ read_prev_chunk
     offset = data_buffer_size_ - (int)bytes_to_read;
 
     //
-    // Move the current position in the file bytes_to_read bytes backwards to
-    // be able to read forward later on. Note that we ASSUME that the file
-    // is positioned ("fseek-ed") at the beginning of the data block that
-    // has already been processed, starting with an 'r' tag (or just at
-    // the end of the file when no data has been read yet).
+    // Read the bytes_to_read bytes preceding the data block that has
+    // already been processed, starting with an 'r' tag (or the last
+    // bytes_to_read bytes in the file when no data has been read yet).
     //
 
-    fseek(file_file_, -bytes_to_read, SEEK_CUR);
-
-    // Read bytes_to_read bytes.
-
-    bytes_read = (int)fread((void*)&(data_buffer_[offset]), 1, bytes_to_read, file_file_);
+    bytes_read = (int)read_ahead_.read(file_bytes_unread_ - bytes_to_read,
+                                       (void*)&(data_buffer_[offset]), bytes_to_read);
     if (bytes_read != bytes_to_read)
     {
       //
@@ -455,15 +481,6 @@ read_prev_chunk
 
     file_bytes_unread_ -= bytes_read;
 
-    //
-    // We must update the fseek position, so the next time this method
-    // is invoked the fseek pointer points to the beginning of the
-    // buffer we've just read. Now, it is pointing to its END, so we
-    // must fseek -bytes_read backward.
-    //
-
-    fseek(file_file_, -bytes_read, SEEK_CUR);
-
     //
     // Now we know that we have an integral set of records starting at
     //   data_buffer_[offset]
@@ -588,3 +605,23 @@ read_type
     return 0;
   }
 }
+
+int
+r_matrix_file_reader_bin_backward::
+set_reverse_window
+(long long window_size)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    // Check the size.
+    if (window_size < 0) return 2;
+
+    reverse_window_size_ = window_size;
+
+    // Bye.
+
+    return 0;
+  }
+}
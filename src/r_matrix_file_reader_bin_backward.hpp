@@ -6,8 +6,14 @@
 #ifndef R_MATRIX_FILE_READER_BIN_BACKWARD_HPP
 #define R_MATRIX_FILE_READER_BIN_BACKWARD_HPP
 
+#include "astrolabe_read_ahead.hpp"
 #include "r_matrix_based_file_reader_bin.hpp"
 
+/// @brief Default size of the region that the reader asks the system to
+/// load in advance: 32 Mbyte (32 * 1024 * 1024 bytes)
+
+#define _ASTROLABE_R_MATRIX_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE 33554432
+
 /**
  * @brief Class defining the interface of backwards r_matrix binary file readers.
  *
@@ -26,12 +32,43 @@
  * The process finishes when the first record in the file has been read
  *(end-of-file or, better put, beginning-of-file condition).
  *
+ * Since the read-ahead policy of operating systems is of no use when
+ * reading files backwards, the reader asks the system to load in advance
+ * the region preceding the chunk being read (see set_reverse_window()).
+ * The throughput achieved may be checked using get_read_statistics().
+ *
  */
 
 class r_matrix_file_reader_bin_backward : public r_matrix_based_file_reader_bin
 {
   public:
 
+    /**
+     * @brief Close the file.
+     *
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: Unable to close the file.
+     */
+
+    virtual int  close                              (void);
+
+    /**
+     * @brief Retrieve the amount of data read from the file and the time
+     *        spent doing so.
+     *
+     * @param bytes_read Number of bytes read from the file to fill the
+     *        internal buffer.
+     * @param seconds Time, in seconds, the calling module has been blocked
+     *        waiting for these bytes.
+     *
+     * Statistics refer to the file opened last and are kept after
+     * closing it.
+     */
+
+    void         get_read_statistics                (long long& bytes_read,
+                                                     double&    seconds) const;
+
     /**
      * @brief Opens the reader, enabling I/O operations.
      *
@@ -196,6 +233,25 @@ class r_matrix_file_reader_bin_backward : public r_matrix_based_file_reader_bin
 
     virtual int  read_type                          (char& record_type);
 
+    /**
+     * @brief Set the size of the region of the file that the reader asks
+     *        the system to load in advance.
+     *
+     * @param window_size Size of the region, in bytes. 0 disables this
+     *        feature.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file is already open and therefore it is not
+     *             possible to change this setting.
+     *        - 2: Invalid (negative) size.
+     *
+     * This method may be called only after the reader object has been
+     * instantiated and before open() has been invoked. The default size is
+     * _ASTROLABE_R_MATRIX_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE.
+     */
+
+    int          set_reverse_window                 (long long window_size);
+
 
   protected:
 
@@ -276,7 +332,12 @@ class r_matrix_file_reader_bin_backward : public r_matrix_based_file_reader_bin
 
     /// @brief Number of bytes in the input file that have not been read yet.
 
-    int          file_bytes_unread_;
+    long long    file_bytes_unread_;
+
+    /// @brief Reads the chunks of the file, hinting the system about the
+    /// region preceding them.
+
+    astrolabe_read_ahead read_ahead_;
 
     /// @brief Index (in the data buffer) where the backtracking information
     /// for the current record is stored.
@@ -291,6 +352,10 @@ class r_matrix_file_reader_bin_backward : public r_matrix_based_file_reader_bin
     /// @brief Number of bytes still to be processed in the current record.
 
     int          record_remaining_bytes_;
+
+    /// @brief Size of the region hinted in advance (see set_reverse_window()).
+
+    long long    reverse_window_size_;
 };
 
 #endif // R_MATRIX_FILE_READER_BIN_BACKWARD_HPP
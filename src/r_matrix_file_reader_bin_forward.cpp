@@ -80,19 +80,19 @@ open
 
     // Ascertain how big is the file.
 
-    if (fseek(file_file_, 0 , SEEK_END) != 0)
+    if (astr_fseek(file_file_, 0 , SEEK_END) != 0)
     {
       return 5; // I/O error.
     }
 
-    file_size_ = ftell(file_file_);
+    file_size_ = astr_ftell(file_file_);
 
     //
     // Reset the fseek position, to be able to read from the start of the
     // file.
     //
 
-    fseek(file_file_, 0 , SEEK_SET);
+    astr_fseek(file_file_, 0 , SEEK_SET);
 
     // Try to create the buffer used for block reads.
 
@@ -107,7 +107,7 @@ open
       // If everything works, the file is reported as open.
       //
 
-      if (file_size_ < data_buffer_size_) data_buffer_size_ = file_size_;
+      if (file_size_ < data_buffer_size_) data_buffer_size_ = (int)file_size_;
 
       data_buffer_ = new char[data_buffer_size_];
       file_is_open_ = true;
@@ -4,6 +4,50 @@
 */ 
 #include "r_matrix_file_reader_txt_backward.hpp"
 
+//
+// Memory mapped files are available only on POSIX systems.
+//
+
+#ifndef _WIN32
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif // _WIN32
+
+int
+r_matrix_file_reader_txt_backward::
+close
+(void)
+{
+  {
+    // Do not complain if the file is already closed.
+
+    if (!file_is_open_) return 0;
+
+    //
+    // If memory mapped, unmap the file. The data buffer is set to NULL so
+    // the parent class does not try to delete it, and its size is restored
+    // to the one requested before opening the file.
+    //
+
+    #ifndef _WIN32
+    if (file_is_mapped_)
+    {
+      if (map_base_ != NULL) munmap((void*)map_base_, map_length_);
+
+      map_base_         = NULL;
+      map_length_       = 0;
+      data_buffer_      = NULL;
+      data_buffer_size_ = map_buffer_size_;
+      file_is_mapped_   = false;
+    }
+    #endif // _WIN32
+
+    // Close the file.
+
+    return r_matrix_based_file_reader_txt::close();
+  }
+}
+
 int
 r_matrix_file_reader_txt_backward::
 find_first_complete_record
@@ -396,19 +440,12 @@ find_record_bwd
 
     //
     // Look for the first opening '<' backwards, since we are trying to find a
-    // closing record tag.
+    // closing record tag. The search is made several bytes at a time; index
+    // becomes chunk_start_index_ - 1 if there is no '<'.
     //
 
-    index--;
-
-    while (index >= chunk_start_index_)
-    {
-      chr = data_buffer_[index];
-
-      if (chr == '<') break;
-
-      index--;
-    }
+    index = chunk_start_index_ +
+            delimiters_.find_last(&(data_buffer_[chunk_start_index_]), index - chunk_start_index_, '<');
 
     if (index < chunk_start_index_) return 1;
 
@@ -469,19 +506,12 @@ find_record_bwd
 
     //
     // Look for the next opening '<' backwards. Presumably, it will belong to
-    // the opening tag and will mark the beginning of the record.
+    // the opening tag and will mark the beginning of the record. Again,
+    // several bytes are searched at a time.
     //
 
-    index--;
-
-    while (index >= chunk_start_index_)
-    {
-      chr = data_buffer_[index];
-
-      if (chr == '<') break;
-
-      index--;
-    }
+    index = chunk_start_index_ +
+            delimiters_.find_last(&(data_buffer_[chunk_start_index_]), index - chunk_start_index_, '<');
 
     if (index < chunk_start_index_) return 2; // Malformed record found.
 
@@ -547,13 +577,14 @@ find_record_fwd
 (int from,  int& start, int& end)
 {
   {
-    char chr;
-    int  i;
-    int  index;
-    int  j;
-    int  k;
-    int  opening_tag_end;
-    int  text_size;
+    char        chr;
+    const char* found;
+    int         i;
+    int         index;
+    int         j;
+    int         k;
+    int         opening_tag_end;
+    int         text_size;
 
     if (from >= data_buffer_size_) return 1; // Reached the end of the buffer.
 
@@ -636,36 +667,23 @@ find_record_fwd
 
     index++;
 
-    while (index < data_buffer_size_)
-    {
-      chr = data_buffer_[index];
+    found = (const char*)memchr(&(data_buffer_[index]), '>', data_buffer_size_ - index);
 
-      if (chr == '>') break;
-
-      index++;
-    }
-
-    if (index >= data_buffer_size_) return 1;
+    if (found == NULL) return 1;
 
     // index points now to the end of the record.
 
-    end = index;
+    index = (int)(found - data_buffer_);
+    end   = index;
 
     //
     // Now, we'll try to find the first opening '<' backwards, which, presumably,
-    // will be part of the closing tag.
+    // will be part of the closing tag. k becomes opening_tag_end if there
+    // is none.
     //
 
-    k = end - 1;
-
-    while (k > opening_tag_end)
-    {
-      chr = data_buffer_[k];
-
-      if (chr == '<') break;
-
-      k--;
-    }
+    k = opening_tag_end + 1 +
+        delimiters_.find_last(&(data_buffer_[opening_tag_end + 1]), end - opening_tag_end - 1, '<');
 
     if (k <= opening_tag_end) return 2; // Malformed record found.
 
@@ -726,6 +744,95 @@ find_record_fwd
   }
 }
 
+bool
+r_matrix_file_reader_txt_backward::
+is_memory_mapped
+(void)
+const
+{
+  {
+    return file_is_open_ ? file_is_mapped_ : memory_mapped_;
+  }
+}
+
+int
+r_matrix_file_reader_txt_backward::
+map_file
+(void)
+{
+  {
+    #ifndef _WIN32
+
+    void* new_base;
+
+    // The whole file must fit in the address space.
+
+    if ((long long)(size_t)file_size_ != file_size_) return 1;
+
+    new_base = mmap(NULL, (size_t)file_size_, PROT_READ, MAP_PRIVATE, fileno(file_file_), 0);
+
+    if (new_base == MAP_FAILED) return 1;
+
+    map_base_   = (char*)new_base;
+    map_length_ = (size_t)file_size_;
+
+    // That's all.
+
+    return 0;
+
+    #else
+
+    // Memory mapped files not available on this platform.
+
+    return 1;
+
+    #endif // _WIN32
+  }
+}
+
+int
+r_matrix_file_reader_txt_backward::
+map_prev_chunk
+(void)
+{
+  {
+    int       bytes_to_map;
+
+    #ifndef _WIN32
+    long long hint_start;
+    #endif // _WIN32
+
+    //
+    // The window ends where the data already processed starts, and is as
+    // big as possible (but no more than map_window_size_ bytes).
+    //
+
+    bytes_to_map = map_window_size_;
+    if (bytes_to_map > file_bytes_unread_) bytes_to_map = (int)file_bytes_unread_;
+
+    data_buffer_      = map_base_ + (file_bytes_unread_ - bytes_to_map);
+    data_buffer_size_ = bytes_to_map;
+
+    //
+    // Ask the system to load this window and the one preceding it, since
+    // its own read-ahead policy is of no use when reading backwards. This
+    // is just a hint, so errors are ignored. Addresses must be page aligned.
+    //
+
+    #ifndef _WIN32
+    hint_start = file_bytes_unread_ - bytes_to_map - map_window_size_;
+    if (hint_start < 0) hint_start = 0;
+    hint_start -= hint_start % (long long)sysconf(_SC_PAGESIZE);
+
+    madvise((void*)(map_base_ + hint_start), (size_t)(file_bytes_unread_ - hint_start), MADV_WILLNEED);
+    #endif // _WIN32
+
+    // That's all.
+
+    return bytes_to_map;
+  }
+}
+
 int
 r_matrix_file_reader_txt_backward::
 open
@@ -748,42 +855,75 @@ open
 
     // Ascertain how big is the file.
 
-    if (fseek(file_file_, 0 , SEEK_END) != 0)
+    if (astr_fseek(file_file_, 0 , SEEK_END) != 0)
     {
       return 5; // I/O error.
     }
 
-    file_size_         = ftell(file_file_);
+    file_size_         = astr_ftell(file_file_);
     file_bytes_unread_ = file_size_;
 
-    // Try to create the buffer used for buffered reads.
+    //
+    // Memory mapped mode. Map the whole file; read_prev_chunk() will walk
+    // its windows from the last one to the first one. Should the file be
+    // impossible to map (or too big for the address space), we'll revert
+    // to buffered reads.
+    //
 
-    try
-    {
-      //
-      // Instantiate a data buffer with the proper size. If the size of the
-      // file is smaller than the maximum authorized size, then data_buffer_size_
-      // will be readjusted to use less memory. Otherwise, the requested
-      // data buffer size will be preserved.
-      //
-      // If everything works, the file is reported as open.
-      //
+    file_is_mapped_ = memory_mapped_;
 
-      if (file_size_ < data_buffer_size_) data_buffer_size_ = file_size_;
+    if (file_is_mapped_)
+    {
+      map_buffer_size_ = data_buffer_size_;
+      map_window_size_ = _ASTROLABE_R_MATRIX_FILE_READER_DEFAULT_MAP_WINDOW_SIZE;
+      if (data_buffer_size_ > map_window_size_) map_window_size_ = data_buffer_size_;
 
-      data_buffer_ = new char[data_buffer_size_];
       file_is_open_ = true;
+
+      // Empty files can't be mapped, and must be reported as such.
+
+      if (file_size_ == 0) return 4;
+
+      if (map_file() != 0)
+      {
+        // Unable to map the file. Revert to buffered reads.
+
+        file_is_open_   = false;
+        file_is_mapped_ = false;
+      }
     }
-    catch (...)
+
+    // Try to create the buffer used for buffered reads.
+
+    if (!file_is_mapped_)
     {
-      //
-      // If there's not enough memory, close again the file, flag it
-      // as not open and return the error code.
-      //
+      try
+      {
+        //
+        // Instantiate a data buffer with the proper size. If the size of the
+        // file is smaller than the maximum authorized size, then data_buffer_size_
+        // will be readjusted to use less memory. Otherwise, the requested
+        // data buffer size will be preserved.
+        //
+        // If everything works, the file is reported as open.
+        //
+
+        if (file_size_ < data_buffer_size_) data_buffer_size_ = (int)file_size_;
 
-      close();
-      file_is_open_ = false;
-      return 3;
+        data_buffer_ = new char[data_buffer_size_];
+        file_is_open_ = true;
+      }
+      catch (...)
+      {
+        //
+        // If there's not enough memory, close again the file, flag it
+        // as not open and return the error code.
+        //
+
+        close();
+        file_is_open_ = false;
+        return 3;
+      }
     }
 
     //
@@ -794,7 +934,7 @@ open
     // the fseek pointer indicates the end of the file.
     //
 
-    fseek(file_file_, 0, SEEK_END);
+    astr_fseek(file_file_, 0, SEEK_END);
 
     read_status = read_prev_chunk();
 
@@ -826,6 +966,13 @@ r_matrix_file_reader_txt_backward
     chunk_start_index_         = -1;
     data_buffer_current_       = -1;
     file_bytes_unread_         =  0;
+
+    map_base_                  = NULL;
+    map_buffer_size_           =  0;
+    map_length_                =  0;
+    map_window_size_           =  0;
+    file_is_mapped_            = false;
+    memory_mapped_             = false;
   }
 }
 
@@ -834,7 +981,13 @@ r_matrix_file_reader_txt_backward::
 (void)
 {
   {
-    // INTENTIONALLY LEFT BLANK.
+    //
+    // When memory mapped, the data buffer points to the mapped file and
+    // must not be deleted by the parent's destructor. Closing the file
+    // unmaps it and resets the data buffer.
+    //
+
+    if (file_is_mapped_) close();
   }
 }
 
@@ -844,8 +997,8 @@ read_prev_chunk
 (void)
 {
   {
-    long   bytes_read;
-    long   bytes_to_read;
+    int    bytes_read;
+    int    bytes_to_read;
     bool   done;
     int    offset;
     int    new_offset;
@@ -871,7 +1024,7 @@ read_prev_chunk
       // Ascertain how many bytes may be read at once.
 
       bytes_to_read = data_buffer_size_;
-      if (bytes_to_read > file_bytes_unread_) bytes_to_read = file_bytes_unread_;
+      if (bytes_to_read > file_bytes_unread_) bytes_to_read = (int)file_bytes_unread_;
 
       if (bytes_to_read == 0)
       {
@@ -879,37 +1032,53 @@ read_prev_chunk
         return 1;
       }
 
-      //
-      // Compute the number of bytes that won't be used in the data buffer. This
-      // amount will be used as an offset to put data in this buffer.
-      //
-
-      offset = data_buffer_size_ - (int)bytes_to_read;
-
-      //
-      // Move the current position in the file bytes_to_read bytes backwards to
-      // be able to read forward later on. Note that we ASSUME that the file
-      // is positioned ("fseek-ed") at the beginning of the data block that
-      // has already been processed, starting with an 'l' tag (or just at
-      // the end of the file when no data has been read yet).
-      //
-
-      fseek(file_file_, -bytes_to_read, SEEK_CUR);
-
-      // Read bytes_to_read bytes.
+      if (file_is_mapped_)
+      {
+        //
+        // Memory mapped mode. Nothing is read: the data buffer becomes the
+        // window of the mapped file preceding the data block that has
+        // already been processed. Thus, there are no unused bytes at its
+        // beginning. The file position is not used at all.
+        //
 
-      bytes_read = (int)fread((void*)&(data_buffer_[offset]), 1, bytes_to_read, file_file_);
-      if (bytes_read != bytes_to_read)
+        bytes_to_read = map_prev_chunk();
+        bytes_read    = bytes_to_read;
+        offset        = 0;
+      }
+      else
       {
         //
-        // This should never happen; we never ask for more data that is stored
-        // in the file, since we always know how much information is left there.
+        // Compute the number of bytes that won't be used in the data buffer. This
+        // amount will be used as an offset to put data in this buffer.
+        //
+
+        offset = data_buffer_size_ - (int)bytes_to_read;
+
         //
-        // Therefore, ff the number of bytes read do not match with the total
-        // of bytes to read, this means that some kind of I/O error has arised.
+        // Move the current position in the file bytes_to_read bytes backwards to
+        // be able to read forward later on. Note that we ASSUME that the file
+        // is positioned ("fseek-ed") at the beginning of the data block that
+        // has already been processed, starting with an 'l' tag (or just at
+        // the end of the file when no data has been read yet).
         //
 
-        return 2;
+        astr_fseek(file_file_, -bytes_to_read, SEEK_CUR);
+
+        // Read bytes_to_read bytes.
+
+        bytes_read = (int)fread((void*)&(data_buffer_[offset]), 1, bytes_to_read, file_file_);
+        if (bytes_read != bytes_to_read)
+        {
+          //
+          // This should never happen; we never ask for more data that is stored
+          // in the file, since we always know how much information is left there.
+          //
+          // Therefore, ff the number of bytes read do not match with the total
+          // of bytes to read, this means that some kind of I/O error has arised.
+          //
+
+          return 2;
+        }
       }
 
       //
@@ -977,7 +1146,7 @@ read_prev_chunk
       // must fseek -bytes_read backward.
       //
 
-      fseek(file_file_, -bytes_read, SEEK_CUR);
+      if (!file_is_mapped_) astr_fseek(file_file_, -bytes_read, SEEK_CUR);
 
       //
       // Now we know that we have an integral set of records starting at
@@ -1237,3 +1406,29 @@ read_type
     return 0;
   }
 }
+
+int
+r_matrix_file_reader_txt_backward::
+set_memory_mapped
+(bool memory_mapped)
+{
+  {
+    // If the file is already open, it's not legal to change the I/O model.
+
+    if (file_is_open_) return 1;
+
+    // Memory mapped files are available only on POSIX systems.
+
+    #ifdef _WIN32
+    if (memory_mapped) return 2;
+    #endif // _WIN32
+
+    // Set the new I/O model.
+
+    memory_mapped_ = memory_mapped;
+
+    // Bye.
+
+    return 0;
+  }
+}
@@ -7,6 +7,11 @@
 #define R_MATRIX_FILE_READER_TXT_BACKWARD_HPP
 
 #include "r_matrix_based_file_reader_txt.hpp"
+#include "astrolabe_text_scanner.hpp"
+
+/// @brief Default size of the window used in memory mapped mode: 64 Mbyte (64 * 1024 * 1024 bytes)
+
+#define _ASTROLABE_R_MATRIX_FILE_READER_DEFAULT_MAP_WINDOW_SIZE 67108864
 
 /**
  * @brief Class defining the interface of backwards correlation matrix text file readers.
@@ -17,6 +22,12 @@
  * r_matrix_based_file_reader_txt, reading correlation matrix files stored in
  * text format in backwards direction.
  *
+ * As observation_file_reader_txt_backward does, the file may be read either
+ * copying its chunks to the internal data buffer (the default) or mapping
+ * it in memory (see set_memory_mapped()), parsing the records in place. The
+ * error codes are the same no matter the I/O model in use.
+ *
+ * Memory mapped mode is only available on POSIX systems.
  */
 
 class r_matrix_file_reader_txt_backward : public r_matrix_based_file_reader_txt
@@ -69,6 +80,32 @@ class r_matrix_file_reader_txt_backward : public r_matrix_based_file_reader_txt
      */
                  ~r_matrix_file_reader_txt_backward    (void);
 
+    /**
+     * @brief Closes the file reader, disabling any other
+     *        further action on it.
+     * @return The error code. Possible error code values are:
+     *        - 0: Successful completion.
+     *        - 1: Error closing the file.
+     *
+     * When working in memory mapped mode, the file is unmapped before
+     * closing it.
+     */
+
+    virtual int  close                                 (void);
+
+    /**
+     * @brief Check if the reader is using the memory mapped I/O model.
+     *
+     * @return True if the file is (or will be, once opened) read
+     *         through a memory map, false otherwise.
+     *
+     * Note that open() will revert to the regular, buffered I/O model
+     * when the file can not be mapped; this method reports the I/O
+     * model actually in use after open() has been called.
+     */
+
+    virtual bool is_memory_mapped                      (void) const;
+
     /**
      * @brief Read the event record type.
      *
@@ -117,6 +154,31 @@ class r_matrix_file_reader_txt_backward : public r_matrix_based_file_reader_txt
 
     virtual int  read_type                             (char& record_type);
 
+    /**
+     * @brief Select the I/O model used to read the file.
+     *
+     * @param memory_mapped True to map the file in memory, false to use
+     *        buffered reads (the default).
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The file is already open and therefore it is not
+     *             possible to change the I/O model.
+     *        - 2: Memory mapped files are not available on this platform.
+     *
+     * See observation_file_reader_txt_backward::set_memory_mapped(). The
+     * mapped file is processed in windows whose size is the biggest of the
+     * buffer size (see set_buffer_size()) and
+     * _ASTROLABE_R_MATRIX_FILE_READER_DEFAULT_MAP_WINDOW_SIZE.
+     *
+     * If, once open() is called, the file can not be mapped, the reader
+     * reverts silently to the buffered I/O model.
+     *
+     * This method may be called only after the reader object has been
+     * instantiated and before open() has been invoked.
+     */
+
+    virtual int  set_memory_mapped                     (bool memory_mapped);
+
   protected:
 
     /**
@@ -236,6 +298,28 @@ class r_matrix_file_reader_txt_backward : public r_matrix_based_file_reader_txt
      */
     int          find_record_fwd                       (int from,  int& start, int& end);
 
+    /**
+     * @brief Map the whole input file in memory (memory mapped mode only).
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: Unable to map the file.
+     */
+
+    int          map_file                              (void);
+
+    /**
+     * @brief Make the data buffer point to the window of the mapped file
+     *        preceding the data already processed (memory mapped mode only).
+     * @return The size of the window, that is, the new value of
+     *         data_buffer_size_. It is never bigger than map_window_size_.
+     *
+     * The window ends at the first byte already processed (see
+     * file_bytes_unread_), which must not be zero. The system is asked to
+     * load this window and the one preceding it.
+     */
+
+    int          map_prev_chunk                        (void);
+
     /**
      * @brief Read as many bytes as possible from the input file to fill the
      *        data buffer. The read process is performed in backwards direction.
@@ -273,6 +357,11 @@ class r_matrix_file_reader_txt_backward : public r_matrix_based_file_reader_txt
      *
      * Remember: the data already stored in positions 0..start_at of the buffer
      * is left undisturbed.
+     *
+     * When working in memory mapped mode, nothing is read and the fseek
+     * position is not used: the data buffer is made to point to the window
+     * of the mapped file preceding the bytes already processed (see
+     * map_prev_chunk()).
      */
 
     int          read_prev_chunk                       (void);
@@ -291,9 +380,42 @@ class r_matrix_file_reader_txt_backward : public r_matrix_based_file_reader_txt
 
     int          data_buffer_current_;
 
+    /// @brief Searches the data buffer backwards, looking for the beginning
+    /// of records.
+
+    astrolabe_text_scanner delimiters_;
+
     /// @brief Number of bytes in the input file that have not been read yet.
 
-    int          file_bytes_unread_;
+    long long    file_bytes_unread_;
+
+    /// @brief Flag. True when the file open is actually read through a
+    /// memory map, that is, when requested and open() managed to map it.
+
+    bool         file_is_mapped_;
+
+    /// @brief Start address of the mapped file (memory mapped mode only).
+
+    char*        map_base_;
+
+    /// @brief Size of the data buffer requested before opening the file,
+    /// restored when it is closed (memory mapped mode only).
+
+    int          map_buffer_size_;
+
+    /// @brief Size in bytes of the mapped file (memory mapped mode only).
+
+    size_t       map_length_;
+
+    /// @brief Maximum size in bytes of the windows of the mapped file
+    /// processed at a time (memory mapped mode only).
+
+    int          map_window_size_;
+
+    /// @brief Flag. When true, the file is read through a memory map
+    /// instead of using the data buffer, if possible (see set_memory_mapped()).
+
+    bool         memory_mapped_;
 };
 
 #endif // R_MATRIX_FILE_READER_TXT_BACKWARD_HPP
@@ -11,6 +11,8 @@ find_next_record_limits
 {
   {
     int  i;
+    int  k;
+    int  n;
     bool opening_found;
     int  status;
     int  total_found;
@@ -41,22 +43,31 @@ find_next_record_limits
     // file in those cases that produce an end-of-file when trying to
     // load more data.
     //
+    // The positions of all the '<' and '>' in the data buffer were located
+    // when it was loaded (see read_next_chunk()), so we just need to walk
+    // through these.
+    //
 
     opening_found = false;
     total_found   = 0;
-    i             = data_buffer_current_;
+    i             = data_buffer_bytes_;
+    n             = delimiters_.n_delimiters();
 
-    while (i < data_buffer_bytes_)
+    for (k = delimiters_.find(data_buffer_current_); k < n; k++)
     {
-      if (data_buffer_[i] == '<') opening_found = true;
+      i = delimiters_.delimiter(k);
+      if (i >= data_buffer_bytes_)
+      {
+        i = data_buffer_bytes_;
+        break;
+      }
 
-      if (data_buffer_[i] == '>')
+      if (data_buffer_[i] == '<') opening_found = true;
+      else
       {
         total_found ++;
         if (total_found == 2) break;
       }
-
-      i++;
     }
 
     //
@@ -122,26 +133,28 @@ find_next_record_limits
       //
       // However, since the original information in the buffer has been
       // moved to its beginning, we must, again, look for the second
-      // closing '>'.
+      // closing '>' (read_next_chunk() has located the delimiters in the
+      // whole buffer again).
       //
       // We are assuming now that the whole record fits into our buffer, since
       // at this point we've read a full chunk of data from disk.
       //
 
-      i = data_buffer_current_; // Beginning of the buffer, since
-                                // move_remaining_up() resets
-                                // data_buffer_current_ to 0.
       total_found = 0;
+      i           = data_buffer_bytes_;
+      n           = delimiters_.n_delimiters();
 
-      while (i < data_buffer_bytes_)
+      for (k = delimiters_.find(data_buffer_current_); k < n; k++)
       {
-        if (data_buffer_[i] == '>')
+        if (data_buffer_[delimiters_.delimiter(k)] == '>')
         {
           total_found ++;
-          if (total_found == 2) break;
+          if (total_found == 2)
+          {
+            i = delimiters_.delimiter(k);
+            break;
+          }
         }
-
-        i++;
       }
 
       // We've got the position of the last (second, in fact) closing '>'.
@@ -152,12 +165,15 @@ find_next_record_limits
 
     // Now, find the first opening '<'.
 
-    i = data_buffer_current_;
+    i = data_buffer_bytes_;
 
-    while (i < data_buffer_bytes_)
+    for (k = delimiters_.find(data_buffer_current_); k < n; k++)
     {
-      if (data_buffer_[i] == '<') break;
-      i++;
+      if (data_buffer_[delimiters_.delimiter(k)] == '<')
+      {
+        i = delimiters_.delimiter(k);
+        break;
+      }
     }
 
     cur_record_start_ = i;
@@ -249,19 +265,19 @@ open
 
     // Ascertain how big is the file.
 
-    if (fseek(file_file_, 0 , SEEK_END) != 0)
+    if (astr_fseek(file_file_, 0 , SEEK_END) != 0)
     {
       return 5; // I/O error.
     }
 
-    file_size_ = ftell(file_file_);
+    file_size_ = astr_ftell(file_file_);
 
     //
     // Reset the fseek position, to be able to read from the start of the
     // file.
     //
 
-    fseek(file_file_, 0 , SEEK_SET);
+    astr_fseek(file_file_, 0 , SEEK_SET);
 
     // Try to create the buffer used for block reads.
 
@@ -276,7 +292,7 @@ open
       // If everything works, the file is reported as open.
       //
 
-      if (file_size_ < data_buffer_size_) data_buffer_size_ = file_size_;
+      if (file_size_ < data_buffer_size_) data_buffer_size_ = (int)file_size_;
 
       data_buffer_ = new char[data_buffer_size_];
       file_is_open_ = true;
@@ -415,6 +431,10 @@ read_next_chunk
 
     data_buffer_bytes_ = start_at + (int)bytes_read;
 
+    // Locate the tag delimiters in the whole buffer (see find_next_record_limits()).
+
+    delimiters_.scan(data_buffer_, data_buffer_bytes_);
+
     // That's all.
 
     return 0;
@@ -6,6 +6,7 @@
 #ifndef R_MATRIX_FILE_READER_TXT_FORWARD_HPP
 #define R_MATRIX_FILE_READER_TXT_FORWARD_HPP
 
+#include "astrolabe_text_scanner.hpp"
 #include "r_matrix_based_file_reader_txt.hpp"
 
 /**
@@ -178,6 +179,11 @@ class r_matrix_file_reader_txt_forward : public r_matrix_based_file_reader_txt
     /// "read") in the data buffer.
 
     int          data_buffer_current_;
+
+    /// @brief Positions of the '<' and '>' characters in the data buffer,
+    /// located every time it is loaded.
+
+    astrolabe_text_scanner delimiters_;
 };
 
 #endif // R_MATRIX_FILE_READER_TXT_FORWARD_HPP
@@ -19,6 +19,10 @@ close
 
     status = flush();
 
+    // Wait for the data flushed in the background, if any.
+
+    if (finish_flushing() != 0) status = 1;
+
     if (status != 0)
     {
       fclose(file_file_);
@@ -95,6 +99,10 @@ write_r
 
     if (n_correlation_values <= 0) return 3;
 
+    // The r-records stored so far are complete. Sync them, if due.
+
+    if (commit_epochs() != 0) return 2;
+
     //
     // Compute the size needed to store the current r record in the buffer.
     // We'll always take into account the backtracking tags since an r-record
@@ -19,6 +19,10 @@ close
 
     status = flush();
 
+    // Wait for the data flushed in the background, if any.
+
+    if (finish_flushing() != 0) status = 1;
+
     if (status != 0)
     {
       fclose(file_file_);
@@ -46,32 +50,13 @@ close
   }
 }
 
+void
 r_matrix_file_writer_txt::
-r_matrix_file_writer_txt
+compute_value_sizes
 (void)
 {
   {
-
-    //
-    // Instantiate and assign the fixed parts of the r-records
-    // formats. Doing this here will reduce drastically the amount of
-    // instantiation / destruction operations needed by methods
-    // build_r_format().
-    //
-    // Note that this is the place to change default formats for
-    // double values - if ever needed - as well as any other format
-    // involved in the process or "text writing".
-    //
-    // WARNING - WARNING - WARNING - WARNING - WARNING - WARNING
-    //
-    // Do not forget to update the size in bytes that the different
-    // part of the l- or o-records will use later on this same method.
-    //
-    // END OF WARNING - END OF WARNING - END OF WARNING - END OF WARNING
-    //
-
-    format_fixed_r_                    = strdup("<r s=\"%c\"> %23.15le");
-    format_default_double_format_      = strdup(" %23.15le");
+    int double_size;
 
     //
     // Compute the actual size that different types of data will use when
@@ -79,7 +64,9 @@ r_matrix_file_writer_txt
     //
     // WARNING - WARNING - WARNING - WARNING - WARNING - WARNING
     //
-    // These sizes must be set taking into acount the formats defined above!!!
+    // These sizes must be set taking into acount the formats defined in the
+    // constructor!!! When shortest_doubles_ is set, a double takes up to
+    // _ASTR_FORMAT_DOUBLE_MAX_SIZE characters, instead.
     //
     // END OF WARNING - END OF WARNING - END OF WARNING - END OF WARNING
     //
@@ -93,20 +80,23 @@ r_matrix_file_writer_txt
     // into account to perform the computation.
     //
 
+    if (shortest_doubles_) double_size = _ASTR_FORMAT_DOUBLE_MAX_SIZE;
+    else                   double_size = 23;
+
     //
     // Fixed par of the l-record.
     //
 
     sizeof_fixed_r_ = (2 + 1 + 3 + 2) + 1 + // Literal characters.
                        1                  + // s attribute value.
-                      23;                   // Time tag outside the opening tag.
+                      double_size;          // Time tag outside the opening tag.
 
     //
     // Size taken by a single double value (correlation values)
     // Includes the whitespace preceding the double value itself.
     //
 
-    sizeof_double_value_ = 1 + 23;
+    sizeof_double_value_ = 1 + double_size;
 
     //
     // Size taken by any the r tag. Includes the preceding whitespace,
@@ -120,6 +110,44 @@ r_matrix_file_writer_txt
   }
 }
 
+r_matrix_file_writer_txt::
+r_matrix_file_writer_txt
+(void)
+{
+  {
+
+    //
+    // Instantiate and assign the fixed parts of the r-records
+    // formats. Doing this here will reduce drastically the amount of
+    // instantiation / destruction operations needed by methods
+    // build_r_format().
+    //
+    // Note that this is the place to change default formats for
+    // double values - if ever needed - as well as any other format
+    // involved in the process or "text writing".
+    //
+    // WARNING - WARNING - WARNING - WARNING - WARNING - WARNING
+    //
+    // Do not forget to update the size in bytes that the different
+    // part of the l- or o-records will use (see compute_value_sizes()).
+    //
+    // END OF WARNING - END OF WARNING - END OF WARNING - END OF WARNING
+    //
+
+    format_fixed_r_                    = strdup("<r s=\"%c\"> %23.15le");
+    format_default_double_format_      = strdup(" %23.15le");
+
+    //
+    // Values are written using the formats above until
+    // set_shortest_doubles() is called. Compute the size these take.
+    //
+
+    shortest_doubles_ = false;
+
+    compute_value_sizes();
+  }
+}
+
 r_matrix_file_writer_txt::
 ~r_matrix_file_writer_txt
 (void)
@@ -141,6 +169,41 @@ r_matrix_file_writer_txt::
   }
 }
 
+int
+r_matrix_file_writer_txt::
+print_double
+(char*  pchar,
+ double value)
+{
+  {
+    if (!shortest_doubles_) return sprintf(pchar, format_default_double_format_, value);
+
+    *pchar = ' ';
+    return 1 + astr_format_double(value, pchar + 1);
+  }
+}
+
+int
+r_matrix_file_writer_txt::
+set_shortest_doubles
+(bool enabled)
+{
+  {
+    // If the file is already open, it's not legal to change this setting.
+    if (file_is_open_) return 1;
+
+    shortest_doubles_ = enabled;
+
+    // Records may take a different amount of characters now.
+
+    compute_value_sizes();
+
+    // Bye.
+
+    return 0;
+  }
+}
+
 int
 r_matrix_file_writer_txt::
 write_r
@@ -166,6 +229,10 @@ write_r
 
     if (n_correlation_values <= 0) return 3;
 
+    // The r-records stored so far are complete. Sync them, if due.
+
+    if (commit_epochs() != 0) return 2;
+
     //
     // Compute the size needed to store the current r record in the buffer.
     // We'll use the sizeof_double data member defined and initialized
@@ -209,7 +276,13 @@ write_r
     if (active) cactive = 'a';
     else        cactive = 'r';
 
-    bytes_written = sprintf(pchar, format_fixed_r_, cactive, time);
+    if (shortest_doubles_)
+    {
+      bytes_written = (int)sizeof("<r s=\"a\">") - 1;
+      memcpy(pchar, active ? "<r s=\"a\">" : "<r s=\"r\">", (size_t)bytes_written);
+      bytes_written += print_double(pchar + bytes_written, time);
+    }
+    else bytes_written = sprintf(pchar, format_fixed_r_, cactive, time);
     total_bytes_written += bytes_written;
     pchar += bytes_written;
 
@@ -217,7 +290,7 @@ write_r
 
     for (i = 0; i < n_correlation_values; i++ )
     {
-      bytes_written = sprintf(pchar, format_default_double_format_, the_correlation_values[i]);
+      bytes_written = print_double(pchar, the_correlation_values[i]);
       total_bytes_written += bytes_written;
       pchar+= bytes_written;
     }
@@ -228,7 +301,8 @@ write_r
     // operating system used when compiling this code.
     //
 
-    bytes_written = sprintf(pchar, " </r>%s", NEWLINE);
+    bytes_written = (int)strlen(" </r>" NEWLINE);
+    memcpy(pchar, " </r>" NEWLINE, (size_t)bytes_written);
     total_bytes_written += bytes_written;
 
     // Update pointers.
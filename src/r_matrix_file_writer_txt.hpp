@@ -6,6 +6,7 @@
 #ifndef R_MATRIX_FILE_WRITER_TXT_HPP
 #define R_MATRIX_FILE_WRITER_TXT_HPP
 
+#include "astrolabe_number_formatter.hpp"
 #include "r_matrix_based_file_writer.hpp"
 
 //
@@ -75,6 +76,25 @@ class r_matrix_file_writer_txt : public r_matrix_based_file_writer
 
     virtual     ~r_matrix_file_writer_txt (void);
 
+    /**
+     * @brief Select how double values are written.
+     *
+     * @param enabled True to write the shortest text that reads back as
+     *        exactly the same value, false to use the default fixed width
+     *        format (" %23.15le").
+     * @return Error code. Error code values are:
+     *         - 0: Successful completion.
+     *         - 1: Writer already open. It is not allowed to change
+     *              this setting at this moment.
+     *
+     * See obs_e_based_file_writer_txt::set_shortest_doubles() for details.
+     *
+     * This method may be called only after the writer has been instantiated
+     * but before the open() method has been invoked.
+     */
+
+    virtual int  set_shortest_doubles     (bool         enabled);
+
     /**
      * @brief Write an r-record.
      *
@@ -101,6 +121,25 @@ class r_matrix_file_writer_txt : public r_matrix_based_file_writer
 
   protected:
 
+    /**
+     * @brief Compute the sizeof_* data members, depending on the format
+     *        used to write double values.
+     */
+
+    void         compute_value_sizes      (void);
+
+    /**
+     * @brief Write a double value, including the preceding whitespace.
+     *
+     * @param pchar Position in the data buffer where the value is written.
+     * @param value The value to write.
+     * @return The number of characters written (never more than
+     *         sizeof_double_value_). No ending NULL is written.
+     */
+
+    int          print_double             (char*        pchar,
+                                           double       value);
+
     /// @brief Default format used to write double values.
 
     char* format_default_double_format_;
@@ -129,6 +168,11 @@ class r_matrix_file_writer_txt : public r_matrix_based_file_writer
     /// 1 whitespace, identifier, 1 whitespace and time tag. REVISAR!!!!!!!
 
     int sizeof_fixed_r_;
+
+    /// @brief Write double values using the shortest text possible, with
+    /// no sprintf() (true) or using the default format (false).
+
+    bool shortest_doubles_;
 };
 
 #endif // R_MATRIX_FILE_WRITER_TXT_HPP
@@ -5,6 +5,26 @@
 
 #include "r_matrix_reader.hpp"
 
+void
+r_matrix_reader::
+add_read_statistics
+(void)
+{
+  {
+    long long bytes_read;
+    double    seconds;
+
+    // Only binary backward readers keep statistics.
+
+    if (bin_backward_reader_ == NULL) return;
+
+    bin_backward_reader_->get_read_statistics(bytes_read, seconds);
+
+    read_bytes_   += bytes_read;
+    read_seconds_ += seconds;
+  }
+}
+
 int
 r_matrix_reader::
 close
@@ -33,8 +53,10 @@ close
       if (file_reader_ != NULL)
       {
         status = file_reader_->close();
+        add_read_statistics();
         delete file_reader_;
-        file_reader_ = NULL;
+        file_reader_         = NULL;
+        bin_backward_reader_ = NULL;
       }
     }
 
@@ -68,6 +90,7 @@ r_matrix_reader
 (void)
 {
   {
+    bin_backward_reader_         = NULL;
     data_channel_is_open_        = false;
     data_channel_is_set_         = false;
     data_channel_is_socket_      = false;
@@ -83,6 +106,10 @@ r_matrix_reader
 
     socket_reader_               = NULL;
     socket_works_in_server_mode_ = true;
+
+    read_bytes_                  = 0;
+    read_seconds_                = 0;
+    reverse_window_size_         = _ASTROLABE_R_MATRIX_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE;
   }
 }
 
@@ -237,6 +264,32 @@ get_metadata_warnings
   }
 }
 
+void
+r_matrix_reader::
+get_read_statistics
+(long long& bytes_read,
+ double&    seconds)
+const
+{
+  {
+    long long chunk_bytes_read;
+    double    chunk_seconds;
+
+    bytes_read = read_bytes_;
+    seconds    = read_seconds_;
+
+    // Add the statistics of the chunk being read, if any.
+
+    if (bin_backward_reader_ != NULL)
+    {
+      bin_backward_reader_->get_read_statistics(chunk_bytes_read, chunk_seconds);
+
+      bytes_read += chunk_bytes_read;
+      seconds    += chunk_seconds;
+    }
+  }
+}
+
 bool
 r_matrix_reader::
 is_eof
@@ -259,6 +312,60 @@ const
   }
 }
 
+r_matrix_based_file_reader*
+r_matrix_reader::
+new_file_reader
+(void)
+{
+  r_matrix_based_file_reader* reader;
+
+  {
+    bool is_binary_file;
+
+    is_binary_file
+      = (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE);
+
+    bin_backward_reader_ = NULL;
+
+    if (is_binary_file)
+    {
+      // Binary files.
+      if (is_backwards_mode_set_)
+      {
+        //
+        // Reversed, binary file reader. Kept aside as well, since this is
+        // the one asking the system to load the file in advance.
+        //
+
+        bin_backward_reader_ = new r_matrix_file_reader_bin_backward();
+        bin_backward_reader_->set_reverse_window(reverse_window_size_);
+        reader = bin_backward_reader_;
+      }
+      else
+      {
+        // Forward, binary file reader.
+        reader = new r_matrix_file_reader_bin_forward();
+      }
+    }
+    else
+    {
+      // Text files.
+      if (is_backwards_mode_set_)
+      {
+        // Reversed, text file reader.
+        reader = new r_matrix_file_reader_txt_backward();
+      }
+      else
+      {
+        // Forward, text file reader.
+        reader = new r_matrix_file_reader_txt_forward();
+      }
+    }
+  }
+
+  return reader;
+}
+
 int
 r_matrix_reader::
 open
@@ -269,7 +376,6 @@ open
     string       data_channel_filename;
     string       chunk_filename;
     const char*  host;
-    bool         is_binary_file;
     int          port;
     int          status;
 
@@ -280,6 +386,8 @@ open
     // Set internal flags.
 
     is_backwards_mode_set_ = reverse_mode;
+    read_bytes_            = 0;
+    read_seconds_          = 0;
 
     //
     // Now, check what kind of underlying data channel we are
@@ -340,10 +448,6 @@ open
     }
     else
     {
-
-      is_binary_file =
-        (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE);
-
       //
       // Retrieve too the name of the "general" external file that will keep (in fact,
       // possibly split into chunks) the actual data.
@@ -374,34 +478,7 @@ open
       // file type (text or binary) and the read mode (forward or reverse).
       //
 
-      if (is_binary_file)
-      {
-        // Binary files.
-        if (is_backwards_mode_set_)
-        {
-          // Reversed, binary file reader.
-          file_reader_ = new r_matrix_file_reader_bin_backward();
-        }
-        else
-        {
-          // Forward, binary file reader.
-          file_reader_ = new r_matrix_file_reader_bin_forward();
-        }
-      }
-      else
-      {
-        // Text files.
-        if (is_backwards_mode_set_)
-        {
-          // Reversed, text file reader.
-          file_reader_ = new r_matrix_file_reader_txt_backward();
-        }
-        else
-        {
-          // Forward, text file reader.
-          file_reader_ = new r_matrix_file_reader_txt_forward();
-        }
-      }
+      file_reader_ = new_file_reader();
 
       //
       // We may now try to open the actual underlying file using
@@ -512,7 +589,6 @@ read_type
 {
   {
     string chunk_filename;
-    bool   is_binary_file;
     int    status;
 
     if (data_channel_is_socket_)
@@ -562,9 +638,11 @@ read_type
         //
 
         status = file_reader_->close();
+        add_read_statistics();
 
         delete file_reader_;
-        file_reader_ = NULL;
+        file_reader_         = NULL;
+        bin_backward_reader_ = NULL;
 
         if (status != 0) return 7;
 
@@ -587,37 +665,7 @@ read_type
         // file type (text or binary) and the read mode (forward or reverse).
         //
 
-        is_binary_file
-          = (header_data_.get_device_format() == gp_astrolabe_header_file_data::GP_ASTROLABE_HEADER_FORMAT_IS_BINARY_FILE);
-
-        if (is_binary_file)
-        {
-          // Binary files.
-          if (is_backwards_mode_set_)
-          {
-            // Reversed, binary file reader.
-            file_reader_ = new r_matrix_file_reader_bin_backward();
-          }
-          else
-          {
-            // Forward, binary file reader.
-            file_reader_ = new r_matrix_file_reader_bin_forward();
-          }
-        }
-        else
-        {
-          // Text files.
-          if (is_backwards_mode_set_)
-          {
-            // Reversed, text file reader.
-            file_reader_ = new r_matrix_file_reader_txt_backward();
-          }
-          else
-          {
-            // Forward, text file reader.
-            file_reader_ = new r_matrix_file_reader_txt_forward();
-          }
-        }
+        file_reader_ = new_file_reader();
 
         //
         // Open the new chunk. If this fails, we'll return an
@@ -720,6 +768,25 @@ set_header_file
   }
 }
 
+int
+r_matrix_reader::
+set_reverse_window
+(long long window_size)
+{
+  {
+    // The file readers are set up when opening the data channel.
+
+    if (data_channel_is_open_) return 1;
+    if (window_size < 0)       return 2;
+
+    reverse_window_size_ = window_size;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 r_matrix_reader::
 set_schema_file
@@ -188,6 +188,26 @@ class r_matrix_reader
 
     int                  get_metadata_warnings     (list<string>& list_of_warnings);
 
+    /**
+     * @brief Retrieve the amount of data read from the chunk files and the
+     *        time spent doing so.
+     *
+     * @param bytes_read Number of bytes read from the chunk files to fill
+     *        the internal buffers of the file readers.
+     * @param seconds Time, in seconds, the calling module has been blocked
+     *        waiting for these bytes.
+     *
+     * The quotient of both values is the throughput achieved when reading
+     * backwards (see set_reverse_window()). Statistics add up those of the
+     * file readers of every chunk read since open() (see
+     * r_matrix_file_reader_bin_backward::get_read_statistics()) and are
+     * kept after close(). Only binary files read backwards are accounted
+     * for; otherwise, zero bytes are reported.
+     */
+
+    void                 get_read_statistics       (long long& bytes_read,
+                                                    double&    seconds) const;
+
 
     /**
      * @brief Check if the data in the r_matrix channel has been completely read.
@@ -499,6 +519,29 @@ class r_matrix_reader
 
     int                  set_header_file           (const char* header_file_name);
 
+    /**
+     * @brief Set the size of the region of the chunk files that backward
+     *        file readers ask the system to load in advance.
+     *
+     * @param window_size Size of the region, in bytes. 0 disables this
+     *        feature.
+     * @return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: Invalid (negative) size.
+     *
+     * The size is handed to the file reader of every chunk when reading
+     * binary files backwards (see
+     * r_matrix_file_reader_bin_backward::set_reverse_window()); check the
+     * throughput achieved with get_read_statistics(). Other file readers
+     * and socket data channels ignore this setting.
+     *
+     * This method must be called before open(). The default size is
+     * _ASTROLABE_R_MATRIX_FILE_READER_DEFAULT_REVERSE_WINDOW_SIZE.
+     */
+
+    int                  set_reverse_window        (long long window_size);
+
     /**
      * @brief Set the name of the XML schema defining the grammar of
      *        ASTROLABE header files.
@@ -592,8 +635,29 @@ class r_matrix_reader
     int                  get_metadata              (int& total_metadata_warnings,
                                                     int& total_metadata_errors);
 
+    /**
+     * @brief Add the read statistics of the current file reader to those
+     *        of the chunks already read (see get_read_statistics()).
+     */
+
+    void                 add_read_statistics       (void);
+
+    /**
+     * @brief Instantiate a file reader suitable for the format of the
+     *        data files and the read mode (forward or reverse) selected.
+     * @return The new file reader, not yet open. When it reads binary
+     *         files backwards, bin_backward_reader_ points to it as well.
+     */
+
+    r_matrix_based_file_reader* new_file_reader   (void);
+
   protected:
 
+    /// \brief The current file reader (see file_reader_), when it reads
+    /// binary files backwards. NULL otherwise.
+
+    r_matrix_file_reader_bin_backward* bin_backward_reader_;
+
     /// \brief The chunk files name generator.
 
     segmented_file_utils            chunk_names_generator_;
@@ -653,6 +717,21 @@ class r_matrix_reader
 
     bool                            is_schema_filename_set_;
 
+    /// \brief Bytes read by the file readers of the chunks already closed
+    /// (see get_read_statistics()).
+
+    long long                       read_bytes_;
+
+    /// \brief Time spent by the file readers of the chunks already closed
+    /// waiting for read_bytes_ (see get_read_statistics()).
+
+    double                          read_seconds_;
+
+    /// \brief Size of the region of the chunk files that backward file
+    /// readers ask the system to load in advance (see set_reverse_window()).
+
+    long long                       reverse_window_size_;
+
     /// \brief Name of the XML schema file used to validate the syntax
     /// of the ASTROLABE header file to read. When empty, no schema
     /// is available.
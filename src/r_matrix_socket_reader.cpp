@@ -4,6 +4,61 @@
 */ 
 #include "r_matrix_socket_reader.hpp"
 
+void
+r_matrix_socket_reader::
+accept_protocol
+(void)
+{
+  {
+    char answer[2 * _ASTROLABE_SOCKET_XDR_INT_SIZE];
+    int  version;
+    int  window;
+
+    // Decode the protocol version and the window wanted by the writer.
+
+    decoder_stream_->simple(version);
+    decoder_stream_->simple(window);
+
+    //
+    // Grant the windowed protocol (or any newer one, that writers must
+    // be ready to give up) if both ends want a window.
+    //
+
+    if ((version >= _ASTROLABE_SOCKET_PROTOCOL_WINDOWED) && (window > 1) && (max_window_ > 1))
+    {
+      protocol_version_ = _ASTROLABE_SOCKET_PROTOCOL_WINDOWED;
+      window_           = (window < max_window_) ? window : max_window_;
+    }
+    else
+    {
+      protocol_version_ = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+      window_           = 1;
+    }
+
+    //
+    // Acknowledge half a window at once, so the writer never runs out of
+    // window while the acknowledgement travels.
+    //
+
+    ack_interval_    = (window_ + 1) / 2;
+    unacked_records_ = 0;
+
+    //
+    // Acknowledgements must not wait for the previous ones to be
+    // acknowledged by TCP, since the writer may be waiting for them.
+    //
+
+    if (protocol_version_ == _ASTROLABE_SOCKET_PROTOCOL_WINDOWED) socket_->setNoDelay(true);
+
+    // Answer.
+
+    astr_socket_put_int(answer, protocol_version_);
+    astr_socket_put_int(answer + _ASTROLABE_SOCKET_XDR_INT_SIZE, window_);
+
+    socket_->send(answer, 2 * _ASTROLABE_SOCKET_XDR_INT_SIZE);
+  }
+}
+
 int
 r_matrix_socket_reader::
 close
@@ -58,6 +113,8 @@ r_matrix_socket_reader
 (void)
 {
   {
+    ack_interval_               = 1;
+
     data_buffer_                = NULL;
     data_buffer_size_           = _R_MATRIX_SOCKET_READER_DEFAULT_BUFFER_SIZE;
 
@@ -69,6 +126,11 @@ r_matrix_socket_reader
 
     is_eof_                     = false;
 
+    max_window_                 = _ASTROLABE_SOCKET_DEFAULT_MAX_WINDOW;
+
+    protocol_is_settled_        = false;
+    protocol_version_           = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+
     read_active_flag_           = false;
     read_completed_             = true;
     read_r_data_                = false;
@@ -78,6 +140,10 @@ r_matrix_socket_reader
     server_socket_              = NULL;
     socket_                     = NULL;
     socket_is_open_             = false;
+
+    unacked_records_            = 0;
+
+    window_                     = 1;
   }
 }
 
@@ -97,6 +163,35 @@ get_full_record
 {
   {
     int  bytesReceived; // Total bytes read
+    char lengthBuffer[_ASTROLABE_SOCKET_XDR_INT_SIZE];
+    int  record_length;
+
+    //
+    // Windowed protocol: records are preceded by their length, and may
+    // arrive split or along with others, so read exactly what's needed.
+    //
+
+    if (protocol_version_ == _ASTROLABE_SOCKET_PROTOCOL_WINDOWED)
+    {
+      astr_socket_recv_all(socket_, lengthBuffer, _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+      record_length = astr_socket_get_int(lengthBuffer);
+
+      if ((record_length < 1) || (record_length > data_buffer_size_))
+      {
+        throw SocketException("Invalid record length"); // Protocol error.
+      }
+
+      astr_socket_recv_all(socket_, data_buffer_, record_length);
+
+      // Acknowledge the records received so far once in a while.
+
+      unacked_records_++;
+
+      if (unacked_records_ >= ack_interval_) send_ack();
+
+      return;
+    }
 
     //
     // Get a full data record. These are sent at once.
@@ -131,6 +226,17 @@ get_full_record
   }
 }
 
+int
+r_matrix_socket_reader::
+get_window
+(void)
+const
+{
+  {
+    return window_;
+  }
+}
+
 bool
 r_matrix_socket_reader::
 is_eof
@@ -226,6 +332,17 @@ open
       }
     }
 
+    //
+    // Every connection starts with the stop-and-wait protocol. The writer
+    // may ask for another one before sending its first record.
+    //
+
+    ack_interval_        = 1;
+    protocol_is_settled_ = false;
+    protocol_version_    = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+    unacked_records_     = 0;
+    window_              = 1;
+
     // Update flags.
 
     socket_is_open_ = true;
@@ -422,41 +539,87 @@ read_type
     // since it arrives stored in the same place that the record type.
     //
 
-    try
-    {
-      //
-      // get_full_record() stores the data read in the underlying
-      // buffer used by our decoders (data_buffer_).
-      //
-      // get_full_record(), by the way, reads data from the socket
-      // connection!
-      //
+    //
+    // The first message may be the request to use the windowed protocol
+    // (the hello command). It is answered here, and then the actual
+    // record is read.
+    //
 
-      get_full_record();
-    }
-    catch (...)
+    do
     {
-      // Problems reading the socket. We'll report a read error condition.
-      return 2;
-    }
+      try
+      {
+        //
+        // get_full_record() stores the data read in the underlying
+        // buffer used by our decoders (data_buffer_).
+        //
+        // get_full_record(), by the way, reads data from the socket
+        // connection!
+        //
+
+        get_full_record();
+      }
+      catch (...)
+      {
+        // Problems reading the socket. We'll report a read error condition.
+        return 2;
+      }
 
-    // Let's decode the type. Beware: it may be the end-of-file command!
+      // Let's decode the type. Beware: it may be the end-of-file command!
 
-    try
-    {
-      decoder_membuf_->rewind(); // So we start again from the beginning of the buffer.
-      decoder_stream_->cstring(the_type, 1);
-    }
-    catch (...)
-    {
-      // Error decoding the type. We'll report a read error condition.
-      return 2;
+      try
+      {
+        decoder_membuf_->rewind(); // So we start again from the beginning of the buffer.
+        decoder_stream_->cstring(the_type, 1);
+      }
+      catch (...)
+      {
+        // Error decoding the type. We'll report a read error condition.
+        return 2;
+      }
+
+      if (the_type[0] == 'v')
+      {
+        // Too late to change the protocol.
+
+        if (protocol_is_settled_) return 4;
+
+        try
+        {
+          accept_protocol();
+        }
+        catch (...)
+        {
+          // Error decoding the request or sending the answer.
+          return 2;
+        }
+      }
+
+      protocol_is_settled_ = true;
     }
+    while (the_type[0] == 'v');
 
     // Have we received the "end-of-file" command?
 
     if (the_type[0] == 'e')
     {
+      //
+      // With the windowed protocol, the writer waits for every record
+      // to be acknowledged before closing the connection.
+      //
+
+      if (unacked_records_ > 0)
+      {
+        try
+        {
+          send_ack();
+        }
+        catch (...)
+        {
+          return 2;
+        }
+      }
+
       // End of transmission!!!
 
       is_eof_ = true;
@@ -481,3 +644,39 @@ read_type
     return 0;
   }
 }
+
+void
+r_matrix_socket_reader::
+send_ack
+(void)
+{
+  {
+    char ack[_ASTROLABE_SOCKET_XDR_INT_SIZE];
+
+    // A single, cumulative, acknowledgement for all of them.
+
+    astr_socket_put_int(ack, unacked_records_);
+
+    socket_->send(ack, _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+    unacked_records_ = 0;
+  }
+}
+
+int
+r_matrix_socket_reader::
+set_max_window
+(int n_records)
+{
+  {
+    // The window must be decided before opening the connection.
+
+    if (socket_is_open_) return 1;
+
+    if (n_records < 1)   return 2;
+
+    max_window_ = n_records;
+
+    return 0;
+  }
+}
@@ -7,6 +7,7 @@
 #define R_MATRIX_SOCKET_READER_HPP
 
 #include "PracticalSocket.h"
+#include "astrolabe_socket_utilities.hpp"
 
 #include <xtl/objio.h>
 #include <xtl/xdr.h>
@@ -67,6 +68,10 @@
  *   Closing the reader will disable any further I/O read operations.
  * - The reader object may be destroyed.
  *
+ * Both the classic stop-and-wait protocol and the windowed one (see
+ * astrolabe_socket_utilities.hpp) are understood, as in
+ * obs_e_based_socket_reader.
+ *
  */
 
 class r_matrix_socket_reader
@@ -99,6 +104,18 @@ class r_matrix_socket_reader
 
          ~r_matrix_socket_reader    (void);
 
+    /**
+     * \brief Retrieve the window agreed with the writer.
+     *
+     * \return The maximum number of records that the writer may send
+     *         without waiting for their acknowledgement. One means that
+     *         the stop-and-wait protocol is in use.
+     *
+     * Only known after the first call to read_type().
+     */
+
+    int  get_window                 (void) const;
+
     /**
      * \brief Check if the data in socket channel has been completely read.
      *
@@ -254,7 +271,9 @@ class r_matrix_socket_reader
      *         - 6: NOT USED.
      *
      * read_type() is the method that starts the process of reading a
-     * full r_matrix record.
+     * full r_matrix record. The request to use the windowed protocol, if
+     * any, is answered by the first call to this method, and is never seen
+     * by the caller.
      *
      * It may be invoked right after open() or read_r_data() have
      * been called only. Using this method at any other moment will
@@ -287,8 +306,34 @@ class r_matrix_socket_reader
 
     int  read_type                  (char& record_type);
 
+    /**
+     * \brief Set the maximum window granted to writers asking for the
+     *        windowed protocol.
+     *
+     * \param n_records The maximum window. One makes the reader answer
+     *        that only the stop-and-wait protocol is available.
+     * \return Error code. Error code values:
+     *         - 0: Successful completion.
+     *         - 1: The socket is already open.
+     *         - 2: The window must be greater than zero.
+     *
+     * See obs_e_based_socket_reader::set_max_window().
+     */
+
+    int  set_max_window             (int n_records);
+
   protected:
 
+    /**
+     * \brief Answer the request to use the windowed protocol.
+     *
+     * \throw SocketException Unable to send the answer.
+     *
+     * See obs_e_based_socket_reader::accept_protocol().
+     */
+
+    void accept_protocol            (void);
+
     /**
      * \brief Reads a full record using the open socket connection.
      *
@@ -307,13 +352,30 @@ class r_matrix_socket_reader
      * is a single byte (its contents does not matter at all; what is
      * important is to send one single byte back to the writer).
      *
+     * With the windowed protocol, the record is preceded by its length,
+     * and the acknowledgement is only sent once ack_interval_ records
+     * have been received (see send_ack()).
+     *
      */
 
     void get_full_record            (void);
 
+    /**
+     * \brief Acknowledge the records received with the windowed protocol
+     *        that have not been acknowledged yet (unacked_records_).
+     *
+     * \throw SocketException Unable to send the acknowledgement.
+     */
+
+    void send_ack                   (void);
 
   protected:
 
+    /// \brief Number of records acknowledged at once with the windowed
+    /// protocol.
+
+    int                                 ack_interval_;
+
     /// \brief The data_buffer_ where received data will be stored.
 
     char*                               data_buffer_;
@@ -348,6 +410,20 @@ class r_matrix_socket_reader
 
     bool                                last_record_is_active_;
 
+    /// \brief Maximum window granted to writers (see set_max_window()).
+
+    int                                 max_window_;
+
+    /// \brief Flag. True once the first message has been received, so the
+    /// protocol may not be changed anymore.
+
+    bool                                protocol_is_settled_;
+
+    /// \brief Protocol in use (_ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT or
+    /// _ASTROLABE_SOCKET_PROTOCOL_WINDOWED).
+
+    int                                 protocol_version_;
+
     /// \brief Control flag. When true, it indicates that a call to read_active_flag()
     /// has already been made for the current record.
 
@@ -386,6 +462,15 @@ class r_matrix_socket_reader
 
     bool                                socket_is_open_;
 
+    /// \brief Number of records received with the windowed protocol and not
+    /// acknowledged yet.
+
+    int                                 unacked_records_;
+
+    /// \brief Window agreed with the writer (see get_window()).
+
+    int                                 window_;
+
 };
 
 #endif // R_MATRIX_SOCKET_READER_HPP
@@ -45,10 +45,15 @@ close
     try
     {
       // Send the EOF command.
-      socket_->send(coder_membuf_->data(), coder_membuf_->size());
+      send_record();
 
-      // Wait for the acknowledgement sent by the receiver.
-      getACK();
+      //
+      // Wait for the acknowledgement sent by the receiver. With the
+      // windowed protocol, the records not acknowledged yet are
+      // acknowledged along with the EOF command.
+      //
+
+      while (outstanding_records_ > 0) getACK();
 
     }
     catch(SocketException &)
@@ -109,10 +114,14 @@ r_matrix_socket_writer
     data_buffer_         = NULL;
     data_buffer_size_    = _R_MATRIX_SOCKET_WRITER_DEFAULT_BUFFER_SIZE;
     host_                = "";
+    outstanding_records_ = 0;
     port_                = 0;
+    protocol_version_    = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+    requested_window_    = 1;
     server_socket_       = NULL;
     socket_              = NULL;
     socket_is_open_      = false;
+    window_              = 1;
 
   }
 }
@@ -134,8 +143,30 @@ getACK
   {
     char echoBuffer[1];      // Buffer for 1 acknowledgement character.
     int  bytesReceived;      // Bytes read on each recv()
+    char countBuffer[_ASTROLABE_SOCKET_XDR_INT_SIZE];
+    int  n_acknowledged;
     int  totalBytesReceived; // Total bytes read
 
+    //
+    // Windowed protocol: the acknowledgement is an XDR int with the number
+    // of messages acknowledged at once.
+    //
+
+    if (protocol_version_ == _ASTROLABE_SOCKET_PROTOCOL_WINDOWED)
+    {
+      astr_socket_recv_all(socket_, countBuffer, _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+      n_acknowledged = astr_socket_get_int(countBuffer);
+
+      if ((n_acknowledged < 1) || (n_acknowledged > outstanding_records_))
+      {
+        throw SocketException("Invalid acknowledgement"); // Protocol error.
+      }
+
+      outstanding_records_ -= n_acknowledged;
+      return;
+    }
+
     bytesReceived = 0;
     totalBytesReceived = 0;  
 
@@ -156,6 +187,17 @@ getACK
   }
 }
 
+int
+r_matrix_socket_writer::
+get_window
+(void)
+const
+{
+  {
+    return window_;
+  }
+}
+
 bool
 r_matrix_socket_writer::
 is_open
@@ -167,6 +209,61 @@ const
   }
 }
 
+void
+r_matrix_socket_writer::
+negotiate_protocol
+(void)
+{
+  {
+    char answer[2 * _ASTROLABE_SOCKET_XDR_INT_SIZE];
+    int  version;
+    int  window;
+
+    // Encode the hello command: protocol version and window wanted.
+
+    version = _ASTROLABE_SOCKET_PROTOCOL_WINDOWED;
+
+    coder_membuf_->rewind();
+    coder_stream_->cstring("v", 1);
+    coder_stream_->simple(version);
+    coder_stream_->simple(requested_window_);
+
+    //
+    // The hello command travels and is acknowledged as any other message
+    // of the stop-and-wait protocol. Then, the receiver answers. Old
+    // receivers never do, so don't wait for them forever: a timeout
+    // throws, as a broken connection does.
+    //
+
+    socket_->setRecvTimeout(_ASTROLABE_SOCKET_HELLO_TIMEOUT);
+
+    send_record();
+
+    astr_socket_recv_all(socket_, answer, 2 * _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+    socket_->setRecvTimeout(0);
+
+    version = astr_socket_get_int(answer);
+    window  = astr_socket_get_int(answer + _ASTROLABE_SOCKET_XDR_INT_SIZE);
+
+    // Keep on using stop-and-wait unless the receiver agrees.
+
+    if ((version == _ASTROLABE_SOCKET_PROTOCOL_WINDOWED) && (window > 1))
+    {
+      protocol_version_ = _ASTROLABE_SOCKET_PROTOCOL_WINDOWED;
+      window_           = (window < requested_window_) ? window : requested_window_;
+
+      //
+      // Several records are now in flight. Coalescing small writes would
+      // hold them until the previous ones are acknowledged by TCP, which
+      // the receiver delays, since it answers once every several records.
+      //
+
+      socket_->setNoDelay(true);
+    }
+  }
+}
+
 int
 r_matrix_socket_writer::
 open
@@ -253,12 +350,15 @@ open
       // Instantiate a data buffer with the proper size.
       //
 
-      data_buffer_     = new char[data_buffer_size_];
+      data_buffer_     = new char[_ASTROLABE_SOCKET_XDR_INT_SIZE + data_buffer_size_];
       socket_is_open_  = true;
 
-      // Set up the stack of XDR objects needed to write XDR coded data.
+      //
+      // Set up the stack of XDR objects needed to write XDR coded data. The
+      // room before the encoded data is used to store its length.
+      //
 
-      coder_membuf_    = new mem_buffer(data_buffer_, data_buffer_size_);
+      coder_membuf_    = new mem_buffer(data_buffer_ + _ASTROLABE_SOCKET_XDR_INT_SIZE, data_buffer_size_);
       coder_formatter_ = new XDR_format<mem_buffer>(*coder_membuf_);
       coder_stream_    = new obj_output<XDR_format<mem_buffer> >(*coder_formatter_);
 
@@ -275,12 +375,108 @@ open
       return 3;
     }
 
+    //
+    // Every connection starts with the stop-and-wait protocol. Ask for
+    // the windowed one if a window has been set.
+    //
+
+    outstanding_records_ = 0;
+    protocol_version_    = _ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT;
+    window_              = 1;
+
+    if (requested_window_ > 1)
+    {
+      try
+      {
+        negotiate_protocol();
+      }
+      catch (...)
+      {
+        //
+        // The receiver does not understand the hello command, or the
+        // connection is broken. There's no point in sending the
+        // end-of-file command; just drop the connection.
+        //
+
+        if (socket_        != NULL) delete socket_;
+        if (server_socket_ != NULL) delete server_socket_;
+
+        socket_        = NULL;
+        server_socket_ = NULL;
+
+        delete coder_membuf_;
+        delete coder_formatter_;
+        delete coder_stream_;
+        delete [] data_buffer_;
+
+        coder_membuf_    = NULL;
+        coder_formatter_ = NULL;
+        coder_stream_    = NULL;
+        data_buffer_     = NULL;
+
+        socket_is_open_ = false;
+        return 2;
+      }
+    }
+
     // Successful completion.
 
     return 0;
   }
 }
 
+void
+r_matrix_socket_writer::
+send_record
+(void)
+{
+  {
+    int size;
+
+    size = coder_membuf_->size();
+
+    // Stop-and-wait: send the message as is and wait for its acknowledgement.
+
+    if (protocol_version_ != _ASTROLABE_SOCKET_PROTOCOL_WINDOWED)
+    {
+      socket_->send(coder_membuf_->data(), size);
+      getACK();
+      return;
+    }
+
+    //
+    // Windowed protocol. Wait only if the window is full; then, send the
+    // length of the message and the message itself at once.
+    //
+
+    while (outstanding_records_ >= window_) getACK();
+
+    astr_socket_put_int(data_buffer_, size);
+
+    socket_->send(data_buffer_, _ASTROLABE_SOCKET_XDR_INT_SIZE + size);
+
+    outstanding_records_++;
+  }
+}
+
+int
+r_matrix_socket_writer::
+set_window
+(int n_records)
+{
+  {
+    // The window must be decided before opening the connection.
+
+    if (socket_is_open_) return 1;
+
+    if (n_records < 1)   return 2;
+
+    requested_window_ = n_records;
+
+    return 0;
+  }
+}
+
 int
 r_matrix_socket_writer::
 write_r
@@ -360,10 +556,7 @@ write_r
     try
     {
       // Send data.
-      socket_->send(coder_membuf_->data(), coder_membuf_->size());
-
-      // Wait for the acknowledgement sent by the receiver.
-      getACK();
+      send_record();
     }
     catch(SocketException &)
     {
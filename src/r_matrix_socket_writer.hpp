@@ -11,6 +11,7 @@
 #include <cstdlib>
 
 #include "PracticalSocket.h"
+#include "astrolabe_socket_utilities.hpp"
 
 #include <xtl/objio.h>
 #include <xtl/xdr.h>
@@ -60,6 +61,10 @@ using namespace std;
   * neutral, architecture-independent representation guarantees that the
   * receiver will be able to rebuild such information flawlessly.
   *
+  * By default, every record must be acknowledged by the receiver before
+  * the next one is sent. Use set_window() before open() to let several
+  * records travel at the same time (see astrolabe_socket_utilities.hpp).
+  *
   */
 
 class r_matrix_socket_writer
@@ -110,6 +115,17 @@ class r_matrix_socket_writer
      */
          ~r_matrix_socket_writer   (void);
 
+    /**
+     * \brief Retrieve the window in use.
+     *
+     * \return The maximum number of records that may be waiting for
+     *         their acknowledgement, as agreed with the receiver when
+     *         opening the connection. One means that the stop-and-wait
+     *         protocol is in use (also when the socket is not open).
+     */
+
+    int  get_window                (void) const;
+
     /**
      * \brief Check if the socket is already opened.
      *
@@ -133,7 +149,8 @@ class r_matrix_socket_writer
      * \return Error code. Error code values:
      *        - 0: Successful completion.
      *        - 1: The socket was already open.
-     *        - 2: Unable to open the selected socket.
+     *        - 2: Unable to open the selected socket, or to agree on
+     *             the windowed protocol with the receiver (see set_window()).
      *        - 3: Not enough memory to allocate the internal buffer.
      *
      * Once a socket writer has been instantiated it is possible
@@ -165,6 +182,24 @@ class r_matrix_socket_writer
                                     int         port,
                                     bool        server_mode);
 
+    /**
+     * \brief Select the number of records that may be sent without
+     *        waiting for their acknowledgement.
+     *
+     * \param n_records The window wanted. One (the default) selects the
+     *        classic stop-and-wait protocol.
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The socket is already open.
+     *        - 2: The window must be greater than zero.
+     *
+     * See obs_e_based_socket_writer::set_window(). With the windowed
+     * protocol, write_r() only waits when the window is full, so errors
+     * sending records may be reported by a later call or by close().
+     */
+
+    int  set_window                (int         n_records);
+
     /**
      * \brief Write (send) an r-record.
      *
@@ -245,10 +280,37 @@ class r_matrix_socket_writer
      * is. In fact, it does not matter what character is sent; only
      * that it is sent (and received).
      *
+     * When the windowed protocol is in use, acknowledgements are XDR ints
+     * instead, stating how many records are acknowledged at once; these
+     * are discounted from outstanding_records_.
+     *
      */
 
     void getACK                    (void);
 
+    /**
+     * \brief Ask the receiver to use the windowed protocol.
+     *
+     * \throw SocketException Unable to send the request or to receive
+     *        the answer within _ASTROLABE_SOCKET_HELLO_TIMEOUT
+     *        milliseconds.
+     *
+     * See obs_e_based_socket_writer::negotiate_protocol(). Used by open().
+     */
+
+    void negotiate_protocol        (void);
+
+    /**
+     * \brief Send the message encoded in coder_membuf_.
+     *
+     * \throw SocketException Unable to send the message or to receive
+     *        an acknowledgement.
+     *
+     * See obs_e_based_socket_writer::send_record().
+     */
+
+    void send_record               (void);
+
   protected:
 
     /// \brief Underlying mem_buffer object used in XDR coding operatinos.
@@ -264,7 +326,9 @@ class r_matrix_socket_writer
 
     obj_output<XDR_format<mem_buffer> >* coder_stream_;
 
-    /// \brief The data_buffer_ used to store the data to write.
+    /// \brief The data_buffer_ used to store the data to write. The
+    /// encoded messages start _ASTROLABE_SOCKET_XDR_INT_SIZE bytes after
+    /// its beginning, leaving room for their length.
 
     char*                                data_buffer_;
 
@@ -276,10 +340,24 @@ class r_matrix_socket_writer
 
     string                               host_;
 
+    /// \brief Number of records (or commands) sent and not acknowledged
+    /// yet. Always zero with the stop-and-wait protocol.
+
+    int                                  outstanding_records_;
+
     /// \brief Port to connect through.
 
     unsigned short                       port_;
 
+    /// \brief Protocol in use (_ASTROLABE_SOCKET_PROTOCOL_STOP_AND_WAIT or
+    /// _ASTROLABE_SOCKET_PROTOCOL_WINDOWED).
+
+    int                                  protocol_version_;
+
+    /// \brief Window asked for when opening the connection (see set_window()).
+
+    int                                  requested_window_;
+
     /// \brief The server socket used to set the connection in server mode.
 
     TCPServerSocket*                     server_socket_;
@@ -291,6 +369,10 @@ class r_matrix_socket_writer
     /// \brief Flag showing wheter the socket connection is open.
 
     bool                                 socket_is_open_;
+
+    /// \brief Window agreed with the receiver (see get_window()).
+
+    int                                  window_;
 };
 
 #endif // R_MATRIX_SOCKET_WRITER_HPP
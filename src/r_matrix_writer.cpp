@@ -1,5 +1,25 @@
 #include "r_matrix_writer.hpp"
 
+void
+r_matrix_writer::
+add_sync_statistics
+(void)
+{
+  {
+    double    max_seconds;
+    long long n_syncs;
+    double    seconds;
+
+    // Chunk file writers are destroyed once closed; keep their figures.
+
+    file_writer_->get_sync_statistics(n_syncs, seconds, max_seconds);
+
+    n_syncs_      += n_syncs;
+    sync_seconds_ += seconds;
+    if (max_seconds > max_sync_seconds_) max_sync_seconds_ = max_seconds;
+  }
+}
+
 int
 r_matrix_writer::
 close
@@ -36,12 +56,31 @@ close
 
       if (file_writer_->is_open())
       {
+        chunk_names_generator_.set_chunk_time_range(chunk_first_time_,
+                                                    chunk_last_time_,
+                                                    already_written_records_);
+
         status = file_writer_->close();
+        add_sync_statistics();
         delete file_writer_;
         file_writer_ = NULL;
 
         if (status != 0) return status;
       }
+
+      //
+      // Describe the chunks written, if asked to, so readers find them
+      // without scanning the folder.
+      //
+
+      if (chunk_manifest_is_enabled_)
+      {
+        if (chunk_names_generator_.write_manifest() != 0)
+        {
+          data_channel_is_open_ = false;
+          return 1;
+        }
+      }
     }
 
     // Update flags.
@@ -60,20 +99,33 @@ r_matrix_writer
 {
   {
     already_written_records_ = 0;
+    async_flush_             = false;
     data_channel_is_open_    = false;
     data_channel_is_set_     = false;
     data_channel_is_socket_  = false;
+    durability_interval_     = 0;
+    durability_policy_       = _ASTROLABE_DURABILITY_NONE;
     external_base_file_      = "";
     file_mode_is_binary_     = false;
     file_writer_             = NULL;
     header_file_name_        = "";
     host_                    = "";
     lineage_info_            = NULL;
+    max_chunk_bytes_         = 0;
     max_records_per_chunk_   = 0;
+    max_sync_seconds_        = 0;
+    n_syncs_                 = 0;
     numeric_suffix_width_    = 0;
     port_                    = 0;
+    preallocate_chunks_      = false;
     socket_server_mode_      = false;
+    socket_window_           = 1;
     socket_writer_           = NULL;
+    sync_seconds_            = 0;
+
+    chunk_first_time_          = 0.0;
+    chunk_last_time_           = 0.0;
+    chunk_manifest_is_enabled_ = false;
   }
 }
 
@@ -88,6 +140,36 @@ r_matrix_writer::
   }
 }
 
+void
+r_matrix_writer::
+get_sync_statistics
+(long long& n_syncs,
+ double&    seconds,
+ double&    max_seconds)
+const
+{
+  {
+    double    chunk_max_seconds;
+    long long chunk_n_syncs;
+    double    chunk_seconds;
+
+    n_syncs     = n_syncs_;
+    seconds     = sync_seconds_;
+    max_seconds = max_sync_seconds_;
+
+    // Add the figures of the chunk file being written, if any.
+
+    if (file_writer_ != NULL)
+    {
+      file_writer_->get_sync_statistics(chunk_n_syncs, chunk_seconds, chunk_max_seconds);
+
+      n_syncs += chunk_n_syncs;
+      seconds += chunk_seconds;
+      if (chunk_max_seconds > max_seconds) max_seconds = chunk_max_seconds;
+    }
+  }
+}
+
 bool
 r_matrix_writer::  
 is_open
@@ -127,6 +209,7 @@ open
       // Sockets.
 
       socket_writer_ = new r_matrix_socket_writer();
+      socket_writer_->set_window(socket_window_);
       status = socket_writer_->open(host_.c_str(), port_, socket_server_mode_);
       if (status != 0) return status;
     }
@@ -152,6 +235,13 @@ open
       status = header_writer.write();
       if (status != 0) return 2; // Unable to open the data channel.
 
+      //
+      // A manifest left by a previous run would describe the chunks we
+      // are about to replace.
+      //
+
+      if (chunk_names_generator_.remove_manifest() == 2) return 2;
+
 
       //
       // Get the first chunk name. We ignore the return error code since
@@ -174,6 +264,10 @@ open
         file_writer_ = new r_matrix_file_writer_txt();
       }
 
+      file_writer_->set_async_flush(async_flush_);
+      file_writer_->set_durability(durability_policy_, durability_interval_);
+      file_writer_->set_preallocation(preallocate_chunks_ ? max_chunk_bytes_ : 0);
+
       // Open the writer. Beware of errors!
 
       status = file_writer_->open(chunk_filename.c_str());
@@ -191,6 +285,42 @@ open
   }
 }
 
+int
+r_matrix_writer::
+set_async_flush
+(bool enabled)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    async_flush_ = enabled;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+r_matrix_writer::
+set_chunk_manifest
+(bool enabled)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    chunk_manifest_is_enabled_ = enabled;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 r_matrix_writer::  
 set_data_channel 
@@ -297,6 +427,79 @@ set_data_channel
   }
 }
 
+int
+r_matrix_writer::
+set_durability
+(int policy,
+ int interval)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if ((policy < _ASTROLABE_DURABILITY_NONE) ||
+        (policy > _ASTROLABE_DURABILITY_CLOSE)) return 2;
+
+    // Periodic policies need a period.
+
+    if ((policy == _ASTROLABE_DURABILITY_EPOCHS) ||
+        (policy == _ASTROLABE_DURABILITY_MILLISECONDS))
+    {
+      if (interval <= 0) return 3;
+    }
+
+    durability_interval_ = interval;
+    durability_policy_   = policy;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+r_matrix_writer::
+set_max_chunk_size
+(long long max_bytes,
+ bool      preallocate)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (max_bytes < 0) return 2;
+
+    max_chunk_bytes_    = max_bytes;
+    preallocate_chunks_ = preallocate && (max_bytes > 0);
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+r_matrix_writer::
+set_socket_window
+(int n_records)
+{
+  {
+    // The setting must be decided before opening the channel.
+
+    if (data_channel_is_open_) return 1;
+
+    if (n_records < 1) return 2;
+
+    socket_window_ = n_records;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 r_matrix_writer::
 write_r
@@ -334,22 +537,29 @@ write_r
     // We'll use the polymorphic file writer to write the r-record.
     //
     // However, we must check if we've reached the maximum number of
-    // records before writing, so we may split the output into different
-    // file chunks.
+    // records (or the target size, see set_max_chunk_size()) before
+    // writing, so we may split the output into different file chunks.
     //
 
-      if (already_written_records_ == max_records_per_chunk_)
+      if ((already_written_records_ == max_records_per_chunk_) ||
+          ((max_chunk_bytes_ > 0) && (already_written_records_ > 0) &&
+           (file_writer_->get_bytes_stored() >= max_chunk_bytes_)))
       {
 
-        // We've reached the maximum number of epochs per chunk.
+        // We've reached the maximum size of the chunk.
 
-        // Close the current chunk.
+        // Describe it for the manifest, then close it.
+
+        chunk_names_generator_.set_chunk_time_range(chunk_first_time_,
+                                                    chunk_last_time_,
+                                                    already_written_records_);
 
         status = file_writer_->close();
         if (status != 0) return 2; // Error writing to disk.
 
         // Destroy the file writer.
 
+        add_sync_statistics();
         delete file_writer_;
         file_writer_ = NULL;
 
@@ -379,6 +589,10 @@ write_r
           file_writer_ = new r_matrix_file_writer_txt();
         }
 
+        file_writer_->set_async_flush(async_flush_);
+        file_writer_->set_durability(durability_policy_, durability_interval_);
+        file_writer_->set_preallocation(preallocate_chunks_ ? max_chunk_bytes_ : 0);
+
         // Open the writer.
 
         status = file_writer_->open(chunk_filename.c_str());
@@ -392,6 +606,9 @@ write_r
 
       // One more record written!
 
+      if (already_written_records_ == 0) chunk_first_time_ = time;
+      chunk_last_time_ = time;
+
       already_written_records_++;
 
       // Finally, write the r-record! Use the polymorphic writer to do it.
@@ -76,6 +76,22 @@ class r_matrix_writer
 
     int  close                         (void);
 
+    /**
+     * \brief Retrieve the sync statistics of the file data channel.
+     *
+     * \param n_syncs Number of times the chunk files have been committed
+     *        to the storage device (see set_durability()).
+     * \param seconds Total time, in seconds, spent in these commits.
+     * \param max_seconds Time, in seconds, taken by the slowest one.
+     *
+     * Figures add up all the chunk files written so far, including the
+     * one being written, and are kept after closing the channel.
+     */
+
+    void get_sync_statistics           (long long&   n_syncs,
+                                        double&      seconds,
+                                        double&      max_seconds) const;
+
     /**
      * \brief Check if the underlying data channel has already been opened.
      *
@@ -119,6 +135,41 @@ class r_matrix_writer
      */
         ~r_matrix_writer               (void);
 
+    /**
+     * \brief Enable or disable writing the chunk files in the background.
+     *
+     * \param enabled True to write the buffers of the file writers in a
+     *        helper thread.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *
+     * See observation_writer::set_async_flush(). This setting has no effect
+     * on socket data channels. It must be decided before calling open();
+     * by default, buffers are written by the thread calling the writer.
+     */
+
+    int  set_async_flush               (bool         enabled);
+
+    /**
+     * \brief Enable or disable the chunk manifest.
+     *
+     * \param enabled True to write a chunk manifest when closing the
+     *        data channel.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *
+     * See observation_writer::set_chunk_manifest(). The time range of a
+     * chunk is given by its first and last r-records. This setting has no
+     * effect on socket data channels. It must be decided before calling
+     * open(); by default, no manifest is written.
+     */
+
+    int  set_chunk_manifest            (bool         enabled);
+
     /**
      * \brief Set the r_matrix data channel to work with files.
      *
@@ -132,6 +183,7 @@ class r_matrix_writer
      *        will be a binary one. When false, this file will be a text file.
      * \param max_records_to_split Maximum number of r-records to write in any of
      *        the external files containing actual data. Must be greater than zero.
+     *        Chunk files may also be limited by size (see set_max_chunk_size()).
      * \param file_suffix_width Number of digits to use in the suffix part
      *        of the names of the different external files into which data is
      *        written. Range: [1..9].
@@ -267,6 +319,87 @@ class r_matrix_writer
                                         int          port,
                                         bool         server_mode);
 
+    /**
+     * \brief Select when the chunk files are committed to the storage
+     *        device.
+     *
+     * \param policy One of _ASTROLABE_DURABILITY_NONE,
+     *        _ASTROLABE_DURABILITY_EPOCHS, _ASTROLABE_DURABILITY_MILLISECONDS
+     *        or _ASTROLABE_DURABILITY_CLOSE.
+     * \param interval Number of r-records (_ASTROLABE_DURABILITY_EPOCHS) or
+     *        milliseconds (_ASTROLABE_DURABILITY_MILLISECONDS) between
+     *        syncs. Ignored by the other policies.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: Unknown policy.
+     *        - 3: The interval must be greater than zero.
+     *
+     * See r_matrix_based_file_writer::set_durability(). Unless the policy is
+     * _ASTROLABE_DURABILITY_NONE, every chunk file is synced when closed.
+     * Periodic syncs are done by a helper thread, so writing does not wait
+     * for the device. Use get_sync_statistics() to tune the interval.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open(); by default, files are never synced.
+     */
+
+    int  set_durability                (int          policy,
+                                        int          interval);
+
+    /**
+     * \brief Split the chunk files by size, and optionally reserve their
+     *        space in advance.
+     *
+     * \param max_bytes Target size, in bytes, of every chunk file. Zero
+     *        disables the limit.
+     * \param preallocate When true, the space of every chunk file
+     *        (max_bytes) is reserved when it is created (see
+     *        r_matrix_based_file_writer::set_preallocation()).
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: The size must not be negative.
+     *
+     * See observation_writer::set_max_chunk_size(). A new chunk file is
+     * started before writing an r-record once the current chunk holds
+     * max_bytes or more; the maximum number of r-records per chunk (see
+     * set_data_channel()) is still honored. As there, space is reserved
+     * on Linux and Windows only; elsewhere, preallocate is silently ignored.
+     *
+     * This setting has no effect on socket data channels. It must be
+     * decided before calling open(); by default, chunks are split by
+     * number of r-records only.
+     */
+
+    int  set_max_chunk_size            (long long    max_bytes,
+                                        bool         preallocate);
+
+    /**
+     * \brief Let several records travel through socket data channels
+     *        without waiting for their acknowledgement.
+     *
+     * \param n_records Maximum number of records not acknowledged yet.
+     *        One (the default) keeps the stop-and-wait protocol, where
+     *        every record waits for its acknowledgement.
+     *
+     * \return Error code. Error code values:
+     *        - 0: Successful completion.
+     *        - 1: The data channel is already open.
+     *        - 2: The window must be greater than zero.
+     *
+     * See r_matrix_socket_writer::set_window(). A window greater than one
+     * is asked for when the connection is opened, so the reader must
+     * understand the windowed protocol; otherwise, open() fails.
+     *
+     * This setting has no effect on file data channels. It must be
+     * decided before calling open().
+     */
+
+    int  set_socket_window             (int          n_records);
+
     /**
      * \brief Write an r-record.
      *
@@ -297,6 +430,28 @@ class r_matrix_writer
 
   protected:
 
+    /**
+     * \brief Add the sync statistics of the chunk file writer to those
+     *        of the channel, before destroying it.
+     */
+
+    void add_sync_statistics           (void);
+
+  protected:
+
+    /// \brief Flag. When true, a chunk manifest is written when closing
+    /// the data channel (see set_chunk_manifest()).
+
+    bool                            chunk_manifest_is_enabled_;
+
+    /// \brief Time tag of the first r-record of the current chunk.
+
+    double                          chunk_first_time_;
+
+    /// \brief Time tag of the last r-record of the current chunk.
+
+    double                          chunk_last_time_;
+
     /// \brief The chunk files name generator.
 
     segmented_file_utils            chunk_names_generator_;
@@ -306,6 +461,11 @@ class r_matrix_writer
 
     int                             already_written_records_;
 
+    /// \brief Flag stating if the file writers must write their buffers in
+    /// the background.
+
+    bool                            async_flush_;
+
     /// \brief Flag. When true, indicates that the underlying data
     /// channel is open.
 
@@ -321,6 +481,14 @@ class r_matrix_writer
 
     bool                            data_channel_is_socket_;
 
+    /// \brief Number of r-records or milliseconds between syncs.
+
+    int                             durability_interval_;
+
+    /// \brief When to sync the chunk files (see set_durability()).
+
+    int                             durability_policy_;
+
     /// \brief Base name of the external files written when working in
     /// external mode.
 
@@ -349,10 +517,23 @@ class r_matrix_writer
 
     lineage_data*                   lineage_info_;
 
+    /// \brief Target size, in bytes, of a chunk file (0: no limit).
+
+    long long                       max_chunk_bytes_;
+
     /// \brief Maximum number of records to write in a single chunk file.
 
     int                             max_records_per_chunk_;
 
+    /// \brief Time, in seconds, taken by the slowest sync of the chunk
+    /// files already closed.
+
+    double                          max_sync_seconds_;
+
+    /// \brief Number of syncs of the chunk files already closed.
+
+    long long                       n_syncs_;
+
     /// \brief Width in characters of the numeric suffix used to identify
     /// the different chunk file names.
 
@@ -362,17 +543,32 @@ class r_matrix_writer
 
     int                             port_;
 
+    /// \brief Flag. True when the space of the chunk files must be reserved
+    /// when these are created (see set_max_chunk_size()).
+
+    bool                            preallocate_chunks_;
+
     /// \brief Flag stating if the socket has to work as a server (listener)
     /// or not (client).
 
 
     bool                            socket_server_mode_;
 
+    /// \brief Window asked for when opening socket data channels (see
+    /// set_socket_window()).
+
+    int                             socket_window_;
+
     /// \brief Socket writer in charge to write correlation matrix data
     /// using a socket conection.
 
     r_matrix_socket_writer*         socket_writer_;
 
+    /// \brief Time, in seconds, spent syncing the chunk files already
+    /// closed.
+
+    double                          sync_seconds_;
+
 };
 
 #endif // R_MATRIX_WRITER_HPP
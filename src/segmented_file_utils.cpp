@@ -5,6 +5,17 @@
 
 #include "segmented_file_utils.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <dirent.h>
+#endif
+
 
 string
 segmented_file_utils::
@@ -98,37 +109,68 @@ find_all_chuncks
 {
   {
 
-    int    file_number;
-    bool   first_chunk_found;
-    string test_filename;
-    int    width;
+    int         file_number;
+    bool        first_chunk_found;
+    bool        found;
+    bool        listed;
+    set<string> suffixes;
+    string      test_filename;
+    int         width;
+
+    //
+    // List the folder once, so the candidate names below are looked up in
+    // memory. Should the folder not be listed, check the candidates on disk.
+    //
+
+    listed = (list_chunk_suffixes(filename, suffixes) == 0);
 
     // Test for suffixes whose widths range from 1 to 9 chars wide.
 
     first_chunk_found = false;
 
-    for (width = 1; width <= 9; width++)
+    while (true)
     {
-      //
-      // Build the name of the first file to test. Its chunk number is 1
-      // and the current test width is fixed by variable width.
-      //
-
-      test_filename = build_chunk_name(filename, 1, width);
-
-      // Does this file exist?
-
-      if (file_exists(test_filename))
+      for (width = 1; width <= 9; width++)
       {
         //
-        // Yes! We've found the first file chunk and now know how wide is
-        // the numeric suffix!
+        // Build the name of the first file to test. Its chunk number is 1
+        // and the current test width is fixed by variable width.
         //
 
-        first_chunk_found = true;
-        suffix_width = width;
-        break;
+        if (listed)
+        {
+          found = (suffixes.count(zero_pad_number(1, width)) != 0);
+        }
+        else
+        {
+          test_filename = build_chunk_name(filename, 1, width);
+          found         = file_exists(test_filename);
+        }
+
+        // Does this file exist?
+
+        if (found)
+        {
+          //
+          // Yes! We've found the first file chunk and now know how wide is
+          // the numeric suffix!
+          //
+
+          first_chunk_found = true;
+          suffix_width = width;
+          break;
+        }
       }
+
+      //
+      // When no first chunk has been listed, check the candidates on disk
+      // before giving up: the file system may match names regardless of
+      // their case (as on macOS) while the listing does not.
+      //
+
+      if (first_chunk_found || !listed) break;
+
+      listed = false;
     }
 
     // Check if we really have the name of the first file chunk.
@@ -155,11 +197,19 @@ find_all_chuncks
       // suffix width we've found above.
       //
 
-      test_filename = build_chunk_name(filename, file_number, suffix_width);
+      if (listed)
+      {
+        found = (suffixes.count(zero_pad_number(file_number, suffix_width)) != 0);
+      }
+      else
+      {
+        test_filename = build_chunk_name(filename, file_number, suffix_width);
+        found         = file_exists(test_filename);
+      }
 
       // Does this file exist?
 
-      if (!file_exists(test_filename))
+      if (!found)
       {
         //
         // It does not exist. We've reached the last chunk.
@@ -183,6 +233,62 @@ find_all_chuncks
   }
 }
 
+int
+segmented_file_utils::
+get_chunk_filename
+(int     number,
+ string& chunk_filename)
+{
+  {
+    // Only available in read mode.
+
+    if (mode_work_ != __SFU_WORK_MODE_READ__) return 2;
+
+    // Check that the chunk does exist.
+
+    if ((number < 1) || (number > chunks_total_)) return 1;
+
+    // Generate the name of the chunk.
+
+    chunk_filename = build_chunk_name(filename_, number, numeric_suffix_width_);
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+segmented_file_utils::
+get_chunk_time_range
+(int        number,
+ double&    first_time,
+ double&    last_time,
+ long long& n_records)
+{
+  {
+    // Only available in read mode.
+
+    if (mode_work_ != __SFU_WORK_MODE_READ__) return 2;
+
+    // Check that the chunk does exist.
+
+    if ((number < 1) || (number > chunks_total_)) return 1;
+
+    // Ranges come from the manifest only, and must describe every chunk.
+
+    if ((int)n_records_.size() != chunks_total_) return 3;
+
+    first_time = first_times_[number - 1];
+    last_time  = last_times_ [number - 1];
+    n_records  = n_records_  [number - 1];
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 segmented_file_utils::
 get_next_filename
@@ -206,11 +312,16 @@ get_next_filename
         // Backwards reader.
         //
         // Decrease the current chunk number. Reaching 0 means that
-        // no more chunks exist.
+        // no more chunks exist. Stay there, so further calls keep on
+        // reporting so.
         //
 
         chunks_current_--;
-        if (chunks_current_ == 0) return 1;
+        if (chunks_current_ <= 0)
+        {
+          chunks_current_ = 0;
+          return 1;
+        }
       }
       else
       {
@@ -218,11 +329,16 @@ get_next_filename
         // Forward reader.
         //
         // Increase the current chunk number. Surpassing the value of
-        // chunks total means that no more chunks exist.
+        // chunks total means that no more chunks exist (stay there, as
+        // backwards readers do).
         //
 
         chunks_current_++;
-        if (chunks_current_ > chunks_total_) return 1;
+        if (chunks_current_ > chunks_total_)
+        {
+          chunks_current_ = chunks_total_ + 1;
+          return 1;
+        }
       }
     }
     else
@@ -251,6 +367,18 @@ get_next_filename
   }
 }
 
+int
+segmented_file_utils::
+get_number_of_chunks
+(void)
+{
+  {
+    if (mode_work_ != __SFU_WORK_MODE_READ__) return 0;
+
+    return chunks_total_;
+  }
+}
+
 segmented_file_utils::
 segmented_file_utils
 (void)
@@ -260,6 +388,7 @@ segmented_file_utils
     chunks_total_         = 0;
     chunks_current_       = 0;
     filename_             = "";
+    manifest_cache_       = false;
     max_chunks_           = 0;
     mode_work_            = __SFU_WORK_MODE_UNSET__ ;
     mode_read_            = __SFU_READ_MODE_UNSET__;
@@ -277,6 +406,374 @@ segmented_file_utils::
   }
 }
 
+int
+segmented_file_utils::
+list_chunk_suffixes
+(const string& filename,
+ set<string>&  suffixes)
+{
+  {
+    string         directory;
+    vector<string> entries;
+    string         extension;
+    size_t         found;
+    size_t         i;
+    string         name;
+    string         path_and_basename;
+    string         prefix;
+    string         suffix;
+    string         tail;
+
+    //
+    // Chunk names are made of the path and base name of the generic file,
+    // an underscore, the numeric suffix and the extension, if any (see
+    // build_chunk_name()). Split the first part into folder and prefix.
+    //
+
+    filename_split(filename, path_and_basename, extension);
+
+    found = path_and_basename.find_last_of("/\\");
+
+    if (found == string::npos)
+    {
+      directory = "";
+      prefix    = path_and_basename + "_";
+    }
+    else
+    {
+      directory = path_and_basename.substr(0, found + 1);
+      prefix    = path_and_basename.substr(found + 1) + "_";
+    }
+
+    tail = "";
+    if (extension != "") tail = "." + extension;
+
+    // Retrieve the names of all the entries in the folder at once.
+
+    #ifdef _WIN32
+    {
+      struct _finddata_t entry;
+      intptr_t           handle;
+
+      handle = _findfirst((directory + "*").c_str(), &entry);
+      if (handle == -1) return 1;
+
+      do
+      {
+        entries.push_back(entry.name);
+      }
+      while (_findnext(handle, &entry) == 0);
+
+      _findclose(handle);
+    }
+    #else
+    {
+      DIR*           folder;
+      struct dirent* entry;
+
+      folder = opendir((directory == "") ? "." : directory.c_str());
+      if (folder == NULL) return 1;
+
+      while ((entry = readdir(folder)) != NULL) entries.push_back(entry->d_name);
+
+      closedir(folder);
+    }
+    #endif
+
+    //
+    // Names are not case sensitive on Windows, so neither is the match
+    // there.
+    //
+
+    #ifdef _WIN32
+      transform(prefix.begin(), prefix.end(), prefix.begin(), ::tolower);
+      transform(tail.begin(),   tail.end(),   tail.begin(),   ::tolower);
+    #endif
+
+    //
+    // Keep the suffixes of the names following the convention: the prefix,
+    // 1 to 9 digits and the extension.
+    //
+
+    suffixes.clear();
+
+    for (i = 0; i < entries.size(); i++)
+    {
+      name = entries[i];
+
+      #ifdef _WIN32
+        transform(name.begin(), name.end(), name.begin(), ::tolower);
+      #endif
+
+      if (name.size() <= (prefix.size() + tail.size()))                       continue;
+      if (name.compare(0, prefix.size(), prefix) != 0)                        continue;
+      if (name.compare(name.size() - tail.size(), tail.size(), tail) != 0)    continue;
+
+      suffix = name.substr(prefix.size(), name.size() - prefix.size() - tail.size());
+
+      if (suffix.size() > 9)                                      continue;
+      if (suffix.find_first_not_of("0123456789") != string::npos) continue;
+
+      suffixes.insert(suffix);
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+string
+segmented_file_utils::
+manifest_file_name
+(const string& filename)
+{
+  {
+    return filename + _ASTROLABE_CHUNK_MANIFEST_EXTENSION;
+  }
+}
+
+int
+segmented_file_utils::
+read_manifest
+(const string& filename,
+ int&  number_of_chunks,
+ int&  suffix_width)
+{
+  {
+    int               chunk;
+    int               chunks;
+    double            first_time;
+    vector<double>    first_times;
+    double            last_time;
+    vector<double>    last_times;
+    int               i;
+    char              line[256];
+    FILE*             manifest;
+    int               max_chunks;
+    long long         n_records;
+    vector<long long> records;
+    bool              signed_file;
+    int               width;
+
+    manifest = fopen(manifest_file_name(filename).c_str(), "r");
+    if (manifest == NULL) return 1;
+
+    //
+    // The signature comes first. Then, the width of the suffix and the
+    // number of chunks, in any order, and the time ranges of the chunks,
+    // if known (see set_chunk_time_range()). Other lines are skipped.
+    //
+    // The time ranges are read in a second pass, once the number of chunks
+    // has been checked, so corrupt chunk numbers can't make us allocate
+    // more room than the chunks on disk need.
+    //
+
+    chunks = 0;
+    width  = 0;
+
+    signed_file = ((fgets(line, sizeof(line), manifest) != NULL) &&
+                   (strncmp(line, _ASTROLABE_CHUNK_MANIFEST_SIGNATURE,
+                            strlen(_ASTROLABE_CHUNK_MANIFEST_SIGNATURE)) == 0));
+
+    if (signed_file)
+    {
+      while (fgets(line, sizeof(line), manifest) != NULL)
+      {
+        sscanf(line, "suffix_width %d", &width);
+        sscanf(line, "chunks %d",       &chunks);
+      }
+    }
+
+    //
+    // No more than 10^width - 1 chunks may be numbered with the width
+    // given.
+    //
+
+    max_chunks = 1;
+    for (i = 0; (i < width) && (i < 9); i++) max_chunks *= 10;
+    max_chunks--;
+
+    if ((!signed_file)             ||
+        (width < 1) || (width > 9) ||
+        (chunks < 1)               ||
+        (chunks > max_chunks))
+    {
+      fclose(manifest);
+      return 1;
+    }
+
+    //
+    // The manifest may be stale (chunks added or removed afterwards). It
+    // is trusted as long as its first and last chunks exist and no chunk
+    // follows the last one.
+    //
+
+    if ((!file_exists(build_chunk_name(filename, 1,          width))) ||
+        (!file_exists(build_chunk_name(filename, chunks,     width))) ||
+        ( file_exists(build_chunk_name(filename, chunks + 1, width))))
+    {
+      fclose(manifest);
+      return 1;
+    }
+
+    number_of_chunks = chunks;
+    suffix_width     = width;
+
+    // Second pass: the time ranges.
+
+    first_times.resize(chunks, 0.0);
+    last_times.resize (chunks, 0.0);
+    records.resize    (chunks, -1);
+
+    rewind(manifest);
+
+    if (fgets(line, sizeof(line), manifest) != NULL)
+    {
+      while (fgets(line, sizeof(line), manifest) != NULL)
+      {
+        if (sscanf(line, "chunk %d %lld %lf %lf", &chunk, &n_records, &first_time, &last_time) == 4)
+        {
+          if ((chunk < 1) || (chunk > chunks) || (n_records < 0)) continue;
+
+          first_times[chunk - 1] = first_time;
+          last_times [chunk - 1] = last_time;
+          records    [chunk - 1] = n_records;
+        }
+      }
+    }
+
+    fclose(manifest);
+
+    // Keep the time ranges only when every chunk is described.
+
+    first_times_.clear();
+    last_times_.clear();
+    n_records_.clear();
+
+    for (chunk = 0; chunk < chunks; chunk++)
+    {
+      if (records[chunk] < 0) break;
+    }
+
+    if (chunk == chunks)
+    {
+      first_times_.swap(first_times);
+      last_times_.swap (last_times);
+      n_records_.swap  (records);
+    }
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+segmented_file_utils::
+remove_manifest
+(void)
+{
+  {
+    string manifest_name;
+
+    // Only available in write mode.
+
+    if (mode_work_ != __SFU_WORK_MODE_WRITE__) return 1;
+
+    manifest_name = manifest_file_name(filename_);
+
+    if (!file_exists(manifest_name)) return 0;
+    if (remove(manifest_name.c_str()) != 0) return 2;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+segmented_file_utils::
+set_chunk_time_range
+(double    first_time,
+ double    last_time,
+ long long n_records)
+{
+  {
+    int chunk;
+
+    // Only available in write mode.
+
+    if (mode_work_ != __SFU_WORK_MODE_WRITE__) return 2;
+
+    // The chunk whose name has been generated last.
+
+    chunk = chunks_current_;
+    if (chunk > max_chunks_) chunk = max_chunks_;
+    if (chunk < 1)           return 1;
+
+    if (chunk > (int)n_records_.size())
+    {
+      first_times_.resize(chunk, 0.0);
+      last_times_.resize (chunk, 0.0);
+      n_records_.resize  (chunk, -1);
+    }
+
+    first_times_[chunk - 1] = first_time;
+    last_times_ [chunk - 1] = last_time;
+    n_records_  [chunk - 1] = (n_records < 0) ? 0 : n_records;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+segmented_file_utils::
+set_current_chunk
+(int number)
+{
+  {
+    // Only available in read mode.
+
+    if (mode_work_ != __SFU_WORK_MODE_READ__) return 2;
+
+    // Check that the chunk does exist.
+
+    if ((number < 1) || (number > chunks_total_)) return 1;
+
+    //
+    // get_next_filename() moves from the current chunk before building
+    // the name, so it will continue with the neighbour of this one.
+    //
+
+    chunks_current_ = number;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
+int
+segmented_file_utils::
+set_manifest_cache
+(bool enabled)
+{
+  {
+    // The manifest is saved by set_mode_read().
+
+    if (mode_work_ != __SFU_WORK_MODE_UNSET__) return 1;
+
+    manifest_cache_ = enabled;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 int
 segmented_file_utils::
 set_mode_read
@@ -284,9 +781,10 @@ set_mode_read
  bool  backwards_reader)
 {
   {
-    int number_of_chunks;
-    int status;
-    int suffix_width;
+    int  number_of_chunks;
+    bool scanned;
+    int  status;
+    int  suffix_width;
 
     // The operations mode may be set only once.
 
@@ -302,10 +800,20 @@ set_mode_read
     backwards_reader_ = backwards_reader;
     filename_         = filename;
 
-    // Try to find the chunks making our generic file.
+    //
+    // Try to find the chunks making our generic file. A valid manifest
+    // saves scanning the folder.
+    //
 
-    status = find_all_chuncks(filename, number_of_chunks, suffix_width);
-    if (status != 0) return 3;
+    scanned = false;
+
+    if (read_manifest(filename, number_of_chunks, suffix_width) != 0)
+    {
+      status = find_all_chuncks(filename, number_of_chunks, suffix_width);
+      if (status != 0) return 3;
+
+      scanned = true;
+    }
 
     // Chunks identified. Set more attributes.
 
@@ -321,6 +829,13 @@ set_mode_read
       chunks_current_ = 0;
     }
 
+    //
+    // Save what we've found for the next time, if asked to. Failing to do
+    // so is not an error; the folder will just be scanned again.
+    //
+
+    if (scanned && manifest_cache_) write_manifest();
+
     // That's all.
 
     return 0;
@@ -360,6 +875,78 @@ set_mode_write
   }
 }
 
+int
+segmented_file_utils::
+write_manifest
+(void)
+{
+  {
+    int   chunk;
+    bool  described;
+    FILE* manifest;
+    int   number_of_chunks;
+    int   status;
+
+    //
+    // Readers describe the chunks found; writers, the chunks whose names
+    // have been generated (the last request may have failed, though).
+    //
+
+    if (mode_work_ == __SFU_WORK_MODE_READ__)
+    {
+      number_of_chunks = chunks_total_;
+    }
+    else if (mode_work_ == __SFU_WORK_MODE_WRITE__)
+    {
+      number_of_chunks = chunks_current_;
+      if (number_of_chunks > max_chunks_) number_of_chunks = max_chunks_;
+    }
+    else
+    {
+      return 1;
+    }
+
+    if (number_of_chunks < 1) return 1;
+
+    manifest = fopen(manifest_file_name(filename_).c_str(), "w");
+    if (manifest == NULL) return 2;
+
+    status = fprintf(manifest, "%s\nsuffix_width %d\nchunks %d\n",
+                     _ASTROLABE_CHUNK_MANIFEST_SIGNATURE,
+                     numeric_suffix_width_,
+                     number_of_chunks);
+
+    //
+    // The time ranges, only when every chunk is described (readers ignore
+    // partial sets anyway). Times are written with enough digits to be
+    // read back exactly.
+    //
+
+    described = ((int)n_records_.size() >= number_of_chunks);
+
+    for (chunk = 0; described && (chunk < number_of_chunks); chunk++)
+    {
+      if (n_records_[chunk] < 0) described = false;
+    }
+
+    for (chunk = 0; described && (status >= 0) && (chunk < number_of_chunks); chunk++)
+    {
+      status = fprintf(manifest, "chunk %d %lld %.17g %.17g\n",
+                       chunk + 1,
+                       n_records_[chunk],
+                       first_times_[chunk],
+                       last_times_[chunk]);
+    }
+
+    if (fclose(manifest) != 0) return 2;
+    if (status < 0)            return 2;
+
+    // That's all.
+
+    return 0;
+  }
+}
+
 string
 segmented_file_utils::
 zero_pad_number
@@ -36,9 +36,12 @@
 
 #endif // __GNUC__
 
+#include <cstdio>
 #include <iomanip>
+#include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <iostream>
 
@@ -70,6 +73,15 @@ using namespace std;
 
 #define __SFU_READ_MODE_BACKWARDS__ 2
 
+/// \brief Extension appended to generic file names to name their chunk
+/// manifests (see segmented_file_utils::write_manifest()).
+
+#define _ASTROLABE_CHUNK_MANIFEST_EXTENSION ".chunks"
+
+/// \brief First line of chunk manifests.
+
+#define _ASTROLABE_CHUNK_MANIFEST_SIGNATURE "ASTROLABE_CHUNK_MANIFEST 1"
+
 /// \brief File name generator for files that are actually stored in
 /// different numbered fragments or chunks.
 
@@ -136,6 +148,29 @@ using namespace std;
   object simply scans the folder where the chunk files are stored and
   analyzes how these are named to provide with the correct chunk file
   names.
+
+  Scanning means listing the folder once and matching the names found
+  against the naming convention, so the time needed does not depend on
+  the number of chunks (as it would by checking the existence of every
+  candidate name, which is only done when the folder may not be listed).
+  Datasets with many chunks, or stored on network file systems, may skip
+  even this listing by means of a chunk manifest: a small text file
+  named after the generic file plus _ASTROLABE_CHUNK_MANIFEST_EXTENSION
+  (for instance, "myfile.dat.chunks") that records the width of the
+  numeric suffix and the number of chunks. Manifests are written by
+  write_manifest(), usually called by segmented writers once all the
+  chunks are closed, or by readers that ask for it (see
+  set_manifest_cache()). When a manifest is found, set_mode_read() trusts
+  it as long as its first and last chunks exist and no chunk follows
+  the last one.
+
+  Writers may also describe every chunk they close by its first and last
+  epoch times and its number of records (see set_chunk_time_range()).
+  These ranges are saved in the manifest too, and are available to
+  readers through get_chunk_time_range(), so these may find the chunk
+  holding a given time without opening the rest. Since ranges are only
+  trusted along with the manifest, writers must remove_manifest() before
+  writing the chunks of a generic file again.
   
   On the contrary, when creating files, the calling module decides
   on the final naming, and this class is just a helper to simplifly the
@@ -447,8 +482,69 @@ class segmented_file_utils
       and set_mode_write()) has been selected.
      */
 
+    /// \brief Get the full file name of a given chunk.
+    /**
+      \param number The number of the chunk, starting at 1.
+      \param chunk_filename On output, the name of the requested chunk file.
+      \return Error code. Error code values:
+              - 0: Successful completion.
+              - 1: Chunk number out of range.
+              - 2: Operation mode not set to read.
+
+      Provides random access to the names of the chunks identified by
+      set_mode_read(). The sequence of names returned by get_next_filename()
+      is not altered.
+     */
+
+    int    get_chunk_filename    (int number, string& chunk_filename);
+
+    /// \brief Get the time range of a given chunk, as recorded in its manifest.
+    /**
+      \param number The number of the chunk, starting at 1.
+      \param first_time On output, the time tag of the first epoch written
+             to the chunk.
+      \param last_time On output, the time tag of the last epoch written
+             to the chunk.
+      \param n_records On output, the number of records in the chunk. When
+             0, the chunk is empty and both times are meaningless.
+      \return Error code. Error code values:
+              - 0: Successful completion.
+              - 1: Chunk number out of range.
+              - 2: Operation mode not set to read.
+              - 3: The chunks were not found through a manifest, or the
+                   manifest does not describe the time range of every chunk.
+
+      Times are given in the order the epochs were written, so the first
+      one is greater than the last one in chunks written backwards. No
+      file is accessed.
+     */
+
+    int    get_chunk_time_range  (int number, double& first_time, double& last_time, long long& n_records);
+
     int    get_next_filename     (string& next_filename);
 
+    /// \brief Get the number of chunks making the generic file.
+    /**
+      \return The number of chunks found by set_mode_read(), or 0 if the
+              read mode has not been set.
+     */
+
+    int    get_number_of_chunks  (void);
+
+    /// \brief Remove the chunk manifest of the generic file, if any.
+    /**
+      \return Error code. Error code values:
+              - 0: Successful completion (including when there was no
+                   manifest to remove).
+              - 1: Operation mode not set to write.
+              - 2: Unable to remove the manifest file.
+
+      Writers call this method before writing the first chunk, so a
+      manifest describing the chunks being replaced is never trusted.
+     */
+
+    int    remove_manifest       (void);
+
     /// \brief Constructor.
 
            segmented_file_utils  (void);
@@ -528,6 +624,72 @@ class segmented_file_utils
 
     int    set_mode_write        (const string& filename, int numeric_suffix_width);
 
+    /// \brief Set the chunk considered as the current one when reading.
+    /**
+      \param number The number of the chunk, starting at 1.
+      \return Error code. Error code values:
+              - 0: Successful completion.
+              - 1: Chunk number out of range.
+              - 2: Operation mode not set to read.
+
+      Once called, get_next_filename() will continue from the given
+      chunk, that is, it will return the name of the chunk following
+      it (forward readers) or preceding it (backwards readers). This
+      makes it possible to jump to any chunk without losing the ability
+      to walk through the remaining ones.
+     */
+
+    int    set_current_chunk     (int number);
+
+    /// \brief Describe the chunk being written.
+    /**
+      \param first_time Time tag of the first epoch written to the chunk.
+      \param last_time Time tag of the last epoch written to the chunk.
+      \param n_records Number of records written to the chunk (0 if empty).
+      \return Error code. Error code values:
+              - 0: Successful completion.
+              - 1: No chunk name has been generated yet.
+              - 2: Operation mode not set to write.
+
+      The description applies to the chunk whose name was returned last by
+      get_next_filename(), and is saved by write_manifest() (see
+      get_chunk_time_range()). Writers call it when closing each chunk.
+     */
+
+    int    set_chunk_time_range  (double first_time, double last_time, long long n_records);
+
+    /// \brief Ask set_mode_read() to save a chunk manifest.
+    /**
+      \param enabled True to save a manifest whenever set_mode_read() has
+             to scan the folder because no valid manifest exists.
+      \return Error code. Error code values:
+              - 0: Successful completion.
+              - 1: The operation mode was already set.
+
+      Readers opening the same generic file later on will then find the
+      chunks without scanning the folder. Failing to save the manifest (for
+      instance, on read only media) is not an error. By default, no
+      manifest is saved.
+     */
+
+    int    set_manifest_cache    (bool enabled);
+
+    /// \brief Save the chunk manifest of the generic file.
+    /**
+      \return Error code. Error code values:
+              - 0: Successful completion.
+              - 1: Operation mode not set, or no chunks to describe.
+              - 2: Unable to write the manifest file.
+
+      The manifest describes the chunks identified by set_mode_read() or,
+      in write mode, the chunks whose names have been generated so far by
+      get_next_filename(), so writers must call this method once the last
+      chunk has been written. The time ranges of the chunks, when every
+      one of them is known, are saved as well.
+     */
+
+    int    write_manifest        (void);
+
   protected:
 
     /// \brief Build the name of a chunk file given the generic file name,
@@ -609,10 +771,54 @@ class segmented_file_utils
       \return Error code. Error code values:
               - 0: Successful completion.
               - 1: Unable to find the chunks composing the file.
+
+      The folder is listed once (see list_chunk_suffixes()). When it may
+      not be listed, or no first chunk is found in the listing, the
+      candidate names are checked one at a time, so chunks are found
+      whenever the file system finds them.
      */
 
     int    find_all_chuncks      (const string& filename, int&  number_of_chunks, int&  suffix_width);
 
+    /// \brief Collect the numeric suffixes of the chunk files found in the
+    /// folder of a generic file.
+    /**
+      \param filename The generic file name whose chunks must be listed.
+      \param suffixes On output, the numeric suffixes (as found in the names,
+             zeros included) of the files following the naming convention.
+             On Windows, names are matched regardless of their case.
+      \return Error code. Error code values:
+              - 0: Successful completion.
+              - 1: Unable to list the folder.
+     */
+
+    int    list_chunk_suffixes   (const string& filename, set<string>& suffixes);
+
+    /// \brief Build the name of the chunk manifest of a generic file.
+    /**
+      \param filename The generic file name.
+      \return The name of its manifest file.
+     */
+
+    string manifest_file_name    (const string& filename);
+
+    /// \brief Read the chunk manifest of a generic file, if any.
+    /**
+      \param filename The generic file name whose manifest must be read.
+      \param number_of_chunks On output, the number of chunks in the manifest.
+      \param suffix_width On output, the width of the numeric suffix.
+      \return Error code. Error code values:
+              - 0: Successful completion.
+              - 1: No manifest, or the manifest does not describe the chunks
+                   on disk any longer.
+
+      Only the first chunk, the last one and the one following the last
+      one are checked, so the folder is not scanned. The time ranges of
+      the chunks, if the manifest records all of them, are loaded too.
+     */
+
+    int    read_manifest         (const string& filename, int&  number_of_chunks, int&  suffix_width);
+
     /// \brief Returns a string version of a integer, left-padded with zeros up
     // up to the desired width.
     /**
@@ -647,6 +853,14 @@ class segmented_file_utils
 
     int    chunks_total_;
 
+    /// \brief Time tags of the first epoch of every chunk (index 0 is chunk 1).
+
+    vector<double>    first_times_;
+
+    /// \brief Time tags of the last epoch of every chunk.
+
+    vector<double>    last_times_;
+
     /// \brief The generic name of the file  which is actuall split into chunks.
 
     string filename_;
@@ -656,6 +870,11 @@ class segmented_file_utils
 
     int    max_chunks_;
 
+    /// \brief Flag. When true, set_mode_read() saves a manifest after
+    /// scanning the folder (see set_manifest_cache()).
+
+    bool   manifest_cache_;
+
     /// \brief Read mode (unset, forward, backwards).
 
     int    mode_read_;
@@ -664,6 +883,10 @@ class segmented_file_utils
 
     int    mode_work_;
 
+    /// \brief Number of records of every chunk. -1 for chunks not described.
+
+    vector<long long> n_records_;
+
     /// \brief Width in characters of the string version of the numeric suffix.
 
     int    numeric_suffix_width_;
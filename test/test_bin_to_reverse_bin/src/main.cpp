@@ -29,6 +29,11 @@ main
   int                                   i;
   string                                sid;
 
+  // I/O statistics of the backwards reader.
+
+  long long                             bytes_read;
+  double                                seconds;
+
   // Variables to hold l- or o-records.
 
   char                                  type;
@@ -348,6 +353,17 @@ main
     i = 1;
   }
 
+  //
+  // Report the throughput achieved by the backwards reader. Compare it
+  // to that of a forward pass over the same file.
+  //
+
+  reverse_binary_reader->get_read_statistics(bytes_read, seconds);
+
+  cout << "Bytes read: " << bytes_read << ", seconds waiting for I/O: " << seconds;
+  if (seconds > 0) cout << " (" << (bytes_read / seconds) / (1024.0 * 1024.0) << " Mbyte/s)";
+  cout << endl;
+
   // Try to close the output file.
 
   io_status = binary_writer->close();
@@ -1,9 +1,11 @@
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
 #include "RecordStructure.hpp"
 
 #include "observation_file_reader_bin_forward.hpp"
+#include "observation_file_reader_bin_parallel.hpp"
 #include "observation_file_writer_txt.hpp"
 
 using namespace std;
@@ -18,9 +20,13 @@ main
   string                               infile_name;
   string                               outfile_name;
 
-  // The binary reader (forward) and text writer objects.
+  //
+  // The binary reader (either forward or parallel) and text writer objects.
+  // When a number of threads is given, the parallel reader is used.
+  //
 
-  observation_file_reader_bin_forward* binary_reader;
+  obs_e_based_file_reader_bin*         binary_reader;
+  int                                  n_threads;
   observation_file_writer_txt*         text_writer;
 
   // Auxiliary data. Return codes, counters for loops.
@@ -71,13 +77,16 @@ main
 
   if (argc < 3)
   {
-    cout << "usage: test_bin_to_txt input_bin_file_name output_txt_file_name" << endl;
+    cout << "usage: test_bin_to_txt input_bin_file_name output_txt_file_name [n_threads]" << endl;
     return 1;
   }
 
   infile_name  = argv[1];
   outfile_name = argv[2];
 
+  n_threads    = -1;
+  if (argc > 3) n_threads = atoi(argv[3]);
+
   //
   // We will dimension the different variable length data
   // arrays according to the maximum dimension needed. To
@@ -129,9 +138,24 @@ main
   identifier = new char[identifier_width + 1];
   identifier_width++; // Takes into account the ending NULL char.
 
-  // Instantiate the new binary forward reader.
+  //
+  // Instantiate the new binary reader. The parallel one decodes the file
+  // using n_threads worker threads (0: as many as cores).
+  //
 
-  binary_reader = new observation_file_reader_bin_forward();
+  if (n_threads < 0)
+  {
+    binary_reader = new observation_file_reader_bin_forward();
+  }
+  else
+  {
+    observation_file_reader_bin_parallel* parallel_reader;
+
+    parallel_reader = new observation_file_reader_bin_parallel();
+    parallel_reader->set_number_of_threads(n_threads);
+
+    binary_reader = parallel_reader;
+  }
 
   //
   // Set the maximum size of the reader's buffer in BYTES.
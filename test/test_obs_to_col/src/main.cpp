@@ -0,0 +1,122 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "observation_file_reader_col.hpp"
+
+using namespace std;
+
+//
+// Check the columnar files written by astrolabe-convert (output format
+// col). The conversion itself is done by the tool, whose record layout
+// comes from the metadata files, for instance:
+//
+//   astrolabe-convert input.xml output.xml output.col col units.xml metadata.xml
+//   test_obs_to_col output_001.col
+//
+// The chunk file given is read back by column.
+//
+
+int
+main
+(int argc, char** argv)
+{
+
+  // The name of the columnar file to check.
+
+  string                               infile_name;
+
+  // The columnar reader.
+
+  observation_file_reader_col*         columnar_reader;
+
+  // Auxiliary data. Return codes, counters for loops.
+
+  int                                  io_status;
+  int                                  i;
+  int                                  j;
+
+  // Variables used to check the columnar file.
+
+  vector<int>                          blocks;
+  vector<double>                       column_expectations;
+  vector<double>                       column_times;
+  int                                  n_records;
+  double                               sum_expectations;
+
+  //
+  // Check the number of parameters. We need just one (besides the name
+  // of the program): the columnar chunk file to read.
+  //
+
+  if (argc < 2)
+  {
+    cout << "usage: test_obs_to_col columnar_chunk_file_name" << endl;
+    return 1;
+  }
+
+  infile_name = argv[1];
+
+  //
+  // Read the columnar file. For every l-block, project just the time
+  // tags and the first expectation.
+  //
+
+  columnar_reader = new observation_file_reader_col();
+
+  io_status = columnar_reader->open(infile_name.c_str());
+  if (io_status != 0)
+  {
+    delete columnar_reader;
+
+    cout << "[ERROR] open (columnar reader): " << io_status << endl;
+    return 1;
+  }
+
+  cout << "Blocks in columnar file: " << columnar_reader->get_n_blocks() << endl;
+
+  // Select all the blocks (any identifier, any time).
+
+  columnar_reader->find_blocks(NULL, -1.0e300, 1.0e300, blocks);
+
+  for (i = 0; i < (int)blocks.size(); i++)
+  {
+    n_records = columnar_reader->get_block_n_records(blocks[i]);
+
+    cout << "  block " << blocks[i]
+         << " type "   << columnar_reader->get_block_type(blocks[i])
+         << " id "     << columnar_reader->get_block_identifier(blocks[i])
+         << " records " << n_records
+         << " time ["  << columnar_reader->get_block_time_min(blocks[i])
+         << ", "       << columnar_reader->get_block_time_max(blocks[i]) << "]";
+
+    if (columnar_reader->get_block_type(blocks[i]) == 'l')
+    {
+      column_times.resize(n_records);
+      column_expectations.resize(n_records);
+
+      io_status = columnar_reader->read_times(blocks[i], column_times.data());
+      if (io_status == 0)
+        io_status = columnar_reader->read_expectations(blocks[i], 0, column_expectations.data());
+
+      if (io_status != 0)
+      {
+        cout << endl << "[ERROR] read columns: " << io_status << endl;
+        break;
+      }
+
+      sum_expectations = 0.0;
+
+      for (j = 0; j < n_records; j++) sum_expectations += column_expectations[j];
+
+      cout << " sum(expectation 0) " << sum_expectations;
+    }
+
+    cout << endl;
+  }
+
+  columnar_reader->close();
+  delete columnar_reader;
+
+  return 0;
+}
@@ -143,15 +143,21 @@ main
 
   bool            epoch_changed;
   bool            forward_reader;
+  int             lookahead;
+  bool            memory_mapped;
   int             n_epochs;
   int             n_l_records;
   int             n_o_records;
+  bool            read_epochs;
   bool            server_socket;
+  bool            start_at_time;
+  double          start_time;
 
   // Auxiliary variables for loops, return codes and miscellaneous purposes.
 
   int             i;
   int             io_status;
+  int             j;
   list<string>    problems;
   string          sid;
   int             total_errors;
@@ -164,6 +170,10 @@ main
 
   RecordStructure record_structure_catalogue;
 
+  // Storage for whole epochs, when these are read using read_epoch().
+
+  observation_epoch epoch;
+
   // --------------------------------------------------------------
 
   //
@@ -286,17 +296,54 @@ main
   //
 
   forward_reader = true;
+  lookahead      = 0;
+  memory_mapped  = false;
+  read_epochs    = false;
   server_socket  = true;
+  start_at_time  = false;
+  start_time     = 0.0;
 
   if (!reader.data_channel_is_socket())
   {
     // Files.
 
     cout << "The input data channel is a file." << endl;
-    cout << "Do you wish to read data in forward (0) or backwards (1) mode?: " ;
+    cout << "Do you wish to read data in forward (0), backwards (1)," << endl;
+    cout << "memory mapped forward (2) or memory mapped backwards (3) mode?: " ;
     cin >> read_mode;
 
-    forward_reader = (read_mode == 0);
+    forward_reader = ((read_mode != 1) && (read_mode != 3));
+    memory_mapped  = ((read_mode == 2) || (read_mode == 3));
+
+    // Forward readers may decode the next chunks in advance (see set_chunk_lookahead()).
+
+    if (forward_reader)
+    {
+      cout << "How many chunks do you wish to decode in advance (0 for none)?: ";
+      cin >> lookahead;
+
+      reader.set_chunk_lookahead(lookahead);
+    }
+
+    // Chunks may also be opened in the background (see set_chunk_open_ahead()).
+
+    cout << "Do you wish to open every chunk in advance (1) or not (0)?: ";
+    cin >> read_mode;
+
+    reader.set_chunk_open_ahead(read_mode == 1);
+
+    // Files may be read starting at any time (see seek_to_time()).
+
+    cout << "Do you wish to start reading at a given time (1) or not (0)?: ";
+    cin >> read_mode;
+
+    start_at_time = (read_mode == 1);
+
+    if (start_at_time)
+    {
+      cout << "Type the time to start reading at: ";
+      cin >> start_time;
+    }
   }
   else
   {
@@ -309,6 +356,13 @@ main
     server_socket = (read_mode == 1);
   }
 
+  // Records may be read one by one or an epoch at a time (see read_epoch()).
+
+  cout << "Do you wish to read records one by one (0) or whole epochs at once (1)?: ";
+  cin >> read_mode;
+
+  read_epochs = (read_mode == 1);
+
   // --------------------------------------------------------------
 
   //
@@ -397,6 +451,10 @@ main
     if (n_tags            > the_tags_size         ) the_tags_size = n_tags;
     if (n_expectations    > the_expectations_size ) the_expectations_size = n_expectations;
     if ((int)sid.length() > identifier_width      ) identifier_width = (int)sid.length();
+
+    // read_epoch() needs to know the dimensions of every kind of record.
+
+    reader.set_l_record_dimensions(sid.c_str(), n_tags, n_expectations);
   }
 
   the_covariance_values_size = (the_expectations_size * (the_expectations_size + 1)) / 2;
@@ -418,6 +476,8 @@ main
     if (n_obs_iids        > the_obs_size     ) the_obs_size = n_obs_iids;
     if (n_ins_iids        > the_ins_size     ) the_ins_size = n_ins_iids;
     if ((int)sid.length() > identifier_width ) identifier_width = (int)sid.length();
+
+    reader.set_o_record_dimensions(sid.c_str(), n_par_iids, n_obs_iids, n_ins_iids);
   }
 
   the_par_iids = new int[the_par_size];
@@ -437,9 +497,10 @@ main
   // simultaneously this data will be written to another ASTROLABE file.
   //
 
-  // Try to open the reader, saying whether we need a reversed reader or not.
+  // Try to open the reader, saying whether we need a reversed reader or not
+  // and, for forward binary files, whether memory maps should be used.
 
-  io_status = reader.open(!forward_reader);
+  io_status = reader.open(!forward_reader, memory_mapped);
   if (io_status != 0)
   {
     delete the_tags;      
@@ -457,12 +518,110 @@ main
     return 1;
   }
 
+  //
+  // Jump to the requested time, if any. Error code 1 is not an error; it
+  // means that no epoch satisfies the request, so nothing will be read.
+  //
+
+  if (start_at_time)
+  {
+    io_status = reader.seek_to_time(start_time);
+    if (io_status > 1)
+    {
+      delete the_tags;
+      delete the_expectations;
+      delete the_covariance_values;
+      delete the_par_iids;
+      delete the_obs_iids;
+      delete the_ins_iids;
+
+      delete identifier;
+
+      reader.close();
+      writer.close();
+
+      cout << "[ERROR] seek_to_time: " << io_status << endl;
+      return 1;
+    }
+  }
+
   // Iterate while there are data available.
 
   n_epochs    = 0;
   n_l_records = 0;
   n_o_records = 0;
 
+  if (read_epochs)
+  {
+    //
+    // Read a whole epoch per iteration. All its records are retrieved
+    // at once, so there's no need to check for epoch changes.
+    //
+
+    while (true)
+    {
+      io_status = reader.read_epoch(epoch);
+
+      // Error code 1 is the legal end of data condition.
+
+      if (io_status == 1) break;
+
+      if (io_status != 0)
+      {
+        cout << "[ERROR] read_epoch: " << io_status << endl;
+        break;
+      }
+
+      //
+      // As when reading records one by one, the first epoch is not
+      // counted as an epoch change.
+      //
+
+      if ((n_l_records + n_o_records) > 0) n_epochs++;
+
+      // Write the records in the epoch to our test output file.
+
+      for (j = 0; j < epoch.get_n_records(); j++)
+      {
+        if (epoch.get_type(j) == 'l')
+        {
+          io_status = writer.write_l(epoch.get_active(j),
+                                     (char*)epoch.get_identifier(j),
+                                     epoch.get_instance_id(j),
+                                     epoch.get_record_time(j),
+                                     epoch.get_n_tags(j),
+                                     (double*)epoch.get_tags(j),
+                                     epoch.get_n_expectations(j),
+                                     (double*)epoch.get_expectations(j),
+                                     epoch.get_n_covariance_values(j),
+                                     (double*)epoch.get_covariance_values(j));
+          n_l_records++;
+        }
+        else
+        {
+          io_status = writer.write_o(epoch.get_active(j),
+                                     (char*)epoch.get_identifier(j),
+                                     epoch.get_record_time(j),
+                                     epoch.get_n_parameter_iids(j),
+                                     (int*)epoch.get_parameter_iids(j),
+                                     epoch.get_n_observation_iids(j),
+                                     (int*)epoch.get_observation_iids(j),
+                                     epoch.get_n_instrument_iids(j),
+                                     (int*)epoch.get_instrument_iids(j));
+          n_o_records++;
+        }
+
+        if (io_status != 0)
+        {
+          cout << "Error writing record. Error code: " << io_status << endl;
+          break;
+        }
+      }
+
+      if (io_status != 0) break;
+    }
+  }
+  else
   while (true)
   {
     // Read the tag type.
@@ -71,6 +71,7 @@ main
   string           header_filename;
   string           schema_full_path_and_filename;
   int              read_mode;
+  int              n_threads;
 
   //
   // Names of (1) the ASTROLABE header file describing
@@ -269,9 +270,19 @@ main
 
   if (!reader.data_channel_is_socket())
   {
-    // Files.
+    // Files. Text files may be parsed by several threads.
 
     cout << "The input data channel is a file." << endl;
+    cout << "How many threads should parse text files (1: sequential, 0: as many as cores)? ";
+    cin >> n_threads;
+
+    io_status = reader.set_number_of_threads(n_threads);
+
+    if (io_status != 0)
+    {
+      cout << "[ERROR] set_number_of_threads: " << io_status << endl;
+      return 1;
+    }
   }
   else
   {
@@ -0,0 +1,314 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "observation_file_reader_bin_forward.hpp"
+#include "observation_file_reader_bin_parallel.hpp"
+#include "observation_file_writer_bin.hpp"
+
+using namespace std;
+
+//
+// Checks that the forward and parallel binary readers hand out views
+// pointing into the records they read, instead of copies.
+//
+// A binary file is written with epochs made of an l-record followed by an
+// o-record. Their identifiers, and numbers of tags and covariances, vary
+// from record to record, so the arrays in the records (which are packed)
+// are found at any alignment.
+// The file is read back with read_l_data_view() and read_o_data_view()
+// by every reader, checking all values through the views. Every array
+// in a record is preceded by its counter, so views pointing into the
+// record are exactly sizeof(int) bytes farther apart than copies packed
+// in a scratch area would be; that's how staged values are detected.
+//
+
+// Number of records (half of them l-records) written.
+
+#define N_RECORDS 10000
+
+// Maximum length of the identifiers written and read back.
+
+#define MAX_ID_LENGTH 64
+
+/// \brief Builds the identifier of a record, whose length depends on
+/// the record index.
+
+static void
+record_identifier
+(int   index,
+ char* identifier)
+{
+  {
+    int length;
+
+    length = 1 + (index % 13);
+
+    memset(identifier, 'a' + (index % 26), (size_t)length);
+    identifier[length] = '\0';
+  }
+}
+
+/// \brief Writes the test file.
+
+static int
+write_test_file
+(const char* file_name)
+{
+  {
+    double                      the_covariance_values[21];
+    double                      the_expectations[6];
+    double                      the_tags[3];
+    int                         the_ins_iids[3];
+    int                         the_obs_iids[4];
+    int                         the_par_iids[5];
+    int                         i;
+    char                        identifier[MAX_ID_LENGTH];
+    int                         index;
+    int                         io_status;
+    int                         n_covariance_values;
+    int                         n_expectations;
+    int                         n_ins_iids;
+    int                         n_obs_iids;
+    int                         n_par_iids;
+    int                         n_tags;
+    observation_file_writer_bin writer;
+
+    io_status = writer.open(file_name);
+    if (io_status != 0)
+    {
+      cout << "[ERROR] open: " << file_name << " (" << io_status << ")" << endl;
+      return 1;
+    }
+
+    for (index = 0; index < N_RECORDS; index++)
+    {
+      record_identifier(index, identifier);
+
+      if ((index % 2) == 0)
+      {
+        n_tags         = index % 4;
+        n_expectations = 1 + (index % 6);
+
+        switch (index % 3)
+        {
+          case 0:  n_covariance_values = 0;                                          break;
+          case 1:  n_covariance_values = n_expectations;                             break;
+          default: n_covariance_values = (n_expectations * (n_expectations + 1)) / 2; break;
+        }
+
+        for (i = 0; i < n_tags;              i++) the_tags[i]              = (double)(index + i) / 7;
+        for (i = 0; i < n_expectations;      i++) the_expectations[i]      = (double)(index + i) / 3;
+        for (i = 0; i < n_covariance_values; i++) the_covariance_values[i] = (double)(index + i) / 11;
+
+        io_status = writer.write_l(true, identifier, index, (double)(index / 2),
+                                   n_tags,              the_tags,
+                                   n_expectations,      the_expectations,
+                                   n_covariance_values, the_covariance_values);
+      }
+      else
+      {
+        n_par_iids = 1 + (index % 5);
+        n_obs_iids = 1 + (index % 4);
+        n_ins_iids = index % 3;
+
+        for (i = 0; i < n_par_iids; i++) the_par_iids[i] = index + i;
+        for (i = 0; i < n_obs_iids; i++) the_obs_iids[i] = index + i + 1;
+        for (i = 0; i < n_ins_iids; i++) the_ins_iids[i] = index + i + 2;
+
+        io_status = writer.write_o(true, identifier, (double)(index / 2),
+                                   n_par_iids, the_par_iids,
+                                   n_obs_iids, the_obs_iids,
+                                   n_ins_iids, the_ins_iids);
+      }
+
+      if (io_status != 0)
+      {
+        cout << "[ERROR] write: " << file_name << " (" << io_status << ")" << endl;
+        break;
+      }
+    }
+
+    if (writer.close() != 0) io_status = 1;
+
+    return (io_status != 0) ? 1 : 0;
+  }
+}
+
+/// \brief Reads the test file back through views, checking values and
+/// where the views point to.
+
+static int
+check_test_file
+(obs_e_based_file_reader& reader,
+ const char*              title,
+ const char*              file_name)
+{
+  {
+    astrolabe_double_view the_covariance_values;
+    astrolabe_double_view the_expectations;
+    astrolabe_double_view the_tags;
+    astrolabe_int_view    the_ins_iids;
+    astrolabe_int_view    the_obs_iids;
+    astrolabe_int_view    the_par_iids;
+    bool                  active;
+    int                   errors;
+    char                  expected_identifier[MAX_ID_LENGTH];
+    int                   i;
+    char*                 identifier;
+    int                   index;
+    int                   instance_id;
+    int                   io_status;
+    int                   misaligned;
+    int                   n_covariance_values;
+    int                   n_expectations;
+    int                   n_ins_iids;
+    int                   n_obs_iids;
+    int                   n_par_iids;
+    int                   n_tags;
+    char                  record_type;
+    int                   staged;
+    double                time_tag;
+
+    errors     = 0;
+    misaligned = 0;
+    staged     = 0;
+
+    io_status = reader.open(file_name);
+    if (io_status != 0)
+    {
+      cout << "[ERROR] " << title << " open: " << file_name << " (" << io_status << ")" << endl;
+      return 1;
+    }
+
+    identifier = new char[MAX_ID_LENGTH];
+
+    for (index = 0; index < N_RECORDS; index++)
+    {
+      io_status = reader.read_type(record_type);
+
+      if (io_status == 0) io_status = reader.read_active_flag(active);
+      if (io_status == 0) io_status = reader.read_identifier(identifier, MAX_ID_LENGTH);
+
+      if (io_status != 0) break;
+
+      record_identifier(index, expected_identifier);
+      if (strcmp(identifier, expected_identifier) != 0) errors++;
+
+      if (record_type == 'l')
+      {
+        n_tags         = index % 4;
+        n_expectations = 1 + (index % 6);
+
+        io_status = reader.read_instance_id(instance_id);
+        if (io_status == 0) io_status = reader.read_time(time_tag);
+        if (io_status == 0) io_status = reader.read_l_data_view(n_tags,              the_tags,
+                                                                n_expectations,      the_expectations,
+                                                                n_covariance_values, the_covariance_values);
+        if (io_status != 0) break;
+
+        if (instance_id             != index)               errors++;
+        if (time_tag                != (double)(index / 2)) errors++;
+        if (the_tags.size()         != n_tags)              errors++;
+        if (the_expectations.size() != n_expectations)      errors++;
+
+        for (i = 0; i < n_tags;              i++) if (the_tags[i]              != (double)(index + i) / 7)  errors++;
+        for (i = 0; i < n_expectations;      i++) if (the_expectations[i]      != (double)(index + i) / 3)  errors++;
+        for (i = 0; i < n_covariance_values; i++) if (the_covariance_values[i] != (double)(index + i) / 11) errors++;
+
+        // Views into the record skip the counter between arrays.
+
+        if (n_tags > 0)
+        {
+          if ((the_expectations.bytes() - the_tags.bytes()) != (long)(n_tags * sizeof(double) + sizeof(int))) staged++;
+        }
+        else if (n_covariance_values > 0)
+        {
+          if ((the_covariance_values.bytes() - the_expectations.bytes()) !=
+              (long)(n_expectations * sizeof(double) + sizeof(int))) staged++;
+        }
+
+        if (the_expectations.aligned_data() == NULL) misaligned++;
+      }
+      else
+      {
+        n_par_iids = 1 + (index % 5);
+        n_obs_iids = 1 + (index % 4);
+        n_ins_iids = index % 3;
+
+        io_status = reader.read_time(time_tag);
+        if (io_status == 0) io_status = reader.read_o_data_view(n_par_iids, the_par_iids,
+                                                                n_obs_iids, the_obs_iids,
+                                                                n_ins_iids, the_ins_iids);
+        if (io_status != 0) break;
+
+        if (time_tag != (double)(index / 2)) errors++;
+
+        for (i = 0; i < n_par_iids; i++) if (the_par_iids[i] != index + i)     errors++;
+        for (i = 0; i < n_obs_iids; i++) if (the_obs_iids[i] != index + i + 1) errors++;
+        for (i = 0; i < n_ins_iids; i++) if (the_ins_iids[i] != index + i + 2) errors++;
+
+        if ((the_obs_iids.bytes() - the_par_iids.bytes()) != (long)((n_par_iids + 1) * sizeof(int))) staged++;
+
+        if (the_par_iids.aligned_data() == NULL) misaligned++;
+      }
+    }
+
+    reader.close();
+
+    delete [] identifier;
+
+    if (io_status != 0)
+    {
+      cout << "[ERROR] " << title << " read: record " << index << " (" << io_status << ")" << endl;
+      return 1;
+    }
+
+    cout << title << ": " << errors << " wrong values, " << staged << " records staged, "
+         << misaligned << " records misaligned" << endl;
+
+    return ((errors != 0) || (staged != 0)) ? 1 : 0;
+  }
+}
+
+int
+main
+(int argc, char** argv)
+{
+  // Readers.
+
+  observation_file_reader_bin_forward  buffered_reader;
+  observation_file_reader_bin_forward  mapped_reader;
+  observation_file_reader_bin_parallel parallel_reader;
+
+  // Auxiliary data.
+
+  int                                  status;
+
+  //
+  // Check the number of parameters. We need one (besides the name of the
+  // program): the name of the file to write and read back.
+  //
+
+  if (argc < 2)
+  {
+    cout << "usage: test_record_views output_bin_file_name" << endl;
+    return 1;
+  }
+
+  if (write_test_file(argv[1]) != 0) return 1;
+
+  status = 0;
+
+  mapped_reader.set_memory_mapped(true);
+
+  if (check_test_file(buffered_reader, "forward",         argv[1]) != 0) status = 1;
+  if (check_test_file(mapped_reader,   "forward, mapped", argv[1]) != 0) status = 1;
+  if (check_test_file(parallel_reader, "parallel",        argv[1]) != 0) status = 1;
+
+  if (status != 0) cout << "[ERROR] views do not match the records written" << endl;
+
+  return status;
+}
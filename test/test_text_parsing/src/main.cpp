@@ -0,0 +1,291 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "astrolabe_number_parser.hpp"
+
+using namespace std;
+
+//
+// Compares the conversion of the numbers in ASTROLABE text files as text
+// readers used to do it (copying every token to a NULL terminated buffer
+// and calling sscanf) to the one they do now (astr_parse_double() and
+// astr_parse_int(), in place). Both must yield exactly the same values.
+//
+// Run it once per file type (observations, parameters, instruments,
+// residuals, r-matrices) to see the gain in each case.
+//
+
+// Number of times each conversion is repeated. The best time is reported.
+
+#define N_ROUNDS 5
+
+int
+main
+(int argc, char** argv)
+{
+
+  // The contents of the file being processed.
+
+  vector<char>                         contents;
+  FILE*                                file;
+  long long                            file_size;
+
+  // The numeric tokens found in the file (first character and size).
+
+  vector<int>                          double_first;
+  vector<int>                          double_size;
+  vector<int>                          int_first;
+  vector<int>                          int_size;
+  long long                            double_bytes;
+  long long                            int_bytes;
+
+  // Conversion results, old and new.
+
+  vector<double>                       old_doubles;
+  vector<double>                       new_doubles;
+  vector<int>                          old_ints;
+  vector<int>                          new_ints;
+
+  // Timing.
+
+  chrono::steady_clock::time_point     started;
+  double                               seconds;
+  double                               old_double_seconds;
+  double                               new_double_seconds;
+  double                               old_int_seconds;
+  double                               new_int_seconds;
+
+  // Auxiliary data.
+
+  char                                 text[512];
+  bool                                 in_tag;
+  bool                                 is_double;
+  int                                  errors;
+  int                                  f;
+  int                                  i;
+  int                                  j;
+  int                                  round;
+  int                                  size;
+  int                                  status;
+
+  //
+  // Check the number of parameters. We need at least one (besides
+  // the name of the program): the text file to process.
+  //
+
+  if (argc < 2)
+  {
+    cout << "usage: test_text_parsing text_file_name [text_file_name ...]" << endl;
+    return 1;
+  }
+
+  status = 0;
+
+  for (f = 1; f < argc; f++)
+  {
+    // Load the whole file.
+
+    file = fopen(argv[f], "rb");
+    if (file == NULL)
+    {
+      cout << "[ERROR] open: " << argv[f] << endl;
+      status = 1;
+      continue;
+    }
+
+    fseek(file, 0, SEEK_END);
+    file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    contents.resize((size_t)file_size + 1);
+    if (fread(&(contents[0]), 1, (size_t)file_size, file) != (size_t)file_size)
+    {
+      fclose(file);
+      cout << "[ERROR] read: " << argv[f] << endl;
+      status = 1;
+      continue;
+    }
+
+    fclose(file);
+    contents[(size_t)file_size] = '<';
+
+    //
+    // Find the numeric tokens: everything outside tags. Tokens made of
+    // digits only are converted as integers; the rest, as doubles.
+    //
+
+    double_first.clear();
+    double_size.clear();
+    int_first.clear();
+    int_size.clear();
+    double_bytes = 0;
+    int_bytes    = 0;
+    in_tag       = false;
+
+    for (i = 0; i < (int)file_size; i++)
+    {
+      if (contents[i] == '<') in_tag = true;
+      if (in_tag)
+      {
+        if (contents[i] == '>') in_tag = false;
+        continue;
+      }
+
+      if ((contents[i] == ' ') || (contents[i] == '\t') || (contents[i] == '\n') || (contents[i] == '\r')) continue;
+
+      is_double = false;
+      for (j = i; (contents[j] != ' ') && (contents[j] != '\t') && (contents[j] != '\n') &&
+                  (contents[j] != '\r') && (contents[j] != '<'); j++)
+      {
+        if ((contents[j] < '0') || (contents[j] > '9')) is_double = true;
+      }
+
+      size = j - i;
+
+      if (size < (int)sizeof(text))
+      {
+        if (is_double)
+        {
+          double_first.push_back(i);
+          double_size.push_back(size);
+          double_bytes += size;
+        }
+        else
+        {
+          int_first.push_back(i);
+          int_size.push_back(size);
+          int_bytes += size;
+        }
+      }
+
+      i = j - 1;
+    }
+
+    old_doubles.resize(double_first.size());
+    new_doubles.resize(double_first.size());
+    old_ints.resize(int_first.size());
+    new_ints.resize(int_first.size());
+
+    old_double_seconds = 0.0;
+    new_double_seconds = 0.0;
+    old_int_seconds    = 0.0;
+    new_int_seconds    = 0.0;
+
+    for (round = 0; round < N_ROUNDS; round++)
+    {
+      // Doubles, old way.
+
+      started = chrono::steady_clock::now();
+
+      for (i = 0; i < (int)double_first.size(); i++)
+      {
+        memcpy(text, &(contents[double_first[i]]), (size_t)double_size[i]);
+        text[double_size[i]] = 0;
+        sscanf(text, "%lf", &(old_doubles[i]));
+      }
+
+      seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+      if ((round == 0) || (seconds < old_double_seconds)) old_double_seconds = seconds;
+
+      // Doubles, new way.
+
+      started = chrono::steady_clock::now();
+
+      for (i = 0; i < (int)double_first.size(); i++)
+      {
+        astr_parse_double(&(contents[double_first[i]]), &(contents[double_first[i] + double_size[i]]),
+                          new_doubles[i], NULL);
+      }
+
+      seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+      if ((round == 0) || (seconds < new_double_seconds)) new_double_seconds = seconds;
+
+      // Integers, old way.
+
+      started = chrono::steady_clock::now();
+
+      for (i = 0; i < (int)int_first.size(); i++)
+      {
+        memcpy(text, &(contents[int_first[i]]), (size_t)int_size[i]);
+        text[int_size[i]] = 0;
+        sscanf(text, "%d", &(old_ints[i]));
+      }
+
+      seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+      if ((round == 0) || (seconds < old_int_seconds)) old_int_seconds = seconds;
+
+      // Integers, new way.
+
+      started = chrono::steady_clock::now();
+
+      for (i = 0; i < (int)int_first.size(); i++)
+      {
+        astr_parse_int(&(contents[int_first[i]]), &(contents[int_first[i] + int_size[i]]),
+                       new_ints[i], NULL);
+      }
+
+      seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+      if ((round == 0) || (seconds < new_int_seconds)) new_int_seconds = seconds;
+    }
+
+    // Both conversions must yield exactly the same values.
+
+    errors = 0;
+
+    for (i = 0; i < (int)double_first.size(); i++)
+    {
+      if (memcmp(&(old_doubles[i]), &(new_doubles[i]), sizeof(double)) != 0)
+      {
+        if (errors < 10)
+        {
+          cout << "[ERROR] mismatch: " << string(&(contents[double_first[i]]), (size_t)double_size[i]) << endl;
+        }
+        errors++;
+      }
+    }
+
+    for (i = 0; i < (int)int_first.size(); i++)
+    {
+      if (old_ints[i] != new_ints[i])
+      {
+        if (errors < 10)
+        {
+          cout << "[ERROR] mismatch: " << string(&(contents[int_first[i]]), (size_t)int_size[i]) << endl;
+        }
+        errors++;
+      }
+    }
+
+    if (errors != 0) status = 1;
+
+    // Report.
+
+    cout << argv[f] << endl;
+
+    cout << "  doubles:  " << double_first.size() << " tokens, "
+         << double_bytes / (1024.0 * 1024.0) << " Mbyte" << endl;
+    if ((old_double_seconds > 0) && (new_double_seconds > 0))
+    {
+      cout << "    sscanf:            " << (double_bytes / old_double_seconds) / (1024.0 * 1024.0) << " Mbyte/s" << endl;
+      cout << "    astr_parse_double: " << (double_bytes / new_double_seconds) / (1024.0 * 1024.0) << " Mbyte/s"
+           << " (x" << old_double_seconds / new_double_seconds << ")" << endl;
+    }
+
+    cout << "  integers: " << int_first.size() << " tokens, "
+         << int_bytes / (1024.0 * 1024.0) << " Mbyte" << endl;
+    if ((old_int_seconds > 0) && (new_int_seconds > 0))
+    {
+      cout << "    sscanf:            " << (int_bytes / old_int_seconds) / (1024.0 * 1024.0) << " Mbyte/s" << endl;
+      cout << "    astr_parse_int:    " << (int_bytes / new_int_seconds) / (1024.0 * 1024.0) << " Mbyte/s"
+           << " (x" << old_int_seconds / new_int_seconds << ")" << endl;
+    }
+
+    cout << "  mismatches: " << errors << endl;
+  }
+
+  return status;
+}
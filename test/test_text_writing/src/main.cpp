@@ -0,0 +1,394 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "../../test_synthtxt/src/RecordStructure.hpp"
+#include "../../test_synthtxt/src/RecordSequence.hpp"
+
+#include "observation_file_reader_txt_forward.hpp"
+#include "observation_file_writer_txt.hpp"
+
+using namespace std;
+
+//
+// Compares the throughput of the observation text writer using its default
+// formats (sprintf(), " %23.15le") to the one it achieves when writing the
+// shortest text that reads back as exactly the same doubles (see
+// set_shortest_doubles()).
+//
+// Both files are written with the synthetic records produced by
+// test_synthtxt (same record structures and sequence). Expectations,
+// however, are divided by 3, so these need all their significant digits,
+// as real observations do. The file written in shortest mode is then read
+// back: every value must be exactly the one written.
+//
+
+// Number of times each file is written. The best time is reported.
+
+#define N_ROUNDS 3
+
+// Maximum length of the identifiers read back.
+
+#define MAX_ID_LENGTH 64
+
+/// \brief Write the synthetic records generated by test_synthtxt.
+
+static int
+write_synthetic_file
+(const char* file_name,
+ bool        shortest,
+ int         n_cycles,
+ long long&  bytes_written)
+{
+  {
+    double*                      the_covariance_values;
+    double*                      the_expectations;
+    double*                      the_tags;
+    int*                         the_ins_iids;
+    int*                         the_obs_iids;
+    int*                         the_par_iids;
+    int                          cycle;
+    FILE*                        file;
+    int                          i;
+    char                         identifier[MAX_ID_LENGTH];
+    int                          io_status;
+    int                          line_index;
+    int                          n_covariance_values;
+    int                          n_expectations;
+    int                          n_ins_iids;
+    int                          n_obs_iids;
+    int                          n_par_iids;
+    int                          n_tags;
+    int                          random_value;
+    RecordSequence               record_sequence;
+    RecordStructure              record_structure;
+    int                          record_id_index;
+    int                          record_type;
+    string                       sid;
+    double                       time_tag;
+    int                          total_lines;
+    observation_file_writer_txt  writer;
+
+    // Big enough for any record in the catalogue.
+
+    the_tags              = new double[256];
+    the_expectations      = new double[256];
+    the_covariance_values = new double[256 * 257 / 2];
+    the_par_iids          = new int[256];
+    the_obs_iids          = new int[256];
+    the_ins_iids          = new int[256];
+
+    // The same pseudo-random sequence for both files.
+
+    srand(1);
+
+    writer.set_shortest_doubles(shortest);
+
+    io_status = writer.open(file_name);
+    if (io_status != 0)
+    {
+      cout << "[ERROR] open: " << file_name << " (" << io_status << ")" << endl;
+      return 1;
+    }
+
+    total_lines = n_cycles * record_sequence.cycle_length();
+
+    for (line_index = 0; line_index < total_lines; line_index++)
+    {
+      record_sequence.get_next(record_type, record_id_index, cycle);
+
+      time_tag = (double)cycle;
+
+      if (record_type == 1)
+      {
+        record_structure.l_record_data(record_id_index, sid, n_tags, n_expectations);
+        strcpy(identifier, sid.c_str());
+
+        random_value = rand() % 100 + 1;
+
+        if (random_value <= 5)       n_covariance_values = 0;
+        else if (random_value <= 95) n_covariance_values = n_expectations;
+        else                         n_covariance_values = (n_expectations * (n_expectations + 1)) / 2;
+
+        for (i = 0; i < n_covariance_values; i++) the_covariance_values[i] = (double)(i + line_index);
+        for (i = n_expectations; i < n_covariance_values; i++) the_covariance_values[i] = (double)i / 100;
+
+        for (i = 0; i < n_tags;         i++) the_tags[i]         = (double)(i + line_index);
+        for (i = 0; i < n_expectations; i++) the_expectations[i] = (double)(i + line_index + 1) / 3;
+
+        io_status = writer.write_l(true, identifier, line_index, time_tag,
+                                   n_tags,              the_tags,
+                                   n_expectations,      the_expectations,
+                                   n_covariance_values, the_covariance_values);
+      }
+      else
+      {
+        record_structure.o_record_data(record_id_index, sid, n_par_iids, n_obs_iids, n_ins_iids);
+        strcpy(identifier, sid.c_str());
+
+        for (i = 0; i < n_par_iids; i++) the_par_iids[i] = i + line_index;
+        for (i = 0; i < n_obs_iids; i++) the_obs_iids[i] = i + line_index + 1;
+        for (i = 0; i < n_ins_iids; i++) the_ins_iids[i] = i + line_index + 2;
+
+        io_status = writer.write_o(true, identifier, time_tag,
+                                   n_par_iids, the_par_iids,
+                                   n_obs_iids, the_obs_iids,
+                                   n_ins_iids, the_ins_iids);
+      }
+
+      if (io_status != 0)
+      {
+        cout << "[ERROR] write: " << file_name << " (" << io_status << ")" << endl;
+        break;
+      }
+    }
+
+    if (writer.close() != 0) io_status = 1;
+
+    delete [] the_tags;
+    delete [] the_expectations;
+    delete [] the_covariance_values;
+    delete [] the_par_iids;
+    delete [] the_obs_iids;
+    delete [] the_ins_iids;
+
+    // Size of the file.
+
+    bytes_written = 0;
+
+    file = fopen(file_name, "rb");
+    if (file != NULL)
+    {
+      fseek(file, 0, SEEK_END);
+      bytes_written = ftell(file);
+      fclose(file);
+    }
+
+    return (io_status != 0) ? 1 : 0;
+  }
+}
+
+/// \brief Read back a file written in shortest mode, checking that all
+/// values are exactly the ones written.
+
+static int
+check_synthetic_file
+(const char* file_name,
+ long long&  n_values)
+{
+  {
+    astrolabe_double_view                the_covariance_values;
+    astrolabe_double_view                the_expectations;
+    astrolabe_double_view                the_tags;
+    astrolabe_int_view                   the_ins_iids;
+    astrolabe_int_view                   the_obs_iids;
+    astrolabe_int_view                   the_par_iids;
+    bool                                 active;
+    int                                  errors;
+    int                                  i;
+    char*                                identifier;
+    int                                  instance_id;
+    int                                  io_status;
+    int                                  n_covariance_values;
+    int                                  n_expectations;
+    int                                  n_ins_iids;
+    int                                  n_obs_iids;
+    int                                  n_par_iids;
+    int                                  n_tags;
+    observation_file_reader_txt_forward  reader;
+    RecordStructure                      record_structure;
+    char                                 record_type;
+    double                               time_tag;
+
+    n_values = 0;
+    errors   = 0;
+
+    io_status = reader.open(file_name);
+    if (io_status != 0)
+    {
+      cout << "[ERROR] open: " << file_name << " (" << io_status << ")" << endl;
+      return 1;
+    }
+
+    identifier = new char[MAX_ID_LENGTH];
+
+    while (true)
+    {
+      io_status = reader.read_type(record_type);
+      if (io_status == 1) break;
+
+      if (io_status == 0) io_status = reader.read_active_flag(active);
+      if (io_status == 0) io_status = reader.read_identifier(identifier, MAX_ID_LENGTH);
+
+      // o-records: instance identifiers only.
+
+      if ((io_status == 0) && (record_type != 'l'))
+      {
+        io_status = reader.read_time(time_tag);
+
+        if (io_status == 0)
+        {
+          record_structure.o_record_data(identifier, n_par_iids, n_obs_iids, n_ins_iids);
+
+          io_status = reader.read_o_data_view(n_par_iids, the_par_iids,
+                                              n_obs_iids, the_obs_iids,
+                                              n_ins_iids, the_ins_iids);
+        }
+
+        if (io_status == 0)
+        {
+          if (time_tag != floor(time_tag)) errors++;
+          continue;
+        }
+      }
+
+      if (io_status == 0) io_status = reader.read_instance_id(instance_id);
+      if (io_status == 0) io_status = reader.read_time(time_tag);
+
+      if (io_status == 0)
+      {
+        record_structure.l_record_data(identifier, n_tags, n_expectations);
+
+        io_status = reader.read_l_data_view(n_tags,         the_tags,
+                                            n_expectations, the_expectations,
+                                            n_covariance_values, the_covariance_values);
+      }
+
+      if (io_status != 0)
+      {
+        cout << "[ERROR] read: " << file_name << " (" << io_status << ")" << endl;
+        errors++;
+        break;
+      }
+
+      // The instance identifier is the index of the line written.
+
+      for (i = 0; i < n_tags; i++)
+      {
+        if (the_tags[i] != (double)(i + instance_id)) errors++;
+      }
+
+      for (i = 0; i < n_expectations; i++)
+      {
+        if (the_expectations[i] != (double)(i + instance_id + 1) / 3) errors++;
+      }
+
+      if (time_tag != floor(time_tag)) errors++;
+
+      n_values += n_tags + n_expectations + n_covariance_values + 1;
+    }
+
+    reader.close();
+
+    delete [] identifier;
+
+    return (errors != 0) ? 1 : 0;
+  }
+}
+
+int
+main
+(int argc, char** argv)
+{
+
+  // Output files and size of the test.
+
+  string                               default_file_name;
+  string                               shortest_file_name;
+  int                                  n_cycles;
+
+  // Timing.
+
+  chrono::steady_clock::time_point     started;
+  double                               seconds;
+  double                               default_seconds;
+  double                               shortest_seconds;
+
+  // Auxiliary data.
+
+  long long                            default_bytes;
+  long long                            n_values;
+  long long                            shortest_bytes;
+  int                                  round;
+  int                                  status;
+
+  //
+  // Check the number of parameters. We need at least one (besides
+  // the name of the program): the base name of the output files.
+  //
+
+  if (argc < 2)
+  {
+    cout << "usage: test_text_writing output_txt_file_name [cycles]" << endl;
+    return 1;
+  }
+
+  default_file_name  = string(argv[1]) + ".default";
+  shortest_file_name = string(argv[1]) + ".shortest";
+
+  n_cycles = 1000;
+  if (argc > 2) n_cycles = atoi(argv[2]);
+  if (n_cycles <= 0) n_cycles = 1000;
+
+  status           = 0;
+  default_bytes    = 0;
+  shortest_bytes   = 0;
+  default_seconds  = 0.0;
+  shortest_seconds = 0.0;
+
+  for (round = 0; round < N_ROUNDS; round++)
+  {
+    // Default formats.
+
+    started = chrono::steady_clock::now();
+
+    if (write_synthetic_file(default_file_name.c_str(), false, n_cycles, default_bytes) != 0) return 1;
+
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    if ((round == 0) || (seconds < default_seconds)) default_seconds = seconds;
+
+    // Shortest round-trip representation.
+
+    started = chrono::steady_clock::now();
+
+    if (write_synthetic_file(shortest_file_name.c_str(), true, n_cycles, shortest_bytes) != 0) return 1;
+
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    if ((round == 0) || (seconds < shortest_seconds)) shortest_seconds = seconds;
+  }
+
+  // Values written in shortest mode must read back exactly.
+
+  if (check_synthetic_file(shortest_file_name.c_str(), n_values) != 0)
+  {
+    cout << "[ERROR] values read back from " << shortest_file_name << " do not match" << endl;
+    status = 1;
+  }
+
+  // Report.
+
+  cout << n_cycles << " cycles, " << n_values << " double values" << endl;
+
+  cout << "  default:  " << default_bytes / (1024.0 * 1024.0) << " Mbyte";
+  if (default_seconds > 0)
+  {
+    cout << ", " << (default_bytes / default_seconds) / (1024.0 * 1024.0) << " Mbyte/s, "
+         << n_values / default_seconds << " values/s";
+  }
+  cout << endl;
+
+  cout << "  shortest: " << shortest_bytes / (1024.0 * 1024.0) << " Mbyte";
+  if (shortest_seconds > 0)
+  {
+    cout << ", " << (shortest_bytes / shortest_seconds) / (1024.0 * 1024.0) << " Mbyte/s, "
+         << n_values / shortest_seconds << " values/s"
+         << " (x" << default_seconds / shortest_seconds << ")";
+  }
+  cout << endl;
+
+  return status;
+}
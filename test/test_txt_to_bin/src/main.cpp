@@ -4,6 +4,7 @@
 #include "RecordStructure.hpp"
 
 #include "observation_file_reader_txt_forward.hpp"
+#include "observation_file_reader_txt_parallel.hpp"
 #include "observation_file_writer_bin.hpp"
 
 using namespace std;
@@ -18,9 +19,31 @@ main
   string                               infile_name;
   string                               outfile_name;
 
-  // The text reader (forward) and binary writer objects.
+  // Compression level for the binary file (0: not compressed).
 
-  observation_file_reader_txt_forward* text_reader;
+  int                                  compression_level;
+
+  // Write the binary file in the background (see set_async_flush()).
+
+  bool                                 async_flush;
+  long long                            bytes_written;
+  double                               write_seconds;
+
+  // Durability policy and interval (see set_durability()) and sync figures.
+
+  int                                  durability_policy;
+  int                                  durability_interval;
+  double                               max_sync_seconds;
+  long long                            n_syncs;
+  double                               sync_seconds;
+
+  //
+  // The text reader (either forward or parallel) and binary writer objects.
+  // When a number of threads is given, the parallel reader is used.
+  //
+
+  obs_e_based_file_reader_txt*         text_reader;
+  int                                  n_threads;
   observation_file_writer_bin*         binary_writer;
 
   // Auxiliary data. Return codes, counters for loops.
@@ -66,18 +89,33 @@ main
   //
   // Check the number of parameters. We need at least two (besides
   // the name of the program): one for the input text file and
-  // another one for the output binary file.
+  // another one for the output binary file. A third, optional one,
+  // sets the compression level (1 to 9) of the binary file.
   //
 
   if (argc < 3)
   {
-    cout << "usage: test_txt_to_bin input_txt_file_name output_bin_file_name" << endl;
+    cout << "usage: test_txt_to_bin input_txt_file_name output_bin_file_name [compression_level [n_threads [async_flush [durability_policy durability_interval]]]]" << endl;
     return 1;
   }
 
   infile_name  = argv[1];
   outfile_name = argv[2];
 
+  compression_level = 0;
+  if (argc > 3) compression_level = atoi(argv[3]);
+
+  n_threads         = -1;
+  if (argc > 4) n_threads = atoi(argv[4]);
+
+  async_flush       = false;
+  if (argc > 5) async_flush = (atoi(argv[5]) != 0);
+
+  durability_policy   = _ASTROLABE_DURABILITY_NONE;
+  durability_interval = 0;
+  if (argc > 6) durability_policy   = atoi(argv[6]);
+  if (argc > 7) durability_interval = atoi(argv[7]);
+
 
   //
   // We will dimension the different variable length data
@@ -131,9 +169,24 @@ main
   identifier_width++; // Takes into account the ending NULL char.
 
 
-  // Instantiate the new text forward reader.
+  //
+  // Instantiate the new text reader. The parallel one parses the file
+  // using n_threads worker threads (0: as many as cores).
+  //
+
+  if (n_threads < 0)
+  {
+    text_reader = new observation_file_reader_txt_forward();
+  }
+  else
+  {
+    observation_file_reader_txt_parallel* parallel_reader;
+
+    parallel_reader = new observation_file_reader_txt_parallel();
+    parallel_reader->set_number_of_threads(n_threads);
 
-  text_reader = new observation_file_reader_txt_forward();
+    text_reader = parallel_reader;
+  }
 
   //
   // Set the maximum size of the reader's buffer in BYTES.
@@ -172,6 +225,42 @@ main
 
   binary_writer->set_buffer_size(5 * 1024); // Just 5 Kbytes.
 
+  //
+  // Optionally, write a block-compressed file. Readers will decompress
+  // it transparently.
+  //
+
+  io_status = binary_writer->set_compression(compression_level);
+  if (io_status != 0)
+  {
+    delete identifier;
+    delete the_tags;
+    delete the_expectations;
+    delete the_covariance_values;
+    delete the_par_iids;
+    delete the_obs_iids;
+    delete the_ins_iids;
+
+    cout << "[ERROR] set_compression: " << io_status << endl;
+    return 1;
+  }
+
+  //
+  // Optionally, write the buffer in a helper thread, so this one goes on
+  // reading while the previous buffer is written.
+  //
+
+  binary_writer->set_async_flush(async_flush);
+
+  // Optionally, sync the file from time to time.
+
+  io_status = binary_writer->set_durability(durability_policy, durability_interval);
+  if (io_status != 0)
+  {
+    cout << "[ERROR] set_durability: " << io_status << endl;
+    return 1;
+  }
+
   // Try to open the file.
 
   io_status = binary_writer->open(outfile_name.c_str());
@@ -359,6 +448,16 @@ main
     i = 1;
   }
 
+  // Time spent waiting for the disk while writing.
+
+  binary_writer->get_write_statistics(bytes_written, write_seconds);
+
+  cout << bytes_written << " bytes written, " << write_seconds << " seconds waiting for the disk." << endl;
+
+  binary_writer->get_sync_statistics(n_syncs, sync_seconds, max_sync_seconds);
+
+  cout << n_syncs << " syncs, " << sync_seconds << " seconds syncing (slowest: " << max_sync_seconds << ")." << endl;
+
   delete text_reader;
   delete binary_writer;
   delete identifier;
@@ -15,11 +15,14 @@ main
 {
 
   // The name of the input file. Server and port
-  // of the destination socket.
+  // of the destination socket, and number of records
+  // that may be sent without waiting for their
+  // acknowledgement.
 
   string                               infile_name;
   string                               server;
   int                                  port;
+  int                                  window;
 
   // The text reader (forward) and binary writer objects.
 
@@ -70,12 +73,12 @@ main
   // Check the number of parameters. We need at least three (besides
   // the name of the program): one for the input text file, one more
   // for the server name (or IP address) and, finally, one last parameter
-  // for the port number.
+  // for the port number. The window is optional.
   //
 
   if (argc < 4)
   {
-    cout << "usage: test_txt_to_socket input_txt_file_name server_name_or_IP_address port_number" << endl;
+    cout << "usage: test_txt_to_socket input_txt_file_name server_name_or_IP_address port_number [window]" << endl;
     return 1;
   }
 
@@ -91,6 +94,20 @@ main
     return 1;
   }
 
+  // By default, every record waits for its acknowledgement.
+
+  window = 1;
+
+  if (argc > 4)
+  {
+    istringstream ws(argv[4]);
+    if (!(ws >> window) || (window < 1))
+    {
+      cout << "[ERROR] " << argv[4] << " is not a valid window " << endl;
+      return 1;
+    }
+  }
+
   //
   // We will dimension the different variable length data
   // arrays according to the maximum dimension needed. To
@@ -175,6 +192,8 @@ main
 
   socket_writer = new observation_socket_writer();
 
+  socket_writer->set_window(window);
+
   // Try to open the socket writer.
 
   io_status = socket_writer->open(server.c_str(), port, false);
@@ -0,0 +1,286 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <string>
+#include <vector>
+
+#include "gp_metadata_parser.hpp"
+#include "gp_metadata.hpp"
+#include "observation_file_converter.hpp"
+
+using namespace std;
+
+//
+// astrolabe-convert
+//
+// Command line utility converting the observation-event files described by
+// an ASTROLABE header file to a new set of files (text, binary or columnar,
+// forward or reversed, split in chunks of a given number of epochs or bytes),
+// using the multithreaded observation_file_converter. The dimensions of the
+// records are taken from the metadata files describing them.
+//
+// Exit codes: 0 (success), 1 (bad arguments), 2 (errors in the metadata),
+// 3 (bad input or output settings), 4 (conversion failed).
+//
+// Options (before the positional arguments):
+//
+//   -h      Print the usage message and exit.
+//   -r      Reverse the order of the epochs.
+//   -m      Read the input files through memory maps.
+//   -p      Read the input files in advance, in a helper thread.
+//   -q n    Number of epochs in the queue between the read and write stages.
+//   -s n    Maximum number of epochs in an output chunk file.
+//   -b n    Target size, in bytes, of an output chunk file.
+//   -f      Preallocate the output chunk files (along with -b).
+//   -c      Write a chunk manifest along with the output chunk files.
+//   -i      Write a time index along with every output chunk file.
+//   -k n    Number of records in a column block (col output only).
+//   -w n    Number of digits of the numeric suffix of the output chunk files.
+//   -x file XML schema used to validate the header and metadata files.
+//
+
+// Default maximum number of epochs in an output chunk file.
+
+#define DEFAULT_MAX_EPOCHS 1000000
+
+// Default number of digits of the numeric suffix of the output chunk files.
+
+#define DEFAULT_SUFFIX_WIDTH 9
+
+/// \brief Print the usage message.
+
+static void
+usage
+(void)
+{
+  {
+    cout << "usage: astrolabe-convert [-h] [-r] [-m] [-p] [-q queue_size] [-s max_epochs_per_chunk]"                    << endl
+         << "                         [-b max_bytes_per_chunk] [-f] [-c] [-i] [-k block_size] [-w suffix_width]"          << endl
+         << "                         [-x schema_file]"                                                                  << endl
+         << "                         input_header_file output_header_file output_base_name txt|bin|col"                << endl
+         << "                         UDUNITS2_units_database_file metadata_file [metadata_file ...]"                   << endl;
+  }
+}
+
+int
+main
+(int   argc,
+ char* argv[])
+{
+  {
+    bool                       binary;
+    int                        block_size;
+    bool                       chunk_manifest;
+    bool                       columnar;
+    observation_file_converter converter;
+    string                     error_message;
+    int                        error_index;
+    int                        error_total;
+    int                        first;
+    string                     input_header;
+    list<string>               input_problems;
+    list<string>::iterator     it;
+    long long                  max_bytes;
+    int                        max_epochs;
+    bool                       memory_mapped;
+    gp_metadata                metadata;
+    vector<string>             metadata_files;
+    gp_metadata_parser         metadata_parser;
+    long long                  n_epochs;
+    long long                  n_records;
+    string                     output_base;
+    string                     output_header;
+    bool                       preallocate;
+    bool                       prefetch;
+    int                        queue_size;
+    bool                       reverse_mode;
+    double                     seconds;
+    int                        status;
+    int                        suffix_width;
+    bool                       time_index;
+    string                     udunits_units_database;
+    string                     xml_schema;
+
+    // Options.
+
+    block_size     = _ASTROLABE_COL_FILE_WRITER_DEFAULT_BLOCK_SIZE;
+    chunk_manifest = false;
+    max_bytes      = 0;
+    max_epochs     = DEFAULT_MAX_EPOCHS;
+    memory_mapped  = false;
+    preallocate    = false;
+    prefetch       = false;
+    queue_size     = -1;
+    reverse_mode   = false;
+    suffix_width   = DEFAULT_SUFFIX_WIDTH;
+    time_index     = false;
+
+    for (first = 1; (first < argc) && (argv[first][0] == '-'); first++)
+    {
+      if      (strcmp(argv[first], "-r") == 0) reverse_mode   = true;
+      else if (strcmp(argv[first], "-m") == 0) memory_mapped  = true;
+      else if (strcmp(argv[first], "-p") == 0) prefetch       = true;
+      else if (strcmp(argv[first], "-f") == 0) preallocate    = true;
+      else if (strcmp(argv[first], "-c") == 0) chunk_manifest = true;
+      else if (strcmp(argv[first], "-i") == 0) time_index     = true;
+      else if (strcmp(argv[first], "-h") == 0)
+      {
+        usage();
+        return 0;
+      }
+      else if ((strcmp(argv[first], "-q") == 0) && ((first + 1) < argc)) queue_size = atoi(argv[++first]);
+      else if ((strcmp(argv[first], "-s") == 0) && ((first + 1) < argc)) max_epochs = atoi(argv[++first]);
+      else if ((strcmp(argv[first], "-b") == 0) && ((first + 1) < argc)) max_bytes  = atoll(argv[++first]);
+      else if ((strcmp(argv[first], "-k") == 0) && ((first + 1) < argc)) block_size = atoi(argv[++first]);
+      else if ((strcmp(argv[first], "-w") == 0) && ((first + 1) < argc)) suffix_width = atoi(argv[++first]);
+      else if ((strcmp(argv[first], "-x") == 0) && ((first + 1) < argc)) xml_schema = argv[++first];
+      else
+      {
+        usage();
+        return 1;
+      }
+    }
+
+    // Positional arguments.
+
+    if ((argc - first) < 6)
+    {
+      usage();
+      return 1;
+    }
+
+    input_header           = argv[first];
+    output_header          = argv[first + 1];
+    output_base            = argv[first + 2];
+    binary                 = (strcmp(argv[first + 3], "bin") == 0);
+    columnar               = (strcmp(argv[first + 3], "col") == 0);
+    udunits_units_database = argv[first + 4];
+
+    if (!binary && !columnar && (strcmp(argv[first + 3], "txt") != 0))
+    {
+      usage();
+      return 1;
+    }
+
+    for (first += 5; first < argc; first++) metadata_files.push_back(argv[first]);
+
+    // Load the metadata. The dimensions of the records come from it.
+
+    if (xml_schema.empty())
+    {
+      metadata_parser.set_parser_parameters_developer(metadata_files,
+                                                      udunits_units_database,
+                                                      &metadata);
+    }
+    else
+    {
+      metadata_parser.set_parser_parameters(metadata_files,
+                                            udunits_units_database,
+                                            xml_schema,
+                                            &metadata);
+    }
+
+    metadata_parser.parse();
+
+    error_total = metadata_parser.errors_dim();
+
+    if (error_total > 0)
+    {
+      cout << "Errors found in the metadata files:" << endl << endl;
+
+      for (error_index = 0; error_index < error_total; error_index++)
+      {
+        error_message = metadata_parser.errors_get(error_index);
+        cout << error_message << endl;
+      }
+
+      return 2;
+    }
+
+    // Set up the converter.
+
+    status = converter.set_input(input_header.c_str(),
+                                 xml_schema.empty() ? NULL : xml_schema.c_str(),
+                                 reverse_mode,
+                                 memory_mapped,
+                                 prefetch);
+    if (status != 0)
+    {
+      cout << "Unable to set the input header file (error code " << status
+           << ", channel error code "                        << converter.get_channel_status() << ")." << endl;
+
+      converter.get_input_errors(input_problems);
+      for (it = input_problems.begin(); it != input_problems.end(); it++) cout << *it << endl;
+
+      return 3;
+    }
+
+    status = converter.set_metadata(metadata);
+    if (status != 0)
+    {
+      cout << "Unable to set the layout of the records (error code " << status << ")." << endl;
+      return 3;
+    }
+
+    status = converter.set_output(output_header.c_str(),
+                                  output_base.c_str(),
+                                  binary,
+                                  max_epochs,
+                                  suffix_width,
+                                  NULL);
+    if (status != 0)
+    {
+      cout << "Unable to set the output header file (error code " << status << ")." << endl;
+      return 3;
+    }
+
+    if (columnar)
+    {
+      status = converter.set_columnar((block_size > 0) ? block_size : -1);
+      if (status != 0)
+      {
+        cout << "Invalid block size (error code " << status << ")." << endl;
+        return 3;
+      }
+    }
+
+    converter.set_chunk_manifest(chunk_manifest);
+    converter.set_time_index(time_index);
+
+    status = converter.set_max_chunk_size(max_bytes, preallocate);
+    if (status != 0)
+    {
+      cout << "Invalid chunk size (error code " << status << ")." << endl;
+      return 3;
+    }
+
+    if (queue_size > 0)
+    {
+      status = converter.set_queue_size(queue_size);
+      if (status != 0)
+      {
+        cout << "Invalid queue size (error code " << status << ")." << endl;
+        return 3;
+      }
+    }
+
+    // Convert.
+
+    status = converter.convert();
+
+    converter.get_statistics(n_epochs, n_records, seconds);
+
+    if (status != 0)
+    {
+      cout << "Conversion failed (error code " << status
+           << ", channel error code "          << converter.get_channel_status() << ")." << endl;
+    }
+
+    cout << n_epochs  << " epochs, "
+         << n_records << " records written in "
+         << seconds   << " seconds." << endl;
+
+    return (status == 0) ? 0 : 4;
+  }
+}